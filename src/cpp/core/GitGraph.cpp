@@ -18,6 +18,9 @@
 
 #include <core/GitGraph.hpp>
 
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
 #include <shared_core/SafeConvert.hpp>
 
 namespace rstudio {
@@ -157,6 +160,52 @@ Line GitGraph::addCommit(const std::string& commit,
    return result;
 }
 
+std::string GitGraph::state() const
+{
+   // e.g. "7 3:4d5e9a1 5:b05f11c" -- the next column id followed by the id
+   // and expected commit of each open column
+   std::string output = safe_convert::numberToString(nextColumnId_);
+   for (const Column& column : pendingLine_)
+   {
+      output.append(" ");
+      output.append(safe_convert::numberToString(column.id));
+      output.append(":");
+      output.append(column.preCommit);
+   }
+   return output;
+}
+
+bool GitGraph::restoreState(const std::string& state)
+{
+   std::vector<std::string> fields;
+   boost::algorithm::split(fields, state, boost::algorithm::is_any_of(" "));
+   if (fields.empty())
+      return false;
+
+   int nextColumnId = safe_convert::stringTo<int>(fields[0], -1);
+   if (nextColumnId < 0)
+      return false;
+
+   Line pendingLine;
+   for (std::size_t i = 1; i < fields.size(); i++)
+   {
+      std::size_t colon = fields[i].find(':');
+      if (colon == std::string::npos)
+         return false;
+
+      int id = safe_convert::stringTo<int>(fields[i].substr(0, colon), -1);
+      std::string commit = fields[i].substr(colon + 1);
+      if (id < 0 || id >= nextColumnId || commit.empty())
+         return false;
+
+      pendingLine.push_back(Column(id, commit, commit));
+   }
+
+   nextColumnId_ = nextColumnId;
+   pendingLine_ = pendingLine;
+   return true;
+}
+
 } // namespace gitgraph
 } // namespace core
 } // namespace rstudio
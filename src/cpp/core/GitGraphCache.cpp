@@ -0,0 +1,287 @@
+/*
+ * GitGraphCache.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/GitGraphCache.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <shared_core/Error.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/GitGraph.hpp>
+#include <core/Hash.hpp>
+#include <core/Log.hpp>
+
+namespace rstudio {
+namespace core {
+namespace gitgraph {
+
+namespace {
+
+// commits are listed at least this many at a time, so paging through a
+// history doesn't mean listing commits for every page
+const std::size_t kMinRevListCount = 500;
+
+std::vector<std::string> splitLines(const std::string& text)
+{
+   std::vector<std::string> lines;
+   std::size_t pos = 0;
+   while (pos < text.size())
+   {
+      std::size_t newline = text.find('\n', pos);
+      if (newline == std::string::npos)
+         newline = text.size();
+      lines.push_back(text.substr(pos, newline - pos));
+      pos = newline + 1;
+   }
+   return lines;
+}
+
+} // anonymous namespace
+
+GraphCache::GraphCache(const FilePath& cacheDir)
+   : cacheDir_(cacheDir),
+     commitsBuilt_(0)
+{
+}
+
+Error GraphCache::lines(const std::string& key,
+                        std::size_t skip,
+                        std::size_t count,
+                        const ResolveTipFunction& resolveTip,
+                        const RevListFunction& revList,
+                        std::vector<std::string>* pLines)
+{
+   pLines->clear();
+
+   History& history = this->history(key);
+   if (!history.verified)
+   {
+      std::string tip;
+      Error error = resolveTip(&tip);
+      if (error)
+         return error;
+      boost::algorithm::replace_all(tip, "\n", " ");
+
+      if (tip != history.tip)
+      {
+         reset(key, &history);
+         history.tip = tip;
+      }
+      history.verified = true;
+   }
+
+   std::size_t end = count > std::numeric_limits<std::size_t>::max() - skip ?
+            std::numeric_limits<std::size_t>::max() :
+            skip + count;
+   if (end > history.lines.size() && !history.complete)
+   {
+      Error error = extend(key, end - history.lines.size(), revList, &history);
+      if (error)
+         return error;
+   }
+
+   if (skip < history.lines.size())
+   {
+      pLines->assign(history.lines.begin() + skip,
+                     history.lines.begin() + std::min(end, history.lines.size()));
+   }
+
+   return Success();
+}
+
+void GraphCache::invalidate()
+{
+   for (auto& entry : histories_)
+      entry.second.verified = false;
+}
+
+GraphCache::History& GraphCache::history(const std::string& key)
+{
+   auto it = histories_.find(key);
+   if (it != histories_.end())
+      return it->second;
+
+   History& history = histories_[key];
+   load(key, &history);
+   return history;
+}
+
+void GraphCache::reset(const std::string& key, History* pHistory)
+{
+   *pHistory = History();
+
+   Error error = statePath(key).removeIfExists();
+   if (error)
+      LOG_ERROR(error);
+   error = linesPath(key).removeIfExists();
+   if (error)
+      LOG_ERROR(error);
+}
+
+Error GraphCache::extend(const std::string& key,
+                         std::size_t count,
+                         const RevListFunction& revList,
+                         History* pHistory)
+{
+   // carry on from where the graph left off
+   GitGraph graph;
+   if (!pHistory->graphState.empty() && !graph.restoreState(pHistory->graphState))
+   {
+      LOG_ERROR_MESSAGE("Invalid git graph state: " + pHistory->graphState);
+      std::string tip = pHistory->tip;
+      count += pHistory->lines.size();
+      reset(key, pHistory);
+      pHistory->tip = tip;
+      pHistory->verified = true;
+   }
+
+   std::size_t requested = std::max(count, kMinRevListCount);
+   std::vector<std::string> revListLines;
+   Error error = revList(pHistory->lines.size(), requested, &revListLines);
+   if (error)
+      return error;
+
+   std::string newLines;
+   std::size_t added = 0;
+   for (const std::string& revListLine : revListLines)
+   {
+      std::vector<std::string> parents;
+      boost::algorithm::split(parents, revListLine, boost::algorithm::is_any_of(" "));
+      if (parents.empty() || parents.front().empty())
+         break;
+
+      std::string commit = parents.front();
+      parents.erase(parents.begin());
+
+      std::string line = graph.addCommit(commit, parents).string();
+      pHistory->lines.push_back(line);
+      newLines.append(line);
+      newLines.append("\n");
+      added++;
+   }
+   commitsBuilt_ += added;
+
+   pHistory->complete = added < requested;
+   pHistory->graphState = graph.state();
+
+   // the lines are written before the state, so if we're interrupted the
+   // state never claims more lines than were written
+   if (!newLines.empty())
+   {
+      error = cacheDir_.ensureDirectory();
+      if (!error)
+         error = appendToFile(linesPath(key), newLines);
+      if (error)
+         LOG_ERROR(error);
+   }
+   writeState(key, *pHistory);
+
+   return Success();
+}
+
+FilePath GraphCache::statePath(const std::string& key) const
+{
+   return cacheDir_.completeChildPath(hash::crc32HexHash(key) + ".state");
+}
+
+FilePath GraphCache::linesPath(const std::string& key) const
+{
+   return cacheDir_.completeChildPath(hash::crc32HexHash(key) + ".lines");
+}
+
+void GraphCache::load(const std::string& key, History* pHistory)
+{
+   // the state file holds the key, the tip, whether the history is complete
+   // and how many lines it has, and the state of the graph
+   FilePath statePath = this->statePath(key);
+   if (!statePath.exists())
+      return;
+
+   std::string contents;
+   Error error = readStringFromFile(statePath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   std::vector<std::string> state = splitLines(contents);
+   if (state.size() < 4 || state[0] != key)
+      return;
+
+   std::istringstream is(state[2]);
+   bool complete = false;
+   std::size_t lineCount = 0;
+   if (!(is >> complete >> lineCount))
+      return;
+
+   std::string linesContents;
+   if (linesPath(key).exists())
+   {
+      error = readStringFromFile(linesPath(key), &linesContents);
+      if (error)
+      {
+         LOG_ERROR(error);
+         return;
+      }
+   }
+
+   std::vector<std::string> lines = splitLines(linesContents);
+   if (lines.size() < lineCount)
+      return;
+
+   // drop any lines written after the state was last saved
+   if (lines.size() > lineCount)
+   {
+      lines.resize(lineCount);
+      std::string text;
+      for (const std::string& line : lines)
+         text.append(line + "\n");
+      error = writeStringToFile(linesPath(key), text);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   pHistory->tip = state[1];
+   pHistory->complete = complete;
+   pHistory->graphState = state[3];
+   pHistory->lines.swap(lines);
+}
+
+void GraphCache::writeState(const std::string& key, const History& history)
+{
+   std::ostringstream os;
+   os << key << "\n"
+      << history.tip << "\n"
+      << history.complete << " " << history.lines.size() << "\n"
+      << history.graphState << "\n";
+
+   Error error = cacheDir_.ensureDirectory();
+   if (!error)
+      error = writeStringToFile(statePath(key), os.str());
+   if (error)
+      LOG_ERROR(error);
+}
+
+} // namespace gitgraph
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,235 @@
+/*
+ * GitGraphCacheTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/GitGraphCache.hpp>
+
+#include <boost/bind.hpp>
+
+#include <shared_core/Error.hpp>
+
+#include <core/GitGraph.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace gitgraph {
+namespace tests {
+
+namespace {
+
+// rev-list output for a history of the given length (newest first), with
+// a branch merged in every so often
+std::vector<std::string> makeHistory(int length, const std::string& prefix = "c")
+{
+   std::vector<std::string> history;
+   for (int i = length - 1; i >= 0; i--)
+   {
+      std::string line = prefix + std::to_string(i);
+      if (i > 0)
+         line += " " + prefix + std::to_string(i - 1);
+      if (i % 10 == 9 && i > 5)
+         line += " " + prefix + std::to_string(i - 5);
+      history.push_back(line);
+   }
+   return history;
+}
+
+std::vector<std::string> replay(const std::vector<std::string>& history)
+{
+   GitGraph graph;
+   std::vector<std::string> lines;
+   for (const std::string& line : history)
+   {
+      std::vector<std::string> parents;
+      std::size_t pos = line.find(' ');
+      std::string commit = line.substr(0, pos);
+      while (pos != std::string::npos)
+      {
+         std::size_t next = line.find(' ', pos + 1);
+         parents.push_back(line.substr(pos + 1, next - pos - 1));
+         pos = next;
+      }
+      lines.push_back(graph.addCommit(commit, parents).string());
+   }
+   return lines;
+}
+
+Error revList(const std::vector<std::string>* pHistory,
+              int* pCalls,
+              std::size_t skip,
+              std::size_t count,
+              std::vector<std::string>* pLines)
+{
+   (*pCalls)++;
+   pLines->clear();
+   for (std::size_t i = skip; i < pHistory->size() && i < skip + count; i++)
+      pLines->push_back((*pHistory)[i]);
+   return Success();
+}
+
+Error resolveTip(const std::vector<std::string>* pHistory, std::string* pTip)
+{
+   *pTip = pHistory->empty() ? std::string() : pHistory->front().substr(0, pHistory->front().find(' '));
+   return Success();
+}
+
+} // anonymous namespace
+
+test_context("GitGraphCache")
+{
+   FilePath cacheDir;
+   FilePath::tempFilePath(cacheDir);
+
+   std::vector<std::string> history = makeHistory(5000);
+   std::vector<std::string> expected = replay(history);
+   int revListCalls = 0;
+   RevListFunction revListFn = boost::bind(revList, &history, &revListCalls, _1, _2, _3);
+   ResolveTipFunction resolveTipFn = boost::bind(resolveTip, &history, _1);
+
+   test_that("Graph state can be saved and restored")
+   {
+      GitGraph graph;
+      for (std::size_t i = 0; i < 100; i++)
+      {
+         std::vector<std::string> parents;
+         std::string commit = history[i].substr(0, history[i].find(' '));
+         std::string rest = history[i].substr(commit.size());
+         for (std::size_t pos = 0; pos < rest.size(); )
+         {
+            std::size_t next = rest.find(' ', pos + 1);
+            parents.push_back(rest.substr(pos + 1, next - pos - 1));
+            pos = next == std::string::npos ? rest.size() : next;
+         }
+         graph.addCommit(commit, parents);
+      }
+
+      GitGraph restored;
+      expect_true(restored.restoreState(graph.state()));
+      expect_true(restored.state() == graph.state());
+      expect_false(restored.restoreState("x 1:abc"));
+      expect_false(restored.restoreState("2 5:abc"));
+   }
+
+   test_that("Pages match replaying the graph from the first commit")
+   {
+      GraphCache cache(cacheDir);
+      std::vector<std::string> lines;
+      for (std::size_t skip = 0; skip < history.size() + 100; skip += 100)
+      {
+         expect_false(cache.lines("HEAD", skip, 100, resolveTipFn, revListFn, &lines));
+         for (std::size_t i = 0; i < lines.size(); i++)
+            expect_true(lines[i] == expected[skip + i]);
+         expect_true(lines.size() == (skip < history.size() ? 100u : 0u));
+      }
+
+      // every commit was built once, listing commits in batches
+      expect_true(cache.commitsBuilt() == history.size());
+      expect_true(revListCalls <= 11);
+   }
+
+   test_that("Lines are reused after a restart")
+   {
+      std::vector<std::string> lines;
+      {
+         GraphCache cache(cacheDir);
+         expect_false(cache.lines("HEAD", 0, 1200, resolveTipFn, revListFn, &lines));
+      }
+
+      GraphCache cache(cacheDir);
+      expect_false(cache.lines("HEAD", 1100, 100, resolveTipFn, revListFn, &lines));
+      expect_true(cache.commitsBuilt() == 0);
+      expect_true(lines.front() == expected[1100]);
+
+      // and the graph carries on from where it left off
+      expect_false(cache.lines("HEAD", 1500, 100, resolveTipFn, revListFn, &lines));
+      expect_true(lines.front() == expected[1500]);
+      expect_true(lines.back() == expected[1599]);
+   }
+
+   test_that("Histories are rebuilt when their tip changes")
+   {
+      GraphCache cache(cacheDir);
+      std::vector<std::string> lines;
+      expect_false(cache.lines("HEAD", 0, 100, resolveTipFn, revListFn, &lines));
+      std::size_t built = cache.commitsBuilt();
+
+      // nothing is rebuilt if the tip hasn't changed
+      cache.invalidate();
+      expect_false(cache.lines("HEAD", 0, 100, resolveTipFn, revListFn, &lines));
+      expect_true(cache.commitsBuilt() == built);
+
+      // a new merge commit changes the whole graph beneath it
+      history.insert(history.begin(), "c5000 c4999 c4000");
+      expected = replay(history);
+      cache.invalidate();
+      expect_false(cache.lines("HEAD", 0, 100, resolveTipFn, revListFn, &lines));
+      expect_true(cache.commitsBuilt() > built);
+      for (std::size_t i = 0; i < lines.size(); i++)
+         expect_true(lines[i] == expected[i]);
+   }
+
+   test_that("Each history is cached separately")
+   {
+      std::vector<std::string> other = makeHistory(50, "b");
+      std::vector<std::string> otherExpected = replay(other);
+      int otherCalls = 0;
+
+      GraphCache cache(cacheDir);
+      std::vector<std::string> lines;
+      expect_false(cache.lines("HEAD", 0, 10, resolveTipFn, revListFn, &lines));
+      expect_false(cache.lines("feature", 0, 100,
+                               boost::bind(resolveTip, &other, _1),
+                               boost::bind(revList, &other, &otherCalls, _1, _2, _3),
+                               &lines));
+      expect_true(lines == otherExpected);
+      expect_false(cache.lines("HEAD", 10, 10, resolveTipFn, revListFn, &lines));
+      expect_true(lines.front() == expected[10]);
+   }
+
+   // scrolling back and forth through a long history, a page at a time
+   test_that("Pages already built are served from the cache")
+   {
+      GraphCache cache(cacheDir.completeChildPath("paging"));
+      std::vector<std::string> lines;
+      for (std::size_t skip = 0; skip < 1000; skip += 100)
+         expect_false(cache.lines("HEAD", skip, 100, resolveTipFn, revListFn, &lines));
+      std::size_t built = cache.commitsBuilt();
+      expect_true(built >= 1000);
+
+      int calls = revListCalls;
+      for (std::size_t skip = 0; skip < 1000; skip += 100)
+      {
+         expect_false(cache.lines("HEAD", skip, 100, resolveTipFn, revListFn, &lines));
+         expect_true(lines.front() == expected[skip]);
+         expect_true(lines.back() == expected[skip + 99]);
+      }
+      expect_true(cache.commitsBuilt() == built);
+      expect_true(revListCalls == calls);
+
+      // a page past the end of the cache carries on building from there
+      expect_false(cache.lines("HEAD", built, 100, resolveTipFn, revListFn, &lines));
+      expect_true(cache.commitsBuilt() > built);
+      expect_true(revListCalls == calls + 1);
+      expect_true(lines.front() == expected[built]);
+   }
+
+   cacheDir.removeIfExists();
+}
+
+} // namespace tests
+} // namespace gitgraph
+} // namespace core
+} // namespace rstudio
@@ -16,6 +16,7 @@
 #include <core/Hash.hpp>
 
 #include <sstream>
+#include <vector>
 #include <iomanip>
 
 #include <boost/crc.hpp>
@@ -27,6 +28,54 @@ namespace rstudio {
 namespace core {
 namespace hash {   
 
+namespace {
+
+// crc32 combination treats the crc register as a polynomial over GF(2):
+// appending n zero bytes to a block multiplies its crc by x^(8n) modulo
+// the crc polynomial (this is the approach of zlib's crc32_combine)
+const boost::uint32_t kCrc32Polynomial = 0xEDB88320;
+
+// a * b modulo the crc polynomial (bit-reflected, so x^0 is the high bit)
+boost::uint32_t multiplyModP(boost::uint32_t a, boost::uint32_t b)
+{
+   boost::uint32_t product = 0;
+   for (boost::uint32_t m = 1u << 31; m != 0; m >>= 1)
+   {
+      if (a & m)
+      {
+         product ^= b;
+         if ((a & (m - 1)) == 0)
+            break;
+      }
+      b = (b & 1) ? (b >> 1) ^ kCrc32Polynomial : b >> 1;
+   }
+   return product;
+}
+
+// x^(8 * length) modulo the crc polynomial
+boost::uint32_t zeroBytesOperator(std::size_t length)
+{
+   // powers[k] is x^(2^k)
+   static const std::vector<boost::uint32_t> powers = []()
+   {
+      std::vector<boost::uint32_t> powers(64);
+      powers[0] = 1u << 30;
+      for (std::size_t k = 1; k < powers.size(); k++)
+         powers[k] = multiplyModP(powers[k - 1], powers[k - 1]);
+      return powers;
+   }();
+
+   boost::uint32_t result = 1u << 31;
+   for (std::size_t k = 3; length != 0; length >>= 1, k++)
+   {
+      if (length & 1)
+         result = multiplyModP(powers[k], result);
+   }
+   return result;
+}
+
+} // anonymous namespace
+
 std::string crc32Hash(const std::string& content)
 {
    boost::crc_32_type result;
@@ -34,6 +83,23 @@ std::string crc32Hash(const std::string& content)
    return safe_convert::numberToString(result.checksum());
 }
 
+boost::uint32_t crc32(const char* data, std::size_t length)
+{
+   boost::crc_32_type result;
+   result.process_bytes(data, length);
+   return result.checksum();
+}
+
+boost::uint32_t crc32Combine(boost::uint32_t crc1,
+                             boost::uint32_t crc2,
+                             std::size_t length2)
+{
+   if (length2 == 0)
+      return crc1;
+
+   return multiplyModP(zeroBytesOperator(length2), crc1) ^ crc2;
+}
+
 std::string crc32HexHash(const std::string& content)
 {
    // compute checksum
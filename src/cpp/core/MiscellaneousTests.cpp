@@ -252,6 +252,117 @@ test_context("LruCache")
 
       expect_true(cache.size() == 0);
    }
+
+   test_that("Entries are evicted when the cache is too heavy")
+   {
+      LruCache<int, std::string>::Options options;
+      options.maxWeight = 100;
+      options.weightFunction = [](int, const std::string& value) { return value.size(); };
+      LruCache<int, std::string> cache(options);
+
+      for (int i = 0; i < 10; ++i)
+         cache.insert(i, std::string(10, 'x'));
+      expect_true(cache.size() == 10);
+      expect_true(cache.weight() == 100);
+
+      // a heavy entry pushes out the oldest ones
+      cache.insert(10, std::string(35, 'x'));
+      expect_true(cache.weight() <= 100);
+      expect_true(cache.size() == 7);
+
+      std::string val;
+      expect_false(cache.get(3, &val));
+      expect_true(cache.get(4, &val));
+
+      // updating an entry updates its weight
+      cache.insert(10, std::string(5, 'x'));
+      expect_true(cache.weight() == 65);
+
+      // and entries heavier than the whole cache aren't kept
+      cache.insert(4, std::string(101, 'x'));
+      expect_false(cache.get(4, &val));
+      expect_true(cache.weight() == 55);
+      expect_true(cache.stats().evictions == 4);
+   }
+
+   test_that("Entries expire after their time to live")
+   {
+      LruCache<std::string, int>::Options options;
+      options.maxSize = 10;
+      options.timeToLive = boost::posix_time::milliseconds(50);
+      LruCache<std::string, int> cache(options);
+
+      cache.insert("a", 1);
+      int val;
+      expect_true(cache.get("a", &val));
+
+      boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+      expect_false(cache.get("a", &val));
+      expect_true(cache.size() == 0);
+
+      // reinserting renews the entry
+      cache.insert("a", 2);
+      expect_true(cache.get("a", &val));
+      expect_true(val == 2);
+      expect_true(cache.stats().expirations == 1);
+   }
+
+   test_that("Hits and misses are counted")
+   {
+      LruCache<int, int> cache(2);
+      cache.insert(1, 1);
+      cache.insert(2, 2);
+      cache.insert(3, 3);
+
+      int val;
+      cache.get(1, &val);
+      cache.get(2, &val);
+      cache.get(3, &val);
+      cache.get(3, &val);
+
+      LruCache<int, int>::Stats stats = cache.stats();
+      expect_true(stats.hits == 3);
+      expect_true(stats.misses == 1);
+      expect_true(stats.insertions == 3);
+      expect_true(stats.evictions == 1);
+   }
+
+   test_that("Sharded caches can be used from many threads")
+   {
+      LruCache<int, int> cache(1000, 16);
+      std::vector<boost::shared_ptr<boost::thread> > threads;
+      for (int t = 0; t < 8; ++t)
+      {
+         threads.push_back(boost::shared_ptr<boost::thread>(new boost::thread([&cache, t]()
+         {
+            int val;
+            for (int i = 0; i < 20000; ++i)
+            {
+               int key = (i * 7 + t) % 2000;
+               if (!cache.get(key, &val))
+                  cache.insert(key, key);
+               else if (val != key)
+                  cache.remove(key);
+            }
+         })));
+      }
+      for (auto& pThread : threads)
+         pThread->join();
+
+      // each shard's share of the capacity is rounded up
+      expect_true(cache.size() <= 16 * 63);
+
+      LruCache<int, int>::Stats stats = cache.stats();
+      expect_true(stats.hits + stats.misses == 8 * 20000);
+      expect_true(stats.hits > 0);
+
+      int val;
+      for (int i = 0; i < 2000; ++i)
+      {
+         if (cache.get(i, &val))
+            expect_true(val == i);
+      }
+   }
 }
 
 test_context("Options")
@@ -705,6 +705,13 @@ std::wstring::const_iterator countNewlines(std::wstring::const_iterator begin,
    return countNewlinesImpl(begin, end, '\r', '\n', pCount);
 }
 
+std::string::const_iterator countNewlines(std::string::const_iterator begin,
+                                          std::string::const_iterator end,
+                                          std::size_t* pCount)
+{
+   return countNewlinesImpl(begin, end, '\r', '\n', pCount);
+}
+
 bool isPrefixOf(const std::string& self, const std::string& prefix)
 {
    return boost::algorithm::starts_with(self, prefix);
@@ -0,0 +1,94 @@
+/*
+ * MpscQueueTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/collection/MpscQueue.hpp>
+
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace collection {
+namespace tests {
+
+namespace {
+
+void produce(MpscQueue<int>* pQueue, int producer, int count)
+{
+   for (int i = 0; i < count; i++)
+      pQueue->push(producer * count + i);
+}
+
+} // anonymous namespace
+
+test_context("MpscQueue")
+{
+   test_that("Items are removed in insertion order")
+   {
+      MpscQueue<int> queue;
+      CHECK(queue.empty());
+
+      for (int i = 0; i < 10; i++)
+         CHECK(queue.push(i) == static_cast<std::size_t>(i + 1));
+      CHECK_FALSE(queue.empty());
+      CHECK(queue.size() == 10);
+
+      std::vector<int> items;
+      queue.popAll(&items);
+      REQUIRE(items.size() == 10);
+      for (int i = 0; i < 10; i++)
+         CHECK(items[i] == i);
+
+      CHECK(queue.empty());
+      CHECK(queue.size() == 0);
+   }
+
+   test_that("Concurrent producers lose no items and keep their own order")
+   {
+      const int kProducers = 4;
+      const int kCount = 10000;
+
+      MpscQueue<int> queue;
+      std::vector<int> items;
+
+      boost::thread_group producers;
+      for (int i = 0; i < kProducers; i++)
+         producers.create_thread(boost::bind(produce, &queue, i, kCount));
+
+      // consume while the producers are running
+      while (items.size() < static_cast<std::size_t>(kProducers * kCount))
+         queue.popAll(&items);
+      producers.join_all();
+
+      CHECK(queue.empty());
+
+      std::vector<int> last(kProducers, -1);
+      for (int item : items)
+      {
+         int producer = item / kCount;
+         CHECK(item > last[producer]);
+         last[producer] = item;
+      }
+   }
+}
+
+} // namespace tests
+} // namespace collection
+} // namespace core
+} // namespace rstudio
@@ -15,16 +15,16 @@
 
 #include <core/gwt/GwtFileHandler.hpp>
 
-#include <boost/regex.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
 #include <shared_core/FilePath.hpp>
-#include <core/RegexUtils.hpp>
+#include <core/Thread.hpp>
 #include <core/text/TemplateFilter.hpp>
 #include <core/system/System.hpp>
 #include <core/http/CSRFToken.hpp>
 #include <core/http/Request.hpp>
 #include <core/http/Response.hpp>
+#include <core/http/StaticFileCache.hpp>
 
 #include "config.h"
 
@@ -43,8 +43,36 @@ struct FileRequestOptions
    std::string gwtPrefix;
    bool useEmulatedStack;
    std::string frameOptions;
+   boost::shared_ptr<http::StaticFileCache> pFileCache;
 };
 
+// the file cache for a www directory (shared by all of its handlers)
+boost::shared_ptr<http::StaticFileCache> fileCache(const std::string& wwwLocalPath)
+{
+   static boost::mutex s_mutex;
+   static std::map<std::string, boost::shared_ptr<http::StaticFileCache> > s_fileCaches;
+
+   LOCK_MUTEX(s_mutex)
+   {
+      boost::shared_ptr<http::StaticFileCache>& pFileCache = s_fileCaches[wwwLocalPath];
+      if (!pFileCache)
+         pFileCache.reset(new http::StaticFileCache());
+      return pFileCache;
+   }
+   END_LOCK_MUTEX
+
+   return boost::shared_ptr<http::StaticFileCache>(new http::StaticFileCache());
+}
+
+void setCachedFile(const FileRequestOptions& options,
+                   const FilePath& filePath,
+                   const http::Request& request,
+                   http::Response* pResponse)
+{
+   if (!options.pFileCache->setFile(filePath, request, pResponse))
+      pResponse->setFile(filePath, request);
+}
+
 void handleFileRequest(const FileRequestOptions& options,
                        const http::Request& request, 
                        http::Response* pResponse)
@@ -107,17 +135,17 @@ void handleFileRequest(const FileRequestOptions& options,
    }
    
    // case: files designated to be cached "forever"
-   if (regex_utils::match(uri, boost::regex(".*\\.cache\\..*")))
+   if (boost::algorithm::contains(uri, ".cache."))
    {
       pResponse->setCacheForeverHeaders();
-      pResponse->setFile(filePath, request);
+      setCachedFile(options, filePath, request, pResponse);
    }
    
    // case: files designated to never be cached 
-   else if (regex_utils::match(uri, boost::regex(".*\\.nocache\\..*")))
+   else if (boost::algorithm::contains(uri, ".nocache."))
    {
       pResponse->setNoCacheHeaders();
-      pResponse->setFile(filePath, request);
+      setCachedFile(options, filePath, request, pResponse);
    }
    // case: main page -- don't cache and dynamically set compiler stack mode
    else if (uri == mainPage)
@@ -130,7 +158,7 @@ void handleFileRequest(const FileRequestOptions& options,
 
       // polyfill for IE11 (only)
       std::string polyfill = "<script type=\"text/javascript\" language=\"javascript\" src=\"js/core-js/minified.js\"></script>\n";
-      if (regex_utils::match(request.userAgent(), boost::regex(".*Trident.*"))) {
+      if (boost::algorithm::contains(request.userAgent(), "Trident")) {
          vars["head_tags"] = polyfill;
       } else {
          vars["head_tags"] = std::string();
@@ -166,7 +194,9 @@ void handleFileRequest(const FileRequestOptions& options,
    {
       // since these are application components we force revalidation (default behavior of
       // setCacheableFile)
-      pResponse->setCacheableFile(filePath, request);
+      pResponse->setCacheWithRevalidationHeaders();
+      if (!options.pFileCache->setFile(filePath, request, pResponse))
+         pResponse->setCacheableFile(filePath, request);
    }
 }
    
@@ -182,7 +212,8 @@ http::UriHandlerFunction fileHandlerFunction(
                                        const std::string& frameOptions)
 {
    FileRequestOptions options { wwwLocalPath, baseUri, mainPageFilter, initJs,
-                                gwtPrefix, useEmulatedStack, frameOptions };
+                                gwtPrefix, useEmulatedStack, frameOptions,
+                                fileCache(wwwLocalPath) };
 
    return boost::bind(handleFileRequest,
                       options,
@@ -190,6 +221,15 @@ http::UriHandlerFunction fileHandlerFunction(
                       _2);
 }
 
+void precacheFiles(const std::string& wwwLocalPath)
+{
+   boost::shared_ptr<http::StaticFileCache> pFileCache = fileCache(wwwLocalPath);
+   core::thread::safeLaunchThread([=]()
+   {
+      pFileCache->populate(FilePath(wwwLocalPath));
+   });
+}
+
 } // namespace gwt
 } // namespace core
 } // namespace rstudio
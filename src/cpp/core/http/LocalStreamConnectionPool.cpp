@@ -0,0 +1,272 @@
+/*
+ * LocalStreamConnectionPool.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/LocalStreamConnectionPool.hpp>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <vector>
+
+#include <core/Thread.hpp>
+#include <core/http/SocketUtils.hpp>
+
+using namespace boost::posix_time;
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+LocalStreamConnectionPool::LocalStreamConnectionPool(
+                                       std::size_t maxIdlePerStream,
+                                       const time_duration& maxIdleTime)
+   : maxIdlePerStream_(maxIdlePerStream),
+     maxIdleTime_(maxIdleTime)
+{
+}
+
+LocalStreamConnectionPool::~LocalStreamConnectionPool()
+{
+   try
+   {
+      for (auto& entry : idleConnections_)
+      {
+         for (const IdleConnection& connection : entry.second)
+            closeConnection(connection.pSocket);
+      }
+   }
+   catch(...)
+   {
+   }
+}
+
+boost::shared_ptr<LocalStreamConnectionPool::SocketType>
+LocalStreamConnectionPool::acquire(const std::string& streamPath)
+{
+   boost::shared_ptr<SocketType> pSocket;
+   std::vector<boost::shared_ptr<SocketType> > unhealthy;
+   ptime now = microsec_clock::universal_time();
+
+   LOCK_MUTEX(mutex_)
+   {
+      auto it = idleConnections_.find(streamPath);
+      if (it == idleConnections_.end())
+         return pSocket;
+
+      // prefer the most recently used connection (it is the least likely
+      // to have been closed by the session)
+      IdleConnections& connections = it->second;
+      while (!connections.empty())
+      {
+         IdleConnection connection = connections.back();
+         connections.pop_back();
+         stats_.idleConnections--;
+
+         if (isHealthy(connection, now, maxIdleTime_))
+         {
+            pSocket = connection.pSocket;
+            stats_.connectionsReused++;
+            break;
+         }
+
+         unhealthy.push_back(connection.pSocket);
+         stats_.connectionsDiscarded++;
+      }
+
+      if (connections.empty())
+         idleConnections_.erase(it);
+   }
+   END_LOCK_MUTEX
+
+   for (const boost::shared_ptr<SocketType>& pUnhealthy : unhealthy)
+      closeConnection(pUnhealthy);
+
+   return pSocket;
+}
+
+void LocalStreamConnectionPool::release(const std::string& streamPath,
+                                        const boost::shared_ptr<SocketType>& pSocket)
+{
+   if (!pSocket || !pSocket->is_open())
+      return;
+
+   bool accepted = false;
+   LOCK_MUTEX(mutex_)
+   {
+      IdleConnections& connections = idleConnections_[streamPath];
+      if (connections.size() < maxIdlePerStream_)
+      {
+         IdleConnection connection;
+         connection.pSocket = pSocket;
+         connection.idleSince = microsec_clock::universal_time();
+         connections.push_back(connection);
+
+         stats_.idleConnections++;
+         if (stats_.idleConnections > stats_.peakIdleConnections)
+            stats_.peakIdleConnections = stats_.idleConnections;
+
+         accepted = true;
+      }
+      else if (connections.empty())
+      {
+         idleConnections_.erase(streamPath);
+      }
+   }
+   END_LOCK_MUTEX
+
+   // the pool for this stream is full - don't hold on to the connection
+   if (!accepted)
+      closeConnection(pSocket);
+}
+
+void LocalStreamConnectionPool::connectionOpened()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      stats_.connectionsOpened++;
+   }
+   END_LOCK_MUTEX
+}
+
+void LocalStreamConnectionPool::connectionDiscarded()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      stats_.connectionsDiscarded++;
+   }
+   END_LOCK_MUTEX
+}
+
+void LocalStreamConnectionPool::requestStarted()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      stats_.requestsInFlight++;
+      if (stats_.requestsInFlight > stats_.peakRequestsInFlight)
+         stats_.peakRequestsInFlight = stats_.requestsInFlight;
+   }
+   END_LOCK_MUTEX
+}
+
+void LocalStreamConnectionPool::requestFinished()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      if (stats_.requestsInFlight > 0)
+         stats_.requestsInFlight--;
+   }
+   END_LOCK_MUTEX
+}
+
+void LocalStreamConnectionPool::purge(const std::string& streamPath)
+{
+   IdleConnections purged;
+   LOCK_MUTEX(mutex_)
+   {
+      auto it = idleConnections_.find(streamPath);
+      if (it != idleConnections_.end())
+      {
+         purged.swap(it->second);
+         idleConnections_.erase(it);
+         stats_.idleConnections -= purged.size();
+      }
+   }
+   END_LOCK_MUTEX
+
+   for (const IdleConnection& connection : purged)
+      closeConnection(connection.pSocket);
+}
+
+void LocalStreamConnectionPool::pruneIdleConnections()
+{
+   std::vector<boost::shared_ptr<SocketType> > pruned;
+   ptime now = microsec_clock::universal_time();
+
+   LOCK_MUTEX(mutex_)
+   {
+      for (auto it = idleConnections_.begin(); it != idleConnections_.end(); )
+      {
+         IdleConnections& connections = it->second;
+         for (auto connIt = connections.begin(); connIt != connections.end(); )
+         {
+            if (isHealthy(*connIt, now, maxIdleTime_))
+            {
+               ++connIt;
+            }
+            else
+            {
+               pruned.push_back(connIt->pSocket);
+               connIt = connections.erase(connIt);
+               stats_.idleConnections--;
+            }
+         }
+
+         if (connections.empty())
+            it = idleConnections_.erase(it);
+         else
+            ++it;
+      }
+   }
+   END_LOCK_MUTEX
+
+   for (const boost::shared_ptr<SocketType>& pSocket : pruned)
+      closeConnection(pSocket);
+}
+
+LocalStreamConnectionPool::Statistics LocalStreamConnectionPool::statistics()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      return stats_;
+   }
+   END_LOCK_MUTEX
+
+   return Statistics();
+}
+
+bool LocalStreamConnectionPool::isHealthy(const IdleConnection& connection,
+                                          const ptime& now,
+                                          const time_duration& maxIdleTime)
+{
+   if (!connection.pSocket->is_open())
+      return false;
+
+   if (now - connection.idleSince > maxIdleTime)
+      return false;
+
+   // peek at the socket without blocking: an idle keep-alive connection
+   // should have nothing to read. end of file means the session closed
+   // its end, and any unsolicited data means the stream is out of sync
+   char byte;
+   ssize_t result = ::recv(connection.pSocket->native_handle(),
+                           &byte,
+                           1,
+                           MSG_PEEK | MSG_DONTWAIT);
+   if (result >= 0)
+      return false;
+
+   return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+void LocalStreamConnectionPool::closeConnection(const boost::shared_ptr<SocketType>& pSocket)
+{
+   Error error = closeSocket(*pSocket);
+   if (error && !isConnectionTerminatedError(error))
+      LOG_ERROR(error);
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,177 @@
+/*
+ * LocalStreamConnectionPoolTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef _WIN32
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/write.hpp>
+
+#include <core/http/LocalStreamConnectionPool.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+namespace tests {
+
+namespace {
+
+typedef LocalStreamConnectionPool::SocketType SocketType;
+
+const char* const kStreamPath = "/tmp/rstudio-test-stream";
+
+void connectPair(boost::asio::io_service& ioService,
+                 boost::shared_ptr<SocketType>* pClient,
+                 boost::shared_ptr<SocketType>* pServer)
+{
+   pClient->reset(new SocketType(ioService));
+   pServer->reset(new SocketType(ioService));
+   boost::asio::local::connect_pair(**pClient, **pServer);
+}
+
+} // anonymous namespace
+
+test_context("LocalStreamConnectionPoolTests")
+{
+   test_that("Released connections are reused")
+   {
+      boost::asio::io_service ioService;
+      LocalStreamConnectionPool pool(2, boost::posix_time::minutes(1));
+
+      boost::shared_ptr<SocketType> pClient, pServer;
+      connectPair(ioService, &pClient, &pServer);
+
+      CHECK_FALSE(pool.acquire(kStreamPath));
+
+      pool.connectionOpened();
+      pool.release(kStreamPath, pClient);
+      CHECK(pool.statistics().idleConnections == 1);
+
+      CHECK(pool.acquire(kStreamPath) == pClient);
+      CHECK_FALSE(pool.acquire(kStreamPath));
+
+      LocalStreamConnectionPool::Statistics stats = pool.statistics();
+      CHECK(stats.connectionsOpened == 1);
+      CHECK(stats.connectionsReused == 1);
+      CHECK(stats.idleConnections == 0);
+      CHECK(stats.reuseRatio() == 0.5);
+   }
+
+   test_that("Connections closed by the peer are discarded")
+   {
+      boost::asio::io_service ioService;
+      LocalStreamConnectionPool pool(2, boost::posix_time::minutes(1));
+
+      boost::shared_ptr<SocketType> pClient, pServer;
+      connectPair(ioService, &pClient, &pServer);
+
+      pool.release(kStreamPath, pClient);
+      pServer->close();
+
+      CHECK_FALSE(pool.acquire(kStreamPath));
+      CHECK(pool.statistics().connectionsDiscarded == 1);
+      CHECK_FALSE(pClient->is_open());
+   }
+
+   test_that("Connections with unread data are discarded")
+   {
+      boost::asio::io_service ioService;
+      LocalStreamConnectionPool pool(2, boost::posix_time::minutes(1));
+
+      boost::shared_ptr<SocketType> pClient, pServer;
+      connectPair(ioService, &pClient, &pServer);
+
+      pool.release(kStreamPath, pClient);
+      boost::asio::write(*pServer, boost::asio::buffer(std::string("HTTP/1.1")));
+
+      CHECK_FALSE(pool.acquire(kStreamPath));
+   }
+
+   test_that("Idle connections per stream are bounded")
+   {
+      boost::asio::io_service ioService;
+      LocalStreamConnectionPool pool(1, boost::posix_time::minutes(1));
+
+      boost::shared_ptr<SocketType> pClient1, pServer1, pClient2, pServer2;
+      connectPair(ioService, &pClient1, &pServer1);
+      connectPair(ioService, &pClient2, &pServer2);
+
+      pool.release(kStreamPath, pClient1);
+      pool.release(kStreamPath, pClient2);
+
+      CHECK(pool.statistics().idleConnections == 1);
+      CHECK(pClient1->is_open());
+      CHECK_FALSE(pClient2->is_open());
+   }
+
+   test_that("Expired connections are pruned")
+   {
+      boost::asio::io_service ioService;
+      LocalStreamConnectionPool pool(2, boost::posix_time::time_duration(0, 0, 0, 0));
+
+      boost::shared_ptr<SocketType> pClient, pServer;
+      connectPair(ioService, &pClient, &pServer);
+
+      pool.release(kStreamPath, pClient);
+      boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+      pool.pruneIdleConnections();
+
+      CHECK(pool.statistics().idleConnections == 0);
+      CHECK_FALSE(pClient->is_open());
+   }
+
+   test_that("Requests in flight are counted")
+   {
+      LocalStreamConnectionPool pool(2, boost::posix_time::minutes(1));
+
+      pool.requestStarted();
+      pool.requestStarted();
+      pool.requestFinished();
+      pool.requestStarted();
+
+      LocalStreamConnectionPool::Statistics stats = pool.statistics();
+      CHECK(stats.requestsInFlight == 2);
+      CHECK(stats.peakRequestsInFlight == 2);
+
+      pool.requestFinished();
+      pool.requestFinished();
+      CHECK(pool.statistics().requestsInFlight == 0);
+      CHECK(pool.statistics().peakRequestsInFlight == 2);
+   }
+
+   test_that("Purging a stream closes its idle connections")
+   {
+      boost::asio::io_service ioService;
+      LocalStreamConnectionPool pool(2, boost::posix_time::minutes(1));
+
+      boost::shared_ptr<SocketType> pClient, pServer;
+      connectPair(ioService, &pClient, &pServer);
+
+      pool.release(kStreamPath, pClient);
+      pool.purge(kStreamPath);
+
+      CHECK(pool.statistics().idleConnections == 0);
+      CHECK_FALSE(pClient->is_open());
+   }
+}
+
+} // end namespace tests
+} // end namespace http
+} // end namespace core
+} // end namespace rstudio
+
+#endif // _WIN32
@@ -161,6 +161,7 @@ void Message::reset()
    httpVersion_.clear();
    headers_.clear();
    body_.clear();
+   pSharedBody_.reset();
    
    // allow additional reseting by subclasses
    resetMembers();
@@ -194,7 +195,7 @@ std::vector<boost::asio::const_buffer> Message::toBuffers(
    buffers.insert(buffers.end(), headerBuffs.begin(), headerBuffs.end());
 
    // body
-   buffers.push_back(boost::asio::buffer(body_));
+   buffers.push_back(boost::asio::buffer(body()));
 
    // return the buffers
    return buffers;
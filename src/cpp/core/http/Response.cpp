@@ -438,6 +438,30 @@ void Response::addCookie(const Cookie& cookie)
 
 Error Response::setBody(const std::string& content)
 {
+   // without an encoding there is nothing to filter, so avoid streaming the
+   // content through a (copying) filter chain
+   if (contentEncoding() != kGzipEncoding)
+   {
+      body_ = content;
+      pSharedBody_.reset();
+      setContentLength(gsl::narrow_cast<int>(body_.length()));
+      return Success();
+   }
+
+   std::istringstream is(content);
+   return setBody(is);
+}
+
+Error Response::setBody(std::string&& content)
+{
+   if (contentEncoding() != kGzipEncoding)
+   {
+      body_ = std::move(content);
+      pSharedBody_.reset();
+      setContentLength(gsl::narrow_cast<int>(body_.length()));
+      return Success();
+   }
+
    std::istringstream is(content);
    return setBody(is);
 }
@@ -544,8 +568,16 @@ void Response::setBodyUnencoded(const std::string& body)
 {
    removeHeader("Content-Encoding");
    body_ = body;
+   pSharedBody_.reset();
    setContentLength(gsl::narrow_cast<int>(body_.length()));
 }
+
+void Response::setSharedBody(const boost::shared_ptr<const std::string>& pBody)
+{
+   body_.clear();
+   pSharedBody_ = pBody;
+   setContentLength(gsl::narrow_cast<int>(pBody->length()));
+}
    
    
 void Response::setError(int statusCode, const std::string& message)
@@ -0,0 +1,338 @@
+/*
+ * StaticFileCache.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/http/StaticFileCache.hpp>
+
+#include <sstream>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <shared_core/Error.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/Thread.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+#include <core/http/Util.hpp>
+#include <core/system/Crypto.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+struct StaticFileCache::Content
+{
+   std::size_t size() const
+   {
+      return pBody->size() + (pGzipBody ? pGzipBody->size() : 0);
+   }
+
+   std::string eTag;
+   boost::shared_ptr<const std::string> pBody;
+
+   // null if the contents don't compress
+   boost::shared_ptr<const std::string> pGzipBody;
+};
+
+struct StaticFileCache::Entry
+{
+   std::time_t lastWriteTime;
+   std::uintmax_t fileSize;
+   std::string contentType;
+   boost::shared_ptr<const Content> pContent;
+};
+
+namespace {
+
+bool matchesETag(const std::string& ifNoneMatch, const std::string& eTag)
+{
+   if (ifNoneMatch.empty())
+      return false;
+
+   std::vector<std::string> eTags;
+   boost::algorithm::split(eTags, ifNoneMatch, boost::algorithm::is_any_of(","));
+   for (std::string& candidate : eTags)
+   {
+      boost::algorithm::trim(candidate);
+      if (candidate == eTag || candidate == "*")
+         return true;
+   }
+   return false;
+}
+
+Error gzip(const std::string& contents, std::string* pCompressed)
+{
+   try
+   {
+      std::istringstream is(contents);
+      std::ostringstream os;
+      boost::iostreams::filtering_ostream filteringStream;
+      filteringStream.push(boost::iostreams::gzip_compressor());
+      filteringStream.push(os);
+      boost::iostreams::copy(is, filteringStream);
+      *pCompressed = os.str();
+      return Success();
+   }
+   catch (const std::exception& e)
+   {
+      Error error = systemError(boost::system::errc::io_error, ERROR_LOCATION);
+      error.addProperty("what", e.what());
+      return error;
+   }
+}
+
+} // anonymous namespace
+
+StaticFileCache::StaticFileCache(std::size_t maxSize)
+   : maxSize_(maxSize),
+     size_(0),
+     hits_(0),
+     misses_(0),
+     notModified_(0),
+     bytesSaved_(0)
+{
+}
+
+void StaticFileCache::populate(const FilePath& dir)
+{
+   Error error = dir.getChildrenRecursive([&](int, const FilePath& filePath)
+   {
+      if (!filePath.isDirectory())
+      {
+         bool hit;
+         entry(filePath, &hit);
+      }
+      return size() < maxSize_;
+   });
+
+   if (error)
+      LOG_ERROR(error);
+}
+
+bool StaticFileCache::setFile(const FilePath& filePath,
+                              const Request& request,
+                              Response* pResponse)
+{
+   // (html sent to Qt is padded, so isn't cached)
+   if (pResponse->usePadding(request, filePath))
+      return false;
+
+   bool hit = false;
+   boost::shared_ptr<const Entry> pEntry = entry(filePath, &hit);
+   if (!pEntry)
+      return false;
+
+   if (hit)
+      hits_++;
+   else
+      misses_++;
+
+   const Content& content = *pEntry->pContent;
+   boost::posix_time::ptime lastModified = boost::posix_time::from_time_t(pEntry->lastWriteTime);
+   pResponse->setContentType(pEntry->contentType);
+   pResponse->setHeader("ETag", content.eTag);
+   pResponse->setHeader("Last-Modified", util::httpDate(lastModified));
+   if (content.pGzipBody)
+      pResponse->setHeader("Vary", "Accept-Encoding");
+
+   // prefer If-None-Match to If-Modified-Since when both are present
+   std::string ifNoneMatch = request.headerValue("If-None-Match");
+   bool notModified = ifNoneMatch.empty() ?
+            lastModified == request.ifModifiedSince() :
+            matchesETag(ifNoneMatch, content.eTag);
+
+   bool gzip = content.pGzipBody && request.acceptsEncoding(kGzipEncoding);
+   const boost::shared_ptr<const std::string>& pBody = gzip ? content.pGzipBody : content.pBody;
+
+   if (notModified)
+   {
+      pResponse->removeHeader("Content-Type");
+      pResponse->setStatusCode(status::NotModified);
+      notModified_++;
+      bytesSaved_ += pBody->size();
+      return true;
+   }
+
+   if (gzip)
+   {
+      pResponse->setContentEncoding(kGzipEncoding);
+      bytesSaved_ += content.pBody->size() - pBody->size();
+   }
+
+   pResponse->setSharedBody(pBody);
+   return true;
+}
+
+StaticFileCache::Stats StaticFileCache::stats() const
+{
+   Stats stats;
+   stats.hits = hits_;
+   stats.misses = misses_;
+   stats.notModified = notModified_;
+   stats.bytesSaved = bytesSaved_;
+   return stats;
+}
+
+std::size_t StaticFileCache::size() const
+{
+   LOCK_MUTEX(mutex_)
+   {
+      return size_;
+   }
+   END_LOCK_MUTEX
+
+   return 0;
+}
+
+boost::shared_ptr<const StaticFileCache::Entry> StaticFileCache::entry(const FilePath& filePath,
+                                                                       bool* pHit)
+{
+   *pHit = false;
+   if (!filePath.exists())
+      return boost::shared_ptr<const Entry>();
+
+   std::time_t lastWriteTime = filePath.getLastWriteTime();
+   std::uintmax_t fileSize = filePath.getSize();
+
+   LOCK_MUTEX(mutex_)
+   {
+      auto it = entries_.find(filePath.getAbsolutePath());
+      if (it != entries_.end() &&
+          it->second->lastWriteTime == lastWriteTime &&
+          it->second->fileSize == fileSize)
+      {
+         *pHit = true;
+         return it->second;
+      }
+   }
+   END_LOCK_MUTEX
+
+   return load(filePath, lastWriteTime, fileSize);
+}
+
+boost::shared_ptr<const StaticFileCache::Entry> StaticFileCache::load(const FilePath& filePath,
+                                                                      std::time_t lastWriteTime,
+                                                                      std::uintmax_t fileSize)
+{
+   // leave room for many files
+   if (fileSize > maxSize_ / 8)
+      return boost::shared_ptr<const Entry>();
+
+   // read, hash and compress the file (outside the lock, as this is the
+   // expensive part; concurrent requests for the same file may duplicate
+   // the work, but only the first time it's requested)
+   std::string contents;
+   Error error = readStringFromFile(filePath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return boost::shared_ptr<const Entry>();
+   }
+
+   std::string hash;
+   error = system::crypto::sha256(contents, &hash);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return boost::shared_ptr<const Entry>();
+   }
+
+   boost::shared_ptr<Content> pContent(new Content());
+   pContent->eTag = "\"" + boost::algorithm::hex(hash) + "\"";
+
+#ifndef _WIN32
+   // responses are never gzipped on win32 (see Response::setBody)
+   std::string compressed;
+   error = gzip(contents, &compressed);
+   if (error)
+      LOG_ERROR(error);
+   else if (compressed.size() < contents.size())
+      pContent->pGzipBody.reset(new std::string(std::move(compressed)));
+#endif
+
+   pContent->pBody.reset(new std::string(std::move(contents)));
+
+   boost::shared_ptr<Entry> pEntry(new Entry());
+   pEntry->lastWriteTime = lastWriteTime;
+   pEntry->fileSize = fileSize;
+   pEntry->contentType = filePath.getMimeContentType();
+   pEntry->pContent = pContent;
+
+   LOCK_MUTEX(mutex_)
+   {
+      // share the contents of identical files
+      auto contentIt = contents_.find(pContent->eTag);
+      if (contentIt != contents_.end())
+      {
+         pEntry->pContent = contentIt->second;
+      }
+      else if (size_ + pContent->size() <= maxSize_)
+      {
+         contents_[pContent->eTag] = pContent;
+         size_ += pContent->size();
+      }
+      else
+      {
+         // the cache is full so serve (but don't keep) the file
+         return pEntry;
+      }
+
+      std::string path = filePath.getAbsolutePath();
+      auto it = entries_.find(path);
+      if (it == entries_.end())
+      {
+         entries_[path] = pEntry;
+         return pEntry;
+      }
+
+      // the file has changed; drop its previous contents if no other file
+      // shares them
+      boost::shared_ptr<const Content> pPrevious = it->second->pContent;
+      it->second = pEntry;
+      if (pPrevious != pEntry->pContent)
+      {
+         bool shared = false;
+         for (const auto& entry : entries_)
+         {
+            if (entry.second->pContent == pPrevious)
+            {
+               shared = true;
+               break;
+            }
+         }
+
+         if (!shared)
+         {
+            contents_.erase(pPrevious->eTag);
+            size_ -= pPrevious->size();
+         }
+      }
+
+      return pEntry;
+   }
+   END_LOCK_MUTEX
+
+   return pEntry;
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
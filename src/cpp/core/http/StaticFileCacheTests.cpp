@@ -0,0 +1,208 @@
+/*
+ * StaticFileCacheTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <core/http/StaticFileCache.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/http/Request.hpp>
+#include <core/http/Response.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+std::string sampleScript(std::size_t size)
+{
+   std::string script;
+   for (int i = 0; script.size() < size; i++)
+      script += "function f" + std::to_string(i) + "(a,b){return a.call(b," + std::to_string(i % 7) + ");}\n";
+   return script;
+}
+
+FilePath createTempDirectory()
+{
+   FilePath dir;
+   FilePath::tempFilePath(dir);
+   dir.ensureDirectory();
+   return dir;
+}
+
+void acceptGzip(Request* pRequest)
+{
+   pRequest->setUri("/app.js");
+   pRequest->setHeader("Accept-Encoding", "gzip, deflate");
+}
+
+} // anonymous namespace
+
+test_context("StaticFileCache")
+{
+   FilePath dir = createTempDirectory();
+   FilePath script = dir.completeChildPath("app.js");
+   std::string contents = sampleScript(500 * 1024);
+   writeStringToFile(script, contents);
+
+   Request gzipRequest;
+   acceptGzip(&gzipRequest);
+
+   test_that("Files are compressed once and shared between responses")
+   {
+      StaticFileCache cache;
+
+      Response first;
+      expect_true(cache.setFile(script, gzipRequest, &first));
+      expect_true(first.statusCode() == status::Ok);
+      expect_true(first.contentEncoding() == kGzipEncoding);
+      expect_true(first.body().size() < contents.size() / 4);
+      expect_true(first.headerValue("Content-Type") == "text/javascript");
+
+      Response second;
+      expect_true(cache.setFile(script, gzipRequest, &second));
+      expect_true(second.body().data() == first.body().data());
+      expect_true(second.headerValue("ETag") == first.headerValue("ETag"));
+
+      // clients which don't accept gzip get the file as is
+      Response plain;
+      Request plainRequest;
+      expect_true(cache.setFile(script, plainRequest, &plain));
+      expect_true(plain.contentEncoding().empty());
+      expect_true(plain.body() == contents);
+      expect_true(plain.toBuffers().size() > 1);
+
+      StaticFileCache::Stats stats = cache.stats();
+      expect_true(stats.misses == 1);
+      expect_true(stats.hits == 2);
+      expect_true(stats.bytesSaved == 2 * (contents.size() - first.body().size()));
+   }
+
+   test_that("Matching ETags get Not Modified responses")
+   {
+      StaticFileCache cache;
+
+      Response response;
+      expect_true(cache.setFile(script, gzipRequest, &response));
+      std::string eTag = response.headerValue("ETag");
+      expect_true(eTag.size() == 66);
+
+      Request request;
+      acceptGzip(&request);
+      request.setHeader("If-None-Match", "\"stale\", " + eTag);
+      Response notModified;
+      expect_true(cache.setFile(script, request, &notModified));
+      expect_true(notModified.statusCode() == status::NotModified);
+      expect_true(notModified.body().empty());
+      expect_true(cache.stats().notModified == 1);
+
+      request.setHeader("If-None-Match", "\"stale\"");
+      Response modified;
+      expect_true(cache.setFile(script, request, &modified));
+      expect_true(modified.statusCode() == status::Ok);
+   }
+
+   test_that("Identical files share contents and changed files are reloaded")
+   {
+      StaticFileCache cache;
+      FilePath copy = dir.completeChildPath("copy.js");
+      writeStringToFile(copy, contents);
+
+      Response response;
+      expect_true(cache.setFile(script, gzipRequest, &response));
+      std::size_t size = cache.size();
+      Response copyResponse;
+      expect_true(cache.setFile(copy, gzipRequest, &copyResponse));
+      expect_true(cache.size() == size);
+      expect_true(copyResponse.body().data() == response.body().data());
+
+      writeStringToFile(copy, contents + "// changed\n");
+      Response changed;
+      expect_true(cache.setFile(copy, gzipRequest, &changed));
+      expect_true(changed.headerValue("ETag") != response.headerValue("ETag"));
+      expect_true(cache.size() > size);
+
+      // the original contents remain (they're still used by app.js)
+      expect_true(cache.stats().misses == 3);
+      copy.remove();
+   }
+
+   test_that("Missing and oversized files aren't cached")
+   {
+      StaticFileCache cache(1024 * 1024);
+      Response response;
+      expect_false(cache.setFile(dir.completeChildPath("missing.js"), gzipRequest, &response));
+      expect_false(cache.setFile(script, gzipRequest, &response));
+      expect_true(response.body().empty());
+   }
+
+   test_that("Directories can be populated up front")
+   {
+      StaticFileCache cache;
+      cache.populate(dir);
+      expect_true(cache.size() > 0);
+
+      Response response;
+      expect_true(cache.setFile(script, gzipRequest, &response));
+      expect_true(cache.stats().hits == 1);
+      expect_true(cache.stats().misses == 0);
+   }
+
+   // the same script sent to many clients (e.g. a class signing in at once)
+   test_that("Repeated requests are served from the cache until the file changes")
+   {
+      const int kRequests = 20;
+
+      StaticFileCache cache;
+      Response first;
+      expect_true(cache.setFile(script, gzipRequest, &first));
+      for (int i = 1; i < kRequests; i++)
+      {
+         Response response;
+         expect_true(cache.setFile(script, gzipRequest, &response));
+         expect_true(response.body().data() == first.body().data());
+      }
+
+      StaticFileCache::Stats stats = cache.stats();
+      expect_true(stats.misses == 1);
+      expect_true(stats.hits == kRequests - 1);
+
+      // a change which keeps the size the same is noticed through the
+      // modification time
+      std::string edited = contents;
+      edited[0] = 'F';
+      writeStringToFile(script, edited);
+      script.setLastWriteTime(::time(nullptr) + 60);
+
+      Response changed;
+      expect_true(cache.setFile(script, gzipRequest, &changed));
+      expect_true(changed.body().data() != first.body().data());
+      expect_true(changed.headerValue("ETag") != first.headerValue("ETag"));
+      expect_true(cache.stats().misses == 2);
+
+      Request plainRequest;
+      Response plain;
+      expect_true(cache.setFile(script, plainRequest, &plain));
+      expect_true(plain.body() == edited);
+      expect_true(cache.stats().misses == 2);
+   }
+
+   dir.remove();
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -23,6 +23,7 @@
 
 #include <boost/asio.hpp>
 #include <boost/tokenizer.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/regex.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
@@ -532,6 +533,17 @@ bool isWSUpgradeRequest(const Request& request)
    return boost::regex_search(connection, upgrade);
 }
 
+bool isIdempotentRequest(const Request& request)
+{
+   const std::string& method = request.method();
+   return boost::algorithm::iequals(method, "GET") ||
+          boost::algorithm::iequals(method, "HEAD") ||
+          boost::algorithm::iequals(method, "OPTIONS") ||
+          boost::algorithm::iequals(method, "TRACE") ||
+          boost::algorithm::iequals(method, "PUT") ||
+          boost::algorithm::iequals(method, "DELETE");
+}
+
 #ifndef _WIN32
 bool isSslShutdownError(const boost::system::error_code& ec)
 {
@@ -75,6 +75,12 @@ public:
    Line addCommit(const std::string& commit,
                   const std::vector<std::string>& parents);
 
+   // The state built up by the calls to addCommit so far, as a string.
+   // Restoring it into another GitGraph lets that graph carry on from
+   // where this one left off (e.g. after the lines so far were cached).
+   std::string state() const;
+   bool restoreState(const std::string& state);
+
 private:
    int nextColumnId_;
    Line pendingLine_;
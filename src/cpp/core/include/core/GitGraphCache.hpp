@@ -0,0 +1,114 @@
+/*
+ * GitGraphCache.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_GITGRAPH_CACHE_HPP
+#define CORE_GITGRAPH_CACHE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+
+namespace gitgraph {
+
+// Lists commits in the order the graph is built (e.g. with git rev-list
+// --date-order --parents), as lines of the form "<commit> <parent>...",
+// skipping the first skip commits and returning at most count.
+typedef boost::function<Error(std::size_t skip,
+                              std::size_t count,
+                              std::vector<std::string>*)> RevListFunction;
+
+// Resolves the commit(s) a history starts from (e.g. with git rev-parse).
+typedef boost::function<Error(std::string*)> ResolveTipFunction;
+
+// Caches the graph lines of one or more histories (identified by a key,
+// e.g. the ref and file filter being viewed) so that paging through a
+// history only builds the graph for commits which haven't been seen yet,
+// rather than replaying it from the first commit for every page.
+//
+// Each history's lines are kept in memory and in the cache directory
+// (as one line per commit, plus the state needed to carry on building
+// the graph), so they survive a restart. Since new commits change the
+// graph of everything beneath them, a history is discarded when its tip
+// changes; tips are resolved again on first use and after a call to
+// invalidate() (e.g. when refs are seen to have changed).
+class GraphCache : boost::noncopyable
+{
+public:
+   explicit GraphCache(const FilePath& cacheDir);
+
+   // the graph lines of the count commits following the first skip
+   // (fewer if the history ends first)
+   Error lines(const std::string& key,
+               std::size_t skip,
+               std::size_t count,
+               const ResolveTipFunction& resolveTip,
+               const RevListFunction& revList,
+               std::vector<std::string>* pLines);
+
+   // refs may have changed, so resolve tips again before using any lines
+   void invalidate();
+
+   // the number of commits which have had their line built (for testing)
+   std::size_t commitsBuilt() const { return commitsBuilt_; }
+
+private:
+   struct History
+   {
+      History() : verified(false), complete(false) {}
+
+      std::string tip;
+      bool verified;
+
+      // whether the lines reach the end of the history
+      bool complete;
+
+      // the state of the graph after the last of the lines
+      std::string graphState;
+
+      std::vector<std::string> lines;
+   };
+
+   History& history(const std::string& key);
+   void reset(const std::string& key, History* pHistory);
+   Error extend(const std::string& key,
+                std::size_t count,
+                const RevListFunction& revList,
+                History* pHistory);
+
+   FilePath statePath(const std::string& key) const;
+   FilePath linesPath(const std::string& key) const;
+   void load(const std::string& key, History* pHistory);
+   void writeState(const std::string& key, const History& history);
+
+   const FilePath cacheDir_;
+   std::map<std::string, History> histories_;
+   std::size_t commitsBuilt_;
+};
+
+} // namespace gitgraph
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_GITGRAPH_CACHE_HPP
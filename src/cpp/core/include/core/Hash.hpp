@@ -16,8 +16,11 @@
 #ifndef CORE_HASH_HPP
 #define CORE_HASH_HPP
 
+#include <cstddef>
 #include <string>
 
+#include <boost/cstdint.hpp>
+
 namespace rstudio {
 namespace core {
 namespace hash {
@@ -26,6 +29,16 @@ std::string crc32Hash(const std::string& content);
 
 std::string crc32HexHash(const std::string& content);
 
+// raw crc32 checksum (crc32Hash returns its decimal representation)
+boost::uint32_t crc32(const char* data, std::size_t length);
+
+// crc32 checksum of the concatenation of two blocks of data, computed from
+// the checksums of each block and the length of the second; this allows
+// checksums of large documents to be maintained incrementally
+boost::uint32_t crc32Combine(boost::uint32_t crc1,
+                             boost::uint32_t crc2,
+                             std::size_t length2);
+
 } // namespace hash
 } // namespace core 
 } // namespace rstudio
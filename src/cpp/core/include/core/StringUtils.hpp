@@ -242,6 +242,10 @@ std::wstring::const_iterator countNewlines(std::wstring::const_iterator begin,
                                            std::wstring::const_iterator end,
                                            std::size_t* pCount);
 
+std::string::const_iterator countNewlines(std::string::const_iterator begin,
+                                          std::string::const_iterator end,
+                                          std::size_t* pCount);
+
 bool isPrefixOf(const std::string& self, const std::string& prefix);
 
 template <typename StringType>
@@ -16,8 +16,15 @@
 #ifndef CORE_COLLECTION_LRU_CACHE_HPP
 #define CORE_COLLECTION_LRU_CACHE_HPP
 
-#include <map>
-#include <deque>
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
 
 #include <shared_core/Error.hpp>
 #include <core/Thread.hpp>
@@ -26,47 +33,127 @@ namespace rstudio {
 namespace core {
 namespace collection {
 
-template <typename KeyType, typename ValueType>
-class LruCache
+// A thread safe cache which evicts its least recently used entries once it
+// holds too many of them, or once their total weight (e.g. their size in
+// bytes) is too great. Entries may also be given a time to live, after which
+// they're treated as missing.
+//
+// Entries are spread across a number of shards by the hash of their key,
+// each with its own lock, so that concurrent lookups of different keys
+// rarely contend. Capacity is divided evenly between the shards and each
+// shard evicts independently, so eviction order is only exactly LRU when
+// there's a single shard (the default).
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = boost::hash<KeyType> >
+class LruCache : boost::noncopyable
 {
 public:
-   LruCache(unsigned int maxSize) : maxSize_(maxSize) {}
+   // the weight of an entry, counted against maxWeight
+   typedef boost::function<std::size_t(const KeyType&, const ValueType&)> WeightFunction;
+
+   struct Options
+   {
+      Options()
+         : maxSize(0),
+           maxWeight(0),
+           shards(1),
+           timeToLive(boost::posix_time::not_a_date_time)
+      {
+      }
+
+      // maximum number of entries (0 for no limit)
+      std::size_t maxSize;
+
+      // maximum total weight of the entries (0 for no limit)
+      std::size_t maxWeight;
+      WeightFunction weightFunction;
+
+      // number of independently locked shards
+      std::size_t shards;
+
+      // how long entries remain valid after they're inserted (not_a_date_time
+      // for no limit)
+      boost::posix_time::time_duration timeToLive;
+   };
+
+   struct Stats
+   {
+      Stats()
+         : hits(0), misses(0), insertions(0), evictions(0), expirations(0)
+      {
+      }
+
+      std::size_t hits;
+      std::size_t misses;
+      std::size_t insertions;
+      std::size_t evictions;
+      std::size_t expirations;
+   };
+
+   explicit LruCache(std::size_t maxSize, std::size_t shards = 1)
+   {
+      Options options;
+      options.maxSize = maxSize;
+      options.shards = shards;
+      initialize(options);
+   }
+
+   explicit LruCache(const Options& options)
+   {
+      initialize(options);
+   }
+
    virtual ~LruCache() {}
 
    void insert(const KeyType& key,
                const ValueType& value)
    {
-      LOCK_MUTEX(mutex_)
+      std::size_t weight = weightFunction_ ? weightFunction_(key, value) : 1;
+      Shard& shard = shardFor(key);
+
+      LOCK_MUTEX(shard.mutex)
       {
-         if (map_.count(key) > 0)
+         // an entry too heavy to fit is never cached (but it replaces any
+         // existing entry, which would be out of date)
+         if (maxShardWeight_ > 0 && weight > maxShardWeight_)
+         {
+            typename Shard::Map::iterator it = shard.map.find(key);
+            if (it != shard.map.end())
+               shard.erase(it);
+            return;
+         }
+
+         std::pair<typename Shard::Map::iterator, bool> result =
+               shard.map.insert(std::make_pair(key, Entry(value)));
+         Node* pNode = &(*result.first);
+         if (result.second)
          {
-            // entry for this key already exists - we are updating the value instead of inserting it
-            // we need to remove it from the chain of nodes and then reinsert it to the front
-            // so that this entry's LRU "time" is effectively updated
-            auto pNode = map_[key];
-            pNode->value = value;
-            removeNode(pNode);
-            addNode(pNode);
+            shard.link(pNode);
          }
          else
          {
-            if (map_.size() >= maxSize_)
-            {
-               // the cache has reached maximum size
-               // remove the oldest item from the cache which is at the back of the node chain
-               auto pNode = backNode_;
-               removeNode(pNode);
-
-               // erase the node from the map
-               // when this block goes out of scope, there are no more references
-               // to the expired node pointer, so it is freed
-               map_.erase(pNode->key);
-            }
-
-            // create a new node and store it
-            auto pNode = boost::shared_ptr<Node>(new Node(key, value));
-            addNode(pNode);
-            map_[key] = pNode;
+            // entry for this key already exists - update its value and move
+            // it to the front so that its LRU "time" is effectively updated
+            pNode->second.value = value;
+            shard.weight -= pNode->second.weight;
+            shard.moveToFront(pNode);
+         }
+
+         pNode->second.weight = weight;
+         if (!timeToLive_.is_special())
+            pNode->second.expires = now() + timeToLive_;
+         shard.weight += weight;
+         shard.stats.insertions++;
+
+         // remove the oldest entries (at the back of the list) until we're
+         // within our limits again
+         while (shard.back != pNode &&
+                ((maxShardSize_ > 0 && shard.map.size() > maxShardSize_) ||
+                 (maxShardWeight_ > 0 && shard.weight > maxShardWeight_)))
+         {
+            shard.erase(shard.map.find(shard.back->first));
+            shard.stats.evictions++;
          }
       }
       END_LOCK_MUTEX
@@ -75,19 +162,30 @@ public:
    bool get(const KeyType& key,
             ValueType* pValue)
    {
-      LOCK_MUTEX(mutex_)
+      Shard& shard = shardFor(key);
+
+      LOCK_MUTEX(shard.mutex)
       {
-         typename CollectionType::iterator iter = map_.find(key);
-         if (iter == map_.end())
+         typename Shard::Map::iterator it = shard.map.find(key);
+         if (it == shard.map.end())
+         {
+            shard.stats.misses++;
             return false;
+         }
 
-         auto pNode = iter->second;
+         if (!it->second.expires.is_special() && now() >= it->second.expires)
+         {
+            shard.erase(it);
+            shard.stats.expirations++;
+            shard.stats.misses++;
+            return false;
+         }
 
-         // remove and reinsert node to update its last access time
-         removeNode(pNode);
-         addNode(pNode);
+         // move to the front to update its last access time
+         shard.moveToFront(&(*it));
+         shard.stats.hits++;
 
-         *pValue = pNode->value;
+         *pValue = it->second.value;
          return true;
       }
       END_LOCK_MUTEX
@@ -97,77 +195,194 @@ public:
 
    void remove(const KeyType& key)
    {
-      LOCK_MUTEX(mutex_)
-      {
-         typename CollectionType::iterator iter = map_.find(key);
-         if (iter == map_.end())
-            return;
+      Shard& shard = shardFor(key);
 
-         auto pNode = iter->second;
-         removeNode(pNode);
-         map_.erase(key);
+      LOCK_MUTEX(shard.mutex)
+      {
+         typename Shard::Map::iterator it = shard.map.find(key);
+         if (it != shard.map.end())
+            shard.erase(it);
       }
       END_LOCK_MUTEX
    }
 
+   void clear()
+   {
+      for (std::size_t i = 0; i < shardCount_; i++)
+      {
+         LOCK_MUTEX(shards_[i].mutex)
+         {
+            shards_[i].map.clear();
+            shards_[i].front = nullptr;
+            shards_[i].back = nullptr;
+            shards_[i].weight = 0;
+         }
+         END_LOCK_MUTEX
+      }
+   }
+
    size_t size()
    {
-      LOCK_MUTEX(mutex_)
+      std::size_t size = 0;
+      for (std::size_t i = 0; i < shardCount_; i++)
       {
-         return map_.size();
+         LOCK_MUTEX(shards_[i].mutex)
+         {
+            size += shards_[i].map.size();
+         }
+         END_LOCK_MUTEX
       }
-      END_LOCK_MUTEX
+      return size;
+   }
 
-      return 0;
+   // total weight of the entries
+   std::size_t weight()
+   {
+      std::size_t weight = 0;
+      for (std::size_t i = 0; i < shardCount_; i++)
+      {
+         LOCK_MUTEX(shards_[i].mutex)
+         {
+            weight += shards_[i].weight;
+         }
+         END_LOCK_MUTEX
+      }
+      return weight;
+   }
+
+   Stats stats()
+   {
+      Stats stats;
+      for (std::size_t i = 0; i < shardCount_; i++)
+      {
+         LOCK_MUTEX(shards_[i].mutex)
+         {
+            const Stats& shardStats = shards_[i].stats;
+            stats.hits += shardStats.hits;
+            stats.misses += shardStats.misses;
+            stats.insertions += shardStats.insertions;
+            stats.evictions += shardStats.evictions;
+            stats.expirations += shardStats.expirations;
+         }
+         END_LOCK_MUTEX
+      }
+      return stats;
    }
 
 private:
-   struct Node
+   struct Entry;
+   typedef std::pair<const KeyType, Entry> Node;
+
+   // entries are linked into their shard's LRU list directly, so each needs
+   // no allocation beyond its node in the map (whose address is stable)
+   struct Entry
    {
-      Node(const KeyType& key, const ValueType& value) :
-         key(key), value(value) {}
+      explicit Entry(const ValueType& value)
+         : value(value),
+           weight(0),
+           pPrev(nullptr),
+           pNext(nullptr)
+      {
+      }
 
-      boost::shared_ptr<Node> pLeft;
-      boost::shared_ptr<Node> pRight;
-      KeyType key;
       ValueType value;
+      std::size_t weight;
+      boost::posix_time::ptime expires;
+      Node* pPrev;
+      Node* pNext;
    };
 
-   void removeNode(const boost::shared_ptr<Node>& pNode)
+   struct Shard
    {
-      if (pNode->pLeft)
-         pNode->pLeft->pRight = pNode->pRight;
-      else
-         frontNode_ = pNode->pRight;
+      typedef std::unordered_map<KeyType, Entry, HashType> Map;
 
-      if (pNode->pRight)
-         pNode->pRight->pLeft = pNode->pLeft;
-      else
-         backNode_ = pNode->pLeft;
-   }
+      Shard() : front(nullptr), back(nullptr), weight(0) {}
 
-   void addNode(const boost::shared_ptr<Node>& pNode)
-   {
-      pNode->pRight = frontNode_;
-      pNode->pLeft.reset();
+      void link(Node* pNode)
+      {
+         pNode->second.pPrev = nullptr;
+         pNode->second.pNext = front;
+         if (front)
+            front->second.pPrev = pNode;
+         front = pNode;
+         if (!back)
+            back = pNode;
+      }
+
+      void unlink(Node* pNode)
+      {
+         if (pNode->second.pPrev)
+            pNode->second.pPrev->second.pNext = pNode->second.pNext;
+         else
+            front = pNode->second.pNext;
+
+         if (pNode->second.pNext)
+            pNode->second.pNext->second.pPrev = pNode->second.pPrev;
+         else
+            back = pNode->second.pPrev;
+      }
+
+      void moveToFront(Node* pNode)
+      {
+         if (pNode == front)
+            return;
+         unlink(pNode);
+         link(pNode);
+      }
+
+      void erase(typename Map::iterator it)
+      {
+         unlink(&(*it));
+         weight -= it->second.weight;
+         map.erase(it);
+      }
 
-      if (frontNode_)
-         frontNode_->pLeft = pNode;
-      frontNode_ = pNode;
+      boost::mutex mutex;
+      Map map;
+      Node* front;
+      Node* back;
+      std::size_t weight;
+      Stats stats;
+   };
 
-      if (!backNode_)
-         backNode_ = frontNode_;
+   void initialize(const Options& options)
+   {
+      shardCount_ = options.shards > 0 ? options.shards : 1;
+      shards_.reset(new Shard[shardCount_]);
+
+      // divide the limits between the shards (rounding up, so a limit is
+      // never zero unless it was meant to be)
+      maxShardSize_ = (options.maxSize + shardCount_ - 1) / shardCount_;
+      maxShardWeight_ = (options.maxWeight + shardCount_ - 1) / shardCount_;
+      weightFunction_ = options.weightFunction;
+      timeToLive_ = options.timeToLive;
    }
 
-   unsigned int maxSize_;
+   Shard& shardFor(const KeyType& key)
+   {
+      if (shardCount_ == 1)
+         return shards_[0];
 
-   typedef std::map<KeyType, boost::shared_ptr<Node>> CollectionType;
-   CollectionType map_;
+      // (mix the hash, as the map within the shard uses its low bits too)
+      std::size_t hash = hash_(key);
+      hash ^= hash >> 16;
+      hash *= 0x45d9f3b;
+      hash ^= hash >> 16;
+      return shards_[hash % shardCount_];
+   }
 
-   boost::shared_ptr<Node> frontNode_;
-   boost::shared_ptr<Node> backNode_;
+   static boost::posix_time::ptime now()
+   {
+      return boost::posix_time::microsec_clock::universal_time();
+   }
 
-   boost::mutex mutex_;
+   boost::scoped_array<Shard> shards_;
+   std::size_t shardCount_;
+   std::size_t maxShardSize_;
+   std::size_t maxShardWeight_;
+   WeightFunction weightFunction_;
+   boost::posix_time::time_duration timeToLive_;
+   HashType hash_;
 };
 
 } // namespace collection
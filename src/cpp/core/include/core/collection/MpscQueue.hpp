@@ -0,0 +1,135 @@
+/*
+ * MpscQueue.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_COLLECTION_MPSC_QUEUE_HPP
+#define CORE_COLLECTION_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <vector>
+
+#include <boost/utility.hpp>
+
+namespace rstudio {
+namespace core {
+namespace collection {
+
+// Lock-free multiple producer, single consumer queue.
+//
+// Producers push onto an intrusive singly linked list with a single
+// compare-and-swap; the consumer detaches the entire list in one atomic
+// exchange and reverses it to recover insertion order. Because items are
+// never popped individually there is no ABA hazard.
+//
+// Any number of threads may call push() concurrently. Only one thread at a
+// time may call popAll() (callers with several consumers must serialize
+// them externally).
+template <typename T>
+class MpscQueue : boost::noncopyable
+{
+public:
+   MpscQueue()
+      : pHead_(nullptr), size_(0)
+   {
+   }
+
+   ~MpscQueue()
+   {
+      Node* pNode = pHead_.exchange(nullptr);
+      while (pNode)
+      {
+         Node* pNext = pNode->pNext;
+         delete pNode;
+         pNode = pNext;
+      }
+   }
+
+   // add an item; returns the number of items in the queue after the add
+   // (approximate when other threads are pushing or popping concurrently)
+   std::size_t push(const T& item)
+   {
+      Node* pNode = new Node(item);
+      Node* pHead = pHead_.load(std::memory_order_relaxed);
+      do
+      {
+         pNode->pNext = pHead;
+      }
+      while (!pHead_.compare_exchange_weak(pHead,
+                                           pNode,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+
+      long size = ++size_;
+      return size > 0 ? static_cast<std::size_t>(size) : 0;
+   }
+
+   bool empty() const
+   {
+      return pHead_.load(std::memory_order_acquire) == nullptr;
+   }
+
+   std::size_t size() const
+   {
+      long size = size_.load();
+      return size > 0 ? static_cast<std::size_t>(size) : 0;
+   }
+
+   // remove all items, appending them (oldest first) to pItems
+   void popAll(std::vector<T>* pItems)
+   {
+      Node* pNode = pHead_.exchange(nullptr, std::memory_order_acquire);
+
+      // the list is newest first; reverse it
+      Node* pOldest = nullptr;
+      long count = 0;
+      while (pNode)
+      {
+         Node* pNext = pNode->pNext;
+         pNode->pNext = pOldest;
+         pOldest = pNode;
+         pNode = pNext;
+         ++count;
+      }
+      size_ -= count;
+
+      pItems->reserve(pItems->size() + count);
+      while (pOldest)
+      {
+         Node* pNext = pOldest->pNext;
+         pItems->push_back(pOldest->item);
+         delete pOldest;
+         pOldest = pNext;
+      }
+   }
+
+private:
+   struct Node
+   {
+      explicit Node(const T& item) : item(item), pNext(nullptr) {}
+      T item;
+      Node* pNext;
+   };
+
+   std::atomic<Node*> pHead_;
+
+   // signed since a consumer can detach a node before its producer has
+   // counted it
+   std::atomic<long> size_;
+};
+
+} // end namespace collection
+} // end namespace core
+} // end namespace rstudio
+
+#endif // CORE_COLLECTION_MPSC_QUEUE_HPP
@@ -30,6 +30,10 @@ http::UriHandlerFunction fileHandlerFunction(
       const std::string& gwtPrefix = std::string(),
       bool useEmulatedStack = false,
       const std::string& frameOptions = std::string());
+
+// read and compress the static files served from wwwLocalPath (on a
+// background thread) rather than on their first request
+void precacheFiles(const std::string& wwwLocalPath);
    
 } // namespace gwt
 } // namespace core
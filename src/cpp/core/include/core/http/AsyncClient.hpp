@@ -277,11 +277,15 @@ protected:
    void writeRequest()
    {
       // specify closing of the connection after the request unless this is
-      // an attempt to upgrade to websockets
+      // an attempt to upgrade to websockets or the subclass is able to reuse
+      // the connection for subsequent requests
       Header overrideHeader;
       if (!util::isWSUpgradeRequest(request_))
       {
-         overrideHeader = Header::connectionClose();
+         if (requestPersistentConnection())
+            overrideHeader = Header("Connection", "keep-alive");
+         else
+            overrideHeader = Header::connectionClose();
       }
 
       // write
@@ -291,7 +295,8 @@ protected:
           boost::bind(
                &AsyncClient<SocketService>::handleWrite,
                AsyncClient<SocketService>::shared_from_this(),
-               boost::asio::placeholders::error)
+               boost::asio::placeholders::error,
+               boost::asio::placeholders::bytes_transferred)
       );
    }
 
@@ -431,7 +436,8 @@ private:
       CATCH_UNEXPECTED_ASYNC_CLIENT_EXCEPTION
    }
 
-   void handleWrite(const boost::system::error_code& ec)
+   void handleWrite(const boost::system::error_code& ec,
+                    std::size_t bytesTransferred)
    {
       try
       {
@@ -460,7 +466,8 @@ private:
                           AsyncClient<SocketService>::shared_from_this(),
                           boost::asio::placeholders::error));
          }
-         else
+         else if (!canRetryRequest(bytesTransferred > 0) ||
+                  !retryOnStaleConnection(ec))
          {
             handleErrorCode(ec, ERROR_LOCATION);
          }
@@ -493,7 +500,9 @@ private:
                              boost::asio::placeholders::error));
             }
          }
-         else
+         else if (responseBuffer_.size() > 0 ||
+                  !canRetryRequest(true) ||
+                  !retryOnStaleConnection(ec))
          {
             handleErrorCode(ec, ERROR_LOCATION);
          }
@@ -535,6 +544,31 @@ private:
       return false;
    }
 
+   // subclasses which reuse connections return true to ask the server to
+   // keep the connection open once the response has been written
+   virtual bool requestPersistentConnection()
+   {
+      return false;
+   }
+
+   // invoked when the connection fails before any of the response was read
+   // (and only when the request can safely be sent again; see
+   // canRetryRequest). subclasses which reuse connections can return true
+   // after transparently resubmitting the request over a fresh connection (a
+   // pooled connection may have been closed by the server while it sat idle)
+   virtual bool retryOnStaleConnection(const boost::system::error_code& ec)
+   {
+      return false;
+   }
+
+   // a request can be sent again if none of it was written (so the server
+   // can't have acted on it), or if acting on it twice is harmless; otherwise
+   // (e.g. a POST rpc) the error goes back to the caller
+   bool canRetryRequest(bool anyRequestWritten) const
+   {
+      return !anyRequestWritten || util::isIdempotentRequest(request_);
+   }
+
    void handleReadHeaders(const boost::system::error_code& ec)
    {
       try
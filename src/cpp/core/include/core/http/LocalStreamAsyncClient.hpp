@@ -18,6 +18,8 @@
 
 #include <sys/stat.h>
 
+#include <atomic>
+
 #include <boost/function.hpp>
 #include <boost/optional.hpp>
 
@@ -29,6 +31,7 @@
 #include <core/system/PosixUser.hpp>
 
 #include <core/http/AsyncClient.hpp>
+#include <core/http/LocalStreamConnectionPool.hpp>
 #include <core/http/LocalStreamSocketUtils.hpp>
 
 namespace rstudio {
@@ -47,23 +50,72 @@ public:
                                                 http::ConnectionRetryProfile())
      : AsyncClient<boost::asio::local::stream_protocol::socket>(ioService,
                                                                 logToStderr),
-       socket_(ioService),
+       pSocket_(new boost::asio::local::stream_protocol::socket(ioService)),
        localStreamPath_(localStreamPath),
-       validateUid_(validateUid)
+       validateUid_(validateUid),
+       reusedConnection_(false),
+       requestInFlight_(false)
    {
       setConnectionRetryProfile(retryProfile);
    }
 
+   virtual ~LocalStreamAsyncClient()
+   {
+      try
+      {
+         finishRequest();
+      }
+      catch(...)
+      {
+      }
+   }
+
+   // use (and return connections to) the given pool. must be called
+   // prior to execute
+   void setConnectionPool(const boost::shared_ptr<LocalStreamConnectionPool>& pPool)
+   {
+      pPool_ = pPool;
+   }
+
+   virtual void close()
+   {
+      finishRequest();
+      AsyncClient<boost::asio::local::stream_protocol::socket>::close();
+   }
+
 protected:
 
    virtual boost::asio::local::stream_protocol::socket& socket()
    {
-      return socket_;
+      return *pSocket_;
    }
 
 private:
 
    virtual void connectAndWriteRequest()
+   {
+      // reuse an idle connection to the stream if one is available. the peer
+      // of a pooled connection was already validated when it was connected
+      if (pPool_)
+      {
+         if (!requestInFlight_.exchange(true))
+            pPool_->requestStarted();
+
+         boost::shared_ptr<LocalStreamConnectionPool::SocketType> pPooled =
+               pPool_->acquire(localStreamPath_.getAbsolutePath());
+         if (pPooled)
+         {
+            pSocket_ = pPooled;
+            reusedConnection_ = true;
+            writeRequest();
+            return;
+         }
+      }
+
+      connectNewSocket();
+   }
+
+   void connectNewSocket()
    {
       // validate if requested
       if (validateUid_.is_initialized() && localStreamPath_.exists())
@@ -110,12 +162,77 @@ private:
       return "localhost";
    }
 
+   // HEAD responses carry a Content-Length without a body, so don't attempt
+   // to delimit them on a persistent connection
+   virtual bool requestPersistentConnection()
+   {
+      return pPool_ && request().method() != "HEAD";
+   }
+
+   // true if the server agreed to keep the connection open and delimited the
+   // response with a Content-Length (so we don't need to wait for eof)
+   bool isPersistentResponse()
+   {
+      return requestPersistentConnection() &&
+             !chunkedEncoding_ &&
+             !response_.headerValue("Content-Length").empty() &&
+             boost::algorithm::iequals(response_.headerValue("Connection"), "keep-alive");
+   }
+
+   virtual bool stopReadingAndRespond()
+   {
+      return isPersistentResponse() &&
+             response_.body().length() >= response_.contentLength();
+   }
+
+   virtual bool keepConnectionAlive()
+   {
+      if (!isPersistentResponse())
+         return false;
+
+      // hand the connection back to the pool and replace it with an
+      // unconnected socket so that any later close() on this client
+      // does not affect the pooled connection
+      pPool_->release(localStreamPath_.getAbsolutePath(), pSocket_);
+      pSocket_.reset(new boost::asio::local::stream_protocol::socket(ioService()));
+      finishRequest();
+      return true;
+   }
+
+   // (close can be called from other threads, e.g. to abandon a request)
+   void finishRequest()
+   {
+      if (requestInFlight_.exchange(false))
+         pPool_->requestFinished();
+   }
+
+   virtual bool retryOnStaleConnection(const boost::system::error_code& ec)
+   {
+      if (!reusedConnection_)
+         return false;
+
+      // only retry once, and always over a brand new connection
+      reusedConnection_ = false;
+      pPool_->connectionDiscarded();
+
+      Error error = closeSocket(*pSocket_);
+      if (error && !isConnectionTerminatedError(error))
+         LOG_ERROR(error);
+      pSocket_.reset(new boost::asio::local::stream_protocol::socket(ioService()));
+
+      connectNewSocket();
+      return true;
+   }
+
    void handleConnect(const boost::system::error_code& ec)
    {
       try
       {
          if (!ec)
          {
+            if (pPool_)
+               pPool_->connectionOpened();
+
             // the connection was successful call base to write the request
             writeRequest();
          }
@@ -137,9 +254,12 @@ private:
    }
 
 private:
-   boost::asio::local::stream_protocol::socket socket_;
+   boost::shared_ptr<boost::asio::local::stream_protocol::socket> pSocket_;
    core::FilePath localStreamPath_;
    boost::optional<UidType> validateUid_;
+   boost::shared_ptr<LocalStreamConnectionPool> pPool_;
+   bool reusedConnection_;
+   std::atomic<bool> requestInFlight_;
 };
    
    
@@ -0,0 +1,143 @@
+/*
+ * LocalStreamConnectionPool.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_LOCAL_STREAM_CONNECTION_POOL_HPP
+#define CORE_HTTP_LOCAL_STREAM_CONNECTION_POOL_HPP
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/BoostThread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+// keeps idle, already-connected local stream sockets around (keyed by the
+// path of the stream they are connected to) so that subsequent requests to
+// the same stream can skip the connect and peer validation. sockets are only
+// returned to the pool after a complete keep-alive request/response exchange
+// (see LocalStreamAsyncClient) and are health checked before being reused
+class LocalStreamConnectionPool : boost::noncopyable
+{
+public:
+   typedef boost::asio::local::stream_protocol::socket SocketType;
+
+   struct Statistics
+   {
+      Statistics()
+         : connectionsOpened(0),
+           connectionsReused(0),
+           connectionsDiscarded(0),
+           idleConnections(0),
+           peakIdleConnections(0),
+           requestsInFlight(0),
+           peakRequestsInFlight(0)
+      {
+      }
+
+      // fraction of requests which were served by a pooled connection
+      double reuseRatio() const
+      {
+         uint64_t total = connectionsOpened + connectionsReused;
+         return total == 0 ? 0.0 : static_cast<double>(connectionsReused) / total;
+      }
+
+      uint64_t connectionsOpened;
+      uint64_t connectionsReused;
+      uint64_t connectionsDiscarded;
+      std::size_t idleConnections;
+      std::size_t peakIdleConnections;
+
+      // requests sent through the pool which haven't yet completed (the
+      // depth of the queue of requests waiting on sessions)
+      std::size_t requestsInFlight;
+      std::size_t peakRequestsInFlight;
+   };
+
+public:
+   // maxIdlePerStream bounds the number of idle connections kept for any one
+   // stream (additional connections are closed on release), which keeps a
+   // burst of concurrent requests from pinning file descriptors in both
+   // rserver and the session indefinitely
+   LocalStreamConnectionPool(std::size_t maxIdlePerStream,
+                             const boost::posix_time::time_duration& maxIdleTime);
+
+   virtual ~LocalStreamConnectionPool();
+
+   // take an idle connection to the given stream. returns a null pointer if
+   // no healthy connection is available, in which case the caller should
+   // connect a new socket (and call connectionOpened)
+   boost::shared_ptr<SocketType> acquire(const std::string& streamPath);
+
+   // return a connection which has completed a keep-alive exchange
+   void release(const std::string& streamPath,
+                const boost::shared_ptr<SocketType>& pSocket);
+
+   // record that a fresh connection was made for a request
+   void connectionOpened();
+
+   // record that a previously pooled connection failed when reused
+   void connectionDiscarded();
+
+   // record that a request was sent through the pool, and that it completed
+   // (whether or not its connection was returned to the pool)
+   void requestStarted();
+   void requestFinished();
+
+   // close all idle connections to the given stream (e.g. the session exited)
+   void purge(const std::string& streamPath);
+
+   // close idle connections that have expired or whose peer has gone away.
+   // intended to be invoked periodically
+   void pruneIdleConnections();
+
+   Statistics statistics();
+
+private:
+   struct IdleConnection
+   {
+      boost::shared_ptr<SocketType> pSocket;
+      boost::posix_time::ptime idleSince;
+   };
+
+   typedef std::deque<IdleConnection> IdleConnections;
+
+   static bool isHealthy(const IdleConnection& connection,
+                         const boost::posix_time::ptime& now,
+                         const boost::posix_time::time_duration& maxIdleTime);
+
+   static void closeConnection(const boost::shared_ptr<SocketType>& pSocket);
+
+   std::size_t maxIdlePerStream_;
+   boost::posix_time::time_duration maxIdleTime_;
+
+   boost::mutex mutex_;
+   std::map<std::string, IdleConnections> idleConnections_;
+   Statistics stats_;
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_LOCAL_STREAM_CONNECTION_POOL_HPP
@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
 
 namespace RSTUDIO_BOOST_NAMESPACE {
@@ -92,7 +93,7 @@ public:
 
    const Headers& headers() const  { return headers_; }
    
-   const std::string& body() const { return body_; }
+   const std::string& body() const { return pSharedBody_ ? *pSharedBody_ : body_; }
    
    void reset();
    
@@ -107,6 +108,10 @@ protected:
    // RVO for potentially large buffers). note this means that you MUST always
    // remember to call setContentLength after setting the body!
    std::string body_;
+
+   // alternatively, a body shared with others (e.g. a cached file) which
+   // is sent without being copied; takes precedence over body_ when set
+   boost::shared_ptr<const std::string> pSharedBody_;
    
    void appendSpaceBuffer(
          std::vector<boost::asio::const_buffer>& buffers) const;
@@ -117,6 +122,7 @@ protected:
    void assign(const Message& message, const Headers& extraHeaders)
    {
       body_ = message.body_;
+      pSharedBody_ = message.pSharedBody_;
       httpVersionMajor_ = message.httpVersionMajor_;
       httpVersionMinor_ = message.httpVersionMinor_;
       headers_ = message.headers_;
@@ -159,6 +159,7 @@ public:
    Headers getCookies(const std::vector<std::string>& names = {}) const;
    
    Error setBody(const std::string& content);
+   Error setBody(std::string&& content);
    
    Error setCacheableBody(const std::string& content,
                           const Request& request)
@@ -242,6 +243,7 @@ public:
          
          // set body 
          body_ = bodyStream.str();
+         pSharedBody_.reset();
 
          if (padding && body_.length() < 1024)
          {
@@ -429,6 +431,10 @@ public:
 
    // these calls do no stream io or encoding so don't return errors
    void setBodyUnencoded(const std::string& body);
+
+   // set a body shared with others (so it must not be modified) which is
+   // sent without being copied; any content encoding must already be applied
+   void setSharedBody(const boost::shared_ptr<const std::string>& pBody);
    void setError(int statusCode, const std::string& message);
 
    // request uri not found
@@ -0,0 +1,105 @@
+/*
+ * StaticFileCache.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_STATIC_FILE_CACHE_HPP
+#define CORE_HTTP_STATIC_FILE_CACHE_HPP
+
+#include <atomic>
+#include <ctime>
+#include <map>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+class Request;
+class Response;
+
+// In-memory cache of static files (e.g. the javascript and css which make
+// up the IDE) for serving to many clients. Each file is read, hashed (for a
+// strong ETag) and gzipped once, after which responses share the cached
+// buffers rather than copying or compressing them again. Files with
+// identical contents share a single cache entry. Files are revalidated
+// against their size and modification time on each request.
+class StaticFileCache : boost::noncopyable
+{
+public:
+   struct Stats
+   {
+      Stats() : hits(0), misses(0), notModified(0), bytesSaved(0) {}
+
+      // requests served from the cache and those for which the file had to
+      // be read (and compressed) first
+      std::size_t hits;
+      std::size_t misses;
+
+      // requests answered with 304 Not Modified
+      std::size_t notModified;
+
+      // bytes which didn't need to be sent thanks to compression and
+      // Not Modified responses
+      std::size_t bytesSaved;
+   };
+
+   explicit StaticFileCache(std::size_t maxSize = 256 * 1024 * 1024);
+
+   // add the files within dir (recursively) to the cache
+   void populate(const FilePath& dir);
+
+   // respond to the request with filePath (with 304 Not Modified if the
+   // request's If-None-Match or If-Modified-Since show that the client has
+   // it already); returns false if the file is unsuitable for caching, in
+   // which case the response is untouched
+   bool setFile(const FilePath& filePath, const Request& request, Response* pResponse);
+
+   Stats stats() const;
+
+   // the total size of the cached contents (including compressed copies)
+   std::size_t size() const;
+
+private:
+   struct Content;
+   struct Entry;
+
+   boost::shared_ptr<const Entry> entry(const FilePath& filePath, bool* pHit);
+   boost::shared_ptr<const Entry> load(const FilePath& filePath,
+                                       std::time_t lastWriteTime,
+                                       std::uintmax_t fileSize);
+
+   const std::size_t maxSize_;
+
+   mutable boost::mutex mutex_;
+   std::map<std::string, boost::shared_ptr<const Entry> > entries_;
+   std::map<std::string, boost::shared_ptr<const Content> > contents_;
+   std::size_t size_;
+
+   std::atomic<std::size_t> hits_;
+   std::atomic<std::size_t> misses_;
+   std::atomic<std::size_t> notModified_;
+   std::atomic<std::size_t> bytesSaved_;
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_STATIC_FILE_CACHE_HPP
@@ -177,6 +177,10 @@ bool isNetworkAddress(const std::string& str);
 // determins if the given request is request to upgrade the connection to a websocket
 bool isWSUpgradeRequest(const Request& request);
 
+// is the given request safe to send again when it may already have been
+// received (i.e. is its method idempotent; RFC 7231 section 4.2.2)?
+bool isIdempotentRequest(const Request& request);
+
 // does the given error represent SSL truncation/shutdown?
 bool isSslShutdownError(const boost::system::error_code& code);
 
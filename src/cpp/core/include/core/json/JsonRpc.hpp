@@ -94,6 +94,7 @@ struct is_error_code_enum<rstudio::core::json::errc::errc_t>
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
 #include <shared_core/Error.hpp>
@@ -364,10 +365,12 @@ public:
       setField(json::kRpcResult, result);
    }
 
-   Value result()
-   {
-      return response_[json::kRpcResult];
-   }
+   // set the result to json which has already been serialized (typically
+   // with a json::Writer). large results can be streamed this way rather
+   // than being built up (and copied) as a Value
+   void setRawResult(std::string&& result);
+
+   Value result();
 
    Value error()
    {
@@ -399,6 +402,8 @@ public:
 
    void setField(const std::string& name, const Value& value)
    { 
+      if (name == json::kRpcResult)
+         pRawResult_.reset();
       response_[name] = value;
    }             
                 
@@ -418,6 +423,7 @@ public:
    // low level hook to set the full response
    void setResponse(const Object& response)
    {
+      pRawResult_.reset();
       response_ = response;
    }
    
@@ -435,6 +441,7 @@ public:
    Object getRawResponse();
    
    void write(std::ostream& os) const;
+   void write(std::string* pOutput) const;
 
    static bool parse(const std::string& input,
                      JsonRpcResponse* pResponse);
@@ -443,7 +450,10 @@ public:
                      JsonRpcResponse* pResponse);
    
 private:
+   void write(Writer& writer) const;
+
    Object response_;
+   boost::shared_ptr<const std::string> pRawResult_;
    boost::function<void()> afterResponse_;
    bool suppressDetectChanges_;
 };
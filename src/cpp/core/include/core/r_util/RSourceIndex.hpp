@@ -301,6 +301,11 @@ public:
       packageInformation()[package] = info;
    }
 
+   static void removePackageInformation(const std::string& package)
+   {
+      packageInformation().erase(package);
+   }
+
    static bool hasInformation(const std::string& package)
    {
       return packageInformation().find(package) != packageInformation().end();
@@ -360,7 +365,7 @@ public:
            it != allInferredPkgNames().end();
            ++it)
       {
-         if (allInferredPkgNames().count(*it) == 0)
+         if (packageInformation().count(*it) == 0)
             result.push_back(*it);
       }
       return result;
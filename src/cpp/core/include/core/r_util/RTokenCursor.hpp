@@ -196,15 +196,15 @@ public:
    Position currentPosition(bool endOfToken = false) const
    {
       const RToken& token = currentToken();
-      return Position(token.row(), token.column() + (endOfToken ? token.length() : 0));
+      return Position(token.row(), token.column() + (endOfToken ? token.width() : 0));
    }
    
-   std::wstring::const_iterator begin() const
+   std::string::const_iterator begin() const
    {
       return currentToken().begin();
    }
    
-   std::wstring::const_iterator end() const
+   std::string::const_iterator end() const
    {
       return currentToken().end();
    }
@@ -254,12 +254,12 @@ public:
       return rTokens_.at(offset_);
    }
    
-   std::wstring content() const
+   std::string content() const
    {
       return currentToken().content();
    }
    
-   const std::string& contentAsUtf8() const
+   std::string contentAsUtf8() const
    {
       return currentToken().contentAsUtf8();
    }
@@ -286,12 +286,12 @@ public:
       return true;
    }
    
-   bool contentEquals(const std::wstring& content) const
+   bool contentEquals(const std::string& content) const
    {
       return currentToken().contentEquals(content);
    }
    
-   bool contentEquals(wchar_t character) const
+   bool contentEquals(char character) const
    {
       return currentToken().contentEquals(character);
    }
@@ -306,7 +306,7 @@ public:
       return currentToken().isType(type);
    }
    
-   bool contentContains(wchar_t character) const
+   bool contentContains(char character) const
    {
       return currentToken().contentContains(character);
    }
@@ -349,7 +349,7 @@ public:
    bool fwdOverBlank()
    {
       while (currentToken().isType(RToken::WHITESPACE) &&
-             !currentToken().contentContains(L'\n'))
+             !currentToken().contentContains('\n'))
          if (!moveToNextToken())
             return false;
       return true;
@@ -358,7 +358,7 @@ public:
    bool bwdOverBlank()
    {
       while (currentToken().isType(RToken::WHITESPACE) &&
-             !currentToken().contentContains(L'\n'))
+             !currentToken().contentContains('\n'))
          if (!moveToPreviousToken())
             return false;
       return true;
@@ -390,7 +390,7 @@ public:
       bool isSemi = token.isType(RToken::SEMI);
       bool isComma = token.isType(RToken::COMMA);
       bool hasNewline = token.isType(RToken::WHITESPACE) &&
-            token.contentContains(L'\n');
+            token.contentContains('\n');
       bool isRightParen = isRightBracket(token);
       bool isFinalToken = offset_ == n_ - 1;
 
@@ -560,7 +560,7 @@ public:
   bool isLookingAtNamedArgumentInFunctionCall()
   {
      return isValidAsIdentifier(*this) &&
-            nextSignificantToken().contentEquals(L"=");
+            nextSignificantToken().contentEquals("=");
   }
   
   bool appearsToBeBinaryOperator() const
@@ -662,20 +662,20 @@ public:
   //    foo + bar::baz$bam()
   //          ^^^^^^^^^^^^
   //
-  std::wstring getEvaluationAssociatedWithCall() const
+  std::string getEvaluationAssociatedWithCall() const
   {
      RTokenCursor cursor = clone();
      
      if (canOpenArgumentList(cursor))
         if (!cursor.moveToPreviousSignificantToken())
-           return std::wstring();
+           return std::string();
      
-     std::wstring::const_iterator end = cursor.end();
+     std::string::const_iterator end = cursor.end();
      if (!cursor.moveToStartOfEvaluation())
-        return std::wstring(cursor.begin(), cursor.end());
+        return std::string(cursor.begin(), cursor.end());
      
-     std::wstring::const_iterator begin = cursor.begin();
-     return std::wstring(begin, end);
+     std::string::const_iterator begin = cursor.begin();
+     return std::string(begin, end);
   }
   
   // Get the entirety of a function call, e.g.
@@ -683,17 +683,17 @@ public:
   //    foo + bar::baz$bam(a, b, c)
   //          ^^^^^^^^^^^^^^^^^^^^^
   //
-  std::wstring getFunctionCall() const
+  std::string getFunctionCall() const
   {
-     std::wstring evaluation = getEvaluationAssociatedWithCall();
+     std::string evaluation = getEvaluationAssociatedWithCall();
      RTokenCursor cursor = clone();
      if (!cursor.moveToNextSignificantToken())
-        return std::wstring();
+        return std::string();
      
      if (!cursor.fwdToMatchingToken())
-        return std::wstring();
+        return std::string();
      
-     return evaluation + std::wstring(this->end(), cursor.end());
+     return evaluation + std::string(this->end(), cursor.end());
   }
   
   // Check to see if this is an 'assignment' call, e.g.
@@ -802,7 +802,7 @@ public:
         //    (1, 2, 3)
         //
         // is actually two separate statements (the second being invalid)
-        if (!inParens && nextToken().contentContains(L'\n'))
+        if (!inParens && nextToken().contentContains('\n'))
            return true;
         
         // Bail on semi-colons.
@@ -842,7 +842,7 @@ public:
            if (!fwdToMatchingToken())
               return false;
            
-           if (!inParens && nextToken().contentContains(L'\n'))
+           if (!inParens && nextToken().contentContains('\n'))
               return true;
            
            // Bail on semi-colons.
@@ -864,7 +864,7 @@ public:
            if (!fwdToMatchingToken())
               return false;
            
-           if (!inParens && nextToken().contentContains(L'\n'))
+           if (!inParens && nextToken().contentContains('\n'))
               return true;
            
            continue;
@@ -983,8 +983,7 @@ PIPE_START:
      if (isPipeOperator(cursor.previousSignificantToken()))
         goto PIPE_START;
 
-     return core::string_utils::wideToUtf8(
-              std::wstring(cursor.begin(), endCursor.end()));
+     return std::string(cursor.begin(), endCursor.end());
      
      return onFailure;
      
@@ -30,14 +30,10 @@
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/regex.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <core/Macros.hpp>
 
-// On Linux confirm that wchar_t is Unicode
-#if !defined(_WIN32) && !defined(__APPLE__) && !defined(__STDC_ISO_10646__)
-   #error "wchar_t is not Unicode"
-#endif
-
 namespace rstudio {
 namespace core {
 
@@ -52,6 +48,9 @@ namespace r_util {
 // which yielded them (RTokenizer or RTokens) is alive. This is because
 // they contain iterators into the original source data rather than their
 // own copy of their contents.
+//
+// Token contents are UTF-8. Offsets and lengths are in bytes, while rows
+// and columns (as used for positions in the editor) are in characters.
 class RToken final
 {
 public:
@@ -82,8 +81,8 @@ public:
    RToken() = default;
 
    RToken(TokenType type,
-          std::wstring::const_iterator begin,
-          std::wstring::const_iterator end,
+          std::string::const_iterator begin,
+          std::string::const_iterator end,
           std::size_t offset,
           std::size_t row,
           std::size_t column)
@@ -94,12 +93,18 @@ public:
    
    // accessors
    TokenType type() const { return type_; }
-   std::wstring content() const { return std::wstring(begin_, end_); }
-   const std::string& contentAsUtf8() const;
+   std::string content() const { return std::string(begin_, end_); }
+   std::string contentAsUtf8() const { return content(); }
    std::size_t offset() const { return offset_; }
    std::size_t length() const { return end_ - begin_; }
    std::size_t row() const { return row_; }
    std::size_t column() const { return column_; }
+
+   // the number of characters (rather than bytes) in the token
+   std::size_t width() const
+   {
+      return std::count_if(begin_, end_, [](char ch) { return (ch & 0xC0) != 0x80; });
+   }
    
    core::collection::Position position() const
    {
@@ -107,29 +112,29 @@ public:
    }
 
    // efficient comparison operations
-   bool contentEquals(const std::wstring& text) const
+   bool contentEquals(const std::string& text) const
    {
       std::size_t distance = std::distance(begin_, end_);
       return distance == text.size() &&
              std::equal(begin_, end_, text.begin());
    }
    
-   bool contentEquals(wchar_t character) const
+   bool contentEquals(char character) const
    {
       return std::distance(begin_, end_) == 1 && *begin_ == character;
    }
    
-   bool contentContains(const wchar_t character) const
+   bool contentContains(const char character) const
    {
       return std::find(begin_, end_, character) != end_;
    }
 
-   bool contentStartsWith(const std::wstring& text) const
+   bool contentStartsWith(const std::string& text) const
    {
       return std::search(begin_, end_, text.begin(), text.end()) == begin_;
    }
 
-   bool isOperator(const std::wstring& op) const
+   bool isOperator(const std::string& op) const
    {
       return (type_ == RToken::OPER) &&
               std::equal(begin_, end_, op.begin());
@@ -154,17 +159,17 @@ public:
       return offset_ == static_cast<std::size_t>(-1);
    }
    
-   std::wstring::const_iterator begin() const
+   std::string::const_iterator begin() const
    {
       return begin_;
    }
    
-   std::wstring::const_iterator end() const
+   std::string::const_iterator end() const
    {
       return end_;
    }
    
-   std::pair<std::wstring::const_iterator, std::wstring::const_iterator> range() const
+   std::pair<std::string::const_iterator, std::string::const_iterator> range() const
    {
       return std::make_pair(begin_, end_);
    }
@@ -177,23 +182,47 @@ public:
    }
 
 private:
-   std::wstring emptyToken_;
+   friend class RTokens;
+
+   // point the token into (an edited copy of) the data which yielded it,
+   // moving it by the given number of bytes, rows and characters
+   void rebase(std::string::const_iterator dataBegin,
+               std::ptrdiff_t offsetDelta,
+               std::ptrdiff_t rowDelta,
+               std::ptrdiff_t columnDelta)
+   {
+      std::size_t length = end_ - begin_;
+      offset_ += offsetDelta;
+      row_ += rowDelta;
+      column_ += columnDelta;
+      begin_ = dataBegin + offset_;
+      end_ = begin_ + length;
+   }
+
+   // the (empty) contents of tokens which don't refer to any data
+   static const std::string& emptyToken()
+   {
+      static const std::string instance;
+      return instance;
+   }
+
+private:
    TokenType type_ = TokenType::ERR;
-   std::wstring::const_iterator begin_ = emptyToken_.cbegin();
-   std::wstring::const_iterator end_ = emptyToken_.cend();
+   std::string::const_iterator begin_ = emptyToken().cbegin();
+   std::string::const_iterator end_ = emptyToken().cend();
    std::size_t offset_ = -1;
    std::size_t row_ = 0;
    std::size_t column_ = 0;
 };
 
-// Tokenize R code. Note that the RToken instances which are returned are
-// valid only during the lifetime of the RTokenizer which yielded them
-// (because they store iterators into their content rather than making a copy
-// of the content)
+// Tokenize R code (encoded as UTF-8). Note that the RToken instances which
+// are returned are valid only during the lifetime of the RTokenizer which
+// yielded them (because they store iterators into their content rather than
+// making a copy of the content)
 class RTokenizer : boost::noncopyable
 {
 public:
-   explicit RTokenizer(const std::wstring& data)
+   explicit RTokenizer(const std::string& data)
       : data_(data),
         begin_(data_.begin()),
         end_(data_.end()),
@@ -209,6 +238,23 @@ public:
 
    RToken nextToken();
 
+   // the data being tokenized (which yielded tokens refer to)
+   const std::string& data() const { return data_; }
+
+   // the brackets open at the current position (needed to tokenize `]]`)
+   const std::vector<char>& braceStack() const { return braceStack_; }
+
+   // replace the bytes [offset, offset + length) of the data; this
+   // invalidates any tokens previously yielded
+   void replace(std::size_t offset, std::size_t length, const std::string& text);
+
+   // resume tokenizing at offset (which must be the start of a token) with
+   // the given position and open brackets
+   void seek(std::size_t offset,
+             std::size_t row,
+             std::size_t column,
+             const std::vector<char>& braceStack);
+
 private:
    Error matchRawStringLiteral(RToken* pToken);
    
@@ -221,18 +267,16 @@ private:
    RToken matchUserOperator();
    RToken matchOperator();
    bool eol();
-   wchar_t peek();
-   wchar_t peek(std::size_t lookahead);
-   wchar_t eat();
-   std::size_t tokenLength(const boost::wregex& regex);
-   void eatUntil(const boost::wregex& regex);
+   char peek();
+   char peek(std::size_t lookahead);
+   char eat();
    RToken consumeToken(RToken::TokenType tokenType, std::size_t length);
    
 private:
-   std::wstring data_;
-   std::wstring::const_iterator begin_;
-   std::wstring::const_iterator end_;
-   std::wstring::const_iterator pos_;
+   std::string data_;
+   std::string::const_iterator begin_;
+   std::string::const_iterator end_;
+   std::string::const_iterator pos_;
    std::size_t row_;
    std::size_t column_;
    std::vector<char> braceStack_; // needed for tokenization of `[[`, `[`
@@ -241,8 +285,8 @@ private:
 
 // Set of RTokens. Note that the RTokens returned from the set
 // are conceptually iterators so are only valid for the lifetime of
-// the RTokens object which yielded them.
-class RTokens
+// the RTokens object which yielded them (or until it is updated).
+class RTokens : boost::noncopyable
 {
    typedef std::vector<RToken> Tokens;
    
@@ -256,7 +300,13 @@ public:
 
 public:
    
-   void push_back(const RToken& rToken) { tokens_.push_back(rToken); }
+   void push_back(const RToken& rToken)
+   {
+      // keep track of the first error (if there isn't one yet it's at size())
+      if (firstError_ == tokens_.size() && !rToken.isType(RToken::ERR))
+         firstError_++;
+      tokens_.push_back(rToken);
+   }
    std::size_t size() const { return tokens_.size(); }
    bool empty() const { return tokens_.empty(); }
    
@@ -282,20 +332,25 @@ public:
    const_iterator begin() const { return tokens_.begin(); }
    const_iterator end() const { return tokens_.end(); }
    
-   explicit RTokens(const std::wstring& code, int flags = None)
-      : tokenizer_(code)
-   {
-      while (RToken token = tokenizer_.nextToken())
-      {
-         if ((flags & StripWhitespace) && token.type() == RToken::WHITESPACE)
-            continue;
+   explicit RTokens(const std::string& code, int flags = None);
 
-         if ((flags & StripComments) && token.type() == RToken::COMMENT)
-            continue;
+   // the code which was tokenized
+   const std::string& code() const { return tokenizer_.data(); }
 
-         push_back(token);
-      }
-   }
+   // the flags with which the code was tokenized
+   int flags() const { return flags_; }
+
+   // update the tokens to reflect the replacement of the bytes
+   // [offset, offset + length) of the code with text. rather than
+   // re-tokenizing the entire document, tokenizing resumes shortly before
+   // the edit and stops once it is back in step with the existing tokens
+   // (which are then reused). returns false (leaving the tokens unchanged)
+   // if the range is out of bounds
+   bool update(std::size_t offset, std::size_t length, const std::string& text);
+
+   // update the tokens to reflect new contents of the code, re-tokenizing
+   // only the part of the code which differs
+   void update(const std::string& code);
    
    friend std::ostream& operator <<(std::ostream& os,
                                     const RTokens& rTokens)
@@ -305,17 +360,55 @@ public:
       return os;
    }
 
+private:
+   // tokenizer state prior to a token (from which tokenizing can resume)
+   struct Checkpoint
+   {
+      std::size_t index;
+      std::vector<char> braceStack;
+   };
+
+   bool isStripped(const RToken& token) const;
+
 private:
     RTokenizer tokenizer_;
+    int flags_;
     Tokens tokens_;
+    std::vector<Checkpoint> checkpoints_;
+    std::size_t firstError_;
     RToken dummyToken_;
 };
 
+// Tokens of recently tokenized documents, which are updated incrementally
+// when a document is tokenized again after being edited (rather than being
+// tokenized from scratch)
+class RTokensCache : boost::noncopyable
+{
+public:
+   explicit RTokensCache(int flags, std::size_t capacity = 8)
+      : flags_(flags), capacity_(capacity)
+   {
+   }
+
+   // the tokens of code, identified by key (e.g. a document id or path). the
+   // tokens remain valid as long as the returned pointer is held
+   boost::shared_ptr<const RTokens> tokenize(const std::string& key,
+                                            const std::string& code);
+
+private:
+   typedef std::pair<std::string, boost::shared_ptr<RTokens> > Entry;
+
+   const int flags_;
+   const std::size_t capacity_;
+   boost::mutex mutex_;
+   std::deque<Entry> entries_; // most recently used first
+};
+
 namespace token_utils {
 
 inline bool isBinaryOp(const RToken& token)
 {
-   if (token.contentEquals(L'!'))
+   if (token.contentEquals('!'))
       return false;
    
    return token.isType(RToken::OPER) ||
@@ -325,42 +418,42 @@ inline bool isBinaryOp(const RToken& token)
 inline bool isLocalLeftAssign(const RToken& token)
 {
    return token.isType(RToken::OPER) && (
-            token.contentEquals(L"=") ||
-            token.contentEquals(L"<-") ||
-            token.contentEquals(L":="));
+            token.contentEquals("=") ||
+            token.contentEquals("<-") ||
+            token.contentEquals(":="));
 }
 
 inline bool isLocalRightAssign(const RToken& token)
 {
-   return token.isType(RToken::OPER) && token.contentEquals(L"->");
+   return token.isType(RToken::OPER) && token.contentEquals("->");
 }
 
 inline bool isParentLeftAssign(const RToken& token)
 {
    return token.isType(RToken::OPER) &&
-          token.contentEquals(L"<<-");
+          token.contentEquals("<<-");
 }
 
 inline bool isParentRightAssign(const RToken& token)
 {
    return token.isType(RToken::OPER) &&
-          token.contentEquals(L"->>");
+          token.contentEquals("->>");
 }
 
 inline bool isLeftAssign(const RToken& token)
 {
    return token.isType(RToken::OPER) && (
-            token.contentEquals(L"=") ||
-            token.contentEquals(L"<-") ||
-            token.contentEquals(L"<<-") ||
-            token.contentEquals(L":="));
+            token.contentEquals("=") ||
+            token.contentEquals("<-") ||
+            token.contentEquals("<<-") ||
+            token.contentEquals(":="));
 }
 
 inline bool isRightAssign(const RToken& token)
 {
    return token.isType(RToken::OPER) && (
-            token.contentEquals(L"->") ||
-            token.contentEquals(L"->>"));
+            token.contentEquals("->") ||
+            token.contentEquals("->>"));
 }
 
 inline bool isRightBracket(const RToken& rToken)
@@ -382,13 +475,13 @@ inline bool isLeftBracket(const RToken& rToken)
 inline bool isDollar(const RToken& rToken)
 {
    return rToken.isType(RToken::OPER) &&
-          rToken.contentEquals(L"$");
+          rToken.contentEquals("$");
 }
 
 inline bool isAt(const RToken& rToken)
 {
    return rToken.isType(RToken::OPER) &&
-          rToken.contentEquals(L"@");
+          rToken.contentEquals("@");
 }
 
 inline bool isId(const RToken& rToken)
@@ -399,14 +492,14 @@ inline bool isId(const RToken& rToken)
 inline bool isNamespaceExtractionOperator(const RToken& rToken)
 {
    return rToken.isType(RToken::OPER) && (
-            rToken.contentEquals(L"::") ||
-            rToken.contentEquals(L":::"));
+            rToken.contentEquals("::") ||
+            rToken.contentEquals(":::"));
 }
 
 inline bool isFunction(const RToken& rToken)
 {
    return rToken.isType(RToken::ID) &&
-          rToken.contentEquals(L"function");
+          rToken.contentEquals("function");
 }
 
 inline bool isString(const RToken& rToken)
@@ -440,16 +533,16 @@ inline bool isValidAsIdentifier(const RToken& rToken)
 inline bool hasNewline(const RToken& rToken)
 {
    return rToken.isType(RToken::WHITESPACE) &&
-          rToken.contentContains(L'\n');
+          rToken.contentContains('\n');
 }
 
 inline bool isValidAsUnaryOperator(const RToken& rToken)
 {
-   return rToken.contentEquals(L"-") ||
-          rToken.contentEquals(L"+") ||
-          rToken.contentEquals(L"!") ||
-          rToken.contentEquals(L"?") ||
-          rToken.contentEquals(L"~");
+   return rToken.contentEquals("-") ||
+          rToken.contentEquals("+") ||
+          rToken.contentEquals("!") ||
+          rToken.contentEquals("?") ||
+          rToken.contentEquals("~");
 }
 
 inline bool canStartExpression(const RToken& rToken)
@@ -468,12 +561,12 @@ inline bool isExtractionOperator(const RToken& rToken)
 
 inline bool isBlank(const RToken& rToken)
 {
-   return isWhitespace(rToken) && !rToken.contentContains(L'\n');
+   return isWhitespace(rToken) && !rToken.contentContains('\n');
 }
 
 inline bool isWhitespaceWithNewline(const RToken& rToken)
 {
-   return isWhitespace(rToken) && rToken.contentContains(L'\n');
+   return isWhitespace(rToken) && rToken.contentContains('\n');
 }
 
 inline bool canOpenArgumentList(const RToken& rToken)
@@ -514,13 +607,13 @@ inline bool canContinueStatement(const RToken& rToken)
 }
 
 inline bool isSymbolNamed(const RToken& rToken,
-                          const std::wstring& name)
+                          const std::string& name)
 {
    // For strings, check if the content within the quotes
    // is equal to the name provided. TODO: handle escaped
    // quotes within
    if (rToken.isType(RToken::STRING) ||
-       (rToken.isType(RToken::ID) && *rToken.begin() == L'`'))
+       (rToken.isType(RToken::ID) && *rToken.begin() == '`'))
    {
       std::size_t distance = std::distance(
                rToken.begin(), rToken.end());
@@ -538,10 +631,9 @@ inline bool isSymbolNamed(const RToken& rToken,
 inline std::string getSymbolName(const RToken& rToken)
 {
    if (rToken.isType(RToken::STRING) ||
-       (rToken.isType(RToken::ID) && *rToken.begin() == L'`'))
+       (rToken.isType(RToken::ID) && *rToken.begin() == '`'))
    {
-       return string_utils::wideToUtf8(
-          std::wstring(rToken.begin() + 1, rToken.end() - 1));
+       return std::string(rToken.begin() + 1, rToken.end() - 1);
    }
    
    return rToken.contentAsUtf8();
@@ -569,21 +661,21 @@ inline bool canFollowBinaryOperator(const RToken& rToken)
 
 inline bool isPipeOperator(const RToken& rToken)
 {
-   static const boost::wregex rePipe(L"^%[^>]*>+[^>]*%$");
+   static const boost::regex rePipe("^%[^>]*>+[^>]*%$");
    return regex_utils::match(rToken.begin(), rToken.end(), rePipe);
 }
 
 namespace {
 
-std::vector<std::wstring> makeNaKeywords()
+std::vector<std::string> makeNaKeywords()
 {
-   std::vector<std::wstring> keywords;
+   std::vector<std::string> keywords;
    
-   keywords.push_back(L"NA");
-   keywords.push_back(L"NA_character_");
-   keywords.push_back(L"NA_complex_");
-   keywords.push_back(L"NA_integer_");
-   keywords.push_back(L"NA_real_");
+   keywords.push_back("NA");
+   keywords.push_back("NA_character_");
+   keywords.push_back("NA_complex_");
+   keywords.push_back("NA_integer_");
+   keywords.push_back("NA_real_");
    
    return keywords;
 }
@@ -595,7 +687,7 @@ inline bool isNaKeyword(const RToken& rToken)
    if (!rToken.isType(RToken::ID))
       return false;
    
-   static const std::vector<std::wstring> naKeywords = makeNaKeywords();
+   static const std::vector<std::string> naKeywords = makeNaKeywords();
    for (const auto& naKeyword : naKeywords)
       if (rToken.contentEquals(naKeyword))
          return true;
@@ -0,0 +1,84 @@
+/*
+ * CompiledDictionary.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_SPELLING_COMPILED_DICTIONARY_HPP
+#define CORE_SPELLING_COMPILED_DICTIONARY_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/utility.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+class FilePath;
+
+namespace spelling {
+
+// Expand the words of a hunspell dictionary with the affixes each may take,
+// yielding them in the dictionary's encoding. Affix conditions and
+// continuation classes aren't evaluated, so some of the words yielded won't
+// be correct (and some correct words won't be yielded); the words are meant
+// to be checked against the dictionary itself before being compiled.
+Error expandDictionaryWords(const FilePath& affPath,
+                            const FilePath& dicPath,
+                            const boost::function<void(const std::string&)>& onWord);
+
+// A hash table of correctly spelled (UTF-8) words, compiled from a
+// dictionary. The table is memory mapped read-only, so every process using
+// the same compiled dictionary shares a single copy of it. Words that aren't
+// in the table aren't necessarily misspelled (e.g. compound words, or forms
+// built from several affixes); those need to be checked against the
+// dictionary itself.
+class CompiledDictionary : boost::noncopyable
+{
+public:
+   // write a compiled dictionary (written to a temporary file and then
+   // moved into place, so processes never see a partially written file)
+   static Error write(const FilePath& path, std::vector<std::string> words);
+
+   CompiledDictionary();
+
+   Error open(const FilePath& path);
+   void close();
+   bool isOpen() const { return pBuckets_ != nullptr; }
+
+   bool contains(const std::string& word) const;
+
+   // number of words, and size of the mapped table in bytes
+   std::size_t size() const { return static_cast<std::size_t>(count_); }
+   std::size_t bytes() const { return file_.is_open() ? file_.size() : 0; }
+
+private:
+   bool matches(std::uint64_t index, const std::string& word) const;
+
+   boost::iostreams::mapped_file_source file_;
+   const std::uint32_t* pBuckets_;
+   const std::uint64_t* pOffsets_;
+   const char* pWords_;
+   std::uint64_t count_;
+   std::uint64_t bucketCount_;
+};
+
+} // namespace spelling
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_SPELLING_COMPILED_DICTIONARY_HPP
@@ -39,9 +39,16 @@ typedef boost::function<core::Error(const std::string&,
 class HunspellSpellingEngine : public SpellingEngine
 {
 public:
+   // dictionaries are compiled into compiledDictionariesPath, if provided, so
+   // that they can be shared (see CompiledDictionary); a dictionary which
+   // hasn't been compiled yet is compiled on a background thread, which also
+   // calls iconvstrFunction
    HunspellSpellingEngine(const std::string& langId,
                           const HunspellDictionaryManager& dictionaryManager,
-                          const IconvstrFunction& iconvstrFunction);
+                          const IconvstrFunction& iconvstrFunction,
+                          const FilePath& compiledDictionariesPath = FilePath());
+
+   virtual ~HunspellSpellingEngine();
 
 public:
 
@@ -50,6 +57,9 @@ public:
    Error checkSpelling(const std::string& word,
                        bool *pCorrect);
 
+   void checkSpelling(const std::vector<std::string>& words,
+                      std::vector<bool>* pCorrect);
+
    Error suggestionList(const std::string& word,
                         std::vector<std::string>* pSugs);
 
@@ -38,6 +38,11 @@ public:
    virtual Error checkSpelling(const std::string& word,
                                bool *pCorrect) = 0;
 
+   // check a batch of words (words which can't be checked are logged and
+   // reported as correct)
+   virtual void checkSpelling(const std::vector<std::string>& words,
+                              std::vector<bool>* pCorrect) = 0;
+
    virtual Error suggestionList(const std::string& word,
                                 std::vector<std::string>* pSugs) = 0;
 
@@ -215,6 +215,15 @@ public:
    // poll for input and exit status
    void poll();
 
+#ifndef _WIN32
+   // poll, reading output and checking for exit only when asked to (for use
+   // when it's already known which children have output or have exited)
+   void poll(bool readOutput, bool checkExit);
+
+   // the output descriptors which are still being read
+   std::vector<int> outputFds() const;
+#endif
+
    // has it exited?
    virtual bool exited();
 
@@ -39,12 +39,20 @@ namespace system {
 struct FileScannerOptions
 {
    FileScannerOptions()
-      : recursive(false), yield(false)
+      : recursive(false), yield(false), threads(1)
    {
    }
 
    bool recursive;
    bool yield;
+
+   // number of threads used to read directories during a recursive scan
+   // (posix only). the resulting tree is the same regardless, however when
+   // more than one thread is used the filter is called concurrently from
+   // several threads (and onBeforeScanDir from threads other than the
+   // caller's, though never concurrently)
+   std::size_t threads;
+
    boost::function<bool(const FileInfo&)> filter;
    boost::function<Error(const FileInfo&)> onBeforeScanDir;
 };
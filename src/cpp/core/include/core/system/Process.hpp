@@ -348,7 +348,11 @@ ProcessCallbacks createProcessCallbacks(
 class ProcessSupervisor : boost::noncopyable
 {
 public:
-   ProcessSupervisor();
+   // On Linux the supervisor is told which children have output or have
+   // exited, and services only those each time it polls. Pass
+   // pollAllChildren (or set RSTUDIO_PROCESS_SUPERVISOR_POLL in the
+   // environment) to instead read from and wait on every child each time.
+   explicit ProcessSupervisor(bool pollAllChildren = false);
    virtual ~ProcessSupervisor();
 
    // Run a child asynchronously, invoking callbacks as the process starts,
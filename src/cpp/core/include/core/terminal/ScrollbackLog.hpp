@@ -0,0 +1,115 @@
+/*
+ * ScrollbackLog.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_TERMINAL_SCROLLBACK_LOG_HPP
+#define CORE_TERMINAL_SCROLLBACK_LOG_HPP
+
+#include <deque>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+
+namespace terminal {
+
+/*
+ * Persistent storage for a terminal's scrollback, kept as a ring of
+ * fixed-size segment files (<name>.0, <name>.1, ...) plus an index
+ * (<name>.index) recording the size and number of lines in each segment.
+ *
+ * Appends are buffered in memory and written by flush(), so a chatty
+ * process doesn't cost a file open and write for every chunk of output.
+ * The oldest segments are dropped once the log exceeds its maximum size,
+ * and the line index means finding the start of the last N lines (or any
+ * byte range) only requires reading the segments involved, however large
+ * the log has grown.
+ *
+ * Reads and trims include any output which is still buffered.
+ */
+class ScrollbackLog : boost::noncopyable
+{
+public:
+   ScrollbackLog(const FilePath& dir,
+                 const std::string& name,
+                 std::size_t segmentSize = 256 * 1024,
+                 std::size_t maxSize = 16 * 1024 * 1024);
+
+   // read the index of an existing log (if any)
+   Error open();
+
+   // add output (written on the next flush, or once enough is buffered)
+   Error append(const std::string& output);
+   Error flush();
+
+   // the log's size in bytes and the number of newlines within it
+   std::size_t size() const;
+   std::size_t lineCount() const;
+
+   // discard everything before the last maxLines lines (as
+   // string_utils::trimLeadingLines does)
+   Error trimLeadingLines(std::size_t maxLines, bool* pTrimmed = nullptr);
+
+   // read length bytes starting at offset (fewer if the log ends first)
+   Error read(std::size_t offset, std::size_t length, std::string* pOutput);
+   Error readAll(std::string* pOutput);
+
+   // discard anything following the final newline (everything if there's
+   // no newline at all)
+   Error removeLastLine();
+
+   // remove the log's files
+   Error remove();
+
+private:
+   struct Segment
+   {
+      std::size_t number;
+      std::size_t size;
+      std::size_t lines;
+   };
+
+   FilePath segmentPath(std::size_t number) const;
+   FilePath indexPath() const;
+   Error readSegment(const Segment& segment, std::string* pContents) const;
+   Error writeIndex() const;
+   Error dropOldestSegment();
+   Error removeNewestSegment();
+
+   const FilePath dir_;
+   const std::string name_;
+   const std::size_t segmentSize_;
+   const std::size_t maxSize_;
+
+   std::deque<Segment> segments_;
+
+   // the part of the first segment which has been trimmed away
+   std::size_t headSize_;
+   std::size_t headLines_;
+
+   // output which hasn't been written yet
+   std::string pending_;
+};
+
+} // namespace terminal
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_TERMINAL_SCROLLBACK_LOG_HPP
@@ -0,0 +1,152 @@
+/*
+ * FileNameIndex.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_TEXT_FILE_NAME_INDEX_HPP
+#define CORE_TEXT_FILE_NAME_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+// Score a fuzzy (subsequence) match of query against suggestion; lower
+// scores are better, and a perfect match scores 0.
+//
+// NOTE: When modifying this code, you should ensure that corresponding
+// changes are made to the client side scoreMatch function as well
+// (See: CodeSearchOracle.java)
+int scoreMatch(const std::string& suggestion,
+               const std::string& query,
+               bool isFile);
+
+// Index of the names of the files and folders in a tree (e.g. a project),
+// for fuzzy matching of file names. Paths are stored as a tree of interned
+// path components: each entry records only its parent and the id of its
+// name, and each distinct name is stored (and scored against a query) once.
+// Queries scan a flat table of per-name character masks to rule out most
+// names before any of them are compared, and return the best matches
+// (ranked with scoreMatch) rather than the first ones found.
+//
+// Paths are absolute and use '/' as a separator. Not thread safe: callers
+// synchronize access.
+class FileNameIndex : boost::noncopyable
+{
+public:
+   enum EntryTypes
+   {
+      Files       = 1,
+      Directories = 2,
+      All         = Files | Directories
+   };
+
+   struct Match
+   {
+      std::string path;
+      bool isDirectory;
+      int score;
+   };
+
+   // optional filter applied to matches before they're ranked
+   typedef boost::function<bool(const std::string& path, bool isDirectory)> Filter;
+
+   FileNameIndex();
+
+   // add a file or directory (along with any parent directories not yet
+   // present)
+   void add(const std::string& path, bool isDirectory);
+
+   // remove a file, or a directory and everything within it
+   void remove(const std::string& path);
+
+   void clear();
+
+   bool contains(const std::string& path) const;
+
+   // number of files and directories indexed
+   std::size_t size() const { return entryCount_; }
+
+   // number of distinct names
+   std::size_t nameCount() const { return nameIds_.size(); }
+
+   // the best matches for query (compared without regard to ASCII case) among
+   // the entries within directory, best first. names are matched unless
+   // matchRelativePath is set, in which case the path relative to directory
+   // is matched instead. pMoreAvailable is set when matches were dropped to
+   // keep to maxResults.
+   void search(const std::string& query,
+               const std::string& directory,
+               int types,
+               bool matchRelativePath,
+               std::size_t maxResults,
+               const Filter& filter,
+               std::vector<Match>* pMatches,
+               bool* pMoreAvailable) const;
+
+private:
+   static const uint32_t kNone = 0xFFFFFFFF;
+
+   struct Entry
+   {
+      uint32_t parent;
+      uint32_t name;
+      uint32_t firstChild;
+      uint32_t nextSibling;
+      bool isDirectory;
+   };
+
+   uint32_t internName(const std::string& name);
+   void releaseName(uint32_t id);
+   uint32_t findChild(uint32_t parent, uint32_t name) const;
+   uint32_t findPath(const std::string& path) const;
+   uint32_t addEntry(uint32_t parent, uint32_t name, bool isDirectory);
+   void removeEntry(uint32_t id);
+   std::string entryPath(uint32_t id) const;
+
+   static uint64_t childKey(uint32_t parent, uint32_t name)
+   {
+      return (static_cast<uint64_t>(parent) << 32) | name;
+   }
+
+   // interned names; a name's string is the key of its entry in nameIds_
+   // (whose nodes are stable), and its lower case form and character mask
+   // are kept in flat tables for scanning
+   std::unordered_map<std::string, uint32_t> nameIds_;
+   std::vector<const std::string*> names_;
+   std::vector<std::string> lowerNames_;
+   std::vector<uint64_t> nameMasks_;
+   std::vector<uint32_t> nameRefs_;
+   std::vector<uint32_t> freeNames_;
+
+   // entries, linked to their parents and (as lists) to their children; the
+   // top level entries are the children of kNone
+   std::vector<Entry> entries_;
+   std::vector<uint32_t> freeEntries_;
+   uint32_t firstRoot_;
+   std::unordered_map<uint64_t, uint32_t> childIds_;
+   std::size_t entryCount_;
+};
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_TEXT_FILE_NAME_INDEX_HPP
@@ -0,0 +1,119 @@
+/*
+ * ParallelGrep.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_TEXT_PARALLEL_GREP_HPP
+#define CORE_TEXT_PARALLEL_GREP_HPP
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/regex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+#include <core/BoostThread.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+
+namespace text {
+
+struct GrepLine
+{
+   int lineNumber;
+   std::string text;
+
+   // byte offsets of the (non-empty) matches within text
+   std::vector<std::pair<std::size_t, std::size_t> > matches;
+};
+
+struct GrepFileResult
+{
+   std::string path;
+   std::vector<GrepLine> lines;
+};
+
+// Searches a list of files for lines matching a pattern, using a pool of
+// worker threads. Patterns have grep semantics: a regex is a basic (grep
+// style) regular expression, otherwise it is a literal string. Files
+// containing a NUL byte are treated as binary and skipped.
+//
+// Workers claim files from a shared cursor as they finish their previous
+// file, so a few large files don't hold up the rest of the search. Results
+// are collected in the order the files were passed, which lets callers
+// stream them while the search is still in progress.
+class ParallelGrep : boost::noncopyable
+{
+public:
+   // returns an error if the pattern can't be compiled
+   static Error create(const std::string& pattern,
+                       bool asRegex,
+                       bool ignoreCase,
+                       const std::vector<std::string>& files,
+                       std::size_t threadCount,
+                       boost::shared_ptr<ParallelGrep>* pGrep);
+
+   // cancels the search and waits for the workers to exit
+   ~ParallelGrep();
+
+   void cancel();
+
+   // move the results for the next files whose search has completed (those
+   // without matching lines are omitted) into pResults; returns false once
+   // every file's results have been collected
+   bool collect(std::vector<GrepFileResult>* pResults);
+
+   // block until the search is complete (or cancelled)
+   void wait();
+
+   // search a single file's contents (exposed for testing)
+   bool searchContents(const std::string& contents, std::vector<GrepLine>* pLines) const;
+
+private:
+   ParallelGrep(const boost::regex& regex,
+                const std::string& requiredLiteral,
+                bool ignoreCase,
+                const std::vector<std::string>& files);
+
+   void start(std::size_t threadCount);
+   void worker();
+   void searchFile(std::size_t index);
+
+   const boost::regex regex_;
+   const std::string requiredLiteral_;
+   const bool ignoreCase_;
+   const std::vector<std::string> files_;
+
+   std::atomic<std::size_t> nextFile_;
+   std::atomic<bool> cancelled_;
+   std::vector<boost::thread> threads_;
+
+   boost::mutex mutex_;
+   boost::condition_variable completedCondition_;
+   std::vector<GrepFileResult> results_;
+   std::vector<bool> completed_;
+   std::size_t nextToCollect_;
+   std::size_t completedCount_;
+};
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_TEXT_PARALLEL_GREP_HPP
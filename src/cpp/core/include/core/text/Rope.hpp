@@ -0,0 +1,82 @@
+/*
+ * Rope.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_TEXT_ROPE_HPP
+#define CORE_TEXT_ROPE_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+// Text stored as a sequence of immutable chunks of bounded size, each of
+// which caches its crc32 checksum. Replacing a range of text only rebuilds
+// the chunks it touches and the checksum of the whole is recomputed from
+// those of its chunks, so edits to large documents are proportional to the
+// size of the edit rather than of the document. Chunks are shared between
+// copies, so copying a rope is also cheap.
+class Rope
+{
+public:
+   Rope();
+   explicit Rope(const std::string& text);
+
+   void assign(const std::string& text);
+   void clear();
+
+   std::size_t size() const { return size_; }
+   bool empty() const { return size_ == 0; }
+   std::size_t chunkCount() const { return chunks_.size(); }
+
+   // replace the bytes [offset, offset + length) with text; returns false
+   // (leaving the rope unchanged) if the range is out of bounds
+   bool replace(std::size_t offset, std::size_t length, const std::string& text);
+
+   // the bytes [offset, offset + length), which must be in bounds
+   std::string substr(std::size_t offset, std::size_t length) const;
+
+   std::string str() const;
+   void appendTo(std::string* pStr) const;
+
+   // crc32 checksum of the entire text (same as hash::crc32 of str())
+   boost::uint32_t crc32() const;
+
+   bool operator==(const Rope& other) const;
+   bool operator!=(const Rope& other) const { return !(*this == other); }
+
+private:
+   struct Chunk;
+   typedef boost::shared_ptr<const Chunk> ChunkPtr;
+
+   void appendChunks(const std::string& text, std::vector<ChunkPtr>* pChunks) const;
+
+   // index of the chunk containing offset (or the last chunk when offset
+   // is at the end) along with the offset at which that chunk starts
+   std::size_t findChunk(std::size_t offset, std::size_t* pChunkStart) const;
+
+   std::vector<ChunkPtr> chunks_;
+   std::size_t size_;
+};
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_TEXT_ROPE_HPP
@@ -0,0 +1,131 @@
+/*
+ * TrigramIndex.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_TEXT_TRIGRAM_INDEX_HPP
+#define CORE_TEXT_TRIGRAM_INDEX_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/utility.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+class FilePath;
+
+namespace text {
+
+// Index of the (ASCII case-folded) byte trigrams contained in a set of
+// files. Used to narrow a text search down to the files which could
+// possibly contain a literal string; the candidates must still be verified
+// by actually searching them.
+//
+// Files which were too large to index are recorded as such and are always
+// returned as candidates. Files which look binary (i.e. contain a NUL
+// byte) are never returned as candidates.
+//
+// Not thread safe: callers synchronize access.
+class TrigramIndex : boost::noncopyable
+{
+public:
+   TrigramIndex();
+
+   // add or replace the entry for a file
+   void update(const std::string& path,
+               std::time_t lastWriteTime,
+               uintmax_t size,
+               const std::string& contents);
+
+   // record a file which is searchable but whose contents weren't indexed
+   void updateUnindexed(const std::string& path,
+                        std::time_t lastWriteTime,
+                        uintmax_t size);
+
+   void remove(const std::string& path);
+
+   void clear();
+
+   // is the entry for this file present and up to date?
+   bool isCurrent(const std::string& path,
+                  std::time_t lastWriteTime,
+                  uintmax_t size) const;
+
+   std::size_t size() const { return pathIds_.size(); }
+
+   // all indexed paths, in no particular order
+   void paths(std::vector<std::string>* pPaths) const;
+
+   // files which may contain the passed literal (which is compared without
+   // regard to ASCII case). literals shorter than three bytes can't be
+   // narrowed so match every file; only the trigrams of a literal that are
+   // pure ASCII are used when ignoreCase is true (non-ASCII letters can have
+   // case variants of a different byte sequence)
+   void candidates(const std::string& literal,
+                   bool ignoreCase,
+                   std::vector<std::string>* pPaths) const;
+
+   // persist the index to (or restore it from) a file. a file written by an
+   // incompatible version is treated as empty
+   Error writeToFile(const FilePath& filePath) const;
+   Error readFromFile(const FilePath& filePath);
+
+private:
+   enum EntryFlags
+   {
+      kEntryIndexed = 1,
+      kEntryBinary = 2
+   };
+
+   struct Entry
+   {
+      Entry() : lastWriteTime(0), size(0), flags(0) {}
+
+      std::string path;
+      std::time_t lastWriteTime;
+      uintmax_t size;
+      uint32_t flags;
+      std::vector<uint32_t> trigrams; // sorted, unique
+   };
+
+   uint32_t allocateEntry(const std::string& path);
+   void addPostings(uint32_t id);
+   void removePostings(uint32_t id);
+
+   std::vector<Entry> entries_;
+   std::vector<uint32_t> freeIds_;
+   std::unordered_map<std::string, uint32_t> pathIds_;
+
+   // trigram => sorted ids of the files containing it
+   std::unordered_map<uint32_t, std::vector<uint32_t> > postings_;
+
+   // ids of files which are always candidates
+   std::vector<uint32_t> unindexed_;
+};
+
+// Extract the longest string which every match of the passed basic (grep
+// style) regular expression must contain; returns an empty string if no
+// such string can be determined (e.g. the pattern uses alternation)
+std::string requiredLiteral(const std::string& basicRegex);
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_TEXT_TRIGRAM_INDEX_HPP
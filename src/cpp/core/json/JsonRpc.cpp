@@ -34,8 +34,9 @@ Error parseJsonRpcRequest(const std::string& input, JsonRpcRequest* pRequest)
 {
    try 
    {
-      // parse data and verify it contains an object
-      Value var;
+      // parse data and verify it contains an object (the parsed request is
+      // only read, and what's kept is copied out, so it can use an arena)
+      Value var(json::Allocation::Arena);
       if ( var.parse(input) || !var.isObject() )
       {
          return Error(json::errc::InvalidRequest, ERROR_LOCATION);
@@ -201,14 +202,72 @@ void JsonRpcResponse::runAfterResponse()
       afterResponse_();
 }
    
+void JsonRpcResponse::setRawResult(std::string&& result)
+{
+   response_.erase(json::kRpcResult);
+   pRawResult_.reset(new std::string(std::move(result)));
+}
+
+Value JsonRpcResponse::result()
+{
+   if (pRawResult_)
+   {
+      Value result;
+      Error error = result.parse(*pRawResult_);
+      if (error)
+         LOG_ERROR(error);
+      return result;
+   }
+
+   return response_[json::kRpcResult];
+}
+
 Object JsonRpcResponse::getRawResponse()
 {
+   if (pRawResult_)
+   {
+      Object response = response_;
+      response[json::kRpcResult] = result();
+      return response;
+   }
+
    return response_;
 }
    
 void JsonRpcResponse::write(std::ostream& os) const
 {
-   response_.write(os);
+   Writer writer(os);
+   write(writer);
+}
+
+void JsonRpcResponse::write(std::string* pOutput) const
+{
+   // a raw result is usually large, so size the output for it up front
+   // rather than letting the string grow (and copy) repeatedly around it
+   if (pRawResult_)
+      pOutput->reserve(pOutput->size() + pRawResult_->size() + 256);
+
+   Writer writer(pOutput);
+   write(writer);
+}
+
+void JsonRpcResponse::write(Writer& writer) const
+{
+   if (!pRawResult_)
+   {
+      writer.value(response_);
+      return;
+   }
+
+   writer.startObject();
+   for (const Object::Member& member : response_)
+   {
+      writer.key(member.getName());
+      writer.value(member.getValue());
+   }
+   writer.key(json::kRpcResult);
+   writer.rawValue(*pRawResult_);
+   writer.endObject();
 }
    
 void JsonRpcResponse::setError(const Error& error,
@@ -218,6 +277,7 @@ void JsonRpcResponse::setError(const Error& error,
    // remove result
    response_.erase(json::kRpcResult);
    response_.erase(json::kRpcAsyncHandle);
+   pRawResult_.reset();
    
    if (error.getName() == json::jsonRpcCategory().name())
    {
@@ -288,6 +348,7 @@ void JsonRpcResponse::setError(const boost::system::error_code& ec,
    // remove result
    response_.erase(json::kRpcResult);
    response_.erase(json::kRpcAsyncHandle);
+   pRawResult_.reset();
 
    // error from error code
    Object error;
@@ -324,6 +385,7 @@ void JsonRpcResponse::setAsyncHandle(const std::string& handle)
 {
    response_.erase(json::kRpcResult);
    response_.erase(json::kRpcError);
+   pRawResult_.reset();
 
    setField(json::kRpcAsyncHandle, handle);
 }
@@ -342,9 +404,9 @@ void setJsonRpcResponse(const JsonRpcResponse& jsonRpcResponse,
        pResponse->setContentType(json::kJsonContentType);
    
    // set body 
-   std::stringstream responseStream;
-   jsonRpcResponse.write(responseStream);
-   Error error = pResponse->setBody(responseStream);
+   std::string body;
+   jsonRpcResponse.write(&body);
+   Error error = pResponse->setBody(std::move(body));
    
    // report error to client if one occurred
    if (error)
@@ -372,6 +434,7 @@ bool JsonRpcResponse::parse(const Value& value,
       return false;
 
    pResponse->response_ = value.getValue<json::Object>();
+   pResponse->pRawResult_.reset();
    return true;
 }
 
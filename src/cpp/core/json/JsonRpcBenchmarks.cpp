@@ -0,0 +1,279 @@
+/*
+ * JsonRpcBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/function.hpp>
+
+#include <core/http/Response.hpp>
+#include <core/json/JsonRpc.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+// the shape of a large data viewer page (see writeData in DataViewer.cpp)
+struct GridPage
+{
+   int rows;
+   int cols;
+   std::vector<std::string> cells;
+};
+
+// the shape of a long git history (see vcsHistory in SessionGit.cpp)
+struct Commit
+{
+   std::string id;
+   std::string author;
+   std::string subject;
+   std::string description;
+   double date;
+   std::vector<std::string> refs;
+};
+
+GridPage makeGridPage(int in_rows, int in_cols)
+{
+   GridPage page;
+   page.rows = in_rows;
+   page.cols = in_cols;
+   page.cells.reserve(in_rows * in_cols);
+   for (int i = 0; i < in_rows * in_cols; i++)
+      page.cells.push_back(std::to_string(i * 0.37).substr(0, 9));
+   return page;
+}
+
+std::vector<Commit> makeHistory(int in_commits)
+{
+   std::vector<Commit> commits;
+   commits.reserve(in_commits);
+   for (int i = 0; i < in_commits; i++)
+   {
+      Commit commit;
+      commit.id = "3f0c1a2b9d8e7f6a5b4c3d2e1f0a9b8c7d6e" + std::to_string(10000 + i);
+      commit.author = "Jane Developer <jane@example.com>";
+      commit.subject = "Fix handling of edge case number " + std::to_string(i);
+      commit.description = "A longer description of the change. " + commit.subject;
+      commit.date = 1600000000.0 + i;
+      if (i % 100 == 0)
+         commit.refs.push_back("v1." + std::to_string(i / 100));
+      commits.push_back(commit);
+   }
+   return commits;
+}
+
+void gridAsTree(const GridPage& in_page, http::Response* pResponse)
+{
+   json::Array data;
+   for (int row = 0; row < in_page.rows; row++)
+   {
+      json::Array rowData;
+      rowData.push_back(row);
+      for (int col = 0; col < in_page.cols; col++)
+         rowData.push_back(in_page.cells[row * in_page.cols + col]);
+      data.push_back(rowData);
+   }
+
+   json::Object result;
+   result["draw"] = 1;
+   result["recordsTotal"] = in_page.rows;
+   result["recordsFiltered"] = in_page.rows;
+   result["data"] = data;
+
+   std::string output = result.write();
+   pResponse->setBody(output);
+}
+
+void gridStreamed(const GridPage& in_page, http::Response* pResponse)
+{
+   std::string output;
+   {
+      json::Writer writer(&output);
+      writer.startObject();
+      writer.key("draw").value(1);
+      writer.key("recordsTotal").value(in_page.rows);
+      writer.key("recordsFiltered").value(in_page.rows);
+      writer.key("data").startArray();
+      for (int row = 0; row < in_page.rows; row++)
+      {
+         writer.startArray();
+         writer.value(row);
+         for (int col = 0; col < in_page.cols; col++)
+            writer.value(in_page.cells[row * in_page.cols + col]);
+         writer.endArray();
+      }
+      writer.endArray();
+      writer.endObject();
+   }
+
+   pResponse->setBody(std::move(output));
+}
+
+void historyAsTree(const std::vector<Commit>& in_commits, http::Response* pResponse)
+{
+   json::Array ids, authors, subjects, descriptions, dates, refs;
+   for (const Commit& commit : in_commits)
+   {
+      ids.push_back(commit.id);
+      authors.push_back(commit.author);
+      subjects.push_back(commit.subject);
+      descriptions.push_back(commit.description);
+      dates.push_back(commit.date);
+
+      json::Array theseRefs;
+      for (const std::string& ref : commit.refs)
+         theseRefs.push_back(ref);
+      refs.push_back(theseRefs);
+   }
+
+   json::Object result;
+   result["id"] = ids;
+   result["author"] = authors;
+   result["subject"] = subjects;
+   result["description"] = descriptions;
+   result["date"] = dates;
+   result["refs"] = refs;
+
+   json::JsonRpcResponse rpcResponse;
+   rpcResponse.setResult(result);
+   json::setJsonRpcResponse(rpcResponse, pResponse);
+}
+
+void historyStreamed(const std::vector<Commit>& in_commits, http::Response* pResponse)
+{
+   std::string result;
+   {
+      json::Writer writer(&result);
+      writer.startObject();
+
+      writer.key("id").startArray();
+      for (const Commit& commit : in_commits)
+         writer.value(commit.id);
+      writer.endArray();
+
+      writer.key("author").startArray();
+      for (const Commit& commit : in_commits)
+         writer.value(commit.author);
+      writer.endArray();
+
+      writer.key("subject").startArray();
+      for (const Commit& commit : in_commits)
+         writer.value(commit.subject);
+      writer.endArray();
+
+      writer.key("description").startArray();
+      for (const Commit& commit : in_commits)
+         writer.value(commit.description);
+      writer.endArray();
+
+      writer.key("date").startArray();
+      for (const Commit& commit : in_commits)
+         writer.value(commit.date);
+      writer.endArray();
+
+      writer.key("refs").startArray();
+      for (const Commit& commit : in_commits)
+      {
+         writer.startArray();
+         for (const std::string& ref : commit.refs)
+            writer.value(ref);
+         writer.endArray();
+      }
+      writer.endArray();
+
+      writer.endObject();
+   }
+
+   json::JsonRpcResponse rpcResponse;
+   rpcResponse.setRawResult(std::move(result));
+   json::setJsonRpcResponse(rpcResponse, pResponse);
+}
+
+long maxRssKb()
+{
+   struct rusage usage;
+   ::getrusage(RUSAGE_SELF, &usage);
+   return usage.ru_maxrss;
+}
+
+// runs the producer in a child process, so that its peak RSS is measured
+// independently of the other scenarios, and reports the peak RSS growth and
+// the time until the response body is ready to be sent (the time to first
+// byte, since these producers run to completion before anything is written)
+void measure(const std::string& in_name,
+             const boost::function<void(http::Response*)>& in_producer)
+{
+   std::cout.flush();
+
+   pid_t pid = ::fork();
+   REQUIRE(pid != -1);
+   if (pid == 0)
+   {
+      long rssBefore = maxRssKb();
+      auto start = std::chrono::steady_clock::now();
+
+      http::Response response;
+      in_producer(&response);
+
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      long rssAfter = maxRssKb();
+
+      std::cout << "json rpc benchmark " << in_name << ": "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+                << " ms to first byte, peak RSS +" << (rssAfter - rssBefore) / 1024 << " MB"
+                << " (" << response.body().size() / (1024 * 1024) << " MB body)" << std::endl;
+      std::cout.flush();
+      ::_exit(0);
+   }
+
+   int status = 0;
+   REQUIRE(::waitpid(pid, &status, 0) == pid);
+   REQUIRE(WIFEXITED(status));
+   REQUIRE(WEXITSTATUS(status) == 0);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Json RPC Benchmarks")
+{
+   SECTION("Data viewer page")
+   {
+      // 20k rows of a 50 column data frame
+      GridPage page = makeGridPage(20000, 50);
+      measure("grid page (tree)", [&](http::Response* pResponse) { gridAsTree(page, pResponse); });
+      measure("grid page (streamed)", [&](http::Response* pResponse) { gridStreamed(page, pResponse); });
+   }
+
+   SECTION("Git history")
+   {
+      std::vector<Commit> commits = makeHistory(200000);
+      measure("git history (tree)", [&](http::Response* pResponse) { historyAsTree(commits, pResponse); });
+      measure("git history (streamed)", [&](http::Response* pResponse) { historyStreamed(commits, pResponse); });
+   }
+}
+
+} // end namespace tests
+} // end namespace core
+} // end namespace rstudio
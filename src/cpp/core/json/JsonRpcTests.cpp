@@ -350,6 +350,42 @@ TEST_CASE("JsonRpc")
       json::JsonRpcResponse jsonRpcResponse;
       jsonRpcResponse.setResult(root);
    }
+
+   SECTION("Raw results are written as if they were values")
+   {
+      json::Object object = createObject();
+
+      json::JsonRpcResponse expected;
+      expected.setResult(object);
+      std::string expectedOutput;
+      expected.write(&expectedOutput);
+
+      std::string rawResult;
+      {
+         json::Writer writer(&rawResult);
+         writer.value(object);
+      }
+
+      json::JsonRpcResponse jsonRpcResponse;
+      jsonRpcResponse.setRawResult(std::move(rawResult));
+      std::string output;
+      jsonRpcResponse.write(&output);
+
+      json::Value expectedValue, value;
+      REQUIRE_FALSE(expectedValue.parse(expectedOutput));
+      REQUIRE_FALSE(value.parse(output));
+      CHECK(value == expectedValue);
+      CHECK(jsonRpcResponse.result() == object);
+      CHECK(jsonRpcResponse.getRawResponse() == expectedValue);
+
+      // an error replaces the raw result
+      jsonRpcResponse.setError(Error(json::errc::ParamTypeMismatch, ERROR_LOCATION));
+      output.clear();
+      jsonRpcResponse.write(&output);
+      REQUIRE_FALSE(value.parse(output));
+      CHECK_FALSE(value.getObject().hasMember(json::kRpcResult));
+      CHECK(value.getObject().hasMember(json::kRpcError));
+   }
 }
 
 } // namespace tests
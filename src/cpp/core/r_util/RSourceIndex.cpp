@@ -43,27 +43,27 @@ bool isValidRPackageName(const std::string& pkgName)
    return regex_utils::match(pkgName, rePkgName);
 }
 
-std::wstring removeQuoteDelims(const std::wstring& input)
+std::string removeQuoteDelims(const std::string& input)
 {
    // since we know this was parsed as a quoted string we can just remove
    // the first and last characters
    if (input.size() >= 2)
-      return std::wstring(input, 1, input.size() - 2);
+      return std::string(input, 1, input.size() - 2);
    else
-      return std::wstring();
+      return std::string();
 }
 
 std::string contentAsUtf8(const RToken& token)
 {
    if (token.type() == RToken::STRING)
-      return string_utils::wideToUtf8(removeQuoteDelims(token.content()));
+      return removeQuoteDelims(token.content());
    else
-      return string_utils::wideToUtf8(token.content());
+      return token.content();
 }
 
 bool isTokenType(RTokens::const_iterator begin,
                  RTokens::const_iterator end,
-                 const wchar_t type)
+                 RToken::TokenType type)
 {
    return begin != end && begin->type() == type;
 }
@@ -108,7 +108,7 @@ bool advancePastNextToken(RTokens::const_iterator* pBegin,
 
 bool advancePastNextOperatorToken(RTokens::const_iterator* pBegin,
                                   RTokens::const_iterator end,
-                                  const std::wstring& op)
+                                  const std::string& op)
 {
    return advancePastNextToken(pBegin,
                                end,
@@ -116,9 +116,9 @@ bool advancePastNextOperatorToken(RTokens::const_iterator* pBegin,
 }
 
 // statics for signature parsing comparisons
-const std::wstring kOpEquals(L"=");
-const std::wstring kSignatureSymbol(L"signature");
-const std::wstring kCSymbol(L"c");
+const std::string kOpEquals("=");
+const std::string kSignatureSymbol("signature");
+const std::string kCSymbol("c");
 
 void parseSignatureFunction(RTokens::const_iterator begin,
                             RTokens::const_iterator end,
@@ -208,13 +208,13 @@ void parseSignature(RTokens::const_iterator begin,
 
 bool isMethodOrClassDefinition(const RToken& token)
 {
-   return token.contentStartsWith(L"set") && (
-            token.contentEquals(L"setGeneric") ||
-            token.contentEquals(L"setMethod") ||
-            token.contentEquals(L"setClass") ||
-            token.contentEquals(L"setGroupGeneric") ||
-            token.contentEquals(L"setClassUnion") ||
-            token.contentEquals(L"setRefClass"));
+   return token.contentStartsWith("set") && (
+            token.contentEquals("setGeneric") ||
+            token.contentEquals("setMethod") ||
+            token.contentEquals("setClass") ||
+            token.contentEquals("setGroupGeneric") ||
+            token.contentEquals("setClassUnion") ||
+            token.contentEquals("setRefClass"));
 }
 
 class IndexStatus
@@ -342,7 +342,7 @@ void libraryCallIndexer(const RTokenCursor& cursor,
    if (!cursor.isType(RToken::ID))
       return;
    
-   if (!(cursor.contentEquals(L"library") || cursor.contentEquals(L"require")))
+   if (!(cursor.contentEquals("library") || cursor.contentEquals("require")))
       return;
    
    RTokenCursor clone = cursor.clone();
@@ -382,19 +382,19 @@ void s4MethodIndexer(const RTokenCursor& cursor,
       bool isSetMethod = false;
       RSourceItem::Type setType = RSourceItem::None;
 
-      if (cursor.contentEquals(L"setMethod"))
+      if (cursor.contentEquals("setMethod"))
       {
          isSetMethod = true;
          setType = RSourceItem::Method;
       }
-      else if (cursor.contentEquals(L"setGeneric") ||
-               cursor.contentEquals(L"setGroupGeneric"))
+      else if (cursor.contentEquals("setGeneric") ||
+               cursor.contentEquals("setGroupGeneric"))
       {
          setType = RSourceItem::Method;
       }
-      else if (cursor.contentEquals(L"setClass") ||
-               cursor.contentEquals(L"setClassUnion") ||
-               cursor.contentEquals(L"setRefClass"))
+      else if (cursor.contentEquals("setClass") ||
+               cursor.contentEquals("setClassUnion") ||
+               cursor.contentEquals("setRefClass"))
       {
          setType = RSourceItem::Class;
       }
@@ -461,7 +461,7 @@ bool isVariableIndexable(const RTokenCursor& cursor,
          continue;
       
       // check that it's an R6Class
-      if (clone.contentEquals(L"R6Class"))
+      if (clone.contentEquals("R6Class"))
          return true;
    }
    
@@ -500,7 +500,7 @@ void variableAssignmentIndexer(const RTokenCursor& cursor,
    
    // determine index type (function or variable?)
    const RToken& nextToken = cursor.nextToken();
-   RSourceItem::Type type = nextToken.contentEquals(L"function")
+   RSourceItem::Type type = nextToken.contentEquals("function")
          ? RSourceItem::Function
          : RSourceItem::Variable;
    
@@ -517,7 +517,7 @@ void variableAssignmentIndexer(const RTokenCursor& cursor,
       
       // check for R6Class definition
       bool isR6Definition =
-            cursor.previousSignificantToken().contentEquals(L"R6Class") &&
+            cursor.previousSignificantToken().contentEquals("R6Class") &&
             cursor.nextSignificantToken().isType(RToken::STRING);
       
       if (!isR6Definition)
@@ -568,9 +568,12 @@ RSourceIndex::RSourceIndex(const std::string& context, const std::string& code)
    // clear any (source-local) inferred packages
    inferredPkgNames_.clear();
 
-   // tokenize and create token cursor
-   std::wstring wCode = string_utils::utf8ToWide(code, context);
-   RTokens rTokens(wCode, RTokens::StripWhitespace | RTokens::StripComments);
+   // tokenize (reusing the tokens from when this context was last indexed,
+   // so that only the edited part of the code is re-tokenized) and create
+   // token cursor
+   static RTokensCache cache(RTokens::StripWhitespace | RTokens::StripComments);
+   boost::shared_ptr<const RTokens> pTokens = cache.tokenize(context, code);
+   const RTokens& rTokens = *pTokens;
    if (rTokens.empty())
       return;
    
@@ -22,9 +22,9 @@ namespace unit_tests {
 
 using namespace core::r_util::token_cursor;
 
-bool isPipeOperator(const std::wstring& string)
+bool isPipeOperator(const std::string& string)
 {
-   static const boost::wregex rePipe(L"^%[^>]*>+[^>]*%$");
+   static const boost::regex rePipe("^%[^>]*>+[^>]*%$");
    return regex_utils::match(string.begin(), string.end(), rePipe);
 }
 
@@ -32,7 +32,7 @@ test_context("RTokenCursor")
 {
    test_that("Token cursors properly detect end of statements")
    {
-      RTokens rTokens(L"1 + 2\n");
+      RTokens rTokens("1 + 2\n");
       RTokenCursor cursor(rTokens);
       
       expect_true(cursor.isType(RToken::NUMBER));
@@ -47,19 +47,19 @@ test_context("RTokenCursor")
    
    test_that("Token cursor ignores EOL when in parenthetical scope")
    {
-      RTokens rTokens(L"(1\n+2)");
+      RTokens rTokens("(1\n+2)");
       RTokenCursor cursor(rTokens);
       expect_true(cursor.isType(RToken::LPAREN));
       expect_true(cursor.moveToNextSignificantToken());
       expect_true(cursor.isType(RToken::NUMBER));
       expect_true(cursor.nextToken().isType(RToken::WHITESPACE));
-      expect_true(cursor.nextToken().contentEquals(L"\n"));
+      expect_true(cursor.nextToken().contentEquals("\n"));
       expect_false(cursor.isAtEndOfStatement(true));
    }
    
    test_that("Move to position functions as expected")
    {
-      RTokens rTokens(L"\n\napple + 2");
+      RTokens rTokens("\n\napple + 2");
       RTokenCursor cursor(rTokens);
       
       expect_true(cursor.moveToPosition(2, 0));
@@ -74,28 +74,28 @@ test_context("RTokenCursor")
    
    test_that("pipe / chain operation heads are extracted successfully")
    {
-      expect_true(isPipeOperator(L"%>%"));
-      expect_true(isPipeOperator(L"%>>%"));
-      expect_true(isPipeOperator(L"%T>%"));
+      expect_true(isPipeOperator("%>%"));
+      expect_true(isPipeOperator("%>>%"));
+      expect_true(isPipeOperator("%T>%"));
       
-      RTokens rTokens(L"mtcars %>% first_level() %>% second_level(1");
+      RTokens rTokens("mtcars %>% first_level() %>% second_level(1");
       RTokenCursor cursor(rTokens);
       cursor.moveToEndOfTokenStream();
       expect_true(cursor.isType(RToken::NUMBER) &&
-                  cursor.contentEquals(L"1"));
+                  cursor.contentEquals("1"));
       
       expect_true(cursor.moveToOpeningParenAssociatedWithCurrentFunctionCall());
       expect_true(cursor.isType(RToken::LPAREN));
       expect_true(cursor.moveToPreviousSignificantToken());
-      expect_true(cursor.contentEquals(L"second_level"));
+      expect_true(cursor.contentEquals("second_level"));
       expect_true(cursor.moveToStartOfEvaluation());
-      expect_true(cursor.contentEquals(L"second_level"));
+      expect_true(cursor.contentEquals("second_level"));
       expect_true(cursor.getHeadOfPipeChain() == "mtcars");
    }
    
    test_that("pipe / chain operation lookups fail when not within associated chain")
    {
-      RTokens rTokens(L"mtcars %>% foo\nbar");
+      RTokens rTokens("mtcars %>% foo\nbar");
       RTokenCursor cursor(rTokens);
       cursor.moveToEndOfTokenStream();
       expect_true(cursor.getHeadOfPipeChain().empty());
@@ -103,43 +103,43 @@ test_context("RTokenCursor")
    
    test_that("evaluation lookarounds work")
    {
-      RTokens rTokens(L"foo$bar$baz[[1]]$bam");
+      RTokens rTokens("foo$bar$baz[[1]]$bam");
       RTokenCursor cursor(rTokens);
       
-      expect_true(cursor.contentEquals(L"foo"));
+      expect_true(cursor.contentEquals("foo"));
       expect_true(cursor.moveToEndOfEvaluation());
-      expect_true(cursor.contentEquals(L"baz"));
+      expect_true(cursor.contentEquals("baz"));
       expect_true(cursor.moveToStartOfEvaluation());
-      expect_true(cursor.contentEquals(L"foo"));
+      expect_true(cursor.contentEquals("foo"));
       
       expect_true(cursor.moveToEndOfStatement(false));
-      expect_true(cursor.contentEquals(L"bam"));
+      expect_true(cursor.contentEquals("bam"));
    }
 
    test_that("previousSignificantToken works at end of token list")
    {
-      RTokens rTokens(L"a <- b");
+      RTokens rTokens("a <- b");
       RTokenCursor cursor(rTokens);
       cursor.moveToEndOfTokenStream();
       auto result = cursor.previousSignificantToken();
       expect_true(result.isType(RToken::OPER));
-      expect_true(result.contentEquals(L"<-"));
+      expect_true(result.contentEquals("<-"));
    }
 
    test_that("previousSignificantToken works in middle of token list")
    {
-      RTokens rTokens(L"a <- b");
+      RTokens rTokens("a <- b");
       RTokenCursor cursor(rTokens);
       cursor.moveToEndOfTokenStream();
       cursor.moveToPreviousSignificantToken();
       auto result = cursor.previousSignificantToken();
       expect_true(result.isType(RToken::ID));
-      expect_true(result.contentEquals(L"a"));
+      expect_true(result.contentEquals("a"));
    }
 
    test_that("previousSignificantToken returns dummy token when already at beginning")
    {
-      RTokens rTokens(L"a <- b");
+      RTokens rTokens("a <- b");
       RTokenCursor cursor(rTokens);
       const auto& result = cursor.previousSignificantToken();
       expect_true(result.isType(RToken::ERR));
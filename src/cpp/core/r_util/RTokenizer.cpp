@@ -29,8 +29,8 @@
 
 #include <core/r_util/RTokenizer.hpp>
 
-#include <boost/regex.hpp>
-
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -45,57 +45,162 @@ namespace r_util {
 
 namespace {
 
-class TokenPatterns
+// tokens are matched by hand rather than with regular expressions (which
+// dominated the cost of tokenizing); the comments give the equivalent
+// expressions. the code is scanned as UTF-8 bytes: every character which
+// delimits a token is ASCII, so only identifiers and whitespace need to
+// decode multibyte characters
+
+inline bool isDigit(char c)
+{
+   return c >= '0' && c <= '9';
+}
+
+inline bool isHexDigit(char c)
+{
+   return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+inline bool isContinuationByte(char c)
+{
+   return (c & 0xC0) == 0x80;
+}
+
+// decodes the character starting at it (which must be before end), returning
+// its code point and (in pLength) its length in bytes. invalid bytes are
+// returned as U+FFFD, one byte at a time
+char32_t decode(std::string::const_iterator it,
+                std::string::const_iterator end,
+                std::size_t* pLength)
 {
-private:
-   friend TokenPatterns& tokenPatterns();
-   TokenPatterns()
-      : NUMBER(L"[0-9]*(\\.[0-9]*)?([eE][+-]?[0-9]*)?[Li]?"),
-        HEX_NUMBER(L"0x[0-9a-fA-F]*L?"),
-        USER_OPERATOR(L"%[^\\n%]*%"),
-        QUOTED_IDENTIFIER(L"`[^`]*`"),
-        UNTIL_END_QUOTE(L"[\\\\\'\"]"),
-        WHITESPACE(L"[\\s\x00A0\x3000]+"),
-        COMMENT(L"#[^\\n]*$")
+   unsigned char lead = static_cast<unsigned char>(*it);
+   if (lead < 0x80)
+   {
+      *pLength = 1;
+      return lead;
+   }
+
+   std::size_t length;
+   char32_t codePoint;
+   if (lead >= 0xC2 && lead <= 0xDF)
+   {
+      length = 2;
+      codePoint = lead & 0x1F;
+   }
+   else if (lead >= 0xE0 && lead <= 0xEF)
+   {
+      length = 3;
+      codePoint = lead & 0x0F;
+   }
+   else if (lead >= 0xF0 && lead <= 0xF4)
+   {
+      length = 4;
+      codePoint = lead & 0x07;
+   }
+   else
+   {
+      *pLength = 1;
+      return 0xFFFD;
+   }
+
+   if (end - it < static_cast<std::ptrdiff_t>(length))
+   {
+      *pLength = 1;
+      return 0xFFFD;
+   }
+
+   for (std::size_t i = 1; i < length; i++)
    {
+      char c = *(it + i);
+      if (!isContinuationByte(c))
+      {
+         *pLength = 1;
+         return 0xFFFD;
+      }
+      codePoint = (codePoint << 6) | (c & 0x3F);
    }
 
-public:
-   const boost::wregex NUMBER;
-   const boost::wregex HEX_NUMBER;
-   const boost::wregex USER_OPERATOR;
-   const boost::wregex QUOTED_IDENTIFIER;
-   const boost::wregex UNTIL_END_QUOTE;
-   const boost::wregex WHITESPACE;
-   const boost::wregex COMMENT;
-};
+   *pLength = length;
+   return codePoint;
+}
+
+// the length of the character starting at it
+std::size_t characterLength(std::string::const_iterator it,
+                            std::string::const_iterator end)
+{
+   std::size_t length;
+   decode(it, end, &length);
+   return length;
+}
 
-TokenPatterns& tokenPatterns()
+// whether the character is a letter or digit (as used in identifiers)
+inline bool isAlnum(char32_t c)
 {
-   static TokenPatterns instance;
-   return instance;
+   if (c < 0x80)
+      return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+
+   return c < 0xFFFF && string_utils::isalnum(static_cast<wchar_t>(c));
 }
 
-void updatePosition(std::wstring::const_iterator pos,
+// the length of the whitespace character ([\s\x00A0\x3000]) starting at it,
+// or 0 if it isn't whitespace
+inline std::size_t whitespaceLength(std::string::const_iterator it,
+                                    std::string::const_iterator end)
+{
+   switch (*it)
+   {
+   case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+      return 1;
+   case '\xC2': // U+00A0
+      return (end - it >= 2 && *(it + 1) == '\xA0') ? 2 : 0;
+   case '\xE3': // U+3000
+      return (end - it >= 3 && *(it + 1) == '\x80' && *(it + 2) == '\x80') ? 3 : 0;
+   default:
+      return 0;
+   }
+}
+
+// the first occurrence of ch in [begin, end) (or end); this uses memchr,
+// which C libraries vectorize
+inline std::string::const_iterator find(std::string::const_iterator begin,
+                                        std::string::const_iterator end,
+                                        char ch)
+{
+   if (begin >= end)
+      return end;
+
+   const char* pBegin = &*begin;
+   const void* pFound = std::memchr(pBegin, ch, end - begin);
+   return pFound ? begin + (static_cast<const char*>(pFound) - pBegin) : end;
+}
+
+// the number of characters in [begin, end)
+inline std::size_t characterCount(std::string::const_iterator begin,
+                                  std::string::const_iterator end)
+{
+   return std::count_if(begin, end, [](char c) { return !isContinuationByte(c); });
+}
+
+void updatePosition(std::string::const_iterator pos,
                     std::size_t length,
                     std::size_t* pRow,
                     std::size_t* pColumn)
 {
    std::size_t newlineCount;
-   std::wstring::const_iterator it =
+   std::string::const_iterator it =
          string_utils::countNewlines(pos, pos + length, &newlineCount);
    
    if (newlineCount == 0)
    {
-      *pColumn += length;
+      *pColumn += characterCount(pos, pos + length);
    }
    else
    {
       *pRow += newlineCount;
       
-      // The column is now the token length, minus the
-      // index of the last newline.
-      *pColumn = length - (it - pos) - 1;
+      // The column is now the number of characters following the
+      // last newline.
+      *pColumn = characterCount(it + 1, pos + length);
    }
 }
 
@@ -113,13 +218,13 @@ RToken RTokenizer::nextToken()
   if (eol())
      return RToken();
 
-  wchar_t c = peek();
+  char c = peek();
 
   // check for raw string literals
-  if (c == L'r' || c == L'R')
+  if (c == 'r' || c == 'R')
   {
-     wchar_t next = peek(1);
-     if (next == L'"' || next == L'\'')
+     char next = peek(1);
+     if (next == '"' || next == '\'')
      {
         RToken token;
         Error error = matchRawStringLiteral(&token);
@@ -130,23 +235,23 @@ RToken RTokenizer::nextToken()
   
   switch (c)
   {
-  case L'(':
+  case '(':
      return consumeToken(RToken::LPAREN, 1);
-  case L')':
+  case ')':
      return consumeToken(RToken::RPAREN, 1);
-  case L'{':
+  case '{':
      return consumeToken(RToken::LBRACE, 1);
-  case L'}':
+  case '}':
      return consumeToken(RToken::RBRACE, 1);
-  case L';':
+  case ';':
      return consumeToken(RToken::SEMI, 1);
-  case L',':
+  case ',':
      return consumeToken(RToken::COMMA, 1);
      
-  case L'[':
+  case '[':
   {
      RToken token;
-     if (peek(1) == L'[')
+     if (peek(1) == '[')
      {
         braceStack_.push_back(RToken::LDBRACKET);
         token = consumeToken(RToken::LDBRACKET, 2);
@@ -159,11 +264,11 @@ RToken RTokenizer::nextToken()
      return token;
   }
      
-  case L']':
+  case ']':
   {
      if (braceStack_.empty()) // TODO: warn?
      {
-        if (peek(1) == L']')
+        if (peek(1) == ']')
            return consumeToken(RToken::RDBRACKET, 2);
         else
            return consumeToken(RToken::RBRACKET, 1);
@@ -171,9 +276,9 @@ RToken RTokenizer::nextToken()
      else
      {
         RToken token;
-        if (peek(1) == L']')
+        if (peek(1) == ']')
         {
-           wchar_t top = braceStack_[braceStack_.size() - 1];
+           char top = braceStack_[braceStack_.size() - 1];
            if (top == RToken::LDBRACKET)
               token = consumeToken(RToken::RDBRACKET, 2);
            else
@@ -187,31 +292,36 @@ RToken RTokenizer::nextToken()
      }
   }
      
-  case L'"':
-  case L'\'':
+  case '"':
+  case '\'':
      return matchStringLiteral();
-  case L'`':
+  case '`':
      return matchQuotedIdentifier();
-  case L'#':
+  case '#':
      return matchComment();
-  case L'%':
+  case '%':
      return matchUserOperator();
-  case L' ': case L'\t': case L'\r': case L'\n':
-  case L'\x00A0': case L'\x3000':
+  case ' ': case '\t': case '\r': case '\n':
      return matchWhitespace();
+  case '\xC2': case '\xE3': // may be U+00A0 or U+3000
+     if (whitespaceLength(pos_, end_))
+        return matchWhitespace();
+     break;
   }
 
-  wchar_t cNext = peek(1);
+  char cNext = peek(1);
 
-  if ((c >= L'0' && c <= L'9')
-        || (c == L'.' && cNext >= L'0' && cNext <= L'9'))
+  if ((c >= '0' && c <= '9')
+        || (c == '.' && cNext >= '0' && cNext <= '9'))
   {
      RToken numberToken = matchNumber();
      if (numberToken.length() > 0)
         return numberToken;
   }
 
-  if (string_utils::isalnum(c) || c == L'.')
+  std::size_t length;
+  char32_t ch = decode(pos_, end_, &length);
+  if (isAlnum(ch) || c == '.')
   {
      // From Section 10.3.2, identifiers must not start with
      // a digit, nor may they start with a period followed by
@@ -227,15 +337,23 @@ RToken RTokenizer::nextToken()
   if (oper)
      return oper;
 
-  // Error!!
-  return consumeToken(RToken::ERR, 1);
+  // Error!! (consuming the whole of the offending character)
+  return consumeToken(RToken::ERR, length);
 }
 
 
 
 RToken RTokenizer::matchWhitespace()
 {
-   return consumeToken(RToken::WHITESPACE, tokenLength(tokenPatterns().WHITESPACE));
+   std::string::const_iterator it = pos_;
+   while (it != end_)
+   {
+      std::size_t length = whitespaceLength(it, end_);
+      if (length == 0)
+         break;
+      it += length;
+   }
+   return consumeToken(RToken::WHITESPACE, it - pos_);
 }
 
 Error RTokenizer::matchRawStringLiteral(RToken* pToken)
@@ -243,8 +361,8 @@ Error RTokenizer::matchRawStringLiteral(RToken* pToken)
    auto start = pos_;
    
    // consume leading 'r' or 'R'
-   wchar_t firstChar = eat();
-   if (!(firstChar == L'r' || firstChar == L'R'))
+   char firstChar = eat();
+   if (!(firstChar == 'r' || firstChar == 'R'))
    {
       pos_ = start;
       return tokenizeError(
@@ -253,8 +371,8 @@ Error RTokenizer::matchRawStringLiteral(RToken* pToken)
    }
    
    // consume quote character
-   wchar_t quoteChar = eat();
-   if (!(quoteChar == L'"' || quoteChar == L'\''))
+   char quoteChar = eat();
+   if (!(quoteChar == '"' || quoteChar == '\''))
    {
       pos_ = start;
       return tokenizeError(
@@ -264,30 +382,30 @@ Error RTokenizer::matchRawStringLiteral(RToken* pToken)
    
    // consume an optional number of hyphens
    int hyphenCount = 0;
-   wchar_t ch = eat();
-   while (ch == L'-')
+   char ch = eat();
+   while (ch == '-')
    {
       hyphenCount++;
       ch = eat();
    }
    
    // okay, we're now sitting on open parenthesis
-   wchar_t lhs = ch;
+   char lhs = ch;
    
    // form right boundary character based on consumed parenthesis.
    // if it wasn't a parenthesis, just look for the associated closing quote
-   wchar_t rhs;
-   if (lhs == L'(')
+   char rhs;
+   if (lhs == '(')
    {
-      rhs = L')';
+      rhs = ')';
    }
-   else if (lhs == L'{')
+   else if (lhs == '{')
    {
-      rhs = L'}';
+      rhs = '}';
    }
-   else if (lhs == L'[')
+   else if (lhs == '[')
    {
-      rhs = L']';
+      rhs = ']';
    }
    else
    {
@@ -312,7 +430,8 @@ Error RTokenizer::matchRawStringLiteral(RToken* pToken)
          break;
       
       // find the boundary character
-      wchar_t ch = eat();
+      pos_ = find(pos_, end_, rhs);
+      char ch = eat();
       if (ch != rhs)
          goto LOOP;
       
@@ -320,7 +439,7 @@ Error RTokenizer::matchRawStringLiteral(RToken* pToken)
       for (int i = 0; i < hyphenCount; i++)
       {
          ch = eat();
-         if (ch != L'-')
+         if (ch != '-')
             goto LOOP;
       }
       
@@ -347,27 +466,31 @@ Error RTokenizer::matchRawStringLiteral(RToken* pToken)
 
 RToken RTokenizer::matchStringLiteral()
 {
-   std::wstring::const_iterator start = pos_;
-   wchar_t quot = eat();
+   std::string::const_iterator start = pos_;
+   char quot = eat();
 
    while (!eol())
    {
-      eatUntil(tokenPatterns().UNTIL_END_QUOTE);
+      // skip to the next quote or escape ([\\'"])
+      while (pos_ != end_ && *pos_ != '\\' && *pos_ != '\'' && *pos_ != '"')
+         ++pos_;
 
       if (eol())
          break;
 
-      wchar_t c = eat();
+      char c = eat();
       if (c == quot)
       {
          // NOTE: this is where we used to set wellFormed = true
          break;
       }
 
-      if (c == L'\\')
+      if (c == '\\')
       {
+         // skip the escaped character (all of it, so that the string
+         // doesn't end within a multibyte character)
          if (!eol())
-            eat();
+            pos_ += characterLength(pos_, end_);
 
          // Actually the escape expression can be longer than
          // just the backslash plus one character--but we don't
@@ -396,19 +519,64 @@ RToken RTokenizer::matchStringLiteral()
 
 RToken RTokenizer::matchNumber()
 {
-   std::size_t length = tokenLength(tokenPatterns().HEX_NUMBER);
-   if (length == 0)
-      length = tokenLength(tokenPatterns().NUMBER);
+   std::string::const_iterator it = pos_;
+   if (peek() == '0' && peek(1) == 'x')
+   {
+      // 0x[0-9a-fA-F]*L?
+      it += 2;
+      while (it != end_ && isHexDigit(*it))
+         ++it;
+      if (it != end_ && *it == 'L')
+         ++it;
+   }
+   else
+   {
+      // [0-9]*(\.[0-9]*)?([eE][+-]?[0-9]*)?[Li]?
+      while (it != end_ && isDigit(*it))
+         ++it;
+      if (it != end_ && *it == '.')
+      {
+         ++it;
+         while (it != end_ && isDigit(*it))
+            ++it;
+      }
+      if (it != end_ && (*it == 'e' || *it == 'E'))
+      {
+         ++it;
+         if (it != end_ && (*it == '+' || *it == '-'))
+            ++it;
+         while (it != end_ && isDigit(*it))
+            ++it;
+      }
+      if (it != end_ && (*it == 'L' || *it == 'i'))
+         ++it;
+   }
 
-   return consumeToken(RToken::NUMBER, length);
+   return consumeToken(RToken::NUMBER, it - pos_);
 }
 
 RToken RTokenizer::matchIdentifier()
 {
-   std::wstring::const_iterator start = pos_;
-   eat();
-   while (string_utils::isalnum(peek()) || peek() == L'.' || peek() == L'_')
-      eat();
+   std::string::const_iterator start = pos_;
+   pos_ += characterLength(pos_, end_);
+   while (pos_ != end_)
+   {
+      char c = *pos_;
+      if (c == '.' || c == '_' || isDigit(c) ||
+          (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+      {
+         ++pos_;
+         continue;
+      }
+
+      if (!(c & 0x80))
+         break;
+
+      std::size_t length;
+      if (!isAlnum(decode(pos_, end_, &length)))
+         break;
+      pos_ += length;
+   }
    
    std::size_t row = row_;
    std::size_t column = column_;
@@ -424,82 +592,91 @@ RToken RTokenizer::matchIdentifier()
 
 RToken RTokenizer::matchQuotedIdentifier()
 {
-   std::size_t length = tokenLength(tokenPatterns().QUOTED_IDENTIFIER);
-   if (length == 0)
+   // `[^`]*`
+   std::string::const_iterator it = find(pos_ + 1, end_, '`');
+   if (it == end_)
       return consumeToken(RToken::ERR, 1);
    else
-      return consumeToken(RToken::ID, length);
+      return consumeToken(RToken::ID, it + 1 - pos_);
 }
 
 RToken RTokenizer::matchComment()
 {
-   return consumeToken(RToken::COMMENT, tokenLength(tokenPatterns().COMMENT));
+   // #[^\n]*$ -- note that '$' also matches before other line separators,
+   // but not between the characters of '\r\n', so the comment excludes a
+   // carriage return preceding the newline
+   std::string::const_iterator it = find(pos_ + 1, end_, '\n');
+   if (it != end_ && it - pos_ > 1 && *(it - 1) == '\r')
+      --it;
+   return consumeToken(RToken::COMMENT, it - pos_);
 }
 
 RToken RTokenizer::matchUserOperator()
 {
-   std::size_t length = tokenLength(tokenPatterns().USER_OPERATOR);
-   if (length == 0)
+   // %[^\n%]*%
+   std::string::const_iterator eol = find(pos_ + 1, end_, '\n');
+   std::string::const_iterator it = find(pos_ + 1, eol, '%');
+   if (it == eol)
       return consumeToken(RToken::ERR, 1);
    else
-      return consumeToken(RToken::UOPER, length);
+      return consumeToken(RToken::UOPER, it + 1 - pos_);
 }
 
 
 RToken RTokenizer::matchOperator()
 {
-   wchar_t cNext = peek(1);
-   wchar_t cNextNext = peek(2);
+   char cNext = peek(1);
+   char cNextNext = peek(2);
 
    switch (peek())
    {
-   case L':': // :::, ::, :=
+   case ':': // :::, ::, :=
    {
-      if (cNext == L'=')
+      if (cNext == '=')
          return consumeToken(RToken::OPER, 2);
       else
-         return consumeToken(RToken::OPER, 1 + (cNext == L':') + (cNextNext == L':'));
+         return consumeToken(RToken::OPER, 1 + (cNext == ':') + (cNextNext == ':'));
    }
       
-   case L'|':
-      return consumeToken(RToken::OPER, cNext == L'|' ? 2 : 1);
+   case '|':
+      return consumeToken(RToken::OPER, cNext == '|' ? 2 : 1);
       
-   case L'&':
-      return consumeToken(RToken::OPER, cNext == L'&' ? 2 : 1);
+   case '&':
+      return consumeToken(RToken::OPER, cNext == '&' ? 2 : 1);
       
-   case L'<': // <=, <-, <<-
+   case '<': // <=, <-, <<-
       
-      if (cNext == L'=' || cNext == L'-') // <=, <-
+      if (cNext == '=' || cNext == '-') // <=, <-
          return consumeToken(RToken::OPER, 2);
-      else if (cNext == L'<')
+      else if (cNext == '<')
       {
-         if (cNextNext == L'-') // <<-
+         if (cNextNext == '-') // <<-
             return consumeToken(RToken::OPER, 3);
       }
       else // plain old <
          return consumeToken(RToken::OPER, 1);
       
-   case L'-': // also -> and ->>
-      if (cNext == L'>')
-         return consumeToken(RToken::OPER, cNextNext == L'>' ? 3 : 2);
+   case '-': // also -> and ->>
+      if (cNext == '>')
+         return consumeToken(RToken::OPER, cNextNext == '>' ? 3 : 2);
       else
          return consumeToken(RToken::OPER, 1);
       
-   case L'*': // '*' and '**' (which R's parser converts to '^')
-      return consumeToken(RToken::OPER, cNext == L'*' ? 2 : 1);
+   case '*': // '*' and '**' (which R's parser converts to '^')
+      return consumeToken(RToken::OPER, cNext == '*' ? 2 : 1);
       
-   case L'+': case L'/': case L'?':
-   case L'^': case L'~': case L'$': case L'@':
+   case '+': case '/': case '?':
+   case '^': case '~': case '$': case '@':
       // single-character operators
       return consumeToken(RToken::OPER, 1);
       
-   case L'>': // also >=
-      return consumeToken(RToken::OPER, cNext == L'=' ? 2 : 1);
+   case '>': // also >=
+      return consumeToken(RToken::OPER, cNext == '=' ? 2 : 1);
       
-   case L'=': // also ==
-      return consumeToken(RToken::OPER, cNext == L'=' ? 2 : 1);
-   case L'!': // also !=
-      return consumeToken(RToken::OPER, cNext == L'=' ? 2 : 1);
+   case '=': // also ==
+      return consumeToken(RToken::OPER, cNext == '=' ? 2 : 1);
+   case '!': // also !=
+      return consumeToken(RToken::OPER, cNext == '=' ? 2 : 1);
    default:
       return RToken();
    }
@@ -510,12 +687,12 @@ bool RTokenizer::eol()
    return pos_ >= data_.end();
 }
 
-wchar_t RTokenizer::peek()
+char RTokenizer::peek()
 {
    return peek(0);
 }
 
-wchar_t RTokenizer::peek(std::size_t lookahead)
+char RTokenizer::peek(std::size_t lookahead)
 {
    if ((pos_ + lookahead) >= data_.end())
       return 0;
@@ -523,37 +700,38 @@ wchar_t RTokenizer::peek(std::size_t lookahead)
       return *(pos_ + lookahead);
 }
 
-wchar_t RTokenizer::eat()
+char RTokenizer::eat()
 {
-   wchar_t result = *pos_;
+   // don't advance past the end (e.g. when scanning an unterminated raw
+   // string literal)
+   if (eol())
+      return 0;
+
+   char result = *pos_;
    pos_++;
    return result;
 }
 
-std::size_t RTokenizer::tokenLength(const boost::wregex& regex)
+void RTokenizer::replace(std::size_t offset,
+                         std::size_t length,
+                         const std::string& text)
 {
-   boost::wsmatch match;
-   std::wstring::const_iterator end = data_.end();
-   boost::match_flag_type flg = boost::match_default | boost::match_continuous;
-   if (regex_utils::search(pos_, end, match, regex, flg))
-      return match.length();
-   else
-      return 0;
+   std::size_t pos = pos_ - data_.begin();
+   data_.replace(offset, length, text);
+   begin_ = data_.begin();
+   end_ = data_.end();
+   pos_ = data_.begin() + std::min(pos, data_.size());
 }
 
-void RTokenizer::eatUntil(const boost::wregex& regex)
+void RTokenizer::seek(std::size_t offset,
+                      std::size_t row,
+                      std::size_t column,
+                      const std::vector<char>& braceStack)
 {
-   boost::wsmatch match;
-   std::wstring::const_iterator end = data_.end();
-   if (regex_utils::search(pos_, end, match, regex))
-   {
-      pos_ = match[0].first;
-   }
-   else
-   {
-      // eat all on failure to match
-      pos_ = data_.end();
-   }
+   pos_ = data_.begin() + std::min(offset, data_.size());
+   row_ = row;
+   column_ = column;
+   braceStack_ = braceStack;
 }
 
 
@@ -578,7 +756,7 @@ RToken RTokenizer::consumeToken(RToken::TokenType tokenType,
    // Update the row, column for the next token.
    updatePosition(pos_, length, &row_, &column_);
    
-   std::wstring::const_iterator start = pos_;
+   std::string::const_iterator start = pos_;
    pos_ += length;
    return RToken(tokenType,
                  start,
@@ -588,58 +766,287 @@ RToken RTokenizer::consumeToken(RToken::TokenType tokenType,
                  column);
 }
 
-class ConversionCache
+namespace {
+
+// tokenizer state is recorded every so many tokens
+const std::size_t kCheckpointInterval = 64;
+
+// how far past its end the tokenizer may look when matching a token (e.g.
+// to tell `<` from `<<-`, or to decode the character following an
+// identifier)
+const std::size_t kMaxLookahead = 4;
+
+} // anonymous namespace
+
+RTokens::RTokens(const std::string& code, int flags)
+   : tokenizer_(code), flags_(flags), firstError_(0)
 {
-public:
-   
-   typedef std::wstring key_type;
-   typedef std::string mapped_type;
-   
-   bool contains(const RToken& token) const
+   while (true)
    {
-      return database_.count(token.content());
+      std::size_t index = tokens_.size();
+      bool checkpoint = index % kCheckpointInterval == 0 &&
+                        (checkpoints_.empty() || checkpoints_.back().index != index);
+      if (checkpoint)
+         checkpoints_.push_back(Checkpoint { index, tokenizer_.braceStack() });
+
+      RToken token = tokenizer_.nextToken();
+      if (!token)
+         break;
+
+      if (!isStripped(token))
+         push_back(token);
    }
-   
-   std::string& get(const RToken& token)
+}
+
+bool RTokens::isStripped(const RToken& token) const
+{
+   return ((flags_ & StripWhitespace) && token.type() == RToken::WHITESPACE) ||
+          ((flags_ & StripComments) && token.type() == RToken::COMMENT);
+}
+
+bool RTokens::update(std::size_t offset, std::size_t length, const std::string& text)
+{
+   const std::string& code = tokenizer_.data();
+   if (offset > code.size() || length > code.size() - offset)
+      return false;
+
+   // tokens after an error may depend on text arbitrarily far ahead (e.g. an
+   // unmatched backtick is an error only because there's no other backtick
+   // in the rest of the document) so tokenizing resumes no later than the
+   // first error before the edit
+   std::size_t limit = tokens_.size();
+   if (firstError_ < tokens_.size() && tokens_[firstError_].offset() < offset)
+      limit = firstError_;
+
+   // find the last checkpoint from which we can resume (its token must start
+   // far enough before the edit that neither it nor the token preceding it
+   // could have been affected)
+   auto canResume = [&](const Checkpoint& checkpoint)
    {
-      return database_[token.content()];
+      return checkpoint.index <= limit &&
+             checkpoint.index < tokens_.size() &&
+             tokens_[checkpoint.index].offset() + kMaxLookahead <= offset;
+   };
+   std::size_t resumable = std::partition_point(
+            checkpoints_.begin(), checkpoints_.end(), canResume) - checkpoints_.begin();
+
+   std::size_t restart = checkpoints_.size();
+   for (std::size_t i = resumable; i > 0; i--)
+   {
+      // a token following `r` may have been examined as a potential raw
+      // string (e.g. r"---x), so don't resume there
+      std::size_t index = checkpoints_[i - 1].index;
+      if (index > 0)
+      {
+         const RToken& previous = tokens_[index - 1];
+         if (previous.offset() + previous.length() == tokens_[index].offset() &&
+             (previous.contentEquals('r') || previous.contentEquals('R')))
+         {
+            continue;
+         }
+      }
+
+      restart = i - 1;
+      break;
    }
-   
-   void put(const RToken& token, const mapped_type& value)
+
+   std::size_t restartIndex = 0;
+   std::vector<char> braceStack;
+   const char* previousData = code.data();
+   if (restart < checkpoints_.size())
    {
-      database_[token.content()] = value;
+      const Checkpoint& checkpoint = checkpoints_[restart];
+      const RToken& token = tokens_[checkpoint.index];
+      restartIndex = checkpoint.index;
+      braceStack = checkpoint.braceStack;
+      tokenizer_.replace(offset, length, text);
+      tokenizer_.seek(token.offset(), token.row(), token.column(), braceStack);
    }
-   
-private:
-   std::map<key_type, mapped_type> database_;
-};
+   else
+   {
+      tokenizer_.replace(offset, length, text);
+      tokenizer_.seek(0, 0, 0, braceStack);
+   }
+
+   // tokenize until we reach a checkpoint following the edit (at the
+   // corresponding position and with the same brackets open) after which
+   // the existing tokens are again valid
+   std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(text.size()) -
+                          static_cast<std::ptrdiff_t>(length);
+   std::size_t editEnd = offset + text.size();
+   std::size_t next = restart < checkpoints_.size() ? restart + 1 : 0;
+
+   Tokens tokens;
+   std::vector<Checkpoint> checkpoints;
+   std::size_t resumeIndex = tokens_.size();
+   std::ptrdiff_t rowDelta = 0;
+   std::ptrdiff_t columnDelta = 0;
+   std::size_t columnDeltaRow = 0;
+   while (true)
+   {
+      braceStack = tokenizer_.braceStack();
+      RToken token = tokenizer_.nextToken();
+      if (!token)
+         break;
 
-ConversionCache& conversionCache()
+      if (isStripped(token))
+         continue;
+
+      if (token.offset() >= editEnd)
+      {
+         while (next < checkpoints_.size() &&
+                (checkpoints_[next].index >= tokens_.size() ||
+                 static_cast<std::ptrdiff_t>(tokens_[checkpoints_[next].index].offset()) + delta <
+                 static_cast<std::ptrdiff_t>(token.offset())))
+         {
+            next++;
+         }
+
+         if (next < checkpoints_.size() &&
+             checkpoints_[next].index < tokens_.size())
+         {
+            const Checkpoint& checkpoint = checkpoints_[next];
+            const RToken& existing = tokens_[checkpoint.index];
+            if (static_cast<std::ptrdiff_t>(existing.offset()) + delta ==
+                   static_cast<std::ptrdiff_t>(token.offset()) &&
+                existing.offset() >= offset + length &&
+                checkpoint.braceStack == braceStack)
+            {
+               resumeIndex = checkpoint.index;
+               rowDelta = static_cast<std::ptrdiff_t>(token.row()) -
+                          static_cast<std::ptrdiff_t>(existing.row());
+               columnDelta = static_cast<std::ptrdiff_t>(token.column()) -
+                             static_cast<std::ptrdiff_t>(existing.column());
+               columnDeltaRow = existing.row();
+               break;
+            }
+         }
+      }
+
+      if (tokens.size() % kCheckpointInterval == 0)
+         checkpoints.push_back(Checkpoint { restartIndex + tokens.size(), braceStack });
+      tokens.push_back(token);
+   }
+
+   // splice the new tokens in place of those they replace, moving the
+   // tokens which follow along (and those which precede if the data moved)
+   std::string::const_iterator dataBegin = tokenizer_.data().begin();
+   if (tokenizer_.data().data() != previousData)
+   {
+      for (std::size_t i = 0; i < restartIndex; i++)
+         tokens_[i].rebase(dataBegin, 0, 0, 0);
+   }
+
+   for (std::size_t i = resumeIndex; i < tokens_.size(); i++)
+   {
+      RToken& token = tokens_[i];
+      token.rebase(dataBegin, delta, rowDelta,
+                   token.row() == columnDeltaRow ? columnDelta : 0);
+   }
+
+   std::size_t replaced = resumeIndex - restartIndex;
+   std::ptrdiff_t indexDelta = static_cast<std::ptrdiff_t>(tokens.size()) -
+                               static_cast<std::ptrdiff_t>(replaced);
+   std::size_t common = std::min(replaced, tokens.size());
+   std::copy(tokens.begin(), tokens.begin() + common, tokens_.begin() + restartIndex);
+   if (tokens.size() > replaced)
+      tokens_.insert(tokens_.begin() + resumeIndex, tokens.begin() + common, tokens.end());
+   else
+      tokens_.erase(tokens_.begin() + restartIndex + common, tokens_.begin() + resumeIndex);
+
+   // the first error moves along with the tokens following the edit (unless
+   // it was among those replaced or one of the new tokens is an error)
+   if (firstError_ >= restartIndex)
+   {
+      auto isError = [](const RToken& token) { return token.isType(RToken::ERR); };
+      Tokens::const_iterator begin = tokens_.begin() + restartIndex;
+      Tokens::const_iterator end = begin + tokens.size();
+      Tokens::const_iterator error = std::find_if(begin, end, isError);
+      if (error != end)
+         firstError_ = error - tokens_.begin();
+      else if (firstError_ >= resumeIndex)
+         firstError_ += indexDelta;
+      else
+         firstError_ = std::find_if(end, tokens_.cend(), isError) - tokens_.begin();
+   }
+
+   // likewise for the checkpoints
+   auto byIndex = [](const Checkpoint& checkpoint, std::size_t index)
+   {
+      return checkpoint.index < index;
+   };
+   auto first = std::lower_bound(checkpoints_.begin(), checkpoints_.end(), restartIndex, byIndex);
+   auto last = std::lower_bound(first, checkpoints_.end(), resumeIndex, byIndex);
+   for (auto it = last; it != checkpoints_.end(); ++it)
+      it->index += indexDelta;
+   first = checkpoints_.erase(first, last);
+   checkpoints_.insert(first, checkpoints.begin(), checkpoints.end());
+
+   return true;
+}
+
+void RTokens::update(const std::string& code)
 {
-   static ConversionCache instance;
-   return instance;
+   const std::string& previous = tokenizer_.data();
+
+   // find the part of the code which differs (between the common prefix and
+   // the common suffix)
+   std::size_t prefix = std::mismatch(
+            previous.begin(),
+            previous.begin() + std::min(previous.size(), code.size()),
+            code.begin()).first - previous.begin();
+
+   std::size_t maxSuffix = std::min(previous.size(), code.size()) - prefix;
+   std::size_t suffix = std::mismatch(
+            previous.rbegin(),
+            previous.rbegin() + maxSuffix,
+            code.rbegin()).first - previous.rbegin();
+
+   if (prefix == previous.size() && prefix == code.size())
+      return;
+
+   update(prefix,
+          previous.size() - prefix - suffix,
+          code.substr(prefix, code.size() - prefix - suffix));
 }
 
-const std::string& RToken::contentAsUtf8() const
+boost::shared_ptr<const RTokens> RTokensCache::tokenize(const std::string& key,
+                                                        const std::string& code)
 {
-   ConversionCache& cache = conversionCache();
-   if (cache.contains(*this))
-      return cache.get(*this);
-   
-   std::string result = string_utils::wideToUtf8(content());
-   cache.put(*this, result);
-   return cache.get(*this);
+   boost::mutex::scoped_lock lock(mutex_);
+
+   auto it = std::find_if(entries_.begin(), entries_.end(),
+                          [&](const Entry& entry) { return entry.first == key; });
+
+   boost::shared_ptr<RTokens> pTokens;
+   if (it != entries_.end())
+   {
+      // tokens which are still in use elsewhere can't be updated in place
+      if (it->second.unique())
+      {
+         pTokens = it->second;
+         pTokens->update(code);
+      }
+      entries_.erase(it);
+   }
+
+   if (!pTokens)
+      pTokens.reset(new RTokens(code, flags_));
+
+   entries_.push_front(Entry(key, pTokens));
+   if (entries_.size() > capacity_)
+      entries_.resize(capacity_);
+
+   return pTokens;
 }
 
 std::string RToken::asString() const
 {
    std::stringstream ss;
-   ss << "('" << contentAsUtf8() << "', " << row_ << ", " << column_ << ")";
+   ss << "('" << content() << "', " << row_ << ", " << column_ << ")";
    return ss.str();
 }
 
 } // namespace r_util
 } // namespace core 
 } // namespace rstudio
-
-
@@ -0,0 +1,99 @@
+/*
+ * RTokenizerBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/r_util/RTokenizer.hpp>
+
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace r_util {
+
+using namespace boost::posix_time;
+
+namespace {
+
+std::string sampleCode(std::size_t size)
+{
+   std::string code;
+   for (int i = 0; code.size() < size; i++)
+   {
+      std::string n = std::to_string(i);
+      code +=
+         "#' Summarise group " + n + " (\xC3\xA9t\xC3\xA9)\n"
+         "summarise_" + n + " <- function(data, ..., .groups = NULL) {\n"
+         "   # validate the inputs\n"
+         "   stopifnot(is.data.frame(data), length(list(...)) >= 0L)\n"
+         "   x <- data[[\"value\"]][data$id %in% c(1, 2.5e-3, 0x1F)]\n"
+         "   msg <- sprintf('group %d: `%s`', " + n + "L, r\"(raw \"string\")\")\n"
+         "   if (!is.null(.groups) && nrow(data) > " + n + ") x[-1] else `my var` <<- x\n"
+         "}\n\n";
+   }
+   return code;
+}
+
+long elapsedMs(const ptime& start)
+{
+   return (microsec_clock::universal_time() - start).total_milliseconds();
+}
+
+} // anonymous namespace
+
+// tokenize a large document, then re-tokenize it as it is typed into (both
+// by applying the edits directly and by handing the edited document to a
+// cache, as diagnostics and the source index do)
+TEST_CASE("RTokenizer Benchmarks")
+{
+   const std::size_t kDocumentSize = 4 * 1024 * 1024;
+   const int kEdits = 200;
+
+   std::string code = sampleCode(kDocumentSize);
+
+   ptime start = microsec_clock::universal_time();
+   RTokens rTokens(code, RTokens::StripComments);
+   long tokenizeMs = elapsedMs(start);
+
+   std::size_t offset = code.size() / 2;
+   start = microsec_clock::universal_time();
+   for (int i = 0; i < kEdits; i++)
+      rTokens.update(offset + i, 0, "x");
+   long updateMs = elapsedMs(start);
+
+   RTokensCache cache(RTokens::StripComments);
+   cache.tokenize("document", code);
+   start = microsec_clock::universal_time();
+   for (int i = 0; i < kEdits; i++)
+   {
+      code.insert(offset + i, "x");
+      cache.tokenize("document", code);
+   }
+   long cachedMs = elapsedMs(start);
+
+   CHECK(rTokens.code() == code);
+
+   std::cout << "tokenize (" << code.size() / 1024 << "KB, "
+             << rTokens.size() << " tokens): " << tokenizeMs << "ms; "
+             << kEdits << " incremental updates: " << updateMs << "ms; "
+             << kEdits << " cached re-tokenizations: " << cachedMs << "ms" << std::endl;
+}
+
+} // namespace r_util
+} // namespace core
+} // namespace rstudio
@@ -18,6 +18,7 @@
 #include <core/r_util/RTokenizer.hpp>
 
 #include <iostream>
+#include <random>
 
 #include <tests/TestThat.hpp>
 
@@ -30,21 +31,21 @@ namespace {
 class Verifier
 {
 public:
-   Verifier(wchar_t defaultTokenType,
-            const std::wstring& prefix,
-            const std::wstring& suffix)
+   Verifier(char defaultTokenType,
+            const std::string& prefix,
+            const std::string& suffix)
       : defaultTokenType_(defaultTokenType),
         prefix_(prefix),
         suffix_(suffix)
    {
    }
 
-   void verify(const std::wstring& value)
+   void verify(const std::string& value)
    {
       verify(defaultTokenType_, value);
    }
 
-   void verify(wchar_t tokenType, const std::wstring& value)
+   void verify(char tokenType, const std::string& value)
    {
 
       RTokenizer rt(prefix_ + value + suffix_);
@@ -55,7 +56,7 @@ public:
          {
             if (tokenType != t.type())
             {
-               std::wcerr << value << L" : " << t.content() << std::endl;
+               std::cerr << value << " : " << t.content() << std::endl;
             }
             expect_true(tokenType == t.type());
             expect_true(value.length() == t.length());
@@ -66,166 +67,209 @@ public:
 
    }
 
-   void verify(const std::deque<std::wstring>& values)
+   void verify(const std::deque<std::string>& values)
    {
       verify(defaultTokenType_, values);
    }
 
-   void verify(int tokenType, const std::deque<std::wstring>& values)
+   void verify(int tokenType, const std::deque<std::string>& values)
    {
-      for (const std::wstring& value : values)
+      for (const std::string& value : values)
          verify(tokenType, value);
    }
 
 private:
-   const wchar_t defaultTokenType_;
-   const std::wstring prefix_;
-   const std::wstring suffix_;
+   const char defaultTokenType_;
+   const std::string prefix_;
+   const std::string suffix_;
 
 };
 
 
 void testVoid()
 {
-   RTokenizer rt(L"");
+   RTokenizer rt("");
    expect_true(!rt.nextToken());
 }
 
 void testSimple()
 {
-   Verifier v(RToken::ERR, L" ", L" ");
-   v.verify(RToken::LPAREN, L"(");
-   v.verify(RToken::RPAREN, L")");
-   v.verify(RToken::LBRACKET, L"[");
-   v.verify(RToken::RBRACKET, L"]");
-   v.verify(RToken::LBRACE, L"{");
-   v.verify(RToken::RBRACE, L"}");
-   v.verify(RToken::COMMA, L",");
-   v.verify(RToken::SEMI, L";");
+   Verifier v(RToken::ERR, " ", " ");
+   v.verify(RToken::LPAREN, "(");
+   v.verify(RToken::RPAREN, ")");
+   v.verify(RToken::LBRACKET, "[");
+   v.verify(RToken::RBRACKET, "]");
+   v.verify(RToken::LBRACE, "{");
+   v.verify(RToken::RBRACE, "}");
+   v.verify(RToken::COMMA, ",");
+   v.verify(RToken::SEMI, ";");
 }
 
 void testError()
 {
-   Verifier v(RToken::ERR, L" ", L" ");
+   Verifier v(RToken::ERR, " ", " ");
 }
 
 void testComment()
 {
-   Verifier v(RToken::COMMENT, L" ", L"\n");
-   v.verify(L"#");
-   v.verify(L"# foo #");
+   Verifier v(RToken::COMMENT, " ", "\n");
+   v.verify("#");
+   v.verify("# foo #");
 
-   Verifier v2(RToken::COMMENT, L" ", L"\r\n");
-   v2.verify(L"#");
-   v2.verify(L"# foo #");
+   Verifier v2(RToken::COMMENT, " ", "\r\n");
+   v2.verify("#");
+   v2.verify("# foo #");
 }
 
 
 void testNumbers()
 {
-   Verifier v(RToken::NUMBER, L" ", L" ");
-   v.verify(L"1");
-   v.verify(L"10");
-   v.verify(L"0.1");
-   v.verify(L"1.");
-   v.verify(L".2");
-   v.verify(L"1e-7");
-   v.verify(L"1.2e+7");
-   v.verify(L"2e");
-   v.verify(L"3e+");
-   v.verify(L"0x");
-   v.verify(L"0x0");
-   v.verify(L"0xDEADBEEF");
-   v.verify(L"0xcafebad");
-   v.verify(L"1L");
-   v.verify(L"0x10L");
-   v.verify(L"1000000L");
-   v.verify(L"1e6L");
-   v.verify(L"1.1L");
-   v.verify(L"1e-3L");
-   v.verify(L"2i");
-   v.verify(L"4.1i");
-   v.verify(L"1e-2i");
+   Verifier v(RToken::NUMBER, " ", " ");
+   v.verify("1");
+   v.verify("10");
+   v.verify("0.1");
+   v.verify("1.");
+   v.verify(".2");
+   v.verify("1e-7");
+   v.verify("1.2e+7");
+   v.verify("2e");
+   v.verify("3e+");
+   v.verify("0x");
+   v.verify("0x0");
+   v.verify("0xDEADBEEF");
+   v.verify("0xcafebad");
+   v.verify("1L");
+   v.verify("0x10L");
+   v.verify("1000000L");
+   v.verify("1e6L");
+   v.verify("1.1L");
+   v.verify("1e-3L");
+   v.verify("2i");
+   v.verify("4.1i");
+   v.verify("1e-2i");
 }
 
 
 void testOperators()
 {
-   Verifier v(RToken::OPER, L" ", L" ");
-   v.verify(L"+");
-   v.verify(L"-");
-   v.verify(L"*");
-   v.verify(L"/");
-   v.verify(L"^");
-   v.verify(L">");
-   v.verify(L">=");
-   v.verify(L"<");
-   v.verify(L"<=");
-   v.verify(L"==");
-   v.verify(L"!=");
-   v.verify(L"!");
-   v.verify(L"&");
-   v.verify(L"|");
-   v.verify(L"~");
-   v.verify(L"->");
-   v.verify(L"<-");
-   v.verify(L"->>");
-   v.verify(L"<<-");
-   v.verify(L"$");
-   v.verify(L":");
-   v.verify(L"=");
-   v.verify(L":=");
+   Verifier v(RToken::OPER, " ", " ");
+   v.verify("+");
+   v.verify("-");
+   v.verify("*");
+   v.verify("/");
+   v.verify("^");
+   v.verify(">");
+   v.verify(">=");
+   v.verify("<");
+   v.verify("<=");
+   v.verify("==");
+   v.verify("!=");
+   v.verify("!");
+   v.verify("&");
+   v.verify("|");
+   v.verify("~");
+   v.verify("->");
+   v.verify("<-");
+   v.verify("->>");
+   v.verify("<<-");
+   v.verify("$");
+   v.verify(":");
+   v.verify("=");
+   v.verify(":=");
 }
 
 void testUOperators()
 {
-   Verifier v(RToken::UOPER, L" ", L" ");
-   v.verify(L"%%");
-   v.verify(L"%test test%");
+   Verifier v(RToken::UOPER, " ", " ");
+   v.verify("%%");
+   v.verify("%test test%");
 }
 
 void testStrings()
 {
-   Verifier v(RToken::STRING, L" ", L" ");
-   v.verify(L"\"test\"");
-   v.verify(L"\" '$\t\r\n\\\"\"");
-   v.verify(L"\"\"");
-   v.verify(L"''");
-   v.verify(L"'\"'");
-   v.verify(L"'\\\"'");
-   v.verify(L"'\n'");
-   v.verify(L"'foo bar \\U654'");
+   Verifier v(RToken::STRING, " ", " ");
+   v.verify("\"test\"");
+   v.verify("\" '$\t\r\n\\\"\"");
+   v.verify("\"\"");
+   v.verify("''");
+   v.verify("'\"'");
+   v.verify("'\\\"'");
+   v.verify("'\n'");
+   v.verify("'foo bar \\U654'");
 }
 
 void testIdentifiers()
 {
-   Verifier v(RToken::ID, L" ", L" ");
-   v.verify(L".");
-   v.verify(L"...");
-   v.verify(L"..1");
-   v.verify(L"..2");
-   v.verify(L"foo");
-   v.verify(L"FOO");
-   v.verify(L"f1");
-   v.verify(L"a_b");
-   v.verify(L"ab_");
-   v.verify(L"`foo`");
-   v.verify(L"`$@!$@#$`");
-   v.verify(L"`a\n\"'b`");
-
-   v.verify(L"\x00C1" L"qc1");
-   v.verify(L"\x00C1" L"qc1" L"\x00C1");
+   Verifier v(RToken::ID, " ", " ");
+   v.verify(".");
+   v.verify("...");
+   v.verify("..1");
+   v.verify("..2");
+   v.verify("foo");
+   v.verify("FOO");
+   v.verify("f1");
+   v.verify("a_b");
+   v.verify("ab_");
+   v.verify("`foo`");
+   v.verify("`$@!$@#$`");
+   v.verify("`a\n\"'b`");
+
+   v.verify("\xC3\x81" "qc1");
+   v.verify("\xC3\x81" "qc1" "\xC3\x81");
 }
 
 void testWhitespace()
 {
-   Verifier v(RToken::WHITESPACE, L"a", L"z");
-   v.verify(L" ");
-   v.verify(L"      ");
-   v.verify(L"\t\n");
-   v.verify(L"\x00A0");
-   v.verify(L"  \x3000  ");
-   v.verify(L" \x00A0\t\x3000\r  ");
+   Verifier v(RToken::WHITESPACE, "a", "z");
+   v.verify(" ");
+   v.verify("      ");
+   v.verify("\t\n");
+   v.verify("\xC2\xA0");
+   v.verify("  \xE3\x80\x80  ");
+   v.verify(" \xC2\xA0\t\xE3\x80\x80\r  ");
+}
+
+// R code of (at least) the given size in bytes, including non-ASCII
+// identifiers, strings and comments
+std::string sampleCode(std::size_t size)
+{
+   std::string code;
+   for (int i = 0; code.size() < size; i++)
+   {
+      std::string n = std::to_string(i);
+      code +=
+         "#' Summarise group " + n + " (\xC3\xA9t\xC3\xA9)\n"
+         "summarise_" + n + " <- function(data, ..., .groups = NULL) {\n"
+         "   # validate the inputs\n"
+         "   stopifnot(is.data.frame(data), length(list(...)) >= 0L)\n"
+         "   gr\xC3\xB6\xC3\x9F" "e <- data[[\"value\"]][data$id %in% c(1, 2.5e-3, 0x1F)]\n"
+         "   msg <- sprintf('gruppe %d: `%s` \xE2\x80\x94 d\xC3\xADa', " + n + "L, r\"(raw \"string\")\")\n"
+         "   if (!is.null(.groups) && nrow(data) > " + n + ") gr\xC3\xB6\xC3\x9F" "e[-1] else `my var` <<- x\n"
+         "}\n\n";
+   }
+   return code;
+}
+
+bool tokensEqual(const RTokens& lhs, const RTokens& rhs)
+{
+   if (lhs.size() != rhs.size())
+      return false;
+
+   for (std::size_t i = 0; i < lhs.size(); i++)
+   {
+      const RToken& token = lhs.atUnsafe(i);
+      const RToken& other = rhs.atUnsafe(i);
+      if (token.type() != other.type() ||
+          token.offset() != other.offset() ||
+          token.row() != other.row() ||
+          token.column() != other.column() ||
+          token.content() != other.content())
+      {
+         return false;
+      }
+   }
+
+   return true;
 }
 
 
@@ -250,32 +294,32 @@ test_context("RTokenizer")
    
    test_that("Comments are tokenized without a trailing newline")
    {
-      RTokens rTokens(L"## this is a comment\n1");
+      RTokens rTokens("## this is a comment\n1");
       expect_true(rTokens.size() == 3);
       expect_true(rTokens.at(0).isType(RToken::COMMENT));
       expect_true(rTokens.at(1).isType(RToken::WHITESPACE));
-      expect_true(rTokens.at(1).contentEquals(L"\n"));
+      expect_true(rTokens.at(1).contentEquals("\n"));
       expect_true(rTokens.at(2).isType(RToken::NUMBER));
    }
    
    test_that("'**' is properly tokenized as a single operator")
    {
-      RTokens rTokens(L"1 ** 2");
+      RTokens rTokens("1 ** 2");
       expect_true(rTokens.size() == 5);
       expect_true(rTokens.at(0).isType(RToken::NUMBER));
       expect_true(rTokens.at(1).isType(RToken::WHITESPACE));
       expect_true(rTokens.at(2).isType(RToken::OPER));
-      expect_true(rTokens.at(2).contentEquals(L"**"));
+      expect_true(rTokens.at(2).contentEquals("**"));
    }
    
    test_that("plain raw strings are tokenized properly")
    {
       auto lines = {
-         L"r\"(abc)\"",
-         L"R\"(abc)\"",
-         L"r\"{abc}\"",
-         L"r'[abc]'",
-         L"R'{abc}'"
+         "r\"(abc)\"",
+         "R\"(abc)\"",
+         "r\"{abc}\"",
+         "r'[abc]'",
+         "R'{abc}'"
       };
       
       for (auto line : lines)
@@ -288,14 +332,23 @@ test_context("RTokenizer")
    
    test_that("unclosed raw strings are tokenized as errors")
    {
-      RTokens rTokens(L"r'(abc");
+      RTokens rTokens("r'(abc");
       expect_true(rTokens.size() == 1);
       expect_true(rTokens.at(0).isType(RToken::ERR));
    }
    
+   test_that("unclosed raw strings don't extend past the end of the document")
+   {
+      std::string code = "x <- r'(abc)-";
+      RTokens rTokens(code);
+      expect_true(rTokens.size() == 5);
+      expect_true(rTokens.at(4).isType(RToken::ERR));
+      expect_true(rTokens.at(4).offset() + rTokens.at(4).length() == code.size());
+   }
+   
    test_that("the raw string tokenizer restores iterator state if no raw string consumed")
    {
-      RTokens rTokens(L"rep('.')");
+      RTokens rTokens("rep('.')");
       expect_true(rTokens.size() == 4);
       expect_true(rTokens.at(0).isType(RToken::ID));
       expect_true(rTokens.at(1).isType(RToken::LPAREN));
@@ -303,6 +356,125 @@ test_context("RTokenizer")
       expect_true(rTokens.at(3).isType(RToken::RPAREN));
    }
    
+   test_that("rows and columns count characters while offsets count bytes")
+   {
+      // 'gr\u00F6\u00DFe <- "d\u00EDa"\n\u00F1'
+      RTokens rTokens("gr\xC3\xB6\xC3\x9F" "e <- \"d\xC3\xAD" "a\"\n\xC3\xB1",
+                      RTokens::StripWhitespace);
+      expect_true(rTokens.size() == 4);
+      
+      expect_true(rTokens.at(0).isType(RToken::ID));
+      expect_true(rTokens.at(0).length() == 7);
+      expect_true(rTokens.at(0).width() == 5);
+      
+      expect_true(rTokens.at(1).offset() == 8);
+      expect_true(rTokens.at(1).column() == 6);
+      
+      expect_true(rTokens.at(2).isType(RToken::STRING));
+      expect_true(rTokens.at(2).offset() == 11);
+      expect_true(rTokens.at(2).column() == 9);
+      expect_true(rTokens.at(2).width() == 5);
+      
+      expect_true(rTokens.at(3).isType(RToken::ID));
+      expect_true(rTokens.at(3).row() == 1);
+      expect_true(rTokens.at(3).column() == 0);
+   }
+   
+   test_that("invalid UTF-8 is tokenized as errors")
+   {
+      RTokens rTokens("x \xC3 y \xE2\x80");
+      expect_true(rTokens.size() == 8);
+      expect_true(rTokens.at(2).isType(RToken::ERR));
+      expect_true(rTokens.at(2).length() == 1);
+      expect_true(rTokens.at(4).isType(RToken::ID));
+      expect_true(rTokens.at(4).column() == 4);
+      expect_true(rTokens.at(6).isType(RToken::ERR));
+      expect_true(rTokens.at(7).isType(RToken::ERR));
+   }
+   
+   test_that("incrementally updated tokens match those of the edited code")
+   {
+      // includes non-ASCII characters, and the bytes of a multibyte
+      // character which may be inserted separately
+      const std::vector<std::string> fragments = {
+         " ", "\n", "\r\n", "# comment", "'", "\"", "\\", "`", "%", "%in%",
+         "r", "\"(", ")\"", "-", "[", "[[", "]", "]]", "(", ")", "{", "}",
+         "foo", ".", "1", "0x", "1e", "<", "<-", "::", "=", "!", "$", ",",
+         "\xC3\xA9", "\xC3", "\xA9", "\xC2\xA0", "\xE3\x80\x80", "\xE2\x80\x94"
+      };
+
+      std::mt19937 rng(17);
+      for (int flags = 0; flags < 4; flags++)
+      {
+         std::string code = sampleCode(20000);
+         RTokens rTokens(code, flags);
+         for (int i = 0; i < 200; i++)
+         {
+            std::size_t offset = rng() % (code.size() + 1);
+            std::size_t length = std::min<std::size_t>(rng() % 8, code.size() - offset);
+            std::string text;
+            for (std::size_t j = 0, n = rng() % 3; j < n; j++)
+               text += fragments[rng() % fragments.size()];
+
+            code.replace(offset, length, text);
+            expect_true(rTokens.update(offset, length, text));
+
+            RTokens expected(code, flags);
+            expect_true(rTokens.code() == code);
+            if (!tokensEqual(rTokens, expected))
+               FAIL("tokens differ after edit " << i);
+         }
+      }
+
+      RTokens rTokens("x <- 1");
+      expect_false(rTokens.update(7, 0, "2"));
+      expect_true(rTokens.update(6, 0, "2"));
+      expect_true(rTokens.at(4).contentEquals("12"));
+   }
+   
+   test_that("tokens can be updated from the edited code")
+   {
+      std::string code = sampleCode(5000);
+      RTokens rTokens(code);
+      
+      code.insert(code.size() / 2, "x <- \"d\xC3\xADa");
+      code.erase(100, 20);
+      rTokens.update(code);
+      
+      RTokens expected(code);
+      expect_true(rTokens.code() == code);
+      expect_true(tokensEqual(rTokens, expected));
+   }
+   
+   test_that("cached tokens are updated as documents are edited")
+   {
+      RTokensCache cache(RTokens::StripWhitespace, 2);
+      
+      std::string code = sampleCode(5000);
+      boost::shared_ptr<const RTokens> pTokens = cache.tokenize("a", code);
+      const RTokens* pFirst = pTokens.get();
+      pTokens.reset();
+      
+      // tokens no longer in use are updated in place
+      code.insert(code.size() / 2, "gr\xC3\xB6\xC3\x9F" "e");
+      pTokens = cache.tokenize("a", code);
+      expect_true(pTokens.get() == pFirst);
+      expect_true(tokensEqual(*pTokens, RTokens(code, RTokens::StripWhitespace)));
+      
+      // tokens still in use are left alone
+      std::string edited = code + "\ny <- 2";
+      boost::shared_ptr<const RTokens> pEdited = cache.tokenize("a", edited);
+      expect_true(pEdited != pTokens);
+      expect_true(pTokens->code() == code);
+      expect_true(tokensEqual(*pEdited, RTokens(edited, RTokens::StripWhitespace)));
+      
+      // documents are evicted once the cache is full
+      pEdited.reset();
+      cache.tokenize("b", "b <- 1");
+      cache.tokenize("c", "c <- 1");
+      expect_true(tokensEqual(*cache.tokenize("a", edited), RTokens(edited, RTokens::StripWhitespace)));
+   }
+   
 }
 
 } // namespace r_util
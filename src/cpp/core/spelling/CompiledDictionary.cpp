@@ -0,0 +1,500 @@
+/*
+ * CompiledDictionary.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/spelling/CompiledDictionary.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+
+#include <boost/algorithm/string.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/system/System.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+namespace spelling {
+
+namespace {
+
+// the file begins with a header holding the magic, version, word count and
+// bucket count. it's followed by the buckets of an open addressed hash table
+// (each holding the index of a word plus one, or zero if it's empty), the
+// offset of each word (and of the end of the last word) within the words,
+// and then the words themselves. numbers are written in native byte order
+// (compiled dictionaries are local to a machine)
+const char kMagic[] = "RSSPDICT";
+const std::size_t kMagicSize = 8;
+const std::uint32_t kVersion = 1;
+const std::uint64_t kHeaderSize = kMagicSize + 4 + 4 + 8 + 8;
+
+// (a hash that's the same in every process, unlike std::hash)
+std::uint64_t hashWord(const char* pWord, std::size_t length)
+{
+   std::uint64_t hash = 14695981039346656037ull;
+   for (std::size_t i = 0; i < length; i++)
+   {
+      hash ^= static_cast<unsigned char>(pWord[i]);
+      hash *= 1099511628211ull;
+   }
+   return hash;
+}
+
+enum FlagType
+{
+   FlagChar,
+   FlagLong,
+   FlagNumber,
+   FlagUtf8
+};
+
+struct AffixRule
+{
+   std::string strip;
+   std::string affix;
+};
+
+struct AffixClass
+{
+   AffixClass() : prefix(false), crossProduct(false) {}
+
+   bool prefix;
+   bool crossProduct;
+   std::vector<AffixRule> rules;
+};
+
+struct Affixes
+{
+   Affixes() : flagType(FlagChar) {}
+
+   FlagType flagType;
+   std::vector<std::string> aliases;
+   std::map<std::string, AffixClass> classes;
+};
+
+bool isNumber(const std::string& value)
+{
+   return !value.empty() &&
+          std::all_of(value.begin(), value.end(), [](char ch)
+   {
+      return std::isdigit(static_cast<unsigned char>(ch));
+   });
+}
+
+std::vector<std::string> parseFlags(std::string flags, const Affixes& affixes)
+{
+   std::vector<std::string> parsed;
+
+   // flags may be given by their (1-based) index into the AF aliases
+   if (!affixes.aliases.empty() && isNumber(flags))
+   {
+      std::size_t index = std::strtoul(flags.c_str(), nullptr, 10);
+      if (index == 0 || index > affixes.aliases.size())
+         return parsed;
+      flags = affixes.aliases[index - 1];
+   }
+
+   switch (affixes.flagType)
+   {
+   case FlagLong:
+      for (std::size_t i = 0; i + 1 < flags.size(); i += 2)
+         parsed.push_back(flags.substr(i, 2));
+      break;
+
+   case FlagNumber:
+      boost::algorithm::split(parsed, flags, boost::algorithm::is_any_of(","));
+      break;
+
+   case FlagUtf8:
+      for (std::size_t i = 0; i < flags.size(); )
+      {
+         std::size_t length = 1;
+         while (i + length < flags.size() && (flags[i + length] & 0xC0) == 0x80)
+            length++;
+         parsed.push_back(flags.substr(i, length));
+         i += length;
+      }
+      break;
+
+   default:
+      for (char ch : flags)
+         parsed.push_back(std::string(1, ch));
+      break;
+   }
+
+   return parsed;
+}
+
+Error readAffixes(const FilePath& affPath, Affixes* pAffixes)
+{
+   std::vector<std::string> lines;
+   Error error = readStringVectorFromFile(affPath, &lines);
+   if (error)
+      return error;
+
+   // rules remaining for the affix class whose header was read last
+   std::string flag;
+   std::size_t remaining = 0;
+
+   for (const std::string& line : lines)
+   {
+      std::vector<std::string> fields;
+      boost::algorithm::split(fields,
+                              line,
+                              boost::algorithm::is_any_of(" \t"),
+                              boost::algorithm::token_compress_on);
+      if (fields.size() < 2)
+         continue;
+
+      const std::string& keyword = fields[0];
+      if (keyword == "FLAG")
+      {
+         if (fields[1] == "long")
+            pAffixes->flagType = FlagLong;
+         else if (fields[1] == "num")
+            pAffixes->flagType = FlagNumber;
+         else if (fields[1] == "UTF-8")
+            pAffixes->flagType = FlagUtf8;
+      }
+      else if (keyword == "AF" && !isNumber(fields[1]))
+      {
+         // (the first AF line gives the number of aliases)
+         pAffixes->aliases.push_back(fields[1]);
+      }
+      else if ((keyword == "PFX" || keyword == "SFX") && fields.size() >= 4)
+      {
+         if (remaining > 0 && fields[1] == flag)
+         {
+            // a rule: flag, stripped characters, affix (with any
+            // continuation classes), condition
+            AffixRule rule;
+            rule.strip = fields[2] == "0" ? std::string() : fields[2];
+            rule.affix = fields[3].substr(0, fields[3].find('/'));
+            if (rule.affix == "0")
+               rule.affix.clear();
+
+            pAffixes->classes[flag].rules.push_back(rule);
+            remaining--;
+         }
+         else
+         {
+            // a header: flag, cross product, number of rules
+            flag = fields[1];
+            remaining = std::strtoul(fields[3].c_str(), nullptr, 10);
+
+            AffixClass& affixClass = pAffixes->classes[flag];
+            affixClass.prefix = keyword == "PFX";
+            affixClass.crossProduct = fields[2] == "Y";
+         }
+      }
+   }
+
+   return Success();
+}
+
+void applySuffixes(const std::string& word,
+                   const AffixClass& affixClass,
+                   const boost::function<void(const std::string&)>& onWord)
+{
+   for (const AffixRule& rule : affixClass.rules)
+   {
+      if (boost::algorithm::ends_with(word, rule.strip))
+         onWord(word.substr(0, word.size() - rule.strip.size()) + rule.affix);
+   }
+}
+
+void applyPrefixes(const std::string& word,
+                   const AffixClass& affixClass,
+                   const boost::function<void(const std::string&)>& onWord)
+{
+   for (const AffixRule& rule : affixClass.rules)
+   {
+      if (boost::algorithm::starts_with(word, rule.strip))
+         onWord(rule.affix + word.substr(rule.strip.size()));
+   }
+}
+
+} // anonymous namespace
+
+Error expandDictionaryWords(const FilePath& affPath,
+                            const FilePath& dicPath,
+                            const boost::function<void(const std::string&)>& onWord)
+{
+   Affixes affixes;
+   Error error = readAffixes(affPath, &affixes);
+   if (error)
+      return error;
+
+   std::vector<std::string> lines;
+   error = readStringVectorFromFile(dicPath, &lines);
+   if (error)
+      return error;
+
+   std::vector<std::string> crossSuffixed;
+   for (std::size_t i = 1; i < lines.size(); i++)
+   {
+      // ignore any morphological description
+      std::string line = lines[i];
+      std::size_t end = line.find_first_of(" \t");
+      if (end != std::string::npos)
+         line.erase(end);
+
+      // split the word from its flags (at the first unescaped slash)
+      std::size_t slashPos = std::string::npos;
+      for (std::size_t j = 1; j < line.size(); j++)
+      {
+         if (line[j] == '/' && line[j - 1] != '\\')
+         {
+            slashPos = j;
+            break;
+         }
+      }
+
+      std::string word = boost::algorithm::replace_all_copy(
+               line.substr(0, slashPos), "\\/", "/");
+      if (word.empty())
+         continue;
+
+      onWord(word);
+      if (slashPos == std::string::npos)
+         continue;
+
+      std::vector<std::string> flags = parseFlags(line.substr(slashPos + 1), affixes);
+
+      // suffixes first, keeping those which combine with prefixes
+      crossSuffixed.clear();
+      for (const std::string& flag : flags)
+      {
+         auto it = affixes.classes.find(flag);
+         if (it == affixes.classes.end() || it->second.prefix)
+            continue;
+
+         applySuffixes(word, it->second, onWord);
+         if (it->second.crossProduct)
+         {
+            applySuffixes(word, it->second, [&](const std::string& suffixed)
+            {
+               crossSuffixed.push_back(suffixed);
+            });
+         }
+      }
+
+      for (const std::string& flag : flags)
+      {
+         auto it = affixes.classes.find(flag);
+         if (it == affixes.classes.end() || !it->second.prefix)
+            continue;
+
+         applyPrefixes(word, it->second, onWord);
+         if (it->second.crossProduct)
+         {
+            for (const std::string& suffixed : crossSuffixed)
+               applyPrefixes(suffixed, it->second, onWord);
+         }
+      }
+   }
+
+   return Success();
+}
+
+Error CompiledDictionary::write(const FilePath& path, std::vector<std::string> words)
+{
+   std::sort(words.begin(), words.end());
+   words.erase(std::unique(words.begin(), words.end()), words.end());
+
+   // size the table so that it's at most three quarters full
+   std::uint64_t count = words.size();
+   std::uint64_t bucketCount = 16;
+   while (bucketCount * 3 < count * 4)
+      bucketCount *= 2;
+
+   std::vector<std::uint32_t> buckets(bucketCount, 0);
+   std::vector<std::uint64_t> offsets;
+   offsets.reserve(words.size() + 1);
+   std::uint64_t offset = 0;
+   for (std::size_t i = 0; i < words.size(); i++)
+   {
+      const std::string& word = words[i];
+      std::uint64_t bucket = hashWord(word.data(), word.size()) & (bucketCount - 1);
+      while (buckets[bucket] != 0)
+         bucket = (bucket + 1) & (bucketCount - 1);
+      buckets[bucket] = static_cast<std::uint32_t>(i + 1);
+
+      offsets.push_back(offset);
+      offset += word.size();
+   }
+   offsets.push_back(offset);
+
+   std::string header;
+   header.append(kMagic, kMagicSize);
+   std::uint32_t version = kVersion;
+   std::uint32_t reserved = 0;
+   header.append(reinterpret_cast<const char*>(&version), sizeof(version));
+   header.append(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+   header.append(reinterpret_cast<const char*>(&count), sizeof(count));
+   header.append(reinterpret_cast<const char*>(&bucketCount), sizeof(bucketCount));
+
+   // write alongside the dictionary and then move it into place (several
+   // processes may compile the same dictionary at once, so each writes to
+   // its own file)
+   FilePath tempPath = path.getParent().completeChildPath(
+            path.getFilename() + "." + core::system::generateShortenedUuid() + ".tmp");
+   {
+      std::shared_ptr<std::ostream> pStream;
+      Error error = tempPath.openForWrite(pStream);
+      if (error)
+         return error;
+
+      pStream->write(header.data(), header.size());
+      pStream->write(reinterpret_cast<const char*>(buckets.data()),
+                     buckets.size() * sizeof(std::uint32_t));
+      pStream->write(reinterpret_cast<const char*>(offsets.data()),
+                     offsets.size() * sizeof(std::uint64_t));
+      for (const std::string& word : words)
+         pStream->write(word.data(), word.size());
+      pStream->flush();
+      if (!pStream->good())
+      {
+         pStream.reset();
+         tempPath.removeIfExists();
+         return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+      }
+   }
+
+   return tempPath.move(path, FilePath::MoveCrossDevice, true);
+}
+
+CompiledDictionary::CompiledDictionary()
+   : pBuckets_(nullptr),
+     pOffsets_(nullptr),
+     pWords_(nullptr),
+     count_(0),
+     bucketCount_(0)
+{
+}
+
+Error CompiledDictionary::open(const FilePath& path)
+{
+   close();
+
+   try
+   {
+      file_.open(path.getAbsolutePath());
+   }
+   catch (const std::exception& e)
+   {
+      Error error = systemError(boost::system::errc::io_error, e.what(), ERROR_LOCATION);
+      error.addProperty("path", path);
+      return error;
+   }
+
+   const char* pData = file_.data();
+   std::uint64_t size = file_.size();
+
+   std::uint32_t version = 0;
+   std::uint64_t count = 0;
+   std::uint64_t bucketCount = 0;
+   if (size >= kHeaderSize)
+   {
+      std::memcpy(&version, pData + kMagicSize, sizeof(version));
+      std::memcpy(&count, pData + kMagicSize + 8, sizeof(count));
+      std::memcpy(&bucketCount, pData + kMagicSize + 16, sizeof(bucketCount));
+   }
+
+   // (the bucket count is a power of two, and there must be an empty bucket)
+   std::uint64_t offsetsOffset = kHeaderSize + bucketCount * sizeof(std::uint32_t);
+   std::uint64_t wordsOffset = offsetsOffset + (count + 1) * sizeof(std::uint64_t);
+   if (size < kHeaderSize ||
+       std::memcmp(pData, kMagic, kMagicSize) != 0 ||
+       version != kVersion ||
+       bucketCount == 0 ||
+       (bucketCount & (bucketCount - 1)) != 0 ||
+       count >= bucketCount ||
+       bucketCount > size ||
+       wordsOffset > size ||
+       wordsOffset + reinterpret_cast<const std::uint64_t*>(pData + offsetsOffset)[count] != size)
+   {
+      file_.close();
+      Error error = systemError(boost::system::errc::io_error,
+                                "Invalid compiled dictionary",
+                                ERROR_LOCATION);
+      error.addProperty("path", path);
+      return error;
+   }
+
+   pBuckets_ = reinterpret_cast<const std::uint32_t*>(pData + kHeaderSize);
+   pOffsets_ = reinterpret_cast<const std::uint64_t*>(pData + offsetsOffset);
+   pWords_ = pData + wordsOffset;
+   count_ = count;
+   bucketCount_ = bucketCount;
+   return Success();
+}
+
+void CompiledDictionary::close()
+{
+   if (file_.is_open())
+      file_.close();
+   pBuckets_ = nullptr;
+   pOffsets_ = nullptr;
+   pWords_ = nullptr;
+   count_ = 0;
+   bucketCount_ = 0;
+}
+
+bool CompiledDictionary::contains(const std::string& word) const
+{
+   if (!isOpen())
+      return false;
+
+   std::uint64_t mask = bucketCount_ - 1;
+   std::uint64_t bucket = hashWord(word.data(), word.size()) & mask;
+   for (std::uint64_t probes = 0; probes < bucketCount_; probes++)
+   {
+      std::uint32_t entry = pBuckets_[bucket];
+      if (entry == 0)
+         return false;
+
+      if (matches(entry - 1, word))
+         return true;
+
+      bucket = (bucket + 1) & mask;
+   }
+
+   return false;
+}
+
+bool CompiledDictionary::matches(std::uint64_t index, const std::string& word) const
+{
+   // (a corrupt table matches nothing)
+   if (index >= count_)
+      return false;
+
+   std::uint64_t begin = pOffsets_[index];
+   std::uint64_t end = pOffsets_[index + 1];
+   if (end < begin || end > pOffsets_[count_])
+      return false;
+
+   return end - begin == word.size() &&
+          std::memcmp(pWords_ + begin, word.data(), word.size()) == 0;
+}
+
+} // namespace spelling
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,252 @@
+/*
+ * CompiledDictionaryBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/spelling/CompiledDictionary.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <iconv.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <malloc.h>
+#endif
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/spelling/HunspellSpellingEngine.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#if defined(near)
+#undef near
+#endif
+#include "hunspell/hunspell.hxx"
+
+#include "CompiledDictionaryTestDictionary.hpp"
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace spelling {
+namespace tests {
+
+using namespace boost::posix_time;
+
+namespace {
+
+#ifndef _WIN32
+// a conversion like that of r::util::iconvstr (which opens a converter for
+// each conversion)
+Error convert(const std::string& value,
+              const std::string& from,
+              const std::string& to,
+              bool,
+              std::string* pResult)
+{
+   iconv_t converter = ::iconv_open(to.c_str(), from.c_str());
+   if (converter == reinterpret_cast<iconv_t>(-1))
+      return systemError(errno, ERROR_LOCATION);
+
+   std::vector<char> output(value.size() * 4 + 4);
+   char* pIn = const_cast<char*>(value.data());
+   std::size_t inLeft = value.size();
+   char* pOut = output.data();
+   std::size_t outLeft = output.size();
+   std::size_t result = ::iconv(converter, &pIn, &inLeft, &pOut, &outLeft);
+   ::iconv_close(converter);
+   if (result == static_cast<std::size_t>(-1))
+      return systemError(errno, ERROR_LOCATION);
+
+   pResult->assign(output.data(), output.size() - outLeft);
+   return Success();
+}
+#else
+Error convert(const std::string& value,
+              const std::string& from,
+              const std::string& to,
+              bool allowSubstitution,
+              std::string* pResult)
+{
+   return identity(value, from, to, allowSubstitution, pResult);
+}
+#endif
+
+// a pseudo-random (but repeatable) word
+std::string makeWord(unsigned int seed)
+{
+   static const char* const kSyllables[] = {
+      "ba", "co", "di", "fe", "ga", "ho", "ju", "ka", "lo", "me",
+      "ni", "po", "qua", "ri", "sa", "te", "vo", "wi", "xa", "zu"
+   };
+
+   std::string word;
+   unsigned int value = seed * 2654435761u;
+   for (int i = 0; i < 3 + static_cast<int>(seed % 3); i++)
+   {
+      word += kSyllables[value % 20];
+      value = value / 20 + seed;
+   }
+   return word;
+}
+
+// resident memory which isn't shared with other processes (so not counting
+// the pages of a compiled dictionary)
+#ifdef __linux__
+double privateMegabytes()
+{
+   // (return freed memory first, so that it isn't reused unmeasured)
+   ::malloc_trim(0);
+
+   std::ifstream statm("/proc/self/statm");
+   long size = 0, resident = 0, shared = 0;
+   statm >> size >> resident >> shared;
+   return (resident - shared) * (::sysconf(_SC_PAGESIZE) / 1024.0 / 1024.0);
+}
+#else
+double privateMegabytes()
+{
+   return 0;
+}
+#endif
+
+double elapsedMs(const ptime& start)
+{
+   return (microsec_clock::universal_time() - start).total_microseconds() / 1000.0;
+}
+
+} // anonymous namespace
+
+// a dictionary of 40,000 words, checked one word at a time (as before) and
+// in batches against the compiled dictionary
+TEST_CASE("Compiled dictionary throughput")
+{
+   const unsigned int kStems = 40000;
+   const unsigned int kWords = 200000;
+
+   FilePath dir;
+   FilePath::tempFilePath(dir);
+
+   std::vector<std::string> entries;
+   for (unsigned int i = 0; i < kStems; i++)
+      entries.push_back(makeWord(i) + "/SDG");
+   FilePath affPath = writeDictionary(dir, "xx_XX", entries);
+   FilePath dicPath = dir.completeChildPath("xx_XX.dic");
+
+   // text is mostly dictionary words (and their forms), with some typos
+   const char* const kEndings[] = { "", "s", "ed", "ing", "", "" };
+   std::vector<std::string> words;
+   for (unsigned int i = 0; i < kWords; i++)
+   {
+      unsigned int stem = (i * 7919u) % (i % 4 == 0 ? kStems : 2000);
+      std::string word = makeWord(stem) + kEndings[i % 6];
+      if (i % 10 == 0)
+         word += "q";
+      words.push_back(word);
+   }
+
+   // the per-word path: hunspell, with a conversion per word
+   double privateBefore = privateMegabytes();
+   Hunspell hunspell(affPath.getAbsolutePath().c_str(), dicPath.getAbsolutePath().c_str());
+   double hunspellMb = privateMegabytes() - privateBefore;
+
+   ptime start = microsec_clock::universal_time();
+   std::vector<bool> expected;
+   for (const std::string& word : words)
+   {
+      std::string encoded;
+      convert(word, "UTF-8", "UTF-8", false, &encoded);
+      expected.push_back(hunspell.spell(encoded.c_str()) != 0);
+   }
+   double perWordMs = elapsedMs(start);
+
+   // the first session to use the dictionary compiles it in the background,
+   // checking words with hunspell in the meantime
+   FilePath compiledDir = dir.completeChildPath("compiled");
+   HunspellDictionaryManager manager(dir, dir.completeChildPath("user"));
+   double firstVerdictMs = 0;
+   double compileMs = 0;
+   start = microsec_clock::universal_time();
+   {
+      HunspellSpellingEngine engine("xx_XX", manager, convert, compiledDir);
+      bool isCorrect;
+      engine.checkSpelling(words[1], &isCorrect);
+      CHECK(isCorrect == expected[1]);
+      firstVerdictMs = elapsedMs(start);
+
+      REQUIRE(waitForCompiledDictionary(compiledDir));
+      compileMs = elapsedMs(start);
+   }
+
+   // later sessions check in batches against the compiled dictionary
+   // (hunspell itself isn't loaded until a word that isn't in the compiled
+   // dictionary is seen)
+   privateBefore = privateMegabytes();
+   HunspellSpellingEngine engine("xx_XX", manager, convert, compiledDir);
+   std::vector<std::string> correctWords;
+   for (std::size_t i = 0; i < words.size() && correctWords.size() < 1000; i++)
+   {
+      if (expected[i])
+         correctWords.push_back(words[i]);
+   }
+   std::vector<bool> verdicts;
+   engine.checkSpelling(correctWords, &verdicts);
+   CHECK(std::count(verdicts.begin(), verdicts.end(), true) == 1000);
+   double compiledOnlyMb = privateMegabytes() - privateBefore;
+
+   start = microsec_clock::universal_time();
+   std::vector<bool> actual;
+   const std::size_t kBatchSize = 100;
+   for (std::size_t i = 0; i < words.size(); i += kBatchSize)
+   {
+      std::vector<std::string> batch(words.begin() + i,
+                                     words.begin() + std::min(words.size(), i + kBatchSize));
+      std::vector<bool> verdicts;
+      engine.checkSpelling(batch, &verdicts);
+      actual.insert(actual.end(), verdicts.begin(), verdicts.end());
+   }
+   double batchedMs = elapsedMs(start);
+   double engineMb = privateMegabytes() - privateBefore;
+
+   CHECK(actual == expected);
+
+   std::size_t compiledBytes = 0;
+   std::vector<FilePath> compiled;
+   compiledDir.getChildren(compiled);
+   for (const FilePath& path : compiled)
+      compiledBytes += path.getSize();
+
+   std::cout << "spell check " << kWords << " words: per word " << perWordMs
+             << "ms, batched " << batchedMs << "ms (first verdict after " << firstVerdictMs
+             << "ms, compiled in the background in " << compileMs << "ms)" << std::endl
+             << "private memory: hunspell " << hunspellMb << "MB; engine "
+             << compiledOnlyMb << "MB checking dictionary words, "
+             << engineMb << "MB checking misspellings too; compiled dictionary "
+             << compiledBytes / 1024.0 / 1024.0 << "MB (shared)" << std::endl;
+
+   dir.remove();
+}
+
+} // namespace tests
+} // namespace spelling
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,116 @@
+/*
+ * CompiledDictionaryTestDictionary.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// dictionaries shared by the compiled dictionary tests and benchmarks
+
+#ifndef CORE_SPELLING_COMPILED_DICTIONARY_TEST_DICTIONARY_HPP
+#define CORE_SPELLING_COMPILED_DICTIONARY_TEST_DICTIONARY_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <core/FileSerializer.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+namespace spelling {
+namespace tests {
+
+const char* const kAffixes =
+      "SET UTF-8\n"
+      "TRY esianrtolcdugmphbyfvkwz\n"
+      "\n"
+      "PFX U Y 1\n"
+      "PFX U   0     un         .\n"
+      "\n"
+      "SFX S Y 4\n"
+      "SFX S   y     ies        [^aeiou]y\n"
+      "SFX S   0     s          [aeiou]y\n"
+      "SFX S   0     es         [sxzh]\n"
+      "SFX S   0     s          [^sxzhy]\n"
+      "\n"
+      "SFX D Y 2\n"
+      "SFX D   0     d          e\n"
+      "SFX D   0     ed         [^e]\n"
+      "\n"
+      "SFX G Y 2\n"
+      "SFX G   e     ing        e\n"
+      "SFX G   0     ing        [^e]\n";
+
+inline Error identity(const std::string& value,
+                      const std::string&,
+                      const std::string&,
+                      bool,
+                      std::string* pResult)
+{
+   *pResult = value;
+   return Success();
+}
+
+inline FilePath writeDictionary(const FilePath& dir,
+                                const std::string& id,
+                                const std::vector<std::string>& entries)
+{
+   dir.ensureDirectory();
+   writeStringToFile(dir.completeChildPath(id + ".aff"), kAffixes);
+
+   std::string dic = std::to_string(entries.size()) + "\n";
+   for (const std::string& entry : entries)
+      dic += entry + "\n";
+   writeStringToFile(dir.completeChildPath(id + ".dic"), dic);
+
+   return dir.completeChildPath(id + ".aff");
+}
+
+inline std::vector<std::string> children(const FilePath& dir)
+{
+   std::vector<FilePath> paths;
+   dir.getChildren(paths);
+
+   std::vector<std::string> names;
+   for (const FilePath& path : paths)
+      names.push_back(path.getFilename());
+   std::sort(names.begin(), names.end());
+   return names;
+}
+
+// wait for a dictionary compiled in the background
+inline bool waitForCompiledDictionary(const FilePath& dir)
+{
+   for (int i = 0; i < 1000; i++)
+   {
+      for (const std::string& name : children(dir))
+      {
+         if (boost::algorithm::ends_with(name, ".dict"))
+            return true;
+      }
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+   }
+   return false;
+}
+
+} // namespace tests
+} // namespace spelling
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_SPELLING_COMPILED_DICTIONARY_TEST_DICTIONARY_HPP
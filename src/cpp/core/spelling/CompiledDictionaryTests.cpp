@@ -0,0 +1,151 @@
+/*
+ * CompiledDictionaryTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/spelling/CompiledDictionary.hpp>
+
+#include <algorithm>
+#include <set>
+
+#include <core/FileSerializer.hpp>
+#include <core/spelling/HunspellSpellingEngine.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#include "CompiledDictionaryTestDictionary.hpp"
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace spelling {
+namespace tests {
+
+namespace {
+
+std::set<std::string> expand(const FilePath& affPath)
+{
+   std::set<std::string> words;
+   FilePath dicPath = affPath.getParent().completeChildPath(affPath.getStem() + ".dic");
+   Error error = expandDictionaryWords(affPath, dicPath, [&](const std::string& word)
+   {
+      words.insert(word);
+   });
+   REQUIRE_FALSE(error);
+   return words;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Compiled dictionaries")
+{
+   FilePath dir;
+   FilePath::tempFilePath(dir);
+   FilePath affPath = writeDictionary(dir, "xx_XX", {
+      "walk/SDGU", "bake/SDG", "city/S", "box/S", "Paris", "do/U"
+   });
+
+   SECTION("Dictionary words are expanded with their affixes")
+   {
+      std::set<std::string> words = expand(affPath);
+      for (const char* word : { "walk", "walks", "walked", "walking", "unwalk",
+                                "unwalks", "bake", "baked", "baking", "cities",
+                                "boxes", "Paris", "undo" })
+      {
+         INFO(word);
+         CHECK(words.count(word) == 1);
+      }
+
+      CHECK(words.count("unbox") == 0);
+      CHECK(words.count("do") == 1);
+   }
+
+   SECTION("Words are looked up in a compiled dictionary")
+   {
+      FilePath path = dir.completeChildPath("words.dict");
+      REQUIRE_FALSE(CompiledDictionary::write(path, { "pear", "apple", "fig", "apple", "\xc3\xa9t\xc3\xa9" }));
+
+      CompiledDictionary dictionary;
+      REQUIRE_FALSE(dictionary.open(path));
+      CHECK(dictionary.size() == 4);
+      CHECK(dictionary.contains("apple"));
+      CHECK(dictionary.contains("fig"));
+      CHECK(dictionary.contains("pear"));
+      CHECK(dictionary.contains("\xc3\xa9t\xc3\xa9"));
+      CHECK_FALSE(dictionary.contains("app"));
+      CHECK_FALSE(dictionary.contains("apples"));
+      CHECK_FALSE(dictionary.contains(""));
+      CHECK_FALSE(dictionary.contains("zebra"));
+
+      // no temporary files are left behind
+      CHECK(children(dir) == std::vector<std::string>({ "words.dict", "xx_XX.aff", "xx_XX.dic" }));
+
+      dictionary.close();
+      REQUIRE_FALSE(writeStringToFile(path, "RSSPDICT but not really"));
+      CHECK(dictionary.open(path));
+      CHECK_FALSE(dictionary.isOpen());
+      CHECK_FALSE(dictionary.contains("apple"));
+   }
+
+   SECTION("Verdicts match hunspell's with a compiled dictionary")
+   {
+      FilePath compiledDir = dir.completeChildPath("compiled");
+      HunspellDictionaryManager manager(dir, dir.completeChildPath("user"));
+      HunspellSpellingEngine plain("xx_XX", manager, identity);
+      HunspellSpellingEngine compiled("xx_XX", manager, identity, compiledDir);
+
+      std::vector<std::string> words = {
+         "walk", "walks", "Walks", "unwalked", "walkz", "citys", "cities",
+         "Cities", "paris", "Paris", "PARIS", "unbox", "baking", "bakeing",
+         "undo", "Undo", "do", "walks", "walk", ""
+      };
+
+      std::vector<bool> expected;
+      for (const std::string& word : words)
+      {
+         bool isCorrect = false;
+         REQUIRE_FALSE(plain.checkSpelling(word, &isCorrect));
+         expected.push_back(isCorrect);
+      }
+
+      // (words are checked with hunspell while the dictionary is compiled
+      // in the background, and with the compiled dictionary once it's ready)
+      std::vector<bool> actual;
+      compiled.checkSpelling(words, &actual);
+      CHECK(actual == expected);
+      REQUIRE(waitForCompiledDictionary(compiledDir));
+      CHECK(children(compiledDir).size() == 1);
+      compiled.checkSpelling(words, &actual);
+      CHECK(actual == expected);
+
+      // (a later engine uses the dictionary already compiled)
+      HunspellSpellingEngine reused("xx_XX", manager, identity, compiledDir);
+      reused.checkSpelling(words, &actual);
+      CHECK(actual == expected);
+      CHECK(children(compiledDir).size() == 1);
+
+      std::vector<std::string> suggestions;
+      REQUIRE_FALSE(reused.suggestionList("walkz", &suggestions));
+      CHECK(std::find(suggestions.begin(), suggestions.end(), "walks") != suggestions.end());
+   }
+
+   dir.remove();
+}
+
+} // namespace tests
+} // namespace spelling
+} // namespace core
+} // namespace rstudio
@@ -15,16 +15,24 @@
 
 #include <core/spelling/HunspellSpellingEngine.hpp>
 
+#include <atomic>
+
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 
+#include <core/Hash.hpp>
 #include <core/Log.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/StringUtils.hpp>
+#include <core/Thread.hpp>
+#include <core/collection/LruCache.hpp>
 
+#include <core/spelling/CompiledDictionary.hpp>
 #include <core/spelling/HunspellDictionaryManager.hpp>
 
 #include <shared_core/Error.hpp>
 #include <shared_core/FilePath.hpp>
+#include <shared_core/SafeConvert.hpp>
 
 // Including the hunspell headers caused compilation errors for Windows 64-bit
 // builds. The trouble seemd to be a 'near' macro defined somewhere in the
@@ -108,6 +116,36 @@ std::string exampleWordForEnglishAffix(const std::string& affix)
       return std::string();
 }
 
+FilePath dicDeltaPathFor(const HunspellDictionary& dictionary)
+{
+   FilePath dicPath = dictionary.dicPath();
+   return dicPath.getParent().completeChildPath(dicPath.getStem() + ".dic_delta");
+}
+
+// compiled dictionaries are named for the files they're compiled from (and
+// their sizes and modification times), so a changed dictionary is compiled
+// afresh
+FilePath compiledDictionaryPath(const FilePath& compiledDictionariesPath,
+                                const HunspellDictionary& dictionary)
+{
+   std::string key;
+   FilePath files[] = { dictionary.affPath(),
+                        dictionary.dicPath(),
+                        dicDeltaPathFor(dictionary) };
+   for (const FilePath& file : files)
+   {
+      key += file.getAbsolutePath() + "\n";
+      if (file.exists())
+      {
+         key += safe_convert::numberToString(file.getSize()) + ":" +
+                safe_convert::numberToString(file.getLastWriteTime()) + "\n";
+      }
+   }
+
+   return compiledDictionariesPath.completeChildPath(
+            dictionary.id() + "-" + hash::crc32HexHash(key) + ".dict");
+}
+
 class SpellChecker : boost::noncopyable
 {
 public:
@@ -139,10 +177,14 @@ public:
    }
 };
 
+// number of recent verdicts remembered
+const std::size_t kVerdictCacheSize = 16384;
+
 class HunspellSpellChecker : public SpellChecker
 {
 public:
    HunspellSpellChecker()
+      : verdicts_(kVerdictCacheSize)
    {
    }
 
@@ -158,7 +200,8 @@ public:
    }
 
    Error initialize(const HunspellDictionary& dictionary,
-                    const IconvstrFunction& iconvstrFunc)
+                    const IconvstrFunction& iconvstrFunc,
+                    const FilePath& compiledDictionariesPath)
    {
       // validate that dictionaries exist
       if (!dictionary.affPath().exists())
@@ -166,22 +209,111 @@ public:
       if (!dictionary.dicPath().exists())
          return core::fileNotFoundError(dictionary.dicPath(), ERROR_LOCATION);
 
+      dictionary_ = dictionary;
+      iconvstrFunc_ = iconvstrFunc;
+
+      if (compiledDictionariesPath.isEmpty())
+         return loadHunspell();
+
+      // use the compiled dictionary if it's available, in which case
+      // hunspell itself is only loaded when it's needed (for words that
+      // aren't in the compiled dictionary, and for suggestions)
+      FilePath compiledPath = compiledDictionaryPath(compiledDictionariesPath,
+                                                     dictionary);
+      if (compiledPath.exists())
+      {
+         Error error = compiled_.open(compiledPath);
+         if (!error)
+            return Success();
+         LOG_ERROR(error);
+      }
+
+      Error error = loadHunspell();
+      if (error)
+         return error;
+
+      // compile the dictionary in the background (checking words with
+      // hunspell until it's ready)
+      compiledPath_ = compiledPath;
+      pCompiled_.reset(new std::atomic<bool>(false));
+      core::thread::safeLaunchThread(boost::bind(compileDictionary,
+                                                 dictionary,
+                                                 iconvstrFunc,
+                                                 compiledPath,
+                                                 pCompiled_));
+
+      return Success();
+   }
+
+   Error wordChars(std::wstring *pWordChars)
+   {
+      Error error = ensureHunspell();
+      if (error)
+         return error;
+
+      int len;
+      unsigned short *pChars = pHunspell_->get_wordchars_utf16(&len);
+
+      for (int i = 0; i < len; i++)
+         pWordChars->push_back(pChars[i]);
+
+      return Success();
+   }
+
+private:
+
+   // compile a dictionary with a hunspell instance of its own (so that
+   // custom dictionaries aren't included, as the compiled dictionary is
+   // shared); runs on a background thread, so iconvstrFunc mustn't rely on
+   // being called from the main thread
+   static void compileDictionary(const HunspellDictionary& dictionary,
+                                 const IconvstrFunction& iconvstrFunc,
+                                 const FilePath& compiledPath,
+                                 boost::shared_ptr<std::atomic<bool> > pCompiled)
+   {
+      HunspellSpellChecker checker;
+      Error error = checker.initialize(dictionary, iconvstrFunc, FilePath());
+      if (!error)
+         error = compiledPath.getParent().ensureDirectory();
+      if (!error)
+         error = checker.compile(compiledPath);
+      if (error)
+         LOG_ERROR(error);
+
+      *pCompiled = true;
+   }
+
+   // start using the compiled dictionary once it's been compiled
+   void openCompiledDictionary()
+   {
+      if (!pCompiled_ || !*pCompiled_)
+         return;
+
+      pCompiled_.reset();
+      if (compiledPath_.exists())
+      {
+         Error error = compiled_.open(compiledPath_);
+         if (error)
+            LOG_ERROR(error);
+      }
+   }
+
+   // helpers
+   Error loadHunspell()
+   {
       // convert paths to system encoding before sending to external API
       std::string systemAffPath = string_utils::utf8ToSystem(
-         dictionary.affPath().getAbsolutePath());
+         dictionary_.affPath().getAbsolutePath());
       std::string systemDicPath = string_utils::utf8ToSystem(
-         dictionary.dicPath().getAbsolutePath());
+         dictionary_.dicPath().getAbsolutePath());
 
-      // initialize hunspell, iconvstrFunc_, and encoding_
+      // initialize hunspell and encoding_
       pHunspell_.reset(new Hunspell(systemAffPath.c_str(),
                                     systemDicPath.c_str()));
-      iconvstrFunc_ = iconvstrFunc;
       encoding_ = pHunspell_->get_dic_encoding();
 
       // add words from dic_delta if available
-      FilePath dicPath = dictionary.dicPath();
-      FilePath dicDeltaPath = dicPath.getParent().completeChildPath(
-         dicPath.getStem() + ".dic_delta");
+      FilePath dicDeltaPath = dicDeltaPathFor(dictionary_);
       if (dicDeltaPath.exists())
       {
          Error error = mergeDicDeltaFile(dicDeltaPath);
@@ -189,24 +321,92 @@ public:
             LOG_ERROR(error);
       }
 
-      // return success
+      // add custom dictionaries
+      for (const std::pair<FilePath, std::string>& custom : customDictionaries_)
+      {
+         std::string systemDicPath = string_utils::utf8ToSystem(
+                  custom.first.getAbsolutePath());
+         pHunspell_->add_dic(systemDicPath.c_str(), custom.second.c_str());
+      }
+
       return Success();
    }
 
-   Error wordChars(std::wstring *pWordChars)
+   Error ensureHunspell()
    {
-      int len;
-      unsigned short *pChars = pHunspell_->get_wordchars_utf16(&len);
+      if (pHunspell_)
+         return Success();
 
-      for (int i = 0; i < len; i++)
-         pWordChars->push_back(pChars[i]);
+      return loadHunspell();
+   }
 
-      return Success();
+   Error toUtf8(const std::string& encoded, std::string* pUtf8)
+   {
+      if (encoding_ == "UTF-8")
+      {
+         *pUtf8 = encoded;
+         return Success();
+      }
+
+      return iconvstrFunc_(encoded, encoding_, "UTF-8", false, pUtf8);
    }
 
-private:
+   // compile the words hunspell deems correct (along with their capitalized
+   // forms, as words often begin sentences)
+   Error compile(const FilePath& compiledPath)
+   {
+      std::vector<std::string> words;
+      std::string utf8;
+      auto addIfCorrect = [&](std::string encoded)
+      {
+         if (encoded.empty() ||
+             !pHunspell_->spell(encoded.c_str()) ||
+             toUtf8(encoded, &utf8))
+         {
+            return;
+         }
+         words.push_back(utf8);
+
+         // (only ASCII letters are capitalized, as dictionaries' encodings
+         // all extend ASCII)
+         unsigned char first = encoded[0];
+         if (first < 0x80 && std::islower(first))
+         {
+            encoded[0] = static_cast<char>(std::toupper(first));
+            utf8[0] = encoded[0];
+            if (pHunspell_->spell(encoded.c_str()))
+               words.push_back(utf8);
+         }
+      };
+
+      Error error = expandDictionaryWords(dictionary_.affPath(),
+                                          dictionary_.dicPath(),
+                                          addIfCorrect);
+      if (error)
+         return error;
+
+      FilePath dicDeltaPath = dicDeltaPathFor(dictionary_);
+      if (dicDeltaPath.exists())
+      {
+         std::vector<std::string> lines;
+         error = readStringVectorFromFile(dicDeltaPath, &lines);
+         if (error)
+            return error;
+
+         std::string word, affix, encoded;
+         for (const std::string& line : lines)
+         {
+            if (parseDicDeltaLine(line, &word, &affix) &&
+                !iconvstrFunc_(word, "UTF-8", encoding_, false, &encoded))
+            {
+               addIfCorrect(encoded);
+            }
+         }
+      }
+
+      return CompiledDictionary::write(compiledPath, words);
+   }
 
-   // helpers
    void copyAndFreeHunspellVector(std::vector<std::string>* pVec,
                                     char **wlst,
                                     int len)
@@ -271,19 +471,40 @@ private:
 public:
    Error checkSpelling(const std::string& word, bool *pCorrect)
    {
+      openCompiledDictionary();
+      if (compiled_.contains(word))
+      {
+         *pCorrect = true;
+         return Success();
+      }
+
+      // remember hunspell's recent verdicts (on words which aren't in the
+      // compiled dictionary, such as misspellings)
+      if (verdicts_.get(word, pCorrect))
+         return Success();
+
+      Error error = ensureHunspell();
+      if (error)
+         return error;
+
       std::string encoded;
-      Error error = iconvstrFunc_(word,"UTF-8",encoding_,false,&encoded);
+      error = iconvstrFunc_(word,"UTF-8",encoding_,false,&encoded);
       if (error)
          return error;
 
       *pCorrect = pHunspell_->spell(encoded.c_str());
+      verdicts_.insert(word, *pCorrect);
       return Success();
    }
 
    Error suggestionList(const std::string& word, std::vector<std::string>* pSug)
    {
+      Error error = ensureHunspell();
+      if (error)
+         return error;
+
       std::string encoded;
-      Error error = iconvstrFunc_(word,"UTF-8",encoding_,false,&encoded);
+      error = iconvstrFunc_(word,"UTF-8",encoding_,false,&encoded);
       if (error)
          return error;
 
@@ -359,6 +580,14 @@ public:
       if (!dicPath.exists())
          return core::fileNotFoundError(dicPath, ERROR_LOCATION);
 
+      // (added to hunspell when it's loaded, if it hasn't been yet)
+      customDictionaries_.push_back(std::make_pair(dicPath, key));
+      if (!pHunspell_)
+      {
+         *pAdded = true;
+         return Success();
+      }
+
       // Convert path to system encoding before sending to external api
       std::string systemDicPath = string_utils::utf8ToSystem(dicPath.getAbsolutePath());
       *pAdded = (pHunspell_->add_dic(systemDicPath.c_str(),key.c_str()) == 0);
@@ -366,6 +595,12 @@ public:
    }
 
 private:
+   HunspellDictionary dictionary_;
+   std::vector<std::pair<FilePath, std::string> > customDictionaries_;
+   CompiledDictionary compiled_;
+   FilePath compiledPath_;
+   boost::shared_ptr<std::atomic<bool> > pCompiled_;
+   collection::LruCache<std::string, bool> verdicts_;
    boost::scoped_ptr<Hunspell> pHunspell_;
    IconvstrFunction iconvstrFunc_;
    std::string encoding_;
@@ -377,10 +612,12 @@ struct HunspellSpellingEngine::Impl
 {
    Impl(const std::string& langId,
         const HunspellDictionaryManager& dictionaryManager,
-        const IconvstrFunction& iconvstrFunction)
+        const IconvstrFunction& iconvstrFunction,
+        const FilePath& compiledDictionariesPath)
       : currentLangId_(langId),
         dictManager_(dictionaryManager),
-        iconvstrFunction_(iconvstrFunction)
+        iconvstrFunction_(iconvstrFunction),
+        compiledDictionariesPath_(compiledDictionariesPath)
    {
    }
 
@@ -413,7 +650,9 @@ private:
          HunspellSpellChecker* pHunspell = new HunspellSpellChecker();
          pSpellChecker_.reset(pHunspell);
 
-         Error error = pHunspell->initialize(dict, iconvstrFunction_);
+         Error error = pHunspell->initialize(dict,
+                                             iconvstrFunction_,
+                                             compiledDictionariesPath_);
          if (!error)
          {
             currentLangId_ = langId;
@@ -449,6 +688,7 @@ private:
    std::vector<std::string> currentCustomDicts_;
    HunspellDictionaryManager dictManager_;
    IconvstrFunction iconvstrFunction_;
+   FilePath compiledDictionariesPath_;
    boost::shared_ptr<SpellChecker> pSpellChecker_;
 };
 
@@ -456,11 +696,18 @@ private:
 HunspellSpellingEngine::HunspellSpellingEngine(
                            const std::string& langId,
                            const HunspellDictionaryManager& dictionaryManager,
-                           const IconvstrFunction& iconvstrFunction)
-   : pImpl_(new Impl(langId, dictionaryManager, iconvstrFunction))
+                           const IconvstrFunction& iconvstrFunction,
+                           const FilePath& compiledDictionariesPath)
+   : pImpl_(new Impl(langId,
+                     dictionaryManager,
+                     iconvstrFunction,
+                     compiledDictionariesPath))
 {
 }
 
+HunspellSpellingEngine::~HunspellSpellingEngine()
+{
+}
 
 void HunspellSpellingEngine::useDictionary(const std::string& langId)
 {
@@ -473,6 +720,29 @@ Error HunspellSpellingEngine::checkSpelling(const std::string& word,
    return pImpl_->spellChecker().checkSpelling(word, pCorrect);
 }
 
+void HunspellSpellingEngine::checkSpelling(const std::vector<std::string>& words,
+                                           std::vector<bool>* pCorrect)
+{
+   pCorrect->assign(words.size(), true);
+   for (std::size_t i = 0; i < words.size(); i++)
+   {
+      bool isCorrect = true;
+      Error error = pImpl_->spellChecker().checkSpelling(words[i], &isCorrect);
+      if (error)
+      {
+         // if we can't check a word, ignore it; some combinations of platform,
+         // non-ASCII characters, and locale are known to fail in iconv, and we
+         // don't want to put those failures in front of the user (we just
+         // won't be able to spell check those words)
+         LOG_ERROR(error);
+      }
+      else
+      {
+         (*pCorrect)[i] = isCorrect;
+      }
+   }
+}
+
 Error HunspellSpellingEngine::suggestionList(const std::string& word,
                                              std::vector<std::string>* pSugs)
 {
@@ -0,0 +1,104 @@
+/*
+ * ChildProcessReactor.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_SYSTEM_CHILD_PROCESS_REACTOR_HPP
+#define CORE_SYSTEM_CHILD_PROCESS_REACTOR_HPP
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <core/system/System.hpp>
+
+namespace rstudio {
+namespace core {
+
+class Error;
+
+namespace system {
+
+// Tracks which of a set of child processes have output waiting to be read
+// or have exited, so that the process supervisor need only service those
+// children rather than reading from (and waiting on) every child each time
+// it polls. Output pipes are watched with epoll. Exits are watched with a
+// pidfd where the kernel supports them (Linux 5.3 and later). Children are
+// identified by process id.
+//
+// Where a child's output or exit can't be watched (e.g. a pidfd can't be
+// opened, or a descriptor can't be added to the epoll set) the caller
+// remains responsible for polling that child for it, as reported by
+// watchesOutput() and watchesExit().
+//
+// Descriptors are registered one-shot: once a child has been reported as
+// ready it isn't reported again until rearm() is called, which the caller
+// does after servicing it. Linux only.
+class ChildProcessReactor : boost::noncopyable
+{
+public:
+   ChildProcessReactor();
+   ~ChildProcessReactor();
+
+   Error initialize();
+
+   // start watching a child with the given output descriptors
+   void watch(PidType pid, const std::vector<int>& fds);
+
+   // stop watching a child. this only releases our own resources: a child's
+   // output descriptors are typically closed (and so removed from the epoll
+   // set) by the time it's unwatched, and their numbers may have been reused
+   void unwatch(PidType pid);
+
+   bool isWatching(PidType pid) const;
+
+   // does the reactor report the child's output?
+   bool watchesOutput(PidType pid) const;
+
+   // does the reactor report the child's exit (i.e. do we have a pidfd)?
+   bool watchesExit(PidType pid) const;
+
+   // watch the child again after it's been reported as ready; fds are the
+   // output descriptors which are still open and being read
+   void rearm(PidType pid, const std::vector<int>& fds);
+
+   // wait up to timeout (zero to not wait at all) for children to become
+   // ready, adding their process ids to pReadyPids
+   Error wait(const boost::posix_time::time_duration& timeout,
+              std::set<PidType>* pReadyPids);
+
+private:
+   struct Watch
+   {
+      Watch() : pidFd(-1), watchesOutput(false) {}
+      int pidFd;
+      bool watchesOutput;
+      std::vector<int> fds;
+   };
+
+   Error add(int fd, PidType pid);
+   void modify(int fd, PidType pid);
+   void remove(int fd);
+
+   int epollFd_;
+   std::map<PidType, Watch> watches_;
+};
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_SYSTEM_CHILD_PROCESS_REACTOR_HPP
@@ -0,0 +1,223 @@
+/*
+ * LinuxChildProcessReactor.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "ChildProcessReactor.hpp"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+
+#include <shared_core/Error.hpp>
+#include <core/Log.hpp>
+
+// pidfd_open has the same number on every architecture (other than alpha)
+// but isn't known to older C libraries
+#ifndef SYS_pidfd_open
+# define SYS_pidfd_open 434
+#endif
+
+namespace rstudio {
+namespace core {
+namespace system {
+
+namespace {
+
+// returns -1 if pidfds aren't supported
+int openPidFd(PidType pid)
+{
+   return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+}
+
+void closeFd(int fd)
+{
+   if (fd >= 0)
+      ::close(fd);
+}
+
+} // anonymous namespace
+
+ChildProcessReactor::ChildProcessReactor()
+   : epollFd_(-1)
+{
+}
+
+ChildProcessReactor::~ChildProcessReactor()
+{
+   for (const auto& watch : watches_)
+      closeFd(watch.second.pidFd);
+   closeFd(epollFd_);
+}
+
+Error ChildProcessReactor::initialize()
+{
+   epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+   if (epollFd_ == -1)
+      return systemError(errno, ERROR_LOCATION);
+
+   return Success();
+}
+
+void ChildProcessReactor::watch(PidType pid, const std::vector<int>& fds)
+{
+   Watch watch;
+   watch.watchesOutput = true;
+   watch.fds = fds;
+   for (std::size_t i = 0; i < fds.size(); i++)
+   {
+      Error error = add(fds[i], pid);
+      if (error)
+      {
+         // leave this child's output to be polled
+         LOG_ERROR(error);
+         for (std::size_t j = 0; j < i; j++)
+            remove(fds[j]);
+         watch.watchesOutput = false;
+         watch.fds.clear();
+         break;
+      }
+   }
+
+   // a pidfd becomes readable when the process exits (note that we still
+   // reap the process with waitpid). if we can't have one, this child's
+   // exit is left to be polled
+   watch.pidFd = openPidFd(pid);
+   if (watch.pidFd == -1)
+   {
+      // not supported by this kernel
+      if (errno != ENOSYS)
+         LOG_ERROR(systemError(errno, ERROR_LOCATION));
+   }
+   else
+   {
+      Error error = add(watch.pidFd, pid);
+      if (error)
+      {
+         LOG_ERROR(error);
+         closeFd(watch.pidFd);
+         watch.pidFd = -1;
+      }
+   }
+
+   watches_[pid] = watch;
+}
+
+void ChildProcessReactor::unwatch(PidType pid)
+{
+   auto it = watches_.find(pid);
+   if (it == watches_.end())
+      return;
+
+   // closing the pidfd removes it from the epoll set
+   closeFd(it->second.pidFd);
+   watches_.erase(it);
+}
+
+bool ChildProcessReactor::isWatching(PidType pid) const
+{
+   return watches_.find(pid) != watches_.end();
+}
+
+bool ChildProcessReactor::watchesOutput(PidType pid) const
+{
+   auto it = watches_.find(pid);
+   return it != watches_.end() && it->second.watchesOutput;
+}
+
+bool ChildProcessReactor::watchesExit(PidType pid) const
+{
+   auto it = watches_.find(pid);
+   return it != watches_.end() && it->second.pidFd != -1;
+}
+
+void ChildProcessReactor::rearm(PidType pid, const std::vector<int>& fds)
+{
+   auto it = watches_.find(pid);
+   if (it == watches_.end())
+      return;
+
+   // descriptors the child has finished with (e.g. at end of file) stay
+   // readable, so leave them disarmed rather than having them reported on
+   // every wait
+   if (it->second.watchesOutput)
+   {
+      it->second.fds = fds;
+      for (int fd : fds)
+         modify(fd, pid);
+   }
+
+   if (it->second.pidFd != -1)
+      modify(it->second.pidFd, pid);
+}
+
+Error ChildProcessReactor::wait(const boost::posix_time::time_duration& timeout,
+                                std::set<PidType>* pReadyPids)
+{
+   const int kMaxEvents = 64;
+   struct epoll_event events[kMaxEvents];
+
+   int timeoutMs = static_cast<int>(timeout.total_milliseconds());
+   while (true)
+   {
+      int count = ::epoll_wait(epollFd_, events, kMaxEvents, timeoutMs);
+      if (count == -1)
+      {
+         if (errno == EINTR)
+            return Success();
+         return systemError(errno, ERROR_LOCATION);
+      }
+
+      for (int i = 0; i < count; i++)
+         pReadyPids->insert(static_cast<PidType>(events[i].data.u64));
+
+      // keep collecting (without waiting) if there may be more events
+      if (count < kMaxEvents)
+         return Success();
+      timeoutMs = 0;
+   }
+}
+
+Error ChildProcessReactor::add(int fd, PidType pid)
+{
+   struct epoll_event event = epoll_event();
+   event.events = EPOLLIN | EPOLLONESHOT;
+   event.data.u64 = static_cast<uint64_t>(pid);
+   if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == -1)
+   {
+      Error error = systemError(errno, ERROR_LOCATION);
+      error.addProperty("fd", fd);
+      return error;
+   }
+   return Success();
+}
+
+void ChildProcessReactor::modify(int fd, PidType pid)
+{
+   struct epoll_event event = epoll_event();
+   event.events = EPOLLIN | EPOLLONESHOT;
+   event.data.u64 = static_cast<uint64_t>(pid);
+   if (::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == -1)
+      LOG_ERROR(systemError(errno, ERROR_LOCATION));
+}
+
+void ChildProcessReactor::remove(int fd)
+{
+   if (::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr) == -1)
+      LOG_ERROR(systemError(errno, ERROR_LOCATION));
+}
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
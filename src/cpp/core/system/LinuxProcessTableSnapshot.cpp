@@ -0,0 +1,235 @@
+/*
+ * LinuxProcessTableSnapshot.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "ProcessTableSnapshot.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+
+namespace {
+
+// read up to size bytes of a (small) file, returning the number of bytes
+// read or -1 if the file couldn't be read
+ssize_t readFile(const std::string& path, char* buffer, std::size_t size)
+{
+   int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd == -1)
+      return -1;
+
+   ssize_t count = ::read(fd, buffer, size);
+   ::close(fd);
+   return count;
+}
+
+bool isPid(const char* name)
+{
+   if (*name == '\0')
+      return false;
+
+   for (const char* c = name; *c; ++c)
+   {
+      if (*c < '0' || *c > '9')
+         return false;
+   }
+   return true;
+}
+
+} // anonymous namespace
+
+ProcessTableSnapshot& ProcessTableSnapshot::shared()
+{
+   // (never destroyed, as children may be polled during shutdown)
+   static ProcessTableSnapshot* pInstance = new ProcessTableSnapshot();
+   return *pInstance;
+}
+
+ProcessTableSnapshot::ProcessTableSnapshot(const FilePath& procFsPath,
+                                           const boost::posix_time::time_duration& maxAge)
+   : procFsPath_(procFsPath.getAbsolutePath()),
+     maxAge_(maxAge),
+     scanTime_(boost::posix_time::not_a_date_time)
+{
+}
+
+std::vector<SubprocInfo> ProcessTableSnapshot::children(PidType pid)
+{
+   boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+
+   LOCK_MUTEX(mutex_)
+   {
+      stats_.queries++;
+
+      bool scanned = needsScan(now);
+      if (scanned)
+         scan(now);
+
+      auto it = children_.find(pid);
+      if (it == children_.end())
+         return std::vector<SubprocInfo>();
+
+      // children in an older snapshot may since have exited or exec'd
+      // another program, so check them again (no new children can have
+      // appeared without the last pid changing)
+      if (!scanned)
+      {
+         std::vector<SubprocInfo>& subprocs = it->second;
+         for (std::size_t i = 0; i < subprocs.size(); )
+         {
+            Entry entry;
+            if (readEntry(subprocs[i].pid, &entry) && entry.ppid == pid)
+            {
+               subprocs[i].exe = entry.exe;
+               i++;
+            }
+            else
+            {
+               subprocs.erase(subprocs.begin() + i);
+            }
+         }
+      }
+
+      return it->second;
+   }
+   END_LOCK_MUTEX
+
+   return std::vector<SubprocInfo>();
+}
+
+ProcessTableSnapshot::Stats ProcessTableSnapshot::stats() const
+{
+   LOCK_MUTEX(mutex_)
+   {
+      return stats_;
+   }
+   END_LOCK_MUTEX
+
+   return Stats();
+}
+
+bool ProcessTableSnapshot::readEntry(PidType pid, Entry* pEntry) const
+{
+   // the stat file looks like:
+   //
+   //    4075 (My )(great Program) S 4074 ....
+   //
+   // the executable name (in parentheses) can contain anything, including
+   // whitespace and parentheses, so we look for the last closing parenthesis
+   // and find the parent pid (the second field after it) from there. a
+   // buffer of this size holds everything up to and including the parent
+   // pid, even for the longest of names.
+   char buffer[512];
+   std::string path = procFsPath_ + "/" + std::to_string(pid) + "/stat";
+   ssize_t count = readFile(path, buffer, sizeof(buffer) - 1);
+   if (count <= 0)
+      return false;
+   buffer[count] = '\0';
+
+   const char* openParen = std::strchr(buffer, '(');
+   const char* closeParen = std::strrchr(buffer, ')');
+   if (openParen == nullptr || closeParen == nullptr || closeParen < openParen)
+      return false;
+
+   // skip the state to reach the parent pid
+   const char* ppid = closeParen + 1;
+   while (*ppid == ' ')
+      ++ppid;
+   while (*ppid != ' ' && *ppid != '\0')
+      ++ppid;
+   char* end = nullptr;
+   long value = std::strtol(ppid, &end, 10);
+   if (end == ppid)
+      return false;
+
+   pEntry->ppid = static_cast<PidType>(value);
+   pEntry->exe.assign(openParen + 1, closeParen);
+   return true;
+}
+
+std::string ProcessTableSnapshot::lastPid() const
+{
+   // e.g. "0.20 0.18 0.12 1/80 11206"; the last field is the most recently
+   // created pid
+   char buffer[128];
+   ssize_t count = readFile(procFsPath_ + "/loadavg", buffer, sizeof(buffer) - 1);
+   if (count <= 0)
+      return std::string();
+
+   std::string loadAvg(buffer, count);
+   std::size_t end = loadAvg.find_last_not_of(" \n");
+   if (end == std::string::npos)
+      return std::string();
+   std::size_t start = loadAvg.find_last_of(' ', end);
+   return loadAvg.substr(start == std::string::npos ? 0 : start + 1, end - start);
+}
+
+bool ProcessTableSnapshot::needsScan(boost::posix_time::ptime now)
+{
+   if (scanTime_.is_not_a_date_time())
+      return true;
+
+   // nothing has been created since the last scan
+   std::string last = lastPid();
+   if (!last.empty() && last == scanLastPid_)
+      return false;
+
+   return now - scanTime_ > maxAge_;
+}
+
+void ProcessTableSnapshot::scan(boost::posix_time::ptime now)
+{
+   stats_.scans++;
+   children_.clear();
+
+   // read the last pid first, so that anything created during the scan
+   // prompts another one
+   scanLastPid_ = lastPid();
+   scanTime_ = now;
+
+   DIR* pDir = ::opendir(procFsPath_.c_str());
+   if (pDir == nullptr)
+      return;
+
+   while (struct dirent* pEntry = ::readdir(pDir))
+   {
+      if (!isPid(pEntry->d_name))
+         continue;
+
+      PidType pid = static_cast<PidType>(std::atol(pEntry->d_name));
+      Entry entry;
+      if (!readEntry(pid, &entry))
+         continue;
+
+      SubprocInfo info;
+      info.pid = pid;
+      info.exe = entry.exe;
+      children_[entry.ppid].push_back(info);
+   }
+
+   ::closedir(pDir);
+}
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
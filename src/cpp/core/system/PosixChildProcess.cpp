@@ -1000,10 +1000,31 @@ bool AsyncChildProcess::hasRecentOutput() const
 }
 
 void AsyncChildProcess::poll()
+{
+   poll(true, true);
+}
+
+std::vector<int> AsyncChildProcess::outputFds() const
+{
+   std::vector<int> fds;
+   if (!pAsyncImpl_->finishedStdout_)
+      fds.push_back(pImpl_->fdStdout);
+
+   // (stderr is disabled for pseudoterminals)
+   if (!pAsyncImpl_->finishedStderr_ && !options().pseudoterminal)
+      fds.push_back(pImpl_->fdStderr);
+
+   return fds;
+}
+
+void AsyncChildProcess::poll(bool readOutput, bool checkExit)
 {
    // call onStarted if we haven't yet
    if (!(pAsyncImpl_->calledOnStarted_))
    {
+      readOutput = true;
+      checkExit = true;
+
       // make sure the output pipes are setup for async reading
       setPipeNonBlocking(pImpl_->fdStdout);
 
@@ -1041,7 +1062,7 @@ void AsyncChildProcess::poll()
    bool hasRecentOutput = false;
 
    // check stdout and fire event if we got output
-   if (!pAsyncImpl_->finishedStdout_)
+   if (readOutput && !pAsyncImpl_->finishedStdout_)
    {
       bool eof;
       std::string out;
@@ -1064,7 +1085,7 @@ void AsyncChildProcess::poll()
    }
 
    // check stderr and fire event if we got output
-   if (!pAsyncImpl_->finishedStderr_)
+   if (readOutput && !pAsyncImpl_->finishedStderr_)
    {
       bool eof;
       std::string err;
@@ -1094,7 +1115,7 @@ void AsyncChildProcess::poll()
    // case we'll allow the exit sequence to proceed and simply pass -1 as
    // the exit status.
    int status;
-   PidType result = posix::posixCall<PidType>(
+   PidType result = !checkExit ? 0 : posix::posixCall<PidType>(
             boost::bind(::waitpid, pImpl_->pid, &status, WNOHANG));
 
    // either a normal exit or an error while waiting
@@ -15,15 +15,26 @@
 
 #include <core/system/FileScanner.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <shared_core/Error.hpp>
 #include <core/Log.hpp>
 #include <shared_core/FilePath.hpp>
 #include <core/BoostThread.hpp>
-
-#include "config.h"
+#include <core/Thread.hpp>
 
 namespace rstudio {
 namespace core {
@@ -31,78 +42,153 @@ namespace system {
 
 namespace {
 
-#if defined(__APPLE__) && !defined(HAVE_SCANDIR_POSIX)
-int entryFilter(struct dirent *entry)
-#else
-int entryFilter(const struct dirent *entry)
-#endif
+struct DirEntry
 {
-   if (::strcmp(entry->d_name, ".") == 0 || ::strcmp(entry->d_name, "..") == 0)
-      return 0;
-   else
-      return 1;
-}
+   std::string name;
+   unsigned char type;
+};
 
 // note: because R may change LC_COLLATE, we cannot
 // use strcoll (otherwise we run into race issues where
 // the file monitor attempts to access LC_COLLATE just as
 // R is replacing it). to avoid this, we use strcmp and
 // don't sort according to locale.
-#if !defined(HAVE_SCANDIR_POSIX)
-int alphasort(const void* voidlhs, const void* voidrhs)
+bool entryLessThan(const DirEntry& lhs, const DirEntry& rhs)
 {
-   const dirent** lhs = (const dirent**)voidlhs;
-   const dirent** rhs = (const dirent**)voidrhs;
-#else
-int alphasort(const dirent** lhs, const dirent** rhs)
+   return std::strcmp(lhs.name.c_str(), rhs.name.c_str()) < 0;
+}
+
+Error interruptedError(const ErrorLocation& location)
 {
-#endif
-   return strcmp((*lhs)->d_name, (*rhs)->d_name);
+   // mark as expected to suppress logging
+   Error error = core::systemError(boost::system::errc::interrupted, location);
+   error.setExpected();
+   return error;
 }
 
-// wrapper for scandir api
-Error scanDir(const std::string& dirPath, std::vector<std::string>* pNames)
+bool isInterrupted(const std::atomic<bool>* pCancelled)
 {
-   // read directory contents into namelist
-   struct dirent **namelist;
-   int entries = ::scandir(dirPath.c_str(),
-                           &namelist,
-                           entryFilter,
-                           alphasort);
-   if (entries == -1)
+   if (pCancelled)
+      return *pCancelled;
+   else
+      return boost::this_thread::interruption_requested();
+}
+
+// read the (filtered) contents of a directory, sorted by name. the directory
+// is opened once and its entries are stat'ed relative to it (rather than
+// by their full paths); directories reported by readdir don't need to be
+// stat'ed at all since we don't record their size or modification time
+Error listDirectory(const std::string& dirPath,
+                    const boost::function<bool(const FileInfo&)>& filter,
+                    const std::atomic<bool>* pCancelled,
+                    std::vector<FileInfo>* pFiles)
+{
+   int fd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (fd == -1)
    {
       Error error = systemError(errno, ERROR_LOCATION);
       error.addProperty("path", dirPath);
       return error;
    }
 
-   // extract the namelist then free it
-   for(int i=0; i<entries; i++)
+   DIR* pDir = ::fdopendir(fd);
+   if (pDir == nullptr)
    {
-      // get the name (then free it)
-      std::string name(namelist[i]->d_name);
-      ::free(namelist[i]);
+      Error error = systemError(errno, ERROR_LOCATION);
+      error.addProperty("path", dirPath);
+      ::close(fd);
+      return error;
+   }
 
-      // add to the vector
-      pNames->push_back(name);
+   // read the entries (readdir reads them in large batches)
+   std::vector<DirEntry> entries;
+   errno = 0;
+   while (struct dirent* pEntry = ::readdir(pDir))
+   {
+      const char* name = pEntry->d_name;
+      if (::strcmp(name, ".") != 0 && ::strcmp(name, "..") != 0)
+         entries.push_back(DirEntry { name, pEntry->d_type });
+      errno = 0;
    }
-   ::free(namelist);
 
-   return Success();
-}
+   if (errno != 0)
+   {
+      Error error = systemError(errno, ERROR_LOCATION);
+      error.addProperty("path", dirPath);
+      ::closedir(pDir);
+      return error;
+   }
 
-} // anonymous namespace
+   std::sort(entries.begin(), entries.end(), entryLessThan);
 
-Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
-                const FileScannerOptions& options,
-                tree<FileInfo>* pTree)
-{
-   // clear all existing
-   pTree->erase_children(fromNode);
+   std::string prefix = dirPath;
+   if (prefix.empty() || prefix[prefix.length() - 1] != '/')
+      prefix.push_back('/');
+
+   for (const DirEntry& entry : entries)
+   {
+      if (isInterrupted(pCancelled))
+      {
+         ::closedir(pDir);
+         return interruptedError(ERROR_LOCATION);
+      }
+
+      std::string path = prefix + entry.name;
+
+      // create the FileInfo
+      FileInfo fileInfo;
+      if (entry.type == DT_DIR)
+      {
+         fileInfo = FileInfo(path, true, false);
+      }
+      else
+      {
+         // get the attributes
+         struct stat st;
+         int res = ::fstatat(fd, entry.name.c_str(), &st, AT_SYMLINK_NOFOLLOW);
+         if (res == -1)
+         {
+            if (errno != ENOENT && errno != EACCES)
+            {
+               Error error = systemError(errno, ERROR_LOCATION);
+               error.addProperty("path", path);
+               LOG_ERROR(error);
+            }
+            continue;
+         }
 
-   // create FilePath for root
-   FilePath rootPath(fromNode->absolutePath());
+         bool isSymlink = S_ISLNK(st.st_mode);
+         if (S_ISDIR(st.st_mode))
+         {
+            fileInfo = FileInfo(path, true, isSymlink);
+         }
+         else
+         {
+            fileInfo = FileInfo(path,
+                                false,
+                                st.st_size,
+#ifdef __APPLE__
+                                st.st_mtimespec.tv_sec,
+#else
+                                st.st_mtime,
+#endif
+                                isSymlink);
+         }
+      }
+
+      // apply the filter (if any)
+      if (!filter || filter(fileInfo))
+         pFiles->push_back(fileInfo);
+   }
 
+   ::closedir(pDir);
+   return Success();
+}
+
+Error scanFilesSerial(const tree<FileInfo>::iterator_base& fromNode,
+                      const FileScannerOptions& options,
+                      tree<FileInfo>* pTree)
+{
    // yield if requested (only applies to recursive scans)
    if (options.recursive && options.yield)
       boost::this_thread::yield();
@@ -116,89 +202,300 @@ Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
    }
 
    // read directory contents
-   std::vector<std::string> names;
-   Error error = scanDir(fromNode->absolutePath(), &names);
+   std::vector<FileInfo> files;
+   Error error = listDirectory(fromNode->absolutePath(), options.filter, nullptr, &files);
    if (error)
       return error;
 
-   // iterate over the names
-   for (const std::string& name : names)
+   // iterate over the files
+   for (const FileInfo& fileInfo : files)
    {
-      // check for interrupt (mark as expected to suppress logging)
+      // check for interrupt
       if (boost::this_thread::interruption_requested())
+         return interruptedError(ERROR_LOCATION);
+
+      // add the correct type of FileEntry
+      tree<FileInfo>::iterator_base child = pTree->append_child(fromNode, fileInfo);
+
+      // recurse if requested and this is a directory (but not a link)
+      if (options.recursive && fileInfo.isDirectory() && !fileInfo.isSymlink())
       {
-         Error error = core::systemError(boost::system::errc::interrupted, ERROR_LOCATION);
-         error.setExpected();
-         return error;
+         // try to scan the files in the subdirectory -- if we fail
+         // we continue because we don't want one "bad" directory
+         // to cause us to abort the entire scan. yes the tree
+         // will be incomplete however it will be even more incompete
+         // if we fail entirely
+         Error error = scanFilesSerial(child, options, pTree);
+         if (error)
+            LOG_ERROR(error);
       }
+   }
+
+   // return success
+   return Success();
+}
 
-      // compute the path
-      std::string path = rootPath.completeChildPath(name).getAbsolutePath();
+// Scans directories on a pool of threads (the calling thread included).
+// Each directory's listing is stored in a node of a scratch tree of
+// directories; once every directory has been read the FileInfo tree is
+// built from it in the same order a serial scan would produce.
+class ParallelScan : boost::noncopyable
+{
+public:
+   ParallelScan(const FileInfo& root, const FileScannerOptions& options)
+      : root_(new Directory(root)),
+        options_(options),
+        pending_(0),
+        cancelled_(false)
+   {
+   }
 
-      // get the attributes
-      struct stat st;
-      int res = ::lstat(path.c_str(), &st);
-      if (res == -1)
+   ~ParallelScan()
+   {
+      try
+      {
+         stop();
+      }
+      catch (...)
       {
-         if (errno != ENOENT && errno != EACCES)
-         {
-            Error error = systemError(errno, ERROR_LOCATION);
-            error.addProperty("path", path);
-            LOG_ERROR(error);
-         }
-         continue;
       }
+   }
+
+   Error run(const tree<FileInfo>::iterator_base& fromNode, tree<FileInfo>* pTree)
+   {
+      // we poll for interruption while waiting for the workers (rather
+      // than being interrupted in a wait and leaving them running)
+      boost::this_thread::disable_interruption disableInterruption;
+
+      push(root_.get());
+
+      threads_.resize(options_.threads - 1);
+      for (boost::thread& thread : threads_)
+         core::thread::safeLaunchThread(boost::bind(&ParallelScan::worker, this), &thread);
+
+      workUntilDone();
+      stop();
+
+      if (cancelled_)
+         return interruptedError(ERROR_LOCATION);
+
+      if (root_->error)
+         return root_->error;
+
+      addToTree(*root_, fromNode, pTree);
+      return Success();
+   }
+
+private:
+   struct Directory : boost::noncopyable
+   {
+      explicit Directory(const FileInfo& fileInfo) : fileInfo(fileInfo) {}
 
-      // create the FileInfo
       FileInfo fileInfo;
-      bool isSymlink = S_ISLNK(st.st_mode);
-      if (S_ISDIR(st.st_mode))
+      std::vector<FileInfo> files;
+
+      // the scanned subdirectories (parallel to files; null for entries
+      // which aren't traversed)
+      std::vector<boost::shared_ptr<Directory> > subdirs;
+
+      Error error;
+   };
+
+   void push(Directory* pDirectory)
+   {
+      LOCK_MUTEX(mutex_)
       {
-         fileInfo = FileInfo(path, true, isSymlink);
+         queue_.push_back(pDirectory);
+         pending_++;
+         condition_.notify_one();
       }
-      else
+      END_LOCK_MUTEX
+   }
+
+   // returns null when the scan is complete (or cancelled)
+   Directory* pop(bool pollInterruption)
+   {
+      try
       {
-         fileInfo = FileInfo(path,
-                             false,
-                             st.st_size,
-#ifdef __APPLE__
-                             st.st_mtimespec.tv_sec,
-#else
-                             st.st_mtime,
-#endif
-                             isSymlink);
+         boost::unique_lock<boost::mutex> lock(mutex_);
+         while (queue_.empty() && pending_ > 0 && !cancelled_)
+         {
+            if (pollInterruption)
+            {
+               condition_.timed_wait(lock, boost::posix_time::milliseconds(50));
+               if (boost::this_thread::interruption_requested())
+                  cancel();
+            }
+            else
+            {
+               condition_.wait(lock);
+            }
+         }
+
+         if (queue_.empty() || cancelled_)
+            return nullptr;
+
+         // take the most recently discovered directory (this keeps the
+         // number of directories waiting to be read small)
+         Directory* pDirectory = queue_.back();
+         queue_.pop_back();
+         return pDirectory;
+      }
+      catch (const boost::thread_resource_error&)
+      {
+         cancel();
+         return nullptr;
       }
+   }
 
-      // apply the filter (if any)
-      if (!options.filter || options.filter(fileInfo))
+   void done()
+   {
+      LOCK_MUTEX(mutex_)
       {
-         // add the correct type of FileEntry
-         if (fileInfo.isDirectory())
+         if (--pending_ == 0)
+            condition_.notify_all();
+      }
+      END_LOCK_MUTEX
+   }
+
+   // note: expects the mutex to be held when called from pop
+   void cancel()
+   {
+      cancelled_ = true;
+      condition_.notify_all();
+   }
+
+   void workUntilDone()
+   {
+      while (Directory* pDirectory = pop(true))
+      {
+         if (boost::this_thread::interruption_requested())
          {
-            tree<FileInfo>::iterator_base child = pTree->append_child(fromNode,
-                                                                      fileInfo);
-            // recurse if requested and this isn't a link
-            if (options.recursive && !fileInfo.isSymlink())
+            LOCK_MUTEX(mutex_)
             {
-               // try to scan the files in the subdirectory -- if we fail
-               // we continue because we don't want one "bad" directory
-               // to cause us to abort the entire scan. yes the tree
-               // will be incomplete however it will be even more incompete
-               // if we fail entirely
-               Error error = scanFiles(child, options, pTree);
-               if (error)
-                  LOG_ERROR(error);
+               cancel();
             }
+            END_LOCK_MUTEX
+            break;
          }
-         else
+
+         scan(pDirectory);
+      }
+   }
+
+   void worker()
+   {
+      while (Directory* pDirectory = pop(false))
+         scan(pDirectory);
+   }
+
+   void scan(Directory* pDirectory)
+   {
+      // call onBeforeScanDir hook (serialized, since it's typically
+      // registering the directory with some other facility)
+      if (options_.onBeforeScanDir)
+      {
+         LOCK_MUTEX(beforeScanMutex_)
+         {
+            pDirectory->error = options_.onBeforeScanDir(pDirectory->fileInfo);
+         }
+         END_LOCK_MUTEX
+      }
+
+      if (!pDirectory->error)
+      {
+         pDirectory->error = listDirectory(pDirectory->fileInfo.absolutePath(),
+                                           options_.filter,
+                                           &cancelled_,
+                                           &pDirectory->files);
+      }
+
+      if (!pDirectory->error)
+      {
+         pDirectory->subdirs.resize(pDirectory->files.size());
+         for (std::size_t i = pDirectory->files.size(); i > 0; i--)
          {
-            pTree->append_child(fromNode, fileInfo);
+            const FileInfo& fileInfo = pDirectory->files[i - 1];
+            if (fileInfo.isDirectory() && !fileInfo.isSymlink())
+            {
+               pDirectory->subdirs[i - 1].reset(new Directory(fileInfo));
+               push(pDirectory->subdirs[i - 1].get());
+            }
          }
       }
+
+      done();
    }
 
-   // return success
-   return Success();
+   void stop()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         if (pending_ > 0)
+            cancel();
+         else
+            condition_.notify_all();
+      }
+      END_LOCK_MUTEX
+
+      for (boost::thread& thread : threads_)
+      {
+         if (thread.joinable())
+            thread.join();
+      }
+      threads_.clear();
+   }
+
+   void addToTree(const Directory& directory,
+                  const tree<FileInfo>::iterator_base& node,
+                  tree<FileInfo>* pTree)
+   {
+      for (std::size_t i = 0; i < directory.files.size(); i++)
+      {
+         tree<FileInfo>::iterator_base child = pTree->append_child(node, directory.files[i]);
+
+         const Directory* pSubdir = directory.subdirs[i].get();
+         if (pSubdir == nullptr)
+            continue;
+
+         // as with serial scans a directory which couldn't be read is left
+         // empty rather than failing the entire scan
+         if (pSubdir->error)
+            LOG_ERROR(pSubdir->error);
+         else
+            addToTree(*pSubdir, child, pTree);
+      }
+   }
+
+   boost::scoped_ptr<Directory> root_;
+   const FileScannerOptions& options_;
+
+   boost::mutex mutex_;
+   boost::condition_variable condition_;
+   std::vector<Directory*> queue_;
+   std::size_t pending_;
+   std::atomic<bool> cancelled_;
+   std::vector<boost::thread> threads_;
+
+   boost::mutex beforeScanMutex_;
+};
+
+} // anonymous namespace
+
+Error scanFiles(const tree<FileInfo>::iterator_base& fromNode,
+                const FileScannerOptions& options,
+                tree<FileInfo>* pTree)
+{
+   // clear all existing
+   pTree->erase_children(fromNode);
+
+   if (options.recursive && options.threads > 1)
+   {
+      ParallelScan scan(*fromNode, options);
+      return scan.run(fromNode, pTree);
+   }
+
+   return scanFilesSerial(fromNode, options, pTree);
 }
 
 } // namespace system
@@ -0,0 +1,107 @@
+/*
+ * PosixFileScannerBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef _WIN32
+
+#include <core/system/FileScanner.hpp>
+
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/FileSerializer.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+namespace tests {
+
+using namespace boost::posix_time;
+
+namespace {
+
+// creates dirs subdirectories (each with a nested directory) containing
+// files files each
+FilePath populate(int dirs, int files)
+{
+   FilePath root;
+   REQUIRE_FALSE(FilePath::tempFilePath(root));
+   REQUIRE_FALSE(root.ensureDirectory());
+
+   for (int i = 0; i < dirs; i++)
+   {
+      FilePath dir = root.completeChildPath("dir" + std::to_string(i));
+      FilePath nested = dir.completeChildPath("nested");
+      REQUIRE_FALSE(nested.ensureDirectory());
+      for (int j = 0; j < files; j++)
+      {
+         std::string name = "file" + std::to_string(j) + ".R";
+         REQUIRE_FALSE(writeStringToFile(dir.completeChildPath(name), std::string(j, 'x')));
+         REQUIRE_FALSE(writeStringToFile(nested.completeChildPath(name), "x"));
+      }
+   }
+
+   return root;
+}
+
+} // anonymous namespace
+
+// the benefit is largest on network file systems, where each directory read
+// and stat has significant latency; on local disks the gain is more modest
+TEST_CASE("PosixFileScanner Benchmarks")
+{
+   const int kDirs = 2000;
+   const int kFiles = 10;
+
+   FilePath root = populate(kDirs, kFiles);
+
+   auto timeScan = [&](std::size_t threads, std::size_t* pSize) -> long
+   {
+      FileScannerOptions options;
+      options.recursive = true;
+      options.threads = threads;
+
+      ptime start = microsec_clock::universal_time();
+      tree<FileInfo> fileTree;
+      REQUIRE_FALSE(scanFiles(FileInfo(root), options, &fileTree));
+      *pSize = fileTree.size();
+      return (microsec_clock::universal_time() - start).total_milliseconds();
+   };
+
+   std::size_t serialSize = 0;
+   std::size_t parallelSize = 0;
+   long serialMs = timeScan(1, &serialSize);
+   long parallelMs = timeScan(4, &parallelSize);
+   CHECK(parallelSize == serialSize);
+
+   std::cout << "scan files (" << serialSize << " files): "
+             << "1 thread " << serialMs << "ms, "
+             << "4 threads " << parallelMs << "ms" << std::endl;
+
+   root.removeIfExists();
+}
+
+} // namespace tests
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // _WIN32
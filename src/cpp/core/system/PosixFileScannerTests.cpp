@@ -0,0 +1,237 @@
+/*
+ * PosixFileScannerTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef _WIN32
+
+#include <core/system/FileScanner.hpp>
+
+#include <atomic>
+
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+
+#include <core/BoostThread.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/Thread.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+namespace tests {
+
+namespace {
+
+FilePath createTempDirectory()
+{
+   FilePath dir;
+   REQUIRE_FALSE(FilePath::tempFilePath(dir));
+   REQUIRE_FALSE(dir.ensureDirectory());
+   return dir;
+}
+
+// creates dirs subdirectories (each with a nested directory) containing
+// files files each, plus a few symlinks
+void populate(const FilePath& root, int dirs, int files)
+{
+   for (int i = 0; i < dirs; i++)
+   {
+      FilePath dir = root.completeChildPath("dir" + std::to_string(i));
+      FilePath nested = dir.completeChildPath("nested");
+      REQUIRE_FALSE(nested.ensureDirectory());
+      for (int j = 0; j < files; j++)
+      {
+         std::string name = "file" + std::to_string(j) + ".R";
+         REQUIRE_FALSE(writeStringToFile(dir.completeChildPath(name), std::string(j, 'x')));
+         REQUIRE_FALSE(writeStringToFile(nested.completeChildPath(name), "x"));
+      }
+   }
+
+   REQUIRE(::symlink(root.completeChildPath("dir0").getAbsolutePath().c_str(),
+                     root.completeChildPath("link-to-dir").getAbsolutePath().c_str()) == 0);
+   REQUIRE(::symlink("dir0/file0.R",
+                     root.completeChildPath("link-to-file").getAbsolutePath().c_str()) == 0);
+}
+
+Error scan(const FilePath& root,
+           std::size_t threads,
+           tree<FileInfo>* pTree,
+           const boost::function<bool(const FileInfo&)>& filter =
+                                    boost::function<bool(const FileInfo&)>(),
+           const boost::function<Error(const FileInfo&)>& onBeforeScanDir =
+                                    boost::function<Error(const FileInfo&)>())
+{
+   FileScannerOptions options;
+   options.recursive = true;
+   options.threads = threads;
+   options.filter = filter;
+   options.onBeforeScanDir = onBeforeScanDir;
+   return scanFiles(FileInfo(root), options, pTree);
+}
+
+std::vector<std::string> describe(const tree<FileInfo>& fileTree)
+{
+   std::vector<std::string> entries;
+   for (auto it = fileTree.begin(); it != fileTree.end(); ++it)
+   {
+      entries.push_back(it->absolutePath() +
+                        " depth=" + std::to_string(fileTree.depth(it)) +
+                        " dir=" + std::to_string(it->isDirectory()) +
+                        " link=" + std::to_string(it->isSymlink()) +
+                        " size=" + std::to_string(it->size()) +
+                        " mtime=" + std::to_string(it->lastWriteTime()));
+   }
+   return entries;
+}
+
+bool notNamed(const FileInfo& fileInfo, const std::string& name)
+{
+   return FilePath(fileInfo.absolutePath()).getFilename() != name;
+}
+
+} // anonymous namespace
+
+TEST_CASE("PosixFileScanner")
+{
+   SECTION("Parallel scans produce the same tree as serial scans")
+   {
+      FilePath root = createTempDirectory();
+      populate(root, 20, 5);
+
+      tree<FileInfo> serial;
+      REQUIRE_FALSE(scan(root, 1, &serial));
+      tree<FileInfo> parallel;
+      REQUIRE_FALSE(scan(root, 4, &parallel));
+
+      // root + 20 dirs (each with 5 files and a nested dir of 5 files) + 2 links
+      CHECK(serial.size() == 1 + 20 * 12 + 2);
+      CHECK(describe(parallel) == describe(serial));
+
+      // children are sorted by name and symlinked directories aren't traversed
+      tree<FileInfo>::sibling_iterator it = serial.begin(serial.begin());
+      CHECK(FilePath(it->absolutePath()).getFilename() == "dir0");
+      tree<FileInfo>::iterator linkIt = std::find_if(
+               serial.begin(), serial.end(),
+               [](const FileInfo& fileInfo) { return !notNamed(fileInfo, "link-to-dir"); });
+      REQUIRE(linkIt != serial.end());
+      CHECK(linkIt->isSymlink());
+      CHECK(serial.number_of_children(linkIt) == 0);
+
+      root.removeIfExists();
+   }
+
+   SECTION("Filters are applied before descending into directories")
+   {
+      FilePath root = createTempDirectory();
+      populate(root, 3, 2);
+
+      boost::function<bool(const FileInfo&)> filter = boost::bind(notNamed, _1, "nested");
+
+      tree<FileInfo> serial;
+      REQUIRE_FALSE(scan(root, 1, &serial, filter));
+      tree<FileInfo> parallel;
+      REQUIRE_FALSE(scan(root, 3, &parallel, filter));
+
+      CHECK(serial.size() == 1 + 3 * 3 + 2);
+      CHECK(describe(parallel) == describe(serial));
+
+      root.removeIfExists();
+   }
+
+   SECTION("Directories are reported before they are scanned")
+   {
+      FilePath root = createTempDirectory();
+      populate(root, 10, 1);
+
+      boost::function<bool(const FileInfo&)> noFilter;
+      std::atomic<int> count(0);
+      std::string failPath = root.completeChildPath("dir3").getAbsolutePath();
+      auto onBeforeScanDir = [&](const FileInfo& fileInfo) -> Error
+      {
+         count++;
+         if (fileInfo.absolutePath() == failPath)
+            return systemError(boost::system::errc::permission_denied, ERROR_LOCATION);
+         return Success();
+      };
+
+      tree<FileInfo> serial;
+      REQUIRE_FALSE(scan(root, 1, &serial, noFilter, onBeforeScanDir));
+      CHECK(count == 1 + 10 * 2 - 1);
+
+      count = 0;
+      tree<FileInfo> parallel;
+      REQUIRE_FALSE(scan(root, 4, &parallel, noFilter, onBeforeScanDir));
+      CHECK(count == 1 + 10 * 2 - 1);
+
+      // the failed directory is present but empty
+      CHECK(describe(parallel) == describe(serial));
+      CHECK(parallel.size() == 1 + 10 * 4 + 2 - 3);
+
+      // failures for the root fail the scan
+      failPath = root.getAbsolutePath();
+      tree<FileInfo> failed;
+      CHECK(scan(root, 1, &failed, noFilter, onBeforeScanDir));
+      failed.clear();
+      CHECK(scan(root, 4, &failed, noFilter, onBeforeScanDir));
+
+      root.removeIfExists();
+   }
+
+   SECTION("Scans can be interrupted")
+   {
+      FilePath root = createTempDirectory();
+      populate(root, 10, 10);
+
+      for (std::size_t threads : { 1u, 4u })
+      {
+         std::atomic<bool> interrupted(false);
+         Error error;
+         auto scanThread = [&]()
+         {
+            // spin (rather than wait) so that the interrupt isn't consumed
+            while (!interrupted)
+            {
+            }
+
+            tree<FileInfo> fileTree;
+            error = scan(root, threads, &fileTree);
+         };
+
+         boost::thread thread;
+         core::thread::safeLaunchThread(scanThread, &thread);
+         thread.interrupt();
+         interrupted = true;
+         thread.join();
+
+         CHECK(error == systemError(boost::system::errc::interrupted, ErrorLocation()));
+         CHECK(error.isExpected());
+      }
+
+      root.removeIfExists();
+   }
+}
+
+} // namespace tests
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // _WIN32
@@ -16,9 +16,11 @@
 #include <core/system/Process.hpp>
 
 #include <iostream>
+#include <set>
 
 #include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <core/Scope.hpp>
 #include <shared_core/Error.hpp>
@@ -27,6 +29,11 @@
 
 #include <core/PerformanceTimer.hpp>
 #include <core/system/ChildProcess.hpp>
+#include <core/system/Environment.hpp>
+
+#ifdef __linux__
+#include "ChildProcessReactor.hpp"
+#endif
 
 namespace rstudio {
 namespace core {
@@ -68,13 +75,111 @@ Error runCommand(const std::string& command,
 
 struct ProcessSupervisor::Impl
 {
-   Impl() : isPolling(false) {}
+   explicit Impl(bool pollAllChildren)
+      : isPolling(false)
+   {
+#ifdef __linux__
+      reactorDisabled = pollAllChildren ||
+                        !core::system::getenv("RSTUDIO_PROCESS_SUPERVISOR_POLL").empty();
+#endif
+   }
+
    bool isPolling;
    std::vector<boost::shared_ptr<AsyncChildProcess> > children;
+
+#ifdef __linux__
+   void pollChildren(const std::vector<boost::shared_ptr<AsyncChildProcess> >& children)
+   {
+      ChildProcessReactor* pReactor = reactor();
+      if (pReactor)
+      {
+         Error error = pReactor->wait(boost::posix_time::milliseconds(0), &readyPids);
+         if (error)
+         {
+            disableReactor(error);
+            pReactor = nullptr;
+         }
+      }
+
+      std::set<PidType> ready;
+      ready.swap(readyPids);
+
+      for (const boost::shared_ptr<AsyncChildProcess>& pChild : children)
+      {
+         if (!pReactor)
+         {
+            pChild->poll();
+            continue;
+         }
+
+         // children are first polled in full, then only read from when they
+         // have output and waited on when they've exited (or every time if
+         // we can't be told about their output or exit)
+         PidType pid = pChild->getPid();
+         bool isReady = true;
+         if (!pReactor->isWatching(pid))
+            pReactor->watch(pid, pChild->outputFds());
+         else
+            isReady = ready.count(pid) > 0;
+
+         pChild->poll(isReady || !pReactor->watchesOutput(pid),
+                      isReady || !pReactor->watchesExit(pid));
+
+         if (pChild->exited())
+            pReactor->unwatch(pid);
+         else if (isReady)
+            pReactor->rearm(pid, pChild->outputFds());
+      }
+   }
+
+   // wait for children to have output or exit; returns false if we can't
+   // (in which case the caller should sleep instead)
+   bool waitForChildren(const boost::posix_time::time_duration& timeout)
+   {
+      if (!pReactor)
+         return false;
+
+      Error error = pReactor->wait(timeout, &readyPids);
+      if (error)
+      {
+         disableReactor(error);
+         return false;
+      }
+      return true;
+   }
+
+   // returns null if the reactor is disabled or couldn't be created, in
+   // which case every child is polled each time
+   ChildProcessReactor* reactor()
+   {
+      if (!pReactor && !reactorDisabled)
+      {
+         pReactor.reset(new ChildProcessReactor());
+         Error error = pReactor->initialize();
+         if (error)
+            disableReactor(error);
+      }
+      return pReactor.get();
+   }
+
+   void disableReactor(const Error& error)
+   {
+      LOG_ERROR(error);
+      pReactor.reset();
+      reactorDisabled = true;
+   }
+
+   boost::scoped_ptr<ChildProcessReactor> pReactor;
+   bool reactorDisabled;
+
+   // children reported as ready while waiting, to be serviced by the
+   // next poll
+   std::set<PidType> readyPids;
+#endif
 };
 
-ProcessSupervisor::ProcessSupervisor()
-   : pImpl_(new Impl())
+ProcessSupervisor::ProcessSupervisor(bool pollAllChildren)
+   : pImpl_(new Impl(pollAllChildren))
 {
 }
 
@@ -324,9 +429,13 @@ bool ProcessSupervisor::poll()
    // the children vector and if this requried a realloc would invalidate
    // all of the iterators currently pointing into the container
    std::vector<boost::shared_ptr<AsyncChildProcess> > children = pImpl_->children;
+#ifdef __linux__
+   pImpl_->pollChildren(children);
+#else
    std::for_each(children.begin(),
                  children.end(),
                  boost::bind(&AsyncChildProcess::poll, _1));
+#endif
 
    // remove any children who have exited from our list. note that it's safe
    // in this case to use pImpl_->children directly because the call to
@@ -363,7 +472,11 @@ bool ProcessSupervisor::wait(
 
    while (poll())
    {
-      // wait the specified polling interval
+      // wait the specified polling interval (returning early if any of
+      // the children have output or exit)
+#ifdef __linux__
+      if (!pImpl_->waitForChildren(pollingInterval))
+#endif
       boost::this_thread::sleep(pollingInterval);
 
       // check for timeout if appropriate
@@ -0,0 +1,93 @@
+/*
+ * ProcessTableSnapshot.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_SYSTEM_PROCESS_TABLE_SNAPSHOT_HPP
+#define CORE_SYSTEM_PROCESS_TABLE_SNAPSHOT_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <shared_core/FilePath.hpp>
+
+#include <core/system/System.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+
+// Snapshot of the process table read from /proc, indexed by parent process,
+// for answering "what are the children of this process?" without reading
+// the stat file of every process on the machine each time (which gets
+// expensive with several terminals open on a busy host).
+//
+// The table is scanned again only when it's older than maxAge *and* a
+// process has been created since the last scan (judged by the last pid
+// recorded in /proc/loadavg, which is far cheaper to read than the table).
+// Between scans, the children returned are re-read individually so that
+// exits and execs are still reflected. Linux only.
+class ProcessTableSnapshot : boost::noncopyable
+{
+public:
+   struct Stats
+   {
+      Stats() : queries(0), scans(0) {}
+
+      std::size_t queries;
+      std::size_t scans;
+   };
+
+   // the snapshot shared by all of the session's child processes
+   static ProcessTableSnapshot& shared();
+
+   explicit ProcessTableSnapshot(
+         const FilePath& procFsPath = FilePath("/proc"),
+         const boost::posix_time::time_duration& maxAge = boost::posix_time::milliseconds(200));
+
+   std::vector<SubprocInfo> children(PidType pid);
+
+   Stats stats() const;
+
+private:
+   struct Entry
+   {
+      PidType ppid;
+      std::string exe;
+   };
+
+   bool readEntry(PidType pid, Entry* pEntry) const;
+   std::string lastPid() const;
+   bool needsScan(boost::posix_time::ptime now);
+   void scan(boost::posix_time::ptime now);
+
+   const std::string procFsPath_;
+   const boost::posix_time::time_duration maxAge_;
+
+   mutable boost::mutex mutex_;
+   std::unordered_map<PidType, std::vector<SubprocInfo> > children_;
+   boost::posix_time::ptime scanTime_;
+   std::string scanLastPid_;
+   Stats stats_;
+};
+
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_SYSTEM_PROCESS_TABLE_SNAPSHOT_HPP
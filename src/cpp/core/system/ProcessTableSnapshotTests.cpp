@@ -0,0 +1,202 @@
+/*
+ * ProcessTableSnapshotTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifdef __linux__
+
+#include "ProcessTableSnapshot.hpp"
+
+#include <algorithm>
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <core/FileSerializer.hpp>
+#include <core/system/System.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace system {
+namespace tests {
+
+using namespace boost::posix_time;
+
+namespace {
+
+// writes a process into a fake /proc
+void writeProcess(const FilePath& procFs, PidType pid, const std::string& exe, PidType ppid)
+{
+   FilePath dir = procFs.completeChildPath(std::to_string(pid));
+   dir.ensureDirectory();
+   writeStringToFile(dir.completeChildPath("stat"),
+                     std::to_string(pid) + " (" + exe + ") S " + std::to_string(ppid) +
+                     " 4075 4075 34817 4075 4194304 1000 0 0 0 1 0 0 0 20 0 1 0\n");
+}
+
+void setLastPid(const FilePath& procFs, PidType pid)
+{
+   writeStringToFile(procFs.completeChildPath("loadavg"),
+                     "0.20 0.18 0.12 1/80 " + std::to_string(pid) + "\n");
+}
+
+std::vector<PidType> pids(const std::vector<SubprocInfo>& subprocs)
+{
+   std::vector<PidType> pids;
+   for (const SubprocInfo& info : subprocs)
+      pids.push_back(info.pid);
+   std::sort(pids.begin(), pids.end());
+   return pids;
+}
+
+std::string exe(const std::vector<SubprocInfo>& subprocs, PidType pid)
+{
+   for (const SubprocInfo& info : subprocs)
+   {
+      if (info.pid == pid)
+         return info.exe;
+   }
+   return std::string();
+}
+
+} // anonymous namespace
+
+test_context("ProcessTableSnapshot")
+{
+   FilePath procFs;
+   FilePath::tempFilePath(procFs);
+   procFs.ensureDirectory();
+
+   writeProcess(procFs, 1, "init", 0);
+   writeProcess(procFs, 100, "My )(great Program", 1);
+   writeProcess(procFs, 101, "bash", 100);
+   writeProcess(procFs, 102, "sleep", 100);
+   writeProcess(procFs, 200, "bash", 1);
+   setLastPid(procFs, 200);
+
+   test_that("Children are found by parent pid")
+   {
+      ProcessTableSnapshot snapshot(procFs);
+
+      std::vector<SubprocInfo> children = snapshot.children(100);
+      expect_true(pids(children) == std::vector<PidType>({ 101, 102 }));
+      expect_true(exe(children, 102) == "sleep");
+
+      children = snapshot.children(1);
+      expect_true(pids(children) == std::vector<PidType>({ 100, 200 }));
+      expect_true(exe(children, 100) == "My )(great Program");
+
+      expect_true(snapshot.children(200).empty());
+      expect_true(snapshot.stats().scans == 1);
+   }
+
+   test_that("The table isn't scanned again until a process is created")
+   {
+      ProcessTableSnapshot snapshot(procFs, milliseconds(0));
+      snapshot.children(100);
+
+      // exits and execs are noticed without scanning again
+      writeProcess(procFs, 101, "vim", 100);
+      procFs.completeChildPath("102").removeIfExists();
+      std::vector<SubprocInfo> children = snapshot.children(100);
+      expect_true(pids(children) == std::vector<PidType>({ 101 }));
+      expect_true(exe(children, 101) == "vim");
+      expect_true(snapshot.stats().scans == 1);
+
+      writeProcess(procFs, 201, "R", 200);
+      setLastPid(procFs, 201);
+      children = snapshot.children(200);
+      expect_true(pids(children) == std::vector<PidType>({ 201 }));
+      expect_true(snapshot.stats().scans == 2);
+      expect_true(snapshot.stats().queries == 3);
+   }
+
+   test_that("Snapshots are reused until they're older than the maximum age")
+   {
+      ProcessTableSnapshot snapshot(procFs, hours(1));
+      expect_true(snapshot.children(200).empty());
+
+      writeProcess(procFs, 201, "R", 200);
+      setLastPid(procFs, 201);
+      expect_true(snapshot.children(200).empty());
+      expect_true(snapshot.stats().scans == 1);
+
+      ProcessTableSnapshot fresh(procFs, milliseconds(0));
+      expect_true(fresh.children(200).size() == 1);
+   }
+
+   // several terminals, each checking for subprocesses periodically
+   test_that("Terminals share one scan until a process is created")
+   {
+      const int kTerminals = 10;
+      for (int terminal = 0; terminal < kTerminals; terminal++)
+         writeProcess(procFs, 300 + terminal, "bash", 1);
+      setLastPid(procFs, 300 + kTerminals - 1);
+
+      ProcessTableSnapshot shared(procFs, milliseconds(0));
+      for (int round = 0; round < 5; round++)
+      {
+         for (int terminal = 0; terminal < kTerminals; terminal++)
+            expect_true(shared.children(300 + terminal).empty());
+      }
+      expect_true(shared.stats().scans == 1);
+      expect_true(shared.stats().queries == 5 * kTerminals);
+
+      // a command started in one terminal refreshes the snapshot once, for
+      // all of them
+      writeProcess(procFs, 400, "make", 303);
+      setLastPid(procFs, 400);
+      for (int terminal = 0; terminal < kTerminals; terminal++)
+      {
+         std::vector<SubprocInfo> children = shared.children(300 + terminal);
+         if (terminal == 3)
+            expect_true(exe(children, 400) == "make");
+         else
+            expect_true(children.empty());
+      }
+      expect_true(shared.stats().scans == 2);
+   }
+
+   procFs.remove();
+
+   test_that("Forked processes are found in the real process table")
+   {
+      pid_t pid = ::fork();
+      expect_false(pid == -1);
+      if (pid == 0)
+      {
+         ::execlp("sleep", "sleep", "10000", nullptr);
+         ::_exit(1);
+      }
+
+      ::usleep(200000);
+      ProcessTableSnapshot snapshot;
+      std::vector<SubprocInfo> children = snapshot.children(::getpid());
+      expect_true(exe(children, pid) == "sleep");
+
+      ::kill(pid, SIGKILL);
+      ::waitpid(pid, nullptr, 0);
+      expect_true(exe(snapshot.children(::getpid()), pid).empty());
+   }
+
+}
+
+} // namespace tests
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // __linux__
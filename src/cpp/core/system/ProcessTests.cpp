@@ -26,6 +26,11 @@
 #include <core/system/PosixSystem.hpp>
 #include <core/Thread.hpp>
 
+#ifdef __linux__
+#include <stdio.h>
+#include "ChildProcessReactor.hpp"
+#endif
+
 #include <tests/TestThat.hpp>
 
 namespace rstudio {
@@ -442,6 +447,153 @@ test_context("ProcessTests")
       // check to make sure all processes really exited
       CHECK(numExited == 10);
    }
+
+   test_that("ProcessSupervisor delivers output and exits of many staggered processes")
+   {
+      ProcessSupervisor supervisor;
+
+      const int numProcs = 100;
+      std::vector<int> exitCodes(numProcs, -1);
+      std::vector<std::string> outputs(numProcs);
+      for (int i = 0; i < numProcs; ++i)
+      {
+         ProcessOptions options;
+         ProcessCallbacks callbacks;
+         callbacks.onExit = boost::bind(&checkExitCode, _1, &exitCodes[i]);
+         callbacks.onStdout = boost::bind(&appendOutput, _2, &outputs[i]);
+
+         // write output both before and after a pause, and exit with
+         // differing statuses
+         std::string command = "echo start; sleep 0." + safe_convert::numberToString(i % 5) +
+                               "; echo " + safe_convert::numberToString(i) +
+                               "; exit " + safe_convert::numberToString(i % 3);
+         REQUIRE_FALSE(supervisor.runCommand(command, options, callbacks));
+      }
+
+      bool success = supervisor.wait(boost::posix_time::milliseconds(10),
+                                     boost::posix_time::seconds(30));
+      CHECK(success);
+
+      for (int i = 0; i < numProcs; ++i)
+      {
+         CHECK(exitCodes[i] == i % 3);
+         CHECK(outputs[i] == "start\n" + safe_convert::numberToString(i) + "\n");
+      }
+   }
+
+   test_that("ProcessSupervisor notices exits among idle processes")
+   {
+      ProcessSupervisor supervisor;
+
+      const int numIdle = 5;
+      int numIdleExited = 0;
+      for (int i = 0; i < numIdle; ++i)
+      {
+         ProcessCallbacks callbacks;
+         callbacks.onExit = [&numIdleExited](int) { ++numIdleExited; };
+         REQUIRE_FALSE(supervisor.runCommand("sleep 30", ProcessOptions(), callbacks));
+      }
+
+      int exitCode = -1;
+      std::string output;
+      ProcessCallbacks callbacks;
+      callbacks.onExit = boost::bind(&checkExitCode, _1, &exitCode);
+      callbacks.onStdout = boost::bind(&appendOutput, _2, &output);
+      REQUIRE_FALSE(supervisor.runCommand("sleep 0.2; echo done; exit 2", ProcessOptions(), callbacks));
+
+      // the busy child's output and exit are delivered while the others
+      // sit idle
+      boost::posix_time::ptime deadline =
+            boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(10);
+      while (exitCode == -1 && boost::posix_time::microsec_clock::universal_time() < deadline)
+      {
+         supervisor.poll();
+         boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+      }
+
+      CHECK(exitCode == 2);
+      CHECK(output == "done\n");
+      CHECK(numIdleExited == 0);
+      CHECK(supervisor.hasRunningChildren());
+
+      // exits of the idle children are noticed too
+      supervisor.terminateAll();
+      CHECK(supervisor.wait(boost::posix_time::milliseconds(10),
+                            boost::posix_time::seconds(10)));
+      CHECK(numIdleExited == numIdle);
+      CHECK_FALSE(supervisor.hasRunningChildren());
+   }
+
+   test_that("ProcessSupervisor can poll every child instead")
+   {
+      ProcessSupervisor supervisor(true);
+
+      const int numProcs = 20;
+      std::vector<int> exitCodes(numProcs, -1);
+      std::vector<std::string> outputs(numProcs);
+      for (int i = 0; i < numProcs; ++i)
+      {
+         ProcessCallbacks callbacks;
+         callbacks.onExit = boost::bind(&checkExitCode, _1, &exitCodes[i]);
+         callbacks.onStdout = boost::bind(&appendOutput, _2, &outputs[i]);
+
+         std::string command = "sleep 0." + safe_convert::numberToString(i % 3) +
+                               "; echo " + safe_convert::numberToString(i) +
+                               "; exit " + safe_convert::numberToString(i % 3);
+         REQUIRE_FALSE(supervisor.runCommand(command, ProcessOptions(), callbacks));
+      }
+
+      CHECK(supervisor.wait(boost::posix_time::milliseconds(10),
+                            boost::posix_time::seconds(30)));
+
+      for (int i = 0; i < numProcs; ++i)
+      {
+         CHECK(exitCodes[i] == i % 3);
+         CHECK(outputs[i] == safe_convert::numberToString(i) + "\n");
+      }
+   }
+
+#ifdef __linux__
+   test_that("ChildProcessReactor leaves output it can't watch to be polled")
+   {
+      ChildProcessReactor reactor;
+      REQUIRE_FALSE(reactor.initialize());
+
+      int pipeFds[2];
+      REQUIRE(::pipe(pipeFds) == 0);
+
+      // regular files can't be added to an epoll set
+      FILE* pFile = ::tmpfile();
+      REQUIRE(pFile != nullptr);
+
+      // (any process ids will do; we only need their pidfds)
+      PidType watched = ::getpid();
+      PidType polled = ::getppid();
+      reactor.watch(watched, { pipeFds[0] });
+      reactor.watch(polled, { ::fileno(pFile) });
+
+      CHECK(reactor.isWatching(watched));
+      CHECK(reactor.watchesOutput(watched));
+      CHECK(reactor.isWatching(polled));
+      CHECK_FALSE(reactor.watchesOutput(polled));
+      CHECK(reactor.watchesExit(polled) == reactor.watchesExit(watched));
+
+      // output is still reported for the child whose output is watched
+      REQUIRE(::write(pipeFds[1], "x", 1) == 1);
+      std::set<PidType> ready;
+      REQUIRE_FALSE(reactor.wait(boost::posix_time::seconds(5), &ready));
+      CHECK(ready.count(watched) == 1);
+      CHECK(ready.count(polled) == 0);
+
+      reactor.unwatch(watched);
+      reactor.unwatch(polled);
+      CHECK_FALSE(reactor.isWatching(watched));
+
+      ::fclose(pFile);
+      ::close(pipeFds[0]);
+      ::close(pipeFds[1]);
+   }
+#endif
 }
 
 } // end namespace tests
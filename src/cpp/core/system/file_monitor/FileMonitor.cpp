@@ -132,6 +132,79 @@ boost::function<bool(const FileInfo&)> excludeHiddenFilter()
 // helpers for platform-specific implementations
 namespace impl {
 
+namespace {
+
+// find the child of parentIt with the same path as fileInfo
+tree<FileInfo>::sibling_iterator findChild(tree<FileInfo>::iterator parentIt,
+                                           const FileInfo& fileInfo,
+                                           tree<FileInfo>* pTree,
+                                           const FileTreeIndex* pIndex)
+{
+   if (pIndex == nullptr)
+      return findFile(pTree->begin(parentIt), pTree->end(parentIt), fileInfo);
+
+   tree<FileInfo>::iterator it;
+   if (pIndex->find(fileInfo.absolutePath(), &it) &&
+       tree<FileInfo>::parent(it) == parentIt)
+   {
+      return it;
+   }
+
+   return pTree->end(parentIt);
+}
+
+// insert a child of parentIt at its sorted position (children are kept
+// sorted by path so that they can be compared with a fresh scan)
+tree<FileInfo>::iterator insertChild(tree<FileInfo>::iterator parentIt,
+                                     const FileInfo& fileInfo,
+                                     tree<FileInfo>* pTree)
+{
+   tree<FileInfo>::sibling_iterator it = pTree->begin(parentIt);
+   tree<FileInfo>::sibling_iterator end = pTree->end(parentIt);
+   while (it != end && fileInfoPathLessThan(*it, fileInfo))
+      ++it;
+
+   if (it == end)
+      return pTree->append_child(parentIt, fileInfo);
+   else
+      return pTree->insert(it, fileInfo);
+}
+
+} // anonymous namespace
+
+void FileTreeIndex::rebuild(tree<FileInfo>* pTree)
+{
+   nodes_.clear();
+   nodes_.reserve(pTree->size());
+   for (tree<FileInfo>::iterator it = pTree->begin(); it != pTree->end(); ++it)
+      nodes_[it->absolutePath()] = it;
+}
+
+bool FileTreeIndex::find(const std::string& path,
+                         tree<FileInfo>::iterator* pIt) const
+{
+   auto it = nodes_.find(path);
+   if (it == nodes_.end())
+      return false;
+
+   *pIt = it->second;
+   return true;
+}
+
+void FileTreeIndex::addSubtree(tree<FileInfo>::iterator it)
+{
+   nodes_[it->absolutePath()] = it;
+   for (tree<FileInfo>::sibling_iterator child = it.begin(); child != it.end(); ++child)
+      addSubtree(child);
+}
+
+void FileTreeIndex::removeSubtree(tree<FileInfo>::iterator it)
+{
+   nodes_.erase(it->absolutePath());
+   for (tree<FileInfo>::sibling_iterator child = it.begin(); child != it.end(); ++child)
+      removeSubtree(child);
+}
+
 Error processFileAdded(
               tree<FileInfo>::iterator parentIt,
               const FileChangeEvent& fileChange,
@@ -139,15 +212,17 @@ Error processFileAdded(
               const boost::function<bool(const FileInfo&)>& filter,
               const boost::function<Error(const FileInfo&)>& onBeforeScanDir,
               tree<FileInfo>* pTree,
-              std::vector<FileChangeEvent>* pFileChanges)
+              std::vector<FileChangeEvent>* pFileChanges,
+              FileTreeIndex* pIndex)
 {
    // see if this node already exists. if it does then check it for changes
    // (if there are no changes then ignore). we do this because some editors
    // (for example gedit) actually save files in such a way that FileAdded
    // is generated (because they overwrite the old file with a move)
-   tree<FileInfo>::sibling_iterator it = impl::findFile(pTree->begin(parentIt),
-                                                        pTree->end(parentIt),
-                                                        fileChange.fileInfo());
+   tree<FileInfo>::sibling_iterator it = findChild(parentIt,
+                                                   fileChange.fileInfo(),
+                                                   pTree,
+                                                   pIndex);
    if (it != pTree->end(parentIt))
    {
       if (fileChange.fileInfo() != *it)
@@ -175,10 +250,11 @@ Error processFileAdded(
          return error;
 
       // merge in the sub-tree
-      tree<FileInfo>::sibling_iterator addedIter =
-         pTree->append_child(parentIt, fileChange.fileInfo());
-      pTree->insert_subtree_after(addedIter, subTree.begin());
-      pTree->erase(addedIter);
+      tree<FileInfo>::iterator addedIter =
+         insertChild(parentIt, fileChange.fileInfo(), pTree);
+      addedIter = pTree->replace(addedIter, subTree.begin());
+      if (pIndex)
+         pIndex->addSubtree(addedIter);
 
       // generate events
       std::for_each(subTree.begin(),
@@ -190,29 +266,27 @@ Error processFileAdded(
    }
    else
    {
-      pTree->append_child(parentIt, fileChange.fileInfo());
+      tree<FileInfo>::iterator addedIter =
+         insertChild(parentIt, fileChange.fileInfo(), pTree);
+      if (pIndex)
+         pIndex->addSubtree(addedIter);
       pFileChanges->push_back(fileChange);
    }
 
-   // sort the container after insert
-   pTree->sort(pTree->begin(parentIt),
-               pTree->end(parentIt),
-               fileInfoPathLessThan,
-               false);
-
    return Success();
 }
 
 void processFileModified(tree<FileInfo>::iterator parentIt,
                          const FileChangeEvent& fileChange,
                          tree<FileInfo>* pTree,
-                         std::vector<FileChangeEvent>* pFileChanges)
+                         std::vector<FileChangeEvent>* pFileChanges,
+                         FileTreeIndex* pIndex)
 {
    // search for a child with this path
-   tree<FileInfo>::sibling_iterator modIt = impl::findFile(
-                                                     pTree->begin(parentIt),
-                                                     pTree->end(parentIt),
-                                                     fileChange.fileInfo());
+   tree<FileInfo>::sibling_iterator modIt = findChild(parentIt,
+                                                      fileChange.fileInfo(),
+                                                      pTree,
+                                                      pIndex);
 
    // only generate actions if the data is actually new (win32 file monitoring
    // can generate redundant modified events for save operations as well as
@@ -232,12 +306,14 @@ void processFileRemoved(tree<FileInfo>::iterator parentIt,
                         const FileChangeEvent& fileChange,
                         bool recursive,
                         tree<FileInfo>* pTree,
-                        std::vector<FileChangeEvent>* pFileChanges)
+                        std::vector<FileChangeEvent>* pFileChanges,
+                        FileTreeIndex* pIndex)
 {
    // search for a child with this path
-   tree<FileInfo>::sibling_iterator remIt = findFile(pTree->begin(parentIt),
-                                                     pTree->end(parentIt),
-                                                     fileChange.fileInfo());
+   tree<FileInfo>::sibling_iterator remIt = findChild(parentIt,
+                                                      fileChange.fileInfo(),
+                                                      pTree,
+                                                      pIndex);
 
    // only generate actions if the item was found in the tree
    if (remIt != pTree->end(parentIt))
@@ -264,6 +340,8 @@ void processFileRemoved(tree<FileInfo>::iterator parentIt,
       }
 
       // remove it from the tree
+      if (pIndex)
+         pIndex->removeSubtree(remIt);
       pTree->erase(remIt);
    }
 }
@@ -275,12 +353,20 @@ Error discoverAndProcessFileChanges(
    const boost::function<Error(const FileInfo&)>& onBeforeScanDir,
    tree<FileInfo>* pTree,
    const  boost::function<void(const std::vector<FileChangeEvent>&)>&
-                                                               onFilesChanged)
+                                                               onFilesChanged,
+   FileTreeIndex* pIndex)
 {
    // find this path in our fileTree
-   tree<FileInfo>::iterator it = std::find(pTree->begin(),
-                                           pTree->end(),
-                                           fileInfo);
+   tree<FileInfo>::iterator it;
+   if (pIndex)
+   {
+      if (!pIndex->find(fileInfo.absolutePath(), &it))
+         it = pTree->end();
+   }
+   else
+   {
+      it = std::find(pTree->begin(), pTree->end(), fileInfo);
+   }
 
    // if we don't find it then it may have been excluded by a filter, just bail
    if (it == pTree->end())
@@ -313,8 +399,13 @@ Error discoverAndProcessFileChanges(
       onFilesChanged(fileChanges);
 
       // wholesale replace subtree
-      pTree->insert_subtree_after(it, subdirTree.begin());
+      if (pIndex)
+         pIndex->removeSubtree(it);
+      tree<FileInfo>::iterator newIt =
+         pTree->insert_subtree_after(it, subdirTree.begin());
       pTree->erase(it);
+      if (pIndex)
+         pIndex->addSubtree(newIt);
    }
    else
    {
@@ -338,15 +429,17 @@ Error discoverAndProcessFileChanges(
                                            fileChange,
                                            recursive,
                                            filter,
+                                           boost::function<Error(const FileInfo&)>(),
                                            pTree,
-                                           &fileChanges);
+                                           &fileChanges,
+                                           pIndex);
             if (error)
                LOG_ERROR(error);
             break;
          }
          case FileChangeEvent::FileModified:
          {
-            processFileModified(it, fileChange, pTree, &fileChanges);
+            processFileModified(it, fileChange, pTree, &fileChanges, pIndex);
             break;
          }
          case FileChangeEvent::FileRemoved:
@@ -355,7 +448,8 @@ Error discoverAndProcessFileChanges(
                                fileChange,
                                recursive,
                                pTree,
-                               &fileChanges);
+                               &fileChanges,
+                               pIndex);
             break;
          }
          case FileChangeEvent::None:
@@ -0,0 +1,75 @@
+/*
+ * FileMonitorBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "FileMonitorImpl.hpp"
+
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+#include "FileMonitorTestTree.hpp"
+
+namespace rstudio {
+namespace core {
+namespace system {
+namespace file_monitor {
+namespace tests {
+
+using namespace boost::posix_time;
+
+// replay a storm of events against a large tree, locating each event's
+// directory by searching the tree (as was done previously) and with the index
+TEST_CASE("FileTreeIndex Benchmarks")
+{
+   const int kDirs = 10000;
+   const int kFiles = 4;
+   const int kEvents = 3000;
+
+   std::vector<StormEvent> storm = eventStorm(kDirs, kFiles, kEvents);
+
+   tree<FileInfo> searchedTree = createTree(kDirs, kFiles);
+   std::vector<FileChangeEvent> searchedEvents;
+   ptime start = microsec_clock::universal_time();
+   for (const StormEvent& event : storm)
+      processEvent(event.event, event.dir, &searchedTree, nullptr, &searchedEvents);
+   long searchedMs = (microsec_clock::universal_time() - start).total_milliseconds();
+
+   tree<FileInfo> indexedTree = createTree(kDirs, kFiles);
+   impl::FileTreeIndex index;
+   std::vector<FileChangeEvent> indexedEvents;
+   start = microsec_clock::universal_time();
+   index.rebuild(&indexedTree);
+   long rebuildMs = (microsec_clock::universal_time() - start).total_milliseconds();
+   for (const StormEvent& event : storm)
+      processEvent(event.event, event.dir, &indexedTree, &index, &indexedEvents);
+   long indexedMs = (microsec_clock::universal_time() - start).total_milliseconds();
+
+   CHECK(indexedEvents.size() == searchedEvents.size());
+
+   std::cout << "file monitor event storm (" << kEvents << " events, "
+             << indexedTree.size() << " files): "
+             << "searched " << searchedMs << "ms, "
+             << "indexed " << indexedMs << "ms "
+             << "(index built in " << rebuildMs << "ms)" << std::endl;
+}
+
+} // namespace tests
+} // namespace file_monitor
+} // namespace system
+} // namespace core
+} // namespace rstudio
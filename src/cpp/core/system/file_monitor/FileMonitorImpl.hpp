@@ -19,8 +19,10 @@
 #include <string>
 #include <algorithm>
 #include <list>
+#include <unordered_map>
 
 #include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <shared_core/FilePath.hpp>
 #include <core/collection/Tree.hpp>
@@ -35,6 +37,34 @@ namespace system {
 namespace file_monitor {
 namespace impl {
 
+// Index of the nodes of a monitored file tree by absolute path. Event
+// processing uses it to locate the node for a path directly rather than
+// searching the tree (which is linear in the number of monitored files).
+// Iterators into a tree remain valid until their node is erased, so the
+// index must be told about every subtree which is added to or erased from
+// the tree (processFileAdded and friends take care of this when they are
+// passed an index).
+class FileTreeIndex : boost::noncopyable
+{
+public:
+   // index every node of the tree
+   void rebuild(tree<FileInfo>* pTree);
+
+   void clear() { nodes_.clear(); }
+
+   std::size_t size() const { return nodes_.size(); }
+
+   // returns false if there's no node with this path
+   bool find(const std::string& path, tree<FileInfo>::iterator* pIt) const;
+
+   // add or remove a node along with all of its descendants
+   void addSubtree(tree<FileInfo>::iterator it);
+   void removeSubtree(tree<FileInfo>::iterator it);
+
+private:
+   std::unordered_map<std::string, tree<FileInfo>::iterator> nodes_;
+};
+
 Error processFileAdded(
                tree<FileInfo>::iterator parentIt,
                const FileChangeEvent& fileChange,
@@ -42,7 +72,8 @@ Error processFileAdded(
                const boost::function<bool(const FileInfo&)>& filter,
                const boost::function<Error(const FileInfo&)>& onBeforeScanDir,
                tree<FileInfo>* pTree,
-               std::vector<FileChangeEvent>* pFileChanges);
+               std::vector<FileChangeEvent>* pFileChanges,
+               FileTreeIndex* pIndex = nullptr);
 
 inline Error processFileAdded(
                tree<FileInfo>::iterator parentIt,
@@ -64,13 +95,15 @@ inline Error processFileAdded(
 void processFileModified(tree<FileInfo>::iterator parentIt,
                          const FileChangeEvent& fileChange,
                          tree<FileInfo>* pTree,
-                         std::vector<FileChangeEvent>* pFileChanges);
+                         std::vector<FileChangeEvent>* pFileChanges,
+                         FileTreeIndex* pIndex = nullptr);
 
 void processFileRemoved(tree<FileInfo>::iterator parentIt,
                         const FileChangeEvent& fileChange,
                         bool recursive,
                         tree<FileInfo>* pTree,
-                        std::vector<FileChangeEvent>* pFileChanges);
+                        std::vector<FileChangeEvent>* pFileChanges,
+                        FileTreeIndex* pIndex = nullptr);
 
 Error discoverAndProcessFileChanges(
    const FileInfo& fileInfo,
@@ -79,7 +112,8 @@ Error discoverAndProcessFileChanges(
    const boost::function<Error(const FileInfo&)>& onBeforeScanDir,
    tree<FileInfo>* pTree,
    const boost::function<void(const std::vector<FileChangeEvent>&)>&
-                                                            onFilesChanged);
+                                                            onFilesChanged,
+   FileTreeIndex* pIndex = nullptr);
 
 inline Error discoverAndProcessFileChanges(
    const FileInfo& fileInfo,
@@ -0,0 +1,151 @@
+/*
+ * FileMonitorTestTree.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// trees and event storms shared by the file monitor tests and benchmarks
+// (include after tests/TestThat.hpp)
+
+#ifndef CORE_SYSTEM_FILE_MONITOR_TEST_TREE_HPP
+#define CORE_SYSTEM_FILE_MONITOR_TEST_TREE_HPP
+
+#include "FileMonitorImpl.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace rstudio {
+namespace core {
+namespace system {
+namespace file_monitor {
+namespace tests {
+
+// the monitored root doesn't exist; none of the events below require
+// reading from the filesystem
+const char* const kRoot = "/rstudio-file-monitor-tests";
+
+inline std::string dirPath(int dir)
+{
+   char name[32];
+   std::snprintf(name, sizeof(name), "/dir%05d", dir);
+   return kRoot + std::string(name);
+}
+
+inline std::string filePath(int dir, int file)
+{
+   return dirPath(dir) + "/file" + std::to_string(file) + ".R";
+}
+
+inline FileInfo fileInfo(int dir, int file, uintmax_t size = 10)
+{
+   return FileInfo(filePath(dir, file), false, size, 100);
+}
+
+inline tree<FileInfo> createTree(int dirs, int filesPerDir)
+{
+   tree<FileInfo> fileTree;
+   tree<FileInfo>::iterator rootIt = fileTree.set_head(FileInfo(kRoot, true));
+   for (int dir = 0; dir < dirs; dir++)
+   {
+      tree<FileInfo>::iterator dirIt =
+            fileTree.append_child(rootIt, FileInfo(dirPath(dir), true));
+      for (int file = 0; file < filesPerDir; file++)
+         fileTree.append_child(dirIt, fileInfo(dir, file));
+   }
+   return fileTree;
+}
+
+inline std::vector<std::string> treePaths(const tree<FileInfo>& fileTree)
+{
+   std::vector<std::string> paths;
+   for (auto it = fileTree.begin(); it != fileTree.end(); ++it)
+      paths.push_back(it->absolutePath());
+   return paths;
+}
+
+inline tree<FileInfo>::iterator findDir(const tree<FileInfo>& fileTree, int dir)
+{
+   return impl::findFile(fileTree.begin(), fileTree.end(), dirPath(dir));
+}
+
+// apply an event to the child of the given directory, locating the
+// directory either with the index or by searching the tree
+inline void processEvent(const FileChangeEvent& event,
+                  int dir,
+                  tree<FileInfo>* pTree,
+                  impl::FileTreeIndex* pIndex,
+                  std::vector<FileChangeEvent>* pEvents)
+{
+   tree<FileInfo>::iterator parentIt;
+   if (pIndex)
+      REQUIRE(pIndex->find(dirPath(dir), &parentIt));
+   else
+      parentIt = findDir(*pTree, dir);
+
+   switch (event.type())
+   {
+      case FileChangeEvent::FileAdded:
+         REQUIRE_FALSE(impl::processFileAdded(parentIt,
+                                              event,
+                                              true,
+                                              boost::function<bool(const FileInfo&)>(),
+                                              boost::function<Error(const FileInfo&)>(),
+                                              pTree,
+                                              pEvents,
+                                              pIndex));
+         break;
+      case FileChangeEvent::FileModified:
+         impl::processFileModified(parentIt, event, pTree, pEvents, pIndex);
+         break;
+      case FileChangeEvent::FileRemoved:
+         impl::processFileRemoved(parentIt, event, true, pTree, pEvents, pIndex);
+         break;
+      case FileChangeEvent::None:
+         break;
+   }
+}
+
+// a burst of changes to files scattered throughout the tree (e.g. from
+// a build or a checkout)
+struct StormEvent
+{
+   int dir;
+   FileChangeEvent event;
+};
+
+inline std::vector<StormEvent> eventStorm(int dirs, int filesPerDir, int count)
+{
+   const FileChangeEvent::Type types[] = { FileChangeEvent::FileAdded,
+                                           FileChangeEvent::FileModified,
+                                           FileChangeEvent::FileRemoved };
+
+   std::minstd_rand rng(42);
+   std::vector<StormEvent> events;
+   for (int i = 0; i < count; i++)
+   {
+      int dir = static_cast<int>(rng() % dirs);
+      int file = static_cast<int>(rng() % (filesPerDir + 2));
+      events.push_back({ dir, FileChangeEvent(types[i % 3], fileInfo(dir, file, i)) });
+   }
+   return events;
+}
+
+} // namespace tests
+} // namespace file_monitor
+} // namespace system
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_SYSTEM_FILE_MONITOR_TEST_TREE_HPP
@@ -0,0 +1,206 @@
+/*
+ * FileMonitorTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "FileMonitorImpl.hpp"
+
+#include <core/FileSerializer.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+#include "FileMonitorTestTree.hpp"
+
+namespace rstudio {
+namespace core {
+namespace system {
+namespace file_monitor {
+namespace tests {
+
+TEST_CASE("FileTreeIndex")
+{
+   SECTION("Indexes every node of the tree")
+   {
+      tree<FileInfo> fileTree = createTree(10, 5);
+      impl::FileTreeIndex index;
+      index.rebuild(&fileTree);
+
+      CHECK(index.size() == fileTree.size());
+      for (auto it = fileTree.begin(); it != fileTree.end(); ++it)
+      {
+         tree<FileInfo>::iterator found;
+         REQUIRE(index.find(it->absolutePath(), &found));
+         CHECK(found == it);
+      }
+
+      tree<FileInfo>::iterator found;
+      CHECK_FALSE(index.find(filePath(10, 0), &found));
+   }
+
+   SECTION("Added files are indexed at their sorted position")
+   {
+      tree<FileInfo> fileTree = createTree(3, 0);
+      impl::FileTreeIndex index;
+      index.rebuild(&fileTree);
+
+      std::vector<FileChangeEvent> events;
+      for (int file : { 3, 1, 4, 0, 2 })
+      {
+         FileChangeEvent event(FileChangeEvent::FileAdded, fileInfo(1, file));
+         processEvent(event, 1, &fileTree, &index, &events);
+      }
+      CHECK(events.size() == 5);
+
+      tree<FileInfo>::iterator dirIt = findDir(fileTree, 1);
+      std::vector<std::string> children;
+      for (auto it = fileTree.begin(dirIt); it != fileTree.end(dirIt); ++it)
+         children.push_back(it->absolutePath());
+      CHECK(children == std::vector<std::string>({ filePath(1, 0), filePath(1, 1),
+                                                   filePath(1, 2), filePath(1, 3),
+                                                   filePath(1, 4) }));
+
+      tree<FileInfo>::iterator found;
+      REQUIRE(index.find(filePath(1, 4), &found));
+      CHECK(tree<FileInfo>::parent(found) == dirIt);
+
+      // adding an existing file with new attributes reports a modification
+      events.clear();
+      processEvent(FileChangeEvent(FileChangeEvent::FileAdded, fileInfo(1, 4, 20)),
+                   1, &fileTree, &index, &events);
+      REQUIRE(events.size() == 1);
+      CHECK(events[0].type() == FileChangeEvent::FileModified);
+      CHECK(fileTree.number_of_children(dirIt) == 5);
+      CHECK(index.size() == fileTree.size());
+   }
+
+   SECTION("Only children of the event's directory are matched")
+   {
+      tree<FileInfo> fileTree = createTree(3, 2);
+      impl::FileTreeIndex index;
+      index.rebuild(&fileTree);
+
+      // a path from another directory is not a child of this one
+      std::vector<FileChangeEvent> events;
+      tree<FileInfo>::iterator dirIt;
+      REQUIRE(index.find(dirPath(0), &dirIt));
+      impl::processFileRemoved(dirIt,
+                               FileChangeEvent(FileChangeEvent::FileRemoved, fileInfo(1, 0)),
+                               true,
+                               &fileTree,
+                               &events,
+                               &index);
+      CHECK(events.empty());
+      CHECK(index.size() == fileTree.size());
+   }
+
+   SECTION("Removing a directory removes its contents from the index")
+   {
+      tree<FileInfo> fileTree = createTree(3, 4);
+      impl::FileTreeIndex index;
+      index.rebuild(&fileTree);
+
+      std::vector<FileChangeEvent> events;
+      impl::processFileRemoved(fileTree.begin(),
+                               FileChangeEvent(FileChangeEvent::FileRemoved,
+                                               FileInfo(dirPath(1), true)),
+                               true,
+                               &fileTree,
+                               &events,
+                               &index);
+
+      CHECK(events.size() == 5);
+      CHECK(index.size() == fileTree.size());
+
+      tree<FileInfo>::iterator found;
+      CHECK_FALSE(index.find(dirPath(1), &found));
+      CHECK_FALSE(index.find(filePath(1, 2), &found));
+      CHECK(index.find(filePath(2, 2), &found));
+   }
+
+   SECTION("Added directories are indexed along with their contents")
+   {
+      FilePath root;
+      REQUIRE_FALSE(FilePath::tempFilePath(root));
+      FilePath subdir = root.completeChildPath("sub");
+      REQUIRE_FALSE(subdir.completeChildPath("nested").ensureDirectory());
+      REQUIRE_FALSE(writeStringToFile(subdir.completeChildPath("a.R"), "a"));
+      REQUIRE_FALSE(writeStringToFile(subdir.completeChildPath("nested/b.R"), "b"));
+
+      tree<FileInfo> fileTree;
+      fileTree.set_head(FileInfo(root));
+      impl::FileTreeIndex index;
+      index.rebuild(&fileTree);
+
+      std::vector<FileChangeEvent> events;
+      REQUIRE_FALSE(impl::processFileAdded(fileTree.begin(),
+                                           FileChangeEvent(FileChangeEvent::FileAdded,
+                                                           FileInfo(subdir)),
+                                           true,
+                                           boost::function<bool(const FileInfo&)>(),
+                                           boost::function<Error(const FileInfo&)>(),
+                                           &fileTree,
+                                           &events,
+                                           &index));
+
+      CHECK(events.size() == 4);
+      CHECK(fileTree.size() == 5);
+      CHECK(index.size() == fileTree.size());
+
+      tree<FileInfo>::iterator found;
+      REQUIRE(index.find(subdir.completeChildPath("nested/b.R").getAbsolutePath(), &found));
+      CHECK(tree<FileInfo>::parent(found)->absolutePath() ==
+            subdir.completeChildPath("nested").getAbsolutePath());
+      REQUIRE(index.find(subdir.getAbsolutePath(), &found));
+      CHECK(tree<FileInfo>::parent(found) == fileTree.begin());
+
+      root.removeIfExists();
+   }
+
+   SECTION("Indexed processing matches searching the tree")
+   {
+      const int kDirs = 50;
+      const int kFiles = 4;
+      tree<FileInfo> searchedTree = createTree(kDirs, kFiles);
+      tree<FileInfo> indexedTree = createTree(kDirs, kFiles);
+      impl::FileTreeIndex index;
+      index.rebuild(&indexedTree);
+
+      std::vector<FileChangeEvent> searchedEvents;
+      std::vector<FileChangeEvent> indexedEvents;
+      for (const StormEvent& storm : eventStorm(kDirs, kFiles, 2000))
+      {
+         processEvent(storm.event, storm.dir, &searchedTree, nullptr, &searchedEvents);
+         processEvent(storm.event, storm.dir, &indexedTree, &index, &indexedEvents);
+      }
+
+      REQUIRE(indexedEvents.size() == searchedEvents.size());
+      for (std::size_t i = 0; i < indexedEvents.size(); i++)
+      {
+         CHECK(indexedEvents[i].type() == searchedEvents[i].type());
+         CHECK(indexedEvents[i].fileInfo() == searchedEvents[i].fileInfo());
+      }
+
+      CHECK(treePaths(indexedTree) == treePaths(searchedTree));
+      CHECK(index.size() == indexedTree.size());
+   }
+}
+
+} // namespace tests
+} // namespace file_monitor
+} // namespace system
+} // namespace core
+} // namespace rstudio
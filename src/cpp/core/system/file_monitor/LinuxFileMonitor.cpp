@@ -48,6 +48,9 @@ namespace file_monitor {
 
 namespace {
 
+// threads used to scan directories when a monitor is registered
+const std::size_t kScanThreads = 4;
+
 struct Watch
 {
    Watch()
@@ -175,6 +178,7 @@ public:
    bool recursive;
    boost::function<bool(const FileInfo&)> filter;
    tree<FileInfo> fileTree;
+   impl::FileTreeIndex fileIndex;
    Callbacks callbacks;
 };
 
@@ -311,15 +315,11 @@ Error processEvent(FileEventContext* pContext,
       if (watch.empty())
          return Success();
 
-      // get an iterator to the parent dir
-      tree<FileInfo>::iterator parentIt = impl::findFile(
-                                                   pContext->fileTree.begin(),
-                                                   pContext->fileTree.end(),
-                                                   watch.path);
-
-      // if we can't find a parent then return (this directory may have
-      // been excluded from scanning due to a filter)
-      if (parentIt == pContext->fileTree.end())
+      // get an iterator to the parent dir -- if we can't find a parent then
+      // return (this directory may have been excluded from scanning due to
+      // a filter)
+      tree<FileInfo>::iterator parentIt;
+      if (!pContext->fileIndex.find(watch.path, &parentIt))
          return Success();
 
       // get file info
@@ -355,7 +355,8 @@ Error processEvent(FileEventContext* pContext,
                                      event,
                                      pContext->recursive,
                                      &pContext->fileTree,
-                                     &removeEvents);
+                                     &removeEvents,
+                                     &pContext->fileIndex);
 
             // for each directory remove event remove any watches we have for it
             for (const FileChangeEvent& event : removeEvents)
@@ -388,7 +389,8 @@ Error processEvent(FileEventContext* pContext,
                                                  pContext->filter,
                                                  addWatchFunction(pContext),
                                                  &pContext->fileTree,
-                                                 pFileChanges);
+                                                 pFileChanges,
+                                                 &pContext->fileIndex);
             // log the error if it wasn't no such file/dir (this can happen
             // in the normal course of business if a file is deleted between
             // the time the change is detected and we try to inspect it)
@@ -405,7 +407,8 @@ Error processEvent(FileEventContext* pContext,
             impl::processFileModified(parentIt,
                                       event,
                                       &pContext->fileTree,
-                                      pFileChanges);
+                                      pFileChanges,
+                                      &pContext->fileIndex);
             break;
          }
          case FileChangeEvent::None:
@@ -481,6 +484,12 @@ Handle registerMonitor(const core::FilePath& filePath,
    options.yield = true;
    options.filter = filter;
    options.onBeforeScanDir = addWatchFunction(pContext, true);
+
+   // read directories concurrently; scanning is dominated by waiting on
+   // the filesystem (particularly for large trees on network drives)
+   if (recursive)
+      options.threads = kScanThreads;
+
    Error error = scanFiles(FileInfo(filePath), options, &pContext->fileTree);
    if (error)
    {
@@ -492,6 +501,9 @@ Handle registerMonitor(const core::FilePath& filePath,
        return Handle();
    }
 
+   // index the tree so events can find their parent directory directly
+   pContext->fileIndex.rebuild(&pContext->fileTree);
+
    // now that we have finished the file listing we know we have a valid
    // file-monitor so set the callbacks
    pContext->callbacks = callbacks;
@@ -608,7 +620,8 @@ void run(const boost::function<void()>& checkForInput)
                         pContext->filter,
                         addWatchFunction(pContext, true),
                         &pContext->fileTree,
-                        pContext->callbacks.onFilesChanged);
+                        pContext->callbacks.onFilesChanged,
+                        &pContext->fileIndex);
                   if (error)
                      terminateWithMonitoringError(pContext, error);
 
@@ -0,0 +1,444 @@
+/*
+ * ScrollbackLog.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/terminal/ScrollbackLog.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/SafeConvert.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+
+namespace rstudio {
+namespace core {
+namespace terminal {
+
+namespace {
+
+// buffered output is written once it reaches this size (even if it isn't
+// time to flush yet)
+const std::size_t kMaxPendingSize = 64 * 1024;
+
+std::size_t countLines(const std::string& text, std::size_t begin, std::size_t end)
+{
+   return std::count(text.begin() + begin, text.begin() + end, '\n');
+}
+
+} // anonymous namespace
+
+ScrollbackLog::ScrollbackLog(const FilePath& dir,
+                             const std::string& name,
+                             std::size_t segmentSize,
+                             std::size_t maxSize)
+   : dir_(dir),
+     name_(name),
+     segmentSize_(segmentSize),
+     maxSize_(maxSize),
+     headSize_(0),
+     headLines_(0)
+{
+}
+
+Error ScrollbackLog::open()
+{
+   segments_.clear();
+   headSize_ = 0;
+   headLines_ = 0;
+
+   // the index holds the size of the trimmed head followed by the number,
+   // size and line count of each segment
+   std::vector<Segment> indexed;
+   if (indexPath().exists())
+   {
+      std::string contents;
+      Error error = readStringFromFile(indexPath(), &contents);
+      if (error)
+         return error;
+
+      std::istringstream is(contents);
+      is >> headSize_ >> headLines_;
+      Segment segment;
+      while (is >> segment.number >> segment.size >> segment.lines)
+         indexed.push_back(segment);
+   }
+
+   // without an index, look for segments in the directory (the oldest of
+   // which needn't be the first written)
+   if (indexed.empty())
+   {
+      std::vector<FilePath> children;
+      Error error = dir_.getChildren(children);
+      if (error)
+         return error;
+
+      std::string prefix = name_ + ".";
+      std::vector<std::size_t> numbers;
+      for (const FilePath& child : children)
+      {
+         std::string filename = child.getFilename();
+         if (boost::algorithm::starts_with(filename, prefix) &&
+             filename.size() > prefix.size() &&
+             filename.find_first_not_of("0123456789", prefix.size()) == std::string::npos)
+         {
+            numbers.push_back(safe_convert::stringTo<std::size_t>(filename.substr(prefix.size()), 0));
+         }
+      }
+
+      std::sort(numbers.begin(), numbers.end());
+      for (std::size_t number : numbers)
+      {
+         Segment segment;
+         segment.number = number;
+         segment.size = 0;
+         segment.lines = 0;
+         indexed.push_back(segment);
+      }
+   }
+
+   // segments written after the index was last updated are picked up too
+   std::size_t next = indexed.empty() ? 0 : indexed.back().number + 1;
+   while (segmentPath(next).exists())
+   {
+      Segment segment;
+      segment.number = next++;
+      segment.size = 0;
+      segment.lines = 0;
+      indexed.push_back(segment);
+   }
+
+   for (Segment segment : indexed)
+   {
+      FilePath path = segmentPath(segment.number);
+      if (!path.exists())
+         continue;
+
+      // count the lines again in a segment that's changed since it was
+      // indexed (typically the newest, which is still being appended to)
+      std::size_t size = static_cast<std::size_t>(path.getSize());
+      if (size != segment.size)
+      {
+         std::string contents;
+         Error error = readSegment(segment, &contents);
+         if (error)
+            return error;
+         segment.size = contents.size();
+         segment.lines = countLines(contents, 0, contents.size());
+      }
+      segments_.push_back(segment);
+   }
+
+   if (segments_.empty() ||
+       segments_.front().number != (indexed.empty() ? 0 : indexed.front().number) ||
+       headSize_ > segments_.front().size)
+   {
+      headSize_ = 0;
+      headLines_ = 0;
+   }
+
+   return Success();
+}
+
+Error ScrollbackLog::append(const std::string& output)
+{
+   pending_.append(output);
+   if (pending_.size() >= kMaxPendingSize)
+      return flush();
+   return Success();
+}
+
+Error ScrollbackLog::flush()
+{
+   if (pending_.empty())
+      return Success();
+
+   bool segmentsChanged = false;
+   std::size_t written = 0;
+   while (written < pending_.size())
+   {
+      if (segments_.empty() || segments_.back().size >= segmentSize_)
+      {
+         Segment segment;
+         segment.number = segments_.empty() ? 0 : segments_.back().number + 1;
+         segment.size = 0;
+         segment.lines = 0;
+         segments_.push_back(segment);
+         segmentsChanged = true;
+      }
+
+      Segment& segment = segments_.back();
+      std::size_t count = std::min(segmentSize_ - segment.size, pending_.size() - written);
+      Error error = appendToFile(segmentPath(segment.number), pending_.substr(written, count));
+      if (error)
+      {
+         pending_.erase(0, written);
+         return error;
+      }
+
+      segment.size += count;
+      segment.lines += countLines(pending_, written, written + count);
+      written += count;
+   }
+   pending_.clear();
+
+   // drop the oldest output once we're over our size limit
+   while (segments_.size() > 1 && size() > maxSize_)
+   {
+      Error error = dropOldestSegment();
+      if (error)
+         return error;
+      segmentsChanged = true;
+   }
+
+   if (segmentsChanged)
+      return writeIndex();
+
+   return Success();
+}
+
+std::size_t ScrollbackLog::size() const
+{
+   std::size_t size = pending_.size() - headSize_;
+   for (const Segment& segment : segments_)
+      size += segment.size;
+   return size;
+}
+
+std::size_t ScrollbackLog::lineCount() const
+{
+   std::size_t lines = countLines(pending_, 0, pending_.size()) - headLines_;
+   for (const Segment& segment : segments_)
+      lines += segment.lines;
+   return lines;
+}
+
+Error ScrollbackLog::trimLeadingLines(std::size_t maxLines, bool* pTrimmed)
+{
+   if (pTrimmed)
+      *pTrimmed = false;
+
+   Error error = flush();
+   if (error)
+      return error;
+
+   std::size_t lines = lineCount();
+   if (size() <= maxLines * 2 || lines <= maxLines)
+      return Success();
+
+   // the log will start at this newline (counting from one)
+   std::size_t target = lines - maxLines;
+
+   // find the segment it's in using the index
+   std::size_t index = 0;
+   std::size_t seen = 0;
+   for (; index < segments_.size(); index++)
+   {
+      std::size_t segmentLines = segments_[index].lines - (index == 0 ? headLines_ : 0);
+      if (seen + segmentLines >= target)
+         break;
+      seen += segmentLines;
+   }
+
+   std::string contents;
+   error = readSegment(segments_[index], &contents);
+   if (error)
+      return error;
+
+   std::size_t pos = index == 0 ? headSize_ : 0;
+   for (;; pos++)
+   {
+      pos = contents.find('\n', pos);
+      if (pos == std::string::npos)
+         return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+      if (++seen == target)
+         break;
+   }
+
+   for (std::size_t i = 0; i < index; i++)
+   {
+      error = dropOldestSegment();
+      if (error)
+         return error;
+   }
+
+   headSize_ = pos;
+   headLines_ = countLines(contents, 0, pos);
+   if (pTrimmed)
+      *pTrimmed = true;
+
+   return writeIndex();
+}
+
+Error ScrollbackLog::read(std::size_t offset, std::size_t length, std::string* pOutput)
+{
+   pOutput->clear();
+
+   Error error = flush();
+   if (error)
+      return error;
+
+   std::size_t total = size();
+   if (offset >= total)
+      return Success();
+
+   std::size_t begin = headSize_ + offset;
+   std::size_t end = begin + std::min(length, total - offset);
+
+   std::size_t segmentBegin = 0;
+   for (const Segment& segment : segments_)
+   {
+      std::size_t segmentEnd = segmentBegin + segment.size;
+      if (segmentEnd > begin && segmentBegin < end)
+      {
+         std::size_t from = std::max(begin, segmentBegin);
+         std::size_t count = std::min(end, segmentEnd) - from;
+
+         std::shared_ptr<std::istream> pStream;
+         error = segmentPath(segment.number).openForRead(pStream);
+         if (error)
+            return error;
+
+         std::string buffer(count, '\0');
+         pStream->seekg(from - segmentBegin);
+         pStream->read(&buffer[0], count);
+         if (static_cast<std::size_t>(pStream->gcount()) != count)
+            return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+         pOutput->append(buffer);
+      }
+
+      segmentBegin = segmentEnd;
+      if (segmentBegin >= end)
+         break;
+   }
+
+   return Success();
+}
+
+Error ScrollbackLog::readAll(std::string* pOutput)
+{
+   return read(0, size(), pOutput);
+}
+
+Error ScrollbackLog::removeLastLine()
+{
+   Error error = flush();
+   if (error)
+      return error;
+
+   while (!segments_.empty())
+   {
+      Segment& segment = segments_.back();
+      std::size_t start = segments_.size() == 1 ? headSize_ : 0;
+      if (segment.lines > (segments_.size() == 1 ? headLines_ : 0))
+      {
+         std::string contents;
+         error = readSegment(segment, &contents);
+         if (error)
+            return error;
+
+         std::size_t lastNewline = contents.find_last_of('\n');
+         if (lastNewline != std::string::npos && lastNewline >= start)
+         {
+            contents.erase(lastNewline + 1);
+            error = writeStringToFile(segmentPath(segment.number), contents);
+            if (error)
+               return error;
+
+            segment.size = contents.size();
+            return writeIndex();
+         }
+      }
+
+      error = removeNewestSegment();
+      if (error)
+         return error;
+   }
+
+   // no complete line, so nothing is left
+   return remove();
+}
+
+Error ScrollbackLog::remove()
+{
+   pending_.clear();
+   while (!segments_.empty())
+   {
+      Error error = removeNewestSegment();
+      if (error)
+         return error;
+   }
+   headSize_ = 0;
+   headLines_ = 0;
+   return indexPath().removeIfExists();
+}
+
+FilePath ScrollbackLog::segmentPath(std::size_t number) const
+{
+   return dir_.completeChildPath(name_ + "." + safe_convert::numberToString(number));
+}
+
+FilePath ScrollbackLog::indexPath() const
+{
+   return dir_.completeChildPath(name_ + ".index");
+}
+
+Error ScrollbackLog::readSegment(const Segment& segment, std::string* pContents) const
+{
+   return readStringFromFile(segmentPath(segment.number), pContents);
+}
+
+Error ScrollbackLog::writeIndex() const
+{
+   std::ostringstream os;
+   os << headSize_ << " " << headLines_ << "\n";
+   for (const Segment& segment : segments_)
+      os << segment.number << " " << segment.size << " " << segment.lines << "\n";
+   return writeStringToFile(indexPath(), os.str());
+}
+
+Error ScrollbackLog::dropOldestSegment()
+{
+   Error error = segmentPath(segments_.front().number).removeIfExists();
+   if (error)
+      return error;
+
+   segments_.pop_front();
+   headSize_ = 0;
+   headLines_ = 0;
+   return Success();
+}
+
+Error ScrollbackLog::removeNewestSegment()
+{
+   Error error = segmentPath(segments_.back().number).removeIfExists();
+   if (error)
+      return error;
+
+   segments_.pop_back();
+   if (segments_.empty())
+   {
+      headSize_ = 0;
+      headLines_ = 0;
+   }
+   return Success();
+}
+
+} // namespace terminal
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,239 @@
+/*
+ * ScrollbackLogTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/terminal/ScrollbackLog.hpp>
+
+#include <shared_core/Error.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/StringUtils.hpp>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace terminal {
+namespace tests {
+
+namespace {
+
+// output of varying lengths, some of it without newlines
+std::string output(int i)
+{
+   std::string text = "line " + std::to_string(i);
+   if (i % 7 == 0)
+      text += std::string(i % 150, 'x');
+   if (i % 5 != 0)
+      text += "\n";
+   return text;
+}
+
+std::string readAll(ScrollbackLog& log)
+{
+   std::string contents;
+   expect_false(log.readAll(&contents));
+   return contents;
+}
+
+} // anonymous namespace
+
+test_context("ScrollbackLog")
+{
+   FilePath dir;
+   FilePath::tempFilePath(dir);
+   dir.ensureDirectory();
+
+   test_that("Output spanning many segments is read back in full and in ranges")
+   {
+      ScrollbackLog log(dir, "terminal", 100);
+      expect_false(log.open());
+
+      std::string expected;
+      for (int i = 0; i < 500; i++)
+      {
+         expect_false(log.append(output(i)));
+         expected += output(i);
+         if (i % 50 == 0)
+            expect_false(log.flush());
+      }
+
+      expect_true(log.size() == expected.size());
+      expect_true(log.lineCount() == string_utils::countNewlines(expected));
+      expect_true(readAll(log) == expected);
+
+      std::string range;
+      for (std::size_t offset = 0; offset < expected.size(); offset += 333)
+      {
+         expect_false(log.read(offset, 256, &range));
+         expect_true(range == expected.substr(offset, 256));
+      }
+      expect_false(log.read(expected.size(), 10, &range));
+      expect_true(range.empty());
+   }
+
+   test_that("Trimming leading lines matches trimming the whole buffer")
+   {
+      for (std::size_t maxLines : { 1, 10, 100, 1000 })
+      {
+         ScrollbackLog log(dir, "trim" + std::to_string(maxLines), 128);
+         expect_false(log.open());
+
+         std::string expected;
+         for (int round = 0; round < 3; round++)
+         {
+            for (int i = 0; i < 400; i++)
+            {
+               log.append(output(i));
+               expected += output(i);
+            }
+
+            bool trimmed;
+            expect_false(log.trimLeadingLines(maxLines, &trimmed));
+            expect_true(trimmed == string_utils::trimLeadingLines(maxLines, &expected));
+            expect_true(readAll(log) == expected);
+            expect_true(log.lineCount() == string_utils::countNewlines(expected));
+         }
+
+         // the trimmed log is reopened as it was
+         ScrollbackLog reopened(dir, "trim" + std::to_string(maxLines), 128);
+         expect_false(reopened.open());
+         expect_true(readAll(reopened) == expected);
+         expect_true(reopened.lineCount() == log.lineCount());
+      }
+   }
+
+   test_that("The last line can be removed")
+   {
+      ScrollbackLog log(dir, "lastLine", 16);
+      expect_false(log.open());
+
+      std::string prompt(40, '$');
+      log.append("first line\nsecond line\n" + prompt);
+      expect_false(log.removeLastLine());
+      expect_true(readAll(log) == "first line\nsecond line\n");
+
+      expect_false(log.removeLastLine());
+      expect_true(readAll(log) == "first line\nsecond line\n");
+
+      ScrollbackLog noNewline(dir, "noNewline", 16);
+      expect_false(noNewline.open());
+      noNewline.append(prompt);
+      expect_false(noNewline.removeLastLine());
+      expect_true(readAll(noNewline).empty());
+      expect_false(dir.completeChildPath("noNewline.0").exists());
+   }
+
+   test_that("Old output is dropped once the log reaches its maximum size")
+   {
+      ScrollbackLog log(dir, "ring", 1024, 8 * 1024);
+      expect_false(log.open());
+
+      std::string expected;
+      for (int i = 0; i < 5000; i++)
+      {
+         log.append(output(i));
+         expected += output(i);
+      }
+      expect_false(log.flush());
+
+      expect_true(log.size() <= 8 * 1024);
+      expect_true(log.size() > 7 * 1024);
+      std::string contents = readAll(log);
+      expect_true(contents == expected.substr(expected.size() - contents.size()));
+
+      // written output isn't lost if the log isn't reopened cleanly (e.g.
+      // the session crashed before the index was updated)
+      log.append("more output\n");
+      expect_false(log.flush());
+      dir.completeChildPath("ring.index").remove();
+      ScrollbackLog reopened(dir, "ring", 1024, 8 * 1024);
+      expect_false(reopened.open());
+      expect_true(readAll(reopened).find("more output\n") != std::string::npos);
+   }
+
+   test_that("Removed logs are empty")
+   {
+      ScrollbackLog log(dir, "removed", 64);
+      expect_false(log.open());
+      log.append(output(1) + output(2) + output(3));
+      expect_false(log.flush());
+      expect_false(log.remove());
+      expect_true(log.size() == 0);
+
+      ScrollbackLog reopened(dir, "removed", 64);
+      expect_false(reopened.open());
+      expect_true(readAll(reopened).empty());
+   }
+
+   test_that("Output rotates through segments which trimming drops whole")
+   {
+      // fifty ten byte lines fill five segments
+      std::string expected;
+      ScrollbackLog log(dir, "rotate", 100);
+      expect_false(log.open());
+      for (int i = 0; i < 50; i++)
+      {
+         std::string line = "line " + std::to_string(1000 + i) + "\n";
+         log.append(line);
+         expected += line;
+      }
+      expect_false(log.flush());
+      for (int i = 0; i < 5; i++)
+         expect_true(dir.completeChildPath("rotate." + std::to_string(i)).getSize() == 100);
+      expect_false(dir.completeChildPath("rotate.5").exists());
+
+      // keeping the last 15 lines only needs the last two segments
+      expect_false(log.trimLeadingLines(15));
+      string_utils::trimLeadingLines(15, &expected);
+      for (int i = 0; i < 3; i++)
+         expect_false(dir.completeChildPath("rotate." + std::to_string(i)).exists());
+      expect_true(dir.completeChildPath("rotate.3").exists());
+      expect_true(readAll(log) == expected);
+      expect_true(log.lineCount() == string_utils::countNewlines(expected));
+
+      // new output goes on to new segments
+      log.append(std::string(150, '.') + "\n");
+      expect_false(log.flush());
+      expect_true(dir.completeChildPath("rotate.6").exists());
+      expect_false(dir.completeChildPath("rotate.7").exists());
+   }
+
+   test_that("The oldest segments are removed to stay within the maximum size")
+   {
+      ScrollbackLog log(dir, "bounded", 100, 300);
+      expect_false(log.open());
+      std::string expected;
+      for (int i = 0; i < 50; i++)
+      {
+         std::string line = "line " + std::to_string(1000 + i) + "\n";
+         log.append(line);
+         expected += line;
+      }
+      expect_false(log.flush());
+
+      expect_false(dir.completeChildPath("bounded.0").exists());
+      expect_false(dir.completeChildPath("bounded.1").exists());
+      expect_true(dir.completeChildPath("bounded.2").exists());
+      expect_true(log.size() == 300);
+      expect_true(readAll(log) == expected.substr(expected.size() - 300));
+   }
+
+   dir.remove();
+}
+
+} // namespace tests
+} // namespace terminal
+} // namespace core
+} // namespace rstudio
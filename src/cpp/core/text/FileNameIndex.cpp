@@ -0,0 +1,545 @@
+/*
+ * FileNameIndex.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/FileNameIndex.hpp>
+
+#include <algorithm>
+#include <queue>
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <gsl/gsl>
+
+#include <core/StringUtils.hpp>
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+namespace {
+
+inline unsigned char foldCase(unsigned char ch)
+{
+   return (ch >= 'A' && ch <= 'Z') ? static_cast<unsigned char>(ch + ('a' - 'A')) : ch;
+}
+
+// the bit standing for a (case folded) character in a character mask; letters
+// and digits get a bit each, other characters share the rest
+inline uint64_t characterBit(unsigned char ch)
+{
+   ch = foldCase(ch);
+   if (ch >= 'a' && ch <= 'z')
+      return uint64_t(1) << (ch - 'a');
+   else if (ch >= '0' && ch <= '9')
+      return uint64_t(1) << (26 + ch - '0');
+   else
+      return uint64_t(1) << (36 + ch % 28);
+}
+
+uint64_t characterMask(const std::string& str)
+{
+   uint64_t mask = 0;
+   for (char ch : str)
+      mask |= characterBit(static_cast<unsigned char>(ch));
+   return mask;
+}
+
+std::string foldCase(const std::string& str)
+{
+   std::string folded(str);
+   for (char& ch : folded)
+      ch = static_cast<char>(foldCase(static_cast<unsigned char>(ch)));
+   return folded;
+}
+
+// is query (already case folded) a subsequence of str (already case folded)?
+inline bool isFoldedSubsequence(const std::string& str, const std::string& query)
+{
+   std::size_t n = query.size();
+   if (n > str.size())
+      return false;
+
+   std::size_t j = 0;
+   for (std::size_t i = 0; i < str.size() && j < n; i++)
+   {
+      if (str[i] == query[j])
+         j++;
+   }
+   return j == n;
+}
+
+void splitPath(const std::string& path, std::vector<std::string>* pComponents)
+{
+   pComponents->clear();
+   if (path.empty())
+      return;
+
+   std::size_t end = path.size();
+   while (end > 1 && path[end - 1] == '/')
+      end--;
+
+   // the root directory
+   if (end == 1 && path[0] == '/')
+   {
+      pComponents->push_back(std::string());
+      return;
+   }
+
+   std::size_t begin = 0;
+   while (begin <= end)
+   {
+      std::size_t slash = path.find('/', begin);
+      if (slash == std::string::npos || slash > end)
+         slash = end;
+      pComponents->push_back(path.substr(begin, slash - begin));
+      begin = slash + 1;
+   }
+}
+
+struct RankedEntry
+{
+   RankedEntry(int score, const std::string& path, bool isDirectory)
+      : score(score), path(path), isDirectory(isDirectory)
+   {
+   }
+
+   bool operator<(const RankedEntry& other) const
+   {
+      return score < other.score ||
+             (score == other.score && path < other.path);
+   }
+
+   int score;
+   std::string path;
+   bool isDirectory;
+};
+
+} // anonymous namespace
+
+int scoreMatch(const std::string& suggestion,
+               const std::string& query,
+               bool isFile)
+{
+   // No penalty for perfect matches
+   if (suggestion == query)
+      return 0;
+
+   std::vector<int> matches =
+         string_utils::subsequenceIndices(suggestion, query);
+
+   int totalPenalty = 0;
+
+   // Loop over the matches and assign a score
+   for (int j = 0, n = gsl::narrow_cast<int>(matches.size()); j < n; j++)
+   {
+      int matchPos = matches[j];
+      int penalty = matchPos;
+
+      // Less penalty if character follows special delim
+      if (matchPos >= 1)
+      {
+         char prevChar = suggestion[matchPos - 1];
+         if (prevChar == '_' || prevChar == '-' || (!isFile && prevChar == '.'))
+         {
+            penalty = j + 1;
+         }
+      }
+
+      // Less penalty for perfect match (ie, reward case-sensitive match)
+      penalty -= suggestion[matchPos] == query[j];
+
+      // More penalty for 'uninteresting' files
+      if (suggestion == "RcppExports.R" ||
+          suggestion == "RcppExports.cpp")
+         penalty += 6;
+
+      // More penalty for 'uninteresting' extensions (e.g. .Rd)
+      std::string extension = string_utils::getExtension(suggestion);
+      if (boost::algorithm::to_lower_copy(extension) == ".rd")
+         penalty += 6;
+
+      totalPenalty += penalty;
+   }
+
+   // Penalize files
+   if (isFile)
+      ++totalPenalty;
+
+   // Penalize unmatched characters
+   totalPenalty += gsl::narrow_cast<int>((query.size() - matches.size()) * query.size());
+
+   return totalPenalty;
+}
+
+FileNameIndex::FileNameIndex()
+   : firstRoot_(kNone), entryCount_(0)
+{
+}
+
+void FileNameIndex::add(const std::string& path, bool isDirectory)
+{
+   std::vector<std::string> components;
+   splitPath(path, &components);
+
+   uint32_t parent = kNone;
+   for (std::size_t i = 0; i < components.size(); i++)
+   {
+      bool isLast = i + 1 == components.size();
+      uint32_t name = internName(components[i]);
+      uint32_t id = findChild(parent, name);
+      if (id == kNone)
+      {
+         id = addEntry(parent, name, isLast ? isDirectory : true);
+      }
+      else
+      {
+         // the entry already holds a reference to the name
+         releaseName(name);
+         if (isLast)
+            entries_[id].isDirectory = isDirectory;
+      }
+      parent = id;
+   }
+}
+
+void FileNameIndex::remove(const std::string& path)
+{
+   uint32_t id = findPath(path);
+   if (id != kNone)
+      removeEntry(id);
+}
+
+void FileNameIndex::clear()
+{
+   nameIds_.clear();
+   names_.clear();
+   lowerNames_.clear();
+   nameMasks_.clear();
+   nameRefs_.clear();
+   freeNames_.clear();
+   entries_.clear();
+   freeEntries_.clear();
+   childIds_.clear();
+   firstRoot_ = kNone;
+   entryCount_ = 0;
+}
+
+bool FileNameIndex::contains(const std::string& path) const
+{
+   return findPath(path) != kNone;
+}
+
+void FileNameIndex::search(const std::string& query,
+                           const std::string& directory,
+                           int types,
+                           bool matchRelativePath,
+                           std::size_t maxResults,
+                           const Filter& filter,
+                           std::vector<Match>* pMatches,
+                           bool* pMoreAvailable) const
+{
+   *pMoreAvailable = false;
+   if (maxResults == 0)
+      return;
+
+   uint32_t root = kNone;
+   if (!directory.empty())
+   {
+      root = findPath(directory);
+      if (root == kNone)
+         return;
+   }
+
+   const std::string foldedQuery = foldCase(query);
+   const uint64_t queryMask = characterMask(query);
+
+   // score each distinct name once, ruling out most of them using only their
+   // character masks (a tight loop over a flat table)
+   std::vector<int> nameScores;
+   if (!matchRelativePath)
+   {
+      const std::size_t count = nameMasks_.size();
+      std::vector<unsigned char> candidates(count);
+      const uint64_t* pMasks = nameMasks_.data();
+      for (std::size_t i = 0; i < count; i++)
+         candidates[i] = (pMasks[i] & queryMask) == queryMask;
+
+      nameScores.assign(count, -1);
+      for (std::size_t i = 0; i < count; i++)
+      {
+         if (candidates[i] && nameRefs_[i] > 0 &&
+             isFoldedSubsequence(lowerNames_[i], foldedQuery))
+         {
+            nameScores[i] = scoreMatch(*names_[i], query, true);
+         }
+      }
+   }
+
+   // keep the best maxResults matches in a heap (whose top is the worst of
+   // them), ranking equal scores by path
+   std::priority_queue<RankedEntry> best;
+   auto consider = [&](uint32_t id, int score)
+   {
+      // once we know there are more matches than we'll return, we needn't
+      // look at those which couldn't displace any we have
+      bool isFull = best.size() >= maxResults;
+      if (isFull && *pMoreAvailable && score > best.top().score)
+         return;
+
+      const Entry& entry = entries_[id];
+      RankedEntry ranked(score, entryPath(id), entry.isDirectory);
+      if (filter && !filter(ranked.path, ranked.isDirectory))
+         return;
+
+      if (!isFull)
+      {
+         best.push(ranked);
+      }
+      else
+      {
+         *pMoreAvailable = true;
+         if (ranked < best.top())
+         {
+            best.pop();
+            best.push(ranked);
+         }
+      }
+   };
+
+   // walk the entries within the directory; when matching relative paths, the
+   // path (and its character mask) is built up on the way down
+   struct Frame
+   {
+      uint32_t id;
+      std::size_t pathLength;
+      uint64_t pathMask;
+   };
+
+   std::vector<Frame> stack;
+   std::string relativePath;
+   uint32_t first = root == kNone ? firstRoot_ : entries_[root].firstChild;
+   for (uint32_t id = first; id != kNone; id = entries_[id].nextSibling)
+      stack.push_back({ id, 0, 0 });
+
+   const uint64_t separatorBit = characterBit('/');
+   while (!stack.empty())
+   {
+      Frame frame = stack.back();
+      stack.pop_back();
+
+      const Entry& entry = entries_[frame.id];
+      int typeFlag = entry.isDirectory ? Directories : Files;
+
+      uint64_t pathMask = 0;
+      if (matchRelativePath)
+      {
+         relativePath.resize(frame.pathLength);
+         if (!relativePath.empty())
+         {
+            relativePath.push_back('/');
+            pathMask |= separatorBit;
+         }
+         relativePath.append(*names_[entry.name]);
+         pathMask |= frame.pathMask | nameMasks_[entry.name];
+
+         if ((types & typeFlag) &&
+             (pathMask & queryMask) == queryMask &&
+             isFoldedSubsequence(foldCase(relativePath), foldedQuery))
+         {
+            consider(frame.id, scoreMatch(relativePath, query, !entry.isDirectory));
+         }
+      }
+      else if ((types & typeFlag) && nameScores[entry.name] >= 0)
+      {
+         // scores were computed for files; directories aren't penalized
+         int score = nameScores[entry.name];
+         if (entry.isDirectory && score > 0)
+            score--;
+         consider(frame.id, score);
+      }
+
+      for (uint32_t child = entry.firstChild;
+           child != kNone;
+           child = entries_[child].nextSibling)
+      {
+         stack.push_back({ child, relativePath.size(), pathMask });
+      }
+   }
+
+   // emit the matches, best first
+   std::vector<Match> matches(best.size());
+   for (std::size_t i = matches.size(); i > 0; i--)
+   {
+      const RankedEntry& ranked = best.top();
+      matches[i - 1] = { ranked.path, ranked.isDirectory, ranked.score };
+      best.pop();
+   }
+
+   pMatches->insert(pMatches->end(), matches.begin(), matches.end());
+}
+
+uint32_t FileNameIndex::internName(const std::string& name)
+{
+   auto it = nameIds_.find(name);
+   if (it != nameIds_.end())
+   {
+      nameRefs_[it->second]++;
+      return it->second;
+   }
+
+   uint32_t id;
+   if (!freeNames_.empty())
+   {
+      id = freeNames_.back();
+      freeNames_.pop_back();
+   }
+   else
+   {
+      id = gsl::narrow_cast<uint32_t>(names_.size());
+      names_.push_back(nullptr);
+      lowerNames_.push_back(std::string());
+      nameMasks_.push_back(0);
+      nameRefs_.push_back(0);
+   }
+
+   it = nameIds_.insert(std::make_pair(name, id)).first;
+   names_[id] = &it->first;
+   lowerNames_[id] = foldCase(name);
+   nameMasks_[id] = characterMask(name);
+   nameRefs_[id] = 1;
+   return id;
+}
+
+void FileNameIndex::releaseName(uint32_t id)
+{
+   if (--nameRefs_[id] > 0)
+      return;
+
+   nameIds_.erase(*names_[id]);
+   names_[id] = nullptr;
+   lowerNames_[id].clear();
+   nameMasks_[id] = 0;
+   freeNames_.push_back(id);
+}
+
+uint32_t FileNameIndex::findChild(uint32_t parent, uint32_t name) const
+{
+   auto it = childIds_.find(childKey(parent, name));
+   return it == childIds_.end() ? kNone : it->second;
+}
+
+uint32_t FileNameIndex::findPath(const std::string& path) const
+{
+   std::vector<std::string> components;
+   splitPath(path, &components);
+
+   uint32_t id = kNone;
+   for (const std::string& component : components)
+   {
+      auto it = nameIds_.find(component);
+      if (it == nameIds_.end())
+         return kNone;
+
+      id = findChild(id, it->second);
+      if (id == kNone)
+         return kNone;
+   }
+   return id;
+}
+
+uint32_t FileNameIndex::addEntry(uint32_t parent, uint32_t name, bool isDirectory)
+{
+   uint32_t id;
+   if (!freeEntries_.empty())
+   {
+      id = freeEntries_.back();
+      freeEntries_.pop_back();
+   }
+   else
+   {
+      id = gsl::narrow_cast<uint32_t>(entries_.size());
+      entries_.push_back(Entry());
+   }
+
+   uint32_t& firstChild = parent == kNone ? firstRoot_ : entries_[parent].firstChild;
+
+   Entry& entry = entries_[id];
+   entry.parent = parent;
+   entry.name = name;
+   entry.firstChild = kNone;
+   entry.nextSibling = firstChild;
+   entry.isDirectory = isDirectory;
+
+   firstChild = id;
+   childIds_[childKey(parent, name)] = id;
+   entryCount_++;
+   return id;
+}
+
+void FileNameIndex::removeEntry(uint32_t id)
+{
+   // unlink the entry from its parent
+   uint32_t parent = entries_[id].parent;
+   uint32_t* pLink = parent == kNone ? &firstRoot_ : &entries_[parent].firstChild;
+   while (*pLink != id)
+      pLink = &entries_[*pLink].nextSibling;
+   *pLink = entries_[id].nextSibling;
+
+   // then free it and everything beneath it
+   std::vector<uint32_t> pending(1, id);
+   while (!pending.empty())
+   {
+      uint32_t current = pending.back();
+      pending.pop_back();
+
+      Entry& entry = entries_[current];
+      for (uint32_t child = entry.firstChild;
+           child != kNone;
+           child = entries_[child].nextSibling)
+      {
+         pending.push_back(child);
+      }
+
+      childIds_.erase(childKey(entry.parent, entry.name));
+      releaseName(entry.name);
+      entry.firstChild = kNone;
+      freeEntries_.push_back(current);
+      entryCount_--;
+   }
+}
+
+std::string FileNameIndex::entryPath(uint32_t id) const
+{
+   std::vector<uint32_t> chain;
+   for (uint32_t current = id; current != kNone; current = entries_[current].parent)
+      chain.push_back(current);
+
+   std::string path;
+   for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+   {
+      if (it != chain.rbegin())
+         path.push_back('/');
+      path.append(*names_[entries_[*it].name]);
+   }
+
+   // a lone root component stands for the root directory
+   if (path.empty() && !chain.empty())
+      path = "/";
+   return path;
+}
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
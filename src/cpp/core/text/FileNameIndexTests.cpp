@@ -0,0 +1,218 @@
+/*
+ * FileNameIndexTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/FileNameIndex.hpp>
+
+#include <algorithm>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/format.hpp>
+
+#include <core/StringUtils.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+using namespace rstudio::core::text;
+
+namespace {
+
+std::vector<std::string> search(const FileNameIndex& index,
+                                const std::string& query,
+                                const std::string& directory = "/proj",
+                                int types = FileNameIndex::All,
+                                bool matchRelativePath = false,
+                                std::size_t maxResults = 100,
+                                bool* pMoreAvailable = nullptr)
+{
+   std::vector<FileNameIndex::Match> matches;
+   bool moreAvailable = false;
+   index.search(query, directory, types, matchRelativePath, maxResults,
+                FileNameIndex::Filter(), &matches, &moreAvailable);
+   if (pMoreAvailable)
+      *pMoreAvailable = moreAvailable;
+
+   std::vector<std::string> paths;
+   for (const FileNameIndex::Match& match : matches)
+      paths.push_back(match.path);
+   return paths;
+}
+
+std::vector<std::string> paths(std::initializer_list<std::string> values)
+{
+   return std::vector<std::string>(values);
+}
+
+} // anonymous namespace
+
+TEST_CASE("FileNameIndex")
+{
+   FileNameIndex index;
+   index.add("/proj/R/utils.R", false);
+   index.add("/proj/R/plot-utils.R", false);
+   index.add("/proj/R/RcppExports.R", false);
+   index.add("/proj/man/utils.Rd", false);
+   index.add("/proj/src/utils.cpp", false);
+   index.add("/proj/tests/testthat", true);
+   index.add("/proj/DESCRIPTION", false);
+
+   SECTION("Paths are stored as interned components")
+   {
+      // the root, proj, R, man, src and tests are added as directories
+      CHECK(index.size() == 13);
+      CHECK(index.contains("/proj/R"));
+      CHECK(index.contains("/proj/R/"));
+      CHECK(index.contains("/proj/src/utils.cpp"));
+      CHECK_FALSE(index.contains("/proj/src/utils.c"));
+
+      // the root, proj, R, utils.R, plot-utils.R, RcppExports.R, man,
+      // utils.Rd, src, utils.cpp, tests, testthat and DESCRIPTION
+      CHECK(index.nameCount() == 13);
+      index.add("/other/R/utils.R", false);
+      CHECK(index.nameCount() == 14);
+   }
+
+   SECTION("Matches are ranked by score")
+   {
+      CHECK(search(index, "utils", "/proj", FileNameIndex::Files) ==
+            paths({ "/proj/R/utils.R",
+                    "/proj/src/utils.cpp",
+                    "/proj/R/plot-utils.R",
+                    "/proj/man/utils.Rd" }));
+
+      // the matching is case insensitive; scores prefer case sensitive matches
+      CHECK(search(index, "DESC") == paths({ "/proj/DESCRIPTION" }));
+      CHECK(search(index, "desc") == paths({ "/proj/DESCRIPTION" }));
+
+      // the scores are those of scoreMatch
+      std::vector<FileNameIndex::Match> matches;
+      bool moreAvailable = false;
+      index.search("rcpp", "/proj", FileNameIndex::Files, false, 10,
+                   FileNameIndex::Filter(), &matches, &moreAvailable);
+      REQUIRE(matches.size() == 1);
+      CHECK(matches[0].score == scoreMatch("RcppExports.R", "rcpp", true));
+      CHECK_FALSE(matches[0].isDirectory);
+   }
+
+   SECTION("Searches are limited to a directory and entry types")
+   {
+      CHECK(search(index, "utils", "/proj/R") ==
+            paths({ "/proj/R/utils.R", "/proj/R/plot-utils.R" }));
+      CHECK(search(index, "test", "/proj", FileNameIndex::Directories) ==
+            paths({ "/proj/tests", "/proj/tests/testthat" }));
+      CHECK(search(index, "test", "/proj", FileNameIndex::Files).empty());
+      CHECK(search(index, "utils", "/nowhere").empty());
+   }
+
+   SECTION("Only the best matches are kept")
+   {
+      bool moreAvailable = false;
+      CHECK(search(index, "utils", "/proj", FileNameIndex::Files, false, 2,
+                   &moreAvailable) ==
+            paths({ "/proj/R/utils.R", "/proj/src/utils.cpp" }));
+      CHECK(moreAvailable);
+
+      search(index, "utils", "/proj", FileNameIndex::Files, false, 4,
+             &moreAvailable);
+      CHECK_FALSE(moreAvailable);
+   }
+
+   SECTION("Relative paths can be matched")
+   {
+      CHECK(search(index, "srcutil", "/proj", FileNameIndex::Files, true) ==
+            paths({ "/proj/src/utils.cpp" }));
+      CHECK(search(index, "r/plot", "/proj", FileNameIndex::All, true) ==
+            paths({ "/proj/R/plot-utils.R" }));
+      CHECK(search(index, "srcutil", "/proj/src", FileNameIndex::Files, true).empty());
+   }
+
+   SECTION("Matches can be filtered")
+   {
+      std::vector<FileNameIndex::Match> matches;
+      bool moreAvailable = false;
+      index.search("utils", "/proj", FileNameIndex::Files, false, 10,
+                   [](const std::string& path, bool)
+                   {
+                      return !boost::algorithm::ends_with(path, ".Rd");
+                   },
+                   &matches, &moreAvailable);
+      CHECK(matches.size() == 3);
+   }
+
+   SECTION("Files and directories are removed")
+   {
+      index.remove("/proj/R/utils.R");
+      CHECK_FALSE(index.contains("/proj/R/utils.R"));
+      CHECK(search(index, "utils", "/proj/R") == paths({ "/proj/R/plot-utils.R" }));
+
+      index.remove("/proj/R");
+      CHECK_FALSE(index.contains("/proj/R"));
+      CHECK_FALSE(index.contains("/proj/R/plot-utils.R"));
+      CHECK(index.size() == 9);
+
+      // names no longer used are released (and their slots reused)
+      CHECK(index.nameCount() == 9);
+      index.add("/proj/R/zzz.R", false);
+      CHECK(search(index, "zzz") == paths({ "/proj/R/zzz.R" }));
+
+      index.clear();
+      CHECK(index.size() == 0);
+      CHECK(search(index, "utils").empty());
+   }
+
+   SECTION("Results match a scan of every path with scoreMatch")
+   {
+      FileNameIndex large;
+      std::vector<std::string> files;
+      for (int i = 0; i < 2000; i++)
+      {
+         std::string path = (boost::format("/proj/dir%1%/sub%2%/file_%3%.%4%")
+                             % (i % 17) % (i % 5) % i % (i % 3 ? "R" : "cpp")).str();
+         files.push_back(path);
+         large.add(path, false);
+      }
+
+      const std::string query = "fi12R";
+      std::vector<std::pair<int, std::string> > expected;
+      for (const std::string& path : files)
+      {
+         std::string name = path.substr(path.rfind('/') + 1);
+         if (string_utils::isSubsequence(name, query, true))
+            expected.push_back(std::make_pair(scoreMatch(name, query, true), path));
+      }
+      std::sort(expected.begin(), expected.end());
+      expected.resize(std::min<std::size_t>(expected.size(), 25));
+
+      std::vector<FileNameIndex::Match> matches;
+      bool moreAvailable = false;
+      large.search(query, "/proj", FileNameIndex::Files, false, 25,
+                   FileNameIndex::Filter(), &matches, &moreAvailable);
+
+      REQUIRE(matches.size() == expected.size());
+      for (std::size_t i = 0; i < matches.size(); i++)
+      {
+         CHECK(matches[i].score == expected[i].first);
+         CHECK(matches[i].path == expected[i].second);
+      }
+   }
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,293 @@
+/*
+ * ParallelGrep.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/ParallelGrep.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/Thread.hpp>
+#include <core/text/TrigramIndex.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+namespace {
+
+inline char foldCase(char ch)
+{
+   return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+}
+
+bool isAscii(const std::string& text)
+{
+   for (char ch : text)
+   {
+      if (static_cast<unsigned char>(ch) >= 0x80)
+         return false;
+   }
+   return true;
+}
+
+const char* findLiteral(const char* begin,
+                        const char* end,
+                        const std::string& literal,
+                        bool ignoreCase)
+{
+   if (ignoreCase)
+   {
+      return std::search(begin, end,
+                         literal.begin(), literal.end(),
+                         [](char a, char b) { return foldCase(a) == foldCase(b); });
+   }
+   else
+   {
+      return std::search(begin, end, literal.begin(), literal.end());
+   }
+}
+
+} // anonymous namespace
+
+Error ParallelGrep::create(const std::string& pattern,
+                           bool asRegex,
+                           bool ignoreCase,
+                           const std::vector<std::string>& files,
+                           std::size_t threadCount,
+                           boost::shared_ptr<ParallelGrep>* pGrep)
+{
+   // GNU grep extends basic regular expressions with '\+', '\?' and '\|'
+   boost::regex::flag_type flags = asRegex ?
+            boost::regex::grep | boost::regex::bk_plus_qm | boost::regex::bk_vbar :
+            boost::regex::literal;
+   if (ignoreCase)
+      flags |= boost::regex::icase;
+
+   boost::regex regex;
+   try
+   {
+      regex.assign(pattern, flags);
+   }
+   catch (const boost::regex_error& e)
+   {
+      return systemError(boost::system::errc::invalid_argument,
+                         "Invalid search pattern: " + std::string(e.what()),
+                         ERROR_LOCATION);
+   }
+
+   // the literal used to skip over text which can't match; when ignoring
+   // case only ASCII literals are used (non-ASCII case variants may differ
+   // in their byte sequences)
+   std::string literal = asRegex ? requiredLiteral(pattern) : pattern;
+   if (ignoreCase && !isAscii(literal))
+      literal.clear();
+
+   pGrep->reset(new ParallelGrep(regex, literal, ignoreCase, files));
+   (*pGrep)->start(std::max<std::size_t>(1, std::min(threadCount, files.size())));
+   return Success();
+}
+
+ParallelGrep::ParallelGrep(const boost::regex& regex,
+                           const std::string& requiredLiteral,
+                           bool ignoreCase,
+                           const std::vector<std::string>& files)
+   : regex_(regex),
+     requiredLiteral_(requiredLiteral),
+     ignoreCase_(ignoreCase),
+     files_(files),
+     nextFile_(0),
+     cancelled_(false),
+     results_(files.size()),
+     completed_(files.size(), false),
+     nextToCollect_(0),
+     completedCount_(0)
+{
+}
+
+ParallelGrep::~ParallelGrep()
+{
+   try
+   {
+      cancel();
+      for (boost::thread& thread : threads_)
+      {
+         if (thread.joinable())
+            thread.join();
+      }
+   }
+   catch (...)
+   {
+   }
+}
+
+void ParallelGrep::start(std::size_t threadCount)
+{
+   threads_.resize(threadCount);
+   for (boost::thread& thread : threads_)
+      core::thread::safeLaunchThread(boost::bind(&ParallelGrep::worker, this), &thread);
+}
+
+void ParallelGrep::cancel()
+{
+   cancelled_ = true;
+
+   LOCK_MUTEX(mutex_)
+   {
+      completedCondition_.notify_all();
+   }
+   END_LOCK_MUTEX
+}
+
+void ParallelGrep::worker()
+{
+   while (!cancelled_)
+   {
+      std::size_t index = nextFile_++;
+      if (index >= files_.size())
+         break;
+
+      searchFile(index);
+   }
+}
+
+void ParallelGrep::searchFile(std::size_t index)
+{
+   GrepFileResult result;
+   result.path = files_[index];
+
+   // files which can't be read (e.g. because they were removed after the
+   // search started) simply have no matches
+   std::string contents;
+   Error error = readStringFromFile(FilePath(result.path), &contents);
+   if (!error && contents.find('\0') == std::string::npos)
+      searchContents(contents, &result.lines);
+
+   LOCK_MUTEX(mutex_)
+   {
+      results_[index] = std::move(result);
+      completed_[index] = true;
+      completedCount_++;
+      completedCondition_.notify_all();
+   }
+   END_LOCK_MUTEX
+}
+
+bool ParallelGrep::searchContents(const std::string& contents,
+                                  std::vector<GrepLine>* pLines) const
+{
+   const char* begin = contents.data();
+   const char* end = begin + contents.size();
+   const char* lineBegin = begin;
+   int lineNumber = 1;
+
+   try
+   {
+      while (lineBegin < end && !cancelled_)
+      {
+         // jump ahead to the next line which could contain a match
+         if (!requiredLiteral_.empty())
+         {
+            const char* pLiteral = findLiteral(lineBegin, end, requiredLiteral_, ignoreCase_);
+            if (pLiteral == end)
+               break;
+
+            const char* candidateBegin = pLiteral;
+            while (candidateBegin > lineBegin && *(candidateBegin - 1) != '\n')
+               --candidateBegin;
+            lineNumber += static_cast<int>(std::count(lineBegin, candidateBegin, '\n'));
+            lineBegin = candidateBegin;
+         }
+
+         const char* lineEnd = static_cast<const char*>(
+                  std::memchr(lineBegin, '\n', end - lineBegin));
+         if (lineEnd == nullptr)
+            lineEnd = end;
+
+         GrepLine line;
+         bool matched = false;
+         boost::cregex_iterator it(lineBegin, lineEnd, regex_);
+         for (; it != boost::cregex_iterator(); ++it)
+         {
+            matched = true;
+            const boost::cmatch& match = *it;
+            if (match.length() > 0)
+            {
+               std::size_t offset = match[0].first - lineBegin;
+               line.matches.push_back(std::make_pair(offset, offset + match.length()));
+            }
+         }
+
+         if (matched)
+         {
+            line.lineNumber = lineNumber;
+            line.text.assign(lineBegin, lineEnd);
+            pLines->push_back(std::move(line));
+         }
+
+         lineBegin = lineEnd + 1;
+         lineNumber++;
+      }
+   }
+   catch (const std::exception&)
+   {
+      // pattern too complex for this input; treat the rest as not matching
+      return false;
+   }
+
+   return true;
+}
+
+bool ParallelGrep::collect(std::vector<GrepFileResult>* pResults)
+{
+   LOCK_MUTEX(mutex_)
+   {
+      while (nextToCollect_ < files_.size() && completed_[nextToCollect_])
+      {
+         GrepFileResult& result = results_[nextToCollect_];
+         if (!result.lines.empty())
+            pResults->push_back(std::move(result));
+         result = GrepFileResult();
+         nextToCollect_++;
+      }
+
+      return nextToCollect_ < files_.size() && !cancelled_;
+   }
+   END_LOCK_MUTEX
+
+   return false;
+}
+
+void ParallelGrep::wait()
+{
+   try
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (completedCount_ < files_.size() && !cancelled_)
+         completedCondition_.wait(lock);
+   }
+   catch (const boost::thread_resource_error&)
+   {
+   }
+}
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
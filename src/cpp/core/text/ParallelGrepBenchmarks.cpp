@@ -0,0 +1,174 @@
+/*
+ * ParallelGrepBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/ParallelGrep.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/system/Process.hpp>
+#include <core/system/ShellUtils.hpp>
+#include <core/text/TrigramIndex.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+using namespace boost::posix_time;
+
+namespace {
+
+std::vector<text::GrepFileResult> collectAll(text::ParallelGrep* pGrep)
+{
+   std::vector<text::GrepFileResult> results;
+   pGrep->wait();
+   while (pGrep->collect(&results))
+   {
+   }
+   return results;
+}
+
+FilePath createTempDirectory()
+{
+   FilePath dir;
+   REQUIRE_FALSE(FilePath::tempFilePath(dir));
+   REQUIRE_FALSE(dir.ensureDirectory());
+   return dir;
+}
+
+// source-like text with a rarely occurring identifier in some files
+std::string sampleFile(int fileIndex, int lines)
+{
+   std::string contents;
+   for (int i = 0; i < lines; i++)
+   {
+      contents += "result_" + std::to_string(i) + " <- compute(data, column = \"value\", n = " +
+                  std::to_string(fileIndex * i) + ")\n";
+      if (fileIndex % 97 == 0 && i == lines / 2)
+         contents += "   needleFunction(result)\n";
+   }
+   return contents;
+}
+
+} // anonymous namespace
+
+// compare a search narrowed by the trigram index and verified in parallel
+// with the grep command used by find in files (which rereads every file)
+TEST_CASE("ParallelGrep Benchmarks")
+{
+   const int kFiles = 2000;
+   const int kLinesPerFile = 200;
+   const std::size_t kThreads = 4;
+
+   FilePath dir = createTempDirectory();
+
+   std::vector<std::string> files;
+   for (int i = 0; i < kFiles; i++)
+   {
+      FilePath file = dir.completeChildPath("file" + std::to_string(i) + ".R");
+      REQUIRE_FALSE(writeStringToFile(file, sampleFile(i, kLinesPerFile)));
+      files.push_back(file.getAbsolutePath());
+   }
+
+   ptime start = microsec_clock::universal_time();
+   text::TrigramIndex index;
+   for (const std::string& path : files)
+   {
+      std::string contents;
+      REQUIRE_FALSE(readStringFromFile(FilePath(path), &contents));
+      index.update(path, 0, contents.size(), contents);
+   }
+   long indexMs = (microsec_clock::universal_time() - start).total_milliseconds();
+
+   auto runGrep = [&](const std::string& pattern, bool asRegex, std::size_t* pLines) -> long
+   {
+      shell_utils::ShellCommand cmd("grep");
+      cmd << "--binary-files=without-match" << "-rHn" << "--color=always";
+      if (!asRegex)
+         cmd << "-F";
+      cmd << "-e" << pattern << dir;
+
+      ptime start = microsec_clock::universal_time();
+      system::ProcessResult result;
+      REQUIRE_FALSE(system::runCommand(cmd, system::ProcessOptions(), &result));
+      long elapsed = (microsec_clock::universal_time() - start).total_microseconds();
+
+      *pLines = std::count(result.stdOut.begin(), result.stdOut.end(), '\n');
+      return elapsed;
+   };
+
+   auto runIndexed = [&](const std::string& pattern, bool asRegex, std::size_t* pLines) -> long
+   {
+      ptime start = microsec_clock::universal_time();
+
+      std::vector<std::string> candidates;
+      index.candidates(asRegex ? text::requiredLiteral(pattern) : pattern, false, &candidates);
+      std::sort(candidates.begin(), candidates.end());
+
+      boost::shared_ptr<text::ParallelGrep> pGrep;
+      REQUIRE_FALSE(text::ParallelGrep::create(pattern, asRegex, false, candidates, kThreads, &pGrep));
+      std::vector<text::GrepFileResult> results = collectAll(pGrep.get());
+
+      long elapsed = (microsec_clock::universal_time() - start).total_microseconds();
+
+      *pLines = 0;
+      for (const text::GrepFileResult& result : results)
+         *pLines += result.lines.size();
+      return elapsed;
+   };
+
+   struct Query
+   {
+      const char* label;
+      const char* pattern;
+      bool asRegex;
+   };
+
+   Query queries[] = {
+      { "rare literal", "needleFunction", false },
+      { "rare regex", "needle[A-Z][a-z]*(", true },
+      { "common literal", "column = \"value\"", false },
+      { "unselective regex", "_[0-9]\\{3\\} <-", true }
+   };
+
+   std::cout << "find in files (" << kFiles << " files, indexed in " << indexMs << "ms):" << std::endl;
+   for (const Query& query : queries)
+   {
+      std::size_t grepLines = 0;
+      std::size_t indexedLines = 0;
+      long grepUs = runGrep(query.pattern, query.asRegex, &grepLines);
+      long indexedUs = runIndexed(query.pattern, query.asRegex, &indexedLines);
+
+      CHECK(indexedLines == grepLines);
+      std::cout << "   " << query.label << ": grep " << grepUs << "us, "
+                << "indexed " << indexedUs << "us "
+                << "(" << indexedLines << " lines)" << std::endl;
+   }
+
+   dir.removeIfExists();
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
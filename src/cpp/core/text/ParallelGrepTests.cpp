@@ -0,0 +1,327 @@
+/*
+ * ParallelGrepTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/ParallelGrep.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/system/Process.hpp>
+#include <core/system/ShellUtils.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+std::vector<text::GrepLine> search(const std::string& pattern,
+                                   bool asRegex,
+                                   bool ignoreCase,
+                                   const std::string& contents)
+{
+   boost::shared_ptr<text::ParallelGrep> pGrep;
+   Error error = text::ParallelGrep::create(pattern,
+                                            asRegex,
+                                            ignoreCase,
+                                            std::vector<std::string>(),
+                                            1,
+                                            &pGrep);
+   REQUIRE_FALSE(error);
+
+   std::vector<text::GrepLine> lines;
+   pGrep->searchContents(contents, &lines);
+   return lines;
+}
+
+std::vector<text::GrepFileResult> collectAll(text::ParallelGrep* pGrep)
+{
+   std::vector<text::GrepFileResult> results;
+   pGrep->wait();
+   while (pGrep->collect(&results))
+   {
+   }
+   return results;
+}
+
+FilePath createTempDirectory()
+{
+   FilePath dir;
+   REQUIRE_FALSE(FilePath::tempFilePath(dir));
+   REQUIRE_FALSE(dir.ensureDirectory());
+   return dir;
+}
+
+// source-like text with a rarely occurring identifier in some files
+std::string sampleFile(int fileIndex, int lines)
+{
+   std::string contents;
+   for (int i = 0; i < lines; i++)
+   {
+      contents += "result_" + std::to_string(i) + " <- compute(data, column = \"value\", n = " +
+                  std::to_string(fileIndex * i) + ")\n";
+      if (fileIndex % 97 == 0 && i == lines / 2)
+         contents += "   needleFunction(result)\n";
+   }
+   return contents;
+}
+
+#ifndef _WIN32
+
+// the matches reported for each line, as "line:match" (the same form as the
+// output of 'grep -on')
+std::vector<std::string> matchesOf(const std::vector<text::GrepLine>& lines)
+{
+   std::vector<std::string> matches;
+   for (const text::GrepLine& line : lines)
+   {
+      for (const std::pair<std::size_t, std::size_t>& match : line.matches)
+      {
+         matches.push_back(std::to_string(line.lineNumber) + ":" +
+                           line.text.substr(match.first, match.second - match.first));
+      }
+   }
+   return matches;
+}
+
+// the matches found by the grep command used by find in files
+std::vector<std::string> grepMatches(const std::string& pattern,
+                                     bool asRegex,
+                                     bool ignoreCase,
+                                     const FilePath& file)
+{
+   shell_utils::ShellCommand cmd("grep");
+   cmd << "-on";
+   if (!asRegex)
+      cmd << "-F";
+   if (ignoreCase)
+      cmd << "-i";
+   cmd << "-e" << pattern << file;
+
+   system::ProcessResult result;
+   REQUIRE_FALSE(system::runCommand(cmd, system::ProcessOptions(), &result));
+
+   std::vector<std::string> matches;
+   std::size_t begin = 0;
+   while (begin < result.stdOut.size())
+   {
+      std::size_t end = result.stdOut.find('\n', begin);
+      if (end == std::string::npos)
+         end = result.stdOut.size();
+      matches.push_back(result.stdOut.substr(begin, end - begin));
+      begin = end + 1;
+   }
+   return matches;
+}
+
+#endif
+
+} // anonymous namespace
+
+TEST_CASE("ParallelGrep")
+{
+   SECTION("Literal patterns report line numbers and match offsets")
+   {
+      std::vector<text::GrepLine> lines =
+            search("ab", false, false, "xab ab\nnothing\n\nab.*\nlast ab");
+
+      REQUIRE(lines.size() == 3);
+      CHECK(lines[0].lineNumber == 1);
+      CHECK(lines[0].text == "xab ab");
+      REQUIRE(lines[0].matches.size() == 2);
+      CHECK(lines[0].matches[0] == std::make_pair<std::size_t, std::size_t>(1, 3));
+      CHECK(lines[0].matches[1] == std::make_pair<std::size_t, std::size_t>(4, 6));
+      CHECK(lines[1].lineNumber == 4);
+      CHECK(lines[1].text == "ab.*");
+      CHECK(lines[2].lineNumber == 5);
+      CHECK(lines[2].text == "last ab");
+
+      // regex characters are literal
+      lines = search("b.*", false, false, "abc\nab.*\n");
+      REQUIRE(lines.size() == 1);
+      CHECK(lines[0].lineNumber == 2);
+   }
+
+   SECTION("Regex patterns use basic (grep) syntax")
+   {
+      std::vector<text::GrepLine> lines =
+            search("^fo\\+(x)", true, false, "fooo(x)\n foo(x)\nfx\nfo(x) fo(x)");
+
+      REQUIRE(lines.size() == 2);
+      CHECK(lines[0].lineNumber == 1);
+      CHECK(lines[0].matches[0] == std::make_pair<std::size_t, std::size_t>(0, 7));
+      CHECK(lines[1].lineNumber == 4);
+      CHECK(lines[1].matches.size() == 1);
+
+      // alternation
+      lines = search("cat\\|dog", true, false, "a dog\na bird\na cat");
+      REQUIRE(lines.size() == 2);
+      CHECK(lines[1].lineNumber == 3);
+   }
+
+   SECTION("Case can be ignored")
+   {
+      std::vector<text::GrepLine> lines =
+            search("READ", false, true, "read\nRead\nwrite\n");
+      REQUIRE(lines.size() == 2);
+      CHECK(lines[1].lineNumber == 2);
+
+      lines = search("r[aeiou]ad", true, true, "READ\nRAD\n");
+      REQUIRE(lines.size() == 1);
+      CHECK(lines[0].lineNumber == 1);
+
+      CHECK(search("READ", false, false, "read\n").empty());
+   }
+
+   SECTION("Lines matching only an empty string have no match offsets")
+   {
+      std::vector<text::GrepLine> lines = search("x*", true, false, "abc\nxx\n");
+      REQUIRE(lines.size() == 2);
+      CHECK(lines[0].matches.empty());
+      REQUIRE(lines[1].matches.size() == 1);
+      CHECK(lines[1].matches[0] == std::make_pair<std::size_t, std::size_t>(0, 2));
+   }
+
+   SECTION("Carriage returns are preserved")
+   {
+      std::vector<text::GrepLine> lines = search("b", false, false, "a\r\nb\r\n");
+      REQUIRE(lines.size() == 1);
+      CHECK(lines[0].lineNumber == 2);
+      CHECK(lines[0].text == "b\r");
+   }
+
+#ifndef _WIN32
+   SECTION("Matches agree with the grep command")
+   {
+      const std::string contents =
+            "foo fooo fo f\n"
+            "color colour colouur\n"
+            "the cat and the category\n"
+            "dog catalog hotdog\n"
+            "Hello HELLO hello hElLo\n"
+            "a+b a?b a|b aab\n"
+            "x <- c(1, 2, 3)\n";
+
+      FilePath dir = createTempDirectory();
+      FilePath file = dir.completeChildPath("sample.R");
+      REQUIRE_FALSE(writeStringToFile(file, contents));
+
+      struct Query
+      {
+         const char* pattern;
+         bool asRegex;
+         bool ignoreCase;
+      };
+
+      Query queries[] = {
+         { "fo\\+", true, false },
+         { "colou\\?r", true, false },
+         { "cat\\|dog", true, false },
+         { "cat\\|category", true, false },
+         { "\\(cat\\|dog\\)\\+", true, false },
+         { "a+b", true, false },
+         { "a?b", true, false },
+         { "hello", true, true },
+         { "h[aeiou]llo\\|cat", true, true },
+         { "HELLO", false, true },
+         { "a|b", false, false },
+         { "c(1", false, false }
+      };
+
+      for (const Query& query : queries)
+      {
+         INFO(query.pattern);
+         CHECK(matchesOf(search(query.pattern, query.asRegex, query.ignoreCase, contents)) ==
+               grepMatches(query.pattern, query.asRegex, query.ignoreCase, file));
+      }
+
+      dir.removeIfExists();
+   }
+#endif
+
+   SECTION("Invalid patterns are reported")
+   {
+      boost::shared_ptr<text::ParallelGrep> pGrep;
+      CHECK(text::ParallelGrep::create("[abc", true, false,
+                                       std::vector<std::string>(), 1, &pGrep));
+   }
+
+   SECTION("Files are searched in parallel and collected in order")
+   {
+      FilePath dir = createTempDirectory();
+
+      std::vector<std::string> files;
+      for (int i = 0; i < 50; i++)
+      {
+         FilePath file = dir.completeChildPath("file" + std::to_string(i) + ".R");
+         std::string contents = (i % 3 == 0) ? "x <- 1\nmatch here\n" : "no luck\n";
+         REQUIRE_FALSE(writeStringToFile(file, contents));
+         files.push_back(file.getAbsolutePath());
+      }
+
+      // binary and missing files are skipped
+      FilePath binaryFile = dir.completeChildPath("data.rds");
+      REQUIRE_FALSE(writeStringToFile(binaryFile, std::string("match\0", 6)));
+      files.push_back(binaryFile.getAbsolutePath());
+      files.push_back(dir.completeChildPath("missing.R").getAbsolutePath());
+
+      boost::shared_ptr<text::ParallelGrep> pGrep;
+      REQUIRE_FALSE(text::ParallelGrep::create("match", false, false, files, 4, &pGrep));
+      std::vector<text::GrepFileResult> results = collectAll(pGrep.get());
+
+      REQUIRE(results.size() == 17);
+      for (std::size_t i = 0; i < results.size(); i++)
+      {
+         CHECK(results[i].path == files[i * 3]);
+         REQUIRE(results[i].lines.size() == 1);
+         CHECK(results[i].lines[0].lineNumber == 2);
+      }
+
+      dir.removeIfExists();
+   }
+
+   SECTION("Searches can be cancelled")
+   {
+      FilePath dir = createTempDirectory();
+
+      std::vector<std::string> files;
+      for (int i = 0; i < 200; i++)
+      {
+         FilePath file = dir.completeChildPath("file" + std::to_string(i) + ".R");
+         REQUIRE_FALSE(writeStringToFile(file, sampleFile(i, 200)));
+         files.push_back(file.getAbsolutePath());
+      }
+
+      boost::shared_ptr<text::ParallelGrep> pGrep;
+      REQUIRE_FALSE(text::ParallelGrep::create("compute", false, false, files, 2, &pGrep));
+      pGrep->cancel();
+      pGrep->wait();
+
+      std::vector<text::GrepFileResult> results;
+      CHECK_FALSE(pGrep->collect(&results));
+      CHECK(results.size() < files.size());
+
+      pGrep.reset();
+      dir.removeIfExists();
+   }
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
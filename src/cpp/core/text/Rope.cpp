@@ -0,0 +1,233 @@
+/*
+ * Rope.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/Rope.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <core/Hash.hpp>
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+namespace {
+
+// chunks are split when they'd exceed the maximum size and merged with
+// a neighbor when an edit leaves them smaller than the minimum
+const std::size_t kMaxChunkSize = 16 * 1024;
+const std::size_t kMinChunkSize = 4 * 1024;
+
+} // anonymous namespace
+
+struct Rope::Chunk
+{
+   explicit Chunk(const std::string& text)
+      : text(text), crc(hash::crc32(text.data(), text.size()))
+   {
+   }
+
+   const std::string text;
+   const boost::uint32_t crc;
+};
+
+Rope::Rope()
+   : size_(0)
+{
+}
+
+Rope::Rope(const std::string& text)
+   : size_(0)
+{
+   assign(text);
+}
+
+void Rope::assign(const std::string& text)
+{
+   chunks_.clear();
+   appendChunks(text, &chunks_);
+   size_ = text.size();
+}
+
+void Rope::clear()
+{
+   chunks_.clear();
+   size_ = 0;
+}
+
+void Rope::appendChunks(const std::string& text, std::vector<ChunkPtr>* pChunks) const
+{
+   if (text.empty())
+      return;
+
+   // split into evenly sized chunks (so an edit which grows a chunk just
+   // past the maximum doesn't leave a tiny chunk behind)
+   std::size_t count = (text.size() + kMaxChunkSize - 1) / kMaxChunkSize;
+   std::size_t chunkSize = (text.size() + count - 1) / count;
+   for (std::size_t offset = 0; offset < text.size(); offset += chunkSize)
+      pChunks->push_back(ChunkPtr(new Chunk(text.substr(offset, chunkSize))));
+}
+
+std::size_t Rope::findChunk(std::size_t offset, std::size_t* pChunkStart) const
+{
+   std::size_t start = 0;
+   for (std::size_t i = 0; i < chunks_.size(); i++)
+   {
+      std::size_t chunkSize = chunks_[i]->text.size();
+      if (offset < start + chunkSize || i == chunks_.size() - 1)
+      {
+         *pChunkStart = start;
+         return i;
+      }
+      start += chunkSize;
+   }
+
+   *pChunkStart = 0;
+   return 0;
+}
+
+bool Rope::replace(std::size_t offset, std::size_t length, const std::string& text)
+{
+   if (offset > size_ || length > size_ - offset)
+      return false;
+
+   if (length == 0 && text.empty())
+      return true;
+
+   if (chunks_.empty())
+   {
+      assign(text);
+      return true;
+   }
+
+   // find the chunks spanned by the replaced range
+   std::size_t firstStart = 0;
+   std::size_t first = findChunk(offset, &firstStart);
+   std::size_t lastStart = firstStart;
+   std::size_t last = first;
+   if (length > 0)
+      last = findChunk(offset + length - 1, &lastStart);
+
+   std::string prefix = chunks_[first]->text.substr(0, offset - firstStart);
+   std::string suffix = chunks_[last]->text.substr(offset + length - lastStart);
+
+   // absorb a neighbor if the result would be undersized
+   if (prefix.size() + text.size() + suffix.size() < kMinChunkSize)
+   {
+      if (last + 1 < chunks_.size())
+         suffix.append(chunks_[++last]->text);
+      else if (first > 0)
+         prefix.insert(0, chunks_[--first]->text);
+   }
+
+   std::vector<ChunkPtr> replacement;
+   appendChunks(prefix + text + suffix, &replacement);
+
+   chunks_.erase(chunks_.begin() + first, chunks_.begin() + last + 1);
+   chunks_.insert(chunks_.begin() + first, replacement.begin(), replacement.end());
+   size_ = size_ - length + text.size();
+   return true;
+}
+
+std::string Rope::substr(std::size_t offset, std::size_t length) const
+{
+   std::string result;
+   result.reserve(length);
+
+   std::size_t start = 0;
+   for (const ChunkPtr& pChunk : chunks_)
+   {
+      if (result.size() == length)
+         break;
+
+      const std::string& chunk = pChunk->text;
+      std::size_t end = start + chunk.size();
+      if (end > offset)
+      {
+         std::size_t from = std::max(offset, start) - start;
+         result.append(chunk, from, length - result.size());
+      }
+      start = end;
+   }
+
+   return result;
+}
+
+std::string Rope::str() const
+{
+   std::string result;
+   appendTo(&result);
+   return result;
+}
+
+void Rope::appendTo(std::string* pStr) const
+{
+   pStr->reserve(pStr->size() + size_);
+   for (const ChunkPtr& pChunk : chunks_)
+      pStr->append(pChunk->text);
+}
+
+boost::uint32_t Rope::crc32() const
+{
+   boost::uint32_t crc = 0;
+   for (const ChunkPtr& pChunk : chunks_)
+      crc = hash::crc32Combine(crc, pChunk->crc, pChunk->text.size());
+   return crc;
+}
+
+bool Rope::operator==(const Rope& other) const
+{
+   if (size_ != other.size_)
+      return false;
+
+   // compare chunk by chunk (the chunk boundaries needn't line up)
+   std::size_t i = 0, j = 0;
+   std::size_t offsetI = 0, offsetJ = 0;
+   while (i < chunks_.size() && j < other.chunks_.size())
+   {
+      const std::string& a = chunks_[i]->text;
+      const std::string& b = other.chunks_[j]->text;
+      if (chunks_[i] == other.chunks_[j] && offsetI == 0 && offsetJ == 0)
+      {
+         i++;
+         j++;
+         continue;
+      }
+
+      std::size_t n = std::min(a.size() - offsetI, b.size() - offsetJ);
+      if (std::memcmp(a.data() + offsetI, b.data() + offsetJ, n) != 0)
+         return false;
+
+      offsetI += n;
+      offsetJ += n;
+      if (offsetI == a.size())
+      {
+         i++;
+         offsetI = 0;
+      }
+      if (offsetJ == b.size())
+      {
+         j++;
+         offsetJ = 0;
+      }
+   }
+
+   return true;
+}
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,90 @@
+/*
+ * RopeBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/Rope.hpp>
+
+#include <iostream>
+#include <random>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Hash.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+using namespace boost::posix_time;
+
+namespace {
+
+std::string sampleText(std::size_t size)
+{
+   std::string text;
+   for (int line = 0; text.size() < size; line++)
+      text += "x_" + std::to_string(line) + " <- compute(data, n = " + std::to_string(line % 97) + ")\n";
+   text.resize(size);
+   return text;
+}
+
+} // anonymous namespace
+
+// compare editing a large document as a string (copy, replace and rehash
+// the whole, as document saves used to) with editing it as a rope
+TEST_CASE("Rope Benchmarks")
+{
+   const std::size_t kDocumentSize = 4 * 1024 * 1024;
+   const int kEdits = 500;
+
+   std::string document = sampleText(kDocumentSize);
+   std::minstd_rand rng(42);
+   std::vector<std::size_t> offsets;
+   for (int i = 0; i < kEdits; i++)
+      offsets.push_back(rng() % kDocumentSize);
+
+   ptime start = microsec_clock::universal_time();
+   std::string stringHash;
+   for (std::size_t offset : offsets)
+   {
+      std::string contents(document);
+      contents.replace(offset, 1, "xy");
+      stringHash = hash::crc32Hash(contents);
+      document.swap(contents);
+   }
+   long stringMs = (microsec_clock::universal_time() - start).total_milliseconds();
+
+   text::Rope rope(sampleText(kDocumentSize));
+   start = microsec_clock::universal_time();
+   boost::uint32_t ropeHash = 0;
+   for (std::size_t offset : offsets)
+   {
+      rope.replace(offset, 1, "xy");
+      ropeHash = rope.crc32();
+   }
+   long ropeMs = (microsec_clock::universal_time() - start).total_milliseconds();
+
+   CHECK(std::to_string(ropeHash) == stringHash);
+
+   std::cout << "document edits (" << kEdits << " edits, " << kDocumentSize / 1024 << "KB): "
+             << "string " << stringMs << "ms, "
+             << "rope " << ropeMs << "ms" << std::endl;
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
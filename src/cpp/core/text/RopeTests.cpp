@@ -0,0 +1,122 @@
+/*
+ * RopeTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/Rope.hpp>
+
+#include <random>
+
+#include <core/Hash.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+std::string sampleText(std::size_t size)
+{
+   std::string text;
+   for (int line = 0; text.size() < size; line++)
+      text += "x_" + std::to_string(line) + " <- compute(data, n = " + std::to_string(line % 97) + ")\n";
+   text.resize(size);
+   return text;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Rope")
+{
+   SECTION("Checksums can be combined")
+   {
+      std::string a = "library(dplyr)\n";
+      std::string b = sampleText(100000);
+      std::string ab = a + b;
+
+      boost::uint32_t crcA = hash::crc32(a.data(), a.size());
+      boost::uint32_t crcB = hash::crc32(b.data(), b.size());
+      CHECK(hash::crc32Combine(crcA, crcB, b.size()) == hash::crc32(ab.data(), ab.size()));
+      CHECK(hash::crc32Combine(crcA, 0, 0) == crcA);
+      CHECK(std::to_string(hash::crc32(ab.data(), ab.size())) == hash::crc32Hash(ab));
+   }
+
+   SECTION("Replacements match string replacements")
+   {
+      std::string expected = sampleText(200000);
+      text::Rope rope(expected);
+      CHECK(rope.size() == expected.size());
+      CHECK(rope.chunkCount() > 1);
+
+      std::minstd_rand rng(7);
+      for (int i = 0; i < 2000; i++)
+      {
+         std::size_t offset = rng() % (expected.size() + 1);
+         std::size_t length = std::min<std::size_t>(rng() % (i % 50 == 0 ? 40000 : 20),
+                                                    expected.size() - offset);
+         std::string text = (i % 3 == 0) ? std::string() : sampleText(rng() % (i % 40 == 0 ? 30000 : 30));
+
+         REQUIRE(rope.replace(offset, length, text));
+         expected.replace(offset, length, text);
+         REQUIRE(rope.size() == expected.size());
+      }
+
+      CHECK(rope.str() == expected);
+      CHECK(rope.crc32() == hash::crc32(expected.data(), expected.size()));
+      CHECK(rope.substr(1000, 5000) == expected.substr(1000, 5000));
+
+      // chunks stay bounded in size (and so in number)
+      CHECK(rope.chunkCount() <= expected.size() / 2048 + 2);
+   }
+
+   SECTION("Out of range replacements are rejected")
+   {
+      text::Rope rope("hello");
+      CHECK_FALSE(rope.replace(6, 0, "x"));
+      CHECK_FALSE(rope.replace(3, 3, "x"));
+      CHECK(rope.str() == "hello");
+
+      CHECK(rope.replace(5, 0, " world"));
+      CHECK(rope.replace(0, 1, "H"));
+      CHECK(rope.str() == "Hello world");
+
+      CHECK(rope.replace(0, rope.size(), ""));
+      CHECK(rope.empty());
+      CHECK(rope.crc32() == hash::crc32("", 0));
+      CHECK(rope.replace(0, 0, "again"));
+      CHECK(rope.str() == "again");
+   }
+
+   SECTION("Copies are independent")
+   {
+      text::Rope original(sampleText(100000));
+      text::Rope copy = original;
+      CHECK(copy == original);
+
+      REQUIRE(original.replace(50000, 10, "edit"));
+      CHECK(copy != original);
+      CHECK(copy.str() == sampleText(100000));
+
+      // equal text with different chunking compares equal
+      text::Rope reassembled(original.str());
+      CHECK(reassembled == original);
+      CHECK(reassembled.crc32() == original.crc32());
+   }
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
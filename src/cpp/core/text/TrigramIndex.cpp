@@ -0,0 +1,534 @@
+/*
+ * TrigramIndex.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/TrigramIndex.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <core/FileSerializer.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace core {
+namespace text {
+
+namespace {
+
+// bump whenever the file format changes
+const char * const kIndexFileHeader = "rstudio-trigram-index-1\n";
+
+inline unsigned char foldCase(unsigned char ch)
+{
+   return (ch >= 'A' && ch <= 'Z') ? static_cast<unsigned char>(ch + ('a' - 'A')) : ch;
+}
+
+inline uint32_t trigramAt(const unsigned char* pData)
+{
+   return (static_cast<uint32_t>(foldCase(pData[0])) << 16) |
+          (static_cast<uint32_t>(foldCase(pData[1])) << 8) |
+           static_cast<uint32_t>(foldCase(pData[2]));
+}
+
+inline bool isAsciiTrigram(uint32_t trigram)
+{
+   return (trigram & 0x808080) == 0;
+}
+
+void extractTrigrams(const std::string& text, std::vector<uint32_t>* pTrigrams)
+{
+   pTrigrams->clear();
+   if (text.size() < 3)
+      return;
+
+   const unsigned char* pData = reinterpret_cast<const unsigned char*>(text.data());
+   std::size_t count = text.size() - 2;
+   pTrigrams->reserve(count);
+   for (std::size_t i = 0; i < count; i++)
+      pTrigrams->push_back(trigramAt(pData + i));
+
+   std::sort(pTrigrams->begin(), pTrigrams->end());
+   pTrigrams->erase(std::unique(pTrigrams->begin(), pTrigrams->end()),
+                    pTrigrams->end());
+}
+
+void insertSorted(std::vector<uint32_t>* pIds, uint32_t id)
+{
+   std::vector<uint32_t>::iterator it = std::lower_bound(pIds->begin(), pIds->end(), id);
+   if (it == pIds->end() || *it != id)
+      pIds->insert(it, id);
+}
+
+void eraseSorted(std::vector<uint32_t>* pIds, uint32_t id)
+{
+   std::vector<uint32_t>::iterator it = std::lower_bound(pIds->begin(), pIds->end(), id);
+   if (it != pIds->end() && *it == id)
+      pIds->erase(it);
+}
+
+// serialization helpers (fixed width, little endian)
+
+void appendInt(uint64_t value, int bytes, std::string* pOutput)
+{
+   for (int i = 0; i < bytes; i++)
+      pOutput->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+void appendString(const std::string& value, std::string* pOutput)
+{
+   appendInt(value.size(), 4, pOutput);
+   pOutput->append(value);
+}
+
+class Reader
+{
+public:
+   explicit Reader(const std::string& data)
+      : data_(data), pos_(0), ok_(true)
+   {
+   }
+
+   bool ok() const { return ok_; }
+   bool atEnd() const { return pos_ >= data_.size(); }
+
+   uint64_t readInt(int bytes)
+   {
+      if (!ok_ || data_.size() - pos_ < static_cast<std::size_t>(bytes))
+      {
+         ok_ = false;
+         return 0;
+      }
+
+      uint64_t value = 0;
+      for (int i = 0; i < bytes; i++)
+         value |= static_cast<uint64_t>(static_cast<unsigned char>(data_[pos_++])) << (8 * i);
+      return value;
+   }
+
+   std::string readString()
+   {
+      std::size_t length = static_cast<std::size_t>(readInt(4));
+      if (!ok_ || data_.size() - pos_ < length)
+      {
+         ok_ = false;
+         return std::string();
+      }
+
+      std::string value = data_.substr(pos_, length);
+      pos_ += length;
+      return value;
+   }
+
+private:
+   const std::string& data_;
+   std::size_t pos_;
+   bool ok_;
+};
+
+} // anonymous namespace
+
+TrigramIndex::TrigramIndex()
+{
+}
+
+uint32_t TrigramIndex::allocateEntry(const std::string& path)
+{
+   std::unordered_map<std::string, uint32_t>::iterator it = pathIds_.find(path);
+   if (it != pathIds_.end())
+   {
+      removePostings(it->second);
+      return it->second;
+   }
+
+   uint32_t id;
+   if (!freeIds_.empty())
+   {
+      id = freeIds_.back();
+      freeIds_.pop_back();
+   }
+   else
+   {
+      id = static_cast<uint32_t>(entries_.size());
+      entries_.push_back(Entry());
+   }
+
+   entries_[id].path = path;
+   pathIds_[path] = id;
+   return id;
+}
+
+void TrigramIndex::addPostings(uint32_t id)
+{
+   const Entry& entry = entries_[id];
+   if (!(entry.flags & kEntryIndexed))
+   {
+      if (!(entry.flags & kEntryBinary))
+         insertSorted(&unindexed_, id);
+      return;
+   }
+
+   for (uint32_t trigram : entry.trigrams)
+      insertSorted(&postings_[trigram], id);
+}
+
+void TrigramIndex::removePostings(uint32_t id)
+{
+   Entry& entry = entries_[id];
+   if (!(entry.flags & kEntryIndexed))
+      eraseSorted(&unindexed_, id);
+
+   for (uint32_t trigram : entry.trigrams)
+   {
+      std::unordered_map<uint32_t, std::vector<uint32_t> >::iterator it =
+            postings_.find(trigram);
+      if (it == postings_.end())
+         continue;
+
+      eraseSorted(&it->second, id);
+      if (it->second.empty())
+         postings_.erase(it);
+   }
+
+   entry.trigrams.clear();
+   entry.flags = 0;
+}
+
+void TrigramIndex::update(const std::string& path,
+                          std::time_t lastWriteTime,
+                          uintmax_t size,
+                          const std::string& contents)
+{
+   uint32_t id = allocateEntry(path);
+   Entry& entry = entries_[id];
+   entry.lastWriteTime = lastWriteTime;
+   entry.size = size;
+
+   if (contents.find('\0') != std::string::npos)
+   {
+      entry.flags = kEntryIndexed | kEntryBinary;
+   }
+   else
+   {
+      entry.flags = kEntryIndexed;
+      extractTrigrams(contents, &entry.trigrams);
+   }
+
+   addPostings(id);
+}
+
+void TrigramIndex::updateUnindexed(const std::string& path,
+                                   std::time_t lastWriteTime,
+                                   uintmax_t size)
+{
+   uint32_t id = allocateEntry(path);
+   Entry& entry = entries_[id];
+   entry.lastWriteTime = lastWriteTime;
+   entry.size = size;
+   entry.flags = 0;
+   addPostings(id);
+}
+
+void TrigramIndex::remove(const std::string& path)
+{
+   std::unordered_map<std::string, uint32_t>::iterator it = pathIds_.find(path);
+   if (it == pathIds_.end())
+      return;
+
+   uint32_t id = it->second;
+   removePostings(id);
+   entries_[id] = Entry();
+   freeIds_.push_back(id);
+   pathIds_.erase(it);
+}
+
+void TrigramIndex::clear()
+{
+   entries_.clear();
+   freeIds_.clear();
+   pathIds_.clear();
+   postings_.clear();
+   unindexed_.clear();
+}
+
+bool TrigramIndex::isCurrent(const std::string& path,
+                             std::time_t lastWriteTime,
+                             uintmax_t size) const
+{
+   std::unordered_map<std::string, uint32_t>::const_iterator it = pathIds_.find(path);
+   if (it == pathIds_.end())
+      return false;
+
+   const Entry& entry = entries_[it->second];
+   return entry.lastWriteTime == lastWriteTime && entry.size == size;
+}
+
+void TrigramIndex::paths(std::vector<std::string>* pPaths) const
+{
+   pPaths->reserve(pPaths->size() + pathIds_.size());
+   for (const auto& pathId : pathIds_)
+      pPaths->push_back(pathId.first);
+}
+
+void TrigramIndex::candidates(const std::string& literal,
+                              bool ignoreCase,
+                              std::vector<std::string>* pPaths) const
+{
+   std::vector<uint32_t> trigrams;
+   extractTrigrams(literal, &trigrams);
+   if (ignoreCase)
+   {
+      trigrams.erase(std::remove_if(trigrams.begin(),
+                                    trigrams.end(),
+                                    [](uint32_t trigram) { return !isAsciiTrigram(trigram); }),
+                     trigrams.end());
+   }
+
+   std::vector<uint32_t> ids;
+   if (trigrams.empty())
+   {
+      // nothing to narrow the search with; every searchable file is a candidate
+      for (const auto& pathId : pathIds_)
+      {
+         if (!(entries_[pathId.second].flags & kEntryBinary))
+            ids.push_back(pathId.second);
+      }
+   }
+   else
+   {
+      // intersect posting lists, starting with the shortest
+      std::vector<const std::vector<uint32_t>*> lists;
+      for (uint32_t trigram : trigrams)
+      {
+         std::unordered_map<uint32_t, std::vector<uint32_t> >::const_iterator it =
+               postings_.find(trigram);
+         if (it == postings_.end())
+         {
+            lists.clear();
+            break;
+         }
+         lists.push_back(&it->second);
+      }
+
+      if (!lists.empty())
+      {
+         std::sort(lists.begin(),
+                   lists.end(),
+                   [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b)
+                   {
+                      return a->size() < b->size();
+                   });
+
+         ids = *lists[0];
+         std::vector<uint32_t> intersection;
+         for (std::size_t i = 1; i < lists.size() && !ids.empty(); i++)
+         {
+            intersection.clear();
+            std::set_intersection(ids.begin(), ids.end(),
+                                  lists[i]->begin(), lists[i]->end(),
+                                  std::back_inserter(intersection));
+            ids.swap(intersection);
+         }
+      }
+
+      ids.insert(ids.end(), unindexed_.begin(), unindexed_.end());
+   }
+
+   pPaths->reserve(pPaths->size() + ids.size());
+   for (uint32_t id : ids)
+      pPaths->push_back(entries_[id].path);
+}
+
+Error TrigramIndex::writeToFile(const FilePath& filePath) const
+{
+   std::string data(kIndexFileHeader);
+   appendInt(pathIds_.size(), 4, &data);
+   for (const auto& pathId : pathIds_)
+   {
+      const Entry& entry = entries_[pathId.second];
+      appendString(entry.path, &data);
+      appendInt(static_cast<uint64_t>(entry.lastWriteTime), 8, &data);
+      appendInt(entry.size, 8, &data);
+      appendInt(entry.flags, 4, &data);
+      appendInt(entry.trigrams.size(), 4, &data);
+      for (uint32_t trigram : entry.trigrams)
+         appendInt(trigram, 3, &data);
+   }
+
+   return writeStringToFile(filePath, data);
+}
+
+Error TrigramIndex::readFromFile(const FilePath& filePath)
+{
+   clear();
+
+   std::string data;
+   Error error = readStringFromFile(filePath, &data);
+   if (error)
+      return error;
+
+   std::size_t headerSize = std::strlen(kIndexFileHeader);
+   if (data.compare(0, headerSize, kIndexFileHeader) != 0)
+      return Success();
+
+   std::string body = data.substr(headerSize);
+   Reader bodyReader(body);
+
+   uint64_t count = bodyReader.readInt(4);
+   for (uint64_t i = 0; i < count && bodyReader.ok(); i++)
+   {
+      Entry entry;
+      entry.path = bodyReader.readString();
+      entry.lastWriteTime = static_cast<std::time_t>(bodyReader.readInt(8));
+      entry.size = static_cast<uintmax_t>(bodyReader.readInt(8));
+      entry.flags = static_cast<uint32_t>(bodyReader.readInt(4));
+      uint64_t trigramCount = bodyReader.readInt(4);
+      for (uint64_t j = 0; j < trigramCount && bodyReader.ok(); j++)
+         entry.trigrams.push_back(static_cast<uint32_t>(bodyReader.readInt(3)));
+
+      if (!bodyReader.ok())
+         break;
+
+      uint32_t id = allocateEntry(entry.path);
+      entries_[id] = entry;
+      addPostings(id);
+   }
+
+   // discard a truncated or corrupt index rather than trust part of it
+   if (!bodyReader.ok() || !bodyReader.atEnd())
+      clear();
+
+   return Success();
+}
+
+std::string requiredLiteral(const std::string& basicRegex)
+{
+   std::string best;
+   std::string current;
+
+   auto endRun = [&]()
+   {
+      if (current.size() > best.size())
+         best = current;
+      current.clear();
+   };
+
+   // a quantifier which allows zero occurrences makes the preceding
+   // (possibly multibyte) character optional
+   auto dropLastCharacter = [&]()
+   {
+      while (!current.empty() && (static_cast<unsigned char>(current.back()) & 0xC0) == 0x80)
+         current.pop_back();
+      if (!current.empty())
+         current.pop_back();
+   };
+
+   const std::size_t n = basicRegex.size();
+   for (std::size_t i = 0; i < n; i++)
+   {
+      char ch = basicRegex[i];
+      switch (ch)
+      {
+      case '\n':
+         // multiple patterns
+         return std::string();
+
+      case '\\':
+      {
+         if (i + 1 >= n)
+            return std::string();
+
+         char next = basicRegex[++i];
+         if (next == '|')
+            return std::string();
+         else if (std::strchr(".[]*^$\\/", next))
+            current.push_back(next);
+         else if (next == '?' || next == '{')
+         {
+            dropLastCharacter();
+            endRun();
+            if (next == '{')
+            {
+               std::size_t close = basicRegex.find("\\}", i);
+               if (close == std::string::npos)
+                  return std::string();
+               i = close + 1;
+            }
+         }
+         else
+         {
+            // '\+' (the preceding character is still required), groups,
+            // back references, word boundaries and character classes
+            endRun();
+         }
+         break;
+      }
+
+      case '[':
+      {
+         // skip the bracket expression; ']' is literal when first
+         std::size_t j = i + 1;
+         if (j < n && basicRegex[j] == '^')
+            j++;
+         if (j < n && basicRegex[j] == ']')
+            j++;
+         while (j < n && basicRegex[j] != ']')
+         {
+            if (basicRegex[j] == '[' && j + 1 < n &&
+                (basicRegex[j + 1] == ':' || basicRegex[j + 1] == '.' || basicRegex[j + 1] == '='))
+            {
+               std::size_t close = basicRegex.find(std::string(1, basicRegex[j + 1]) + "]", j + 2);
+               if (close == std::string::npos)
+                  return std::string();
+               j = close + 2;
+            }
+            else
+            {
+               j++;
+            }
+         }
+         if (j >= n)
+            return std::string();
+
+         i = j;
+         endRun();
+         break;
+      }
+
+      case '*':
+         dropLastCharacter();
+         endRun();
+         break;
+
+      case '.':
+      case '^':
+      case '$':
+         endRun();
+         break;
+
+      default:
+         current.push_back(ch);
+         break;
+      }
+   }
+
+   endRun();
+   return best;
+}
+
+} // namespace text
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,205 @@
+/*
+ * TrigramIndexTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <core/text/TrigramIndex.hpp>
+
+#include <algorithm>
+
+#include <core/FileSerializer.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+std::vector<std::string> candidates(const text::TrigramIndex& index,
+                                    const std::string& literal,
+                                    bool ignoreCase = false)
+{
+   std::vector<std::string> paths;
+   index.candidates(literal, ignoreCase, &paths);
+   std::sort(paths.begin(), paths.end());
+   return paths;
+}
+
+std::vector<std::string> paths(std::initializer_list<std::string> values)
+{
+   return std::vector<std::string>(values);
+}
+
+} // anonymous namespace
+
+TEST_CASE("TrigramIndex")
+{
+   SECTION("Narrows candidates to files containing every trigram")
+   {
+      text::TrigramIndex index;
+      index.update("/a.R", 1, 10, "library(dplyr)\nmutate(df)");
+      index.update("/b.R", 1, 10, "x <- filter(df, y)");
+      index.update("/c.R", 1, 10, "mutable");
+
+      CHECK(candidates(index, "mutate") == paths({"/a.R"}));
+      CHECK(candidates(index, "mut") == paths({"/a.R", "/c.R"}));
+      CHECK(candidates(index, "(df") == paths({"/a.R", "/b.R"}));
+      CHECK(candidates(index, "summarise").empty());
+
+      // trigrams must all be present, but not necessarily adjacent
+      CHECK(candidates(index, "mutable df").empty());
+      CHECK(candidates(index, "mutable") == paths({"/c.R"}));
+   }
+
+   SECTION("Short literals match every searchable file")
+   {
+      text::TrigramIndex index;
+      index.update("/a.R", 1, 10, "abc");
+      index.update("/b.R", 1, 10, "xyz");
+      index.update("/c.bin", 1, 10, std::string("ab\0c", 4));
+
+      CHECK(candidates(index, "q") == paths({"/a.R", "/b.R"}));
+      CHECK(candidates(index, "") == paths({"/a.R", "/b.R"}));
+   }
+
+   SECTION("Candidates ignore ASCII case")
+   {
+      text::TrigramIndex index;
+      index.update("/a.R", 1, 10, "ReadRDS(path)");
+
+      CHECK(candidates(index, "readrds") == paths({"/a.R"}));
+      CHECK(candidates(index, "READRDS", true) == paths({"/a.R"}));
+   }
+
+   SECTION("Non-ASCII trigrams are skipped when ignoring case")
+   {
+      text::TrigramIndex index;
+      index.update("/a.txt", 1, 10, "\xC3\x89t\xC3\xA9");  // "Été"
+      index.update("/b.txt", 1, 10, "\xC3\xA9t\xC3\xA9");  // "été"
+
+      CHECK(candidates(index, "\xC3\xA9t\xC3\xA9") == paths({"/b.txt"}));
+      CHECK(candidates(index, "\xC3\xA9t\xC3\xA9", true) == paths({"/a.txt", "/b.txt"}));
+   }
+
+   SECTION("Updates and removals are reflected in candidates")
+   {
+      text::TrigramIndex index;
+      index.update("/a.R", 1, 10, "old contents");
+      CHECK(candidates(index, "old") == paths({"/a.R"}));
+
+      index.update("/a.R", 2, 12, "new contents");
+      CHECK(candidates(index, "old").empty());
+      CHECK(candidates(index, "new") == paths({"/a.R"}));
+      CHECK(index.size() == 1);
+
+      index.update("/b.R", 1, 10, "new file");
+      index.remove("/a.R");
+      CHECK(candidates(index, "new") == paths({"/b.R"}));
+      CHECK(candidates(index, "contents").empty());
+      CHECK(index.size() == 1);
+
+      // ids are reused
+      index.update("/c.R", 1, 10, "contents again");
+      CHECK(candidates(index, "contents") == paths({"/c.R"}));
+   }
+
+   SECTION("Unindexed files are always candidates; binary files never are")
+   {
+      text::TrigramIndex index;
+      index.update("/a.R", 1, 10, "hello world");
+      index.updateUnindexed("/big.csv", 1, 100000000);
+      index.update("/data.rds", 1, 10, std::string("hello\0world", 11));
+
+      CHECK(candidates(index, "hello") == paths({"/a.R", "/big.csv"}));
+      CHECK(candidates(index, "goodbye") == paths({"/big.csv"}));
+
+      // indexing a previously unindexed file
+      index.update("/big.csv", 2, 10, "a,b,c");
+      CHECK(candidates(index, "goodbye").empty());
+   }
+
+   SECTION("Tracks whether entries are current")
+   {
+      text::TrigramIndex index;
+      index.update("/a.R", 100, 10, "contents");
+
+      CHECK(index.isCurrent("/a.R", 100, 10));
+      CHECK_FALSE(index.isCurrent("/a.R", 101, 10));
+      CHECK_FALSE(index.isCurrent("/a.R", 100, 11));
+      CHECK_FALSE(index.isCurrent("/b.R", 100, 10));
+   }
+
+   SECTION("Can be written to and read from a file")
+   {
+      text::TrigramIndex index;
+      index.update("/a.R", 100, 10, "library(dplyr)");
+      index.update("/b.R", 200, 20, "library(ggplot2)");
+      index.updateUnindexed("/big.csv", 300, 30);
+      index.update("/data.rds", 400, 40, std::string("\0\0\0", 3));
+
+      FilePath indexFile;
+      REQUIRE_FALSE(FilePath::tempFilePath(indexFile));
+      REQUIRE_FALSE(index.writeToFile(indexFile));
+
+      text::TrigramIndex restored;
+      REQUIRE_FALSE(restored.readFromFile(indexFile));
+      CHECK(restored.size() == 4);
+      CHECK(restored.isCurrent("/a.R", 100, 10));
+      CHECK(restored.isCurrent("/data.rds", 400, 40));
+      CHECK(candidates(restored, "library") == paths({"/a.R", "/b.R", "/big.csv"}));
+      CHECK(candidates(restored, "ggplot") == paths({"/b.R", "/big.csv"}));
+
+      // a truncated index is discarded
+      std::string data;
+      REQUIRE_FALSE(readStringFromFile(indexFile, &data));
+      REQUIRE_FALSE(writeStringToFile(indexFile, data.substr(0, data.size() - 5)));
+      REQUIRE_FALSE(restored.readFromFile(indexFile));
+      CHECK(restored.size() == 0);
+
+      indexFile.removeIfExists();
+   }
+
+   SECTION("Extracts the literal required by a basic regex")
+   {
+      CHECK(text::requiredLiteral("hello") == "hello");
+      CHECK(text::requiredLiteral("^hello$") == "hello");
+      CHECK(text::requiredLiteral("read.csv") == "read");
+      CHECK(text::requiredLiteral("read\\.csv") == "read.csv");
+      CHECK(text::requiredLiteral("ab*cdef") == "cdef");
+      CHECK(text::requiredLiteral("abcd\\?ef") == "abc");
+      CHECK(text::requiredLiteral("abcd\\+ef") == "abcd");
+      CHECK(text::requiredLiteral("x\\{2,3\\}yz") == "yz");
+      CHECK(text::requiredLiteral("[a-z]*_function") == "_function");
+      CHECK(text::requiredLiteral("[]abc]xy") == "xy");
+      CHECK(text::requiredLiteral("[[:alpha:]]\\+_test") == "_test");
+      CHECK(text::requiredLiteral("\\(foo\\)bar") == "foo");
+      CHECK(text::requiredLiteral("foo(bar)") == "foo(bar)");
+      CHECK(text::requiredLiteral("\xC3\xA9t\xC3\xA9*") == "\xC3\xA9t");
+
+      // patterns which don't require any particular text
+      CHECK(text::requiredLiteral("foo\\|bar").empty());
+      CHECK(text::requiredLiteral("foo\nbar").empty());
+      CHECK(text::requiredLiteral("[abc").empty());
+      CHECK(text::requiredLiteral("abc\\").empty());
+   }
+}
+
+} // namespace tests
+} // namespace core
+} // namespace rstudio
@@ -418,6 +418,46 @@ void listEnvironment(SEXP env,
    }
 }
 
+void listEnvironmentBindings(SEXP env,
+                             bool includeAll,
+                             bool includeLastDotValue,
+                             std::vector<Binding>* pBindings)
+{
+   pBindings->clear();
+
+   SEXP namesSEXP;
+   Protect rProtect(namesSEXP = R_lsInternal(env, includeAll ? TRUE : FALSE));
+
+   int n = Rf_length(namesSEXP);
+   pBindings->reserve(n + 1);
+   for (int i = 0; i < n; i++)
+   {
+      SEXP symbolSEXP = Rf_install(CHAR(STRING_ELT(namesSEXP, i)));
+
+      SEXP valueSEXP = R_NilValue;
+      if (!R_BindingIsActive(symbolSEXP, env))
+         valueSEXP = Rf_findVarInFrame(env, symbolSEXP);
+
+      if (valueSEXP != R_UnboundValue) // should never be unbound
+      {
+         pBindings->push_back(std::make_pair(symbolSEXP, valueSEXP));
+      }
+      else
+      {
+         LOG_WARNING_MESSAGE(
+                  "Unexpected R_UnboundValue returned from R_lsInternal");
+      }
+   }
+
+   // add in .Last.value if it exists
+   if (!includeAll && includeLastDotValue)
+   {
+      SEXP symbolSEXP = Rf_install(".Last.value");
+      SEXP valueSEXP = Rf_findVar(symbolSEXP, env);
+      if (valueSEXP != R_UnboundValue)
+         pBindings->push_back(std::make_pair(symbolSEXP, valueSEXP));
+   }
+}
 
 void listNamedAttributes(SEXP obj, Protect *pProtect, std::vector<Variable>* pVariables)
 {
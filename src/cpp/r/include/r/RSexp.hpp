@@ -64,6 +64,18 @@ void listEnvironment(SEXP env,
                      bool includeLastDotValue,
                      Protect* pProtect,
                      std::vector<Variable>* pVariables);
+
+// (symbol, value) pairs for the variables within an environment. symbols are
+// never collected, so unlike names they can be compared by identity from one
+// listing to the next; no names are copied, so this is much cheaper than
+// listEnvironment for large environments. the values are not protected
+// beyond being bound in the environment (active bindings are not fired, and
+// have a value of nil)
+typedef std::pair<SEXP,SEXP> Binding;
+void listEnvironmentBindings(SEXP env,
+                             bool includeAll,
+                             bool includeLastDotValue,
+                             std::vector<Binding>* pBindings);
       
 // object info
 SEXP findVar(const std::string& name,
@@ -295,8 +295,10 @@ void httpServerAddHandlers()
    // initialize gwt symbol maps
    gwt::initializeSymbolMaps(server::options().wwwSymbolMapsPath());
 
-   // add default handler for gwt app
+   // add default handler for gwt app (compressing its files up front, as
+   // many users may request them at once when the server comes up)
    uri_handlers::setBlockingDefault(blockingFileHandler());
+   gwt::precacheFiles(server::options().wwwLocalPath());
 }
 
 Error initLog()
@@ -16,6 +16,7 @@
 #include "ServerPAMAuthOverlay.hpp"
 
 #include <core/Thread.hpp>
+#include <core/collection/LruCache.hpp>
 #include <core/system/Process.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/system/Crypto.hpp>
@@ -72,16 +73,24 @@ std::string getUserIdentifier(const core::http::Request& request)
    return auth::common::getUserIdentifier(request);
 }
 
+typedef core::collection::LruCache<std::string, std::string> UsernameCache;
+
+UsernameCache::Options usernameCacheOptions()
+{
+   // bounded, and expiring so that changes to the user database are seen
+   UsernameCache::Options options;
+   options.maxSize = 4096;
+   options.shards = 16;
+   options.timeToLive = boost::posix_time::minutes(5);
+   return options;
+}
+
 std::string userIdentifierToLocalUsername(const std::string& userIdentifier)
 {
-   static core::thread::ThreadsafeMap<std::string, std::string> cache;
+   static UsernameCache cache(usernameCacheOptions());
    std::string username = userIdentifier;
 
-   if (cache.contains(userIdentifier)) 
-   {
-      username = cache.get(userIdentifier);
-   }
-   else
+   if (!cache.get(userIdentifier, &username))
    {
       // The username returned from this function is eventually used to create
       // a local stream path, so it's important that it agree with the system
@@ -103,7 +112,7 @@ std::string userIdentifierToLocalUsername(const std::string& userIdentifier)
       // cache the username -- we do this even if the lookup fails since
       // otherwise we're likely to keep hitting (and logging) the error on
       // every request
-      cache.set(userIdentifier, username);
+      cache.insert(userIdentifier, username);
    }
 
    return username;
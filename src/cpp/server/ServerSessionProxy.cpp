@@ -37,6 +37,8 @@
 #include <core/Thread.hpp>
 #include <core/WaitUtils.hpp>
 #include <core/RegexUtils.hpp>
+#include <core/PeriodicCommand.hpp>
+#include <core/collection/LruCache.hpp>
 
 #include <core/http/CSRFToken.hpp>
 #include <core/http/SocketUtils.hpp>
@@ -44,6 +46,7 @@
 #include <core/http/Request.hpp>
 #include <core/http/Response.hpp>
 #include <core/http/LocalStreamAsyncClient.hpp>
+#include <core/http/LocalStreamConnectionPool.hpp>
 #include <core/http/Util.hpp>
 #include <core/http/URL.hpp>
 #include <core/http/ChunkProxy.hpp>
@@ -70,6 +73,7 @@
 #include <server/ServerErrorCategory.hpp>
 
 #include <server/ServerSessionManager.hpp>
+#include <server/ServerScheduler.hpp>
 
 #include <server/ServerConstants.hpp>
 
@@ -597,15 +601,24 @@ void handleEventsError(
    ptrConnection->writeResponse();
 }
 
+typedef core::collection::LruCache<std::string, UidType> UserIdCache;
+
+UserIdCache::Options userIdCacheOptions()
+{
+   // this is consulted on every proxied request, so keep recent lookups
+   // (bounded, and expiring so that changes to the user database are seen)
+   UserIdCache::Options options;
+   options.maxSize = 4096;
+   options.shards = 16;
+   options.timeToLive = boost::posix_time::minutes(5);
+   return options;
+}
+
 Error userIdForUsername(const std::string& username, UidType* pUID)
 {
-   static core::thread::ThreadsafeMap<std::string, UidType> cache;
+   static UserIdCache cache(userIdCacheOptions());
 
-   if (cache.contains(username))
-   {
-      *pUID = cache.get(username);
-   }
-   else
+   if (!cache.get(username, pUID))
    {
       core::system::User user;
       Error error = core::system::User::getUserFromIdentifier(username, user);
@@ -613,12 +626,35 @@ Error userIdForUsername(const std::string& username, UidType* pUID)
          return error;
 
       *pUID = user.getUserId();
-      cache.set(username, *pUID);
+      cache.insert(username, *pUID);
    }
 
    return Success();
 }
 
+// idle connections to session streams (null if connection reuse is disabled)
+boost::shared_ptr<http::LocalStreamConnectionPool> s_pConnectionPool;
+
+bool pruneSessionConnections()
+{
+   s_pConnectionPool->pruneIdleConnections();
+
+   http::LocalStreamConnectionPool::Statistics stats =
+         s_pConnectionPool->statistics();
+   LOG_DEBUG_MESSAGE("Session connection pool: " +
+                     safe_convert::numberToString(stats.connectionsOpened) + " opened, " +
+                     safe_convert::numberToString(stats.connectionsReused) + " reused (" +
+                     safe_convert::numberToString(stats.reuseRatio()) + " reuse ratio), " +
+                     safe_convert::numberToString(stats.connectionsDiscarded) + " discarded, " +
+                     safe_convert::numberToString(stats.idleConnections) + " idle (" +
+                     safe_convert::numberToString(stats.peakIdleConnections) + " peak), " +
+                     safe_convert::numberToString(stats.requestsInFlight) + " requests in flight (" +
+                     safe_convert::numberToString(stats.peakRequestsInFlight) + " peak)");
+
+   // keep pruning
+   return true;
+}
+
 void proxyRequest(
       int requestType,
       const r_util::SessionContext& context,
@@ -684,9 +720,16 @@ void proxyRequest(
    // create client
    // if the user is available on the system pass in the uid for validation to ensure
    // that we only connect to the socket if it was created by the user
-   boost::shared_ptr<http::IAsyncClient> pClient(new http::LocalStreamAsyncClient(
-                                                    ptrConnection->ioService(),
-                                                    streamPath, false, validateUid));
+   boost::shared_ptr<http::LocalStreamAsyncClient> pLocalStreamClient(
+            new http::LocalStreamAsyncClient(ptrConnection->ioService(),
+                                             streamPath, false, validateUid));
+
+   // reuse idle connections to the session where possible. we don't do this
+   // when the caller takes ownership of the client (e.g. to stream uploads)
+   if (s_pConnectionPool && !clientHandler)
+      pLocalStreamClient->setConnectionPool(s_pConnectionPool);
+
+   boost::shared_ptr<http::IAsyncClient> pClient = pLocalStreamClient;
 
    // setup retry context
    if (!connectionRetryProfile.empty())
@@ -768,6 +811,23 @@ http::Headers getAuthCookies(const http::Response& response)
 
 Error initialize()
 { 
+   int maxIdleConnections = server::options().rsessionProxyMaxIdleConnections();
+   if (maxIdleConnections > 0)
+   {
+      s_pConnectionPool.reset(new http::LocalStreamConnectionPool(
+                                 maxIdleConnections,
+                                 boost::posix_time::minutes(5)));
+
+      // (sessions close connections after a minute idle, which the pool
+      // notices when it checks a connection before reusing it)
+
+      // periodically close connections to sessions which have gone away
+      scheduler::addCommand(
+         boost::shared_ptr<ScheduledCommand>(new PeriodicCommand(
+            boost::posix_time::seconds(30), pruneSessionConnections, false))
+      );
+   }
+
    return server_core::sessions::local_streams::ensureStreamsDir();
 }
 
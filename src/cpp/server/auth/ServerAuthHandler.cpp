@@ -24,14 +24,17 @@
 #include <core/FileLock.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/json/JsonRpc.hpp>
+#include <core/PeriodicCommand.hpp>
 #include <core/system/PosixUser.hpp>
 #include <core/Thread.hpp>
 
 #include <server_core/ServerDatabase.hpp>
+#include <server_core/http/RevokedCookieSet.hpp>
 
 #include <server/ServerConstants.hpp>
 #include <server/ServerObject.hpp>
 #include <server/ServerOptions.hpp>
+#include <server/ServerScheduler.hpp>
 #include <server/ServerUriHandlers.hpp>
 
 #include <server/auth/ServerSecureUriHandler.hpp>
@@ -66,9 +69,11 @@ boost::posix_time::ptime cookieExpiration(const std::string& cookie)
 // inordinate amounts of revocation entries
 std::map<std::string, boost::posix_time::ptime> s_loginTimes;
 
-// sorted array of revoked cookies, where the first to expire appears as the first element
-// allows for quickly removing the first element
-std::deque<RevokedCookie> s_revokedCookies;
+// revoked cookies which have yet to expire (consulted on every request)
+http::RevokedCookieSet s_revokedCookies;
+
+// how often expired cookies are removed from the revocation list
+const boost::posix_time::time_duration kRevokedCookieExpiryInterval = boost::posix_time::minutes(1);
 
 // mutex for providing concurrent access to internal structures
 // necessary because auth happens on the thread pool
@@ -94,13 +99,8 @@ void updateCredentialsNotSupported(
    pConnection->writeResponse();
 }
 
-Error readRevocationListFromDatabase(std::vector<std::string>* pEntries)
+Error removeExpiredCookiesFromDatabase(const boost::shared_ptr<IConnection>& connection)
 {
-   // establish a new transaction with the database
-   boost::shared_ptr<IConnection> connection = server_core::database::getConnection();
-   Transaction transaction(connection);
-
-   // first, delete all stale cookies from the database
    std::string expiration = date_time::format(boost::posix_time::microsec_clock::universal_time(),
                                               date_time::kIso8601Format);
    Query deleteQuery = connection->query("DELETE FROM revoked_cookie WHERE expiration <= :val")
@@ -112,6 +112,20 @@ Error readRevocationListFromDatabase(std::vector<std::string>* pEntries)
       return error;
    }
 
+   return Success();
+}
+
+Error readRevocationListFromDatabase(std::vector<std::string>* pEntries)
+{
+   // establish a new transaction with the database
+   boost::shared_ptr<IConnection> connection = server_core::database::getConnection();
+   Transaction transaction(connection);
+
+   // first, delete all stale cookies from the database
+   Error error = removeExpiredCookiesFromDatabase(connection);
+   if (error)
+      return error;
+
    // get all cookie entries from the database
    Query fetchQuery = connection->query("SELECT cookie_data FROM revoked_cookie");
    Rowset rowset;
@@ -132,22 +146,6 @@ Error readRevocationListFromDatabase(std::vector<std::string>* pEntries)
    return Success();
 }
 
-void removeStaleCookieFromDatabase(const RevokedCookie& cookie,
-                                   const boost::shared_ptr<IConnection>& connection)
-{
-   std::string expiration = date_time::format(cookie.expiration, date_time::kIso8601Format);
-   Query query = connection->query("DELETE FROM revoked_cookie WHERE cookie_data = :dat")
-         .withInput(cookie.cookie);
-
-   Error error = connection->execute(query);
-   if (error)
-   {
-      error.addProperty("description", "Could not delete expired revoked cookie from the database");
-      LOG_ERROR(error);
-   }
-}
-
-
 Error writeRevokedCookieToDatabase(const RevokedCookie& cookie,
                                    boost::shared_ptr<IConnection> connection = boost::shared_ptr<IConnection>())
 {
@@ -176,17 +174,12 @@ Error writeRevokedCookiesToDatabase()
    boost::shared_ptr<IConnection> connection = server_core::database::getConnection();
    Transaction transaction(connection);
 
-   LOCK_MUTEX(s_mutex)
+   for (const auto& entry : s_revokedCookies.entries())
    {
-      for (auto it = s_revokedCookies.begin(); it != s_revokedCookies.end(); ++it)
-      {
-         const RevokedCookie& cookie = *it;
-         Error error = writeRevokedCookieToDatabase(cookie, connection);
-         if (error)
-            return error;
-      }
+      Error error = writeRevokedCookieToDatabase(RevokedCookie(entry.first), connection);
+      if (error)
+         return error;
    }
-   END_LOCK_MUTEX
 
    transaction.commit();
    return Success();
@@ -217,54 +210,26 @@ Error readRevocationListFromFile(const FilePath& revocationList,
 
 bool isCookieRevoked(const std::string& cookie)
 {
-   bool attemptedConnection = false;
-   boost::shared_ptr<IConnection> connection;
-   boost::posix_time::ptime now = boost::posix_time::second_clock::universal_time();
+   return s_revokedCookies.contains(cookie);
+}
 
-   LOCK_MUTEX(s_mutex)
-   {
-      // check for cookie in revocation list, deleting expired elements as we go
-      for (auto it = s_revokedCookies.begin(); it != s_revokedCookies.end();)
-      {
-         const RevokedCookie& other = *it;
-         if (other.cookie == cookie)
-            return true;
+bool removeExpiredRevokedCookies()
+{
+   if (s_revokedCookies.removeExpired() == 0)
+      return true;
 
-         if (other.expiration <= now)
-         {
-            if (!attemptedConnection)
-            {
-               // grab a connection from the pool, but only wait for a short amount of time
-               // this ensures that we do not delay the sign in process too long - deleting stale
-               // cookies from the database immediately is not of critical importance, as this operation will
-               // be retried on all subsequent auths / process restarts
-               server_core::database::getConnection(boost::posix_time::milliseconds(500), &connection);
-               attemptedConnection = true;
-            }
-
-            if (connection)
-            {
-               removeStaleCookieFromDatabase(other, connection);
-
-               // we only erase cookies from the memory map if they were also removed from the database
-               // to ensure that if we couldn't delete them immediately, we retry the operation later
-               it = s_revokedCookies.erase(it);
-               continue;
-            }
-            else
-            {
-               ++it;
-            }
-         }
-         else
-         {
-            ++it;
-         }
-      }
+   // expired cookies are deleted from the database in one statement; if we
+   // can't get a connection quickly they'll be deleted on a later pass (or
+   // when the revocation list is next read)
+   boost::shared_ptr<IConnection> connection;
+   if (server_core::database::getConnection(boost::posix_time::milliseconds(500), &connection))
+   {
+      Error error = removeExpiredCookiesFromDatabase(connection);
+      if (error)
+         LOG_ERROR(error);
    }
-   END_LOCK_MUTEX
 
-   return false;
+   return true;
 }
 
 } // anonymous namespace
@@ -508,26 +473,8 @@ void refreshAuthCookies(const std::string& userIdentifier,
 
 void insertRevokedCookie(const RevokedCookie& cookie)
 {
-   // do not insert the cookie if it is already expired
-   if (cookie.expiration <= boost::posix_time::second_clock::universal_time())
-      return;
-
-   LOCK_MUTEX(s_mutex)
-   {
-      for (auto it = s_revokedCookies.begin(); it != s_revokedCookies.end(); ++it)
-      {
-         const RevokedCookie& other = *it;
-         if (other.expiration > cookie.expiration)
-         {
-            s_revokedCookies.insert(it, cookie);
-            return;
-         }
-      }
-
-      // no elements were greater - insert at the end
-      s_revokedCookies.insert(s_revokedCookies.end(), cookie);
-   }
-   END_LOCK_MUTEX
+   // (cookies which have already expired are not inserted)
+   s_revokedCookies.insert(cookie.cookie, cookie.expiration);
 }
 
 void invalidateAuthCookie(const std::string& cookie,
@@ -635,6 +582,11 @@ Error initialize()
             LOG_ERROR(error);
       }
 
+      // periodically remove expired cookies from the revocation list
+      scheduler::addCommand(
+         boost::shared_ptr<ScheduledCommand>(new PeriodicCommand(
+            kRevokedCookieExpiryInterval, removeExpiredRevokedCookies, false)));
+
       return overlay::initialize();
    }
 
@@ -155,6 +155,9 @@ protected:
       ("rsession-proxy-max-wait-secs",
       value<int>(&rsessionProxyMaxWaitSeconds_)->default_value(10),
       "The maximum time to wait in seconds for a successful response when proxying requests to rsession.")
+      ("rsession-proxy-max-idle-connections",
+      value<int>(&rsessionProxyMaxIdleConnections_)->default_value(4),
+      "The maximum number of idle connections to keep open to each rsession for reuse by subsequent proxied requests. Set to 0 to open a new connection for every request.")
       ("rsession-memory-limit-mb",
       value<int>(&deprecatedMemoryLimitMb_)->default_value(0),
       "The limit in MB that an rsession process may consume.")
@@ -259,6 +262,7 @@ public:
    std::string rsessionLdLibraryPath() const { return rsessionLdLibraryPath_; }
    std::string rsessionConfigFile() const { return rsessionConfigFile_; }
    int rsessionProxyMaxWaitSeconds() const { return rsessionProxyMaxWaitSeconds_; }
+   int rsessionProxyMaxIdleConnections() const { return rsessionProxyMaxIdleConnections_; }
    std::string databaseConfigFile() const { return databaseConfigFile_; }
    bool authNone() const { return authNone_; }
    bool authValidateUsers() const { return authValidateUsers_; }
@@ -307,6 +311,7 @@ protected:
    std::string rsessionLdLibraryPath_;
    std::string rsessionConfigFile_;
    int rsessionProxyMaxWaitSeconds_;
+   int rsessionProxyMaxIdleConnections_;
    int deprecatedMemoryLimitMb_;
    int deprecatedStackLimitMb_;
    int deprecatedUserProcessLimit_;
@@ -0,0 +1,206 @@
+/*
+ * RevokedCookieSet.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <server_core/http/RevokedCookieSet.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include <boost/cstdint.hpp>
+
+#include <core/Thread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+namespace {
+
+// 16 bits per cookie with 4 hashes gives a false positive rate of about
+// 0.25% when the filter is at capacity
+const std::size_t kBitsPerCookie = 16;
+const std::size_t kHashes = 4;
+const std::size_t kMinCapacity = 1024;
+
+} // anonymous namespace
+
+class RevokedCookieSet::BloomFilter : boost::noncopyable
+{
+public:
+   explicit BloomFilter(std::size_t capacity)
+      : words_((capacity * kBitsPerCookie + 63) / 64),
+        capacity_(capacity)
+   {
+      for (std::atomic<boost::uint64_t>& word : words_)
+         word.store(0, std::memory_order_relaxed);
+   }
+
+   std::size_t capacity() const { return capacity_; }
+
+   void add(const std::string& cookie)
+   {
+      std::size_t bits = words_.size() * 64;
+      std::size_t hash = std::hash<std::string>()(cookie);
+      std::size_t step = secondHash(hash);
+      for (std::size_t i = 0; i < kHashes; i++, hash += step)
+      {
+         std::size_t bit = hash % bits;
+         words_[bit / 64].fetch_or(boost::uint64_t(1) << (bit % 64), std::memory_order_relaxed);
+      }
+   }
+
+   bool mightContain(const std::string& cookie) const
+   {
+      std::size_t bits = words_.size() * 64;
+      std::size_t hash = std::hash<std::string>()(cookie);
+      std::size_t step = secondHash(hash);
+      for (std::size_t i = 0; i < kHashes; i++, hash += step)
+      {
+         std::size_t bit = hash % bits;
+         boost::uint64_t word = words_[bit / 64].load(std::memory_order_relaxed);
+         if ((word & (boost::uint64_t(1) << (bit % 64))) == 0)
+            return false;
+      }
+      return true;
+   }
+
+private:
+   // derive the remaining hashes from the first (double hashing)
+   static std::size_t secondHash(std::size_t hash)
+   {
+      boost::uint64_t mixed = static_cast<boost::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+      return static_cast<std::size_t>(mixed >> 32) | 1;
+   }
+
+   std::vector<std::atomic<boost::uint64_t> > words_;
+   const std::size_t capacity_;
+};
+
+RevokedCookieSet::RevokedCookieSet()
+   : pFilter_(new BloomFilter(kMinCapacity))
+{
+}
+
+RevokedCookieSet::~RevokedCookieSet()
+{
+}
+
+bool RevokedCookieSet::insert(const std::string& cookie,
+                              const boost::posix_time::ptime& expiration,
+                              const boost::posix_time::ptime& now)
+{
+   if (expiration <= now)
+      return false;
+
+   LOCK_MUTEX(mutex_)
+   {
+      auto result = cookies_.emplace(cookie, expiration);
+      if (!result.second)
+         return false;
+
+      expirations_.emplace(expiration, &result.first->first);
+
+      // add to the filter before the cookie can be looked up (rebuilding the
+      // filter if it has reached its capacity)
+      if (cookies_.size() > pFilter_->capacity())
+         rebuildFilter();
+      else
+         pFilter_->add(cookie);
+
+      return true;
+   }
+   END_LOCK_MUTEX
+
+   return false;
+}
+
+bool RevokedCookieSet::contains(const std::string& cookie) const
+{
+   boost::shared_ptr<BloomFilter> pFilter = boost::atomic_load(&pFilter_);
+   if (!pFilter->mightContain(cookie))
+      return false;
+
+   LOCK_MUTEX(mutex_)
+   {
+      return cookies_.find(cookie) != cookies_.end();
+   }
+   END_LOCK_MUTEX
+
+   return false;
+}
+
+std::size_t RevokedCookieSet::removeExpired(const boost::posix_time::ptime& now)
+{
+   std::size_t removed = 0;
+
+   LOCK_MUTEX(mutex_)
+   {
+      auto it = expirations_.begin();
+      for (; it != expirations_.end() && it->first <= now; ++it)
+      {
+         cookies_.erase(cookies_.find(*it->second));
+         removed++;
+      }
+      expirations_.erase(expirations_.begin(), it);
+
+      // a bloom filter can't forget cookies, so rebuild it without them
+      if (removed > 0)
+         rebuildFilter();
+   }
+   END_LOCK_MUTEX
+
+   return removed;
+}
+
+std::size_t RevokedCookieSet::size() const
+{
+   LOCK_MUTEX(mutex_)
+   {
+      return cookies_.size();
+   }
+   END_LOCK_MUTEX
+
+   return 0;
+}
+
+std::vector<std::pair<std::string, boost::posix_time::ptime> > RevokedCookieSet::entries() const
+{
+   std::vector<std::pair<std::string, boost::posix_time::ptime> > entries;
+
+   LOCK_MUTEX(mutex_)
+   {
+      entries.reserve(expirations_.size());
+      for (const auto& expiration : expirations_)
+         entries.push_back(std::make_pair(*expiration.second, expiration.first));
+   }
+   END_LOCK_MUTEX
+
+   return entries;
+}
+
+void RevokedCookieSet::rebuildFilter()
+{
+   std::size_t capacity = std::max(kMinCapacity, cookies_.size() * 2);
+   boost::shared_ptr<BloomFilter> pFilter(new BloomFilter(capacity));
+   for (const auto& cookie : cookies_)
+      pFilter->add(cookie.first);
+
+   boost::atomic_store(&pFilter_, pFilter);
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,124 @@
+/*
+ * RevokedCookieSetBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+#include <server_core/http/RevokedCookieSet.hpp>
+
+#include <deque>
+#include <iostream>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+using namespace boost::posix_time;
+
+namespace {
+
+const int kLookups = 200000;
+
+std::string makeCookie(int i)
+{
+   return "user" + std::to_string(i) + "|Thu%2C%2001%20Jan%202099%2000%3A00%3A00%20GMT|" +
+          std::to_string(i * 2654435761u);
+}
+
+// the cookie presented by the i'th request; one in ten requests presents a
+// revoked cookie
+std::string requestCookie(int i, int size)
+{
+   return makeCookie(i % 10 == 0 ? i % size : size + i);
+}
+
+// average time of a lookup (of a mix of revoked and unrevoked cookies)
+// made against a set of the given size
+double lookupMicroseconds(int size)
+{
+   ptime now = second_clock::universal_time();
+   RevokedCookieSet cookies;
+   for (int i = 0; i < size; i++)
+      cookies.insert(makeCookie(i), now + hours(1 + i % 24), now);
+
+   int found = 0;
+   ptime start = microsec_clock::universal_time();
+   for (int i = 0; i < kLookups; i++)
+   {
+      if (cookies.contains(requestCookie(i, size)))
+         found++;
+   }
+   double elapsed = (microsec_clock::universal_time() - start).total_microseconds();
+
+   expect_equal(found, kLookups / 10);
+   return elapsed / kLookups;
+}
+
+// the same lookups made by scanning the revocation list (as every request
+// did before RevokedCookieSet)
+double scanMicroseconds(int size)
+{
+   ptime now = second_clock::universal_time();
+   std::deque<std::pair<std::string, ptime> > cookies;
+   for (int i = 0; i < size; i++)
+      cookies.emplace_back(makeCookie(i), now + hours(1 + i % 24));
+
+   // scanning is slow enough that fewer lookups give a stable average
+   const int lookups = kLookups / 100;
+   int found = 0;
+   ptime start = microsec_clock::universal_time();
+   for (int i = 0; i < lookups; i++)
+   {
+      std::string cookie = requestCookie(i, size);
+      for (const auto& revoked : cookies)
+      {
+         if (revoked.first == cookie)
+         {
+            found++;
+            break;
+         }
+      }
+   }
+   double elapsed = (microsec_clock::universal_time() - start).total_microseconds();
+
+   expect_equal(found, lookups / 10);
+   return elapsed / lookups;
+}
+
+} // anonymous namespace
+
+// the revocation list used to be scanned in full on every request; lookups
+// should now take about as long no matter how many cookies are revoked
+test_context("Revoked cookie set benchmarks")
+{
+   test_that("lookup latency stays flat as the number of revoked cookies grows")
+   {
+      double small = lookupMicroseconds(1000);
+      double medium = lookupMicroseconds(10000);
+      double large = lookupMicroseconds(100000);
+      double scanned = scanMicroseconds(100000);
+
+      std::cout << "revoked cookie lookups: "
+                << "1000 cookies " << small << "us, "
+                << "10000 cookies " << medium << "us, "
+                << "100000 cookies " << large << "us "
+                << "(scanning 100000 cookies " << scanned << "us)" << std::endl;
+
+      // allow for the larger set's lookups missing the cache more often
+      expect_true(large < small * 4);
+   }
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,117 @@
+/*
+ * RevokedCookieSetTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+#include <server_core/http/RevokedCookieSet.hpp>
+
+#include <atomic>
+
+#include <core/BoostThread.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+using namespace boost::posix_time;
+
+namespace {
+
+std::string makeCookie(int i)
+{
+   return "user" + std::to_string(i) + "|Thu%2C%2001%20Jan%202099%2000%3A00%3A00%20GMT|" +
+          std::to_string(i * 2654435761u);
+}
+
+} // anonymous namespace
+
+test_context("Revoked cookie set")
+{
+   test_that("revoked cookies are found until they expire")
+   {
+      ptime now = second_clock::universal_time();
+      RevokedCookieSet cookies;
+      for (int i = 0; i < 5000; i++)
+         expect_true(cookies.insert(makeCookie(i), now + minutes(i % 100 + 1), now));
+
+      expect_false(cookies.insert(makeCookie(1), now + minutes(5), now));
+      expect_false(cookies.insert("expired", now, now));
+      expect_equal(cookies.size(), 5000u);
+
+      for (int i = 0; i < 5000; i++)
+         expect_true(cookies.contains(makeCookie(i)));
+      expect_false(cookies.contains(makeCookie(5000)));
+      expect_false(cookies.contains("expired"));
+
+      std::vector<std::pair<std::string, ptime> > entries = cookies.entries();
+      expect_equal(entries.size(), 5000u);
+      expect_true(entries.front().second == now + minutes(1));
+      expect_true(entries.back().second == now + minutes(100));
+
+      // cookies expiring within the first 50 minutes are removed
+      expect_equal(cookies.removeExpired(now + minutes(50)), 2500u);
+      expect_equal(cookies.size(), 2500u);
+      for (int i = 0; i < 5000; i++)
+         expect_equal(cookies.contains(makeCookie(i)), i % 100 >= 50);
+
+      expect_equal(cookies.removeExpired(now + minutes(50)), 0u);
+      expect_equal(cookies.removeExpired(now + minutes(100)), 2500u);
+      expect_true(cookies.entries().empty());
+   }
+
+   test_that("lookups are safe while cookies are being revoked and expired")
+   {
+      ptime now = second_clock::universal_time();
+      RevokedCookieSet cookies;
+      for (int i = 0; i < 1000; i++)
+         cookies.insert(makeCookie(i), now + hours(1), now);
+
+      std::atomic<bool> done(false);
+      std::atomic<int> missing(0);
+      boost::thread_group readers;
+      for (int t = 0; t < 4; t++)
+      {
+         readers.create_thread([&]()
+         {
+            while (!done)
+            {
+               for (int i = 0; i < 1000; i++)
+               {
+                  if (!cookies.contains(makeCookie(i)))
+                     missing++;
+               }
+            }
+         });
+      }
+
+      // revoke (and expire) other cookies, growing the filter several times
+      for (int i = 1000; i < 50000; i++)
+      {
+         cookies.insert(makeCookie(i), now + seconds(i % 2 == 0 ? 10 : 7200), now);
+         if (i % 10000 == 0)
+            cookies.removeExpired(now + minutes(1));
+      }
+      cookies.removeExpired(now + minutes(1));
+
+      done = true;
+      readers.join_all();
+
+      expect_equal(missing.load(), 0);
+      expect_equal(cookies.size(), 1000u + 49000u / 2);
+   }
+}
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
@@ -0,0 +1,88 @@
+/*
+ * RevokedCookieSet.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef CORE_HTTP_REVOKED_COOKIE_SET_HPP
+#define CORE_HTTP_REVOKED_COOKIE_SET_HPP
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace rstudio {
+namespace core {
+namespace http {
+
+// The set of revoked (signed out) cookies which have yet to expire. Lookups
+// happen on every authenticated request, so the cookies are hashed and
+// fronted by a bloom filter which is consulted without locking: the vast
+// majority of cookies presented have not been revoked and are rejected by
+// the filter alone. Expired cookies are removed by periodically calling
+// removeExpired() rather than during lookups.
+class RevokedCookieSet : boost::noncopyable
+{
+public:
+   RevokedCookieSet();
+   ~RevokedCookieSet();
+
+   // COPYING: boost::noncopyable
+
+   // add a cookie (which expires at expiration); returns false if the cookie
+   // was already present or has already expired
+   bool insert(const std::string& cookie,
+               const boost::posix_time::ptime& expiration,
+               const boost::posix_time::ptime& now =
+                        boost::posix_time::second_clock::universal_time());
+
+   bool contains(const std::string& cookie) const;
+
+   // remove the cookies which have expired as of now, returning how many
+   std::size_t removeExpired(const boost::posix_time::ptime& now =
+                                boost::posix_time::second_clock::universal_time());
+
+   std::size_t size() const;
+
+   // the cookies along with their expirations, soonest to expire first
+   std::vector<std::pair<std::string, boost::posix_time::ptime> > entries() const;
+
+private:
+   class BloomFilter;
+
+   // rebuild the filter from the current cookies (sized for them to grow
+   // to twice their number before it needs rebuilding again)
+   void rebuildFilter();
+
+   mutable boost::mutex mutex_;
+
+   // cookies mapped to their expiration, and the reverse (whose values point
+   // to the keys of the former, which are stable across rehashing)
+   std::unordered_map<std::string, boost::posix_time::ptime> cookies_;
+   std::multimap<boost::posix_time::ptime, const std::string*> expirations_;
+
+   // replaced (rather than modified) when rebuilt so readers needn't lock
+   boost::shared_ptr<BloomFilter> pFilter_;
+};
+
+} // namespace http
+} // namespace core
+} // namespace rstudio
+
+#endif // CORE_HTTP_REVOKED_COOKIE_SET_HPP
@@ -0,0 +1,381 @@
+/*
+ * SessionClientEventCoalescer.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionClientEventCoalescer.hpp"
+
+#include <iterator>
+#include <set>
+
+#include <core/system/FileChangeEvent.hpp>
+#include <shared_core/SafeConvert.hpp>
+#include <shared_core/json/Json.hpp>
+
+#include <core/Log.hpp>
+
+#include "modules/SessionConsole.hpp"
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+
+namespace {
+
+enum MergeResult
+{
+   MergeIncompatible,   // events can't be combined; keep both
+   MergeCombined,       // events were combined into one
+   MergeCancelled       // events cancel each other out; drop both
+};
+
+const char * const kChanged = "changed";
+const char * const kRemoved = "removed";
+
+bool readEnvironmentChanges(const ClientEvent& event,
+                            json::Array* pChanged,
+                            json::Array* pRemoved)
+{
+   if (!event.data().isObject())
+      return false;
+
+   const json::Object& data = event.data().getObject();
+   json::Object::Iterator changedIt = data.find(kChanged);
+   json::Object::Iterator removedIt = data.find(kRemoved);
+   if (changedIt == data.end() || removedIt == data.end() ||
+       !(*changedIt).getValue().isArray() || !(*removedIt).getValue().isArray())
+   {
+      return false;
+   }
+
+   *pChanged = (*changedIt).getValue().getArray();
+   *pRemoved = (*removedIt).getValue().getArray();
+   return true;
+}
+
+bool objectName(const json::Value& value, std::string* pName)
+{
+   if (!value.isObject())
+      return false;
+   return !json::readObject(value.getObject(), "name", *pName);
+}
+
+bool collectNames(const json::Array& objects, std::set<std::string>* pNames)
+{
+   for (const json::Value& value : objects)
+   {
+      std::string name;
+      if (!objectName(value, &name))
+         return false;
+      pNames->insert(name);
+   }
+   return true;
+}
+
+bool collectStrings(const json::Array& values, std::set<std::string>* pStrings)
+{
+   for (const json::Value& value : values)
+   {
+      if (!value.isString())
+         return false;
+      pStrings->insert(value.getString());
+   }
+   return true;
+}
+
+// environment_changed events are deltas, so they are merged rather than
+// replaced: the result describes every object changed or removed by
+// either event, with the later event taking precedence
+MergeResult mergeEnvironmentChanged(const ClientEvent& previous,
+                                    const ClientEvent& event,
+                                    ClientEvent* pMerged)
+{
+   json::Array prevChanged, prevRemoved, nextChanged, nextRemoved;
+   if (!readEnvironmentChanges(previous, &prevChanged, &prevRemoved) ||
+       !readEnvironmentChanges(event, &nextChanged, &nextRemoved))
+   {
+      return MergeIncompatible;
+   }
+
+   std::set<std::string> nextChangedNames, nextRemovedNames, prevRemovedNames;
+   if (!collectNames(nextChanged, &nextChangedNames) ||
+       !collectStrings(nextRemoved, &nextRemovedNames) ||
+       !collectStrings(prevRemoved, &prevRemovedNames))
+   {
+      return MergeIncompatible;
+   }
+
+   json::Array changed;
+   for (const json::Value& value : prevChanged)
+   {
+      std::string name;
+      if (!objectName(value, &name))
+         return MergeIncompatible;
+      if (!nextChangedNames.count(name) && !nextRemovedNames.count(name))
+         changed.push_back(value);
+   }
+   for (const json::Value& value : nextChanged)
+      changed.push_back(value);
+
+   json::Array removed;
+   for (const std::string& name : prevRemovedNames)
+   {
+      if (!nextChangedNames.count(name) && !nextRemovedNames.count(name))
+         removed.push_back(name);
+   }
+   for (const std::string& name : nextRemovedNames)
+      removed.push_back(name);
+
+   json::Object data = event.data().getObject();
+   data[kChanged] = changed;
+   data[kRemoved] = removed;
+   *pMerged = ClientEvent(event.type(), data);
+   return MergeCombined;
+}
+
+// plots state is a snapshot, so the latest wins -- except that a request
+// to activate the plots pane must survive
+MergeResult mergePlotsStateChanged(const ClientEvent& previous,
+                                   const ClientEvent& event,
+                                   ClientEvent* pMerged)
+{
+   const char * const kActivatePlots = "activatePlots";
+
+   if (!previous.data().isObject() || !event.data().isObject())
+      return MergeIncompatible;
+
+   bool activate = false;
+   json::readObject(previous.data().getObject(), kActivatePlots, activate);
+   if (!activate)
+   {
+      *pMerged = event;
+      return MergeCombined;
+   }
+
+   json::Object data = event.data().getObject();
+   data[kActivatePlots] = true;
+   *pMerged = ClientEvent(event.type(), data);
+   return MergeCombined;
+}
+
+int fileChangeType(const ClientEvent& event)
+{
+   int type = system::FileChangeEvent::None;
+   json::readObject(event.data().getObject(), "type", type);
+   return type;
+}
+
+MergeResult mergeFileChanged(const ClientEvent& previous,
+                             const ClientEvent& event,
+                             ClientEvent* pMerged)
+{
+   using system::FileChangeEvent;
+
+   int previousType = fileChangeType(previous);
+   int type = fileChangeType(event);
+
+   if (previousType == FileChangeEvent::FileAdded)
+   {
+      // the client never saw the file, so it needn't see it go away
+      if (type == FileChangeEvent::FileRemoved)
+         return MergeCancelled;
+
+      // the client still needs to hear about the file being added
+      if (type == FileChangeEvent::FileModified)
+      {
+         json::Object data = event.data().getObject();
+         data["type"] = static_cast<int>(FileChangeEvent::FileAdded);
+         *pMerged = ClientEvent(event.type(), data);
+         return MergeCombined;
+      }
+   }
+
+   *pMerged = event;
+   return MergeCombined;
+}
+
+std::string coalescingKey(const ClientEvent& event)
+{
+   if (event.type() == client_events::kPlotsStateChanged)
+      return "plots_state_changed";
+
+   if (event.type() == client_events::kEnvironmentChanged)
+      return "environment_changed";
+
+   if (event.type() == client_events::kFileChanged && event.data().isObject())
+   {
+      json::Object file;
+      std::string path;
+      if (!json::readObject(event.data().getObject(), "file", file) &&
+          !json::readObject(file, "path", path))
+      {
+         return "file_changed:" + path;
+      }
+   }
+
+   return std::string();
+}
+
+// the key of the coalesced event which must not be merged across the given
+// event (e.g. an environment_changed delta can't move past an assignment)
+std::string barrierKey(const ClientEvent& event)
+{
+   if (event.type() == client_events::kEnvironmentAssigned ||
+       event.type() == client_events::kEnvironmentRemoved ||
+       event.type() == client_events::kEnvironmentRefresh ||
+       event.type() == client_events::kContextDepthChanged)
+   {
+      return "environment_changed";
+   }
+
+   return std::string();
+}
+
+bool isConsoleOutput(const ClientEvent& event)
+{
+   return (event.type() == client_events::kConsoleWriteOutput ||
+           event.type() == client_events::kConsoleWriteError) &&
+          event.data().isObject();
+}
+
+// console output is appended to the previous event when both were written
+// to the same stream of the same console, so nothing is lost
+MergeResult mergeConsoleOutput(const ClientEvent& previous,
+                               const ClientEvent& event,
+                               ClientEvent* pMerged)
+{
+   if (!isConsoleOutput(previous) || previous.type() != event.type())
+      return MergeIncompatible;
+
+   std::string previousText, previousConsole, text, console;
+   if (json::readObject(previous.data().getObject(),
+                        kConsoleText, previousText,
+                        kConsoleId, previousConsole) ||
+       json::readObject(event.data().getObject(),
+                        kConsoleText, text,
+                        kConsoleId, console) ||
+       previousConsole != console)
+   {
+      return MergeIncompatible;
+   }
+
+   json::Object data = event.data().getObject();
+   data[kConsoleText] = previousText + text;
+   *pMerged = ClientEvent(event.type(), data);
+   return MergeCombined;
+}
+
+MergeResult merge(const ClientEvent& previous,
+                  const ClientEvent& event,
+                  ClientEvent* pMerged)
+{
+   if (event.type() == client_events::kPlotsStateChanged)
+      return mergePlotsStateChanged(previous, event, pMerged);
+   else if (event.type() == client_events::kEnvironmentChanged)
+      return mergeEnvironmentChanged(previous, event, pMerged);
+   else if (event.type() == client_events::kFileChanged)
+      return mergeFileChanged(previous, event, pMerged);
+   else
+      return MergeIncompatible;
+}
+
+} // anonymous namespace
+
+ClientEventCoalescer::ClientEventCoalescer(std::size_t maxEvents)
+   : maxEvents_(maxEvents),
+     coalesced_(0),
+     resyncs_(0)
+{
+}
+
+void ClientEventCoalescer::add(const ClientEvent& event)
+{
+   // an event which must stay ordered relative to a keyed event ends that
+   // event's coalescing, so that nothing later is merged ahead of it
+   std::string barrier = barrierKey(event);
+   if (!barrier.empty())
+      keyedEvents_.erase(barrier);
+
+   // console output can only be merged with the event right before it
+   // (anything else would reorder it)
+   if (isConsoleOutput(event) && !events_.empty())
+   {
+      ClientEvent merged = event;
+      if (mergeConsoleOutput(events_.back().event, event, &merged) == MergeCombined)
+      {
+         events_.back().event = merged;
+         coalesced_++;
+         return;
+      }
+   }
+
+   std::string key = coalescingKey(event);
+   if (!key.empty())
+   {
+      auto keyedIt = keyedEvents_.find(key);
+      if (keyedIt != keyedEvents_.end())
+      {
+         ClientEvent merged = event;
+         MergeResult result = merge(keyedIt->second->event, event, &merged);
+         if (result == MergeCombined)
+         {
+            // the merged event keeps the previous event's queue position
+            keyedIt->second->event = merged;
+            coalesced_++;
+            return;
+         }
+         else if (result == MergeCancelled)
+         {
+            events_.erase(keyedIt->second);
+            keyedEvents_.erase(keyedIt);
+            coalesced_ += 2;
+            return;
+         }
+      }
+   }
+
+   events_.push_back(PendingEvent(event, key));
+   if (!key.empty())
+      keyedEvents_[key] = std::prev(events_.end());
+
+   // once too many events are pending the client can no longer be brought
+   // up to date incrementally, so have it reload its state instead
+   if (events_.size() > maxEvents_)
+   {
+      LOG_WARNING_MESSAGE("Too many client events pending (more than " +
+                          safe_convert::numberToString(maxEvents_) +
+                          "); discarding them and requesting a client reload");
+      clear();
+      events_.push_back(PendingEvent(
+         ClientEvent(client_events::kReloadWithLastChanceSave), std::string()));
+      resyncs_++;
+   }
+}
+
+void ClientEventCoalescer::remove(std::vector<ClientEvent>* pEvents)
+{
+   pEvents->reserve(pEvents->size() + events_.size());
+   for (const PendingEvent& pending : events_)
+      pEvents->push_back(pending.event);
+   clear();
+}
+
+void ClientEventCoalescer::clear()
+{
+   events_.clear();
+   keyedEvents_.clear();
+}
+
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,100 @@
+/*
+ * SessionClientEventCoalescer.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_SESSION_CLIENT_EVENT_COALESCER_HPP
+#define SESSION_SESSION_CLIENT_EVENT_COALESCER_HPP
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/utility.hpp>
+
+#include <session/SessionClientEvent.hpp>
+
+namespace rstudio {
+namespace session {
+
+// Holds the events which are waiting to be delivered to the client,
+// applying per-type coalescing rules as events are added:
+//
+//   - plots_state_changed: only the latest state is kept (though a request
+//     to activate the plots pane is never lost)
+//   - environment_changed: successive change sets are merged into one
+//   - file_changed: only the latest change for a given path is kept (an
+//     add followed by a modify stays an add; an add followed by a remove
+//     cancels out)
+//   - console output: text written to the same stream of the same console
+//     is appended to the previous event if that event is also output
+//
+// A coalesced event keeps the queue position of the earliest event it
+// replaces. Events which must stay ordered relative to a coalesced event
+// (e.g. environment_assigned and environment_removed) end its coalescing,
+// so later changes start a new event after them.
+//
+// The number of pending events is bounded (see the client-events-max-pending
+// session option); if the limit is exceeded (only when no client has
+// collected events for a long time) the pending events are discarded and
+// replaced by a request for the client to reload.
+//
+// Not thread safe: callers synchronize access.
+class ClientEventCoalescer : boost::noncopyable
+{
+public:
+   explicit ClientEventCoalescer(std::size_t maxEvents);
+
+   // add an event
+   void add(const ClientEvent& event);
+
+   // remove all pending events (oldest first)
+   void remove(std::vector<ClientEvent>* pEvents);
+
+   void clear();
+
+   bool empty() const { return events_.empty(); }
+   std::size_t size() const { return events_.size(); }
+
+   // number of events which were merged into (or cancelled by) a later event
+   uint64_t coalescedCount() const { return coalesced_; }
+
+   // number of times the pending limit was exceeded and a reload requested
+   uint64_t resyncCount() const { return resyncs_; }
+
+private:
+   struct PendingEvent
+   {
+      PendingEvent(const ClientEvent& event, const std::string& key)
+         : event(event), key(key)
+      {
+      }
+
+      ClientEvent event;
+      std::string key;
+   };
+
+   typedef std::list<PendingEvent> PendingEvents;
+
+   std::size_t maxEvents_;
+   PendingEvents events_;
+   std::map<std::string, PendingEvents::iterator> keyedEvents_;
+   uint64_t coalesced_;
+   uint64_t resyncs_;
+};
+
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_SESSION_CLIENT_EVENT_COALESCER_HPP
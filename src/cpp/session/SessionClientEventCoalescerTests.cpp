@@ -0,0 +1,246 @@
+/*
+ * SessionClientEventCoalescerTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionClientEventCoalescer.hpp"
+
+#include <core/system/FileChangeEvent.hpp>
+
+#include "modules/SessionConsole.hpp"
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace tests {
+
+using namespace rstudio::core;
+using core::system::FileChangeEvent;
+
+namespace {
+
+ClientEvent plotsEvent(int width, bool activate)
+{
+   json::Object data;
+   data["width"] = width;
+   data["activatePlots"] = activate;
+   return ClientEvent(client_events::kPlotsStateChanged, data);
+}
+
+ClientEvent environmentEvent(const std::vector<std::string>& changed,
+                             const std::vector<std::string>& removed)
+{
+   json::Array changedArray;
+   for (const std::string& name : changed)
+   {
+      json::Object object;
+      object["name"] = name;
+      changedArray.push_back(object);
+   }
+
+   json::Array removedArray;
+   for (const std::string& name : removed)
+      removedArray.push_back(name);
+
+   json::Object data;
+   data["changed"] = changedArray;
+   data["removed"] = removedArray;
+   return ClientEvent(client_events::kEnvironmentChanged, data);
+}
+
+ClientEvent fileEvent(FileChangeEvent::Type type, const std::string& path)
+{
+   json::Object file;
+   file["path"] = path;
+
+   json::Object data;
+   data["type"] = static_cast<int>(type);
+   data["file"] = file;
+   return ClientEvent(client_events::kFileChanged, data);
+}
+
+ClientEvent consoleEvent(int type, const std::string& text,
+                         const std::string& console = "console")
+{
+   json::Object data;
+   data[kConsoleText] = text;
+   data[kConsoleId] = console;
+   return ClientEvent(type, data);
+}
+
+std::string consoleText(const ClientEvent& event)
+{
+   return event.data().getObject()[kConsoleText].getString();
+}
+
+std::vector<ClientEvent> removeAll(ClientEventCoalescer* pCoalescer)
+{
+   std::vector<ClientEvent> events;
+   pCoalescer->remove(&events);
+   return events;
+}
+
+std::vector<std::string> namesOf(const json::Value& data, const std::string& field)
+{
+   std::vector<std::string> names;
+   for (const json::Value& value : data.getObject()[field].getArray())
+   {
+      if (value.isString())
+         names.push_back(value.getString());
+      else
+         names.push_back(value.getObject()["name"].getString());
+   }
+   return names;
+}
+
+} // anonymous namespace
+
+test_context("Client event coalescing")
+{
+   test_that("Only the latest plots state is delivered")
+   {
+      ClientEventCoalescer coalescer(100);
+      coalescer.add(plotsEvent(100, true));
+      coalescer.add(ClientEvent(client_events::kBusy, true));
+      coalescer.add(plotsEvent(200, false));
+
+      std::vector<ClientEvent> events = removeAll(&coalescer);
+      REQUIRE(events.size() == 2);
+      CHECK(events[0].type() == client_events::kPlotsStateChanged);
+      CHECK(events[1].type() == client_events::kBusy);
+
+      // the later state wins but the activation request survives
+      json::Object data = events[0].data().getObject();
+      CHECK(data["width"].getInt() == 200);
+      CHECK(data["activatePlots"].getBool());
+
+      CHECK(coalescer.empty());
+      CHECK(coalescer.coalescedCount() == 1);
+   }
+
+   test_that("Environment changes are merged")
+   {
+      ClientEventCoalescer coalescer(100);
+      coalescer.add(environmentEvent({"a", "b"}, {"c"}));
+      coalescer.add(environmentEvent({"c"}, {"a"}));
+
+      std::vector<ClientEvent> events = removeAll(&coalescer);
+      REQUIRE(events.size() == 1);
+      CHECK(namesOf(events[0].data(), "changed") ==
+            std::vector<std::string>({"b", "c"}));
+      CHECK(namesOf(events[0].data(), "removed") ==
+            std::vector<std::string>({"a"}));
+   }
+
+   test_that("File changes are coalesced per path")
+   {
+      ClientEventCoalescer coalescer(100);
+
+      // added then modified is still an add
+      coalescer.add(fileEvent(FileChangeEvent::FileAdded, "/a"));
+      coalescer.add(fileEvent(FileChangeEvent::FileModified, "/b"));
+      coalescer.add(fileEvent(FileChangeEvent::FileModified, "/a"));
+      coalescer.add(fileEvent(FileChangeEvent::FileModified, "/b"));
+
+      // added then removed cancels out
+      coalescer.add(fileEvent(FileChangeEvent::FileAdded, "/c"));
+      coalescer.add(fileEvent(FileChangeEvent::FileRemoved, "/c"));
+
+      std::vector<ClientEvent> events = removeAll(&coalescer);
+      REQUIRE(events.size() == 2);
+      CHECK(events[0].data().getObject()["type"].getInt() == FileChangeEvent::FileAdded);
+      CHECK(events[1].data().getObject()["type"].getInt() == FileChangeEvent::FileModified);
+      CHECK(coalescer.coalescedCount() == 4);
+   }
+
+   test_that("Environment changes aren't merged across assignments")
+   {
+      ClientEventCoalescer coalescer(100);
+      coalescer.add(environmentEvent({"a"}, {}));
+      coalescer.add(ClientEvent(client_events::kEnvironmentRemoved, "a"));
+      coalescer.add(environmentEvent({"b"}, {}));
+      coalescer.add(environmentEvent({"c"}, {}));
+
+      std::vector<ClientEvent> events = removeAll(&coalescer);
+      REQUIRE(events.size() == 3);
+      CHECK(events[0].type() == client_events::kEnvironmentChanged);
+      CHECK(namesOf(events[0].data(), "changed") ==
+            std::vector<std::string>({"a"}));
+      CHECK(events[1].type() == client_events::kEnvironmentRemoved);
+      CHECK(events[2].type() == client_events::kEnvironmentChanged);
+      CHECK(namesOf(events[2].data(), "changed") ==
+            std::vector<std::string>({"b", "c"}));
+      CHECK(coalescer.coalescedCount() == 1);
+   }
+
+   test_that("Adjacent console output is merged without losing any")
+   {
+      ClientEventCoalescer coalescer(100);
+      coalescer.add(consoleEvent(client_events::kConsoleWriteError, "a\n"));
+      coalescer.add(consoleEvent(client_events::kConsoleWriteError, "b\n"));
+      coalescer.add(consoleEvent(client_events::kConsoleWriteOutput, "c\n"));
+      coalescer.add(consoleEvent(client_events::kConsoleWriteOutput, "d\n"));
+      coalescer.add(consoleEvent(client_events::kConsoleWriteOutput, "e\n", "other"));
+      coalescer.add(ClientEvent(client_events::kBusy, true));
+      coalescer.add(consoleEvent(client_events::kConsoleWriteOutput, "f\n", "other"));
+
+      std::vector<ClientEvent> events = removeAll(&coalescer);
+      REQUIRE(events.size() == 5);
+      CHECK(events[0].type() == client_events::kConsoleWriteError);
+      CHECK(consoleText(events[0]) == "a\nb\n");
+      CHECK(events[1].type() == client_events::kConsoleWriteOutput);
+      CHECK(consoleText(events[1]) == "c\nd\n");
+      CHECK(consoleText(events[2]) == "e\n");
+      CHECK(events[3].type() == client_events::kBusy);
+      CHECK(consoleText(events[4]) == "f\n");
+      CHECK(coalescer.coalescedCount() == 2);
+   }
+
+   test_that("Console output floods don't reach the limit")
+   {
+      // e.g. a loop calling message(), which writes each line separately
+      ClientEventCoalescer coalescer(10);
+      for (int i = 0; i < 1000; i++)
+         coalescer.add(consoleEvent(client_events::kConsoleWriteError, "x\n"));
+
+      CHECK(coalescer.resyncCount() == 0);
+      std::vector<ClientEvent> events = removeAll(&coalescer);
+      REQUIRE(events.size() == 1);
+      CHECK(consoleText(events[0]).size() == 2000);
+   }
+
+   test_that("Exceeding the limit replaces pending events with a reload")
+   {
+      ClientEventCoalescer coalescer(3);
+      coalescer.add(plotsEvent(1, false));
+      for (int i = 0; i < 3; i++)
+         coalescer.add(ClientEvent(client_events::kBusy, true));
+      CHECK(coalescer.size() == 1);
+      CHECK(coalescer.resyncCount() == 1);
+
+      // events added afterwards are delivered after the reload, and
+      // nothing is coalesced into the discarded plots event
+      coalescer.add(plotsEvent(2, false));
+      std::vector<ClientEvent> events = removeAll(&coalescer);
+      REQUIRE(events.size() == 2);
+      CHECK(events[0].type() == client_events::kReloadWithLastChanceSave);
+      CHECK(events[1].type() == client_events::kPlotsStateChanged);
+      CHECK(events[1].data().getObject()["width"].getInt() == 2);
+      CHECK(coalescer.coalescedCount() == 0);
+   }
+}
+
+} // namespace tests
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,211 @@
+/*
+ * SessionClientEventPushChannel.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionClientEventPushChannel.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Log.hpp>
+#include <core/Thread.hpp>
+#include <shared_core/Error.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+
+const char * const kClientEventsPushHandle = "events";
+
+ClientEventPushChannel::ClientEventPushChannel(
+                           const ClientEventPushChannelCallbacks& callbacks)
+   : callbacks_(callbacks),
+     ready_(false),
+     resendRequested_(false)
+{
+}
+
+ClientEventPushChannel::~ClientEventPushChannel()
+{
+   try
+   {
+      stop();
+   }
+   CATCH_UNEXPECTED_EXCEPTION
+}
+
+Error ClientEventPushChannel::start()
+{
+   Error error = socket_.ensureServerRunning();
+   if (error)
+      return error;
+
+   console_process::ConsoleProcessSocketConnectionCallbacks callbacks;
+   callbacks.onReceivedInput =
+         boost::bind(&ClientEventPushChannel::onReceivedInput, this, _1);
+   callbacks.onConnectionOpened =
+         boost::bind(&ClientEventPushChannel::onConnectionOpened, this);
+   callbacks.onConnectionClosed =
+         boost::bind(&ClientEventPushChannel::onConnectionClosed, this);
+   callbacks.onConnectionError =
+         boost::bind(&ClientEventPushChannel::onConnectionError, this);
+   return socket_.listen(kClientEventsPushHandle, callbacks);
+}
+
+void ClientEventPushChannel::stop()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      ready_ = false;
+      resendRequested_ = false;
+   }
+   END_LOCK_MUTEX
+
+   socket_.stopServer();
+}
+
+int ClientEventPushChannel::port() const
+{
+   return socket_.port();
+}
+
+bool ClientEventPushChannel::isReady()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      return ready_;
+   }
+   END_LOCK_MUTEX
+
+   return false;
+}
+
+bool ClientEventPushChannel::isAliveSince(const boost::posix_time::ptime& time)
+{
+   LOCK_MUTEX(mutex_)
+   {
+      return ready_ &&
+             !lastReceivedTime_.is_not_a_date_time() &&
+             lastReceivedTime_ > time;
+   }
+   END_LOCK_MUTEX
+
+   return false;
+}
+
+bool ClientEventPushChannel::takeResendRequest()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      bool resendRequested = resendRequested_;
+      resendRequested_ = false;
+      return resendRequested;
+   }
+   END_LOCK_MUTEX
+
+   return false;
+}
+
+Error ClientEventPushChannel::send(const json::Array& events)
+{
+   Error error = socket_.sendText(kClientEventsPushHandle, events.write());
+   if (error)
+   {
+      // the connection is gone; stop pushing until the client reconnects
+      // (any unacknowledged events will be resent at that time, or picked
+      // up via get_events if the client falls back to long-polling)
+      LOCK_MUTEX(mutex_)
+      {
+         ready_ = false;
+      }
+      END_LOCK_MUTEX
+   }
+   return error;
+}
+
+void ClientEventPushChannel::onReceivedInput(const std::string& input)
+{
+   json::Value value;
+   if (value.parse(input) || !value.isObject())
+   {
+      LOG_WARNING_MESSAGE("Invalid message on client event channel: " + input);
+      return;
+   }
+
+   std::string clientId;
+   int lastEventId = -1;
+   Error error = json::readObject(value.getObject(),
+                                  "client_id", clientId,
+                                  "last_event_id", lastEventId);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   // ignore stale clients; the active client will connect on its own
+   if (clientId != callbacks_.clientId())
+      return;
+
+   // mark the channel ready before forwarding the acknowledgement (a resend
+   // racing with it may include a few events the client has already seen,
+   // which it ignores)
+   LOCK_MUTEX(mutex_)
+   {
+      lastReceivedTime_ = boost::posix_time::microsec_clock::universal_time();
+      if (!ready_)
+      {
+         ready_ = true;
+         resendRequested_ = true;
+      }
+   }
+   END_LOCK_MUTEX
+
+   callbacks_.onAcknowledged(lastEventId);
+}
+
+void ClientEventPushChannel::onConnectionOpened()
+{
+   // a newly opened connection isn't ready until the client identifies
+   // itself (and tells us which events it has already seen)
+   LOCK_MUTEX(mutex_)
+   {
+      ready_ = false;
+   }
+   END_LOCK_MUTEX
+}
+
+void ClientEventPushChannel::onConnectionClosed()
+{
+   LOCK_MUTEX(mutex_)
+   {
+      ready_ = false;
+      resendRequested_ = false;
+   }
+   END_LOCK_MUTEX
+
+   if (callbacks_.onDisconnected)
+      callbacks_.onDisconnected();
+}
+
+void ClientEventPushChannel::onConnectionError()
+{
+   // treat errors like a close; the client will reconnect or fall back
+   // to long-polling
+   onConnectionClosed();
+}
+
+} // namespace session
+} // namespace rstudio
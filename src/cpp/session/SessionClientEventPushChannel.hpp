@@ -0,0 +1,123 @@
+/*
+ * SessionClientEventPushChannel.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_CLIENT_EVENT_PUSH_CHANNEL_HPP
+#define SESSION_CLIENT_EVENT_PUSH_CHANNEL_HPP
+
+#include <string>
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <core/BoostThread.hpp>
+
+#include <shared_core/json/Json.hpp>
+
+#include <session/SessionConsoleProcessSocket.hpp>
+
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace session {
+
+// handle (final url segment) the client uses to connect to the push channel,
+// e.g. ws://127.0.0.1:<port>/events/
+extern const char * const kClientEventsPushHandle;
+
+struct ClientEventPushChannelCallbacks
+{
+   // id of the currently active client; messages from other clients are ignored
+   boost::function<std::string()> clientId;
+
+   // invoked when the client acknowledges receipt of all events with an
+   // id less than or equal to lastEventId
+   boost::function<void(int lastEventId)> onAcknowledged;
+
+   // invoked when the client's connection closes or fails (optional)
+   boost::function<void()> onDisconnected;
+};
+
+// WebSocket transport used to push client events to the browser as they
+// are queued (rather than having the client long-poll for them).
+//
+// Protocol (all messages use the ConsoleProcessSocketPacket text framing):
+//
+//   client -> server: {"client_id": "<id>", "last_event_id": <n>}
+//      sent when the connection opens and after each batch of events has
+//      been dispatched. the first such message after a connection opens
+//      requests that all unacknowledged events be (re)sent
+//
+//   server -> client: [ <event>, <event>, ... ]
+//      an array of events in the same format as the get_events response.
+//      the client ignores events with ids it has already seen
+//
+// If the connection can't be established or is closed the client falls
+// back to long-polling get_events; events are only discarded once they
+// have been acknowledged so nothing is lost in the transition.
+class ClientEventPushChannel : boost::noncopyable
+{
+public:
+   explicit ClientEventPushChannel(const ClientEventPushChannelCallbacks& callbacks);
+   virtual ~ClientEventPushChannel();
+
+   // start the websocket server and begin listening for the client
+   core::Error start();
+
+   // stop the websocket server
+   void stop();
+
+   // network port for the websocket listener; 0 if not running
+   int port() const;
+
+   // has a client connected and identified itself?
+   bool isReady();
+
+   // is the client ready and has it sent us a message over the connection
+   // since the given time? (a ready connection which has gone quiet may
+   // already be dead without us having seen it close)
+   bool isAliveSince(const boost::posix_time::ptime& time);
+
+   // returns true (and clears the request) if a client has (re)connected
+   // since the last call and needs all unacknowledged events to be sent
+   bool takeResendRequest();
+
+   // send a batch of events to the connected client
+   core::Error send(const core::json::Array& events);
+
+private:
+   void onReceivedInput(const std::string& input);
+   void onConnectionOpened();
+   void onConnectionClosed();
+   void onConnectionError();
+
+private:
+   ClientEventPushChannelCallbacks callbacks_;
+   console_process::ConsoleProcessSocket socket_;
+
+   boost::mutex mutex_;
+   bool ready_;
+   bool resendRequested_;
+   boost::posix_time::ptime lastReceivedTime_;
+};
+
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_CLIENT_EVENT_PUSH_CHANNEL_HPP
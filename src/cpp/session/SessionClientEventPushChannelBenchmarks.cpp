@@ -0,0 +1,90 @@
+/*
+ * SessionClientEventPushChannelBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionClientEventPushChannel.hpp"
+#include "SessionClientEventPushChannelTestClient.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace tests {
+
+using namespace boost::posix_time;
+
+test_context("Client event push channel benchmarks")
+{
+   // simulate a console output flood (as produced by e.g. a tight loop
+   // calling print) and report throughput and delivery latency. each batch
+   // mirrors what ClientEventService pushes after its batching window
+   test_that("Console output flood")
+   {
+      const int kBatches = 2000;
+      const int kEventsPerBatch = 16;
+      const std::string kLine(80, 'x');
+
+      ChannelFixture fixture;
+      REQUIRE(!fixture.channel().start());
+
+      PushClient client(fixture.channel().port());
+      REQUIRE(client.connect());
+      CHECK(client.acknowledge(kClientId, -1));
+      REQUIRE(fixture.waitForAcknowledged(-1));
+
+      std::vector<ptime> sendTimes;
+      int nextId = 0;
+      ptime start = microsec_clock::universal_time();
+      for (int i = 0; i < kBatches; i++)
+      {
+         core::json::Array events;
+         for (int j = 0; j < kEventsPerBatch; j++)
+            events.push_back(consoleOutputEvent(nextId++, kLine + "\n"));
+
+         sendTimes.push_back(microsec_clock::universal_time());
+         CHECK(!fixture.channel().send(events));
+      }
+
+      REQUIRE(client.waitForMessages(kBatches));
+      std::vector<ptime> arrivalTimes = client.arrivalTimes();
+      time_duration elapsed = arrivalTimes.back() - start;
+
+      std::vector<long> latencies;
+      for (int i = 0; i < kBatches; i++)
+         latencies.push_back((arrivalTimes[i] - sendTimes[i]).total_microseconds());
+      std::sort(latencies.begin(), latencies.end());
+
+      double seconds = std::max(static_cast<double>(elapsed.total_microseconds()), 1.0) / 1000000.0;
+      std::cout << "client event push: "
+                << static_cast<long>((kBatches * kEventsPerBatch) / seconds) << " events/sec, "
+                << "latency p50 " << latencies[kBatches / 2] << "us, "
+                << "p99 " << latencies[(kBatches * 99) / 100] << "us"
+                << std::endl;
+
+      // the last event pushed is the last one received
+      core::json::Value last;
+      REQUIRE(!last.parse(client.messages().back()));
+      CHECK(last.getArray()[kEventsPerBatch - 1].getObject()["id"].getInt() == nextId - 1);
+
+      fixture.channel().stop();
+   }
+}
+
+} // namespace tests
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,295 @@
+/*
+ * SessionClientEventPushChannelTestClient.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// client and fixture shared by the push channel tests and benchmarks
+
+#ifndef SESSION_CLIENT_EVENT_PUSH_CHANNEL_TEST_CLIENT_HPP
+#define SESSION_CLIENT_EVENT_PUSH_CHANNEL_TEST_CLIENT_HPP
+
+#include "SessionClientEventPushChannel.hpp"
+
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <core/Thread.hpp>
+
+#include <session/SessionConsoleProcessSocketPacket.hpp>
+
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+
+namespace rstudio {
+namespace session {
+namespace tests {
+
+const char * const kClientId = "8A3B6F1C";
+
+// how long to wait for something to happen on the websocket threads
+// before giving up
+const int kTimeoutSeconds = 10;
+
+typedef websocketpp::client<websocketpp::config::asio_client> client;
+
+// plays the part of the browser: connects to the push channel, identifies
+// itself and records the payload and arrival time of every batch of events
+// it receives
+class PushClient
+{
+public:
+   explicit PushClient(int port)
+      : port_(port), opened_(false), closed_(false), running_(false)
+   {
+   }
+
+   ~PushClient()
+   {
+      try
+      {
+         disconnect();
+      }
+      catch (...) {}
+   }
+
+   bool connect()
+   {
+      std::string uri = "http://localhost:" +
+            boost::lexical_cast<std::string>(port_) + "/events/";
+
+      client_.set_access_channels(websocketpp::log::alevel::none);
+      client_.set_error_channels(websocketpp::log::elevel::none);
+      client_.init_asio();
+      client_.set_open_handler(boost::bind(&PushClient::onOpen, this, _1));
+      client_.set_close_handler(boost::bind(&PushClient::onClose, this, _1));
+      client_.set_fail_handler(boost::bind(&PushClient::onClose, this, _1));
+      client_.set_message_handler(boost::bind(&PushClient::onMessage, this, _1, _2));
+
+      websocketpp::lib::error_code ec;
+      client::connection_ptr con = client_.get_connection(uri, ec);
+      if (ec)
+         return false;
+      client_.connect(con);
+
+      running_ = true;
+      core::thread::safeLaunchThread(boost::bind(&client::run, &client_), &thread_);
+
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      changed_.timed_wait(lock, boost::posix_time::seconds(kTimeoutSeconds),
+                          [&]() { return opened_ || closed_; });
+      return opened_;
+   }
+
+   void disconnect()
+   {
+      if (running_)
+      {
+         websocketpp::lib::error_code ec;
+         client_.close(hdl_, websocketpp::close::status::going_away, "", ec);
+         if (!ec)
+         {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            changed_.timed_wait(lock, boost::posix_time::seconds(kTimeoutSeconds),
+                                [&]() { return closed_; });
+         }
+         client_.stop();
+         running_ = false;
+         thread_.join();
+      }
+   }
+
+   bool acknowledge(const std::string& clientId, int lastEventId)
+   {
+      core::json::Object ack;
+      ack["client_id"] = clientId;
+      ack["last_event_id"] = lastEventId;
+
+      websocketpp::lib::error_code ec;
+      client_.send(hdl_,
+                   console_process::ConsoleProcessSocketPacket::textPacket(ack.write()),
+                   websocketpp::frame::opcode::text,
+                   ec);
+      return !ec;
+   }
+
+   bool waitForMessages(std::size_t count)
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      return changed_.timed_wait(lock, boost::posix_time::seconds(kTimeoutSeconds),
+                                 [&]() { return messages_.size() >= count; });
+   }
+
+   std::vector<std::string> messages()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         return messages_;
+      }
+      END_LOCK_MUTEX
+      return std::vector<std::string>();
+   }
+
+   std::vector<boost::posix_time::ptime> arrivalTimes()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         return arrivalTimes_;
+      }
+      END_LOCK_MUTEX
+      return std::vector<boost::posix_time::ptime>();
+   }
+
+private:
+   void onOpen(websocketpp::connection_hdl hdl)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         hdl_ = hdl;
+         opened_ = true;
+      }
+      END_LOCK_MUTEX
+      changed_.notify_all();
+   }
+
+   void onClose(websocketpp::connection_hdl)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         closed_ = true;
+      }
+      END_LOCK_MUTEX
+      changed_.notify_all();
+   }
+
+   void onMessage(websocketpp::connection_hdl, client::message_ptr msg)
+   {
+      boost::posix_time::ptime now =
+            boost::posix_time::microsec_clock::universal_time();
+      LOCK_MUTEX(mutex_)
+      {
+         messages_.push_back(
+                  console_process::ConsoleProcessSocketPacket::getMessage(msg->get_payload()));
+         arrivalTimes_.push_back(now);
+      }
+      END_LOCK_MUTEX
+      changed_.notify_all();
+   }
+
+   int port_;
+   client client_;
+   websocketpp::connection_hdl hdl_;
+   boost::thread thread_;
+   bool opened_;
+   bool closed_;
+   bool running_;
+
+   boost::mutex mutex_;
+   boost::condition_variable changed_;
+   std::vector<std::string> messages_;
+   std::vector<boost::posix_time::ptime> arrivalTimes_;
+};
+
+class ChannelFixture
+{
+public:
+   ChannelFixture()
+      : disconnected_(false)
+   {
+      ClientEventPushChannelCallbacks callbacks;
+      callbacks.clientId = boost::bind(&ChannelFixture::clientId, this);
+      callbacks.onAcknowledged = boost::bind(&ChannelFixture::onAcknowledged, this, _1);
+      callbacks.onDisconnected = boost::bind(&ChannelFixture::onDisconnected, this);
+      pChannel_.reset(new ClientEventPushChannel(callbacks));
+   }
+
+   ClientEventPushChannel& channel() { return *pChannel_; }
+
+   // every acknowledgement forwarded by the channel, in order
+   std::vector<int> acknowledged()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         return acknowledged_;
+      }
+      END_LOCK_MUTEX
+      return std::vector<int>();
+   }
+
+   // waits for the given acknowledgement; the channel marks itself ready
+   // before forwarding the first one, so this also waits for readiness
+   bool waitForAcknowledged(int lastEventId)
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      return changed_.timed_wait(lock, boost::posix_time::seconds(kTimeoutSeconds), [&]() {
+         return !acknowledged_.empty() && acknowledged_.back() == lastEventId;
+      });
+   }
+
+   bool waitForDisconnected()
+   {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      return changed_.timed_wait(lock, boost::posix_time::seconds(kTimeoutSeconds),
+                                 [&]() { return disconnected_; });
+   }
+
+private:
+   std::string clientId() { return kClientId; }
+
+   void onAcknowledged(int lastEventId)
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         acknowledged_.push_back(lastEventId);
+      }
+      END_LOCK_MUTEX
+      changed_.notify_all();
+   }
+
+   void onDisconnected()
+   {
+      LOCK_MUTEX(mutex_)
+      {
+         disconnected_ = true;
+      }
+      END_LOCK_MUTEX
+      changed_.notify_all();
+   }
+
+   boost::scoped_ptr<ClientEventPushChannel> pChannel_;
+
+   boost::mutex mutex_;
+   boost::condition_variable changed_;
+   std::vector<int> acknowledged_;
+   bool disconnected_;
+};
+
+inline core::json::Object consoleOutputEvent(int id, const std::string& output)
+{
+   core::json::Object event;
+   event["id"] = id;
+   event["type"] = "console_output";
+   event["data"] = output;
+   return event;
+}
+
+
+} // namespace tests
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_CLIENT_EVENT_PUSH_CHANNEL_TEST_CLIENT_HPP
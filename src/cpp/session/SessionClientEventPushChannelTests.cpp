@@ -0,0 +1,194 @@
+/*
+ * SessionClientEventPushChannelTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionClientEventPushChannel.hpp"
+#include "SessionClientEventPushChannelTestClient.hpp"
+
+#include <vector>
+
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace tests {
+
+using namespace boost::posix_time;
+
+test_context("Client event push channel")
+{
+   test_that("Events are only pushed once the active client identifies itself")
+   {
+      ChannelFixture fixture;
+      REQUIRE(!fixture.channel().start());
+
+      PushClient client(fixture.channel().port());
+      REQUIRE(client.connect());
+      CHECK_FALSE(fixture.channel().isReady());
+
+      // a stale client is ignored (messages are handled in order, so by the
+      // time the active client's acknowledgement arrives the stale one has
+      // been seen and dropped)
+      CHECK(client.acknowledge("stale", 8));
+
+      // the active client is asked for a full resend exactly once
+      CHECK(client.acknowledge(kClientId, 10));
+      REQUIRE(fixture.waitForAcknowledged(10));
+      CHECK(fixture.acknowledged() == std::vector<int>({10}));
+      CHECK(fixture.channel().isReady());
+      CHECK(fixture.channel().takeResendRequest());
+      CHECK_FALSE(fixture.channel().takeResendRequest());
+
+      // subsequent acknowledgements are forwarded
+      CHECK(client.acknowledge(kClientId, 12));
+      REQUIRE(fixture.waitForAcknowledged(12));
+      CHECK(fixture.acknowledged() == std::vector<int>({10, 12}));
+      CHECK_FALSE(fixture.channel().takeResendRequest());
+
+      fixture.channel().stop();
+   }
+
+   test_that("The connection is only considered alive while the client uses it")
+   {
+      ChannelFixture fixture;
+      REQUIRE(!fixture.channel().start());
+
+      PushClient client(fixture.channel().port());
+      REQUIRE(client.connect());
+
+      ptime beforeAck = microsec_clock::universal_time();
+      CHECK_FALSE(fixture.channel().isAliveSince(beforeAck));
+
+      CHECK(client.acknowledge(kClientId, -1));
+      REQUIRE(fixture.waitForAcknowledged(-1));
+      CHECK(fixture.channel().isAliveSince(beforeAck));
+
+      // nothing has been heard from the client since
+      ptime afterAck = microsec_clock::universal_time();
+      CHECK_FALSE(fixture.channel().isAliveSince(afterAck));
+
+      CHECK(client.acknowledge(kClientId, 0));
+      REQUIRE(fixture.waitForAcknowledged(0));
+      CHECK(fixture.channel().isAliveSince(afterAck));
+
+      // once closed it is never alive
+      client.disconnect();
+      REQUIRE(fixture.waitForDisconnected());
+      CHECK_FALSE(fixture.channel().isAliveSince(beforeAck));
+
+      fixture.channel().stop();
+   }
+
+   test_that("Pushed batches arrive intact and in order")
+   {
+      ChannelFixture fixture;
+      REQUIRE(!fixture.channel().start());
+
+      PushClient client(fixture.channel().port());
+      REQUIRE(client.connect());
+      CHECK(client.acknowledge(kClientId, -1));
+      REQUIRE(fixture.waitForAcknowledged(-1));
+
+      for (int i = 0; i < 3; i++)
+      {
+         core::json::Array events;
+         events.push_back(consoleOutputEvent(i, "output " + std::to_string(i)));
+         CHECK(!fixture.channel().send(events));
+      }
+
+      REQUIRE(client.waitForMessages(3));
+      std::vector<std::string> messages = client.messages();
+      for (int i = 0; i < 3; i++)
+      {
+         core::json::Value value;
+         REQUIRE(!value.parse(messages[i]));
+         REQUIRE(value.isArray());
+         core::json::Object event = value.getArray()[0].getObject();
+         CHECK(event["id"].getInt() == i);
+      }
+
+      fixture.channel().stop();
+   }
+
+   test_that("Closing the connection stops pushing")
+   {
+      ChannelFixture fixture;
+      REQUIRE(!fixture.channel().start());
+
+      PushClient client(fixture.channel().port());
+      REQUIRE(client.connect());
+      CHECK(client.acknowledge(kClientId, -1));
+      REQUIRE(fixture.waitForAcknowledged(-1));
+      CHECK(fixture.channel().isReady());
+
+      client.disconnect();
+      REQUIRE(fixture.waitForDisconnected());
+      CHECK_FALSE(fixture.channel().isReady());
+
+      core::json::Array events;
+      events.push_back(consoleOutputEvent(0, "lost"));
+      CHECK(fixture.channel().send(events));
+
+      fixture.channel().stop();
+   }
+
+   // a console output flood (as produced by e.g. a tight loop calling
+   // print); each batch mirrors what ClientEventService pushes after its
+   // batching window
+   test_that("Console output floods are delivered in order")
+   {
+      const int kBatches = 200;
+      const int kEventsPerBatch = 16;
+      const std::string kLine(80, 'x');
+
+      ChannelFixture fixture;
+      REQUIRE(!fixture.channel().start());
+
+      PushClient client(fixture.channel().port());
+      REQUIRE(client.connect());
+      CHECK(client.acknowledge(kClientId, -1));
+      REQUIRE(fixture.waitForAcknowledged(-1));
+
+      int nextId = 0;
+      for (int i = 0; i < kBatches; i++)
+      {
+         core::json::Array events;
+         for (int j = 0; j < kEventsPerBatch; j++)
+            events.push_back(consoleOutputEvent(nextId++, kLine + "\n"));
+
+         CHECK(!fixture.channel().send(events));
+      }
+
+      REQUIRE(client.waitForMessages(kBatches));
+      std::vector<std::string> messages = client.messages();
+      REQUIRE(messages.size() == static_cast<std::size_t>(kBatches));
+
+      // every event arrives, in the order it was pushed
+      int expectedId = 0;
+      for (const std::string& message : messages)
+      {
+         core::json::Value batch;
+         REQUIRE(!batch.parse(message));
+         for (const core::json::Value& event : batch.getArray())
+            CHECK(event.getObject()["id"].getInt() == expectedId++);
+      }
+      CHECK(expectedId == nextId);
+
+      fixture.channel().stop();
+   }
+}
+
+} // namespace tests
+} // namespace session
+} // namespace rstudio
@@ -15,6 +15,8 @@
 
 #include "SessionClientEventQueue.hpp"
 
+#include <algorithm>
+
 #include "modules/SessionConsole.hpp"
 
 #include <core/BoostThread.hpp>
@@ -24,15 +26,31 @@
 
 #include <r/session/RConsoleActions.hpp>
 
+#include <session/SessionOptions.hpp>
+
 using namespace rstudio::core;
 
 namespace rstudio {
 namespace session {
  
 namespace {
+
 ClientEventQueue* s_pClientEventQueue = nullptr;
+
+// once this many events have been added without a consumer collecting
+// them, producers opportunistically collect them (so that coalescing and
+// the pending limit apply even when no client is connected)
+const std::size_t kCollectThreshold = 512;
+
+const boost::posix_time::ptime kEpoch(boost::gregorian::date(1970, 1, 1));
+
+int64_t toMicroseconds(const boost::posix_time::ptime& time)
+{
+   return (time - kEpoch).total_microseconds();
 }
 
+} // anonymous namespace
+
 void initializeClientEventQueue()
 {
    BOOST_ASSERT(s_pClientEventQueue == nullptr);
@@ -46,8 +64,12 @@ ClientEventQueue& clientEventQueue()
    
 ClientEventQueue::ClientEventQueue()
    :  pMutex_(new boost::mutex()),
+      pWaitMutex_(new boost::mutex()),
       pWaitForEventCondition_(new boost::condition()),
-      lastEventAddTime_(boost::posix_time::not_a_date_time)
+      eventsAdded_(0),
+      wakeRequested_(false),
+      lastEventAddTime_(0),
+      pendingEvents_(std::max(options().clientEventsMaxPending(), 1))
 {
 }
 
@@ -56,6 +78,9 @@ bool ClientEventQueue::setActiveConsole(const std::string& console)
    bool changed = false;
    LOCK_MUTEX(*pMutex_)
    {
+      // output added so far belongs to the current console
+      collectIncomingEvents();
+
       if (activeConsole_ != console)
       {
          // flush events to the previous console
@@ -72,43 +97,37 @@ bool ClientEventQueue::setActiveConsole(const std::string& console)
 
 void ClientEventQueue::add(const ClientEvent& event)
 { 
-   LOCK_MUTEX(*pMutex_)
+   std::size_t incoming = incomingEvents_.push(event);
+   lastEventAddTime_ = toMicroseconds(
+            boost::posix_time::microsec_clock::universal_time());
+   eventsAdded_++;
+
+   // notify listeners that an event has been added (we only need to take
+   // the wait mutex if someone is actually waiting)
+   if (wakeRequested_.exchange(false))
    {
-      // console output is batched up for compactness/efficiency.
-      if (event.type() == client_events::kConsoleWriteOutput)
-      {
-         if (event.data().getType() == json::Type::STRING)
-            pendingConsoleOutput_ += event.data().getString();
-      }
-      else if (event.type() == client_events::kConsoleWriteError &&
-               event.data().getType() == json::Type::STRING)
-      {
-         flushPendingConsoleOutput();
-         enqueueClientOutputEvent(event.type(), event.data().getString());
-      }
-      else
-      {
-         // flush existing console output prior to adding an 
-         // action of another type
-         flushPendingConsoleOutput();
-         
-         // add event to queue
-         pendingEvents_.push_back(event);
-      }
-      
-      lastEventAddTime_ = boost::posix_time::microsec_clock::universal_time();
+      boost::lock_guard<boost::mutex> lock(*pWaitMutex_);
+      pWaitForEventCondition_->notify_all();
+   }
+
+   // if events are piling up, collect them now -- but never wait on a
+   // consumer to do so
+   if (incoming >= kCollectThreshold)
+   {
+      boost::unique_lock<boost::mutex> lock(*pMutex_, boost::try_to_lock);
+      if (lock.owns_lock())
+         collectIncomingEvents();
    }
-   END_LOCK_MUTEX
-   
-   // notify listeners that an event has been added
-   pWaitForEventCondition_->notify_all();
 }
    
 bool ClientEventQueue::hasEvents() 
 {
+   if (!incomingEvents_.empty())
+      return true;
+
    LOCK_MUTEX(*pMutex_)
    {
-      return pendingEvents_.size() > 0 || pendingConsoleOutput_.length() > 0;
+      return !pendingEvents_.empty() || pendingConsoleOutput_.length() > 0;
    }
    END_LOCK_MUTEX
    
@@ -120,16 +139,13 @@ void ClientEventQueue::remove(std::vector<ClientEvent>* pEvents)
 {
    LOCK_MUTEX(*pMutex_)
    {
+      collectIncomingEvents();
+
       // flush any pending output
       flushPendingConsoleOutput();
       
-      // copy the events to the caller
-      pEvents->insert(pEvents->begin(), 
-                      pendingEvents_.begin(), 
-                      pendingEvents_.end());
-   
-      // clear pending events
-      pendingEvents_.clear();
+      // move the events to the caller
+      pendingEvents_.remove(pEvents);
    } 
    END_LOCK_MUTEX
 }
@@ -138,6 +154,9 @@ void ClientEventQueue::clear()
 {
    LOCK_MUTEX(*pMutex_)
    {
+      std::vector<ClientEvent> discarded;
+      incomingEvents_.popAll(&discarded);
+
       pendingConsoleOutput_.clear();
       pendingEvents_.clear();
    }
@@ -151,9 +170,21 @@ bool ClientEventQueue::waitForEvent(
    using namespace boost;
    try
    {
-      unique_lock<mutex> lock(*pMutex_);
+      uint64_t eventsAdded = eventsAdded_;
+
+      unique_lock<mutex> lock(*pWaitMutex_);
       system_time timeoutTime = get_system_time() + waitDuration;
-      return pWaitForEventCondition_->timed_wait(lock, timeoutTime);
+      while (true)
+      {
+         // ask producers to notify us (re-armed on every pass since a
+         // producer may have consumed the request while we were waking)
+         wakeRequested_ = true;
+         if (eventsAdded_ != eventsAdded)
+            return true;
+
+         if (!pWaitForEventCondition_->timed_wait(lock, timeoutTime))
+            return eventsAdded_ != eventsAdded;
+      }
    }
    catch(const thread_resource_error& e) 
    { 
@@ -167,19 +198,61 @@ bool ClientEventQueue::waitForEvent(
 
 bool ClientEventQueue::eventAddedSince(const boost::posix_time::ptime& time)
 {
+   int64_t lastEventAddTime = lastEventAddTime_;
+   if (lastEventAddTime == 0)
+      return false;
+   else
+      return lastEventAddTime >= toMicroseconds(time);
+}
+
+ClientEventQueue::Statistics ClientEventQueue::statistics()
+{
+   Statistics stats;
+   stats.queued = eventsAdded_;
+
    LOCK_MUTEX(*pMutex_)
    {
-      if (lastEventAddTime_.is_not_a_date_time())
-         return false;
-      else
-         return lastEventAddTime_ >= time;
+      stats.coalesced = pendingEvents_.coalescedCount();
+      stats.resyncs = pendingEvents_.resyncCount();
+      stats.pending = pendingEvents_.size() + incomingEvents_.size();
    }
    END_LOCK_MUTEX
-   
-   // keep compiler happy
-   return false;
+
+   return stats;
+}
+
+void ClientEventQueue::collectIncomingEvents()
+{
+   // NOTE: private helper so no lock required (mutex is not recursive)
+
+   std::vector<ClientEvent> events;
+   incomingEvents_.popAll(&events);
+
+   for (const ClientEvent& event : events)
+   {
+      // console output is batched up for compactness/efficiency.
+      if (event.type() == client_events::kConsoleWriteOutput)
+      {
+         if (event.data().getType() == json::Type::STRING)
+            pendingConsoleOutput_ += event.data().getString();
+      }
+      else if (event.type() == client_events::kConsoleWriteError &&
+               event.data().getType() == json::Type::STRING)
+      {
+         flushPendingConsoleOutput();
+         enqueueClientOutputEvent(event.type(), event.data().getString());
+      }
+      else
+      {
+         // flush existing console output prior to adding an
+         // action of another type
+         flushPendingConsoleOutput();
+
+         // add event to queue
+         pendingEvents_.add(event);
+      }
+   }
 }
-   
 
 void ClientEventQueue::flushPendingConsoleOutput()
 {
@@ -205,7 +278,7 @@ void ClientEventQueue::enqueueClientOutputEvent(
    json::Object output;
    output[kConsoleText] = text;
    output[kConsoleId]   = activeConsole_;
-   pendingEvents_.push_back(ClientEvent(event, output));
+   pendingEvents_.add(ClientEvent(event, output));
 }
 
 } // namespace session
@@ -16,6 +16,7 @@
 #ifndef SESSION_SESSION_CLIENT_EVENT_QUEUE_HPP
 #define SESSION_SESSION_CLIENT_EVENT_QUEUE_HPP
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -24,9 +25,12 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <core/BoostThread.hpp>
+#include <core/collection/MpscQueue.hpp>
 
 #include <session/SessionClientEvent.hpp>
 
+#include "SessionClientEventCoalescer.hpp"
+
 namespace rstudio {
 namespace session {
    
@@ -37,6 +41,11 @@ void initializeClientEventQueue();
 class ClientEventQueue;
 ClientEventQueue& clientEventQueue();
 
+// Events are added from many threads (R, worker threads, the file monitor)
+// but consumed by only one at a time, so add() is lock-free: it pushes the
+// event onto an MPSC queue and only synchronizes with a waiting consumer.
+// Consumers move events from there into a coalescing pending list, which is
+// where console output is batched and redundant events are merged.
 class ClientEventQueue : boost::noncopyable
 {   
 private:
@@ -45,8 +54,25 @@ private:
    
 public:
    // COPYING: boost::noncopyable
+
+   struct Statistics
+   {
+      Statistics() : queued(0), coalesced(0), resyncs(0), pending(0) {}
+
+      // total events added
+      uint64_t queued;
+
+      // events merged into (or cancelled by) a later event
+      uint64_t coalesced;
+
+      // client reloads requested because too many events were pending
+      uint64_t resyncs;
+
+      // events currently awaiting delivery
+      std::size_t pending;
+   };
      
-   // add an event
+   // add an event (lock-free; safe to call from any thread)
    void add(const ClientEvent& event);
    
    // remove all available events
@@ -67,8 +93,12 @@ public:
    // set the active console to be attached to console events; returns true if
    // the active console changed
    bool setActiveConsole(const std::string& console);
+
+   Statistics statistics();
       
 private:   
+   void collectIncomingEvents();
+
    void flushPendingConsoleOutput();
 
    void enqueueClientOutputEvent(int event, const std::string& text);
@@ -78,17 +108,22 @@ private:
    // we don't want them destructed because in desktop mode we don't
    // explicitly stop the queue and this sometimes results in mutex
    // destroy assertions if someone is waiting on the queue while
-   // it is being destroyed
+   // it is being destroyed. pMutex_ serializes consumers (it is never
+   // waited on by add) and pWaitMutex_ pairs with the condition
    boost::mutex* pMutex_;
+   boost::mutex* pWaitMutex_;
    boost::condition* pWaitForEventCondition_;
 
-   // instance data
+   // producer side (lock-free)
+   core::collection::MpscQueue<ClientEvent> incomingEvents_;
+   std::atomic<uint64_t> eventsAdded_;
+   std::atomic<bool> wakeRequested_;
+   std::atomic<int64_t> lastEventAddTime_;
+
+   // consumer side (protected by pMutex_)
    std::string pendingConsoleOutput_;
    std::string activeConsole_;
-   std::vector<ClientEvent> pendingEvents_;
-   boost::posix_time::ptime lastEventAddTime_;
-   
-
+   ClientEventCoalescer pendingEvents_;
 };
 
 } // namespace session
@@ -32,6 +32,7 @@
 #include <session/SessionHttpConnectionListener.hpp>
 #include <session/SessionClientEventService.hpp>
 
+#include "SessionClientEventPushChannel.hpp"
 #include "SessionClientEventQueue.hpp"
 
 using namespace rstudio::core;
@@ -43,6 +44,14 @@ namespace {
 
 const int kLastChanceWaitSeconds = 4;
 
+// when pushing events we don't have to amortize the cost of an http round
+// trip over each batch, so we batch over a much shorter window. we also wake
+// up periodically to service any get_events requests (i.e. a client which
+// has fallen back to long-polling)
+const int kPushWaitMs = 250;
+const int kPushBatchDelayMs = 2;
+const int kPushMaxTotalBatchDelayMs = 20;
+
 bool hasEventIdLessThanOrEqualTo(const json::Value& event, int targetId)
 {
    const json::Object& eventJSON = event.getObject();
@@ -62,6 +71,24 @@ Error ClientEventService::start(const std::string& clientId)
 {
    // set our clientid
    setClientId(clientId, false);
+
+   // start the push channel if requested; if it can't be started clients
+   // will just long-poll for events
+   if (options().clientEventsWebSocket())
+   {
+      ClientEventPushChannelCallbacks callbacks;
+      callbacks.clientId = boost::bind(&ClientEventService::clientId, this);
+      callbacks.onAcknowledged =
+            boost::bind(&ClientEventService::erasePreviouslyDeliveredEvents, this, _1);
+
+      pPushChannel_.reset(new ClientEventPushChannel(callbacks));
+      Error error = pPushChannel_->start();
+      if (error)
+      {
+         LOG_ERROR(error);
+         pPushChannel_.reset();
+      }
+   }
    
    // block all signals for launch of background thread (will cause it
    // to never receive signals)
@@ -102,6 +129,9 @@ void ClientEventService::stop()
 
          serviceThread_.detach();
       }
+
+      if (pPushChannel_)
+         pPushChannel_->stop();
    }
    catch(const boost::thread_interrupted&)
    {
@@ -137,6 +167,11 @@ std::string ClientEventService::clientId()
    return std::string();
 }
 
+int ClientEventService::pushChannelPort()
+{
+   return pPushChannel_ ? pPushChannel_->port() : 0;
+}
+
 void ClientEventService::erasePreviouslyDeliveredEvents(int lastClientEventIdSeen)
 {
    LOCK_MUTEX(mutex_)
@@ -148,6 +183,12 @@ void ClientEventService::erasePreviouslyDeliveredEvents(int lastClientEventIdSee
                                           _1,
                                           lastClientEventIdSeen)),
                clientEvents_.end());
+
+      // sync next event id to client (required so that when we resume
+      // from a suspend we provide client event ids in line with the
+      // client's expectations -- if we started with zero then the client
+      // would never see any events!)
+      nextEventId_ = std::max(nextEventId_, lastClientEventIdSeen + 1);
    }
    END_LOCK_MUTEX
 }
@@ -164,11 +205,24 @@ bool ClientEventService::havePendingClientEvents()
    return false;
 }
 
-void ClientEventService::addClientEvent(const json::Object& eventObject)
+void ClientEventService::addClientEvents(json::Array* pNewEvents)
 {
+   // deque the events
+   std::vector<ClientEvent> events;
+   clientEventQueue().remove(&events);
+
+   // convert to json and add event id
    LOCK_MUTEX(mutex_)
    {
-      clientEvents_.push_back(eventObject);
+      for (std::vector<ClientEvent>::const_iterator
+           it = events.begin(); it != events.end(); ++it)
+      {
+         json::Object event;
+         it->asJsonObject(nextEventId_++, &event);
+         clientEvents_.push_back(event);
+         if (pNewEvents)
+            pNewEvents->push_back(event);
+      }
    }
    END_LOCK_MUTEX
 }
@@ -183,6 +237,67 @@ void ClientEventService::setClientEventResult(
    END_LOCK_MUTEX
 }
 
+bool ClientEventService::pushChannelReady()
+{
+   return pPushChannel_ && pPushChannel_->isReady();
+}
+
+void ClientEventService::pushClientEvents(
+                        bool wait,
+                        const boost::posix_time::time_duration& batchDelay,
+                        const boost::posix_time::time_duration& maxTotalBatchDelay)
+{
+   ClientEventQueue& clientEventQueue = session::clientEventQueue();
+
+   // a client which has just (re)connected gets every event it hasn't
+   // acknowledged, everyone else just gets the newly queued events
+   bool resend = pPushChannel_->takeResendRequest();
+   if (!resend && !clientEventQueue.hasEvents())
+   {
+      if (!wait ||
+          !clientEventQueue.waitForEvent(boost::posix_time::milliseconds(kPushWaitMs)))
+      {
+         return;
+      }
+   }
+
+   // wait (briefly) for additional events that occur in rapid succession
+   if (wait)
+   {
+      boost::system_time maxBatchDelayTime =
+                     boost::get_system_time() + maxTotalBatchDelay;
+
+      while ( clientEventQueue.waitForEvent(batchDelay) &&
+              (boost::get_system_time() < maxBatchDelayTime) )
+      {
+      }
+   }
+
+   json::Array newEvents;
+   addClientEvents(&newEvents);
+
+   Error error;
+   if (resend)
+   {
+      json::Array pendingEvents;
+      LOCK_MUTEX(mutex_)
+      {
+         pendingEvents = clientEvents_.clone().getArray();
+      }
+      END_LOCK_MUTEX
+
+      error = pPushChannel_->send(pendingEvents);
+   }
+   else if (!newEvents.isEmpty())
+   {
+      error = pPushChannel_->send(newEvents);
+   }
+
+   // not fatal -- the events remain in the pending list until they are
+   // acknowledged, so the client will get them when it reconnects
+   if (error)
+      LOG_DEBUG_MESSAGE("Unable to push client events: " + error.getSummary());
+}
 
 void ClientEventService::run()
 {
@@ -204,45 +319,78 @@ void ClientEventService::run()
       // get alias to client event queue
       ClientEventQueue& clientEventQueue = session::clientEventQueue();
       
-      // initialize state
-      int nextEventId = 0;
-      
+      // time at which the previous get_events request was received; used
+      // to check that the push channel is still alive before letting a
+      // get_events request skip the wait
+      ptime lastRequestTime = microsec_clock::universal_time();
+
       // accept loop
       bool stopServer = false;
       while (!stopServer || clientEventQueue.hasEvents())
       {
          boost::shared_ptr<HttpConnection> ptrConnection;
-         try
+
+         // if the client is connected to the push channel then stream events
+         // to it as they arrive, checking (without waiting) for get_events
+         // requests in between so that a client which falls back to
+         // long-polling is still serviced
+         if (pushChannelReady())
          {
-            // wait for up to 1 second for a connection
-            long secondsToWait = stopServer ? kLastChanceWaitSeconds : 1;
-            ptrConnection =
-             httpConnectionListener().eventsConnectionQueue().dequeConnection(
-                                             boost::posix_time::seconds(secondsToWait));
-
-            // if we didn't get one then check for interruption requested
-            // and then continue waiting
-            if (!ptrConnection)
+            try
             {
-               if (stopServer)
+               pushClientEvents(!stopServer,
+                                milliseconds(kPushBatchDelayMs),
+                                milliseconds(kPushMaxTotalBatchDelayMs));
+
+               ptrConnection =
+                  httpConnectionListener().eventsConnectionQueue().dequeConnection();
+               if (!ptrConnection)
                {
-                  // This was our last chance. There are still some events
-                  // left in the queue, but we waited and nobody came.
-                  break;
+                  if (!stopServer && boost::this_thread::interruption_requested())
+                     throw boost::thread_interrupted();
+                  continue;
                }
-
-               // check for interruption and set stopServer flag if we were
-               if (boost::this_thread::interruption_requested())
-                  throw boost::thread_interrupted();
-
-               // accept next request (assuming we weren't interrupted)
+            }
+            catch(const boost::thread_interrupted&)
+            {
+               stopServer = true;
                continue;
             }
          }
-         catch(const boost::thread_interrupted&)
+         else
          {
-            stopServer = true;
-            continue;
+            try
+            {
+               // wait for up to 1 second for a connection
+               long secondsToWait = stopServer ? kLastChanceWaitSeconds : 1;
+               ptrConnection =
+                httpConnectionListener().eventsConnectionQueue().dequeConnection(
+                                                boost::posix_time::seconds(secondsToWait));
+
+               // if we didn't get one then check for interruption requested
+               // and then continue waiting
+               if (!ptrConnection)
+               {
+                  if (stopServer)
+                  {
+                     // This was our last chance. There are still some events
+                     // left in the queue, but we waited and nobody came.
+                     break;
+                  }
+
+                  // check for interruption and set stopServer flag if we were
+                  if (boost::this_thread::interruption_requested())
+                     throw boost::thread_interrupted();
+
+                  // accept next request (assuming we weren't interrupted)
+                  continue;
+               }
+            }
+            catch(const boost::thread_interrupted&)
+            {
+               stopServer = true;
+               continue;
+            }
          }
 
          // parse the json rpc request
@@ -278,18 +426,22 @@ void ClientEventService::run()
          // remove all events already seen by the client from our internal list
          erasePreviouslyDeliveredEvents(lastClientEventIdSeen);
 
-         // sync next event id to client (required so that when we resume
-         // from a suspend we provide client event ids in line with the 
-         // client's expectations -- if we started with zero then the client
-         // would never see any events!)
-         nextEventId = std::max(nextEventId, lastClientEventIdSeen + 1);
+         // events are also being pushed only if the client has used the push
+         // channel since its last get_events request; a client that keeps
+         // polling without doing so has likely lost the connection, and
+         // returning immediately would leave it polling in a tight loop
+         ptime requestTime = microsec_clock::universal_time();
+         bool pushChannelAlive = pPushChannel_ &&
+                                 pPushChannel_->isAliveSince(lastRequestTime);
+         lastRequestTime = requestTime;
 
          // check for events (and wait a specified internal if there are none)
          try
          {
-            // wait for the specified maximum time
+            // wait for the specified maximum time (unless events are also
+            // being pushed, in which case we shouldn't hold them up)
             if (havePendingClientEvents() || clientEventQueue.hasEvents() ||
-                clientEventQueue.waitForEvent(maxRequestSec))
+                (!pushChannelAlive && clientEventQueue.waitForEvent(maxRequestSec)))
             {
                // ...got at least one event
                
@@ -320,18 +472,8 @@ void ClientEventService::run()
          // events on the next iteration of the accept loop
          if (request.clientId == clientId())
          {
-            // deque the events
-            std::vector<ClientEvent> events;
-            clientEventQueue.remove(&events);
-            
-            // convert to json and add event id
-            for (std::vector<ClientEvent>::const_iterator 
-                 it = events.begin(); it != events.end(); ++it)
-            {
-               json::Object event;
-               it->asJsonObject(nextEventId++, &event);
-               addClientEvent(event);
-            }
+            // deque the events, convert to json and add event ids
+            addClientEvents(nullptr);
 
             // send them (pass false for kEventsPending b/c responses from the
             // event service shouldn't interact with automatic event service
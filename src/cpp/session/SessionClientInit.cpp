@@ -53,6 +53,7 @@
 #include <r/ROptions.hpp>
 
 #include <core/CrashHandler.hpp>
+#include <shared_core/SafeConvert.hpp>
 #include <shared_core/json/Json.hpp>
 #include <core/json/JsonRpc.hpp>
 #include <core/http/Request.hpp>
@@ -444,6 +445,24 @@ void handleClientInit(const boost::function<void()>& initFunction,
    sessionInfo["websocket_ping_interval"] = options.webSocketPingInterval();
    sessionInfo["websocket_connect_timeout"] = options.webSocketConnectTimeout();
 
+   // websocket channel for pushing client events (empty if the client
+   // should long-poll). as with terminals, in server mode the client connects
+   // through the port proxy so we provide an obscured form of the port
+   std::string clientEventsChannelId;
+   int clientEventsPort = clientEventService().pushChannelPort();
+   if (clientEventsPort > 0)
+   {
+      clientEventsChannelId = safe_convert::numberToString(clientEventsPort);
+#ifdef RSTUDIO_SERVER
+      if (options.programMode() == kSessionProgramModeServer)
+      {
+         clientEventsChannelId = server_core::transformPort(persistentState().portToken(),
+                                                            clientEventsPort);
+      }
+#endif
+   }
+   sessionInfo["client_events_channel_id"] = clientEventsChannelId;
+
    // publishing may be disabled globally or just for external services, and
    // via configuration options or environment variables
    bool allowPublish = options.allowPublish() &&
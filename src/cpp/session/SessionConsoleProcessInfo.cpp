@@ -122,37 +122,14 @@ void ConsoleProcessInfo::appendToOutputBuffer(char ch)
 std::string ConsoleProcessInfo::getSavedBufferChunk(
       int requestedChunk, bool* pMoreAvailable) const
 {
-   // We read the entire buffer into memory to return a given chunk. This is
-   // ok for our current usage pattern, where the buffer-size is bounded
-   // to a certain number of lines and is infrequently reloaded (only upon
-   // browser refresh or reloading a session). If this pattern becomes
-   // more frequent and/or we support much larger buffers, we'd want to
-   // reconsider this implementation.
-
-   // Read buffer (trims to maxOutputLines_ when chunk zero is requested)
-   std::string buffer = console_persist::getSavedBuffer(
+   // Trims to maxOutputLines_ when chunk zero is requested; only the part
+   // of the buffer holding the chunk is read
+   return console_persist::getSavedBufferChunk(
             handle_,
-            requestedChunk == 0 ? maxOutputLines_ : 0);
-
-   *pMoreAvailable = false;
-
-   // Common case, entire buffer fits in chunk zero
-   if (requestedChunk == 0 && (buffer.length() <= kOutputBufferSize))
-      return buffer;
-
-   // Chunk requested past end of buffer?
-   if (requestedChunk * kOutputBufferSize >= buffer.length())
-      return std::string();
-
-   // Otherwise return substring for the chunk (substr doesn't mind if you ask
-   // for more characters than are available in the string, as long as the
-   // starting position is within the string)
-   std::string chunk = buffer.substr(
-            requestedChunk * kOutputBufferSize, kOutputBufferSize);
-   if (requestedChunk * kOutputBufferSize + chunk.length() < buffer.length())
-      *pMoreAvailable = true;
-
-   return chunk;
+            requestedChunk == 0 ? maxOutputLines_ : 0,
+            requestedChunk,
+            kOutputBufferSize,
+            pMoreAvailable);
 }
 
 std::string ConsoleProcessInfo::getFullSavedBuffer() const
@@ -365,6 +342,11 @@ void ConsoleProcessInfo::saveConsoleProcesses(const std::string& metadata)
    console_persist::saveConsoleProcesses(metadata);
 }
 
+void ConsoleProcessInfo::flushOutputBuffers()
+{
+   console_persist::flushOutputBuffers();
+}
+
 void ConsoleProcessInfo::saveConsoleEnvironment(const core::system::Options& environment)
 {
    console_persist::saveConsoleEnvironment(handle_, environment);
@@ -17,7 +17,10 @@
 
 #include <gsl/gsl>
 
+#include <boost/shared_ptr.hpp>
+
 #include <core/FileSerializer.hpp>
+#include <core/terminal/ScrollbackLog.hpp>
 
 #include <session/SessionModuleContext.hpp>
 #include <session/SessionOptions.hpp>
@@ -54,7 +57,10 @@ namespace console_persist {
 // 2019/07/30 - console06 -> console07
 //                Changed shell type from int to string to align with user
 //                preferences
-#define kConsoleDir "console07"
+// 2020/11/02 - console07 -> console08
+//                Terminal buffers stored as segmented scrollback logs
+//                (<handle>.<n> segments plus a <handle>.index)
+#define kConsoleDir "console08"
 
 namespace {
 
@@ -102,8 +108,20 @@ const FilePath& getConsoleProcIndexPath()
    return s_consoleProcIndexPath;
 }
 
-Error getLogFilePath(const std::string& handle, FilePath* pFile)
+typedef boost::shared_ptr<core::terminal::ScrollbackLog> ScrollbackLogPtr;
+
+// open scrollback logs by terminal handle
+std::map<std::string, ScrollbackLogPtr> s_logs;
+
+Error getLog(const std::string& handle, ScrollbackLogPtr* pLog)
 {
+   auto it = s_logs.find(handle);
+   if (it != s_logs.end())
+   {
+      *pLog = it->second;
+      return Success();
+   }
+
    initialize();
    Error error = getConsoleProcPath().ensureDirectory();
    if (error)
@@ -111,7 +129,15 @@ Error getLogFilePath(const std::string& handle, FilePath* pFile)
       return error;
    }
 
-   *pFile = getConsoleProcPath().completePath(handle);
+   ScrollbackLogPtr pNewLog(new core::terminal::ScrollbackLog(getConsoleProcPath(), handle));
+   error = pNewLog->open();
+   if (error)
+   {
+      return error;
+   }
+
+   s_logs[handle] = pNewLog;
+   *pLog = pNewLog;
    return Success();
 }
 
@@ -151,6 +177,7 @@ std::string loadConsoleProcessMetadata()
 void saveConsoleProcesses(const std::string& metadata)
 {
    initialize();
+   flushOutputBuffers();
 
    if (!s_consoleProcPath.exists())
       return;
@@ -164,119 +191,140 @@ void saveConsoleProcesses(const std::string& metadata)
 std::string getSavedBuffer(const std::string& handle, int maxLines)
 {
    std::string content;
-   FilePath log;
+   ScrollbackLogPtr pLog;
 
-   Error error = getLogFilePath(handle, &log);
+   Error error = getLog(handle, &pLog);
    if (error)
    {
       LOG_ERROR(error);
       return content;
    }
 
-   if (!log.exists())
+   // Trim the buffer based on maxLines. Otherwise it can grow without
+   // bound until the terminal is closed or cleared.
+   if (maxLines > 0)
    {
-      return "";
+      error = pLog->trimLeadingLines(maxLines);
+      if (error)
+         LOG_ERROR(error);
    }
 
-   error = core::readStringFromFile(log, &content);
+   error = pLog->readAll(&content);
+   if (error)
+      LOG_ERROR(error);
+
+   return content;
+}
+
+std::string getSavedBufferChunk(const std::string& handle,
+                                int maxLines,
+                                int chunk,
+                                std::size_t chunkSize,
+                                bool* pMoreAvailable)
+{
+   std::string content;
+   *pMoreAvailable = false;
+
+   ScrollbackLogPtr pLog;
+   Error error = getLog(handle, &pLog);
    if (error)
    {
       LOG_ERROR(error);
       return content;
    }
 
-   if (maxLines < 1)
-      return content;
-
-   // Trim the buffer based on maxLines. Otherwise it can grow without
-   // bound until the terminal is closed or cleared.
-   std::string trimmedOutput = content;
-   if (string_utils::trimLeadingLines(maxLines, &trimmedOutput))
+   if (maxLines > 0)
    {
-      error = core::writeStringToFile(log, trimmedOutput);
+      error = pLog->trimLeadingLines(maxLines);
       if (error)
-      {
-          LOG_ERROR(error);
-          return content;
-      }
+         LOG_ERROR(error);
+   }
+
+   // only the segments holding the chunk are read
+   std::size_t offset = chunk * chunkSize;
+   error = pLog->read(offset, chunkSize, &content);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return content;
    }
-   return trimmedOutput;
+
+   *pMoreAvailable = offset + content.length() < pLog->size();
+   return content;
 }
 
 int getSavedBufferLineCount(const std::string& handle, int maxLines)
 {
-   std::string buffer = getSavedBuffer(handle, maxLines);
-   return gsl::narrow_cast<int>(string_utils::countNewlines(buffer) + 1);
+   ScrollbackLogPtr pLog;
+   Error error = getLog(handle, &pLog);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return 1;
+   }
+
+   if (maxLines > 0)
+   {
+      error = pLog->trimLeadingLines(maxLines);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   return gsl::narrow_cast<int>(pLog->lineCount() + 1);
 }
 
 void appendToOutputBuffer(const std::string& handle, const std::string& buffer)
 {
-   FilePath log;
-   Error error = getLogFilePath(handle, &log);
+   ScrollbackLogPtr pLog;
+   Error error = getLog(handle, &pLog);
    if (error)
    {
       LOG_ERROR(error);
       return;
    }
 
-   error = rstudio::core::appendToFile(log, buffer);
+   error = pLog->append(buffer);
    if (error)
    {
       LOG_ERROR(error);
    }
 }
 
+void flushOutputBuffers()
+{
+   for (const auto& log : s_logs)
+   {
+      Error error = log.second->flush();
+      if (error)
+         LOG_ERROR(error);
+   }
+}
+
 void deleteLogFile(const std::string &handle, bool lastLineOnly)
 {
-   FilePath log;
-   Error error = getLogFilePath(handle, &log);
+   ScrollbackLogPtr pLog;
+   Error error = getLog(handle, &pLog);
    if (error)
    {
       LOG_ERROR(error);
       return;
    }
 
-   if (!log.exists())
-      return;
-
    if (!lastLineOnly)
    {
-      // blow away the file
-      error = log.removeIfExists();
-      if (error)
-      {
-         LOG_ERROR(error);
-         return;
-      }
+      // blow away the log
+      error = pLog->remove();
+      s_logs.erase(handle);
    }
    else
    {
-      // read the file, remove last line and rewrite buffer
-      std::string content;
-      error = core::readStringFromFile(log, &content);
-      if (error)
-      {
-         LOG_ERROR(error);
-         return;
-      }
-
-      size_t lastNewline = content.find_last_of('\n');
-
-      // no complete line in buffer, just blow it away
-      if (lastNewline == std::string::npos)
-      {
-         deleteLogFile(handle, false);
-         return;
-      }
-
-      // erase everything after the final newline
-      content.erase(++lastNewline);
-      error = core::writeStringToFile(log, content);
-      if (error)
-      {
-          LOG_ERROR(error);
-      }
+      // remove everything after the final newline (only the last segment
+      // need be rewritten)
+      error = pLog->removeLastLine();
    }
+
+   if (error)
+      LOG_ERROR(error);
 }
 
 void deleteOrphanedLogs(bool (*validHandle)(const std::string&))
@@ -284,6 +332,9 @@ void deleteOrphanedLogs(bool (*validHandle)(const std::string&))
    if (!validHandle)
       return;
 
+   // write any buffered output so that its files are found below
+   flushOutputBuffers();
+
    // Delete orphaned buffer files
    std::vector<FilePath> children;
    Error error = getConsoleProcPath().getChildren(children);
@@ -302,6 +353,8 @@ void deleteOrphanedLogs(bool (*validHandle)(const std::string&))
 
       if (!validHandle(child.getStem()))
       {
+         // (discarding any output not yet written)
+         s_logs.erase(child.getStem());
          error = child.remove();
          if (error)
             LOG_ERROR(error);
@@ -380,6 +380,14 @@ void ConsoleProcessSocket::onFail(terminalServer* s, websocketpp::connection_hdl
    terminalServer::connection_ptr con = s->get_con_from_hdl(hdl);
    std::string message = "Terminal websocket failure: " + con->get_ec().message();
    LOG_ERROR_MESSAGE(message);
+
+   std::string handle = getHandle(s, hdl);
+   if (handle.empty())
+      return;
+
+   ConsoleProcessSocketConnectionDetails details = connections_.get(handle);
+   if (details.connectionCallbacks_.onConnectionError)
+      details.connectionCallbacks_.onConnectionError();
 }
 
 std::string ConsoleProcessSocket::getHandle(terminalServer* s, websocketpp::connection_hdl hdl)
@@ -92,6 +92,7 @@ bool isKnownProcHandle(const std::string& handle)
 
 void onSuspend(core::Settings* /*pSettings*/)
 {
+   ConsoleProcessInfo::flushOutputBuffers();
    serializeConsoleProcs(PersistentSerialization);
    s_visibleTerminalHandle.clear();
 }
@@ -109,6 +110,12 @@ void loadConsoleProcesses()
    ConsoleProcessInfo::deleteOrphanedLogs(isKnownProcHandle);
 }
 
+bool flushOutputBuffers()
+{
+   ConsoleProcessInfo::flushOutputBuffers();
+   return true;
+}
+
 } // anonymous namespace--------------
 
 ConsoleProcessPtr findProcByHandle(const std::string& handle)
@@ -177,6 +184,7 @@ void saveConsoleProcesses()
 
 void saveConsoleProcessesAtShutdown(bool terminatedNormally)
 {
+   ConsoleProcessInfo::flushOutputBuffers();
    if (!terminatedNormally)
       return;
 
@@ -241,6 +249,12 @@ Error internalInitialize()
 
    loadConsoleProcesses();
 
+   // terminal output is buffered in memory and written out periodically
+   module_context::schedulePeriodicWork(boost::posix_time::seconds(1),
+                                        flushOutputBuffers,
+                                        false, // idleOnly
+                                        false); // immediate
+
    return initializeApi();
 }
 
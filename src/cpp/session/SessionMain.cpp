@@ -132,6 +132,7 @@
 #include "modules/SessionCRANMirrors.hpp"
 #include "modules/SessionCrypto.hpp"
 #include "modules/SessionErrors.hpp"
+#include "modules/SessionFileNameIndex.hpp"
 #include "modules/SessionFiles.hpp"
 #include "modules/SessionFind.hpp"
 #include "modules/SessionGraphics.hpp"
@@ -522,6 +523,7 @@ Error rInit(const rstudio::r::session::RInitInfo& rInitInfo)
 #ifdef RSTUDIO_SERVER
       (modules::crypto::initialize)
 #endif
+      (modules::file_name_index::initialize)
       (modules::code_search::initialize)
       (modules::clang::initialize)
       (modules::connections::initialize)
@@ -1988,6 +1988,8 @@ void enqueFileChangedEvent(const core::system::FileChangeEvent &event)
    FilePath filePath = FilePath(event.fileInfo().absolutePath());
 
    using namespace session::modules::source_control;
+   modules::source_control::onFilesChanged(
+            std::vector<core::system::FileChangeEvent>(1, event));
    auto pCtx = fileDecorationContext(filePath, true);
    enqueFileChangedEvent(event, pCtx);
 }
@@ -2000,6 +2002,9 @@ void enqueFileChangedEvents(const core::FilePath& vcsStatusRoot,
    if (events.empty())
       return;
 
+   // (before decorating the files with their status)
+   modules::source_control::onFilesChanged(events);
+
    // try to find the common parent of the events
    FilePath commonParentPath = FilePath(events.front().fileInfo().absolutePath()).getParent();
    for (const core::system::FileChangeEvent& event : events)
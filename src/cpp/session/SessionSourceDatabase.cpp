@@ -17,6 +17,7 @@
 
 #include <string>
 #include <vector>
+#include <set>
 #include <algorithm>
 
 #include <boost/bind.hpp>
@@ -27,6 +28,7 @@
 #include <core/Exec.hpp>
 #include <shared_core/Error.hpp>
 #include <shared_core/FilePath.hpp>
+#include <shared_core/SafeConvert.hpp>
 #include <core/Hash.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/FileUtils.hpp>
@@ -48,6 +50,7 @@
 #include "SessionSourceDatabaseSupervisor.hpp"
 
 #define kContentsSuffix "-contents"
+#define kJournalSuffix  "-journal"
 
 // NOTE: if a file is deleted then its properties database entry is not
 // deleted. this has two implications:
@@ -59,6 +62,17 @@
 // One way to overcome this might be to use filesystem metadata to store
 // properties rather than a side-database
 
+// NOTE: edits made via SourceDocument::replaceContents are persisted by
+// appending them to a '<id>-journal' file rather than rewriting the entire
+// '<id>-contents' file. each journal record is a header line of the form
+//
+//   <base hash> <offset> <length> <replacement bytes> <new hash>
+//
+// followed by the replacement bytes and a newline. when reading a document
+// the records are replayed on top of the contents file, stopping at the first
+// record which doesn't apply cleanly (e.g. one truncated by a crash). once
+// the journal grows large it is compacted into the contents file at idle time
+
 using namespace rstudio::core;
 
 namespace rstudio {
@@ -233,6 +247,8 @@ Error attemptContentsMigration(json::Object& propertiesJson,
    return writeStringToFile(contentsPath, contents);
 }
 
+const std::size_t kReadOnlyHeaderSize = 64 * 1024;
+
 bool isIntendedAsReadOnly(const std::string& contents,
                           std::vector<std::string>* pAlternatives)
 {
@@ -283,6 +299,7 @@ bool isIntendedAsReadOnly(const std::string& contents,
 }  // anonymous namespace
 
 SourceDocument::SourceDocument(const std::string& type)
+   : flatContentsValid_(false), contentsReplaced_(false)
 {
    FilePath srcDBPath = source_database::path();
    FilePath docPath = file_utils::uniqueFilePath(srcDBPath);
@@ -319,12 +336,79 @@ bool SourceDocument::isUntitled() const
    return path().empty() && !getProperty("tempName").empty();
 }
 
+const std::string& SourceDocument::contents() const
+{
+   // flatten the contents on demand (most edits never need them)
+   if (!flatContentsValid_)
+   {
+      flatContents_.clear();
+      contents_.appendTo(&flatContents_);
+      flatContentsValid_ = true;
+   }
+   return flatContents_;
+}
+
 // set contents from string
 void SourceDocument::setContents(const std::string& contents)
+{
+   setContents(text::Rope(contents));
+   flatContents_ = contents;
+   flatContentsValid_ = true;
+}
+
+void SourceDocument::setContents(const text::Rope& contents)
 {
    contents_ = contents;
-   hash_ = hash::crc32Hash(contents_);
+   flatContents_.clear();
+   flatContentsValid_ = false;
+
+   // same value as hash::crc32Hash(contents)
+   hash_ = safe_convert::numberToString(contents_.crc32());
    lastContentUpdate_ = static_cast<std::time_t>(date_time::millisecondsSinceEpoch());
+
+   pendingContentEdits_.clear();
+   contentsReplaced_ = true;
+}
+
+bool SourceDocument::replaceContents(std::size_t offset,
+                                     std::size_t length,
+                                     const std::string& replacement,
+                                     bool* pChanged)
+{
+   *pChanged = false;
+   if (offset > contents_.size() || length > contents_.size() - offset)
+      return false;
+
+   if (replacement.size() == length && contents_.substr(offset, length) == replacement)
+      return true;
+
+   ContentEdit edit;
+   edit.baseHash = hash_;
+   edit.offset = offset;
+   edit.length = length;
+   edit.replacement = replacement;
+
+   contents_.replace(offset, length, replacement);
+   flatContents_.clear();
+   flatContentsValid_ = false;
+   hash_ = safe_convert::numberToString(contents_.crc32());
+   lastContentUpdate_ = static_cast<std::time_t>(date_time::millisecondsSinceEpoch());
+
+   // no need to track edits if the contents must be written in full anyway
+   if (!contentsReplaced_)
+   {
+      edit.newHash = hash_;
+      pendingContentEdits_.push_back(edit);
+   }
+
+   *pChanged = true;
+   return true;
+}
+
+void SourceDocument::setContentsPersisted()
+{
+   pendingContentEdits_.clear();
+   contentsReplaced_ = false;
 }
 
 // set contents from file
@@ -367,7 +451,7 @@ Error SourceDocument::contentsMatchDisk(bool *pMatches)
       if (error)
          return error;
 
-      *pMatches = contents_.length() == contents.length() && 
+      *pMatches = contents_.size() == contents.length() && 
                   hash_ == hash::crc32Hash(contents);
    }
 
@@ -448,7 +532,8 @@ void SourceDocument::setLastKnownWriteTime(std::time_t time)
    lastKnownWriteTime_ = time;
 }
    
-Error SourceDocument::readFromJson(json::Object* pDocJson)
+Error SourceDocument::readFromJson(json::Object* pDocJson,
+                                   const text::Rope* pContents)
 {
    // NOTE: since this class is the one who presumably persisted the
    // json values in the first place we don't do "checked" access to
@@ -473,7 +558,10 @@ Error SourceDocument::readFromJson(json::Object* pDocJson)
       json::Value type = docJson["type"];
       type_ = !type.isNull() ? type.getString() : std::string();
 
-      setContents(docJson["contents"].getString());
+      if (pContents)
+         setContents(*pContents);
+      else
+         setContents(docJson["contents"].getString());
       dirty_ = docJson["dirty"].getBool();
       created_ = docJson["created"].getDouble();
       sourceOnSave_ = docJson["source_on_save"].getBool();
@@ -541,8 +629,12 @@ void SourceDocument::writeToJson(json::Object* pDocJson, bool includeContents) c
    jsonDoc["last_content_update"] = json::Value(
          static_cast<boost::int64_t>(lastContentUpdate_));
    
+   // the markers we look for are at the top of the document, so there's no
+   // need to flatten large documents to find them
    std::vector<std::string> alternatives;
-   jsonDoc["read_only"] = isIntendedAsReadOnly(contents(), &alternatives);
+   std::string header = includeContents || contents_.size() <= kReadOnlyHeaderSize ?
+            contents() : contents_.substr(0, kReadOnlyHeaderSize);
+   jsonDoc["read_only"] = isIntendedAsReadOnly(header, &alternatives);
    jsonDoc["read_only_alternatives"] = json::toJsonArray(alternatives);
 }
 
@@ -566,7 +658,7 @@ Error SourceDocument::writeToFile(const FilePath& filePath, bool writeContents)
    if (writeContents)
    {
       FilePath contentsPath(filePath.getAbsolutePath() + kContentsSuffix);
-      Error error = writeStringToFile(contentsPath, contents_);
+      Error error = writeStringToFile(contentsPath, contents());
       if (error)
          return error;
    }
@@ -619,32 +711,383 @@ FilePath path()
    return supervisor::sessionDirPath();
 }
 
-Error get(const std::string& id, boost::shared_ptr<SourceDocument> pDoc)
+namespace {
+
+// the contents of a document as persisted (the contents file with the
+// journal replayed on top of it), cached so that documents being edited
+// needn't be re-read and re-hashed on every save
+struct ContentsHead
 {
-   return get(id, true, pDoc);
+   ContentsHead()
+      : convertLineEndings(false),
+        journalValid(true),
+        contentsSize(0),
+        contentsTime(0),
+        journalSize(0),
+        lastUsed(0)
+   {
+   }
+
+   text::Rope contents;
+   std::string hash;
+
+   // do the contents need line ending conversion when read?
+   bool convertLineEndings;
+
+   // can edits be appended to the journal? (false if it has records which
+   // couldn't be replayed)
+   bool journalValid;
+
+   // stamps of the files the contents were read from (so that we notice
+   // if they were changed from elsewhere)
+   uintmax_t contentsSize;
+   std::time_t contentsTime;
+   uintmax_t journalSize;
+
+   boost::uint64_t lastUsed;
+};
+
+// cached heads (keyed by properties path)
+const std::size_t kMaxContentsHeads = 32;
+std::map<std::string, ContentsHead> s_contentsHeads;
+boost::uint64_t s_contentsHeadsClock = 0;
+
+// journals are compacted once they exceed this size or a quarter of the size
+// of the contents file (whichever is larger)
+const uintmax_t kMinJournalCompactionSize = 64 * 1024;
+std::set<std::string> s_pendingCompactions;
+
+FilePath contentsPathFor(const FilePath& propertiesPath)
+{
+   return FilePath(propertiesPath.getAbsolutePath() + kContentsSuffix);
 }
-   
-Error get(const std::string& id, bool includeContents, boost::shared_ptr<SourceDocument> pDoc)
+
+FilePath journalPathFor(const FilePath& propertiesPath)
 {
-   FilePath propertiesPath = source_database::path().completePath(id);
-   
-   // attempt to read file contents from sidecar file if available
+   return FilePath(propertiesPath.getAbsolutePath() + kJournalSuffix);
+}
+
+bool requiresLineEndingConversion(const std::string& text)
+{
+   return text.find('\r') != std::string::npos ||
+          text.find("\xE2\x80\xA8") != std::string::npos ||
+          text.find("\xE2\x80\xA9") != std::string::npos;
+}
+
+void stampContentsHead(const FilePath& propertiesPath, ContentsHead* pHead)
+{
+   FilePath contentsPath = contentsPathFor(propertiesPath);
+   FilePath journalPath = journalPathFor(propertiesPath);
+
+   bool contentsExist = contentsPath.exists();
+   pHead->contentsSize = contentsExist ? contentsPath.getSize() : 0;
+   pHead->contentsTime = contentsExist ? contentsPath.getLastWriteTime() : 0;
+   pHead->journalSize = journalPath.exists() ? journalPath.getSize() : 0;
+}
+
+bool isContentsHeadCurrent(const FilePath& propertiesPath, const ContentsHead& head)
+{
+   ContentsHead current;
+   stampContentsHead(propertiesPath, &current);
+   return current.contentsSize == head.contentsSize &&
+          current.contentsTime == head.contentsTime &&
+          current.journalSize == head.journalSize;
+}
+
+void formatJournalRecord(const ContentEdit& edit, std::string* pJournal)
+{
+   pJournal->append(edit.baseHash + " " +
+                    safe_convert::numberToString(edit.offset) + " " +
+                    safe_convert::numberToString(edit.length) + " " +
+                    safe_convert::numberToString(edit.replacement.size()) + " " +
+                    edit.newHash + "\n");
+   pJournal->append(edit.replacement);
+   pJournal->append("\n");
+}
+
+bool parseJournalRecord(const std::string& journal, std::size_t* pPos, ContentEdit* pEdit)
+{
+   std::size_t eol = journal.find('\n', *pPos);
+   if (eol == std::string::npos)
+      return false;
+
+   std::size_t bytes = 0;
+   std::istringstream header(journal.substr(*pPos, eol - *pPos));
+   header >> pEdit->baseHash >> pEdit->offset >> pEdit->length >> bytes >> pEdit->newHash;
+   if (header.fail())
+      return false;
+
+   // the replacement must be present in full (it won't be if we crashed
+   // while appending the record)
+   std::size_t start = eol + 1;
+   if (bytes >= journal.size() - start || journal[start + bytes] != '\n')
+      return false;
+
+   pEdit->replacement = journal.substr(start, bytes);
+   *pPos = start + bytes + 1;
+   return true;
+}
+
+void loadContentsHead(const FilePath& propertiesPath, ContentsHead* pHead)
+{
+   FilePath contentsPath = contentsPathFor(propertiesPath);
+   FilePath journalPath = journalPathFor(propertiesPath);
+
+   // stamp first so that changes made while we're reading are noticed
+   stampContentsHead(propertiesPath, pHead);
+
+   // read the contents verbatim (any line ending conversion is applied after
+   // the journal, whose offsets are relative to the unconverted contents)
    std::string contents;
-   if (includeContents)
+   if (contentsPath.exists())
+   {
+      Error error = readStringFromFile(contentsPath, &contents);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   pHead->convertLineEndings = requiresLineEndingConversion(contents);
+   pHead->contents.assign(contents);
+   pHead->hash = safe_convert::numberToString(pHead->contents.crc32());
+   pHead->journalValid = true;
+
+   if (!journalPath.exists())
+      return;
+
+   std::string journal;
+   Error error = readStringFromFile(journalPath, &journal);
+   if (error)
+   {
+      LOG_ERROR(error);
+      pHead->journalValid = false;
+      return;
+   }
+
+   // replay each record which applies to the contents as they stand
+   std::size_t pos = 0;
+   while (pos < journal.size())
    {
-      FilePath contentsPath(propertiesPath.getAbsolutePath() + kContentsSuffix);
-      if (contentsPath.exists())
+      std::size_t next = pos;
+      ContentEdit edit;
+      if (!parseJournalRecord(journal, &next, &edit) || edit.baseHash != pHead->hash)
+         break;
+
+      text::Rope edited = pHead->contents;
+      if (!edited.replace(edit.offset, edit.length, edit.replacement) ||
+          safe_convert::numberToString(edited.crc32()) != edit.newHash)
       {
-         Error error = readStringFromFile(contentsPath,
-                                          &contents,
-                                          options().sourceLineEnding());
-         if (error)
-            LOG_ERROR(error);
+         break;
       }
+
+      pHead->contents = edited;
+      pHead->hash = edit.newHash;
+      if (requiresLineEndingConversion(edit.replacement))
+         pHead->convertLineEndings = true;
+      pos = next;
+   }
+
+   if (pos < journal.size())
+   {
+      LOG_WARNING_MESSAGE("Ignoring " + safe_convert::numberToString(journal.size() - pos) +
+                          " bytes of source database journal " +
+                          journalPath.getAbsolutePath());
+      pHead->journalValid = false;
+   }
+}
+
+ContentsHead& insertContentsHead(const FilePath& propertiesPath)
+{
+   std::string key = propertiesPath.getAbsolutePath();
+   if (s_contentsHeads.find(key) == s_contentsHeads.end() &&
+       s_contentsHeads.size() >= kMaxContentsHeads)
+   {
+      auto lru = std::min_element(
+               s_contentsHeads.begin(),
+               s_contentsHeads.end(),
+               [](const std::pair<const std::string, ContentsHead>& a,
+                  const std::pair<const std::string, ContentsHead>& b)
+      {
+         return a.second.lastUsed < b.second.lastUsed;
+      });
+      s_contentsHeads.erase(lru);
+   }
+
+   ContentsHead& head = s_contentsHeads[key];
+   head.lastUsed = ++s_contentsHeadsClock;
+   return head;
+}
+
+// the cached head for the document if it's still current (or null)
+ContentsHead* findContentsHead(const FilePath& propertiesPath)
+{
+   auto it = s_contentsHeads.find(propertiesPath.getAbsolutePath());
+   if (it == s_contentsHeads.end() || !isContentsHeadCurrent(propertiesPath, it->second))
+      return nullptr;
+
+   it->second.lastUsed = ++s_contentsHeadsClock;
+   return &it->second;
+}
+
+// the head for the document (reading it if there's no current cached head)
+ContentsHead& contentsHead(const FilePath& propertiesPath)
+{
+   ContentsHead* pHead = findContentsHead(propertiesPath);
+   if (pHead)
+      return *pHead;
+
+   ContentsHead& head = insertContentsHead(propertiesPath);
+   loadContentsHead(propertiesPath, &head);
+   return head;
+}
+
+void removeContentsHead(const FilePath& propertiesPath)
+{
+   s_contentsHeads.erase(propertiesPath.getAbsolutePath());
+}
+
+text::Rope readContents(const FilePath& propertiesPath)
+{
+   const ContentsHead& head = contentsHead(propertiesPath);
+   if (!head.convertLineEndings)
+      return head.contents;
+
+   std::string contents = head.contents.str();
+   string_utils::convertLineEndings(&contents, options().sourceLineEnding());
+   return text::Rope(contents);
+}
+
+void compactJournal(const FilePath& propertiesPath)
+{
+   s_pendingCompactions.erase(propertiesPath.getAbsolutePath());
+
+   FilePath journalPath = journalPathFor(propertiesPath);
+   if (!propertiesPath.exists() || !journalPath.exists())
+      return;
+
+   // write the contents before removing the journal: should we crash in
+   // between, the journal no longer applies to the new contents (or, if the
+   // edits in it were a no-op, replays to the very same contents)
+   ContentsHead& head = contentsHead(propertiesPath);
+   Error error = writeStringToFile(contentsPathFor(propertiesPath), head.contents.str());
+   if (error)
+   {
+      LOG_ERROR(error);
+      removeContentsHead(propertiesPath);
+      return;
+   }
+
+   error = journalPath.remove();
+   if (error)
+      LOG_ERROR(error);
+
+   head.journalValid = true;
+   stampContentsHead(propertiesPath, &head);
+}
+
+void scheduleCompaction(const FilePath& propertiesPath)
+{
+   if (!s_pendingCompactions.insert(propertiesPath.getAbsolutePath()).second)
+      return;
+
+   module_context::scheduleDelayedWork(boost::posix_time::seconds(5),
+                                       boost::bind(compactJournal, propertiesPath),
+                                       true); // idle only
+}
+
+// append the document's pending edits to its journal; returns false if they
+// can't be (because the contents were replaced, or the edits don't apply to
+// the persisted contents) in which case the contents must be written in full
+bool appendToJournal(const FilePath& propertiesPath, const SourceDocument& doc)
+{
+   if (doc.contentsReplaced())
+      return false;
+
+   ContentsHead* pHead = findContentsHead(propertiesPath);
+   if (pHead == nullptr || !pHead->journalValid)
+      return false;
+
+   const std::vector<ContentEdit>& edits = doc.pendingContentEdits();
+   if (pHead->hash != (edits.empty() ? doc.hash() : edits.front().baseHash))
+      return false;
+
+   // nothing to do if the contents are unchanged
+   if (edits.empty())
+      return true;
+
+   std::string records;
+   bool convertLineEndings = false;
+   for (const ContentEdit& edit : edits)
+   {
+      formatJournalRecord(edit, &records);
+      if (requiresLineEndingConversion(edit.replacement))
+         convertLineEndings = true;
    }
+
+   Error error = appendToFile(journalPathFor(propertiesPath), records);
+   if (error)
+   {
+      // a partially written record would stop the replay of any which
+      // follow, so don't append any more to this journal
+      LOG_ERROR(error);
+      pHead->journalValid = false;
+      return false;
+   }
+
+   pHead->contents = doc.contentsRope();
+   pHead->hash = doc.hash();
+   if (convertLineEndings)
+      pHead->convertLineEndings = true;
+   stampContentsHead(propertiesPath, pHead);
+
+   if (pHead->journalSize > std::max(kMinJournalCompactionSize, pHead->contentsSize / 4))
+      scheduleCompaction(propertiesPath);
+
+   return true;
+}
+
+Error writeFullContents(const FilePath& propertiesPath, const SourceDocument& doc)
+{
+   // remove the journal before writing the contents: should we crash in
+   // between the journal could otherwise be replayed on top of contents
+   // which happen to match those it was based on
+   Error error = journalPathFor(propertiesPath).removeIfExists();
+   if (error)
+      return error;
+
+   error = doc.writeToFile(propertiesPath);
+   if (error)
+   {
+      removeContentsHead(propertiesPath);
+      return error;
+   }
+
+   ContentsHead& head = insertContentsHead(propertiesPath);
+   head.contents = doc.contentsRope();
+   head.hash = doc.hash();
+   head.convertLineEndings = requiresLineEndingConversion(doc.contents());
+   head.journalValid = true;
+   stampContentsHead(propertiesPath, &head);
+   return Success();
+}
+
+} // anonymous namespace
+
+Error get(const std::string& id, boost::shared_ptr<SourceDocument> pDoc)
+{
+   return get(id, true, pDoc);
+}
+   
+Error get(const std::string& id, bool includeContents, boost::shared_ptr<SourceDocument> pDoc)
+{
+   FilePath propertiesPath = source_database::path().completePath(id);
    
    if (propertiesPath.exists())
    {
+      // read file contents from sidecar file (and journal) if available
+      text::Rope contents;
+      if (includeContents)
+         contents = readContents(propertiesPath);
+
       // read the contents of the file
       std::string properties;
       Error error = readStringFromFile(propertiesPath,
@@ -670,13 +1113,20 @@ Error get(const std::string& id, bool includeContents, boost::shared_ptr<SourceD
       if (error)
          LOG_ERROR(error);
       
-      if (includeContents && !contents.empty())
-         jsonDoc["contents"] = contents;
-      
       if (jsonDoc.find("contents") == jsonDoc.end())
          jsonDoc["contents"] = std::string();
       
-      return pDoc->readFromJson(&jsonDoc);
+      if (includeContents && !contents.empty())
+         error = pDoc->readFromJson(&jsonDoc, &contents);
+      else
+         error = pDoc->readFromJson(&jsonDoc);
+      if (error)
+         return error;
+
+      // subsequent edits can be journaled (provided the contents match
+      // those persisted, which put checks)
+      pDoc->setContentsPersisted();
+      return Success();
    }
    else
    {
@@ -700,7 +1150,8 @@ bool isSourceDocument(const FilePath& filePath)
        filename == "lock_file" ||
        filename == "suspend_file" ||
        filename == "restart_file" ||
-       boost::algorithm::ends_with(filename, kContentsSuffix))
+       boost::algorithm::ends_with(filename, kContentsSuffix) ||
+       boost::algorithm::ends_with(filename, kJournalSuffix))
    {
       return false;
    }
@@ -824,12 +1275,19 @@ Error list(std::vector<FilePath>* pPaths)
    
 Error put(boost::shared_ptr<SourceDocument> pDoc, bool writeContents)
 {   
-   // write to file
+   // write to file (appending edits to the journal where possible)
    FilePath filePath = source_database::path().completePath(pDoc->id());
-   Error error = pDoc->writeToFile(filePath, writeContents);
+   Error error;
+   if (writeContents && !appendToJournal(filePath, *pDoc))
+      error = writeFullContents(filePath, *pDoc);
+   else
+      error = pDoc->writeToFile(filePath, false);
    if (error)
       return error;
 
+   if (writeContents)
+      pDoc->setContentsPersisted();
+
    // write properties to durable storage (if there is a path)
    if (!pDoc->path().empty())
    {
@@ -843,11 +1301,20 @@ Error put(boost::shared_ptr<SourceDocument> pDoc, bool writeContents)
    
 Error remove(const std::string& id)
 {
-   return source_database::path().completePath(id).removeIfExists();
+   FilePath propertiesPath = source_database::path().completePath(id);
+   removeContentsHead(propertiesPath);
+
+   Error error = journalPathFor(propertiesPath).removeIfExists();
+   if (error)
+      LOG_ERROR(error);
+
+   return propertiesPath.removeIfExists();
 }
    
 Error removeAll()
 {
+   s_contentsHeads.clear();
+
    std::vector<FilePath> files;
    Error error = source_database::path().getChildren(files);
    if (error)
@@ -20,6 +20,8 @@
 #include <boost/array.hpp>
 
 #include <boost/utility.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/write.hpp>
 #include <boost/asio/placeholders.hpp>
@@ -45,6 +47,13 @@
 namespace rstudio {
 namespace session {
 
+// persistent connections which sit idle for this long are closed. this is
+// sooner than rserver discards idle connections from its pool, so rserver
+// finds them closed when it checks a connection before reusing it (rather
+// than once it has already written a request to it)
+const boost::posix_time::time_duration kPersistentConnectionIdleTimeout =
+      boost::posix_time::minutes(1);
+
 template <typename ProtocolType>
 class HttpConnectionImpl :
    public HttpConnection,
@@ -60,8 +69,16 @@ public:
 public:
    HttpConnectionImpl(boost::asio::io_service& ioService,
                       const HeadersParsedHandler& headersParsed,
-                      const Handler& handler)
-      : socket_(ioService), headersParsedHandler_(headersParsed), handler_(handler)
+                      const Handler& handler,
+                      bool allowPersistentConnections = false)
+      : ioService_(ioService),
+        socket_(ioService),
+        idleTimer_(ioService),
+        headersParsedHandler_(headersParsed),
+        handler_(handler),
+        allowPersistentConnections_(allowPersistentConnections),
+        requestComplete_(false),
+        uploadHandlerSet_(false)
    {
    }
 
@@ -84,6 +101,7 @@ public:
 
    virtual void sendResponse(const core::http::Response &response)
    {
+      bool keepAlive = false;
       try
       {
          if (response.isStreamResponse())
@@ -102,10 +120,32 @@ public:
             return;
          }
 
-         // write the non streaming response
-         boost::asio::write(socket_,
-                            response.toBuffers(
-                                  core::http::Header::connectionClose()));
+         keepAlive = isPersistentRequest() &&
+                     response.statusCode() != core::http::status::SwitchingProtocols;
+         if (keepAlive)
+         {
+            // persistent connections require the response to be delimited
+            // by its Content-Length (the client can't wait for eof)
+            core::http::Header keepAliveHeader("Connection", "keep-alive");
+            if (response.headerValue("Content-Length").empty())
+            {
+               core::http::Response delimitedResponse;
+               delimitedResponse.assign(response);
+               delimitedResponse.setContentLength(response.body().length());
+               boost::asio::write(socket_, delimitedResponse.toBuffers(keepAliveHeader));
+            }
+            else
+            {
+               boost::asio::write(socket_, response.toBuffers(keepAliveHeader));
+            }
+         }
+         else
+         {
+            // write the non streaming response
+            boost::asio::write(socket_,
+                               response.toBuffers(
+                                     core::http::Header::connectionClose()));
+         }
       }
       catch(const boost::system::system_error& e)
       {
@@ -116,10 +156,23 @@ public:
          // log the error if it wasn't connection terminated
          if (!core::http::isConnectionTerminatedError(error))
             LOG_ERROR(error);
+
+         keepAlive = false;
       }
       CATCH_UNEXPECTED_EXCEPTION
 
-      // always close connection
+      // wait for the next request on a persistent connection
+      if (keepAlive)
+      {
+         try
+         {
+            readNextRequest();
+            return;
+         }
+         CATCH_UNEXPECTED_EXCEPTION
+      }
+
+      // otherwise close connection
       try
       {
          close();
@@ -167,6 +220,7 @@ public:
                                                         continuation);
 
       requestParser_.setFormHandler(formHandler);
+      uploadHandlerSet_ = true;
    }
 
 
@@ -195,6 +249,10 @@ private:
    {
       try
       {
+         // the connection is no longer idle
+         boost::system::error_code cancelEc;
+         idleTimer_.cancel(cancelEc);
+
          if (!e)
          {
             // parse next chunk
@@ -246,6 +304,8 @@ private:
             // got valid request -- handle it
             else
             {
+               requestComplete_ = true;
+
                // call handler
                handler_(HttpConnectionImpl<ProtocolType>::shared_from_this());
 
@@ -257,10 +317,14 @@ private:
          }
          else // error reading
          {
-            // log the error if it wasn't connection terminated
+            // log the error if it wasn't connection terminated (or closed
+            // by us for being idle)
             core::Error error(e, ERROR_LOCATION);
-            if (!core::http::isConnectionTerminatedError(error))
+            if (!core::http::isConnectionTerminatedError(error) &&
+                e != boost::asio::error::operation_aborted)
+            {
                LOG_ERROR(error);
+            }
 
             // close the connection
             close();
@@ -272,6 +336,59 @@ private:
       CATCH_UNEXPECTED_EXCEPTION
    }
 
+   // the client asked for the connection to be kept open after a complete
+   // (non-upload) request, and we accept persistent connections from it
+   bool isPersistentRequest() const
+   {
+      return allowPersistentConnections_ &&
+             requestComplete_ &&
+             !uploadHandlerSet_ &&
+             boost::algorithm::iequals(request_.headerValue("Connection"), "keep-alive");
+   }
+
+   // hand the socket over to a new connection which reads the next request.
+   // we use a new object rather than resetting this one since the handler
+   // that sent the response may still be referencing our request()
+   void readNextRequest()
+   {
+      boost::shared_ptr<HttpConnectionImpl<ProtocolType> > ptrNext(
+               new HttpConnectionImpl<ProtocolType>(ioService_,
+                                                    headersParsedHandler_,
+                                                    handler_,
+                                                    allowPersistentConnections_));
+      ptrNext->socket_ = std::move(socket_);
+      ptrNext->startIdleTimer();
+      ptrNext->startReading();
+   }
+
+   void startIdleTimer()
+   {
+      idleTimer_.expires_from_now(kPersistentConnectionIdleTimeout);
+      idleTimer_.async_wait(boost::bind(
+               &HttpConnectionImpl<ProtocolType>::handleIdleTimeout,
+               HttpConnectionImpl<ProtocolType>::shared_from_this(),
+               boost::asio::placeholders::error));
+   }
+
+   void handleIdleTimeout(const boost::system::error_code& ec)
+   {
+      try
+      {
+         // (cancelled once the next request starts arriving)
+         if (ec == boost::asio::error::operation_aborted)
+            return;
+
+         // leave the connection open if a request has been written to it
+         // but not yet read
+         boost::system::error_code availableEc;
+         if (socket_.available(availableEc) > 0 || availableEc)
+            return;
+
+         close();
+      }
+      CATCH_UNEXPECTED_EXCEPTION
+   }
+
    void onStreamComplete()
    {
       close();
@@ -284,13 +401,18 @@ private:
    }
 
 private:
+   boost::asio::io_service& ioService_;
    typename ProtocolType::socket socket_;
+   boost::asio::deadline_timer idleTimer_;
    boost::array<char, 8192> buffer_;
    core::http::RequestParser requestParser_;
    core::http::Request request_;
    std::string requestId_;
    HeadersParsedHandler headersParsedHandler_;
    Handler handler_;
+   bool allowPersistentConnections_;
+   bool requestComplete_;
+   bool uploadHandlerSet_;
 };
 
 } // namespace session
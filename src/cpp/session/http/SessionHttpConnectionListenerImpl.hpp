@@ -190,6 +190,13 @@ private:
 
    virtual core::Error cleanup() = 0;
 
+   // optional subclass hook: whether clients may keep connections open
+   // across requests (by sending Connection: keep-alive)
+   virtual bool allowPersistentConnections()
+   {
+      return false;
+   }
+
 private:
    boost::asio::io_service& ioService() { return acceptorService_.ioService(); }
 
@@ -205,7 +212,8 @@ private:
             boost::bind(
                  &HttpConnectionListenerImpl<ProtocolType>::enqueConnection,
                  this,
-                 _1))
+                 _1),
+            allowPersistentConnections())
       );
 
       // wait for next connection
@@ -112,6 +112,13 @@ private:
    }
 
 
+   // rserver keeps pooled connections to the session stream open across
+   // requests (it only sends keep-alive when pooling is enabled)
+   virtual bool allowPersistentConnections()
+   {
+      return true;
+   }
+
    virtual Error cleanup()
    {
       Error error = cleanupPidFile();
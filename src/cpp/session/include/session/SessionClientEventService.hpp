@@ -18,7 +18,9 @@
 
 #include <string>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <core/BoostThread.hpp>
 
@@ -34,6 +36,8 @@ namespace core {
 namespace rstudio {
 namespace session {
 
+class ClientEventPushChannel;
+
 // singleton
 class ClientEventService;
 ClientEventService& clientEventService();
@@ -41,7 +45,7 @@ ClientEventService& clientEventService();
 class ClientEventService : boost::noncopyable
 {
 private:
-   ClientEventService() {}
+   ClientEventService() : nextEventId_(0) {}
    friend ClientEventService& clientEventService();
 
 public:
@@ -54,14 +58,22 @@ public:
 
    std::string clientId();
 
+   // network port of the websocket used to push events to the client
+   // (0 if events are only available by long-polling get_events)
+   int pushChannelPort();
+
 private:
    void run();
 
    void erasePreviouslyDeliveredEvents(int lastClientEventIdSeen);
    bool havePendingClientEvents();
-   void addClientEvent(const core::json::Object& eventObject);
+   void addClientEvents(core::json::Array* pNewEvents);
    void setClientEventResult(core::json::JsonRpcResponse* pResponse);
 
+   bool pushChannelReady();
+   void pushClientEvents(bool wait,
+                         const boost::posix_time::time_duration& batchDelay,
+                         const boost::posix_time::time_duration& maxTotalBatchDelay);
   
 private:
    boost::mutex mutex_;
@@ -69,6 +81,9 @@ private:
 
    std::string clientId_;
    core::json::Array clientEvents_;
+   int nextEventId_;
+
+   boost::shared_ptr<ClientEventPushChannel> pPushChannel_;
 };
    
   
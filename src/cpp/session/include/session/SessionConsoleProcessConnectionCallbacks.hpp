@@ -38,6 +38,9 @@ struct ConsoleProcessSocketConnectionCallbacks
 
    // invoked when connection closes
    boost::function<void ()> onConnectionClosed;
+
+   // invoked when the connection fails (optional)
+   boost::function<void ()> onConnectionError;
 };
 
 } // namespace console_process
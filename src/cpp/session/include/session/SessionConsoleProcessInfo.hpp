@@ -202,6 +202,7 @@ public:
    static std::string loadConsoleProcessMetadata();
    static void deleteOrphanedLogs(bool (*validHandle)(const std::string&));
    static void saveConsoleProcesses(const std::string& metadata);
+   static void flushOutputBuffers();
    static void loadConsoleEnvironment(const std::string& handle, core::system::Options* pEnv);
 
    static AutoCloseMode closeModeFromPref(std::string prefValue);
@@ -43,13 +43,27 @@ void saveConsoleProcesses(const std::string& metadata);
 // then returns the trimmed buffer.
 std::string getSavedBuffer(const std::string& handle, int maxLines);
 
+// Get one chunkSize piece of the saved buffer for the given ConsoleProcess,
+// first trimming the buffer to maxLines if maxLines > 0. Only the part of
+// the buffer holding the chunk is read.
+std::string getSavedBufferChunk(const std::string& handle,
+                                int maxLines,
+                                int chunk,
+                                std::size_t chunkSize,
+                                bool* pMoreAvailable);
+
 // Return number of lines in the saved buffer for given ConsoleProcess;
 // buffer will be trimmed to max number of lines and rewritten.
 int getSavedBufferLineCount(const std::string& handle, int maxLines);
 
-// Add to the saved buffer for the given ConsoleProcess
+// Add to the saved buffer for the given ConsoleProcess. Output is buffered
+// in memory until flushOutputBuffers is called (reads of the saved buffer
+// include any output not yet written).
 void appendToOutputBuffer(const std::string& handle, const std::string& buffer);
 
+// Write buffered output for all ConsoleProcesses
+void flushOutputBuffers();
+
 // Delete the persisted saved buffer for the given ConsoleProcess
 void deleteLogFile(const std::string& handle, bool lastLineOnly = false);
 
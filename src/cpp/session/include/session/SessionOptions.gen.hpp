@@ -176,6 +176,15 @@ protected:
       (kWebSocketHandshakeTimeout,
       value<int>(&webSocketHandshakeTimeoutMs_)->default_value(5000),
       "Specifies the WebSocket protocol handshake timeout for session terminals in milliseconds.")
+      ("client-events-websocket",
+      value<bool>(&clientEventsWebSocket_)->default_value(false),
+      "Indicates whether or not client events should be pushed to the browser over a WebSocket (falling back to long-polling if the WebSocket can't be used).")
+      ("client-events-max-pending",
+      value<int>(&clientEventsMaxPending_)->default_value(100000),
+      "Specifies the maximum number of client events held for delivery to the browser. If more are pending (because no browser has collected them for a long time) they are discarded and the browser reloads when it next connects.")
+      ("find-in-files-index",
+      value<bool>(&findInFilesIndex_)->default_value(false),
+      "Indicates whether or not find in files should search project files in-process using a persistent trigram index (rather than running grep). The index only covers files monitored in the project, so hidden files and ignored directories (such as .Rproj.user and renv/library) are not searched.")
       (kPackageOutputInPackageFolder,
       value<bool>(&packageOutputToPackageFolder_)->default_value(false),
       "Specifies whether or not package builds output to the package project folder.")
@@ -261,6 +270,9 @@ protected:
       ("r-libs-user",
       value<std::string>(&rLibsUser_)->default_value(""),
       "Specifies the R user library path.")
+      ("r-package-info-cache",
+      value<std::string>(&rPackageInfoCache_)->default_value(""),
+      "Specifies a directory of cached R package information (used for completions) shared by all users. Sessions read from it but never write to it.")
       ("r-cran-repos",
       value<std::string>(&rCRANUrl_)->default_value(""),
       "Specifies the default CRAN repository.")
@@ -414,6 +426,9 @@ public:
    int webSocketConnectTimeout() const { return webSocketConnectTimeout_; }
    int webSocketLogLevel() const { return webSocketLogLevel_; }
    int webSocketHandshakeTimeoutMs() const { return webSocketHandshakeTimeoutMs_; }
+   bool clientEventsWebSocket() const { return clientEventsWebSocket_; }
+   int clientEventsMaxPending() const { return clientEventsMaxPending_; }
+   bool findInFilesIndex() const { return findInFilesIndex_; }
    bool packageOutputInPackageFolder() const { return packageOutputToPackageFolder_; }
    std::string rootPath() const { return rootPath_; }
    bool useSecureCookies() const { return useSecureCookies_; }
@@ -441,6 +456,7 @@ public:
    core::FilePath sessionLibraryPath() const { return core::FilePath(sessionLibraryPath_); }
    core::FilePath sessionPackageArchivesPath() const { return core::FilePath(sessionPackageArchivesPath_); }
    std::string rLibsUser() const { return rLibsUser_; }
+   std::string rPackageInfoCache() const { return rPackageInfoCache_; }
    std::string rCRANUrl() const { return rCRANUrl_; }
    std::string rCRANReposFile() const { return rCRANReposFile_; }
    std::string rCRANReposUrl() const { return rCRANReposUrl_; }
@@ -508,6 +524,9 @@ protected:
    int webSocketConnectTimeout_;
    int webSocketLogLevel_;
    int webSocketHandshakeTimeoutMs_;
+   bool clientEventsWebSocket_;
+   int clientEventsMaxPending_;
+   bool findInFilesIndex_;
    bool packageOutputToPackageFolder_;
    std::string rootPath_;
    bool useSecureCookies_;
@@ -535,6 +554,7 @@ protected:
    std::string sessionLibraryPath_;
    std::string sessionPackageArchivesPath_;
    std::string rLibsUser_;
+   std::string rPackageInfoCache_;
    std::string rCRANUrl_;
    std::string rCRANReposFile_;
    std::string rCRANReposUrl_;
@@ -23,6 +23,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include <core/BoostSignals.hpp>
+#include <core/text/Rope.hpp>
 #include <shared_core/FilePath.hpp>
 #include <shared_core/json/Json.hpp>
 
@@ -49,6 +50,17 @@ namespace core {
 namespace rstudio {
 namespace session {
 namespace source_database {
+
+// an edit to the contents of a document which has yet to be persisted
+// (the hashes are those of the document before and after the edit)
+struct ContentEdit
+{
+   std::string baseHash;
+   std::size_t offset;
+   std::size_t length;
+   std::string replacement;
+   std::string newHash;
+};
    
 class SourceDocument : boost::noncopyable
 {
@@ -61,7 +73,8 @@ public:
    const std::string& id() const { return id_; }
    const std::string& path() const { return path_; }
    const std::string& type() const { return type_; }
-   const std::string& contents() const { return contents_; }
+   const std::string& contents() const;
+   const core::text::Rope& contentsRope() const { return contents_; }
    const std::string& hash() const { return hash_; }
    const std::string& encoding() const { return encoding_; }
    bool dirty() const { return dirty_; }
@@ -80,6 +93,21 @@ public:
 
    // set contents from string
    void setContents(const std::string& contents);
+   void setContents(const core::text::Rope& contents);
+
+   // replace the bytes [offset, offset + length) of the contents (updating
+   // the hash incrementally); returns false if the range is out of bounds
+   bool replaceContents(std::size_t offset,
+                        std::size_t length,
+                        const std::string& replacement,
+                        bool* pChanged);
+
+   // edits made via replaceContents since the contents were last persisted
+   // (if the contents were instead set wholesale then contentsReplaced is
+   // true and the edits are discarded)
+   const std::vector<ContentEdit>& pendingContentEdits() const { return pendingContentEdits_; }
+   bool contentsReplaced() const { return contentsReplaced_; }
+   void setContentsPersisted();
 
    // set contents from file
    core::Error setPathAndContents(const std::string& path,
@@ -158,7 +186,9 @@ public:
       return type_.size() > 0 && type_ == kSourceDocumentTypeRSource;
    }
 
-   core::Error readFromJson(core::json::Object* pDocJson);
+   // contents are read from the json unless provided separately
+   core::Error readFromJson(core::json::Object* pDocJson,
+                            const core::text::Rope* pContents = nullptr);
    void writeToJson(core::json::Object* pDocJson, bool includeContents = true) const;
 
    core::Error writeToFile(const core::FilePath& filePath, bool writeContents = true) const;
@@ -172,7 +202,11 @@ private:
    std::string id_;
    std::string path_;
    std::string type_;
-   std::string contents_;
+   core::text::Rope contents_;
+   mutable std::string flatContents_;
+   mutable bool flatContentsValid_;
+   std::vector<ContentEdit> pendingContentEdits_;
+   bool contentsReplaced_;
    std::string hash_;
    std::string encoding_;
    std::string folds_;
@@ -196,6 +196,10 @@ public:
    // suppress file monitoring if the project already has it covered)
    bool isMonitoringDirectory(const core::FilePath& directory) const;
 
+   // does the file monitor report changes to this file or directory? (given
+   // that it reports changes within the parent directory)
+   bool isMonitoredFile(const core::FileInfo& fileInfo) const;
+
    // subscribe to file monitor notifications -- note that to ensure
    // receipt of the onMonitoringEnabled callback subscription should
    // occur during module initialization
@@ -254,6 +258,7 @@ private:
    bool isNewProject_;
 
    bool hasFileMonitor_;
+   FileMonitorFilterContext fileMonitorFilterContext_;
    std::vector<std::string> monitorSubscribers_;
    RSTUDIO_BOOST_SIGNAL<void(const tree<core::FileInfo>&)> onMonitoringEnabled_;
    RSTUDIO_BOOST_SIGNAL<void(const std::vector<core::system::FileChangeEvent>&)>
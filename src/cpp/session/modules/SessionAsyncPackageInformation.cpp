@@ -28,9 +28,14 @@
 #include <shared_core/Error.hpp>
 
 #include <boost/format.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <session/SessionModuleContext.hpp>
+#include <session/SessionOptions.hpp>
+#include <session/SessionPackageProvidedExtension.hpp>
+
+#include "SessionPackageInformationCache.hpp"
 
 #include <core/Macros.hpp>
 
@@ -45,6 +50,7 @@ using namespace core::r_util;
 bool AsyncPackageInformationProcess::s_isUpdating_ = false;
 bool AsyncPackageInformationProcess::s_updateRequested_ = false;
 std::vector<std::string> AsyncPackageInformationProcess::s_pkgsToUpdate_;
+std::map<std::string, PackageInstallation> AsyncPackageInformationProcess::s_installations_;
 
 using namespace rstudio::core;
 
@@ -140,6 +146,93 @@ bool fillFunctionInfo(const json::Object& functionObjectJson,
    
 }
 
+Error readPackageInformation(const json::Object& informationJson,
+                             PackageInformation* pInfo)
+{
+   json::Array exportsJson;
+   json::Array typesJson;
+   json::Object functionInfoJson;
+   json::Array datasetsJson;
+
+   Error error = json::readObject(informationJson,
+                                  "package", pInfo->package,
+                                  "exports", exportsJson,
+                                  "types", typesJson,
+                                  "function_info", functionInfoJson,
+                                  "datasets", datasetsJson);
+   if (error)
+      return error;
+
+   if (!exportsJson.toVectorString(pInfo->exports))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'objects' array to vector");
+
+   if (!typesJson.toVectorInt(pInfo->types))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'types' array to vector");
+
+   if (!fillFunctionInfo(functionInfoJson, pInfo->package, &(pInfo->functionInfo)))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'functions' object to map");
+
+   if (!datasetsJson.toVectorString(pInfo->datasets))
+      LOG_ERROR_MESSAGE("Failed to read JSON 'data' array to vector");
+
+   return Success();
+}
+
+PackageInformationCache& packageInformationCache()
+{
+   static PackageInformationCache instance(
+            module_context::userScratchPath().completeChildPath("package-information"),
+            FilePath(session::options().rPackageInfoCache()));
+   return instance;
+}
+
+bool isSameInstallation(const PackageInstallation& lhs,
+                        const PackageInstallation& rhs)
+{
+   return lhs.libraryPath == rhs.libraryPath &&
+          lhs.installTime == rhs.installTime;
+}
+
+// tracks the packages installed in the library paths (as indexed by the
+// package provided extension indexer) so that cached package information
+// can be invalidated when packages are installed, updated or removed
+class LibraryWorker : public ppe::Worker
+{
+public:
+   LibraryWorker() : ppe::Worker("DESCRIPTION") {}
+
+private:
+   void onIndexingStarted()
+   {
+      installed_.clear();
+   }
+
+   void onWork(const std::string& pkgName, const FilePath& resourcePath)
+   {
+      PackageInstallation installation;
+      installation.package = pkgName;
+      installation.libraryPath = resourcePath.getParent().getParent();
+      installation.installTime = resourcePath.getLastWriteTime();
+      installed_.push_back(installation);
+   }
+
+   void onIndexingCompleted(json::Object* pPayload)
+   {
+      std::vector<FilePath> libPaths = module_context::getLibPaths();
+
+      std::size_t removed = 0;
+      Error error = packageInformationCache().removeStaleEntries(
+               libPaths, installed_, &removed);
+      if (error)
+         LOG_ERROR(error);
+      DEBUG("Removed " << removed << " stale package information cache entries");
+
+      AsyncPackageInformationProcess::onPackagesIndexed(installed_);
+   }
+
+   std::vector<PackageInstallation> installed_;
+};
+
 } // anonymous namespace
 
 void AsyncPackageInformationProcess::onCompleted(int exitStatus)
@@ -176,11 +269,6 @@ void AsyncPackageInformationProcess::onCompleted(int exitStatus)
    // }
    for (std::size_t i = 0; i < n; ++i)
    {
-      json::Array exportsJson;
-      json::Array typesJson;
-      json::Object functionInfoJson;
-      json::Array datasetsJson;
-      
       core::r_util::PackageInformation pkgInfo;
 
       if (splat[i].empty())
@@ -194,7 +282,7 @@ void AsyncPackageInformationProcess::onCompleted(int exitStatus)
       std::string line = splat[i].substr(::strlen("#!json: "));
       
       json::Value value;
-      if (!value.parse(line))
+      if (value.parse(line))
       {
          std::string subset;
          if (splat[i].length() > 60)
@@ -211,13 +299,7 @@ void AsyncPackageInformationProcess::onCompleted(int exitStatus)
       if (!json::isType<json::Object>(value))
          continue;
       
-      Error error = json::readObject(value.getObject(),
-                                     "package", pkgInfo.package,
-                                     "exports", exportsJson,
-                                     "types", typesJson,
-                                     "function_info", functionInfoJson,
-                                     "datasets", datasetsJson);
-
+      Error error = readPackageInformation(value.getObject(), &pkgInfo);
       if (error)
       {
          LOG_ERROR(error);
@@ -226,20 +308,28 @@ void AsyncPackageInformationProcess::onCompleted(int exitStatus)
 
       DEBUG("Adding entry for package: '" << pkgInfo.package << "'");
 
-      if (!exportsJson.toVectorString(pkgInfo.exports))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'objects' array to vector");
-
-      if (!typesJson.toVectorInt(pkgInfo.types))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'types' array to vector");
-
-      if (!fillFunctionInfo(functionInfoJson, pkgInfo.package, &(pkgInfo.functionInfo)))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'functions' object to map");
-      
-      if (!datasetsJson.toVectorString(pkgInfo.datasets))
-         LOG_ERROR_MESSAGE("Failed to read JSON 'data' array to vector");
-      
       // Update the index
       core::r_util::RSourceIndex::addPackageInformation(pkgInfo.package, pkgInfo);
+
+      // Cache the information if it's for the installation we expected (the
+      // R process could have loaded the package from elsewhere)
+      auto it = s_installations_.find(pkgInfo.package);
+      if (it != s_installations_.end() &&
+          !it->second.libraryPath.isEmpty())
+      {
+         std::string version, library;
+         json::readObject(value.getObject(),
+                          "version", version,
+                          "library", library);
+
+         if (version == it->second.version &&
+             library == it->second.libraryPath.getAbsolutePath())
+         {
+            error = packageInformationCache().write(it->second, value.getObject());
+            if (error)
+               LOG_ERROR(error);
+         }
+      }
    }
 
 }
@@ -279,6 +369,35 @@ void AsyncPackageInformationProcess::update()
       }
    }
    
+   // Use the cached information for packages where we have it, so that
+   // only the remaining packages need to be loaded
+   std::vector<FilePath> libPaths = module_context::getLibPaths();
+   std::vector<std::string> uncached;
+   for (const std::string& pkg : s_pkgsToUpdate_)
+   {
+      PackageInstallation& installation = s_installations_[pkg];
+      installation = PackageInstallation();
+      if (!findPackageInstallation(pkg, libPaths, &installation))
+      {
+         uncached.push_back(pkg);
+         continue;
+      }
+
+      json::Object informationJson;
+      PackageInformation pkgInfo;
+      if (packageInformationCache().read(installation, &informationJson) &&
+          !readPackageInformation(informationJson, &pkgInfo))
+      {
+         DEBUG("Using cached entry for package: '" << pkg << "'");
+         RSourceIndex::addPackageInformation(pkg, pkgInfo);
+      }
+      else
+      {
+         uncached.push_back(pkg);
+      }
+   }
+   s_pkgsToUpdate_ = uncached;
+
    if (pkgs.empty())
    {
       s_isUpdating_ = false;
@@ -319,6 +438,50 @@ void AsyncPackageInformationProcess::update()
    
 }
 
+void AsyncPackageInformationProcess::onPackagesIndexed(
+      const std::vector<PackageInstallation>& installed)
+{
+   using namespace rstudio::core::r_util;
+
+   // Drop the information for packages which have been installed, updated
+   // or removed since it was read, so that it's read again
+   bool changed = false;
+   for (auto it = s_installations_.begin(); it != s_installations_.end(); )
+   {
+      // packages are indexed in library path order, so the first
+      // installation found is the one that would be loaded
+      PackageInstallation current;
+      for (const PackageInstallation& installation : installed)
+      {
+         if (installation.package == it->first)
+         {
+            current = installation;
+            break;
+         }
+      }
+
+      if (isSameInstallation(current, it->second))
+      {
+         ++it;
+         continue;
+      }
+
+      DEBUG("Package '" << it->first << "' changed; dropping its information");
+      RSourceIndex::removePackageInformation(it->first);
+      it = s_installations_.erase(it);
+      changed = true;
+   }
+
+   if (changed)
+      update();
+}
+
+Error AsyncPackageInformationProcess::initialize()
+{
+   ppe::indexer().addWorker(boost::make_shared<LibraryWorker>());
+   return Success();
+}
+
 } // end namespace r_pacakges
 } // end namespace modules
 } // end namespace session
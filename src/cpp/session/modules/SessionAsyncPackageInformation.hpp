@@ -16,9 +16,13 @@
 #ifndef SESSION_ASYNC_PACKAGE_INFORMATION_HPP
 #define SESSION_ASYNC_PACKAGE_INFORMATION_HPP
 
+#include <map>
+
 #include <core/r_util/RSourceIndex.hpp>
 #include <session/SessionAsyncRProcess.hpp>
 
+#include "SessionPackageInformationCache.hpp"
+
 namespace rstudio {
 namespace session {
 namespace modules {
@@ -28,6 +32,11 @@ class AsyncPackageInformationProcess : public async_r::AsyncRProcess
 {
 public:
    static void update();
+
+   // called when the packages in the library paths have been indexed
+   static void onPackagesIndexed(const std::vector<PackageInstallation>& installed);
+
+   static core::Error initialize();
    
    friend class CompleteUpdateOnExit;
 
@@ -51,6 +60,10 @@ private:
    static bool s_updateRequested_;
    static std::vector<std::string> s_pkgsToUpdate_;
 
+   // the installations of the packages whose information has been read
+   // (from the cache or by loading them)
+   static std::map<std::string, PackageInstallation> s_installations_;
+
    std::stringstream stdOut_;
 
 };
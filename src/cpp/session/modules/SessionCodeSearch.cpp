@@ -45,6 +45,8 @@
 #include <core/system/FileChangeEvent.hpp>
 #include <core/system/FileMonitor.hpp>
 
+#include <core/text/FileNameIndex.hpp>
+
 #include <r/RRoutines.hpp>
 #include <r/RExec.hpp>
 #include <r/RRoutines.hpp>
@@ -56,6 +58,7 @@
 #include <session/projects/SessionProjects.hpp>
 
 #include "SessionAsyncPackageInformation.hpp"
+#include "SessionFileNameIndex.hpp"
 
 #include "SessionSource.hpp"
 #include "clang/DefinitionIndex.hpp"
@@ -591,186 +594,6 @@ public:
       }
    }
    
-   template <typename T>
-   void searchFiles(const std::string& term,
-                    std::size_t maxResults,
-                    bool prefixOnly,
-                    bool sourceFilesOnly,
-                    const FilePath& parentPath,
-                    T* pNames,
-                    T* pPaths,
-                    bool* pMoreAvailable)
-   {
-      // default to no more available
-      *pMoreAvailable = false;
-
-      // create wildcard pattern if the search has a '*'
-      boost::regex pattern = regex_utils::regexIfWildcardPattern(term);
-      
-      // get the start and end iterators -- default to all leaves
-      EntryTree::leaf_iterator it = pEntries_->begin_leaf();
-      
-      DEBUG("Searching for node '" << parentPath.getAbsolutePath());
-      Entry parentEntry(core::toFileInfo(parentPath));
-      EntryTree::iterator parent = pEntries_->find(parentEntry);
-      if (parent != pEntries_->end())
-      {
-         DEBUG("Found node: '" + (*parent).fileInfo.getAbsolutePath() + "'");
-         DEBUG("Node has: '" << pEntries_->number_of_children(parent) << "' children.");
-         DEBUG("Node has: '" << pEntries_->number_of_siblings(parent) << "' siblings.");
-
-         it = parent.begin();
-      }
-      else
-      {
-         DEBUG("Failed to find node.");
-         LOG_ERROR_MESSAGE("Failed to find parent node when searching index");
-         return;
-      }
-      
-      // iterate over the files
-      for (; pEntries_->is_valid(it); ++it)
-      {
-         const Entry& entry = *it;
-         
-         DEBUG("Node: '" << (*it).fileInfo.getAbsolutePath() << "'");
-         
-         // skip if it's not a source file
-         if (sourceFilesOnly && !isSourceFile(entry.fileInfo))
-            continue;
-         
-         // get file and name
-         FilePath filePath(entry.fileInfo.absolutePath());
-         std::string name = filePath.getFilename();
-
-         // compare for match (wildcard or standard)
-         bool matches = false;
-         if (!pattern.empty())
-         {
-            matches = regex_utils::textMatches(name,
-                                               pattern,
-                                               prefixOnly,
-                                               false);
-         }
-         else
-         {
-            if (prefixOnly)
-               matches = boost::algorithm::istarts_with(name, term);
-            else
-            {
-               // We allow the user to submit queries of the form e.g.
-               // <query>:<row><column>; make sure we only take items
-               // on the query up to ':'
-               std::string::size_type queryEnd = term.find(":");
-               if (queryEnd == std::string::npos)
-                  queryEnd = term.length();
-
-               matches = string_utils::isSubsequence(name,
-                                                     term,
-                                                     queryEnd,
-                                                     true);
-            }
-         }
-
-         // add the file if we found a match
-         if (matches)
-         {
-            // name and aliased path
-            pNames->push_back(filePath.getFilename());
-            pPaths->push_back(module_context::createAliasedPath(filePath));
-
-            // return if we are past max results
-            if (enforceMaxResults(maxResults, pNames, pPaths, pMoreAvailable))
-               return;
-         }
-      }
-   }
-   
-   template <typename T>
-   void searchFolders(const std::string& term,
-                      const FilePath& parentPath,
-                      std::size_t maxResults,
-                      T* pPaths,
-                      bool* pMoreAvailable)
-   {
-      // Find the parent node in the tree
-      Entry parentEntry(core::toFileInfo(parentPath));
-      EntryTree::iterator parentItr = pEntries_->find(parentEntry);
-      if (parentItr == pEntries_->end())
-         return;
-      
-      EntryTree::iterator it = parentItr.begin();
-      EntryTree::iterator end = parentItr.end();
-      for (; it != end; ++it)
-      {
-         const FileInfo& fileInfo = (*it).fileInfo;
-         if (fileInfo.isDirectory())
-         {
-            int lastSlashIndex = gsl::narrow_cast<int>(fileInfo.absolutePath().rfind('/'));
-
-            std::string fileName =
-                  fileInfo.absolutePath().substr(lastSlashIndex + 1);
-
-            bool isSubsequence =
-                  string_utils::isSubsequence(fileName, term, true);
-
-            if (isSubsequence)
-            {
-               pPaths->push_back(fileInfo.absolutePath());
-               if (pPaths->size() >= maxResults)
-               {
-                  *pMoreAvailable = true;
-                  return;
-               }
-            }
-
-         }
-      }
-   }
-
-   template <typename T>
-   void searchFilesAndFolders(const std::string& term,
-                              const FilePath& parentPath,
-                              std::size_t maxResults,
-                              T* pPaths,
-                              bool* pMoreAvailable)
-   {
-      // Find the parent node in the tree
-      Entry parentEntry(core::toFileInfo(parentPath));
-      EntryTree::iterator parentItr = pEntries_->find(parentEntry);
-      if (parentItr == pEntries_->end())
-         return;
-
-      EntryTree::iterator it = parentItr.begin();
-      EntryTree::iterator end = parentItr.end();
-      for (; it != end; ++it)
-      {
-         const FileInfo& fileInfo = (*it).fileInfo;
-
-         // Avoid dummy nodes
-         if (fileInfo.empty())
-            continue;
-
-         int lastSlashIndex = gsl::narrow_cast<int>(fileInfo.absolutePath().rfind('/'));
-
-         std::string fileName =
-               fileInfo.absolutePath().substr(lastSlashIndex + 1);
-
-         bool isSubsequence =
-               string_utils::isSubsequence(fileName, term, true);
-
-         if (isSubsequence)
-         {
-            pPaths->push_back(fileInfo.absolutePath());
-            if (pPaths->size() >= maxResults)
-            {
-               *pMoreAvailable = true;
-               return;
-            }
-         }
-      }
-   }
-   
    void walkFiles(const FilePath& parentPath,
                   boost::function<void(const Entry&)> operation,
                   boost::function<bool(const Entry&)> filter = boost::function<bool(const Entry&)>())
@@ -899,43 +722,6 @@ private:
       }
    }
 
-   static bool isSourceFile(const FileInfo& fileInfo)
-   {
-      FilePath filePath(fileInfo.absolutePath());
-
-      // screen directories
-      if (!module_context::isUserFile(filePath))
-         return false;
-
-      // filter files by name and extension
-      std::string ext = filePath.getExtensionLowerCase();
-      std::string filename = filePath.getFilename();
-      return !filePath.isDirectory() &&
-              (ext == ".r" || ext == ".rnw" || ext == ".rtex" ||
-               ext == ".rmd" || ext == ".rmarkdown" ||
-               ext == ".rhtml" || ext == ".rd" ||
-               ext == ".h" || ext == ".hpp" ||
-               ext == ".c" || ext == ".cpp" ||
-               ext == ".json" || ext == ".tex" ||
-               ext == ".toml" || ext == ".scala" ||
-               ext == ".css" || ext == ".scss" || ext == ".sass" ||
-               filename == "DESCRIPTION" ||
-               filename == "NAMESPACE" ||
-               filename == "README" ||
-               filename == "NEWS" ||
-               filename == "Makefile" ||
-               filename == "configure" ||
-               filename == "configure.win" ||
-               filename == "cleanup" ||
-               filename == "cleanup.win" ||
-               filename == "Makevars" ||
-               filename == "Makevars.win" ||
-               filename == "LICENSE" ||
-               filename == "LICENCE" ||
-               filename == "CITATION" ||
-               filePath.hasTextMimeType());
-   }
-
    static bool isIndexableSourceFile(const FileInfo& fileInfo)
    {
       FilePath filePath(fileInfo.absolutePath());
@@ -1253,6 +1039,93 @@ void searchSourceDatabaseFiles(const std::string& term,
    }
 }
 
+bool isSourceFile(const std::string& path, bool isDirectory)
+{
+   if (isDirectory)
+      return false;
+
+   FilePath filePath(path);
+
+   // screen directories
+   if (!module_context::isUserFile(filePath))
+      return false;
+
+   // filter files by name and extension
+   std::string ext = filePath.getExtensionLowerCase();
+   std::string filename = filePath.getFilename();
+   return ext == ".r" || ext == ".rnw" || ext == ".rtex" ||
+          ext == ".rmd" || ext == ".rmarkdown" ||
+          ext == ".rhtml" || ext == ".rd" ||
+          ext == ".h" || ext == ".hpp" ||
+          ext == ".c" || ext == ".cpp" ||
+          ext == ".json" || ext == ".tex" ||
+          ext == ".toml" || ext == ".scala" ||
+          ext == ".css" || ext == ".scss" || ext == ".sass" ||
+          filename == "DESCRIPTION" ||
+          filename == "NAMESPACE" ||
+          filename == "README" ||
+          filename == "NEWS" ||
+          filename == "Makefile" ||
+          filename == "configure" ||
+          filename == "configure.win" ||
+          filename == "cleanup" ||
+          filename == "cleanup.win" ||
+          filename == "Makevars" ||
+          filename == "Makevars.win" ||
+          filename == "LICENSE" ||
+          filename == "LICENCE" ||
+          filename == "CITATION" ||
+          filePath.hasTextMimeType();
+}
+
+bool wildcardFilter(const boost::regex& pattern,
+                    const text::FileNameIndex::Filter& filter,
+                    const std::string& path,
+                    bool isDirectory)
+{
+   if (filter && !filter(path, isDirectory))
+      return false;
+
+   std::string name = path.substr(path.rfind('/') + 1);
+   return regex_utils::textMatches(name, pattern, false, false);
+}
+
+// search the project's file name index; wildcard patterns (those with a '*')
+// are matched against every name, and otherwise the term is matched as a
+// subsequence, with the best matches returned first
+void searchIndexedFiles(const std::string& term,
+                        const FilePath& parentPath,
+                        int types,
+                        std::size_t maxResults,
+                        const text::FileNameIndex::Filter& filter,
+                        std::vector<text::FileNameIndex::Match>* pMatches,
+                        bool* pMoreAvailable)
+{
+   boost::regex pattern = regex_utils::regexIfWildcardPattern(term);
+   if (!pattern.empty())
+   {
+      file_name_index::search(std::string(),
+                              parentPath,
+                              types,
+                              false,
+                              maxResults,
+                              boost::bind(wildcardFilter, pattern, filter, _1, _2),
+                              pMatches,
+                              pMoreAvailable);
+   }
+   else
+   {
+      file_name_index::search(term,
+                              parentPath,
+                              types,
+                              false,
+                              maxResults,
+                              filter,
+                              pMatches,
+                              pMoreAvailable);
+   }
+}
+
 template <typename T>
 void searchFiles(const std::string& term,
                  std::size_t maxResults,
@@ -1261,17 +1134,36 @@ void searchFiles(const std::string& term,
                  T* pPaths,
                  bool* pMoreAvailable)
 {
-   // if we have a file monitor then search the project index
-   if (session::projects::projectContext().hasFileMonitor())
-   {
-      projectIndex().searchFiles(term,
-                                 maxResults,
-                                 false,
-                                 sourceFilesOnly,
-                                 projects::projectContext().directory(),
-                                 pNames,
-                                 pPaths,
-                                 pMoreAvailable);
+   // if the project's files are indexed then search the index
+   FilePath projectDir = projects::projectContext().directory();
+   if (session::projects::projectContext().hasFileMonitor() &&
+       file_name_index::isAvailable(projectDir))
+   {
+      // We allow the user to submit queries of the form e.g.
+      // <query>:<row><column>; make sure we only take items
+      // on the query up to ':'
+      std::string query = term.substr(0, term.find(':'));
+
+      text::FileNameIndex::Filter filter;
+      if (sourceFilesOnly)
+         filter = isSourceFile;
+
+      std::vector<text::FileNameIndex::Match> matches;
+      searchIndexedFiles(query,
+                         projectDir,
+                         text::FileNameIndex::Files,
+                         maxResults,
+                         filter,
+                         &matches,
+                         pMoreAvailable);
+
+      for (const text::FileNameIndex::Match& match : matches)
+      {
+         // name and aliased path
+         FilePath filePath(match.path);
+         pNames->push_back(filePath.getFilename());
+         pPaths->push_back(module_context::createAliasedPath(filePath));
+      }
    }
    else
    {
@@ -1283,63 +1175,7 @@ void searchFiles(const std::string& term,
    }
 }
 
-// NOTE: When modifying this code, you should ensure that corresponding
-// changes are made to the client side scoreMatch function as well
-// (See: CodeSearchOracle.java)
-int scoreMatch(std::string const& suggestion,
-               std::string const& query,
-               bool isFile)
-{
-   // No penalty for perfect matches
-   if (suggestion == query)
-      return 0;
-   
-   std::vector<int> matches =
-         string_utils::subsequenceIndices(suggestion, query);
-   
-   int totalPenalty = 0;
-
-   // Loop over the matches and assign a score
-   for (int j = 0, n = gsl::narrow_cast<int>(matches.size()); j < n; j++)
-   {
-      int matchPos = matches[j];
-      int penalty = matchPos;
-
-      // Less penalty if character follows special delim
-      if (matchPos >= 1)
-      {
-         char prevChar = suggestion[matchPos - 1];
-         if (prevChar == '_' || prevChar == '-' || (!isFile && prevChar == '.'))
-         {
-            penalty = j + 1;
-         }
-      }
-
-      // Less penalty for perfect match (ie, reward case-sensitive match)
-      penalty -= suggestion[matchPos] == query[j];
-      
-      // More penalty for 'uninteresting' files
-      if (suggestion == "RcppExports.R" ||
-          suggestion == "RcppExports.cpp")
-         penalty += 6;
-      
-      // More penalty for 'uninteresting' extensions (e.g. .Rd)
-      std::string extension = string_utils::getExtension(suggestion);
-      if (boost::algorithm::to_lower_copy(extension) == ".rd")
-         penalty += 6;
-
-      totalPenalty += penalty;
-   }
-   
-   // Penalize files
-   if (isFile)
-      ++totalPenalty;
-   
-   // Penalize unmatched characters
-   totalPenalty += gsl::narrow_cast<int>((query.size() - matches.size()) * query.size());
-
-   return totalPenalty;
-}
+using core::text::scoreMatch;
 
 struct ScorePairComparator
 {
@@ -2495,88 +2331,68 @@ inline SEXP pathResultsSEXP(std::vector<std::string> const& paths,
    return r::sexp::create(builder, &protect);
 }
 
-SEXP rs_listIndexedFiles(SEXP termSEXP, SEXP absolutePathSEXP, SEXP maxResultsSEXP)
+SEXP listIndexedPaths(SEXP termSEXP,
+                      SEXP absolutePathSEXP,
+                      SEXP maxResultsSEXP,
+                      int types)
 {
    std::string term = r::sexp::asString(termSEXP);
    std::string absolutePath = r::sexp::asString(absolutePathSEXP);
    int maxResults = r::sexp::asInteger(maxResultsSEXP);
-   
+
    FilePath filePath(absolutePath);
-   
-   std::vector<std::string> names;
-   std::vector<std::string> paths;
-   bool moreAvailable = false;
-   
+
    // Bail if the file doesn't exist
    if (!filePath.exists())
       return R_NilValue;
-   
-   // Bail if it's not a monitored path
-   if (!projects::projectContext().isMonitoringDirectory(filePath))
+
+   // Bail if it's not an indexed (monitored) path
+   if (!file_name_index::isAvailable(filePath))
       return R_NilValue;
-   
-   projectIndex().searchFiles(term,
-                              maxResults,
-                              false,
-                              false,
-                              filePath,
-                              &names,
-                              &paths,
-                              &moreAvailable);
+
+   std::vector<text::FileNameIndex::Match> matches;
+   bool moreAvailable = false;
+   searchIndexedFiles(term,
+                      filePath,
+                      types,
+                      safe_convert::numberTo<int, std::size_t>(maxResults, 0),
+                      text::FileNameIndex::Filter(),
+                      &matches,
+                      &moreAvailable);
+
+   std::vector<std::string> paths;
+   for (const text::FileNameIndex::Match& match : matches)
+      paths.push_back(match.path);
 
    return pathResultsSEXP(paths, moreAvailable);
 }
 
+SEXP rs_listIndexedFiles(SEXP termSEXP, SEXP absolutePathSEXP, SEXP maxResultsSEXP)
+{
+   return listIndexedPaths(termSEXP,
+                           absolutePathSEXP,
+                           maxResultsSEXP,
+                           text::FileNameIndex::Files);
+}
+
 SEXP rs_listIndexedFolders(SEXP termSEXP,
                            SEXP absolutePathSEXP,
                            SEXP maxResultsSEXP)
 {
-   std::string term = r::sexp::asString(termSEXP);
-   std::string absolutePath = r::sexp::asString(absolutePathSEXP);
-   int maxResults = r::sexp::asInteger(maxResultsSEXP);
-   
-   FilePath filePath(absolutePath);
-   if (!filePath.exists())
-      return R_NilValue;
-   
-   if (!projects::projectContext().isMonitoringDirectory(filePath))
-      return R_NilValue;
-   
-   std::vector<std::string> paths;
-   bool moreAvailable = false;
-   projectIndex().searchFolders(term,
-                                filePath,
-                                maxResults,
-                                &paths,
-                                &moreAvailable);
-
-   return pathResultsSEXP(paths, moreAvailable);
+   return listIndexedPaths(termSEXP,
+                           absolutePathSEXP,
+                           maxResultsSEXP,
+                           text::FileNameIndex::Directories);
 }
 
 SEXP rs_listIndexedFilesAndFolders(SEXP termSEXP,
                                    SEXP absolutePathSEXP,
                                    SEXP maxResultsSEXP)
 {
-   std::string term = r::sexp::asString(termSEXP);
-   std::string absolutePath = r::sexp::asString(absolutePathSEXP);
-   int maxResults = r::sexp::asInteger(maxResultsSEXP);
-
-   FilePath filePath(absolutePath);
-   if (!filePath.exists())
-      return R_NilValue;
-
-   if (!projects::projectContext().isMonitoringDirectory(filePath))
-      return R_NilValue;
-
-   std::vector<std::string> paths;
-   bool moreAvailable = false;
-   projectIndex().searchFilesAndFolders(term,
-                                        filePath,
-                                        maxResults,
-                                        &paths,
-                                        &moreAvailable);
-
-   return pathResultsSEXP(paths, moreAvailable);
+   return listIndexedPaths(termSEXP,
+                           absolutePathSEXP,
+                           maxResultsSEXP,
+                           text::FileNameIndex::All);
 }
 
 SEXP rs_viewFunction(SEXP functionSEXP, SEXP nameSEXP, SEXP namespaceSEXP) 
@@ -595,29 +595,28 @@ void applyOptions(const FileLocalLintOptions& fileOptions,
    }
 }
 
-#define kLintComment L"(?:^|\\n)#+\\s+\\!diagnostics"
+#define kLintComment "(?:^|\\n)#+\\s+\\!diagnostics"
 
-void setFileLocalParseOptions(const std::wstring& rCode,
+void setFileLocalParseOptions(const std::string& rCode,
                               ParseOptions* pOptions,
                               bool* pNoLint)
 {
    using namespace string_utils;
    
    // Extract all of the lint commands.
-   boost::wregex reLintComments(kLintComment);
+   boost::regex reLintComments(kLintComment);
    std::vector<std::string> lintCommands;
-   boost::wsmatch match;
+   boost::smatch match;
    
-   std::wstring::const_iterator start = rCode.begin();
-   std::wstring::const_iterator end = rCode.end();
+   std::string::const_iterator start = rCode.begin();
+   std::string::const_iterator end = rCode.end();
    while (regex_utils::search(start, end, match, reLintComments))
    {
-      std::wstring::const_iterator matchBegin = match[0].second;
-      std::wstring::const_iterator matchEnd   = std::find(matchBegin, end, L'\n');
+      std::string::const_iterator matchBegin = match[0].second;
+      std::string::const_iterator matchEnd   = std::find(matchBegin, end, '\n');
       
       std::string command = string_utils::trimWhitespace(
-               string_utils::wideToUtf8(
-                  std::wstring(matchBegin, matchEnd)));
+               std::string(matchBegin, matchEnd));
       
       if (command == "off")
       {
@@ -635,7 +634,7 @@ void setFileLocalParseOptions(const std::wstring& rCode,
 
 } // end anonymous namespace
 
-ParseResults parse(const std::wstring& rCode,
+ParseResults parse(const std::string& rCode,
                    const FilePath& origin,
                    const std::string& documentId = std::string(),
                    bool isExplicit = false)
@@ -666,16 +665,16 @@ ParseResults parse(const std::wstring& rCode,
    if (noLint)
       return ParseResults();
    
-   results = rparser::parse(origin, rCode, options);
+   results = rparser::parse(origin, rCode, options, documentId);
    
    ParseNode* pRoot = results.parseTree();
    if (!pRoot)
    {
       std::string codeSnippet;
       if (rCode.length() > 40)
-         codeSnippet = string_utils::wideToUtf8(rCode.substr(0, 40)) + "...";
+         codeSnippet = rCode.substr(0, 40) + "...";
       else
-         codeSnippet = string_utils::wideToUtf8(rCode);
+         codeSnippet = rCode;
       
       std::string message = std::string() +
             "Parse failed: no parse tree available for code " +
@@ -694,13 +693,6 @@ ParseResults parse(const std::wstring& rCode,
    return results;
 }
 
-ParseResults parse(const std::string& rCode,
-                   const FilePath& origin,
-                   const std::string& documentId)
-{
-   return parse(string_utils::utf8ToWide(rCode), origin, documentId);
-}
-
 namespace {
 
 json::Array lintAsJson(const LintItems& items)
@@ -817,7 +809,7 @@ Error lintRSourceDocument(const json::JsonRpcRequest& request,
       return error;
    
    ParseResults results = diagnostics::parse(
-            string_utils::utf8ToWide(content),
+            content,
             origin,
             documentId,
             isExplicit);
@@ -993,7 +985,7 @@ bool collectLint(int depth,
    }
    
    ParseResults results = diagnostics::parse(
-            string_utils::utf8ToWide(contents),
+            contents,
             path,
             std::string(),
             true);
@@ -0,0 +1,177 @@
+/*
+ * SessionFileNameIndex.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionFileNameIndex.hpp"
+
+#include <boost/bind.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#include <core/collection/Tree.hpp>
+#include <core/system/FileChangeEvent.hpp>
+
+#include <session/projects/SessionProjects.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace file_name_index {
+
+namespace {
+
+class ProjectFileNameIndex : boost::noncopyable
+{
+public:
+   ProjectFileNameIndex()
+      : enabled_(false)
+   {
+   }
+
+   bool isEnabled() const
+   {
+      return enabled_;
+   }
+
+   void search(const std::string& query,
+               const FilePath& directory,
+               int types,
+               bool matchRelativePath,
+               std::size_t maxResults,
+               const text::FileNameIndex::Filter& filter,
+               std::vector<text::FileNameIndex::Match>* pMatches,
+               bool* pMoreAvailable) const
+   {
+      index_.search(query,
+                    directory.getAbsolutePath(),
+                    types,
+                    matchRelativePath,
+                    maxResults,
+                    filter,
+                    pMatches,
+                    pMoreAvailable);
+   }
+
+   void onMonitoringEnabled(const tree<FileInfo>& files)
+   {
+      // adding names needs no file system access, so the whole tree is
+      // indexed right away
+      index_.clear();
+      for (auto it = files.begin(); it != files.end(); ++it)
+         index_.add(it->absolutePath(), it->isDirectory());
+
+      enabled_ = true;
+   }
+
+   void onFilesChanged(const std::vector<core::system::FileChangeEvent>& events)
+   {
+      using namespace core::system;
+
+      for (const FileChangeEvent& event : events)
+      {
+         const FileInfo& fileInfo = event.fileInfo();
+         switch (event.type())
+         {
+         case FileChangeEvent::FileAdded:
+            index_.add(fileInfo.absolutePath(), fileInfo.isDirectory());
+            break;
+
+         case FileChangeEvent::FileRemoved:
+            index_.remove(fileInfo.absolutePath());
+            break;
+
+         default:
+            break;
+         }
+      }
+   }
+
+   void onMonitoringDisabled()
+   {
+      // clear the index so we don't ever return stale results
+      enabled_ = false;
+      index_.clear();
+   }
+
+private:
+   text::FileNameIndex index_;
+   bool enabled_;
+};
+
+ProjectFileNameIndex& fileNameIndex()
+{
+   static ProjectFileNameIndex instance;
+   return instance;
+}
+
+} // anonymous namespace
+
+bool isAvailable(const FilePath& directory)
+{
+   const projects::ProjectContext& context = projects::projectContext();
+   if (!fileNameIndex().isEnabled() || !context.isMonitoringDirectory(directory))
+      return false;
+
+   // the file monitor doesn't look within the directories it filters out
+   // (hidden directories, renv/library, etc.), so nothing in them is indexed
+   for (FilePath dir = directory;
+        dir != context.directory() && dir.isWithin(context.directory());
+        dir = dir.getParent())
+   {
+      if (!context.isMonitoredFile(FileInfo(dir.getAbsolutePath(), true)))
+         return false;
+   }
+
+   return true;
+}
+
+void search(const std::string& query,
+            const FilePath& directory,
+            int types,
+            bool matchRelativePath,
+            std::size_t maxResults,
+            const text::FileNameIndex::Filter& filter,
+            std::vector<text::FileNameIndex::Match>* pMatches,
+            bool* pMoreAvailable)
+{
+   fileNameIndex().search(query,
+                          directory,
+                          types,
+                          matchRelativePath,
+                          maxResults,
+                          filter,
+                          pMatches,
+                          pMoreAvailable);
+}
+
+Error initialize()
+{
+   // subscribe to project context file monitoring state changes
+   // (note that if there is no project this will no-op)
+   session::projects::FileMonitorCallbacks cb;
+   cb.onMonitoringEnabled = boost::bind(&ProjectFileNameIndex::onMonitoringEnabled, &fileNameIndex(), _1);
+   cb.onFilesChanged = boost::bind(&ProjectFileNameIndex::onFilesChanged, &fileNameIndex(), _1);
+   cb.onMonitoringDisabled = boost::bind(&ProjectFileNameIndex::onMonitoringDisabled, &fileNameIndex());
+   projects::projectContext().subscribeToFileMonitor("File name indexing", cb);
+
+   return Success();
+}
+
+} // namespace file_name_index
+} // namespace modules
+} // namespace session
+} // namespace rstudio
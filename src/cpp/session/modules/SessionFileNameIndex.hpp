@@ -0,0 +1,62 @@
+/*
+ * SessionFileNameIndex.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_FILE_NAME_INDEX_HPP
+#define SESSION_FILE_NAME_INDEX_HPP
+
+#include <string>
+#include <vector>
+
+#include <core/text/FileNameIndex.hpp>
+
+namespace rstudio {
+namespace core {
+   class Error;
+   class FilePath;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace file_name_index {
+
+// Index of the names of the files and folders within the project, kept
+// current using the project's file monitor. Used for file path completion,
+// the go to file finder and the other places file names are matched.
+
+// is the index up to date for files within this directory? (it isn't for
+// directories the project's file monitor filters out, such as hidden ones)
+bool isAvailable(const core::FilePath& directory);
+
+// the best matches for query among the entries within directory (see
+// core::text::FileNameIndex::search)
+void search(const std::string& query,
+            const core::FilePath& directory,
+            int types,
+            bool matchRelativePath,
+            std::size_t maxResults,
+            const core::text::FileNameIndex::Filter& filter,
+            std::vector<core::text::FileNameIndex::Match>* pMatches,
+            bool* pMoreAvailable);
+
+core::Error initialize();
+
+} // namespace file_name_index
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_FILE_NAME_INDEX_HPP
@@ -14,6 +14,7 @@
  */
 
 #include "SessionFind.hpp"
+#include "SessionFindIndex.hpp"
 
 #include <algorithm>
 #include <gsl/gsl>
@@ -28,10 +29,13 @@
 #include <core/system/Environment.hpp>
 #include <core/system/Process.hpp>
 #include <core/system/ShellUtils.hpp>
+#include <core/text/ParallelGrep.hpp>
+#include <core/text/TrigramIndex.hpp>
 
 #include <r/RUtil.hpp>
 
 #include <session/SessionModuleContext.hpp>
+#include <session/SessionOptions.hpp>
 #include <session/projects/SessionProjects.hpp>
 
 #include <session/prefs/UserPrefs.hpp>
@@ -426,6 +430,23 @@ public:
       return callbacks;
    }
 
+   // entry points for searches which run in-process rather than in a child
+   // process; output is expected in the same format that grep produces
+   bool isActive() const
+   {
+      return findResults().isRunning() && findResults().handle() == handle();
+   }
+
+   void onSearchOutput(const std::string& data)
+   {
+      processOutput(data);
+   }
+
+   void onSearchCompleted()
+   {
+      onExit(0);
+   }
+
 private:
    struct LineInfo
    {
@@ -438,7 +459,7 @@ private:
 
    bool onContinue(const core::system::ProcessOperations& /*ops*/) const
    {
-      return findResults().isRunning() && findResults().handle() == handle();
+      return isActive();
    }
 
    void addReplaceErrorMessage(const std::string& contents,
@@ -922,6 +943,11 @@ private:
    }
 
    void onStdout(const core::system::ProcessOperations& /*ops*/, const std::string& data)
+   {
+      processOutput(data);
+   }
+
+   void processOutput(const std::string& data)
    {
       json::Array files;
       json::Array lineNums;
@@ -1337,6 +1363,195 @@ void addDirectoriesToCommand(
    }
 }
 
+namespace {
+
+// Drives a search run in-process by ParallelGrep: results are polled for
+// on the main thread, formatted as grep would output them and handed to the
+// GrepOperation, so they (and any replace) are processed exactly as the
+// output of a grep search would be
+class IndexedSearch : boost::noncopyable
+{
+public:
+   static void start(boost::shared_ptr<GrepOperation> ptrGrepOp,
+                     boost::shared_ptr<text::ParallelGrep> pGrep)
+   {
+      boost::shared_ptr<IndexedSearch> pSearch(new IndexedSearch(ptrGrepOp, pGrep));
+      module_context::schedulePeriodicWork(
+               boost::posix_time::milliseconds(25),
+               boost::bind(&IndexedSearch::poll, pSearch),
+               false /* poll even when non-idle */);
+   }
+
+private:
+   IndexedSearch(boost::shared_ptr<GrepOperation> ptrGrepOp,
+                 boost::shared_ptr<text::ParallelGrep> pGrep)
+      : ptrGrepOp_(ptrGrepOp), pGrep_(pGrep)
+   {
+   }
+
+   bool poll()
+   {
+      // stopped by the user, superseded by another search or the maximum
+      // number of results has been reached
+      if (!ptrGrepOp_->isActive())
+      {
+         pGrep_.reset();
+         ptrGrepOp_->onSearchCompleted();
+         return false;
+      }
+
+      std::vector<text::GrepFileResult> results;
+      bool more = pGrep_->collect(&results);
+      if (!results.empty())
+         ptrGrepOp_->onSearchOutput(asGrepOutput(results));
+
+      if (!more)
+      {
+         ptrGrepOp_->onSearchCompleted();
+         return false;
+      }
+
+      return true;
+   }
+
+   static std::string asGrepOutput(const std::vector<text::GrepFileResult>& results)
+   {
+      // matches are highlighted the way grep highlights them given the
+      // GREP_COLORS used by runGrepOperation
+      std::string output;
+      for (const text::GrepFileResult& result : results)
+      {
+         std::string path = string_utils::utf8ToSystem(result.path);
+         for (const text::GrepLine& line : result.lines)
+         {
+            output.append(path);
+            output.push_back(':');
+            output.append(safe_convert::numberToString(line.lineNumber));
+            output.push_back(':');
+
+            std::size_t pos = 0;
+            for (const auto& match : line.matches)
+            {
+               output.append(line.text, pos, match.first - pos);
+               output.append("\x1B[01m");
+               output.append(line.text, match.first, match.second - match.first);
+               output.append("\x1B[m");
+               pos = match.second;
+            }
+            output.append(line.text, pos, std::string::npos);
+            output.push_back('\n');
+         }
+      }
+      return output;
+   }
+
+   boost::shared_ptr<GrepOperation> ptrGrepOp_;
+   boost::shared_ptr<text::ParallelGrep> pGrep_;
+};
+
+bool wildcardPatterns(const std::vector<std::string>& args,
+                      std::vector<boost::regex>* pPatterns)
+{
+   for (const std::string& arg : args)
+   {
+      // only '*' wildcards are supported
+      std::string pattern = arg.substr(arg.find('=') + 1);
+      if (pattern.find_first_of("?[]{}\\") != std::string::npos)
+         return false;
+      pPatterns->push_back(regex_utils::wildcardPatternToRegex(pattern));
+   }
+   return true;
+}
+
+bool matchesAny(const std::string& filename, const std::vector<boost::regex>& patterns)
+{
+   for (const boost::regex& pattern : patterns)
+   {
+      if (regex_utils::match(filename, pattern))
+         return true;
+   }
+   return false;
+}
+
+// Start an in-process search of the files within dirPath, using the find
+// index to skip files which can't contain a match. Returns an empty pointer
+// if the search can't be done in-process (in which case grep is used).
+boost::shared_ptr<text::ParallelGrep> startIndexedSearch(const GrepOptions& grepOptions,
+                                                         const std::string& encodedPattern,
+                                                         const FilePath& dirPath)
+{
+   boost::shared_ptr<text::ParallelGrep> pGrep;
+
+   // git grep excludes files ignored by git (which the index doesn't know
+   // about); multiple patterns and complex file globs are left to grep too
+   if (grepOptions.gitFlag() ||
+       encodedPattern.find('\n') != std::string::npos ||
+       !index::isAvailable(dirPath))
+   {
+      return pGrep;
+   }
+
+   std::vector<boost::regex> includePatterns, excludePatterns;
+   if (!wildcardPatterns(grepOptions.includeArgs(), &includePatterns) ||
+       !wildcardPatterns(grepOptions.excludeArgs(), &excludePatterns))
+   {
+      return pGrep;
+   }
+
+   std::vector<FilePath> searchDirs;
+   if (grepOptions.packageSourceFlag())
+   {
+      searchDirs.push_back(dirPath.completeChildPath("R"));
+      searchDirs.push_back(dirPath.completeChildPath("src"));
+   }
+   else if (grepOptions.packageTestsFlag())
+   {
+      searchDirs.push_back(dirPath.completeChildPath("tests"));
+   }
+   else
+   {
+      searchDirs.push_back(dirPath);
+   }
+
+   std::string literal = grepOptions.asRegex() ?
+            text::requiredLiteral(encodedPattern) :
+            encodedPattern;
+
+   std::vector<std::string> candidates;
+   for (const FilePath& searchDir : searchDirs)
+      index::candidateFiles(searchDir, literal, grepOptions.ignoreCase(), &candidates);
+
+   std::vector<std::string> files;
+   files.reserve(candidates.size());
+   for (const std::string& candidate : candidates)
+   {
+      std::string filename = FilePath(candidate).getFilename();
+      if (!includePatterns.empty() && !matchesAny(filename, includePatterns))
+         continue;
+      if (matchesAny(filename, excludePatterns))
+         continue;
+      files.push_back(candidate);
+   }
+
+   std::size_t threads = std::min(std::max(boost::thread::hardware_concurrency(), 1u), 8u);
+   Error error = text::ParallelGrep::create(encodedPattern,
+                                            grepOptions.asRegex(),
+                                            grepOptions.ignoreCase(),
+                                            files,
+                                            threads,
+                                            &pGrep);
+   if (error)
+   {
+      // grep may still accept the pattern (and will report its own errors)
+      LOG_DEBUG_MESSAGE("Falling back to grep: " + error.getSummary());
+      pGrep.reset();
+   }
+
+   return pGrep;
+}
+
+} // anonymous namespace
+
 core::Error runGrepOperation(const GrepOptions& grepOptions, const ReplaceOptions& replaceOptions,
    LocalProgress* pProgress, json::JsonRpcResponse* pResponse)
 {
@@ -1452,14 +1667,27 @@ core::Error runGrepOperation(const GrepOptions& grepOptions, const ReplaceOption
          grepOptions.packageSourceFlag(), grepOptions.packageTestsFlag(), dirPath, &cmd);
    }
 
+   // search project files in-process when the find index covers them (opt-in,
+   // since the index skips hidden files and ignored directories)
+   boost::shared_ptr<text::ParallelGrep> pIndexedGrep;
+   if (session::options().findInFilesIndex())
+      pIndexedGrep = startIndexedSearch(grepOptions, encodedString, dirPath);
+
    // Clear existing results
    findResults().clear();
 
-   error = module_context::processSupervisor().runCommand(cmd,
-                                                          options,
-                                                          callbacks);
-   if (error)
-      return error;
+   if (pIndexedGrep)
+   {
+      IndexedSearch::start(ptrGrepOp, pIndexedGrep);
+   }
+   else
+   {
+      error = module_context::processSupervisor().runCommand(cmd,
+                                                             options,
+                                                             callbacks);
+      if (error)
+         return error;
+   }
 
    findResults().onFindBegin(ptrGrepOp->handle(),
                              grepOptions.searchPattern(),
@@ -1644,7 +1872,8 @@ core::Error initialize()
       (bind(registerRpcMethod, "clear_find_results", clearFindResults))
       (bind(registerRpcMethod, "preview_replace", previewReplace))
       (bind(registerRpcMethod, "complete_replace", completeReplace))
-      (bind(registerRpcMethod, "stop_replace", stopReplace));
+      (bind(registerRpcMethod, "stop_replace", stopReplace))
+      (index::initialize);
    return initBlock.execute();
 }
 
@@ -0,0 +1,349 @@
+/*
+ * SessionFindIndex.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionFindIndex.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/bind.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/collection/Tree.hpp>
+#include <core/system/FileChangeEvent.hpp>
+#include <core/text/TrigramIndex.hpp>
+
+#include <session/SessionModuleContext.hpp>
+#include <session/SessionOptions.hpp>
+#include <session/projects/SessionProjects.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace find {
+namespace index {
+
+namespace {
+
+// larger files are still searched, but their contents aren't indexed
+const uintmax_t kMaxIndexedFileSize = 4 * 1024 * 1024;
+
+class FindIndex : boost::noncopyable
+{
+public:
+   FindIndex()
+      : enabled_(false), indexing_(false), ready_(false), dirty_(false)
+   {
+   }
+
+   bool isAvailable() const
+   {
+      return enabled_ && ready_;
+   }
+
+   void candidateFiles(const FilePath& directory,
+                       const std::string& literal,
+                       bool ignoreCase,
+                       std::vector<std::string>* pPaths) const
+   {
+      std::vector<std::string> candidates;
+      index_.candidates(literal, ignoreCase, &candidates);
+
+      // files with changes waiting to be indexed can't be ruled out
+      for (const auto& pending : pendingPaths_)
+         candidates.push_back(pending.first);
+
+      std::string prefix = directory.getAbsolutePath();
+      if (prefix.empty() || prefix.back() != '/')
+         prefix.push_back('/');
+
+      for (const std::string& path : candidates)
+      {
+         if (path.compare(0, prefix.size(), prefix) == 0)
+            pPaths->push_back(path);
+      }
+
+      std::sort(pPaths->begin(), pPaths->end());
+      pPaths->erase(std::unique(pPaths->begin(), pPaths->end()), pPaths->end());
+   }
+
+   void onMonitoringEnabled(const tree<FileInfo>& files)
+   {
+      using namespace core::system;
+
+      enabled_ = true;
+      ready_ = false;
+
+      // start from the index saved by a previous session (if any) so that
+      // only files which have changed since then need to be read
+      Error error = index_.readFromFile(indexFilePath());
+      if (error && !isPathNotFoundError(error))
+         LOG_ERROR(error);
+
+      std::unordered_set<std::string> paths;
+      for (auto it = files.begin_leaf(); it != files.end_leaf(); ++it)
+      {
+         const FileInfo& fileInfo = *it;
+         if (fileInfo.isDirectory())
+            continue;
+
+         paths.insert(fileInfo.absolutePath());
+         if (!index_.isCurrent(fileInfo.absolutePath(),
+                               fileInfo.lastWriteTime(),
+                               fileInfo.size()))
+         {
+            enque(FileChangeEvent(FileChangeEvent::FileAdded, fileInfo));
+         }
+      }
+
+      // drop files which were removed while the session wasn't running
+      std::vector<std::string> indexedPaths;
+      index_.paths(&indexedPaths);
+      for (const std::string& path : indexedPaths)
+      {
+         if (!paths.count(path))
+         {
+            index_.remove(path);
+            dirty_ = true;
+         }
+      }
+
+      scheduleIndexing(boost::posix_time::milliseconds(200));
+   }
+
+   void onFilesChanged(const std::vector<core::system::FileChangeEvent>& events)
+   {
+      for (const core::system::FileChangeEvent& event : events)
+         enque(event);
+
+      // don't index anything immediately (many files can change at once);
+      // searches treat files which are waiting to be indexed as candidates
+      scheduleIndexing(boost::posix_time::milliseconds(0));
+   }
+
+   void onMonitoringDisabled()
+   {
+      // clear the index so we don't ever return stale results
+      enabled_ = false;
+      ready_ = false;
+      dirty_ = false;
+      index_.clear();
+      indexingQueue_ = std::queue<core::system::FileChangeEvent>();
+      pendingPaths_.clear();
+   }
+
+   void onShutdown(bool)
+   {
+      if (enabled_ && ready_ && dirty_)
+         save();
+   }
+
+private:
+   FilePath indexFilePath() const
+   {
+      return module_context::scopedScratchPath().completePath("find-index");
+   }
+
+   void save()
+   {
+      Error error = index_.writeToFile(indexFilePath());
+      if (error)
+         LOG_ERROR(error);
+      dirty_ = false;
+   }
+
+   void enque(const core::system::FileChangeEvent& event)
+   {
+      indexingQueue_.push(event);
+      pendingPaths_[event.fileInfo().absolutePath()]++;
+   }
+
+   void scheduleIndexing(const boost::posix_time::time_duration& initialDuration)
+   {
+      // perform up to initialDuration of work immediately and then continue
+      // in periodic 20ms chunks until we are completed
+      if (!indexingQueue_.empty() && !indexing_)
+      {
+         indexing_ = true;
+         module_context::scheduleIncrementalWork(
+                  initialDuration,
+                  boost::posix_time::milliseconds(20),
+                  boost::bind(&FindIndex::dequeAndIndex, this),
+                  false /* allow indexing even when non-idle */);
+      }
+      else if (indexingQueue_.empty() && enabled_ && !ready_)
+      {
+         onIndexingCompleted();
+      }
+   }
+
+   bool dequeAndIndex()
+   {
+      using namespace core::system;
+
+      if (!enabled_)
+      {
+         indexing_ = false;
+         return false;
+      }
+
+      if (!indexingQueue_.empty())
+      {
+         FileChangeEvent event = indexingQueue_.front();
+         indexingQueue_.pop();
+
+         const FileInfo& fileInfo = event.fileInfo();
+         auto pendingIt = pendingPaths_.find(fileInfo.absolutePath());
+         if (pendingIt != pendingPaths_.end() && --pendingIt->second <= 0)
+            pendingPaths_.erase(pendingIt);
+
+         switch (event.type())
+         {
+            case FileChangeEvent::FileAdded:
+            case FileChangeEvent::FileModified:
+               updateEntry(fileInfo);
+               break;
+
+            case FileChangeEvent::FileRemoved:
+               removeEntry(fileInfo);
+               break;
+
+            case FileChangeEvent::None:
+               break;
+         }
+      }
+
+      indexing_ = !indexingQueue_.empty();
+      if (!indexing_ && !ready_)
+         onIndexingCompleted();
+      return indexing_;
+   }
+
+   void onIndexingCompleted()
+   {
+      ready_ = true;
+      if (dirty_)
+         save();
+   }
+
+   void updateEntry(const FileInfo& fileInfo)
+   {
+      if (fileInfo.isDirectory())
+         return;
+
+      const std::string& path = fileInfo.absolutePath();
+      dirty_ = true;
+
+      if (fileInfo.size() > kMaxIndexedFileSize)
+      {
+         index_.updateUnindexed(path, fileInfo.lastWriteTime(), fileInfo.size());
+         return;
+      }
+
+      std::string contents;
+      Error error = readStringFromFile(FilePath(path), &contents);
+      if (error)
+      {
+         // the file may have been removed after entering the queue
+         if (!isPathNotFoundError(error))
+            LOG_ERROR(error);
+         index_.remove(path);
+         return;
+      }
+
+      index_.update(path, fileInfo.lastWriteTime(), fileInfo.size(), contents);
+   }
+
+   void removeEntry(const FileInfo& fileInfo)
+   {
+      dirty_ = true;
+      if (!fileInfo.isDirectory())
+      {
+         index_.remove(fileInfo.absolutePath());
+         return;
+      }
+
+      std::string prefix = fileInfo.absolutePath() + "/";
+      std::vector<std::string> paths;
+      index_.paths(&paths);
+      for (const std::string& path : paths)
+      {
+         if (path.compare(0, prefix.size(), prefix) == 0)
+            index_.remove(path);
+      }
+   }
+
+   text::TrigramIndex index_;
+   std::queue<core::system::FileChangeEvent> indexingQueue_;
+   std::unordered_map<std::string, int> pendingPaths_;
+   bool enabled_;
+   bool indexing_;
+   bool ready_;
+   bool dirty_;
+};
+
+FindIndex& findIndex()
+{
+   static FindIndex instance;
+   return instance;
+}
+
+} // anonymous namespace
+
+bool isAvailable(const FilePath& directory)
+{
+   return findIndex().isAvailable() &&
+          projects::projectContext().isMonitoringDirectory(directory);
+}
+
+void candidateFiles(const FilePath& directory,
+                    const std::string& literal,
+                    bool ignoreCase,
+                    std::vector<std::string>* pPaths)
+{
+   findIndex().candidateFiles(directory, literal, ignoreCase, pPaths);
+}
+
+Error initialize()
+{
+   if (!session::options().findInFilesIndex())
+      return Success();
+
+   // subscribe to project context file monitoring state changes
+   // (note that if there is no project this will no-op)
+   session::projects::FileMonitorCallbacks cb;
+   cb.onMonitoringEnabled = boost::bind(&FindIndex::onMonitoringEnabled, &findIndex(), _1);
+   cb.onFilesChanged = boost::bind(&FindIndex::onFilesChanged, &findIndex(), _1);
+   cb.onMonitoringDisabled = boost::bind(&FindIndex::onMonitoringDisabled, &findIndex());
+   projects::projectContext().subscribeToFileMonitor("Find in files indexing", cb);
+
+   module_context::events().onShutdown.connect(
+            boost::bind(&FindIndex::onShutdown, &findIndex(), _1));
+
+   return Success();
+}
+
+} // namespace index
+} // namespace find
+} // namespace modules
+} // namespace session
+} // namespace rstudio
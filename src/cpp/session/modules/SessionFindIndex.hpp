@@ -0,0 +1,57 @@
+/*
+ * SessionFindIndex.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_FIND_INDEX_HPP
+#define SESSION_FIND_INDEX_HPP
+
+#include <string>
+#include <vector>
+
+namespace rstudio {
+namespace core {
+   class Error;
+   class FilePath;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace find {
+namespace index {
+
+// Trigram index of the files within the project, kept current using the
+// project's file monitor and persisted in the project scratch path so that
+// it needn't be rebuilt from scratch when the session restarts.
+
+// is the index up to date for files within this directory?
+bool isAvailable(const core::FilePath& directory);
+
+// sorted paths of the files within directory which could contain literal
+// (i.e. those which haven't been ruled out by the index)
+void candidateFiles(const core::FilePath& directory,
+                    const std::string& literal,
+                    bool ignoreCase,
+                    std::vector<std::string>* pPaths);
+
+core::Error initialize();
+
+} // namespace index
+} // namespace find
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_FIND_INDEX_HPP
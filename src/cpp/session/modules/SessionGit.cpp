@@ -38,6 +38,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
 #include <boost/regex.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <core/Algorithm.hpp>
 #include <core/BoostLamda.hpp>
@@ -47,9 +48,10 @@
 #include <core/system/System.hpp>
 #include <core/system/Process.hpp>
 #include <core/system/Environment.hpp>
+#include <core/system/FileMonitor.hpp>
 #include <core/Exec.hpp>
 #include <core/FileSerializer.hpp>
-#include <core/GitGraph.hpp>
+#include <core/GitGraphCache.hpp>
 #include <core/Scope.hpp>
 #include <core/StringUtils.hpp>
 
@@ -63,6 +65,7 @@
 #include <session/prefs/UserPrefs.hpp>
 
 #include "SessionAskPass.hpp"
+#include "SessionGitStatusCache.hpp"
 
 #include "SessionVCS.hpp"
 
@@ -100,9 +103,24 @@ ShellArgs gitArgs()
 std::vector<std::string> s_branches;
 std::string s_gitExePath;
 uint64_t s_gitVersion;
+
+// graph lines of the histories that have been viewed (so that paging
+// through a long history doesn't rebuild the graph from the top each time)
+boost::scoped_ptr<gitgraph::GraphCache> s_pGraphCache;
+
+// the status of the repository's files (refreshed as they change)
+boost::scoped_ptr<StatusCache> s_pStatusCache;
+
+// whether changes to the index and refs are being monitored (if not, the
+// tip of a history is resolved on every page to check whether it has
+// changed, and status isn't cached)
+bool s_gitDirMonitored = false;
+
 const uint64_t GIT_1_7_2 = ((uint64_t)1 << 48) |
                            ((uint64_t)7 << 32) |
                            ((uint64_t)2 << 16);
+const uint64_t GIT_2_15_0 = ((uint64_t)2 << 48) |
+                            ((uint64_t)15 << 32);
 
 core::system::ProcessOptions procOptions()
 {
@@ -515,58 +533,77 @@ public:
    core::Error status(const FilePath& dir,
                       StatusResult* pStatusResult)
    {
-      using namespace boost;
-
-      // objects to be populated from git's output
       std::vector<FileWithStatus> files;
-      
-      // build shell arguments
+      Error error = status(std::vector<FilePath>(1, dir), &files);
+      if (error)
+         return error;
+
+      *pStatusResult = StatusResult(files);
+
+      return Success();
+   }
+
+   // the status of the files within the passed paths (everything if no
+   // paths are passed)
+   core::Error status(const std::vector<FilePath>& paths,
+                      std::vector<FileWithStatus>* pFiles)
+   {
+      // build shell arguments (asking git not to take the index lock to
+      // refresh it, as that would look like a change to the index)
       ShellArgs arguments = gitArgs();
-      
-      arguments << "status" << "-z" << "--porcelain" << "--" << dir;
-      
+      if (s_gitVersion >= GIT_2_15_0)
+         arguments << "--no-optional-locks";
+      arguments << "status" << "-z" << "--porcelain";
+      if (!paths.empty())
+         arguments << "--" << paths;
+
       std::string output;
       Error error = runGit(arguments, &output);
       if (error)
          return error;
-      
-      // split and parse each piece of status output
-      std::vector<std::string> pieces = core::algorithm::split(output, "\0");
-
-      for (std::vector<std::string>::iterator it = pieces.begin();
-           it != pieces.end();
-           it++)
-      {
-         std::string line = *it;
-         if (line.length() < 4)
-            continue;
-         FileWithStatus file;
 
-         std::string status = line.substr(0, 2);
-         std::string filePath = line.substr(3);
-         file.status = status;
-         
-         // if this was a git rename or copy, we need to capture the rename target from the next
-         // field. note that Git flips the order of filenames when running with '-z'
-         if (status == "R " || status == "C ")
-            filePath = *(++it) + " -> " + filePath;
+      parseStatus(output, root_, pFiles);
 
-         // remove trailing slashes
-         if (filePath.length() > 1 && filePath[filePath.length() - 1] == '/')
-            filePath = filePath.substr(0, filePath.size() - 1);
+      return Success();
+   }
 
-         // file paths are returned as UTF-8 encoded paths,
-         // so no need to re-encode here
-         file.path = root_.completeChildPath(filePath);
+   // the files tracked in the repository
+   core::Error listFiles(std::vector<FilePath>* pFiles)
+   {
+      std::string output;
+      Error error = runGit(gitArgs() << "ls-files" << "-z", &output);
+      if (error)
+         return error;
 
-         files.push_back(file);
+      for (const std::string& path : core::algorithm::split(output, "\0"))
+      {
+         if (!path.empty())
+            pFiles->push_back(root_.completeChildPath(path));
       }
 
-      *pStatusResult = StatusResult(files);
-
       return Success();
    }
 
+   // the user's global ignore rules (core.excludesFile, which git reads
+   // from $XDG_CONFIG_HOME/git/ignore if it isn't set)
+   FilePath excludesFile()
+   {
+      std::string output;
+      int exitCode = 0;
+      Error error = runGit(gitArgs() << "config" << "--path" << "core.excludesFile",
+                           &output,
+                           nullptr,
+                           &exitCode);
+      std::string path = string_utils::trimWhitespace(output);
+      if (!error && exitCode == 0 && !path.empty())
+         return root_.completePath(path);
+
+      std::string configHome = core::system::getenv("XDG_CONFIG_HOME");
+      if (configHome.empty())
+         return module_context::userHomePath().completePath(".config/git/ignore");
+      return FilePath(configHome).completePath("git/ignore");
+   }
+
    core::Error add(const std::vector<FilePath>& filePaths)
    {
       return runGit(gitArgs() << "add" << "--" << filePaths);
@@ -1223,13 +1260,13 @@ public:
                        << "--pretty=raw" << "--decorate=full"
                        << "--date-order";
 
-      ShellArgs revListArgs = gitArgs() << "rev-list" << "--date-order" << "--parents";
-      int revListSkip = skip;
+      // the page of the graph to show (when showing one)
+      int graphSkip = skip;
+      int graphMaxEntries = maxentries;
 
       if (!fileFilter.isEmpty())
       {
          args << "--" << fileFilter;
-         revListArgs << "--" << fileFilter;
       }
 
       if (searchText.empty() && fileFilter.isEmpty())
@@ -1245,21 +1282,11 @@ public:
          {
             args << "--max-count=" + safe_convert::numberToString(maxentries);
             maxentries = -1;
-
-            revListArgs << "--max-count=" + safe_convert::numberToString(
-                  (skip < 0 ? 0 : skip) + maxentries);
          }
       }
 
       if (!rev.empty())
-      {
          args << rev;
-         revListArgs << rev;
-      }
-      else
-      {
-         revListArgs << "HEAD";
-      }
 
       if (maxentries < 0)
          maxentries = std::numeric_limits<int>::max();
@@ -1273,33 +1300,46 @@ public:
       output.clear();
 
       std::vector<std::string> graphLines;
-      if (searchText.empty() && fileFilter.isEmpty())
+      if (searchText.empty() && fileFilter.isEmpty() && s_pGraphCache)
       {
-         std::vector<std::string> revOutLines;
-         std::string revOutput;
-         error = runGit(revListArgs, &revOutput);
+         std::string revListRev = rev.empty() ? "HEAD" : rev;
+         ShellArgs revParseArgs = gitArgs() << "rev-parse" << revListRev;
+         auto resolveTip = [&](std::string* pTip) -> Error
+         {
+            return runGit(revParseArgs, pTip);
+         };
+         auto revList = [&](std::size_t skip,
+                            std::size_t count,
+                            std::vector<std::string>* pLines) -> Error
+         {
+            ShellArgs args = gitArgs() << "rev-list" << "--date-order" << "--parents";
+            args << "--skip=" + safe_convert::numberToString(skip);
+            if (count < static_cast<std::size_t>(std::numeric_limits<int>::max()))
+               args << "--max-count=" + safe_convert::numberToString(count);
+            args << revListRev;
+
+            std::string output;
+            Error error = runGit(args, &output);
+            if (error)
+               return error;
+            *pLines = split(output);
+            return Success();
+         };
+
+         if (!s_gitDirMonitored)
+            s_pGraphCache->invalidate();
+
+         std::size_t graphCount = graphMaxEntries < 0 ?
+                  std::numeric_limits<std::size_t>::max() :
+                  static_cast<std::size_t>(graphMaxEntries);
+         error = s_pGraphCache->lines(revListRev,
+                                      graphSkip < 0 ? 0 : graphSkip,
+                                      graphCount,
+                                      resolveTip,
+                                      revList,
+                                      &graphLines);
          if (error)
             return error;
-         revOutLines = split(revOutput);
-         revOutput.clear();
-
-         gitgraph::GitGraph graph;
-         for (size_t i = 0; i < revOutLines.size(); i++)
-         {
-            typedef std::vector<std::string> find_vector_type;
-            find_vector_type parents;
-            boost::algorithm::split(parents, revOutLines[i],
-                                    boost::algorithm::is_any_of(" "));
-            if (parents.size() < 1)
-               break;
-
-            std::string commit = parents.front();
-            parents.erase(parents.begin());
-
-            gitgraph::Line line = graph.addCommit(commit, parents);
-            if (revListSkip <= 0 || gsl::narrow_cast<int>(i) >= revListSkip)
-               graphLines.push_back(line.string());
-         }
       }
 
       boost::function<bool(CommitInfo)> filter = createSearchTextPredicate(searchText);
@@ -1604,14 +1644,56 @@ void GitFileDecorationContext::decorateFile(const FilePath &filePath,
    (*pFileObject)["git_status"] = vcsObj;
 }
 
+namespace {
+
+bool useStatusCache(const FilePath& dir)
+{
+   if (!s_pStatusCache)
+      return false;
+
+   // the cache relies on hearing about every change to the repository's
+   // files (from the project's file monitor) and to its index and refs
+   if (!s_gitDirMonitored ||
+       !projects::projectContext().isMonitoringDirectory(s_git_.root()))
+   {
+      s_pStatusCache->invalidate();
+      return false;
+   }
+
+   // directories the file monitor filters out (e.g. hidden or ignored
+   // directories) are left to git
+   return dir.isWithin(s_git_.root()) && s_pStatusCache->isMonitored(dir, true);
+}
+
+} // anonymous namespace
+
 core::Error status(const FilePath& dir, StatusResult* pStatusResult)
 {
    if (s_git_.root().isEmpty())
       return Success();
 
+   if (useStatusCache(dir))
+      return s_pStatusCache->status(dir, pStatusResult);
+
    return s_git_.status(dir, pStatusResult);
 }
 
+void onFilesChanged(const std::vector<core::system::FileChangeEvent>& events)
+{
+   if (!s_pStatusCache)
+      return;
+
+   FilePath gitDir = s_git_.root().completeChildPath(".git");
+   std::vector<FilePath> paths;
+   for (const core::system::FileChangeEvent& event : events)
+   {
+      FilePath path(event.fileInfo().absolutePath());
+      if (!path.isWithin(gitDir))
+         paths.push_back(path);
+   }
+   s_pStatusCache->onFilesChanged(paths);
+}
+
 Error fileStatus(const FilePath& filePath, VCSStatus* pStatus)
 {
    StatusResult statusResult;
@@ -1798,7 +1880,7 @@ Error vcsFullStatus(const json::JsonRpcRequest&,
                     json::JsonRpcResponse* pResponse)
 {
    StatusResult statusResult;
-   Error error = s_git_.status(s_git_.root(), &statusResult);
+   Error error = git::status(s_git_.root(), &statusResult);
    if (error)
       return error;
 
@@ -2307,57 +2389,72 @@ Error vcsHistory(const json::JsonRpcRequest& request,
    if (error)
       return error;
 
-   json::Array ids;
-   json::Array authors;
-   json::Array parents;
-   json::Array subjects;
-   json::Array dates;
-   json::Array descriptions;
-   json::Array refs;
-   json::Array tags;
-   json::Array graphs;
-
-   for (std::vector<CommitInfo>::const_iterator it = commits.begin();
-        it != commits.end();
-        it++)
-   {
-      ids.push_back(it->id);
-      authors.push_back(string_utils::filterControlChars(it->author));
-      parents.push_back(string_utils::filterControlChars(it->parent));
-      subjects.push_back(string_utils::filterControlChars(it->subject));
-      descriptions.push_back(string_utils::filterControlChars(it->description));
-      dates.push_back(static_cast<double>(it->date));
-      graphs.push_back(it->graph);
-
-      json::Array theseRefs;
-      std::transform(
-         it->refs.begin(),
-         it->refs.end(),
-         std::back_inserter(theseRefs),
-         [](const std::string& val) { return json::Value(val); });
-      refs.push_back(theseRefs);
-
-      json::Array theseTags;
-      std::transform(
-         it->tags.begin(),
-         it->tags.end(),
-         std::back_inserter(theseTags),
-         [](const std::string& val) { return json::Value(val); });
-      tags.push_back(theseTags);
-   }
+   // the history can be very long, so stream it to the result rather than
+   // building it up as json values
+   std::string result;
+   {
+      json::Writer writer(&result);
+      writer.startObject();
+
+      writer.key("id").startArray();
+      for (const CommitInfo& commit : commits)
+         writer.value(commit.id);
+      writer.endArray();
+
+      writer.key("author").startArray();
+      for (const CommitInfo& commit : commits)
+         writer.value(string_utils::filterControlChars(commit.author));
+      writer.endArray();
+
+      writer.key("parent").startArray();
+      for (const CommitInfo& commit : commits)
+         writer.value(string_utils::filterControlChars(commit.parent));
+      writer.endArray();
+
+      writer.key("subject").startArray();
+      for (const CommitInfo& commit : commits)
+         writer.value(string_utils::filterControlChars(commit.subject));
+      writer.endArray();
+
+      writer.key("description").startArray();
+      for (const CommitInfo& commit : commits)
+         writer.value(string_utils::filterControlChars(commit.description));
+      writer.endArray();
+
+      writer.key("date").startArray();
+      for (const CommitInfo& commit : commits)
+         writer.value(static_cast<double>(commit.date));
+      writer.endArray();
+
+      writer.key("refs").startArray();
+      for (const CommitInfo& commit : commits)
+      {
+         writer.startArray();
+         for (const std::string& ref : commit.refs)
+            writer.value(ref);
+         writer.endArray();
+      }
+      writer.endArray();
 
-   json::Object result;
-   result["id"] = ids;
-   result["author"] = authors;
-   result["parent"] = parents;
-   result["subject"] = subjects;
-   result["description"] = descriptions;
-   result["date"] = dates;
-   result["refs"] = refs;
-   result["tags"] = tags;
-   result["graph"] = graphs;
+      writer.key("tags").startArray();
+      for (const CommitInfo& commit : commits)
+      {
+         writer.startArray();
+         for (const std::string& tag : commit.tags)
+            writer.value(tag);
+         writer.endArray();
+      }
+      writer.endArray();
 
-   pResponse->setResult(result);
+      writer.key("graph").startArray();
+      for (const CommitInfo& commit : commits)
+         writer.value(commit.graph);
+      writer.endArray();
+
+      writer.endObject();
+   }
+
+   pResponse->setRawResult(std::move(result));
 
    return Success();
 }
@@ -3287,6 +3384,54 @@ bool isGithubRepository()
 }
 
 
+namespace {
+
+bool isIndexOrRefsFile(const FilePath& gitDir, const FileInfo& fileInfo)
+{
+   FilePath filePath(fileInfo.absolutePath());
+   return filePath == gitDir.completeChildPath("index") ||
+          filePath == gitDir.completeChildPath("HEAD") ||
+          filePath == gitDir.completeChildPath("packed-refs") ||
+          filePath.isWithin(gitDir.completeChildPath("refs"));
+}
+
+void onGitDirMonitoringError(const Error& error)
+{
+   LOG_ERROR(error);
+   s_gitDirMonitored = false;
+}
+
+// the project's file monitor ignores .git, so we watch the index and refs
+// ourselves (a commit, checkout, stage, fetch, etc. changes them)
+void monitorGitDir(const FilePath& gitDir)
+{
+   core::system::file_monitor::Callbacks cb;
+   cb.onRegistered = [](core::system::file_monitor::Handle, const tree<FileInfo>&)
+   {
+      s_gitDirMonitored = true;
+      s_pGraphCache->invalidate();
+      s_pStatusCache->invalidate();
+   };
+   cb.onRegistrationError = onGitDirMonitoringError;
+   cb.onMonitoringError = onGitDirMonitoringError;
+   cb.onFilesChanged = [](const std::vector<core::system::FileChangeEvent>&)
+   {
+      s_pGraphCache->invalidate();
+      s_pStatusCache->invalidate();
+   };
+   cb.onUnregistered = [](core::system::file_monitor::Handle)
+   {
+      s_gitDirMonitored = false;
+   };
+
+   core::system::file_monitor::registerMonitor(gitDir,
+                                               true,
+                                               boost::bind(isIndexOrRefsFile, gitDir, _1),
+                                               cb);
+}
+
+} // anonymous namespace
+
 core::Error initializeGit(const core::FilePath& workingDir)
 {
    s_git_.setRoot(detectGitDir(workingDir));
@@ -3297,6 +3442,31 @@ core::Error initializeGit(const core::FilePath& workingDir)
       Error error = augmentGitIgnore(gitIgnore);
       if (error)
          LOG_ERROR(error);
+
+      s_pGraphCache.reset(new gitgraph::GraphCache(
+               module_context::scopedScratchPath().completePath("git-graph")));
+      s_pStatusCache.reset(new StatusCache(
+               s_git_.root(),
+               [](const std::vector<FilePath>& paths, std::vector<FileWithStatus>* pFiles)
+               {
+                  return s_git_.status(paths, pFiles);
+               },
+               [](std::vector<FilePath>* pFiles)
+               {
+                  return s_git_.listFiles(pFiles);
+               },
+               [](const FileInfo& fileInfo)
+               {
+                  return projects::projectContext().isMonitoredFile(fileInfo);
+               },
+               { s_git_.root().completePath(".git/info/exclude"), s_git_.excludesFile() }));
+
+      // (.git is a file rather than a directory in worktrees and submodules,
+      // in which case the tip of a history is checked on every page and
+      // status isn't cached)
+      FilePath gitDir = s_git_.root().completeChildPath(".git");
+      if (gitDir.isDirectory())
+         monitorGitDir(gitDir);
    }
 
    return Success();
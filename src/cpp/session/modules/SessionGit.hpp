@@ -17,11 +17,14 @@
 #define SESSION_GIT_HPP
 
 #include <map>
+#include <vector>
 
 #include <shared_core/Error.hpp>
 #include <shared_core/FilePath.hpp>
 #include <shared_core/json/Json.hpp>
 
+#include <core/system/FileChangeEvent.hpp>
+
 #include "vcs/SessionVCSCore.hpp"
 
 namespace rstudio {
@@ -70,6 +73,7 @@ std::string nonPathGitBinDir();
 
 core::Error status(const core::FilePath& dir,
                    source_control::StatusResult* pStatusResult);
+void onFilesChanged(const std::vector<core::system::FileChangeEvent>& events);
 core::Error fileStatus(const core::FilePath& filePath,
                        source_control::VCSStatus* pStatus);
 core::Error statusToJson(const core::FilePath& path,
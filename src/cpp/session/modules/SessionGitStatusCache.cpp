@@ -0,0 +1,359 @@
+/*
+ * SessionGitStatusCache.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionGitStatusCache.hpp"
+
+#include <algorithm>
+
+#include <core/Algorithm.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace git {
+
+using namespace source_control;
+
+namespace {
+
+// beyond this many changed paths (e.g. after a large build or a checkout)
+// it's cheaper to refresh everything than to list them all for git
+const std::size_t kMaxChangedPaths = 256;
+
+bool isUntracked(const FileWithStatus& file)
+{
+   return file.status.status() == "??";
+}
+
+} // anonymous namespace
+
+void parseStatus(const std::string& output,
+                 const FilePath& root,
+                 std::vector<FileWithStatus>* pFiles)
+{
+   // split and parse each piece of status output
+   std::vector<std::string> pieces = core::algorithm::split(output, "\0");
+
+   for (std::vector<std::string>::iterator it = pieces.begin();
+        it != pieces.end();
+        it++)
+   {
+      std::string line = *it;
+      if (line.length() < 4)
+         continue;
+      FileWithStatus file;
+
+      std::string status = line.substr(0, 2);
+      std::string filePath = line.substr(3);
+      file.status = status;
+
+      // if this was a git rename or copy, we need to capture the rename target from the next
+      // field. note that Git flips the order of filenames when running with '-z'
+      if ((status == "R " || status == "C ") && it + 1 != pieces.end())
+         filePath = *(++it) + " -> " + filePath;
+
+      // remove trailing slashes
+      if (filePath.length() > 1 && filePath[filePath.length() - 1] == '/')
+         filePath = filePath.substr(0, filePath.size() - 1);
+
+      // file paths are returned as UTF-8 encoded paths,
+      // so no need to re-encode here
+      file.path = root.completeChildPath(filePath);
+
+      pFiles->push_back(file);
+   }
+}
+
+StatusCache::StatusCache(const FilePath& root,
+                         const StatusFunction& statusFunction,
+                         const TrackedFilesFunction& trackedFilesFunction,
+                         const MonitorFilter& monitorFilter,
+                         const std::vector<FilePath>& ignoreFiles)
+   : root_(root),
+     statusFunction_(statusFunction),
+     trackedFilesFunction_(trackedFilesFunction),
+     monitorFilter_(monitorFilter),
+     ignoreFiles_(ignoreFiles),
+     valid_(false)
+{
+}
+
+Error StatusCache::status(const FilePath& dir, StatusResult* pStatusResult)
+{
+   Error error = refresh();
+   if (error)
+      return error;
+
+   std::vector<FileWithStatus> files;
+
+   // parents with a status (an untracked parent's status applies to
+   // everything within it)
+   if (dir != root_)
+   {
+      for (FilePath parent = dir.getParent();
+           parent.isWithin(root_) && parent != root_;
+           parent = parent.getParent())
+      {
+         auto it = files_.find(parent.getAbsolutePath());
+         if (it != files_.end())
+            files.push_back(it->second);
+      }
+   }
+
+   // everything within the directory
+   if (dir == root_)
+   {
+      for (const auto& entry : files_)
+         files.push_back(entry.second);
+   }
+   else
+   {
+      std::string path = dir.getAbsolutePath();
+      auto it = files_.find(path);
+      if (it != files_.end())
+         files.push_back(it->second);
+
+      std::string prefix = path + "/";
+      for (it = files_.lower_bound(prefix);
+           it != files_.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+           ++it)
+      {
+         files.push_back(it->second);
+      }
+   }
+
+   *pStatusResult = StatusResult(files);
+   return Success();
+}
+
+void StatusCache::onFilesChanged(const std::vector<FilePath>& paths)
+{
+   if (!valid_)
+      return;
+
+   for (const FilePath& path : paths)
+   {
+      // a change to ignore rules can change the status of any path
+      if (path.getFilename() == ".gitignore")
+      {
+         invalidate();
+         return;
+      }
+
+      if (path.isWithin(root_) && path != root_)
+         changedPaths_.insert(path);
+   }
+}
+
+void StatusCache::invalidate()
+{
+   valid_ = false;
+   files_.clear();
+   changedPaths_.clear();
+   unmonitoredPaths_.clear();
+}
+
+bool StatusCache::isMonitored(const FilePath& path, bool isDirectory) const
+{
+   return unmonitoredParent(path, isDirectory).isEmpty();
+}
+
+Error StatusCache::refresh()
+{
+   if (!valid_ ||
+       ignoreFileStates() != ignoreFileStates_ ||
+       changedPaths_.size() + unmonitoredPaths_.size() > kMaxChangedPaths)
+   {
+      return fullRefresh();
+   }
+
+   // changes within an untracked directory can only affect the directory's
+   // own status, so refresh that instead
+   std::set<FilePath> paths = unmonitoredPaths_;
+   for (const FilePath& path : changedPaths_)
+   {
+      FilePath untracked = untrackedParent(path);
+      paths.insert(untracked.isEmpty() ? path : untracked);
+   }
+   changedPaths_.clear();
+
+   if (paths.empty())
+      return Success();
+
+   Error error = refreshPaths(paths);
+   if (error)
+   {
+      invalidate();
+      return error;
+   }
+
+   return Success();
+}
+
+Error StatusCache::fullRefresh()
+{
+   invalidate();
+
+   // (ignore files are read before asking git, so that a change while it
+   // runs is noticed next time)
+   std::vector<std::string> ignoreFileStates = this->ignoreFileStates();
+
+   std::vector<FileWithStatus> files;
+   Error error = statusFunction_(std::vector<FilePath>(), &files);
+   if (error)
+      return error;
+
+   std::vector<FilePath> tracked;
+   error = trackedFilesFunction_(&tracked);
+   if (error)
+      return error;
+
+   for (const FileWithStatus& file : files)
+   {
+      files_[file.path.getAbsolutePath()] = file;
+
+      FilePath unmonitored = unmonitoredParent(file.path, file.path.isDirectory());
+      if (!unmonitored.isEmpty())
+         unmonitoredPaths_.insert(unmonitored);
+   }
+
+   for (const FilePath& path : tracked)
+   {
+      FilePath unmonitored = unmonitoredParent(path, false);
+      if (!unmonitored.isEmpty())
+         unmonitoredPaths_.insert(unmonitored);
+   }
+
+   ignoreFileStates_ = ignoreFileStates;
+   stats_.fullRefreshes++;
+   valid_ = true;
+   return Success();
+}
+
+Error StatusCache::refreshPaths(const std::set<FilePath>& paths)
+{
+   std::set<FilePath> pending = paths;
+   while (!pending.empty())
+   {
+      // (paths within others are covered by them)
+      std::vector<FilePath> query;
+      for (const FilePath& path : pending)
+      {
+         if (query.empty() || !path.isWithin(query.back()))
+            query.push_back(path);
+      }
+
+      std::vector<FileWithStatus> files;
+      Error error = statusFunction_(query, &files);
+      if (error)
+         return error;
+      stats_.pathRefreshes++;
+
+      std::set<FilePath> wasUntracked;
+      for (const FilePath& path : query)
+      {
+         auto it = files_.find(path.getAbsolutePath());
+         if (it != files_.end() && isUntracked(it->second))
+            wasUntracked.insert(path);
+         eraseWithin(path);
+      }
+      for (const FileWithStatus& file : files)
+         files_[file.path.getAbsolutePath()] = file;
+
+      // a path which has become untracked might be within a directory that
+      // has nothing tracked, in which case a full status reports just the
+      // directory, so look at the parent too
+      pending.clear();
+      for (const FileWithStatus& file : files)
+      {
+         if (isUntracked(file) &&
+             std::find(query.begin(), query.end(), file.path) != query.end() &&
+             wasUntracked.count(file.path) == 0 &&
+             file.path.getParent() != root_)
+         {
+            pending.insert(file.path.getParent());
+         }
+      }
+   }
+
+   return Success();
+}
+
+void StatusCache::eraseWithin(const FilePath& path)
+{
+   std::string absolutePath = path.getAbsolutePath();
+   files_.erase(absolutePath);
+
+   std::string prefix = absolutePath + "/";
+   auto begin = files_.lower_bound(prefix);
+   auto end = begin;
+   while (end != files_.end() && end->first.compare(0, prefix.size(), prefix) == 0)
+      ++end;
+   files_.erase(begin, end);
+}
+
+FilePath StatusCache::untrackedParent(const FilePath& path) const
+{
+   for (FilePath parent = path.getParent();
+        parent.isWithin(root_) && parent != root_;
+        parent = parent.getParent())
+   {
+      auto it = files_.find(parent.getAbsolutePath());
+      if (it != files_.end() && isUntracked(it->second))
+         return parent;
+   }
+   return FilePath();
+}
+
+FilePath StatusCache::unmonitoredParent(const FilePath& path, bool isDirectory) const
+{
+   if (!monitorFilter_ || !path.isWithin(root_) || path == root_)
+      return FilePath();
+
+   // check each path from the root down (the file monitor doesn't look
+   // within a directory it filters out)
+   std::vector<FilePath> paths;
+   for (FilePath current = path; current != root_; current = current.getParent())
+      paths.push_back(current);
+
+   for (auto it = paths.rbegin(); it != paths.rend(); ++it)
+   {
+      bool directory = isDirectory || *it != path;
+      if (!monitorFilter_(FileInfo(it->getAbsolutePath(), directory)))
+         return *it;
+   }
+   return FilePath();
+}
+
+std::vector<std::string> StatusCache::ignoreFileStates() const
+{
+   std::vector<std::string> states;
+   for (const FilePath& ignoreFile : ignoreFiles_)
+   {
+      if (ignoreFile.exists())
+         states.push_back(std::to_string(ignoreFile.getSize()) + ":" +
+                          std::to_string(ignoreFile.getLastWriteTime()));
+      else
+         states.push_back(std::string());
+   }
+   return states;
+}
+
+} // namespace git
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,144 @@
+/*
+ * SessionGitStatusCache.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_GIT_STATUS_CACHE_HPP
+#define SESSION_GIT_STATUS_CACHE_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#include <core/FileInfo.hpp>
+
+#include "vcs/SessionVCSCore.hpp"
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace git {
+
+// parse the output of git status -z --porcelain (paths are relative to root)
+void parseStatus(const std::string& output,
+                 const core::FilePath& root,
+                 std::vector<source_control::FileWithStatus>* pFiles);
+
+// runs git status for the passed paths (the whole repository if there are
+// none), providing the status of each file reported
+typedef boost::function<core::Error(
+      const std::vector<core::FilePath>&,
+      std::vector<source_control::FileWithStatus>*)> StatusFunction;
+
+// lists the files tracked in the repository (e.g. with git ls-files)
+typedef boost::function<core::Error(std::vector<core::FilePath>*)> TrackedFilesFunction;
+
+// whether changes to a file or directory are reported by the file monitor
+// (given that changes within its parent directory are)
+typedef boost::function<bool(const core::FileInfo&)> MonitorFilter;
+
+// Keeps the status of every path in a repository, so that a refresh only
+// needs to ask git about the paths which have changed since the last one
+// rather than running git status over the whole repository.
+//
+// Changed paths (e.g. from file monitor events) are collected and refreshed
+// together when status is next requested, so a burst of changes costs a
+// single git status. Anything which could change the status of any path
+// (the index or HEAD changing) should invalidate the cache, prompting a
+// full refresh; changes to ignore rules (any .gitignore, or one of the
+// passed ignore files such as .git/info/exclude) do so automatically.
+//
+// Paths which the file monitor filters out (e.g. hidden files or ignored
+// directories) never report changes, so the parts of the repository git
+// knows about beneath them are asked about again on every refresh. Untracked
+// files created elsewhere beneath them are only noticed by the next full
+// refresh; status for a directory which isn't monitored shouldn't be taken
+// from the cache at all (see isMonitored).
+class StatusCache : boost::noncopyable
+{
+public:
+   StatusCache(const core::FilePath& root,
+               const StatusFunction& statusFunction,
+               const TrackedFilesFunction& trackedFilesFunction,
+               const MonitorFilter& monitorFilter,
+               const std::vector<core::FilePath>& ignoreFiles);
+
+   // the status of everything within dir (and of any of its parents which
+   // have a status, e.g. an untracked parent)
+   core::Error status(const core::FilePath& dir,
+                      source_control::StatusResult* pStatusResult);
+
+   // note paths which have changed (refreshed on the next call to status)
+   void onFilesChanged(const std::vector<core::FilePath>& paths);
+
+   // discard everything (the next call to status runs a full refresh)
+   void invalidate();
+
+   // whether changes to path (and to everything leading to it from the
+   // root) are reported by the file monitor
+   bool isMonitored(const core::FilePath& path, bool isDirectory) const;
+
+   struct Stats
+   {
+      Stats() : fullRefreshes(0), pathRefreshes(0) {}
+      int fullRefreshes;
+      int pathRefreshes;
+   };
+   const Stats& stats() const { return stats_; }
+
+private:
+   core::Error refresh();
+   core::Error fullRefresh();
+   core::Error refreshPaths(const std::set<core::FilePath>& paths);
+   void eraseWithin(const core::FilePath& path);
+   core::FilePath untrackedParent(const core::FilePath& path) const;
+   core::FilePath unmonitoredParent(const core::FilePath& path, bool isDirectory) const;
+   std::vector<std::string> ignoreFileStates() const;
+
+   const core::FilePath root_;
+   const StatusFunction statusFunction_;
+   const TrackedFilesFunction trackedFilesFunction_;
+   const MonitorFilter monitorFilter_;
+   const std::vector<core::FilePath> ignoreFiles_;
+   bool valid_;
+
+   // absolute path => status
+   std::map<std::string, source_control::FileWithStatus> files_;
+
+   // paths which have changed since the last refresh
+   std::set<core::FilePath> changedPaths_;
+
+   // the outermost paths git knows about which the file monitor doesn't
+   // report changes to (refreshed every time)
+   std::set<core::FilePath> unmonitoredPaths_;
+
+   // the size and modification time of each ignore file at the last full
+   // refresh
+   std::vector<std::string> ignoreFileStates_;
+
+   Stats stats_;
+};
+
+} // namespace git
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_GIT_STATUS_CACHE_HPP
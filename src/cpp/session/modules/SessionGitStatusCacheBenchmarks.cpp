@@ -0,0 +1,143 @@
+/*
+ * SessionGitStatusCacheBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionGitStatusCacheTestRepository.hpp"
+
+#include <functional>
+#include <iostream>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace git {
+namespace tests {
+
+using namespace boost::posix_time;
+
+namespace {
+
+const int kDirs = 500;
+const int kFilesPerDir = 100;
+
+FilePath filePath(const FilePath& root, int dir, int file)
+{
+   return root.completePath("dir" + std::to_string(dir) + "/file" + std::to_string(file) + ".R");
+}
+
+double elapsedMs(const ptime& start)
+{
+   return (microsec_clock::universal_time() - start).total_microseconds() / 1000.0;
+}
+
+// the time taken to get the status of the whole repository after each of
+// the given edits, both with a full git status and from the cache
+void measure(const std::string& name,
+             const FilePath& root,
+             StatusCache& cache,
+             int edits,
+             const std::function<std::vector<FilePath>(int)>& edit)
+{
+   double fullMs = 0;
+   double cachedMs = 0;
+   for (int i = 0; i < edits; i++)
+   {
+      std::vector<FilePath> changed = edit(i);
+
+      ptime start = microsec_clock::universal_time();
+      std::string full = fullStatus(root);
+      fullMs += elapsedMs(start);
+
+      start = microsec_clock::universal_time();
+      cache.onFilesChanged(changed);
+      std::string cached = cachedStatus(cache, root);
+      cachedMs += elapsedMs(start);
+
+      CHECK(cached == full);
+   }
+
+   std::cout << "git status after " << name << " (" << kDirs * kFilesPerDir << " files): "
+             << "full " << fullMs / edits << "ms, cached " << cachedMs / edits << "ms" << std::endl;
+}
+
+} // anonymous namespace
+
+// a large repository (including tracked files in a hidden directory, which
+// the file monitor doesn't report changes to) in which files are saved
+TEST_CASE("Git status cache with 50k files")
+{
+   FilePath root;
+   FilePath::tempFilePath(root);
+   root.ensureDirectory();
+   REQUIRE(runGit(root, "init -q"));
+   for (int dir = 0; dir < kDirs; dir++)
+   {
+      root.completePath("dir" + std::to_string(dir)).ensureDirectory();
+      for (int file = 0; file < kFilesPerDir; file++)
+         writeStringToFile(filePath(root, dir, file), "x\n");
+   }
+   write(root.completePath(".github/workflows/check.yaml"), "on: push\n");
+   REQUIRE(runGit(root, "add -A"));
+   REQUIRE(runGit(root, "commit -q -m initial"));
+
+   FilePath exclude = root.completePath(".git/info/exclude");
+   StatusCache cache(root,
+                     boost::bind(gitStatus, root, _1, _2),
+                     boost::bind(gitLsFiles, root, _1),
+                     isMonitoredFile,
+                     std::vector<FilePath>(1, exclude));
+   cachedStatus(cache, root);
+
+   measure("a save", root, cache, 10, [&](int i)
+   {
+      FilePath saved = filePath(root, i * 37, 7);
+      writeStringToFile(saved, "saved " + std::to_string(i) + "\n");
+      return std::vector<FilePath>(1, saved);
+   });
+
+   measure("saving 100 files at once", root, cache, 5, [&](int i)
+   {
+      std::vector<FilePath> saved;
+      for (int file = 0; file < 100; file++)
+      {
+         FilePath path = filePath(root, (i * 100 + file) % kDirs, file % kFilesPerDir);
+         writeStringToFile(path, "reformatted " + std::to_string(i) + "\n");
+         saved.push_back(path);
+      }
+      return saved;
+   });
+
+   measure("creating a file", root, cache, 10, [&](int i)
+   {
+      FilePath created = root.completePath("dir" + std::to_string(i) + "/new.R");
+      writeStringToFile(created, "new\n");
+      return std::vector<FilePath>(1, created);
+   });
+
+   CHECK(cache.stats().fullRefreshes == 1);
+
+   root.remove();
+}
+
+} // namespace tests
+} // namespace git
+} // namespace modules
+} // namespace session
+} // namespace rstudio
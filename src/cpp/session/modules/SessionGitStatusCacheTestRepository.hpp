@@ -0,0 +1,140 @@
+/*
+ * SessionGitStatusCacheTestRepository.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+// git helpers shared by the git status cache tests and benchmarks
+
+#ifndef SESSION_MODULES_GIT_STATUS_CACHE_TEST_REPOSITORY_HPP
+#define SESSION_MODULES_GIT_STATUS_CACHE_TEST_REPOSITORY_HPP
+
+#include "SessionGitStatusCache.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <core/Algorithm.hpp>
+#include <core/FileSerializer.hpp>
+#include <core/system/Process.hpp>
+#include <core/system/ShellUtils.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace git {
+namespace tests {
+
+using namespace rstudio::core;
+using namespace source_control;
+
+inline bool runGit(const FilePath& root, const std::string& args, std::string* pOutput = nullptr)
+{
+   core::system::ProcessOptions options;
+   options.workingDir = root;
+   core::system::ProcessResult result;
+   Error error = core::system::runCommand(
+            "git -c user.name=test -c user.email=test@example.com " + args,
+            options,
+            &result);
+   if (pOutput)
+      *pOutput = result.stdOut;
+   return !error && result.exitStatus == 0;
+}
+
+inline Error gitStatus(const FilePath& root,
+                       const std::vector<FilePath>& paths,
+                       std::vector<FileWithStatus>* pFiles)
+{
+   std::string args = "--no-optional-locks status -z --porcelain";
+   if (!paths.empty())
+   {
+      args += " --";
+      for (const FilePath& path : paths)
+         args += " " + core::shell_utils::escape(path);
+   }
+
+   std::string output;
+   if (!runGit(root, args, &output))
+      return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+
+   parseStatus(output, root, pFiles);
+   return Success();
+}
+
+inline Error gitLsFiles(const FilePath& root, std::vector<FilePath>* pFiles)
+{
+   std::string output;
+   if (!runGit(root, "ls-files -z", &output))
+      return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+
+   for (const std::string& path : core::algorithm::split(output, "\0"))
+   {
+      if (!path.empty())
+         pFiles->push_back(root.completeChildPath(path));
+   }
+   return Success();
+}
+
+// like the project's file monitor, leave out hidden files (other than
+// .gitignore) and an ignored directory
+inline bool isMonitoredFile(const FileInfo& fileInfo)
+{
+   FilePath path(fileInfo.absolutePath());
+   std::string name = path.getFilename();
+   if (name == ".gitignore")
+      return true;
+   return !boost::algorithm::starts_with(name, ".") && name != "ignored";
+}
+
+inline std::string describe(const StatusResult& result)
+{
+   std::map<std::string, std::string> statuses;
+   for (const FileWithStatus& file : result.files())
+      statuses[file.path.getAbsolutePath()] = file.status.status();
+
+   std::string description;
+   for (const auto& entry : statuses)
+      description += entry.second + " " + entry.first + "\n";
+   return description;
+}
+
+inline std::string fullStatus(const FilePath& root)
+{
+   std::vector<FileWithStatus> files;
+   gitStatus(root, std::vector<FilePath>(), &files);
+   return describe(StatusResult(files));
+}
+
+inline std::string cachedStatus(StatusCache& cache, const FilePath& dir)
+{
+   StatusResult result;
+   cache.status(dir, &result);
+   return describe(result);
+}
+
+inline void write(const FilePath& path, const std::string& contents)
+{
+   path.getParent().ensureDirectory();
+   writeStringToFile(path, contents);
+}
+
+} // namespace tests
+} // namespace git
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_MODULES_GIT_STATUS_CACHE_TEST_REPOSITORY_HPP
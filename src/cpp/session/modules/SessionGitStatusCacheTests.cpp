@@ -0,0 +1,245 @@
+/*
+ * SessionGitStatusCacheTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionGitStatusCacheTestRepository.hpp"
+
+#include <functional>
+
+#include <boost/bind.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace git {
+namespace tests {
+
+TEST_CASE("Git status cache")
+{
+   FilePath root;
+   FilePath::tempFilePath(root);
+   root.ensureDirectory();
+   REQUIRE(runGit(root, "init -q"));
+
+   write(root.completePath("README.md"), "readme\n");
+   write(root.completePath("R/a.R"), "a <- 1\n");
+   write(root.completePath("R/b.R"), "b <- 1\n");
+   write(root.completePath("src/deep/c.cpp"), "int c;\n");
+   REQUIRE(runGit(root, "add -A"));
+   REQUIRE(runGit(root, "commit -q -m initial"));
+
+   FilePath exclude = root.completePath(".git/info/exclude");
+   StatusCache cache(root,
+                     boost::bind(gitStatus, root, _1, _2),
+                     boost::bind(gitLsFiles, root, _1),
+                     isMonitoredFile,
+                     std::vector<FilePath>(1, exclude));
+
+   SECTION("Changed paths are refreshed without a full status")
+   {
+      CHECK(cachedStatus(cache, root).empty());
+
+      struct Change
+      {
+         std::string description;
+         std::function<void()> apply;
+         std::vector<std::string> changed;
+      };
+
+      std::vector<Change> changes = {
+         { "modify a tracked file",
+           [&]() { write(root.completePath("R/a.R"), "a <- 2\n"); },
+           { "R/a.R" } },
+         { "add an untracked file beside tracked files",
+           [&]() { write(root.completePath("R/new.R"), "new\n"); },
+           { "R/new.R" } },
+         { "add an untracked directory",
+           [&]() { write(root.completePath("data/raw/x.csv"), "x\n"); },
+           { "data", "data/raw", "data/raw/x.csv" } },
+         { "add a file within the untracked directory",
+           [&]() { write(root.completePath("data/y.csv"), "y\n"); },
+           { "data/y.csv" } },
+         { "add an untracked directory within a tracked one",
+           [&]() { write(root.completePath("src/deep/gen/out.o"), "o\n"); },
+           { "src/deep/gen", "src/deep/gen/out.o" } },
+         { "delete a tracked file",
+           [&]() { root.completePath("R/b.R").remove(); },
+           { "R/b.R" } },
+         { "remove the untracked directory",
+           [&]() { root.completePath("data").remove(); },
+           { "data" } },
+         { "restore a modified file",
+           [&]() { write(root.completePath("R/a.R"), "a <- 1\n"); },
+           { "R/a.R" } },
+         { "remove the last file in an untracked directory's parent",
+           [&]() { root.completePath("src/deep/c.cpp").remove(); },
+           { "src/deep/c.cpp" } },
+      };
+
+      for (const Change& change : changes)
+      {
+         INFO(change.description);
+         change.apply();
+
+         std::vector<FilePath> paths;
+         for (const std::string& path : change.changed)
+            paths.push_back(root.completePath(path));
+         cache.onFilesChanged(paths);
+
+         CHECK(cachedStatus(cache, root) == fullStatus(root));
+      }
+
+      CHECK(cache.stats().fullRefreshes == 1);
+      CHECK(cache.stats().pathRefreshes >= static_cast<int>(changes.size()));
+   }
+
+   SECTION("Status within a directory matches git")
+   {
+      write(root.completePath("R/a.R"), "a <- 2\n");
+      write(root.completePath("src/deep/new/n.cpp"), "n\n");
+      write(root.completePath("README.md"), "more\n");
+
+      std::vector<FileWithStatus> files;
+      gitStatus(root, std::vector<FilePath>(1, root.completePath("R")), &files);
+      CHECK(cachedStatus(cache, root.completePath("R")) == describe(StatusResult(files)));
+
+      // (including the status of an untracked parent)
+      StatusResult result;
+      cache.status(root.completePath("src/deep/new"), &result);
+      CHECK(result.getStatus(root.completePath("src/deep/new")).status() == "??");
+      CHECK(result.getStatus(root.completePath("R/a.R")).status().empty());
+   }
+
+   SECTION("Bursts of changes are refreshed together")
+   {
+      cachedStatus(cache, root);
+      std::vector<FilePath> paths;
+      for (int i = 0; i < 20; i++)
+      {
+         FilePath path = root.completePath("R/gen" + std::to_string(i) + ".R");
+         write(path, "x\n");
+         paths.push_back(path);
+         cache.onFilesChanged(std::vector<FilePath>(1, path));
+      }
+
+      CHECK(cachedStatus(cache, root) == fullStatus(root));
+      // (one git status for the files, and one for their directory, as
+      // they're untracked)
+      CHECK(cache.stats().fullRefreshes == 1);
+      CHECK(cache.stats().pathRefreshes == 2);
+   }
+
+   SECTION("Invalidating the cache prompts a full refresh")
+   {
+      cachedStatus(cache, root);
+      write(root.completePath("R/a.R"), "a <- 2\n");
+      REQUIRE(runGit(root, "add R/a.R"));
+      cache.invalidate();
+
+      CHECK(cachedStatus(cache, root) == fullStatus(root));
+      CHECK(cache.stats().fullRefreshes == 2);
+   }
+
+   root.remove();
+}
+
+TEST_CASE("Git status cache with ignore rules and unmonitored paths")
+{
+   FilePath root;
+   FilePath::tempFilePath(root);
+   root.ensureDirectory();
+   REQUIRE(runGit(root, "init -q"));
+
+   write(root.completePath("README.md"), "readme\n");
+   write(root.completePath(".lintr"), "lint\n");
+   write(root.completePath("ignored/tracked.R"), "t <- 1\n");
+   write(root.completePath("R/a.R"), "a <- 1\n");
+   REQUIRE(runGit(root, "add -A"));
+   REQUIRE(runGit(root, "commit -q -m initial"));
+
+   FilePath exclude = root.completePath(".git/info/exclude");
+   StatusCache cache(root,
+                     boost::bind(gitStatus, root, _1, _2),
+                     boost::bind(gitLsFiles, root, _1),
+                     isMonitoredFile,
+                     std::vector<FilePath>(1, exclude));
+
+   write(root.completePath("R/scratch.R"), "scratch\n");
+   CHECK(cachedStatus(cache, root) == fullStatus(root));
+   CHECK(cache.stats().fullRefreshes == 1);
+
+   SECTION("A change to a .gitignore invalidates the cache")
+   {
+      write(root.completePath(".gitignore"), "scratch.R\n");
+      cache.onFilesChanged(std::vector<FilePath>(1, root.completePath(".gitignore")));
+
+      std::string status = cachedStatus(cache, root);
+      CHECK(status == fullStatus(root));
+      CHECK(status.find("R/scratch.R") == std::string::npos);
+      CHECK(cache.stats().fullRefreshes == 2);
+   }
+
+   SECTION("A change to an ignore file prompts a full refresh")
+   {
+      // (without any file monitor events, as .git isn't monitored)
+      write(exclude, "# excluded\nscratch.R\n");
+
+      std::string status = cachedStatus(cache, root);
+      CHECK(status == fullStatus(root));
+      CHECK(status.find("R/scratch.R") == std::string::npos);
+      CHECK(cache.stats().fullRefreshes == 2);
+
+      // (and only once)
+      cachedStatus(cache, root);
+      CHECK(cache.stats().fullRefreshes == 2);
+   }
+
+   SECTION("Unmonitored paths are refreshed without file monitor events")
+   {
+      CHECK_FALSE(cache.isMonitored(root.completePath(".lintr"), false));
+      CHECK_FALSE(cache.isMonitored(root.completePath("ignored/tracked.R"), false));
+      CHECK_FALSE(cache.isMonitored(root.completePath("ignored/sub"), true));
+      CHECK(cache.isMonitored(root.completePath("R/a.R"), false));
+      CHECK(cache.isMonitored(root.completePath(".gitignore"), false));
+
+      write(root.completePath(".lintr"), "lint more\n");
+      write(root.completePath("ignored/tracked.R"), "t <- 2\n");
+      write(root.completePath("ignored/new.R"), "new\n");
+
+      std::string status = cachedStatus(cache, root);
+      CHECK(status == fullStatus(root));
+      CHECK(status.find(".lintr") != std::string::npos);
+      CHECK(status.find("ignored/tracked.R") != std::string::npos);
+      CHECK(status.find("ignored/new.R") != std::string::npos);
+      CHECK(cache.stats().fullRefreshes == 1);
+
+      // (restoring them is noticed too)
+      write(root.completePath(".lintr"), "lint\n");
+      write(root.completePath("ignored/tracked.R"), "t <- 1\n");
+      root.completePath("ignored/new.R").remove();
+      CHECK(cachedStatus(cache, root) == fullStatus(root));
+      CHECK(cache.stats().fullRefreshes == 1);
+   }
+
+   root.remove();
+}
+
+} // namespace tests
+} // namespace git
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -103,23 +103,6 @@ Error setJsonResultFromHistory(int startIndex,
    return Success();
 }
    
-bool matches(const HistoryEntry& entry,
-             const std::vector<std::string>& searchTerms)
-{   
-   // look for each search term in the input
-   for (std::vector<std::string>::const_iterator it = searchTerms.begin();
-        it != searchTerms.end();
-        ++it)
-   {
-      if (!boost::algorithm::contains(entry.command, *it))
-         return false;
-   }
-   
-   // had all of the search terms, return true
-   return true;
-}
-
-
 void historyRangeAsJson(int startIndex,
                         int endIndex,
                         json::Object* pHistoryJson)
@@ -319,25 +302,9 @@ Error searchHistoryArchive(const json::JsonRpcRequest& request,
    boost::tokenizer<boost::char_separator<char> > tok(query, sep);
    std::copy(tok.begin(), tok.end(), std::back_inserter(searchTerms));
    
-   // examine the items in the history for matches
-   const std::vector<HistoryEntry>& allEntries = historyArchive().entries();
-   std::vector<HistoryEntry> matchingEntries;
-   for (std::vector<HistoryEntry>::const_reverse_iterator 
-            it = allEntries.rbegin();
-            it != allEntries.rend();
-            ++it)
-   {
-      // check limit
-      if (matchingEntries.size() >= static_cast<std::size_t>(maxEntries))
-         break;
-
-      // look for match
-      if (matches(*it, searchTerms))
-      {
-         // add entry
-         matchingEntries.push_back(*it);
-      }
-   }
+   // find the most recent entries containing all of the terms
+   std::vector<HistoryEntry> matchingEntries = historyArchive().search(
+            searchTerms, static_cast<std::size_t>(maxEntries));
 
    // return json
    json::Object entriesJson;
@@ -361,30 +328,10 @@ Error searchHistoryArchiveByPrefix(const json::JsonRpcRequest& request,
    // trim the prefix
    boost::algorithm::trim(prefix);
    
-   // examine the items in the history for matches
-   const std::vector<HistoryEntry>& allEntries = historyArchive().entries();
-   std::set<std::string> matchedCommands;
-   std::vector<HistoryEntry> matchingEntries;
-   for (std::vector<HistoryEntry>::const_reverse_iterator 
-        it = allEntries.rbegin();
-        it != allEntries.rend();
-        ++it)
-   {
-      // check limit
-      if (matchingEntries.size() >= static_cast<std::size_t>(maxEntries))
-         break;
-      
-      // look for match 
-      if (boost::algorithm::starts_with(it->command, prefix))
-      {
-         if (!uniqueOnly || (matchedCommands.count(it->command) == 0))
-         {
-            matchingEntries.push_back(*it);
-            matchedCommands.insert(it->command);
-         }
-      }
-   }
-   
+   // find the most recent entries starting with the prefix
+   std::vector<HistoryEntry> matchingEntries = historyArchive().searchByPrefix(
+            prefix, static_cast<std::size_t>(maxEntries), uniqueOnly);
+
    // return json
    json::Object entriesJson;
    historyEntriesAsJson(matchingEntries, &entriesJson);
@@ -15,8 +15,12 @@
 
 #include "SessionHistoryArchive.hpp"
 
+#include <algorithm>
+#include <set>
 #include <string>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include <shared_core/Error.hpp>
 #include <core/Log.hpp>
 #include <shared_core/FilePath.hpp>
@@ -119,8 +123,32 @@ ReadCollectionAction readHistoryEntry(const std::string& line,
    }
 }
 
+uint32_t trigram(const std::string& text, std::size_t pos)
+{
+   return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+          (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+bool matchesAll(const std::string& command, const std::vector<std::string>& terms)
+{
+   for (const std::string& term : terms)
+   {
+      if (!boost::algorithm::contains(command, term))
+         return false;
+   }
+   return true;
+}
+
 } // anonymous namespace
 
+HistoryArchive::HistoryArchive()
+   : mainDatabaseOffset_(0),
+     rotatedLastWriteTime_(-1),
+     rotatedSize_(0)
+{
+}
+
 HistoryArchive& historyArchive()
 {
    static HistoryArchive instance;
@@ -129,15 +157,11 @@ HistoryArchive& historyArchive()
 
 Error HistoryArchive::add(const std::string& command)
 {
-   // reset the cache (since this write will invalidate the current one,
-   // no sense in keeping our cache around in memory)
-   entries_.clear();
-   entryCacheLastWriteTime_ = -1;
-
    // rotate if necessary
    rotateHistoryDatabase();
 
-   // write the entry to the file
+   // write the entry to the file (it's read back along with any entries
+   // written by other sessions the next time entries are requested)
    std::ostringstream ostrEntry;
    double currentTime = core::date_time::millisecondsSinceEpoch();
    writeEntry(currentTime, command, &ostrEntry);
@@ -154,53 +178,216 @@ const std::vector<HistoryEntry>& HistoryArchive::entries() const
    if (!historyDBPath.exists())
    {
       entries_.clear();
+      postings_.clear();
+      mainDatabaseOffset_ = 0;
+      rotatedLastWriteTime_ = -1;
+      return entries_;
    }
 
-   // otherwise check for divergent lastWriteTime and read the file
-   // if our internal list isn't up to date
-   else if (historyDBPath.getLastWriteTime() != entryCacheLastWriteTime_)
+   // if the database has been rotated (by us or another session) then read
+   // it all again; otherwise just read what's been appended
+   FilePath rotatedHistoryDBPath = historyDatabaseRotatedFilePath();
+   bool hasRotated = rotatedHistoryDBPath.exists();
+   std::time_t rotatedLastWriteTime = hasRotated ? rotatedHistoryDBPath.getLastWriteTime() : 0;
+   uintmax_t rotatedSize = hasRotated ? rotatedHistoryDBPath.getSize() : 0;
+   uintmax_t size = historyDBPath.getSize();
+
+   if (rotatedLastWriteTime != rotatedLastWriteTime_ ||
+       rotatedSize != rotatedSize_ ||
+       size < mainDatabaseOffset_)
    {
-      entries_.clear();
+      reload();
+      rotatedLastWriteTime_ = rotatedLastWriteTime;
+      rotatedSize_ = rotatedSize;
+   }
+   else if (size > mainDatabaseOffset_)
+   {
+      readEntries(historyDBPath, &mainDatabaseOffset_);
+   }
 
-      // establish a next index counter
-      int nextIndex = 0;
+   // return entries
+   return entries_;
+}
+
+std::vector<HistoryEntry> HistoryArchive::search(const std::vector<std::string>& terms,
+                                                 std::size_t maxEntries) const
+{
+   const std::vector<HistoryEntry>& allEntries = entries();
 
-      // first read from rotated file if it exists
-      FilePath rotatedHistoryDBPath = historyDatabaseRotatedFilePath();
-      if (rotatedHistoryDBPath.exists())
+   std::vector<HistoryEntry> matchingEntries;
+   bool noMatches = false;
+   const std::vector<int>* pCandidates = candidates(terms, &noMatches);
+   if (noMatches)
+      return matchingEntries;
+
+   if (pCandidates)
+   {
+      for (auto it = pCandidates->rbegin();
+           it != pCandidates->rend() && matchingEntries.size() < maxEntries;
+           ++it)
+      {
+         if (matchesAll(allEntries[*it].command, terms))
+            matchingEntries.push_back(allEntries[*it]);
+      }
+   }
+   else
+   {
+      for (auto it = allEntries.rbegin();
+           it != allEntries.rend() && matchingEntries.size() < maxEntries;
+           ++it)
       {
-         Error error = readCollectionFromFile<std::vector<HistoryEntry> >(
-                           rotatedHistoryDBPath,
-                           &entries_,
-                           boost::bind(readHistoryEntry, _1, _2, &nextIndex));
-         if (error)
-            LOG_ERROR(error);
+         if (matchesAll(it->command, terms))
+            matchingEntries.push_back(*it);
       }
+   }
 
+   return matchingEntries;
+}
 
-      // now read from main history db
-      std::vector<HistoryEntry> entries;
-      Error error = readCollectionFromFile<std::vector<HistoryEntry> >(
-                           historyDBPath,
-                           &entries,
-                           boost::bind(readHistoryEntry, _1, _2, &nextIndex));
-      if (error)
+std::vector<HistoryEntry> HistoryArchive::searchByPrefix(const std::string& prefix,
+                                                         std::size_t maxEntries,
+                                                         bool uniqueOnly) const
+{
+   const std::vector<HistoryEntry>& allEntries = entries();
+
+   std::vector<HistoryEntry> matchingEntries;
+   std::set<std::string> matchedCommands;
+   auto addIfMatches = [&](const HistoryEntry& entry)
+   {
+      if (boost::algorithm::starts_with(entry.command, prefix) &&
+          (!uniqueOnly || matchedCommands.count(entry.command) == 0))
       {
-         LOG_ERROR(error);
+         matchingEntries.push_back(entry);
+         matchedCommands.insert(entry.command);
       }
-      else
-      {
-         std::copy(entries.begin(),
-                   entries.end(),
-                   std::back_inserter(entries_));
+   };
+
+   bool noMatches = false;
+   const std::vector<int>* pCandidates = candidates(std::vector<std::string>(1, prefix),
+                                                    &noMatches);
+   if (noMatches)
+      return matchingEntries;
 
-         entryCacheLastWriteTime_ = historyDBPath.getLastWriteTime();
+   if (pCandidates)
+   {
+      for (auto it = pCandidates->rbegin();
+           it != pCandidates->rend() && matchingEntries.size() < maxEntries;
+           ++it)
+      {
+         addIfMatches(allEntries[*it]);
       }
+   }
+   else
+   {
+      for (auto it = allEntries.rbegin();
+           it != allEntries.rend() && matchingEntries.size() < maxEntries;
+           ++it)
+      {
+         addIfMatches(*it);
+      }
+   }
+
+   return matchingEntries;
+}
+
+void HistoryArchive::reload() const
+{
+   entries_.clear();
+   postings_.clear();
 
+   // first read from rotated file if it exists
+   FilePath rotatedHistoryDBPath = historyDatabaseRotatedFilePath();
+   if (rotatedHistoryDBPath.exists())
+   {
+      uintmax_t offset = 0;
+      readEntries(rotatedHistoryDBPath, &offset);
    }
 
-   // return entries
-   return entries_;
+   // now read from main history db
+   mainDatabaseOffset_ = 0;
+   readEntries(historyDatabaseFilePath(), &mainDatabaseOffset_);
+}
+
+void HistoryArchive::readEntries(const FilePath& filePath, uintmax_t* pOffset) const
+{
+   std::shared_ptr<std::istream> pStream;
+   Error error = filePath.openForRead(pStream);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return;
+   }
+
+   pStream->seekg(*pOffset);
+   std::string contents((std::istreambuf_iterator<char>(*pStream)),
+                        std::istreambuf_iterator<char>());
+
+   // only complete lines are read (a line may be in the middle of being
+   // written by another session)
+   std::size_t end = contents.find_last_of('\n');
+   if (end == std::string::npos)
+      return;
+
+   int nextIndex = static_cast<int>(entries_.size());
+   std::size_t pos = 0;
+   while (pos <= end)
+   {
+      std::size_t newline = contents.find('\n', pos);
+      HistoryEntry entry;
+      if (readHistoryEntry(contents.substr(pos, newline - pos), &entry, &nextIndex) ==
+          ReadCollectionAddLine)
+      {
+         addEntry(entry);
+      }
+      pos = newline + 1;
+   }
+
+   *pOffset += end + 1;
+}
+
+void HistoryArchive::addEntry(const HistoryEntry& entry) const
+{
+   int index = static_cast<int>(entries_.size());
+   entries_.push_back(entry);
+
+   const std::string& command = entry.command;
+   if (command.size() < 3)
+      return;
+
+   std::vector<uint32_t> trigrams;
+   trigrams.reserve(command.size() - 2);
+   for (std::size_t i = 0; i + 2 < command.size(); i++)
+      trigrams.push_back(trigram(command, i));
+   std::sort(trigrams.begin(), trigrams.end());
+   trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+   for (uint32_t trigram : trigrams)
+      postings_[trigram].push_back(index);
+}
+
+const std::vector<int>* HistoryArchive::candidates(const std::vector<std::string>& terms,
+                                                   bool* pNoMatches) const
+{
+   // the entries containing the rarest of the terms' trigrams (or null if
+   // no term is long enough to have any)
+   *pNoMatches = false;
+   const std::vector<int>* pCandidates = nullptr;
+   for (const std::string& term : terms)
+   {
+      for (std::size_t i = 0; i + 2 < term.size(); i++)
+      {
+         auto it = postings_.find(trigram(term, i));
+         if (it == postings_.end())
+         {
+            *pNoMatches = true;
+            return nullptr;
+         }
+
+         if (!pCandidates || it->second.size() < pCandidates->size())
+            pCandidates = &it->second;
+      }
+   }
+   return pCandidates;
 }
 
 void HistoryArchive::migrateRhistoryIfNecessary()
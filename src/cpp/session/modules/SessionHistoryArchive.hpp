@@ -16,7 +16,10 @@
 #ifndef SESSION_HISTORY_ARCHIVE_HPP
 #define SESSION_HISTORY_ARCHIVE_HPP
 
+#include <cstdint>
+#include <ctime>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/utility.hpp>
@@ -51,7 +54,7 @@ HistoryArchive& historyArchive();
 class HistoryArchive : boost::noncopyable
 {
 private:
-   HistoryArchive() : entryCacheLastWriteTime_(-1) {}
+   HistoryArchive();
    friend HistoryArchive& historyArchive();
 
 public:
@@ -61,9 +64,35 @@ public:
    core::Error add(const std::string& command);
    const std::vector<HistoryEntry>& entries() const;
 
+   // the most recent entries (newest first) which contain all of the
+   // passed terms
+   std::vector<HistoryEntry> search(const std::vector<std::string>& terms,
+                                    std::size_t maxEntries) const;
+
+   // the most recent entries (newest first) which start with prefix,
+   // optionally skipping repeats of a command
+   std::vector<HistoryEntry> searchByPrefix(const std::string& prefix,
+                                            std::size_t maxEntries,
+                                            bool uniqueOnly) const;
+
 private:
-   mutable time_t entryCacheLastWriteTime_;
+   void reload() const;
+   void readEntries(const core::FilePath& filePath, uintmax_t* pOffset) const;
+   void addEntry(const HistoryEntry& entry) const;
+   const std::vector<int>* candidates(const std::vector<std::string>& terms,
+                                      bool* pNoMatches) const;
+
+   // the databases are only ever appended to (until the main database is
+   // rotated), so we track how much of the main database has been read and
+   // read just the entries added since
+   mutable uintmax_t mainDatabaseOffset_;
+   mutable std::time_t rotatedLastWriteTime_;
+   mutable uintmax_t rotatedSize_;
    mutable std::vector<HistoryEntry> entries_;
+
+   // trigram => indexes of the entries whose command contains it (in
+   // ascending order)
+   mutable std::unordered_map<uint32_t, std::vector<int> > postings_;
 };
                        
 } // namespace history
@@ -0,0 +1,244 @@
+/*
+ * SessionPackageInformationCache.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionPackageInformationCache.hpp"
+
+#include <set>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/SafeConvert.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/Hash.hpp>
+#include <core/Log.hpp>
+#include <core/r_util/RPackageInfo.hpp>
+#include <core/system/System.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace r_packages {
+
+namespace {
+
+const char * const kEntryExtension = ".json";
+
+// entries are named <package>_<version>_<library hash>_<install time>; package
+// names and versions can't contain an underscore
+std::string libraryHash(const FilePath& libraryPath)
+{
+   return hash::crc32HexHash(libraryPath.getAbsolutePath());
+}
+
+std::string installationKey(const std::string& package,
+                            const std::string& libraryHash,
+                            const std::string& installTime)
+{
+   return package + "_" + libraryHash + "_" + installTime;
+}
+
+bool isEntryFor(const json::Object& information,
+                const PackageInstallation& installation)
+{
+   std::string package, version, library;
+   Error error = json::readObject(information,
+                                  "package", package,
+                                  "version", version,
+                                  "library", library);
+   if (error)
+      return false;
+
+   return package == installation.package &&
+          version == installation.version &&
+          library == installation.libraryPath.getAbsolutePath();
+}
+
+} // anonymous namespace
+
+bool findPackageInstallation(const std::string& package,
+                             const std::vector<FilePath>& libPaths,
+                             PackageInstallation* pInstallation)
+{
+   for (const FilePath& libPath : libPaths)
+   {
+      FilePath packagePath = libPath.completeChildPath(package);
+      FilePath descriptionPath = packagePath.completeChildPath("DESCRIPTION");
+      if (!descriptionPath.exists())
+         continue;
+
+      r_util::RPackageInfo info;
+      Error error = info.read(packagePath);
+      if (error)
+         return false;
+
+      pInstallation->package = package;
+      pInstallation->version = info.version();
+      pInstallation->libraryPath = libPath;
+      pInstallation->installTime = descriptionPath.getLastWriteTime();
+      return true;
+   }
+
+   return false;
+}
+
+PackageInformationCache::PackageInformationCache(
+      const FilePath& cachePath,
+      const FilePath& sharedCachePath)
+   : cachePath_(cachePath), sharedCachePath_(sharedCachePath)
+{
+}
+
+std::string PackageInformationCache::entryName(
+      const PackageInstallation& installation)
+{
+   return installation.package + "_" +
+          installation.version + "_" +
+          libraryHash(installation.libraryPath) + "_" +
+          safe_convert::numberToString(installation.installTime) +
+          kEntryExtension;
+}
+
+bool PackageInformationCache::read(const PackageInstallation& installation,
+                                   json::Object* pInformation) const
+{
+   std::string name = entryName(installation);
+   for (const FilePath& dir : { cachePath_, sharedCachePath_ })
+   {
+      if (dir.isEmpty())
+         continue;
+
+      FilePath entryPath = dir.completeChildPath(name);
+      if (!entryPath.exists())
+         continue;
+
+      std::string contents;
+      Error error = readStringFromFile(entryPath, &contents);
+      if (error)
+      {
+         LOG_ERROR(error);
+         continue;
+      }
+
+      // check that this is the entry we're after (and not, say, one for a
+      // library whose path has the same hash)
+      json::Value value;
+      if (value.parse(contents) ||
+          !value.isObject() ||
+          !isEntryFor(value.getObject(), installation))
+      {
+         continue;
+      }
+
+      *pInformation = value.getObject();
+      return true;
+   }
+
+   return false;
+}
+
+Error PackageInformationCache::write(const PackageInstallation& installation,
+                                     const json::Object& information) const
+{
+   Error error = cachePath_.ensureDirectory();
+   if (error)
+      return error;
+
+   // write to a temporary file and then move it into place, so that the
+   // entry is never seen partially written
+   std::string name = entryName(installation);
+   FilePath tempPath = cachePath_.completeChildPath(
+            "." + name + "-" + core::system::generateShortenedUuid());
+   error = writeStringToFile(tempPath, information.write());
+   if (error)
+   {
+      tempPath.removeIfExists();
+      return error;
+   }
+
+   error = tempPath.move(cachePath_.completeChildPath(name),
+                         FilePath::MoveDirect,
+                         true);
+   if (error)
+      tempPath.removeIfExists();
+   return error;
+}
+
+Error PackageInformationCache::removeStaleEntries(
+      const std::vector<FilePath>& libPaths,
+      const std::vector<PackageInstallation>& installed,
+      std::size_t* pRemoved) const
+{
+   if (pRemoved)
+      *pRemoved = 0;
+
+   if (!cachePath_.exists())
+      return Success();
+
+   std::set<std::string> libraryHashes;
+   for (const FilePath& libPath : libPaths)
+      libraryHashes.insert(libraryHash(libPath));
+
+   std::set<std::string> installedKeys;
+   for (const PackageInstallation& installation : installed)
+   {
+      installedKeys.insert(installationKey(
+                              installation.package,
+                              libraryHash(installation.libraryPath),
+                              safe_convert::numberToString(installation.installTime)));
+   }
+
+   std::vector<FilePath> entries;
+   Error error = cachePath_.getChildren(entries);
+   if (error)
+      return error;
+
+   for (const FilePath& entryPath : entries)
+   {
+      if (entryPath.getExtension() != kEntryExtension)
+         continue;
+
+      std::vector<std::string> parts;
+      std::string stem = entryPath.getStem();
+      boost::algorithm::split(parts, stem, boost::algorithm::is_any_of("_"));
+      if (parts.size() != 4)
+         continue;
+
+      // entries for libraries we don't know about (e.g. those of other
+      // projects) are left alone
+      if (!libraryHashes.count(parts[2]))
+         continue;
+
+      if (installedKeys.count(installationKey(parts[0], parts[2], parts[3])))
+         continue;
+
+      error = entryPath.remove();
+      if (error)
+         LOG_ERROR(error);
+      else if (pRemoved)
+         (*pRemoved)++;
+   }
+
+   return Success();
+}
+
+} // namespace r_packages
+} // namespace modules
+} // namespace session
+} // namespace rstudio
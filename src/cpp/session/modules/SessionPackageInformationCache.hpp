@@ -0,0 +1,101 @@
+/*
+ * SessionPackageInformationCache.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_PACKAGE_INFORMATION_CACHE_HPP
+#define SESSION_PACKAGE_INFORMATION_CACHE_HPP
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <shared_core/FilePath.hpp>
+#include <shared_core/json/Json.hpp>
+
+namespace rstudio {
+namespace core {
+   class Error;
+}
+}
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace r_packages {
+
+// An installed package: its name and version, the library it's installed in,
+// and when it was installed (the modification time of its DESCRIPTION, which
+// is rewritten whenever the package is reinstalled)
+struct PackageInstallation
+{
+   PackageInstallation() : installTime(0) {}
+
+   std::string package;
+   std::string version;
+   core::FilePath libraryPath;
+   std::time_t installTime;
+};
+
+// find the installation of package that would be loaded from the given
+// library paths (i.e. the one in the first library it's installed in)
+bool findPackageInstallation(const std::string& package,
+                             const std::vector<core::FilePath>& libPaths,
+                             PackageInstallation* pInstallation);
+
+// On disk cache of the information about a package used for completions (the
+// JSON object emitted by .rs.getPackageInformation), so that each session
+// needn't load every package it completes from in a separate R process.
+// Entries are keyed by package name, version and library path (and install
+// time), so they never need to be updated; they're only removed once stale.
+//
+// Entries are written to the cache path (typically within the user's scratch
+// path). They're also read from an optional shared path, which can be
+// populated from a user's cache so that all users share the same entries;
+// the shared path is never written to.
+class PackageInformationCache : boost::noncopyable
+{
+public:
+   explicit PackageInformationCache(
+         const core::FilePath& cachePath,
+         const core::FilePath& sharedCachePath = core::FilePath());
+
+   static std::string entryName(const PackageInstallation& installation);
+
+   // read the information cached for installation (if any)
+   bool read(const PackageInstallation& installation,
+             core::json::Object* pInformation) const;
+
+   core::Error write(const PackageInstallation& installation,
+                     const core::json::Object& information) const;
+
+   // remove entries for packages in the given libraries which no longer match
+   // any of the installed packages
+   core::Error removeStaleEntries(
+         const std::vector<core::FilePath>& libPaths,
+         const std::vector<PackageInstallation>& installed,
+         std::size_t* pRemoved = nullptr) const;
+
+private:
+   core::FilePath cachePath_;
+   core::FilePath sharedCachePath_;
+};
+
+} // namespace r_packages
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_PACKAGE_INFORMATION_CACHE_HPP
@@ -0,0 +1,166 @@
+/*
+ * SessionPackageInformationCacheTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "SessionPackageInformationCache.hpp"
+
+#include <shared_core/Error.hpp>
+
+#include <core/FileSerializer.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace r_packages {
+namespace tests {
+
+using namespace rstudio::core;
+
+namespace {
+
+void installPackage(const FilePath& libPath,
+                    const std::string& package,
+                    const std::string& version,
+                    std::time_t installTime)
+{
+   FilePath descriptionPath =
+         libPath.completeChildPath(package).completeChildPath("DESCRIPTION");
+   REQUIRE_FALSE(descriptionPath.getParent().ensureDirectory());
+   REQUIRE_FALSE(writeStringToFile(descriptionPath,
+                                   "Package: " + package + "\n"
+                                   "Version: " + version + "\n"));
+   descriptionPath.setLastWriteTime(installTime);
+}
+
+json::Object information(const PackageInstallation& installation)
+{
+   json::Array exports;
+   exports.push_back("mutate");
+
+   json::Object object;
+   object["package"] = installation.package;
+   object["version"] = installation.version;
+   object["library"] = installation.libraryPath.getAbsolutePath();
+   object["exports"] = exports;
+   return object;
+}
+
+PackageInstallation findInstallation(const std::string& package,
+                                     const std::vector<FilePath>& libPaths)
+{
+   PackageInstallation installation;
+   REQUIRE(findPackageInstallation(package, libPaths, &installation));
+   return installation;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Package information cache")
+{
+   FilePath root;
+   FilePath::tempFilePath(root);
+   REQUIRE_FALSE(root.ensureDirectory());
+
+   FilePath userLib = root.completeChildPath("user-lib");
+   FilePath siteLib = root.completeChildPath("site-lib");
+   std::vector<FilePath> libPaths = { userLib, siteLib };
+   installPackage(userLib, "dplyr", "1.0.0", 1000);
+   installPackage(siteLib, "dplyr", "0.8.5", 1000);
+   installPackage(siteLib, "rlang", "0.4.7", 1000);
+
+   PackageInformationCache cache(root.completeChildPath("cache"),
+                                 root.completeChildPath("shared"));
+
+   SECTION("Packages are found in library path order")
+   {
+      PackageInstallation dplyr = findInstallation("dplyr", libPaths);
+      CHECK(dplyr.version == "1.0.0");
+      CHECK(dplyr.libraryPath == userLib);
+      CHECK(dplyr.installTime == 1000);
+
+      CHECK(findInstallation("rlang", libPaths).libraryPath == siteLib);
+
+      PackageInstallation none;
+      CHECK_FALSE(findPackageInstallation("ggplot2", libPaths, &none));
+   }
+
+   SECTION("Entries are keyed by package, version and library")
+   {
+      PackageInstallation dplyr = findInstallation("dplyr", libPaths);
+      json::Object cached;
+      CHECK_FALSE(cache.read(dplyr, &cached));
+
+      REQUIRE_FALSE(cache.write(dplyr, information(dplyr)));
+      REQUIRE(cache.read(dplyr, &cached));
+      CHECK(cached == information(dplyr));
+
+      PackageInstallation siteDplyr = findInstallation("dplyr", { siteLib });
+      CHECK_FALSE(cache.read(siteDplyr, &cached));
+
+      // a reinstall of the same version is a different entry
+      installPackage(userLib, "dplyr", "1.0.0", 2000);
+      CHECK_FALSE(cache.read(findInstallation("dplyr", libPaths), &cached));
+   }
+
+   SECTION("Entries are read from the shared cache")
+   {
+      PackageInstallation rlang = findInstallation("rlang", libPaths);
+      PackageInformationCache shared(root.completeChildPath("shared"));
+      REQUIRE_FALSE(shared.write(rlang, information(rlang)));
+
+      json::Object cached;
+      REQUIRE(cache.read(rlang, &cached));
+      CHECK(cached == information(rlang));
+
+      // entries which don't describe the installation are ignored
+      PackageInstallation dplyr = findInstallation("dplyr", libPaths);
+      json::Object other = information(dplyr);
+      other["library"] = siteLib.getAbsolutePath();
+      REQUIRE_FALSE(shared.write(dplyr, other));
+      CHECK_FALSE(cache.read(dplyr, &cached));
+   }
+
+   SECTION("Stale entries are removed")
+   {
+      PackageInstallation dplyr = findInstallation("dplyr", libPaths);
+      PackageInstallation rlang = findInstallation("rlang", libPaths);
+      REQUIRE_FALSE(cache.write(dplyr, information(dplyr)));
+      REQUIRE_FALSE(cache.write(rlang, information(rlang)));
+
+      std::size_t removed = 0;
+      REQUIRE_FALSE(cache.removeStaleEntries(libPaths, { dplyr, rlang }, &removed));
+      CHECK(removed == 0);
+
+      // rlang is updated, and dplyr's library is no longer in use
+      installPackage(siteLib, "rlang", "0.4.8", 2000);
+      PackageInstallation updated = findInstallation("rlang", libPaths);
+      REQUIRE_FALSE(cache.removeStaleEntries({ siteLib }, { updated }, &removed));
+      CHECK(removed == 1);
+
+      json::Object cached;
+      CHECK_FALSE(cache.read(rlang, &cached));
+      CHECK(cache.read(dplyr, &cached));
+   }
+
+   root.remove();
+}
+
+} // namespace tests
+} // namespace r_packages
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -23,9 +23,11 @@
 #include <boost/bind.hpp>
 #include <boost/regex.hpp>
 #include <boost/format.hpp>
+#include <boost/make_shared.hpp>
 
 #include <shared_core/Error.hpp>
 #include <core/Exec.hpp>
+#include <core/collection/LruCache.hpp>
 
 #include <r/RSexp.hpp>
 #include <r/RExec.hpp>
@@ -63,7 +65,31 @@ public:
 
 private:
 
+   typedef boost::shared_ptr<const std::vector<std::string> > Packages;
+   typedef core::collection::LruCache<std::string, Packages> Cache;
+
+   static std::size_t weight(const std::string& contribUrl, const Packages& pPackages)
+   {
+      std::size_t weight = contribUrl.size();
+      for (const std::string& package : *pPackages)
+         weight += package.size();
+      return weight;
+   }
+
+   static Cache::Options options()
+   {
+      // repositories are updated over time, so lists eventually expire and
+      // are downloaded again; the number of repositories is usually small
+      // but each list can be large, so bound them by size
+      Cache::Options options;
+      options.maxWeight = 16 * 1024 * 1024;
+      options.weightFunction = weight;
+      options.timeToLive = boost::posix_time::hours(4);
+      return options;
+   }
+
    AvailablePackagesCache()
+      : cache_(options())
    {
    }
 
@@ -72,23 +98,23 @@ public:
    void insert(const std::string& contribUrl,
                const std::vector<std::string>& availablePackages)
    {
-      cache_[contribUrl] = availablePackages;
+      cache_.insert(contribUrl, boost::make_shared<const std::vector<std::string> >(availablePackages));
    }
 
    bool find(const std::string& contribUrl)
    {
-      return cache_.find(contribUrl) != cache_.end();
+      Packages pPackages;
+      return cache_.get(contribUrl, &pPackages);
    }
 
 
    bool lookup(const std::string& contribUrl,
                std::vector<std::string>* pAvailablePackages)
    {
-      std::map<std::string, std::vector<std::string> >::const_iterator it =
-                                                         cache_.find(contribUrl);
-      if (it != cache_.end())
+      Packages pPackages;
+      if (cache_.get(contribUrl, &pPackages))
       {
-         core::algorithm::append(pAvailablePackages, it->second);
+         core::algorithm::append(pAvailablePackages, *pPackages);
          return true;
       }
       else
@@ -99,7 +125,7 @@ public:
 
    void ensurePopulated(const std::string& contribUrl)
    {
-      if (cache_.find(contribUrl) != cache_.end())
+      if (find(contribUrl))
          return;
 
       // build code to execute
@@ -119,11 +145,11 @@ public:
       }
 
       // put them in the cache
-      cache_[contribUrl] = packages;
+      insert(contribUrl, packages);
    }
 
 private:
-   std::map<std::string, std::vector<std::string> > cache_;
+   Cache cache_;
 };
 
 void downloadAvailablePackages(const std::string& contribUrl,
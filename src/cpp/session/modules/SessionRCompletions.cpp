@@ -15,10 +15,15 @@
 
 #include "SessionRCompletions.hpp"
 
+#include <set>
+
 #include <gsl/gsl>
 
 #include <core/Exec.hpp>
 
+#include <shared_core/SafeConvert.hpp>
+
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/range/adaptors.hpp>
 
 #include <r/RSexp.hpp>
@@ -31,6 +36,7 @@
 #include <r/session/RSessionUtils.hpp>
 
 #include <core/system/FileScanner.hpp>
+#include <core/text/FileNameIndex.hpp>
 
 #include <core/r_util/RProjectFile.hpp>
 #include <core/r_util/RSourceIndex.hpp>
@@ -40,7 +46,9 @@
 #include <session/projects/SessionProjects.hpp>
 #include <session/SessionModuleContext.hpp>
 
+#include "SessionAsyncPackageInformation.hpp"
 #include "SessionCodeSearch.hpp"
+#include "SessionFileNameIndex.hpp"
 #include "SessionLibPathsIndexer.hpp"
 
 using namespace rstudio::core;
@@ -256,16 +264,54 @@ bool subsequenceFilter(const FileInfo& fileInfo,
    return false;
 }
 
-SEXP rs_scanFiles(SEXP pathSEXP,
-                  SEXP patternSEXP,
-                  SEXP maxCountSEXP)
+SEXP scanFilesResultsSEXP(const std::vector<std::string>& paths,
+                          bool moreAvailable)
 {
-   std::string path = r::sexp::asString(pathSEXP);
-   std::string pattern = r::sexp::asString(patternSEXP);
-   int maxCount = r::sexp::asInteger(maxCountSEXP);
+   r::sexp::Protect protect;
+   r::sexp::ListBuilder builder(&protect);
 
-   FilePath filePath(path);
-   FileInfo fileInfo(filePath);
+   builder.add("paths", paths);
+   builder.add("more_available", moreAvailable);
+
+   return r::sexp::create(builder, &protect);
+}
+
+// the file name index leaves out what the project's file monitor filters
+// out (hidden files, and ignored directories such as renv/library), so
+// completions which name those are found by scanning the directory instead
+bool useFileNameIndex(const FilePath& directory, const std::string& pattern)
+{
+   if (!file_name_index::isAvailable(directory))
+      return false;
+
+   // a hidden file or directory
+   if (boost::algorithm::starts_with(pattern, ".") ||
+       pattern.find("/.") != std::string::npos)
+   {
+      return false;
+   }
+
+   // a path within an ignored directory
+   std::size_t slash = pattern.rfind('/');
+   if (slash != std::string::npos)
+   {
+      FilePath parent = directory.completePath(pattern.substr(0, slash));
+      if (parent.isDirectory() && !file_name_index::isAvailable(parent))
+         return false;
+   }
+
+   return true;
+}
+
+// the first maxCount paths within path (matched as a subsequence of the
+// path relative to it)
+Error scanMatchingFiles(const std::string& path,
+                        const std::string& pattern,
+                        int maxCount,
+                        std::vector<std::string>* pPaths,
+                        bool* pMoreAvailable)
+{
+   FileInfo fileInfo((FilePath(path)));
    tree<FileInfo> tree;
 
    core::system::FileScannerOptions options;
@@ -273,30 +319,91 @@ SEXP rs_scanFiles(SEXP pathSEXP,
    options.yield = true;
 
    // Use a subsequence filter, and bail after too many files
-   std::vector<std::string> paths;
-   
    int count = 0;
-   bool moreAvailable = false;
    options.filter = boost::bind(subsequenceFilter,
                                 _1,
                                 pattern,
                                 gsl::narrow_cast<int>(path.length()),
                                 maxCount,
-                                &paths,
+                                pPaths,
                                 &count,
-                                &moreAvailable);
+                                pMoreAvailable);
 
-   Error error = scanFiles(fileInfo, options, &tree);
-   if (error)
-      return R_NilValue;
+   return scanFiles(fileInfo, options, &tree);
+}
 
-   r::sexp::Protect protect;
-   r::sexp::ListBuilder builder(&protect);
+SEXP rs_scanFiles(SEXP pathSEXP,
+                  SEXP patternSEXP,
+                  SEXP /* asRelativePathSEXP */,
+                  SEXP maxCountSEXP)
+{
+   std::string path = r::sexp::asString(pathSEXP);
+   std::string pattern = r::sexp::asString(patternSEXP);
+   int maxCount = r::sexp::asInteger(maxCountSEXP);
 
-   builder.add("paths", paths);
-   builder.add("more_available", moreAvailable);
+   FilePath filePath(path);
 
-   return r::sexp::create(builder, &protect);
+   std::vector<std::string> paths;
+   bool moreAvailable = false;
+
+   // use the project's file name index when it covers this path, returning
+   // the best matches rather than the first ones found
+   if (useFileNameIndex(filePath, pattern))
+   {
+      std::vector<text::FileNameIndex::Match> matches;
+      file_name_index::search(pattern,
+                              filePath,
+                              text::FileNameIndex::All,
+                              true,
+                              safe_convert::numberTo<int, std::size_t>(maxCount, 0),
+                              text::FileNameIndex::Filter(),
+                              &matches,
+                              &moreAvailable);
+
+      for (const text::FileNameIndex::Match& match : matches)
+         paths.push_back(match.path);
+
+      if (moreAvailable || gsl::narrow_cast<int>(paths.size()) >= maxCount)
+         return scanFilesResultsSEXP(paths, moreAvailable);
+
+      // the index has every match it covers, but a scan would also have
+      // found matches within hidden and ignored directories (e.g. "lib" for
+      // renv/library), so scan too and add those after the indexed ones
+      // (the scan finds the indexed matches again, so it's allowed as many
+      // more)
+      std::vector<std::string> scanned;
+      bool moreScanned = false;
+      Error error = scanMatchingFiles(path,
+                                      pattern,
+                                      maxCount + gsl::narrow_cast<int>(paths.size()),
+                                      &scanned,
+                                      &moreScanned);
+      if (error)
+         return scanFilesResultsSEXP(paths, moreAvailable);
+
+      std::set<std::string> indexed(paths.begin(), paths.end());
+      for (const std::string& scannedPath : scanned)
+      {
+         if (indexed.count(scannedPath))
+            continue;
+
+         if (gsl::narrow_cast<int>(paths.size()) >= maxCount)
+         {
+            moreAvailable = true;
+            break;
+         }
+         paths.push_back(scannedPath);
+      }
+      moreAvailable = moreAvailable || moreScanned;
+
+      return scanFilesResultsSEXP(paths, moreAvailable);
+   }
+
+   Error error = scanMatchingFiles(path, pattern, maxCount, &paths, &moreAvailable);
+   if (error)
+      return R_NilValue;
+
+   return scanFilesResultsSEXP(paths, moreAvailable);
 }
 
 SEXP rs_isSubsequence(SEXP stringsSEXP, SEXP querySEXP)
@@ -515,7 +622,8 @@ Error initialize() {
    using namespace module_context;
    ExecBlock initBlock;
    initBlock.addFunctions()
-         (bind(sourceModuleRFile, "SessionRCompletions.R"));
+         (bind(sourceModuleRFile, "SessionRCompletions.R"))
+         (AsyncPackageInformationProcess::initialize);
    return initBlock.execute();
 }
 
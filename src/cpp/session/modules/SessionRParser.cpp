@@ -102,7 +102,7 @@ Error safeEvaluateString(const std::string& string,
 
 bool isDataTableSingleBracketCall(RTokenCursor& cursor)
 {
-   if (!cursor.contentEquals(L"["))
+   if (!cursor.contentEquals("["))
       return false;
    
    RTokenCursor startCursor = cursor.clone();
@@ -116,9 +116,9 @@ bool isDataTableSingleBracketCall(RTokenCursor& cursor)
       return false;
    
    // Get the string encompassing the call
-   std::string objectString = string_utils::wideToUtf8(std::wstring(
+   std::string objectString = std::string(
             startCursor.currentToken().begin(),
-            cursor.currentToken().begin()));
+            cursor.currentToken().begin());
    
    if (objectString.find('(') != std::string::npos)
       return false;
@@ -253,7 +253,7 @@ SEXP resolveObjectAssociatedWithCall(RTokenCursor cursor,
       DEBUG("Resolving as generic evaluation");
       if (pCacheable) *pCacheable = false;
       
-      std::string call = string_utils::wideToUtf8(cursor.getEvaluationAssociatedWithCall());
+      std::string call = cursor.getEvaluationAssociatedWithCall();
       
       // Don't evaluate nested function calls.
       if (call.find('(') != std::string::npos)
@@ -283,25 +283,6 @@ SEXP resolveFunctionAssociatedWithCall(RTokenCursor cursor,
    return resolveObjectAssociatedWithCall(cursor, pProtect, true, pCacheable);
 }
 
-std::set<std::wstring> makeWideNsePrimitives()
-{
-   std::set<std::wstring> wide;
-   const std::set<std::string>& nsePrimitives = r::sexp::nsePrimitives();
-   
-   for (const std::string& primitive : nsePrimitives)
-   {
-      wide.insert(string_utils::utf8ToWide(primitive));
-   }
-
-   return wide;
-}
-
-const std::set<std::wstring>& wideNsePrimitives()
-{
-   static std::set<std::wstring> wideNsePrimitives = makeWideNsePrimitives();
-   return wideNsePrimitives;
-}
-
 bool maybePerformsNSE(RTokenCursor cursor)
 {
    if (!cursor.nextSignificantToken().isType(RToken::LPAREN))
@@ -314,7 +295,7 @@ bool maybePerformsNSE(RTokenCursor cursor)
    if (!endCursor.fwdToMatchingToken())
       return false;
    
-   const std::set<std::wstring>& nsePrimitives = wideNsePrimitives();
+   const std::set<std::string>& nsePrimitives = r::sexp::nsePrimitives();
    
    const RTokens& rTokens = cursor.tokens();
    std::size_t offset = cursor.offset();
@@ -414,7 +395,7 @@ bool mightPerformNonstandardEvaluation(const RTokenCursor& origin,
    }
    
    // Handle some special cases first.
-   if (isSymbolNamed(cursor, L"::") || isSymbolNamed(cursor, L":::"))
+   if (isSymbolNamed(cursor, "::") || isSymbolNamed(cursor, ":::"))
       return true;
    
    // Drop down into R.
@@ -456,52 +437,29 @@ std::string& complement(const std::string& bracket)
    return s_complements[bracket];
 }
 
-std::map<std::wstring, std::wstring> makeWideComplementMap()
-{
-   std::map<std::wstring, std::wstring> m;
-   m[L"["]  = L"]";
-   m[L"("]  = L")";
-   m[L"{"]  = L"}";
-   m[L"[["] = L"]]";
-   m[L"]"]  = L"[";
-   m[L")"]  = L"(";
-   m[L"}"]  = L"{";
-   m[L"]]"] = L"[[";
-   return m;
-}
-
-static std::map<std::wstring, std::wstring> s_wcomplements =
-      makeWideComplementMap();
-
-std::wstring& wideComplement(const std::wstring& bracket)
-{
-   return s_wcomplements[bracket];
-
-} // end anonymous namespace
-
 namespace {
 
-std::wstring typeToWideString(char type)
+std::string typeToString(char type)
 {
-        if (type == RToken::LPAREN) return L"LPAREN";
-   else if (type == RToken::RPAREN) return L"RPAREN";
-   else if (type == RToken::LBRACKET) return L"LBRACKET";
-   else if (type == RToken::RBRACKET) return L"RBRACKET";
-   else if (type == RToken::LBRACE) return L"LBRACE";
-   else if (type == RToken::RBRACE) return L"RBRACE";
-   else if (type == RToken::COMMA) return L"COMMA";
-   else if (type == RToken::SEMI) return L"SEMI";
-   else if (type == RToken::WHITESPACE) return L"WHITESPACE";
-   else if (type == RToken::STRING) return L"STRING";
-   else if (type == RToken::NUMBER) return L"NUMBER";
-   else if (type == RToken::ID) return L"ID";
-   else if (type == RToken::OPER) return L"OPER";
-   else if (type == RToken::UOPER) return L"UOPER";
-   else if (type == RToken::ERR) return L"ERR";
-   else if (type == RToken::LDBRACKET) return L"LDBRACKET";
-   else if (type == RToken::RDBRACKET) return L"RDBRACKET";
-   else if (type == RToken::COMMENT) return L"COMMENT";
-   else return L"<unknown>";
+        if (type == RToken::LPAREN) return "LPAREN";
+   else if (type == RToken::RPAREN) return "RPAREN";
+   else if (type == RToken::LBRACKET) return "LBRACKET";
+   else if (type == RToken::RBRACKET) return "RBRACKET";
+   else if (type == RToken::LBRACE) return "LBRACE";
+   else if (type == RToken::RBRACE) return "RBRACE";
+   else if (type == RToken::COMMA) return "COMMA";
+   else if (type == RToken::SEMI) return "SEMI";
+   else if (type == RToken::WHITESPACE) return "WHITESPACE";
+   else if (type == RToken::STRING) return "STRING";
+   else if (type == RToken::NUMBER) return "NUMBER";
+   else if (type == RToken::ID) return "ID";
+   else if (type == RToken::OPER) return "OPER";
+   else if (type == RToken::UOPER) return "UOPER";
+   else if (type == RToken::ERR) return "ERR";
+   else if (type == RToken::LDBRACKET) return "LDBRACKET";
+   else if (type == RToken::RDBRACKET) return "RDBRACKET";
+   else if (type == RToken::COMMENT) return "COMMENT";
+   else return "<unknown>";
 }
 
 #define RSTUDIO_PARSE_ACTION(__CURSOR__, __STATUS__, __ACTION__)               \
@@ -534,7 +492,7 @@ std::wstring typeToWideString(char type)
    do                                                                          \
    {                                                                           \
       MOVE_TO_NEXT_TOKEN(__CURSOR__, __STATUS__);                              \
-      if (isWhitespace(__CURSOR__) && !__CURSOR__.contentContains(L'\n'))      \
+      if (isWhitespace(__CURSOR__) && !__CURSOR__.contentContains('\n'))       \
          __STATUS__.lint().unnecessaryWhitespace(__CURSOR__);                  \
       FWD_OVER_WHITESPACE_AND_COMMENTS(__CURSOR__, __STATUS__);                \
    } while (0)
@@ -572,7 +530,7 @@ std::wstring typeToWideString(char type)
       if (!__CURSOR__.contentEquals(__CONTENT__))                              \
       {                                                                        \
          DEBUG("(" << __LINE__ << "): Expected "                               \
-                   << string_utils::wideToUtf8(__CONTENT__));                  \
+                   << __CONTENT__);                                            \
          __STATUS__.lint().unexpectedToken(__CURSOR__, __CONTENT__);           \
          return;                                                               \
       }                                                                        \
@@ -584,9 +542,9 @@ std::wstring typeToWideString(char type)
       if (!__CURSOR__.isType(__TYPE__))                                        \
       {                                                                        \
          DEBUG("(" << __LINE__ << "): Expected "                               \
-                   << string_utils::wideToUtf8(typeToWideString(__TYPE__)));   \
+                   << typeToString(__TYPE__));                                 \
          __STATUS__.lint().unexpectedToken(                                    \
-             __CURSOR__, L"'" + typeToWideString(__TYPE__) + L"'");            \
+             __CURSOR__, "'" + typeToString(__TYPE__) + "'");                  \
          if (__RETURN__) return;                                               \
       }                                                                        \
    } while (0)
@@ -597,7 +555,7 @@ std::wstring typeToWideString(char type)
       if (__CURSOR__.isType(__TYPE__))                                         \
       {                                                                        \
          DEBUG("(" << __LINE__ << "): Unexpected "                             \
-                   << string_utils::wideToUtf8(typeToWideString(__TYPE__)));   \
+                   << typeToString(__TYPE__));                                 \
          __STATUS__.lint().unexpectedToken(__CURSOR__);                        \
          if (__RETURN__) return;                                               \
       }                                                                        \
@@ -659,12 +617,12 @@ void lookAheadAndWarnOnUsagesOfSymbol(const RTokenCursor& startCursor,
                                       ParseStatus& status)
 {
    std::size_t braceBalance = 0;
-   std::wstring symbol = startCursor.content();
+   std::string symbol = startCursor.content();
    
    do
    {
       // Skip over 'for' arg-list
-      if (clone.contentEquals(L"for"))
+      if (clone.contentEquals("for"))
       {
          if (!clone.moveToNextSignificantToken())
             return;
@@ -676,7 +634,7 @@ void lookAheadAndWarnOnUsagesOfSymbol(const RTokenCursor& startCursor,
       }
       
       // Skip over functions
-      if (clone.contentEquals(L"function"))
+      if (clone.contentEquals("function"))
       {
          if (!clone.moveToNextSignificantToken())
             return;
@@ -784,7 +742,7 @@ void getNamedUnnamedArguments(RTokenCursor cursor,
    {
       std::string argName;
       bool isNamedArgument = false;
-      std::wstring::const_iterator begin = cursor.begin();
+      std::string::const_iterator begin = cursor.begin();
 
       if (cursor.isLookingAtNamedArgumentInFunctionCall())
       {
@@ -813,12 +771,12 @@ void getNamedUnnamedArguments(RTokenCursor cursor,
       if (isNamedArgument)
       {
          (*pNamedArguments)[argName] =
-               string_utils::wideToUtf8(std::wstring(begin, cursor.begin()));
+               std::string(begin, cursor.begin());
       }
       else
       {
          pUnnamedArguments->push_back(
-                  string_utils::wideToUtf8(std::wstring(begin, cursor.begin())));
+                  std::string(begin, cursor.begin()));
       }
 
    } while (cursor.isType(RToken::COMMA) && cursor.moveToNextSignificantToken());
@@ -854,13 +812,13 @@ void handleIdentifier(RTokenCursor& cursor,
    if (cursor.previousSignificantToken(1).isType(RToken::LPAREN))
    {
       const RToken& callToken = cursor.previousSignificantToken(2);
-      if (callToken.isType(RToken::ID) && callToken.contentEquals(L"data"))
+      if (callToken.isType(RToken::ID) && callToken.contentEquals("data"))
          status.node()->addDefinedSymbol(cursor);
    }
    
    // Don't add references to '.' -- in most situations where it's used,
    // it's for NSE (e.g. magrittr pipes)
-   if (status.isInArgumentList() && cursor.contentEquals(L"."))
+   if (status.isInArgumentList() && cursor.contentEquals("."))
       return;
    
    if (cursor.isType(RToken::ID) ||
@@ -924,7 +882,7 @@ void handleString(RTokenCursor& cursor,
 {
    // if this is a string within a call to glue,
    // mark used variables as appropriate
-   if (status.currentFunctionName() == L"glue")
+   if (status.currentFunctionName() == "glue")
    {
       const std::string& value = cursor.contentAsUtf8();
       boost::regex re("{([^}]+)}");
@@ -956,7 +914,7 @@ void extractFormal(
    std::string formalName;
    
    bool hasDefaultValue = false;
-   std::wstring::const_iterator defaultValueStart;
+   std::string::const_iterator defaultValueStart;
    
    if (cursor.isType(RToken::ID))
       formalName = cursor.contentAsUtf8();
@@ -964,7 +922,7 @@ void extractFormal(
    if (!cursor.moveToNextSignificantToken())
       return;
    
-   if (cursor.contentEquals(L"="))
+   if (cursor.contentEquals("="))
    {
       if (!cursor.moveToNextSignificantToken())
          return;
@@ -989,8 +947,7 @@ void extractFormal(
    FormalInformation info(formalName);
    
    if (hasDefaultValue)
-      info.setDefaultValue(string_utils::wideToUtf8(
-                              std::wstring(defaultValueStart, cursor.begin())));
+      info.setDefaultValue(std::string(defaultValueStart, cursor.begin()));
    
    pInfo->addFormal(info);
    
@@ -1014,7 +971,7 @@ bool extractInfoFromFunctionDefinition(
 {
    do
    {
-      if (cursor.contentEquals(L"function"))
+      if (cursor.contentEquals("function"))
          break;
       
    } while (cursor.moveToNextSignificantToken());
@@ -1148,7 +1105,7 @@ FunctionInformation getInfoAssociatedWithFunctionAtCursor(
    
    // Get the formals associated with this function.
    FunctionInformation info(
-            string_utils::wideToUtf8(cursor.getEvaluationAssociatedWithCall()),
+            cursor.getEvaluationAssociatedWithCall(),
             r::sexp::environmentName(functionSEXP));
    
    Error error = r::sexp::extractFunctionInfo(
@@ -1357,30 +1314,30 @@ public:
    {
       // `old.packages()` delegates the 'method' formal even when missing
       // same with `available.packages()`
-      if (cursor.contentEquals(L"old.packages") ||
-          cursor.contentEquals(L"available.packages"))
+      if (cursor.contentEquals("old.packages") ||
+          cursor.contentEquals("available.packages"))
       {
          pCall->functionInfo().infoForFormal("method").setMissingnessHandled(true);
       }
       
       // `file_test` allows 'y' to be missing, and is only used when
       // 'op' is a 'binary-accepting' operator
-      if (cursor.contentEquals(L"file_test"))
+      if (cursor.contentEquals("file_test"))
          pCall->functionInfo().infoForFormal("y").setMissingnessHandled(true);
       
       // 'globalVariables' doens't need 'package' argument
-      if (cursor.contentEquals(L"globalVariables") ||
-          cursor.contentEquals(L"vignetteEngine"))
+      if (cursor.contentEquals("globalVariables") ||
+          cursor.contentEquals("vignetteEngine"))
       {
          pCall->functionInfo().infoForFormal("package").setMissingnessHandled(true);
          pCall->functionInfo().infoForFormal("name").setMissingnessHandled(true);
          pCall->functionInfo().infoForFormal("tangle").setMissingnessHandled(true);
       }
       
-      if (cursor.contentEquals(L"as.lazy_dots"))
+      if (cursor.contentEquals("as.lazy_dots"))
           pCall->functionInfo().infoForFormal("env").setMissingnessHandled(true);
       
-      if (cursor.contentEquals(L"trace"))
+      if (cursor.contentEquals("trace"))
       {
          std::vector<FormalInformation>& formals = pCall->functionInfo().formals();
          for (FormalInformation& formal : formals)
@@ -1389,25 +1346,25 @@ public:
          }
       }
       
-      if (cursor.contentEquals(L"txtProgressBar"))
+      if (cursor.contentEquals("txtProgressBar"))
       {
          pCall->functionInfo().infoForFormal("label").setMissingnessHandled(true);
          pCall->functionInfo().infoForFormal("title").setMissingnessHandled(true);
       }
       
-      if (cursor.contentEquals(L"spin"))
+      if (cursor.contentEquals("spin"))
          pCall->functionInfo().infoForFormal("hair").setMissingnessHandled(true);
       
-      if (cursor.contentEquals(L"read_chunk"))
+      if (cursor.contentEquals("read_chunk"))
          pCall->functionInfo().infoForFormal("path").setMissingnessHandled(true);
       
-      if (cursor.contentEquals(L"fig_path") ||
-          cursor.contentEquals(L"fig_chunk"))
+      if (cursor.contentEquals("fig_path") ||
+          cursor.contentEquals("fig_chunk"))
       {
          pCall->functionInfo().infoForFormal("number").setMissingnessHandled(true);
       }
       
-      if (cursor.contentEquals(L"need"))
+      if (cursor.contentEquals("need"))
          pCall->functionInfo().infoForFormal("label").setMissingnessHandled(true);
    }
    
@@ -1473,14 +1430,34 @@ private:
 
 void doParse(RTokenCursor&, ParseStatus&);
 
+namespace {
+
+// tokens of recently parsed documents, updated incrementally as the
+// documents are edited
+RTokensCache& tokensCache()
+{
+   static RTokensCache instance(RTokens::StripComments);
+   return instance;
+}
+
+} // end anonymous namespace
+
 ParseResults parse(const FilePath& filePath,
-                   const std::wstring& rCode,
-                   const ParseOptions& parseOptions)
+                   const std::string& rCode,
+                   const ParseOptions& parseOptions,
+                   const std::string& documentId)
 {
-   if (rCode.empty() || rCode.find_first_not_of(L" \r\n\t\v") == std::string::npos)
+   if (rCode.empty() || rCode.find_first_not_of(" \r\n\t\v") == std::string::npos)
       return ParseResults();
    
-   RTokens rTokens(rCode, RTokens::StripComments);
+   // documents are identified by id where available (so that unsaved
+   // documents are also cached) or else by path
+   std::string key = documentId.empty() ? filePath.getAbsolutePath() : documentId;
+   boost::shared_ptr<const RTokens> pTokens = key.empty() ?
+            boost::make_shared<const RTokens>(rCode, RTokens::StripComments) :
+            tokensCache().tokenize(key, rCode);
+   
+   const RTokens& rTokens = *pTokens;
    if (rTokens.empty())
       return ParseResults();
    
@@ -1502,15 +1479,6 @@ ParseResults parse(const FilePath& filePath,
 
 ParseResults parse(const std::string& rCode,
                    const ParseOptions& parseOptions)
-{
-   return parse(
-            FilePath(),
-            string_utils::utf8ToWide(rCode),
-            parseOptions);
-}
-
-ParseResults parse(const std::wstring& rCode,
-                   const ParseOptions& parseOptions)
 {
    return parse(
             FilePath(),
@@ -1530,9 +1498,10 @@ ParseResults parse(const FilePath &filePath, const ParseOptions &parseOptions)
    
    return parse(
             filePath,
-            string_utils::utf8ToWide(contents),
+            contents,
             parseOptions);
 }
+
 namespace {
 
 bool closesArgumentList(const RTokenCursor& cursor,
@@ -1568,7 +1537,7 @@ void checkVariableAssignmentInArgumentList(RTokenCursor cursor,
    if (!cursor.moveToNextSignificantToken())
       return;
    
-   if (!cursor.contentEquals(L"<-"))
+   if (!cursor.contentEquals("<-"))
       return;
    
    status.lint().unexpectedAssignmentInArgumentList(cursor);
@@ -1580,11 +1549,11 @@ void checkBinaryOperatorWhitespace(RTokenCursor& cursor,
    
    // Allow both whitespace styles for certain binary operators, but
    // ensure that the whitespace around is consistent.
-   if (cursor.contentEquals(L'/') ||
-       cursor.contentEquals(L'*') ||
-       cursor.contentEquals(L'^') ||
-       cursor.contentEquals(L'?') ||
-       cursor.contentEquals(L"**"))
+   if (cursor.contentEquals('/') ||
+       cursor.contentEquals('*') ||
+       cursor.contentEquals('^') ||
+       cursor.contentEquals('?') ||
+       cursor.contentEquals("**"))
    {
       bool lhsWhitespace = isWhitespace(cursor.previousToken());
       bool rhsWhitespace = isWhitespace(cursor.nextToken());
@@ -1600,7 +1569,7 @@ void checkBinaryOperatorWhitespace(RTokenCursor& cursor,
    //
    // is bad style.
    bool isExtraction = isExtractionOperator(cursor);
-   bool isColon = cursor.contentEquals(L':');
+   bool isColon = cursor.contentEquals(':');
    if (isExtraction || isColon)
    {
       if (isWhitespace(cursor.previousToken()) ||
@@ -1641,7 +1610,7 @@ void addExtraScopedSymbolsForCall(RTokenCursor startCursor,
       if (!startCursor.moveToPreviousSignificantToken())
          return;
    
-   if (startCursor.contentEquals(L"setRefClass"))
+   if (startCursor.contentEquals("setRefClass"))
    {
       RTokenCursor endCursor = startCursor.clone();
       if (!endCursor.moveToNextSignificantToken())
@@ -1653,8 +1622,7 @@ void addExtraScopedSymbolsForCall(RTokenCursor startCursor,
       std::set<std::string> symbols;
       r::exec::RFunction getSetRefClassCall(".rs.getSetRefClassSymbols");
       getSetRefClassCall.addParam(
-               string_utils::wideToUtf8(
-                  std::wstring(startCursor.begin(), endCursor.end())));
+               std::string(startCursor.begin(), endCursor.end()));
       
       Error error = getSetRefClassCall.call(&symbols);
       if (error)
@@ -1669,7 +1637,7 @@ void addExtraScopedSymbolsForCall(RTokenCursor startCursor,
                endCursor.currentPosition());
    }
    
-   if (startCursor.contentEquals(L"R6Class"))
+   if (startCursor.contentEquals("R6Class"))
    {
       RTokenCursor endCursor = startCursor.clone();
       if (!endCursor.moveToNextSignificantToken())
@@ -1681,7 +1649,7 @@ void addExtraScopedSymbolsForCall(RTokenCursor startCursor,
       std::set<std::string> symbols;
       r::exec::RFunction getR6ClassSymbols(".rs.getR6ClassSymbols");
       getR6ClassSymbols.addParam(
-               string_utils::wideToUtf8(std::wstring(startCursor.begin(), endCursor.end())));
+               std::string(startCursor.begin(), endCursor.end()));
       
       Error error = getR6ClassSymbols.call(&symbols);
       if (error)
@@ -1754,7 +1722,7 @@ void validateFunctionCall(RTokenCursor cursor,
                startCursor.row(),
                startCursor.column(),
                endCursor.row(),
-               endCursor.column() + endCursor.length(),
+               endCursor.column() + endCursor.currentToken().width(),
                LintTypeWarning,
                prefix + prefixMatched);
    }
@@ -1774,14 +1742,14 @@ void validateFunctionCall(RTokenCursor cursor,
    {
       std::stringstream ss;
       ss << "too many arguments in call to '"
-         << string_utils::wideToUtf8(cursor.getEvaluationAssociatedWithCall())
+         << cursor.getEvaluationAssociatedWithCall()
          << "'";
       
       status.lint().add(
                startCursor.row(),
                startCursor.column(),
                endCursor.row(),
-               endCursor.column() + endCursor.length(),
+               endCursor.column() + endCursor.currentToken().width(),
                LintTypeError,
                ss.str());
    }
@@ -1813,7 +1781,7 @@ void validateFunctionCall(RTokenCursor cursor,
                      startCursor.row(),
                      startCursor.column(),
                      endCursor.row(),
-                     endCursor.column() + endCursor.length(),
+                     endCursor.column() + endCursor.currentToken().width(),
                      LintTypeWarning,
                      "argument '" + formalName + "' is missing, with no default");
          }
@@ -1835,7 +1803,7 @@ void validateFunctionCall(RTokenCursor cursor,
                startCursor.row(),
                startCursor.column(),
                endCursor.row(),
-               endCursor.column() + endCursor.length(),
+               endCursor.column() + endCursor.currentToken().width(),
                LintTypeError,
                message);
    }
@@ -1862,7 +1830,7 @@ bool skipFormulas(RTokenCursor& origin, ParseStatus& status)
       // Initial unary operators
       while (isValidAsUnaryOperator(cursor))
       {
-         if (cursor.contentEquals(L"~"))
+         if (cursor.contentEquals("~"))
             foundTilde = true;
 
          if (!cursor.moveToNextSignificantToken())
@@ -1905,7 +1873,7 @@ bool skipFormulas(RTokenCursor& origin, ParseStatus& status)
       if (!isBinaryOp(cursor))
          break;
 
-      if (cursor.contentEquals(L"~"))
+      if (cursor.contentEquals("~"))
          foundTilde = true;
 
       // Step over the operator and start again
@@ -1936,12 +1904,12 @@ void enterFunctionScope(RTokenCursor cursor,
    Position position = cursor.currentPosition();
    
    if (cursor.moveToPreviousSignificantToken() &&
-       cursor.contentEquals(L"function") &&
+       cursor.contentEquals("function") &&
        cursor.moveToPreviousSignificantToken() &&
        isLeftAssign(cursor) &&
        cursor.moveToPreviousSignificantToken())
    {
-      symbol = string_utils::wideToUtf8(cursor.getEvaluationAssociatedWithCall());
+      symbol = cursor.getEvaluationAssociatedWithCall();
       position = cursor.currentPosition();
    }
    
@@ -1960,12 +1928,12 @@ void checkIncorrectComparison(const RTokenCursor& origin,
                               ParseStatus& status)
 {
    const RToken& prev = origin.previousSignificantToken();
-   if (!(prev.contentEquals(L"==") || prev.contentEquals(L"!=")))
+   if (!(prev.contentEquals("==") || prev.contentEquals("!=")))
       return;
    
-   bool isNULL = origin.contentEquals(L"NULL");
+   bool isNULL = origin.contentEquals("NULL");
    bool isNA   = isNaKeyword(origin);
-   bool isNaN  = origin.contentEquals(L"NaN");
+   bool isNaN  = origin.contentEquals("NaN");
    
    bool needsSpecialHandling =
          isNULL || isNA || isNaN;
@@ -2016,7 +1984,7 @@ bool handleElseToken(RTokenCursor& cursor,
    //
    //    (1) Consume all statements (up to an if statement),
    //    (2) Verify that there is an if statement to consume.
-   if (!cursor.nextSignificantToken().contentEquals(L"else"))
+   if (!cursor.nextSignificantToken().contentEquals("else"))
       return false;
    
    // Move on to the 'else' token.
@@ -2147,14 +2115,14 @@ START:
          // Explicitly consume a '!!' or '!!!', to avoid warnings
          // about whitespace used with unquote and unquote-splice
          // operators.
-         if (cursor.contentEquals(L"!") &&
-             cursor.nextSignificantToken().contentEquals(L"!"))
+         if (cursor.contentEquals("!") &&
+             cursor.nextSignificantToken().contentEquals("!"))
          {
             do
             {
                MOVE_TO_NEXT_SIGNIFICANT_TOKEN(cursor, status);
             }
-            while (cursor.contentEquals(L"!"));
+            while (cursor.contentEquals("!"));
          }
          else
          {
@@ -2163,15 +2131,15 @@ START:
       }
       
       // Check for keywords.
-      if (cursor.contentEquals(L"function"))
+      if (cursor.contentEquals("function"))
          goto FUNCTION_START;
-      else if (cursor.contentEquals(L"for"))
+      else if (cursor.contentEquals("for"))
          goto FOR_START;
-      else if (cursor.contentEquals(L"while"))
+      else if (cursor.contentEquals("while"))
          goto WHILE_START;
-      else if (cursor.contentEquals(L"if"))
+      else if (cursor.contentEquals("if"))
          goto IF_START;
-      else if (cursor.contentEquals(L"repeat"))
+      else if (cursor.contentEquals("repeat"))
          goto REPEAT_START;
       
       // Left parenthesis.
@@ -2350,7 +2318,7 @@ START:
       
       // Newlines can end statements.
       if (status.isInControlFlowStatement() &&
-          cursor.contentContains(L'\n'))
+          cursor.contentContains('\n'))
       {
          status.popState();
          MOVE_TO_NEXT_SIGNIFICANT_TOKEN(cursor, status);
@@ -2402,7 +2370,7 @@ START:
          // they are significant in this context.
          if ((status.isInControlFlowStatement() ||
               status.currentState() == ParseStatus::ParseStateTopLevel) &&
-             (cursor.nextToken().contentContains(L'\n') ||
+             (cursor.nextToken().contentContains('\n') ||
               cursor.isAtEndOfDocument()))
          {
             while (status.isInControlFlowStatement())
@@ -2620,7 +2588,7 @@ ARGUMENT_LIST_END:
       
       // Newlines end function calls at the top level.
       else if (status.isAtTopLevel() &&
-               cursor.nextToken().contentContains(L'\n'))
+               cursor.nextToken().contentContains('\n'))
       {
          MOVE_TO_NEXT_SIGNIFICANT_TOKEN(cursor, status);
          goto START;
@@ -2659,7 +2627,7 @@ ARGUMENT_LIST_END:
 FUNCTION_START:
       
       DEBUG("** Function start ** " << cursor);
-      ENSURE_CONTENT(cursor, status, L"function");
+      ENSURE_CONTENT(cursor, status, "function");
       MOVE_TO_NEXT_SIGNIFICANT_TOKEN_WARN_ON_BLANK(cursor, status);
       ENSURE_TYPE(cursor, status, RToken::LPAREN, true);
       status.pushBracket(cursor);
@@ -2675,8 +2643,8 @@ FUNCTION_ARGUMENT_START:
       checkVariableAssignmentInArgumentList(cursor, status);
       
       if (cursor.isType(RToken::ID) &&
-          (cursor.nextSignificantToken().contentEquals(L"=") ||
-           cursor.nextSignificantToken().contentEquals(L"<-")))
+          (cursor.nextSignificantToken().contentEquals("=") ||
+           cursor.nextSignificantToken().contentEquals("<-")))
       {
          status.node()->addDefinedSymbol(cursor, status.node()->position());
          MOVE_TO_NEXT_SIGNIFICANT_TOKEN(cursor, status);
@@ -2710,7 +2678,7 @@ FUNCTION_ARGUMENT_LIST_END:
 FOR_START:
       
       DEBUG("For start: " << cursor);
-      ENSURE_CONTENT(cursor, status, L"for");
+      ENSURE_CONTENT(cursor, status, "for");
       MOVE_TO_NEXT_SIGNIFICANT_TOKEN_WARN_IF_NO_WHITESPACE(cursor, status);
       ENSURE_TYPE(cursor, status, RToken::LPAREN, true);
       status.pushBracket(cursor);
@@ -2718,7 +2686,7 @@ FOR_START:
       ENSURE_TYPE(cursor, status, RToken::ID, false);
       status.node()->addDefinedSymbol(cursor, cursor.currentPosition());
       MOVE_TO_NEXT_SIGNIFICANT_TOKEN(cursor, status);
-      ENSURE_CONTENT(cursor, status, L"in");
+      ENSURE_CONTENT(cursor, status, "in");
       MOVE_TO_NEXT_SIGNIFICANT_TOKEN(cursor, status);
       ENSURE_TYPE_NOT(cursor, status, RToken::RPAREN, false);
       status.pushState(ParseStatus::ParseStateForCondition);
@@ -2737,7 +2705,7 @@ FOR_CONDITION_END:
 WHILE_START:
       
       DEBUG("** While start **");
-      ENSURE_CONTENT(cursor, status, L"while");
+      ENSURE_CONTENT(cursor, status, "while");
       MOVE_TO_NEXT_SIGNIFICANT_TOKEN_WARN_IF_NO_WHITESPACE(cursor, status);
       ENSURE_TYPE(cursor, status, RToken::LPAREN, true);
       status.pushBracket(cursor);
@@ -2760,7 +2728,7 @@ WHILE_CONDITION_END:
 IF_START:
       
       DEBUG("** If start ** " << cursor);
-      ENSURE_CONTENT(cursor, status, L"if");
+      ENSURE_CONTENT(cursor, status, "if");
       MOVE_TO_NEXT_SIGNIFICANT_TOKEN_WARN_IF_NO_WHITESPACE(cursor, status);
       ENSURE_TYPE(cursor, status, RToken::LPAREN, true);
       status.pushBracket(cursor);
@@ -2784,7 +2752,7 @@ IF_CONDITION_END:
 REPEAT_START:
       
       DEBUG("** Repeat start ** " << cursor);
-      ENSURE_CONTENT(cursor, status, L"repeat");
+      ENSURE_CONTENT(cursor, status, "repeat");
       MOVE_TO_NEXT_SIGNIFICANT_TOKEN_WARN_IF_NO_WHITESPACE(cursor, status);
       BEGIN_EXPRESSION(cursor, status, ParseStatus::ParseStateRepeat, "missing expression following `repeat`");
       goto START;
@@ -246,7 +246,7 @@ struct LintItem
       : startRow(gsl::narrow_cast<int>(item.row())),
         startColumn(gsl::narrow_cast<int>(item.column())),
         endRow(gsl::narrow_cast<int>(item.row())),
-        endColumn(gsl::narrow_cast<int>(item.column() + item.length())),
+        endColumn(gsl::narrow_cast<int>(item.column() + item.width())),
         type(type),
         message(message)
    {}
@@ -314,12 +314,6 @@ public:
                   message);
    }
    
-   void unexpectedToken(const RToken& token,
-                        const std::wstring& expected)
-   {
-      unexpectedToken(token, string_utils::wideToUtf8(expected));
-   }
-   
    void unexpectedClosingBracket(const RToken& token)
    {
       addLintItem(token,
@@ -1036,7 +1030,7 @@ public:
         filePath_(filePath)
    {
       parseStateStack_.push(ParseStateTopLevel);
-      functionNames_.push(std::wstring(L""));
+      functionNames_.push(std::string(""));
    }
    
    ParseNode* node() { return pNode_; }
@@ -1108,7 +1102,7 @@ public:
    }
    
    void pushFunctionCallState(ParseState state,
-                              const std::wstring& functionName,
+                              const std::string& functionName,
                               bool isNseFunction)
    {
       DEBUG("Pushing state: " << stateAsString(state));
@@ -1117,7 +1111,7 @@ public:
       nseCallStack_.push(isNseFunction);
    }
    
-   const std::wstring& currentFunctionName() const
+   const std::string& currentFunctionName() const
    {
       return functionNames_.peek();
    }
@@ -1324,7 +1318,7 @@ public:
       return currentState() == ParseStateParenArgumentList;
    }
    
-   const Stack<std::wstring>& functionNames() const
+   const Stack<std::string>& functionNames() const
    {
       return functionNames_;
    }
@@ -1413,7 +1407,7 @@ private:
    LintItems lint_;
    ParseOptions parseOptions_;
    Stack<ParseState> parseStateStack_;
-   Stack<std::wstring> functionNames_;
+   Stack<std::string> functionNames_;
    
    // NOTE: Really prefer 'bool' here but that invokes the
    // std::vector<bool> data member which we want to avoid
@@ -1477,9 +1471,14 @@ private:
 };
 
 // Primary method ----
+//
+// the tokens of documents identified by documentId (or else by filePath)
+// are cached, so that re-parsing an edited document re-tokenizes only the
+// edited part of it
 ParseResults parse(const core::FilePath& filePath,
-                   const std::wstring& rCode,
-                   const ParseOptions& parseOptions = ParseOptions());
+                   const std::string& rCode,
+                   const ParseOptions& parseOptions = ParseOptions(),
+                   const std::string& documentId = std::string());
 
 // Useful aliases ----
 ParseResults parse(const core::FilePath& filePath,
@@ -1488,9 +1487,6 @@ ParseResults parse(const core::FilePath& filePath,
 ParseResults parse(const std::string& rCode,
                    const ParseOptions& parseOptions = ParseOptions());
 
-ParseResults parse(const std::wstring& rCode,
-                   const ParseOptions& parseOptions = ParseOptions());
-
 } // namespace rparser
 } // namespace modules
 } // namespace session
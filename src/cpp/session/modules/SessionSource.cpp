@@ -378,38 +378,20 @@ Error openDocument(const json::JsonRpcRequest& request,
    return Success();
 } 
 
-Error saveDocumentCore(const std::string& contents,
-                       const json::Value& jsonPath,
-                       const json::Value& jsonType,
-                       const json::Value& jsonEncoding,
-                       const json::Value& jsonFoldSpec,
-                       const json::Value& jsonChunkOutput,
-                       boost::shared_ptr<SourceDocument> pDoc)
+// update the document attributes (other than path and contents) sent
+// along with a save
+void updateDocumentAttributes(const json::Value& jsonType,
+                              const json::Value& jsonEncoding,
+                              const json::Value& jsonFoldSpec,
+                              const json::Value& jsonChunkOutput,
+                              boost::shared_ptr<SourceDocument> pDoc)
 {
-   // check whether we have a path and if we do get/resolve its value
-   std::string oldPath, path;
-   FilePath fullDocPath;
-   bool hasPath = json::isType<std::string>(jsonPath);
-   if (hasPath)
-   {
-      oldPath = pDoc->path();
-      path = jsonPath.getString();
-      fullDocPath = module_context::resolveAliasedPath(path);
-   }
-
-   // update dirty state: dirty if there was no path AND the new contents
-   // are different from the old contents (and was thus a content autosave
-   // as distinct from a fold-spec or scroll-position/selection autosave)
-   pDoc->setDirty(!hasPath && (contents != pDoc->contents()));
-   
    bool hasType = json::isType<std::string>(jsonType);
    if (hasType)
    {
       pDoc->setType(jsonType.getString());
    }
    
-   Error error;
-   
    bool hasEncoding = json::isType<std::string>(jsonEncoding);
    if (hasEncoding)
    {
@@ -428,11 +410,41 @@ Error saveDocumentCore(const std::string& contents,
    bool hasChunkOutput = json::isType<json::Array>(jsonChunkOutput);
    if (hasChunkOutput && pDoc->isRMarkdownDocument())
    {
-      error = rmarkdown::notebook::setChunkDefs(pDoc, 
+      Error error = rmarkdown::notebook::setChunkDefs(pDoc, 
             jsonChunkOutput.getArray());
       if (error)
          LOG_ERROR(error);
    }
+}
+
+Error saveDocumentCore(const std::string& contents,
+                       const json::Value& jsonPath,
+                       const json::Value& jsonType,
+                       const json::Value& jsonEncoding,
+                       const json::Value& jsonFoldSpec,
+                       const json::Value& jsonChunkOutput,
+                       boost::shared_ptr<SourceDocument> pDoc)
+{
+   // check whether we have a path and if we do get/resolve its value
+   std::string oldPath, path;
+   FilePath fullDocPath;
+   bool hasPath = json::isType<std::string>(jsonPath);
+   if (hasPath)
+   {
+      oldPath = pDoc->path();
+      path = jsonPath.getString();
+      fullDocPath = module_context::resolveAliasedPath(path);
+   }
+
+   // update dirty state: dirty if there was no path AND the new contents
+   // are different from the old contents (and was thus a content autosave
+   // as distinct from a fold-spec or scroll-position/selection autosave)
+   pDoc->setDirty(!hasPath && (contents != pDoc->contents()));
+   
+   updateDocumentAttributes(jsonType, jsonEncoding, jsonFoldSpec,
+                            jsonChunkOutput, pDoc);
+
+   Error error;
 
    // handle document (varies depending upon whether we have a path)
    if (hasPath)
@@ -602,27 +614,43 @@ Error saveDocumentDiff(const json::JsonRpcRequest& request,
    // to attempt a 'full' document save rather than just a diff-based save
    try
    {
-      std::string contents(pDoc->contents());
-      
       // NOTE: this flag denotes whether the front-end successfully
       // constructed a diff to be saved; we leave this in while still
       // going down this code path just to ensure that any code that
       // runs in response to a document save (even if that save fails)
       // still has a chance to run
+      bool hasChanges = false;
       if (valid)
       {
          // the offsets we receive are in bytes, so we can replace the contents
-         // of the string directly at the supplied offset + length (the contents
-         // string itself is already UTF-8 encoded)
-         contents.replace(offset, length, replacement);
+         // directly at the supplied offset + length (the contents are already
+         // UTF-8 encoded). the edit is applied in place (so its cost doesn't
+         // depend on the size of the document) and, for autosaves, persisted
+         // by appending it to the document's journal
+         if (offset < 0 || length < 0 ||
+             !pDoc->replaceContents(offset, length, replacement, &hasChanges))
+         {
+            return Success();
+         }
       }
 
-      // track if we're updating the document contents
-      bool hasChanges = contents != pDoc->contents();
-      error = saveDocumentCore(contents, jsonPath, jsonType, jsonEncoding,
-                               jsonFoldSpec, jsonChunkOutput, pDoc);
-      if (error)
-         return error;
+      if (hasPath)
+      {
+         // copy the contents since saving sets them anew
+         std::string contents(pDoc->contents());
+         error = saveDocumentCore(contents, jsonPath, jsonType, jsonEncoding,
+                                  jsonFoldSpec, jsonChunkOutput, pDoc);
+         if (error)
+            return error;
+      }
+      else
+      {
+         // content autosave (as for saveDocumentCore, the document is dirty
+         // only if its contents changed)
+         pDoc->setDirty(hasChanges);
+         updateDocumentAttributes(jsonType, jsonEncoding, jsonFoldSpec,
+                                  jsonChunkOutput, pDoc);
+      }
 
       // write to the source database (don't worry about writing document
       // contents if those have not changed)
@@ -52,19 +52,17 @@ namespace {
 boost::scoped_ptr<core::spelling::SpellingEngine> s_pSpellingEngine;
 
 // R function for testing & debugging
-SEXP rs_checkSpelling(SEXP wordSEXP)
+SEXP rs_checkSpelling(SEXP wordsSEXP)
 {
-   bool isCorrect;
-   std::string word = r::sexp::asString(wordSEXP);
-
-   Error error = s_pSpellingEngine->checkSpelling(word, &isCorrect);
-
-   // We'll return true here so as not to tie up the front end.
+   std::vector<std::string> words;
+   Error error = r::sexp::extract(wordsSEXP, &words, true);
    if (error)
-   {
       LOG_ERROR(error);
-      isCorrect = true;
-   }
+
+   // (words which can't be checked are reported as correct so as not to tie
+   // up the front end)
+   std::vector<bool> isCorrect;
+   s_pSpellingEngine->checkSpelling(words, &isCorrect);
 
    r::sexp::Protect rProtect;
    return r::sexp::create(isCorrect, &rProtect);
@@ -83,6 +81,13 @@ FilePath userDictionariesDir()
    return module_context::userScratchPath().completeChildPath("dictionaries");
 }
 
+// dictionaries compiled for quick lookups (memory mapped, so they're shared
+// by all of the user's sessions)
+FilePath compiledDictionariesDir()
+{
+   return userDictionariesDir().completeChildPath("compiled");
+}
+
 
 void syncSpellingEngineDictionaries()
 {
@@ -197,29 +202,30 @@ Error checkSpelling(const json::JsonRpcRequest& request,
    if (error)
       return error;
 
-   json::Array misspelledIndexes;
+   std::vector<std::string> wordsToCheck;
+   wordsToCheck.reserve(words.getSize());
    for (std::size_t i=0; i<words.getSize(); i++)
    {
       if (!json::isType<std::string>(words[i]))
       {
          BOOST_ASSERT(false);
+         wordsToCheck.push_back(std::string());
          continue;
       }
 
-      std::string word = words[i].getString();
-      bool isCorrect = true;
-      error = s_pSpellingEngine->checkSpelling(word, &isCorrect);
-      if (error)
-      {
-         // if we can't check a word, ignore it; some combinations of platform, non-ASCII
-         // characters, and locale are known to fail in iconv, and we don't want to put those
-         // failures in front of the user (we just won't be able to spell check those words)
-         LOG_ERROR(error);
-      }
-      else if (!isCorrect) 
-      {
+      wordsToCheck.push_back(words[i].getString());
+   }
+
+   // check the words together (the engine remembers recent verdicts, so
+   // words repeated within and across batches are only checked once)
+   std::vector<bool> isCorrect;
+   s_pSpellingEngine->checkSpelling(wordsToCheck, &isCorrect);
+
+   json::Array misspelledIndexes;
+   for (std::size_t i=0; i<isCorrect.size(); i++)
+   {
+      if (!isCorrect[i] && !wordsToCheck[i].empty())
          misspelledIndexes.push_back(gsl::narrow_cast<int>(i));
-      }
    }
 
    pResponse->setResult(misspelledIndexes);
@@ -420,7 +426,8 @@ Error initialize()
    HunspellSpellingEngine* pHunspell = new HunspellSpellingEngine(
       prefs::userPrefs().spellingDictionaryLanguage(),
       hunspellDictionaryManager(),
-      &r::util::iconvstr);
+      &r::util::iconvstr,
+      compiledDictionariesDir());
    s_pSpellingEngine.reset(pHunspell);
 
    // connect to user settings changed
@@ -205,6 +205,12 @@ void enqueueRefreshEvent()
    vcs_utils::enqueueRefreshEvent();
 }
 
+void onFilesChanged(const std::vector<core::system::FileChangeEvent>& events)
+{
+   if (git::isGitEnabled())
+      git::onFilesChanged(events);
+}
+
 
 
 core::Error initialize()
@@ -52,6 +52,9 @@ core::FilePath defaultSshKeyDir();
 
 void enqueueRefreshEvent();
 
+// note files which have changed (so that any cached status is refreshed)
+void onFilesChanged(const std::vector<core::system::FileChangeEvent>& events);
+
 core::Error fileStatus(const core::FilePath& filePath,
                        source_control::VCSStatus* pStatus);
 
@@ -15,20 +15,24 @@
 
 #include "DefinitionIndex.hpp"
 
-#include <deque>
+#include <algorithm>
 #include <gsl/gsl>
 
+#include <boost/thread/thread.hpp>
+
 #include <shared_core/FilePath.hpp>
 #include <core/DateTime.hpp>
 #include <core/PerformanceTimer.hpp>
 #include <core/FileSerializer.hpp>
 #include <core/libclang/LibClang.hpp>
+#include <core/Thread.hpp>
 #include <core/system/ProcessArgs.hpp>
 #include <session/IncrementalFileChangeHandler.hpp>
 
 #include <session/SessionModuleContext.hpp>
 #include <session/projects/SessionProjects.hpp>
 
+#include "DefinitionIndexFile.hpp"
 #include "RSourceIndex.hpp"
 #include "RCompilationDatabase.hpp"
 
@@ -45,17 +49,17 @@ namespace {
 // flag indicating whether we are initialized
 bool s_initialized = false;
 
-struct CppDefinitions
-{
-   std::string file;
-   std::time_t fileLastWrite;
-   std::deque<CppDefinition> definitions;
-};
-
-// store definitions by file
+// definitions of files indexed during this session, by file
 typedef std::map<std::string,CppDefinitions> DefinitionsByFile;
 DefinitionsByFile s_definitionsByFile;
 
+// definitions of files indexed before this session (searched on disk; files
+// indexed again this session are excluded from it)
+DefinitionIndexFile s_indexFile;
+
+// has anything changed since the index file was written?
+bool s_indexChanged = false;
+
 // visitor used to populate deque
 bool insertDefinition(const CppDefinition& definition,
                       CppDefinitions* pDefinitions)
@@ -64,8 +68,6 @@ bool insertDefinition(const CppDefinition& definition,
    return true;
 }
 
-typedef boost::function<bool(const CppDefinition&)> DefinitionVisitor;
-
 CXChildVisitResult cursorVisitor(CXCursor cxCursor,
                                  CXCursor,
                                  CXClientData clientData)
@@ -172,6 +174,122 @@ CXChildVisitResult cursorVisitor(CXCursor cxCursor,
    }
 }
 
+// files are parsed on a pool of worker threads, each with its own index
+// (the compilation arguments for a file are determined before handing it to
+// a worker, as doing so may require R; they include the precompiled header
+// for the package's R and Rcpp headers, built once and shared by every file)
+struct IndexJob
+{
+   std::string file;
+   std::time_t fileLastWrite;
+   std::vector<std::string> compileArgs;
+   int sequence;
+};
+
+struct IndexResult
+{
+   CppDefinitions definitions;
+   int sequence;
+};
+
+// (allocated on the heap and never freed, as workers may still be running
+// when the session exits)
+core::thread::ThreadsafeQueue<IndexJob>* s_pIndexJobs = nullptr;
+core::thread::ThreadsafeQueue<IndexResult>* s_pIndexResults = nullptr;
+
+// the latest job for each file being indexed (results of earlier jobs for a
+// file, e.g. if it changed again while being parsed, are discarded)
+std::map<std::string,int> s_pendingJobs;
+int s_nextJobSequence = 0;
+
+CppDefinitions indexFile(CXIndex index, const IndexJob& job)
+{
+   CppDefinitions definitions;
+   definitions.file = job.file;
+   definitions.fileLastWrite = job.fileLastWrite;
+
+   // get args in form clang expects
+   core::system::ProcessArgs argsArray(job.compileArgs);
+
+   // parse the translation unit (function bodies don't contain any
+   // definitions we index, so skip them)
+   CXTranslationUnit tu = libclang::clang().parseTranslationUnit(
+                         index,
+                         job.file.c_str(),
+                         argsArray.args(),
+                         gsl::narrow_cast<int>(argsArray.argCount()),
+                         nullptr, 0, // no unsaved files
+                         CXTranslationUnit_Incomplete |
+                         CXTranslationUnit_SkipFunctionBodies);
+   if (tu == nullptr)
+      return definitions;
+
+   // visit the cursors
+   DefinitionVisitor visitor = boost::bind(insertDefinition, _1, &definitions);
+   libclang::clang().visitChildren(
+        libclang::clang().getTranslationUnitCursor(tu),
+        cursorVisitor,
+        (CXClientData)&visitor);
+
+   libclang::clang().disposeTranslationUnit(tu);
+   return definitions;
+}
+
+void indexWorkerMain(bool verbose)
+{
+   CXIndex index = libclang::clang().createIndex(1 /* Exclude PCH */,
+                                                 verbose ? 1 : 0);
+   while (true)
+   {
+      IndexJob job;
+      if (!s_pIndexJobs->deque(&job, boost::posix_time::seconds(10)))
+         continue;
+
+      IndexResult result;
+      result.definitions = indexFile(index, job);
+      result.sequence = job.sequence;
+      s_pIndexResults->enque(result);
+   }
+}
+
+void ensureIndexWorkers()
+{
+   if (s_pIndexJobs)
+      return;
+
+   s_pIndexJobs = new core::thread::ThreadsafeQueue<IndexJob>();
+   s_pIndexResults = new core::thread::ThreadsafeQueue<IndexResult>();
+
+   // leave a core for the session (and don't take over large machines)
+   unsigned int cores = boost::thread::hardware_concurrency();
+   unsigned int workers = std::min(std::max(cores, 2u) - 1, 4u);
+   bool verbose = rSourceIndex().verbose() > 0;
+   for (unsigned int i = 0; i < workers; i++)
+      core::thread::safeLaunchThread(boost::bind(indexWorkerMain, verbose));
+}
+
+bool collectIndexResults()
+{
+   if (!s_pIndexResults)
+      return true;
+
+   IndexResult result;
+   while (s_pIndexResults->deque(&result))
+   {
+      const std::string& file = result.definitions.file;
+      std::map<std::string,int>::iterator it = s_pendingJobs.find(file);
+      if (it == s_pendingJobs.end() || it->second != result.sequence)
+         continue;
+      s_pendingJobs.erase(it);
+
+      s_indexFile.exclude(file);
+      s_definitionsByFile[file] = result.definitions;
+      s_indexChanged = true;
+   }
+
+   return true;
+}
+
 void fileChangeHandler(const core::system::FileChangeEvent& event)
 {
    // alias the filename
@@ -184,67 +302,47 @@ void fileChangeHandler(const core::system::FileChangeEvent& event)
    if (event.type() == core::system::FileChangeEvent::FileAdded)
    {
       // if we have a definition
+      std::time_t fileLastWrite = 0;
       DefinitionsByFile::const_iterator it = s_definitionsByFile.find(file);
       if (it != s_definitionsByFile.end())
-      {
-         // if the definition is fresh enough then bail
-         if (it->second.fileLastWrite >= event.fileInfo().lastWriteTime())
-            return;
-      }
-   }
+         fileLastWrite = it->second.fileLastWrite;
+      else
+         s_indexFile.fileLastWrite(file, &fileLastWrite);
 
-   // always remove existing definitions
-   s_definitionsByFile.erase(file);
+      // if the definition is fresh enough then bail
+      if (fileLastWrite != 0 && fileLastWrite >= event.fileInfo().lastWriteTime())
+         return;
+   }
 
-   // if this is an add or an update then re-index
+   // if this is an add or an update then re-index (existing definitions
+   // are kept until the file has been parsed)
    if (event.type() == core::system::FileChangeEvent::FileAdded ||
        event.type() == core::system::FileChangeEvent::FileModified)
    {    
-      // get the compilation arguments for this file and use them to
-      // create a translation unit
+      // get the compilation arguments for this file
       std::vector<std::string> compileArgs =
          rCompilationDatabase().compileArgsForTranslationUnit(file, true);
 
       if (!compileArgs.empty())
       {
-         // create index
-         CXIndex index = libclang::clang().createIndex(
-                   1 /* Exclude PCH */,
-                   (rSourceIndex().verbose() > 0) ? 1 : 0);
-
-         // get args in form clang expects
-         core::system::ProcessArgs argsArray(compileArgs);
-
-         // parse the translation unit
-         CXTranslationUnit tu = libclang::clang().parseTranslationUnit(
-                               index,
-                               file.c_str(),
-                               argsArray.args(),
-                               gsl::narrow_cast<int>(argsArray.argCount()),
-                               nullptr, 0, // no unsaved files
-                               CXTranslationUnit_None |
-                               CXTranslationUnit_Incomplete);
-
-
-         // create definitions and wire visitor to it
-         CppDefinitions definitions;
-         definitions.file = file;
-         definitions.fileLastWrite = event.fileInfo().lastWriteTime();
-         s_definitionsByFile[file] = definitions;
-         DefinitionVisitor visitor =
-            boost::bind(insertDefinition, _1, &s_definitionsByFile[file]);
-
-         // visit the cursors
-         libclang::clang().visitChildren(
-              libclang::clang().getTranslationUnitCursor(tu),
-              cursorVisitor,
-              (CXClientData)&visitor);
-
-         // dispose translation unit and index
-         libclang::clang().disposeTranslationUnit(tu);
-         libclang::clang().disposeIndex(index);
+         ensureIndexWorkers();
+
+         IndexJob job;
+         job.file = file;
+         job.fileLastWrite = event.fileInfo().lastWriteTime();
+         job.compileArgs = compileArgs;
+         job.sequence = ++s_nextJobSequence;
+         s_pendingJobs[file] = job.sequence;
+         s_pIndexJobs->enque(job);
+         return;
       }
    }
+
+   // otherwise remove existing definitions
+   s_pendingJobs.erase(file);
+   s_definitionsByFile.erase(file);
+   s_indexFile.exclude(file);
+   s_indexChanged = true;
 }
 
 } // anonymous namespace
@@ -367,6 +465,16 @@ FileLocation findDefinitionLocation(const FileLocation& location)
                return def.location;
          }
       }
+
+      if (s_indexFile.isOpen())
+      {
+         CppDefinition def;
+         Error error = s_indexFile.findUSR(USR, &def);
+         if (error)
+            LOG_ERROR(error);
+         else if (!def.empty())
+            return def.location;
+      }
    }
 
    // see if we can resolve the cursor to a definition (if we can't
@@ -409,150 +517,65 @@ bool insertMatching(const std::string& term,
 }
 
 
-json::Object cppDefinitionToJson(const CppDefinition& definition)
-{
-   using namespace safe_convert;
-   json::Object definitionJson;
-   definitionJson["usr"] = definition.USR;
-   definitionJson["kind"] = numberTo<int>(definition.kind, 0);
-   definitionJson["parent_name"] = definition.parentName;
-   definitionJson["name"] = definition.name;
-   definitionJson["file"] = definition.location.filePath.getAbsolutePath();
-   definitionJson["line"] = numberTo<int>(definition.location.line, 1);
-   definitionJson["column"] = numberTo<int>(definition.location.column, 1);
-   return definitionJson;
-}
-
-CppDefinition cppDefinitionFromJson(const json::Object& object)
-{
-   // read json
-   int kind;
-   int line, column;
-   std::string file;
-   CppDefinition definition;
-   Error error = json::readObject(object,
-                                  "usr", definition.USR,
-                                  "kind", kind,
-                                  "parent_name", definition.parentName,
-                                  "name", definition.name,
-                                  "file", file,
-                                  "line", line,
-                                  "column", column);
-   if (error)
-   {
-      LOG_ERROR(error);
-      return CppDefinition();
-   }
-
-   // required data transforms
-   using namespace safe_convert;
-   definition.kind = static_cast<CppDefinitionKind>(kind);
-   definition.location.filePath = FilePath(file);
-   definition.location.line = numberTo<unsigned>(line, 1);
-   definition.location.column = numberTo<unsigned>(column, 1);
-
-   // return definition
-   return definition;
-}
-
 FilePath definitionIndexFilePath()
 {
-   return module_context::scopedScratchPath().completeChildPath("cpp-definition-cache");
+   return module_context::scopedScratchPath().completeChildPath("cpp-definition-index");
 }
 
 void loadDefinitionIndex()
 {
-   using namespace safe_convert;
+   // remove the index from earlier versions (a single json array)
+   Error error = module_context::scopedScratchPath()
+         .completeChildPath("cpp-definition-cache")
+         .removeIfExists();
+   if (error)
+      LOG_ERROR(error);
 
    FilePath indexFilePath = definitionIndexFilePath();
    if (!indexFilePath.exists())
       return;
 
-   std::string contents;
-   Error error = readStringFromFile(indexFilePath, &contents);
+   error = s_indexFile.open(indexFilePath);
    if (error)
    {
       LOG_ERROR(error);
       return;
    }
 
-   json::Value indexValueJson;
-   if (indexValueJson.parse(contents) ||
-       !json::isType<json::Array>(indexValueJson))
+   // exclude files which no longer exist
+   for (const std::string& file : s_indexFile.files())
    {
-      LOG_ERROR_MESSAGE("Error parsing definition index: " + contents);
-      return;
-   }
-
-   const json::Array& indexJson = indexValueJson.getArray();
-   for (const json::Value& definitionsJson : indexJson)
-   {
-      if (!json::isType<json::Object>(definitionsJson))
+      if (!FilePath::exists(file))
       {
-         LOG_ERROR_MESSAGE("Unexpected non-object type in definition index");
-         continue;
+         s_indexFile.exclude(file);
+         s_indexChanged = true;
       }
-
-      json::Array defsArrayJson;
-      double fileLastWrite;
-      CppDefinitions definitions;
-      Error error = json::readObject(definitionsJson.getObject(),
-                                     "file", definitions.file,
-                                     "file_last_write", fileLastWrite,
-                                     "definitions", defsArrayJson);
-      if (error)
-      {
-         LOG_ERROR(error);
-         continue;
-      }
-      definitions.fileLastWrite = numberTo<double, std::time_t>(fileLastWrite, 0);
-
-      // if the file doesn't exist then bail
-      if (!FilePath::exists(definitions.file))
-         continue;
-
-      for (const json::Value& defJson : defsArrayJson)
-      {
-         if (!json::isType<json::Object>(defJson))
-         {
-            LOG_ERROR_MESSAGE("Unexpected non-object type in definition index");
-            continue;
-         }
-
-         CppDefinition definition = cppDefinitionFromJson(defJson.getObject());
-         if (!definition.empty())
-            definitions.definitions.push_back(definition);
-      }
-
-      s_definitionsByFile[definitions.file] = definitions;
    }
 }
 
-
 void saveDefinitionIndex()
 {
-   using namespace safe_convert;
+   if (!s_indexChanged)
+      return;
 
-   json::Array indexJson;
-   for (const DefinitionsByFile::value_type& defs : s_definitionsByFile)
+   // combine what's still current in the index with what was indexed
+   // during this session
+   std::vector<CppDefinitions> definitions;
+   if (s_indexFile.isOpen())
    {
-      const CppDefinitions& definitions = defs.second;
-      json::Object definitionsJson;
-      definitionsJson["file"] = definitions.file;
-      definitionsJson["file_last_write"] = numberTo<std::time_t, double>(
-                                               definitions.fileLastWrite, 0);
-      json::Array defsArrayJson;
-      std::transform(definitions.definitions.begin(),
-                     definitions.definitions.end(),
-                     std::back_inserter(defsArrayJson),
-                     cppDefinitionToJson);
-      definitionsJson["definitions"] = defsArrayJson;
-
-      indexJson.push_back(definitionsJson);
+      Error error = s_indexFile.readAll(&definitions);
+      if (error)
+      {
+         LOG_ERROR(error);
+         definitions.clear();
+      }
+      s_indexFile.close();
    }
 
-   ;
-   Error error = writeStringToFile(definitionIndexFilePath(), indexJson.writeFormatted());
+   for (const DefinitionsByFile::value_type& defs : s_definitionsByFile)
+      definitions.push_back(defs.second);
+
+   Error error = DefinitionIndexFile::write(definitionIndexFilePath(), definitions);
    if (error)
       LOG_ERROR(error);
 }
@@ -609,6 +632,23 @@ void searchDefinitions(const std::string& term,
             pDefinitions->push_back(def);
       }
    }
+
+   // (the index is read as it's searched rather than held in memory)
+   if (s_indexFile.isOpen())
+   {
+      Error error = s_indexFile.forEach(
+               [&](const CppDefinition& def)
+      {
+         if (units.find(def.location.filePath.getAbsolutePath()) == units.end() &&
+             matches(term, pattern, def))
+         {
+            pDefinitions->push_back(def);
+         }
+         return true;
+      });
+      if (error)
+         LOG_ERROR(error);
+   }
 }
 
 Error initializeDefinitionIndex()
@@ -637,6 +677,12 @@ Error initializeDefinitionIndex()
          pFileChangeHandler->subscribeToFileMonitor("Go to C/C++ Definition");
       }
 
+      // collect definitions as files are indexed
+      module_context::schedulePeriodicWork(
+               boost::posix_time::milliseconds(250),
+               collectIndexResults,
+               false);
+
       // set initialized flag
       s_initialized = true;
 
@@ -16,9 +16,13 @@
 #ifndef SESSION_MODULES_CLANG_DEFINITION_INDEX_HPP
 #define SESSION_MODULES_CLANG_DEFINITION_INDEX_HPP
 
+#include <ctime>
+#include <deque>
 #include <string>
 #include <iosfwd>
 
+#include <boost/function.hpp>
+
 #include <shared_core/FilePath.hpp>
 #include <core/libclang/LibClang.hpp>
 
@@ -79,6 +83,22 @@ struct CppDefinition
 
 std::ostream& operator<<(std::ostream& os, const CppDefinition& definition);
 
+// the definitions within a file (as of its last write time)
+struct CppDefinitions
+{
+   CppDefinitions()
+      : fileLastWrite(0)
+   {
+   }
+
+   std::string file;
+   std::time_t fileLastWrite;
+   std::deque<CppDefinition> definitions;
+};
+
+// visits definitions (returning false to stop visiting)
+typedef boost::function<bool(const CppDefinition&)> DefinitionVisitor;
+
 core::libclang::FileLocation findDefinitionLocation(
                      const core::libclang::FileLocation& location);
 
@@ -0,0 +1,478 @@
+/*
+ * DefinitionIndexFile.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "DefinitionIndexFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace clang {
+
+namespace {
+
+// the file begins with a header holding:
+//
+//   magic, version, file count, definition count,
+//   offset of the name table, offset of the USR table
+//
+// followed by the files (path, last write time) and the definitions
+// (name, parent name, USR, kind, file index, line, column) in order of name.
+// the name and USR tables list the offset of each definition, in order of
+// name and of USR respectively. numbers are written in native byte order
+// (the index is a cache local to this machine).
+const char kMagic[] = "RSCPPDEF";
+const std::size_t kMagicSize = 8;
+const std::uint32_t kVersion = 1;
+const std::uint64_t kHeaderSize = kMagicSize + 4 + 4 + 8 + 8 + 8;
+
+// no string in the index should be anywhere near this long (so a longer one
+// means the index is corrupt)
+const std::uint32_t kMaxStringSize = 1024 * 1024;
+
+template <typename T>
+void append(std::string* pBuffer, T value)
+{
+   pBuffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void appendString(std::string* pBuffer, const std::string& value)
+{
+   append<std::uint32_t>(pBuffer, static_cast<std::uint32_t>(value.size()));
+   pBuffer->append(value);
+}
+
+template <typename T>
+bool read(std::istream& is, T* pValue)
+{
+   return !!is.read(reinterpret_cast<char*>(pValue), sizeof(T));
+}
+
+bool readString(std::istream& is, std::string* pValue)
+{
+   std::uint32_t size = 0;
+   if (!read(is, &size) || size > kMaxStringSize)
+      return false;
+
+   pValue->resize(size);
+   return size == 0 || !!is.read(&(*pValue)[0], size);
+}
+
+} // anonymous namespace
+
+Error DefinitionIndexFile::write(const FilePath& path,
+                                 const std::vector<CppDefinitions>& definitions)
+{
+   // order the definitions by name
+   typedef std::pair<const CppDefinition*, std::uint32_t> Entry;
+   std::vector<Entry> entries;
+   for (std::size_t i = 0; i < definitions.size(); i++)
+   {
+      for (const CppDefinition& definition : definitions[i].definitions)
+         entries.push_back(std::make_pair(&definition, static_cast<std::uint32_t>(i)));
+   }
+   std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+   {
+      return a.first->name < b.first->name;
+   });
+
+   // files
+   std::string body;
+   for (const CppDefinitions& fileDefinitions : definitions)
+   {
+      appendString(&body, fileDefinitions.file);
+      append<std::int64_t>(&body, fileDefinitions.fileLastWrite);
+   }
+
+   // definitions (noting where each one is)
+   std::vector<std::uint64_t> offsets;
+   offsets.reserve(entries.size());
+   for (const Entry& entry : entries)
+   {
+      offsets.push_back(kHeaderSize + body.size());
+      const CppDefinition& definition = *entry.first;
+      appendString(&body, definition.name);
+      appendString(&body, definition.parentName);
+      appendString(&body, definition.USR);
+      append<std::uint8_t>(&body, static_cast<std::uint8_t>(definition.kind));
+      append<std::uint32_t>(&body, entry.second);
+      append<std::uint32_t>(&body, definition.location.line);
+      append<std::uint32_t>(&body, definition.location.column);
+   }
+
+   // name table
+   std::uint64_t nameTableOffset = kHeaderSize + body.size();
+   for (std::uint64_t offset : offsets)
+      append<std::uint64_t>(&body, offset);
+
+   // USR table
+   std::vector<std::size_t> byUSR(entries.size());
+   for (std::size_t i = 0; i < byUSR.size(); i++)
+      byUSR[i] = i;
+   std::stable_sort(byUSR.begin(), byUSR.end(), [&](std::size_t a, std::size_t b)
+   {
+      return entries[a].first->USR < entries[b].first->USR;
+   });
+   std::uint64_t usrTableOffset = kHeaderSize + body.size();
+   for (std::size_t i : byUSR)
+      append<std::uint64_t>(&body, offsets[i]);
+
+   std::string header(kMagic, kMagicSize);
+   append<std::uint32_t>(&header, kVersion);
+   append<std::uint32_t>(&header, static_cast<std::uint32_t>(definitions.size()));
+   append<std::uint64_t>(&header, entries.size());
+   append<std::uint64_t>(&header, nameTableOffset);
+   append<std::uint64_t>(&header, usrTableOffset);
+
+   // write alongside the index and then move it into place, so the index is
+   // never partially written
+   FilePath tempPath = path.getParent().completeChildPath(path.getFilename() + ".tmp");
+   {
+      std::shared_ptr<std::ostream> pStream;
+      Error error = tempPath.openForWrite(pStream);
+      if (error)
+         return error;
+
+      pStream->write(header.data(), header.size());
+      pStream->write(body.data(), body.size());
+      pStream->flush();
+      if (!pStream->good())
+         return systemError(boost::system::errc::io_error, ERROR_LOCATION);
+   }
+
+   return tempPath.move(path, FilePath::MoveCrossDevice, true);
+}
+
+DefinitionIndexFile::DefinitionIndexFile()
+   : size_(0),
+     definitionCount_(0),
+     nameTableOffset_(0),
+     usrTableOffset_(0)
+{
+}
+
+Error DefinitionIndexFile::open(const FilePath& path)
+{
+   close();
+
+   path_ = path;
+   size_ = path.getSize();
+   stream_.open(path.getAbsolutePath().c_str(), std::ios::in | std::ios::binary);
+   if (!stream_.is_open())
+      return systemError(boost::system::errc::no_such_file_or_directory, ERROR_LOCATION);
+
+   char magic[kMagicSize];
+   std::uint32_t version = 0;
+   std::uint32_t fileCount = 0;
+   if (!stream_.read(magic, kMagicSize) ||
+       std::memcmp(magic, kMagic, kMagicSize) != 0 ||
+       !read(stream_, &version) ||
+       version != kVersion ||
+       !read(stream_, &fileCount) ||
+       !read(stream_, &definitionCount_) ||
+       !read(stream_, &nameTableOffset_) ||
+       !read(stream_, &usrTableOffset_) ||
+       definitionCount_ > size_ / 8 ||
+       nameTableOffset_ + definitionCount_ * 8 > size_ ||
+       usrTableOffset_ + definitionCount_ * 8 > size_)
+   {
+      Error error = readError(ERROR_LOCATION);
+      close();
+      return error;
+   }
+
+   for (std::uint32_t i = 0; i < fileCount; i++)
+   {
+      File file;
+      std::int64_t lastWrite = 0;
+      if (!readString(stream_, &file.path) || !read(stream_, &lastWrite))
+      {
+         Error error = readError(ERROR_LOCATION);
+         close();
+         return error;
+      }
+
+      file.lastWrite = static_cast<std::time_t>(lastWrite);
+      file.excluded = false;
+      fileIndexes_[file.path] = files_.size();
+      files_.push_back(file);
+   }
+
+   return Success();
+}
+
+void DefinitionIndexFile::close()
+{
+   if (stream_.is_open())
+      stream_.close();
+   stream_.clear();
+   size_ = 0;
+   files_.clear();
+   fileIndexes_.clear();
+   definitionCount_ = 0;
+   nameTableOffset_ = 0;
+   usrTableOffset_ = 0;
+}
+
+std::vector<std::string> DefinitionIndexFile::files() const
+{
+   std::vector<std::string> files;
+   for (const File& file : files_)
+   {
+      if (!file.excluded)
+         files.push_back(file.path);
+   }
+   return files;
+}
+
+bool DefinitionIndexFile::fileLastWrite(const std::string& file,
+                                        std::time_t* pLastWrite) const
+{
+   auto it = fileIndexes_.find(file);
+   if (it == fileIndexes_.end() || files_[it->second].excluded)
+      return false;
+
+   *pLastWrite = files_[it->second].lastWrite;
+   return true;
+}
+
+void DefinitionIndexFile::exclude(const std::string& file)
+{
+   auto it = fileIndexes_.find(file);
+   if (it != fileIndexes_.end())
+      files_[it->second].excluded = true;
+}
+
+Error DefinitionIndexFile::forEach(const DefinitionVisitor& visitor)
+{
+   return visitFrom(0, std::string(), visitor);
+}
+
+Error DefinitionIndexFile::forEachWithPrefix(const std::string& prefix,
+                                             const DefinitionVisitor& visitor)
+{
+   // binary search for the first name not less than the prefix
+   std::uint64_t begin = 0;
+   std::uint64_t end = definitionCount_;
+   while (begin < end)
+   {
+      std::uint64_t middle = begin + (end - begin) / 2;
+      std::uint64_t offset = 0;
+      std::string name;
+      Error error = readOffset(nameTableOffset_, middle, &offset);
+      if (!error)
+         error = readName(offset, &name);
+      if (error)
+         return error;
+
+      if (name < prefix)
+         begin = middle + 1;
+      else
+         end = middle;
+   }
+
+   return visitFrom(begin, prefix, visitor);
+}
+
+Error DefinitionIndexFile::findUSR(const std::string& USR, CppDefinition* pDefinition)
+{
+   *pDefinition = CppDefinition();
+
+   std::uint64_t begin = 0;
+   std::uint64_t end = definitionCount_;
+   while (begin < end)
+   {
+      std::uint64_t middle = begin + (end - begin) / 2;
+      std::uint64_t offset = 0;
+      CppDefinition definition;
+      std::uint32_t fileIndex = 0;
+      Error error = readOffset(usrTableOffset_, middle, &offset);
+      if (!error)
+         error = readRecord(offset, &definition, &fileIndex);
+      if (error)
+         return error;
+
+      if (definition.USR < USR)
+         begin = middle + 1;
+      else
+         end = middle;
+   }
+
+   // (skipping definitions from excluded files)
+   for (std::uint64_t i = begin; i < definitionCount_; i++)
+   {
+      std::uint64_t offset = 0;
+      CppDefinition definition;
+      std::uint32_t fileIndex = 0;
+      Error error = readOffset(usrTableOffset_, i, &offset);
+      if (!error)
+         error = readRecord(offset, &definition, &fileIndex);
+      if (error)
+         return error;
+
+      if (definition.USR != USR)
+         break;
+
+      if (!files_[fileIndex].excluded)
+      {
+         *pDefinition = definition;
+         break;
+      }
+   }
+
+   return Success();
+}
+
+Error DefinitionIndexFile::readAll(std::vector<CppDefinitions>* pDefinitions)
+{
+   std::vector<CppDefinitions> definitions(files_.size());
+   for (std::size_t i = 0; i < files_.size(); i++)
+   {
+      definitions[i].file = files_[i].path;
+      definitions[i].fileLastWrite = files_[i].lastWrite;
+   }
+
+   for (std::uint64_t i = 0; i < definitionCount_; i++)
+   {
+      std::uint64_t offset = 0;
+      CppDefinition definition;
+      std::uint32_t fileIndex = 0;
+      Error error = readOffset(nameTableOffset_, i, &offset);
+      if (!error)
+         error = readRecord(offset, &definition, &fileIndex);
+      if (error)
+         return error;
+
+      definitions[fileIndex].definitions.push_back(definition);
+   }
+
+   for (std::size_t i = 0; i < files_.size(); i++)
+   {
+      if (!files_[i].excluded)
+         pDefinitions->push_back(definitions[i]);
+   }
+
+   return Success();
+}
+
+Error DefinitionIndexFile::readRecord(std::uint64_t offset,
+                                      CppDefinition* pDefinition,
+                                      std::uint32_t* pFileIndex)
+{
+   stream_.clear();
+   if (!stream_.seekg(offset))
+      return readError(ERROR_LOCATION);
+   return readNextRecord(pDefinition, pFileIndex);
+}
+
+Error DefinitionIndexFile::readNextRecord(CppDefinition* pDefinition,
+                                          std::uint32_t* pFileIndex)
+{
+   std::uint8_t kind = 0;
+   std::uint32_t line = 0;
+   std::uint32_t column = 0;
+   if (!readString(stream_, &pDefinition->name) ||
+       !readString(stream_, &pDefinition->parentName) ||
+       !readString(stream_, &pDefinition->USR) ||
+       !read(stream_, &kind) ||
+       !read(stream_, pFileIndex) ||
+       !read(stream_, &line) ||
+       !read(stream_, &column) ||
+       *pFileIndex >= files_.size())
+   {
+      return readError(ERROR_LOCATION);
+   }
+
+   pDefinition->kind = static_cast<CppDefinitionKind>(kind);
+   pDefinition->location = libclang::FileLocation(FilePath(files_[*pFileIndex].path),
+                                                  line,
+                                                  column);
+   return Success();
+}
+
+Error DefinitionIndexFile::readName(std::uint64_t offset, std::string* pName)
+{
+   stream_.clear();
+   if (!stream_.seekg(offset) || !readString(stream_, pName))
+      return readError(ERROR_LOCATION);
+   return Success();
+}
+
+Error DefinitionIndexFile::readOffset(std::uint64_t tableOffset,
+                                      std::uint64_t index,
+                                      std::uint64_t* pOffset)
+{
+   stream_.clear();
+   if (!stream_.seekg(tableOffset + index * 8) ||
+       !read(stream_, pOffset) ||
+       *pOffset >= size_)
+   {
+      return readError(ERROR_LOCATION);
+   }
+   return Success();
+}
+
+Error DefinitionIndexFile::visitFrom(std::uint64_t index,
+                                     const std::string& prefix,
+                                     const DefinitionVisitor& visitor)
+{
+   if (index >= definitionCount_)
+      return Success();
+
+   // definitions are laid out in order of name, so read them in sequence
+   std::uint64_t offset = 0;
+   Error error = readOffset(nameTableOffset_, index, &offset);
+   if (error)
+      return error;
+
+   stream_.clear();
+   if (!stream_.seekg(offset))
+      return readError(ERROR_LOCATION);
+
+   for (; index < definitionCount_; index++)
+   {
+      CppDefinition definition;
+      std::uint32_t fileIndex = 0;
+      error = readNextRecord(&definition, &fileIndex);
+      if (error)
+         return error;
+
+      if (!boost::algorithm::starts_with(definition.name, prefix))
+         break;
+
+      if (!files_[fileIndex].excluded && !visitor(definition))
+         break;
+   }
+
+   return Success();
+}
+
+Error DefinitionIndexFile::readError(const ErrorLocation& location)
+{
+   return systemError(boost::system::errc::io_error,
+                      "Invalid definition index: " + path_.getAbsolutePath(),
+                      location);
+}
+
+} // namespace clang
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,117 @@
+/*
+ * DefinitionIndexFile.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_MODULES_CLANG_DEFINITION_INDEX_FILE_HPP
+#define SESSION_MODULES_CLANG_DEFINITION_INDEX_FILE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+#include "DefinitionIndex.hpp"
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace clang {
+
+// A compact binary index of the definitions within a set of files, which is
+// searched where it lies on disk rather than being read into memory. The
+// definitions are stored sorted by name, so those with a given prefix are
+// found with a binary search, along with a table of them sorted by USR.
+//
+// An index is written in full, at once. Files whose definitions have changed
+// since can be excluded from searches (their new definitions being kept
+// elsewhere until the index is next written).
+class DefinitionIndexFile : boost::noncopyable
+{
+public:
+   static core::Error write(const core::FilePath& path,
+                            const std::vector<CppDefinitions>& definitions);
+
+   DefinitionIndexFile();
+
+   core::Error open(const core::FilePath& path);
+   void close();
+   bool isOpen() const { return stream_.is_open(); }
+
+   // the indexed files which haven't been excluded
+   std::vector<std::string> files() const;
+
+   // the last write time of a file when it was indexed (false if the file
+   // isn't indexed or has been excluded)
+   bool fileLastWrite(const std::string& file, std::time_t* pLastWrite) const;
+
+   // exclude a file's definitions from searches
+   void exclude(const std::string& file);
+
+   // visit every definition, in order of name
+   core::Error forEach(const DefinitionVisitor& visitor);
+
+   // visit the definitions whose names begin with prefix, in order of name
+   core::Error forEachWithPrefix(const std::string& prefix,
+                                 const DefinitionVisitor& visitor);
+
+   // find a definition by USR (an empty definition if there's none)
+   core::Error findUSR(const std::string& USR, CppDefinition* pDefinition);
+
+   // read the definitions of each file (e.g. to write a new index)
+   core::Error readAll(std::vector<CppDefinitions>* pDefinitions);
+
+private:
+   struct File
+   {
+      std::string path;
+      std::time_t lastWrite;
+      bool excluded;
+   };
+
+   core::Error readRecord(std::uint64_t offset,
+                          CppDefinition* pDefinition,
+                          std::uint32_t* pFileIndex);
+   core::Error readNextRecord(CppDefinition* pDefinition,
+                              std::uint32_t* pFileIndex);
+   core::Error readName(std::uint64_t offset, std::string* pName);
+   core::Error readOffset(std::uint64_t tableOffset,
+                          std::uint64_t index,
+                          std::uint64_t* pOffset);
+   core::Error visitFrom(std::uint64_t index,
+                         const std::string& prefix,
+                         const DefinitionVisitor& visitor);
+   core::Error readError(const core::ErrorLocation& location);
+
+   core::FilePath path_;
+   std::ifstream stream_;
+   std::uint64_t size_;
+   std::vector<File> files_;
+   std::map<std::string, std::size_t> fileIndexes_;
+   std::uint64_t definitionCount_;
+   std::uint64_t nameTableOffset_;
+   std::uint64_t usrTableOffset_;
+};
+
+} // namespace clang
+} // namepace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_MODULES_CLANG_DEFINITION_INDEX_FILE_HPP
@@ -0,0 +1,168 @@
+/*
+ * DefinitionIndexFileTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "DefinitionIndexFile.hpp"
+
+#include <core/FileSerializer.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace clang {
+namespace tests {
+
+using namespace rstudio::core;
+using namespace rstudio::core::libclang;
+
+namespace {
+
+CppDefinitions fileDefinitions(const std::string& file,
+                               std::time_t lastWrite,
+                               const std::vector<std::string>& names)
+{
+   CppDefinitions definitions;
+   definitions.file = file;
+   definitions.fileLastWrite = lastWrite;
+   unsigned line = 1;
+   for (const std::string& name : names)
+   {
+      definitions.definitions.push_back(
+               CppDefinition("c:@F@" + name,
+                             CppFunctionDefinition,
+                             std::string(),
+                             name,
+                             FileLocation(FilePath(file), line++, 1)));
+   }
+   return definitions;
+}
+
+std::vector<std::string> namesWithPrefix(DefinitionIndexFile& index,
+                                         const std::string& prefix)
+{
+   std::vector<std::string> names;
+   Error error = index.forEachWithPrefix(prefix, [&](const CppDefinition& def)
+   {
+      names.push_back(def.name);
+      return true;
+   });
+   REQUIRE_FALSE(error);
+   return names;
+}
+
+} // anonymous namespace
+
+TEST_CASE("C++ definition index file")
+{
+   FilePath path;
+   FilePath::tempFilePath(path);
+
+   std::vector<CppDefinitions> definitions;
+   definitions.push_back(fileDefinitions("/pkg/src/a.cpp", 100,
+                                         { "rcpp_hello", "add", "addOne" }));
+   definitions.push_back(fileDefinitions("/pkg/src/b.cpp", 200,
+                                         { "zeta", "adder", "beta" }));
+   REQUIRE_FALSE(DefinitionIndexFile::write(path, definitions));
+
+   DefinitionIndexFile index;
+   REQUIRE_FALSE(index.open(path));
+   REQUIRE(index.isOpen());
+
+   SECTION("Files and their write times are read back")
+   {
+      CHECK(index.files().size() == 2);
+
+      std::time_t lastWrite = 0;
+      CHECK(index.fileLastWrite("/pkg/src/b.cpp", &lastWrite));
+      CHECK(lastWrite == 200);
+      CHECK_FALSE(index.fileLastWrite("/pkg/src/c.cpp", &lastWrite));
+   }
+
+   SECTION("Definitions are visited in order of name")
+   {
+      std::vector<CppDefinition> all;
+      REQUIRE_FALSE(index.forEach([&](const CppDefinition& def)
+      {
+         all.push_back(def);
+         return true;
+      }));
+
+      REQUIRE(all.size() == 6);
+      CHECK(all.front().name == "add");
+      CHECK(all.back().name == "zeta");
+      CHECK(all.back().location.filePath.getAbsolutePath() == "/pkg/src/b.cpp");
+      CHECK(all.back().location.line == 1);
+      CHECK(all.back().kind == CppFunctionDefinition);
+   }
+
+   SECTION("Definitions are found by prefix")
+   {
+      std::vector<std::string> names = namesWithPrefix(index, "add");
+      CHECK(names == std::vector<std::string>({ "add", "addOne", "adder" }));
+      CHECK(namesWithPrefix(index, "rcpp_").size() == 1);
+      CHECK(namesWithPrefix(index, "q").empty());
+      CHECK(namesWithPrefix(index, "zz").empty());
+      CHECK(namesWithPrefix(index, "").size() == 6);
+   }
+
+   SECTION("Definitions are found by USR")
+   {
+      CppDefinition def;
+      REQUIRE_FALSE(index.findUSR("c:@F@beta", &def));
+      CHECK(def.name == "beta");
+      CHECK(def.location.line == 3);
+
+      CppDefinition missing;
+      REQUIRE_FALSE(index.findUSR("c:@F@gamma", &missing));
+      CHECK(missing.empty());
+   }
+
+   SECTION("Excluded files are skipped")
+   {
+      index.exclude("/pkg/src/a.cpp");
+      CHECK(index.files() == std::vector<std::string>({ "/pkg/src/b.cpp" }));
+      CHECK(namesWithPrefix(index, "add") == std::vector<std::string>({ "adder" }));
+
+      CppDefinition def;
+      REQUIRE_FALSE(index.findUSR("c:@F@add", &def));
+      CHECK(def.empty());
+
+      std::vector<CppDefinitions> remaining;
+      REQUIRE_FALSE(index.readAll(&remaining));
+      REQUIRE(remaining.size() == 1);
+      CHECK(remaining[0].file == "/pkg/src/b.cpp");
+      CHECK(remaining[0].fileLastWrite == 200);
+      CHECK(remaining[0].definitions.size() == 3);
+   }
+
+   SECTION("Invalid index files are rejected")
+   {
+      index.close();
+      REQUIRE_FALSE(writeStringToFile(path, "not an index"));
+      CHECK(index.open(path));
+      CHECK_FALSE(index.isOpen());
+   }
+
+   index.close();
+   path.removeIfExists();
+}
+
+} // namespace tests
+} // namespace clang
+} // namespace modules
+} // namespace session
+} // namespace rstudio
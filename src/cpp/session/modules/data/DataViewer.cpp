@@ -471,10 +471,13 @@ json::Value getCols(SEXP dataSEXP)
 // the shape of the API is described here:
 // http://datatables.net/manual/server-side
 // 
+// the result is streamed to the writer rather than built up as a json::Value,
+// since pages of wide data frames can be very large.
+//
 // NB: may throw exceptions! these are expected to be handled by the handlers
 // in getGridData, where they will be marshaled to JSON and displayed on the
 // client.
-json::Value getData(SEXP dataSEXP, const http::Fields& fields)
+void writeData(SEXP dataSEXP, const http::Fields& fields, json::Writer* pWriter)
 {
    Error error;
    r::sexp::Protect protect;
@@ -660,11 +663,16 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
    r::exec::RFunction(".rs.formatRowNames", dataSEXP, start, length)
       .call(&rownamesSEXP, &protect);
    
-   // create the result grid as JSON
-   json::Array data;
+   // write the result grid as JSON
+   json::Writer& writer = *pWriter;
+   writer.startObject();
+   writer.key("draw").value(draw);
+   writer.key("recordsTotal").value(nrow);
+   writer.key("recordsFiltered").value(filteredNRow);
+   writer.key("data").startArray();
    for (int row = 0; row < length; row++)
    {
-      json::Array rowData;
+      writer.startArray();
       if (rownamesSEXP != nullptr &&
           TYPEOF(rownamesSEXP) != NILSXP &&
           !Rf_isNull(rownamesSEXP) )
@@ -674,16 +682,16 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
              nameSEXP != NA_STRING &&
              r::sexp::length(nameSEXP) > 0)
          {
-            rowData.push_back(Rf_translateCharUTF8(nameSEXP));
+            writer.value(Rf_translateCharUTF8(nameSEXP));
          }
          else
          {
-            rowData.push_back(row + start);
+            writer.value(row + start);
          }
       }
       else
       {
-         rowData.push_back(row + start);
+         writer.value(row + start);
       }
 
       for (int col = 0; col<Rf_length(formattedDataSEXP); col++)
@@ -698,37 +706,33 @@ json::Value getData(SEXP dataSEXP, const http::Fields& fields)
                 stringSEXP != NA_STRING &&
                 r::sexp::length(stringSEXP) > 0)
             {
-               rowData.push_back(Rf_translateCharUTF8(stringSEXP));
+               writer.value(Rf_translateCharUTF8(stringSEXP));
             }
             else if (stringSEXP == NA_STRING)
             {
-               rowData.push_back(SPECIAL_CELL_NA);
+               writer.value(SPECIAL_CELL_NA);
             }
             else
             {
-               rowData.push_back("");
+               writer.value("");
             }
          }
          else
          {
-            rowData.push_back("");
+            writer.value("");
          }
       }
-      data.push_back(rowData);
+      writer.endArray();
    }
-
-   json::Object result;
-   result["draw"] = draw;
-   result["recordsTotal"] = nrow;
-   result["recordsFiltered"] = filteredNRow;
-   result["data"] = data;
-   return std::move(result);
+   writer.endArray();
+   writer.endObject();
 }
 
 Error getGridData(const http::Request& request,
                   http::Response* pResponse)
 {
    json::Value result;
+   std::string output;
    http::status::Code status = http::status::Ok;
 
    try
@@ -794,7 +798,13 @@ Error getGridData(const http::Request& request,
          }
          else if (show == "data")
          {
-            result = getData(dataSEXP, fields);
+            // streamed directly to the output (only kept if complete)
+            std::string data;
+            {
+               json::Writer writer(&data);
+               writeData(dataSEXP, fields, &writer);
+            }
+            output = std::move(data);
          }
       }
    }
@@ -817,7 +827,8 @@ Error getGridData(const http::Request& request,
    // unprintable and (b) some characters are invalid *even if escaped* e.g.
    // \v, there's little to be gained here in trying to marshal them to the
    // viewer.
-   std::string output = result.write();
+   if (output.empty())
+      output = result.write();
    for (size_t i = 0; i < output.size(); i++)
    {
       char c = output[i];
@@ -830,7 +841,7 @@ Error getGridData(const http::Request& request,
 
    pResponse->setNoCacheHeaders();    // don't cache data/grid shape
    pResponse->setStatusCode(status);
-   pResponse->setBody(output);
+   pResponse->setBody(std::move(output));
 
    return Success();
 }
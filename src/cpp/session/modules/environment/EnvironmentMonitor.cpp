@@ -30,48 +30,22 @@ namespace modules {
 namespace environment {
 namespace {
 
-bool compareVarName(const r::sexp::Variable& var1,
-                    const r::sexp::Variable& var2)
-{
-   return var1.first < var2.first;
-}
-
 void enqueRefreshEvent()
 {
    ClientEvent refreshEvent(client_events::kEnvironmentRefresh);
    module_context::enqueClientEvent(refreshEvent);
 }
 
-// if the given variable is an unevaluated promise, add it to the given
-// list of variables
-void addUnevaledPromise(std::vector<r::sexp::Variable>* pEnv,
-                        const r::sexp::Variable& var)
+r::sexp::Variable asVariable(const r::sexp::Binding& binding)
 {
-   if (isUnevaluatedPromise(var.second))
-   {
-      pEnv->push_back(var);
-   }
-}
-
-// If the given variable exists in the given list, remove it. Compares on name
-// only.
-void removeVarFromList(std::vector<r::sexp::Variable>* pEnv,
-                       const r::sexp::Variable& var)
-{
-   for (std::vector<r::sexp::Variable>::iterator iter = pEnv->begin();
-        iter != pEnv->end(); iter++)
-   {
-      if (iter->first == var.first)
-      {
-         pEnv->erase(iter);
-         break;
-      }
-   }
+   return std::make_pair(std::string(CHAR(PRINTNAME(binding.first))),
+                         binding.second);
 }
 
 } // anonymous namespace
 
 EnvironmentMonitor::EnvironmentMonitor() :
+   generation_(0),
    initialized_(false),
    refreshOnInit_(false)
 {}
@@ -118,127 +92,98 @@ bool EnvironmentMonitor::hasEnvironment()
    return envir != nullptr && r::sexp::isPrimitiveEnvironment(envir);
 }
 
-void EnvironmentMonitor::listEnv(std::vector<r::sexp::Variable>* pEnv)
+void EnvironmentMonitor::listBindings(std::vector<r::sexp::Binding>* pBindings)
 {
    if (!hasEnvironment())
       return;
 
-   r::sexp::Protect rProtect;
-   r::sexp::listEnvironment(getMonitoredEnvironment(),
-                            false,
-                            prefs::userPrefs().showLastDotValue(),
-                            &rProtect,
-                            pEnv);
+   r::sexp::listEnvironmentBindings(getMonitoredEnvironment(),
+                                    false,
+                                    prefs::userPrefs().showLastDotValue(),
+                                    pBindings);
 }
 
 void EnvironmentMonitor::checkForChanges()
 {
-   // information about the current environment
-   std::vector<r::sexp::Variable> currentEnv;
-   std::vector<r::sexp::Variable> currentPromises;
+   std::vector<r::sexp::Binding> currentBindings;
+   listBindings(&currentBindings);
 
    // list of assigns/removes (includes both value changes and promise
    // evaluations)
-   std::vector<r::sexp::Variable> addedVars;
-   std::vector<r::sexp::Variable> removedVars;
-
-   // get the set of variables and promises in the current environment
-   listEnv(&currentEnv);
+   std::vector<r::sexp::Binding> assignedBindings;
+   std::vector<SEXP> removedSymbols;
+
+   // note each binding that's new, has a new value, or was an unevaluated
+   // promise which has since been evaluated; everything we saw last time
+   // but don't see now has been removed
+   bool wasEmpty = bindings_.empty();
+   generation_++;
+   for (const r::sexp::Binding& binding : currentBindings)
+   {
+      bool unevaluatedPromise = isUnevaluatedPromise(binding.second);
+
+      std::pair<std::unordered_map<SEXP, BindingState>::iterator, bool> result =
+            bindings_.insert(std::make_pair(binding.first, BindingState()));
+      BindingState& state = result.first->second;
+      if (result.second ||
+          state.value != binding.second ||
+          (state.unevaluatedPromise && !unevaluatedPromise))
+      {
+         assignedBindings.push_back(binding);
+      }
 
-   // R returns an environment list sorted in dictionary order. Since the
-   // set difference algorithms below use simple string comparisons to
-   // establish order, we need to re-sort the list into canonical order
-   // to avoid the algorithms detecting superfluous insertions.
-   std::sort(currentEnv.begin(), currentEnv.end(), compareVarName);
+      state.value = binding.second;
+      state.unevaluatedPromise = unevaluatedPromise;
+      state.generation = generation_;
+   }
 
-   std::for_each(currentEnv.begin(), currentEnv.end(),
-                 boost::bind(addUnevaledPromise, &currentPromises, _1));
+   for (auto it = bindings_.begin(); it != bindings_.end(); )
+   {
+      if (it->second.generation != generation_)
+      {
+         removedSymbols.push_back(it->first);
+         it = bindings_.erase(it);
+      }
+      else
+      {
+         ++it;
+      }
+   }
 
-   bool refreshEnqueued = false;
    if (!initialized_)
    {
       if (refreshOnInit_ ||
           getMonitoredEnvironment() == R_GlobalEnv)
       {
          enqueRefreshEvent();
-         refreshEnqueued = true;
       }
       initialized_ = true;
       refreshOnInit_ = false;
+      return;
    }
-   else
+
+   if (assignedBindings.empty() && removedSymbols.empty())
+      return;
+
+   // optimize for empty current environment (user reset workspace) or empty
+   // last environment (startup) by just sending a single refresh event
+   // only do this for the global environment--while debugging local
+   // environments, the environment object list is sent down as part of
+   // the context depth event.
+   if ((currentBindings.empty() || wasEmpty) &&
+       getMonitoredEnvironment() == R_GlobalEnv)
    {
-      if (currentEnv != lastEnv_)
-      {
-         // optimize for empty currentEnv (user reset workspace) or empty
-         // lastEnv_ (startup) by just sending a single refresh event
-         // only do this for the global environment--while debugging local
-         // environments, the environment object list is sent down as part of
-         // the context depth event.
-         if ((currentEnv.empty() || lastEnv_.empty())
-             && getMonitoredEnvironment() == R_GlobalEnv)
-         {
-            enqueRefreshEvent();
-            refreshEnqueued = true;
-         }
-         else
-         {
-            std::set_difference(lastEnv_.begin(), lastEnv_.end(),
-                                currentEnv.begin(), currentEnv.end(),
-                                std::back_inserter(removedVars),
-                                compareVarName);
-
-            // fire removed event for deletes
-            std::for_each(removedVars.begin(),
-                          removedVars.end(),
-                          boost::bind(&EnvironmentMonitor::enqueRemovedEvent,
-                                      this, _1));
-
-            // remove deleted objects from the list of uneval'ed promises
-            // so we'll stop monitoring them for evaluation
-            std::for_each(removedVars.begin(),
-                          removedVars.end(),
-                          boost::bind(removeVarFromList, &unevaledPromises_, _1));
-
-            // find adds & assigns (all variable name/value combinations in the
-            // current environment but NOT in the previous environment)
-            std::set_difference(currentEnv.begin(), currentEnv.end(),
-                                lastEnv_.begin(), lastEnv_.end(),
-                                std::back_inserter(addedVars));
-
-            // remove assigned objects from the list of uneval'ed promises
-            // (otherwise, we double-assign in the case where a promise SEXP
-            // is simultaneously forced/evaluated and assigned a new value)
-            std::for_each(addedVars.begin(),
-                          addedVars.end(),
-                          boost::bind(removeVarFromList, &unevaledPromises_, _1));
-
-         }
-      }
-      // if a refresh is scheduled there's no need to emit add events one by one
-      if (!refreshEnqueued)
-      {
-         // have any promises been evaluated since we last checked?
-         if (currentPromises != unevaledPromises_)
-         {
-            // for each promise that is in the set of promises we are monitoring
-            // for evaluation but not in the set of currently tracked promises,
-            // we assume this to be an eval--process as an assign
-            std::set_difference(unevaledPromises_.begin(), unevaledPromises_.end(),
-                                currentPromises.begin(), currentPromises.end(),
-                                std::back_inserter(addedVars));
-         }
-
-         // fire assigned event for adds, assigns, and promise evaluations
-         std::for_each(addedVars.begin(),
-                       addedVars.end(),
-                       boost::bind(&EnvironmentMonitor::enqueAssignedEvent,
-                                    this, _1));
-      }
+      enqueRefreshEvent();
+      return;
    }
 
-   unevaledPromises_ = currentPromises;
-   lastEnv_ = currentEnv;
+   // fire removed event for deletes
+   for (SEXP symbolSEXP : removedSymbols)
+      enqueRemovedEvent(asVariable(std::make_pair(symbolSEXP, R_NilValue)));
+
+   // fire assigned event for adds, assigns, and promise evaluations
+   for (const r::sexp::Binding& binding : assignedBindings)
+      enqueAssignedEvent(asVariable(binding));
 }
 
 } // namespace environment
@@ -13,6 +13,8 @@
  *
  */
 
+#include <unordered_map>
+
 #include <r/RSexp.hpp>
 #include <r/RInterface.hpp>
 
@@ -25,7 +27,9 @@ namespace modules {
 namespace environment {
 
 // EnvironmentMonitor listens for changes to objects in the given environment
-// context, and emits object add/remove events.
+// context, and emits object add/remove events. Bindings are tracked by symbol
+// so that checking a large environment which hasn't changed costs a single
+// pass over its bindings.
 class EnvironmentMonitor : boost::noncopyable
 {
 public:
@@ -35,12 +39,22 @@ public:
    bool hasEnvironment();
    void checkForChanges();
 private:
-   void listEnv(std::vector<r::sexp::Variable>* pEnvironment);
+   void listBindings(std::vector<r::sexp::Binding>* pBindings);
    void enqueRemovedEvent(const r::sexp::Variable& variable);
    void enqueAssignedEvent(const r::sexp::Variable& variable);
 
-   std::vector<r::sexp::Variable> lastEnv_;
-   std::vector<r::sexp::Variable> unevaledPromises_;
+   // what we saw of each binding when we last checked for changes; values
+   // are compared by identity only (they aren't protected, so must not be
+   // otherwise used)
+   struct BindingState
+   {
+      SEXP value;
+      bool unevaluatedPromise;
+      unsigned int generation;
+   };
+   std::unordered_map<SEXP, BindingState> bindings_;
+   unsigned int generation_;
+
    r::sexp::PreservedSEXP environment_;
    bool initialized_;
    bool refreshOnInit_;
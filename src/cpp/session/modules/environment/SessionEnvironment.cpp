@@ -392,7 +392,11 @@ json::Array callFramesAsJson(LineDebugState* pLineDebugState)
    return listFrames;
 }
 
-json::Array environmentListAsJson()
+// objects are described a page at a time, as describing each one can be
+// expensive in large environments
+const int kEnvironmentListPageSize = 500;
+
+json::Array environmentListAsJson(int offset, int count, int* pTotal)
 {
     using namespace rstudio::r::sexp;
     Protect rProtect;
@@ -408,22 +412,35 @@ json::Array environmentListAsJson()
                        &rProtect,
                        &vars);
 
-       // get object details and transform to json
-       std::transform(vars.begin(),
-                      vars.end(),
+       // get details of the objects in the page and transform to json
+       std::size_t begin = std::min(static_cast<std::size_t>(std::max(offset, 0)), vars.size());
+       std::size_t end = std::min(begin + static_cast<std::size_t>(std::max(count, 0)), vars.size());
+       std::transform(vars.begin() + begin,
+                      vars.begin() + end,
                       std::back_inserter(listJson),
                       boost::bind(varToJson, env, _1));
     }
 
+    if (pTotal)
+       *pTotal = static_cast<int>(vars.size());
     return listJson;
 }
 
 Error listEnvironment(boost::shared_ptr<int> pContextDepth,
-                      const json::JsonRpcRequest&,
+                      const json::JsonRpcRequest& request,
                       json::JsonRpcResponse* pResponse)
 {
-   // return list
-   pResponse->setResult(environmentListAsJson());
+   int offset = 0, count = 0;
+   Error error = json::readParams(request.params, &offset, &count);
+   if (error)
+      return error;
+
+   // return the requested page and the number of objects in all
+   int total = 0;
+   json::Object resultJson;
+   resultJson["list"] = environmentListAsJson(offset, count, &total);
+   resultJson["total"] = total;
+   pResponse->setResult(resultJson);
    return Success();
 }
 
@@ -651,7 +668,12 @@ json::Object commonEnvironmentStateData(
    // emit the current list of values in the environment, but only if not monitoring (as the intent
    // of the monitoring switch is to avoid implicit environment listing)
    varJson["environment_monitoring"] = s_monitoring;
-   varJson["environment_list"] = includeContents ? environmentListAsJson() : json::Array();
+   // (the first page of them; the client requests the rest)
+   int total = 0;
+   varJson["environment_list"] = includeContents ?
+            environmentListAsJson(0, kEnvironmentListPageSize, &total) :
+            json::Array();
+   varJson["environment_list_total"] = total;
    
    varJson["context_depth"] = depth;
    varJson["call_frames"] = callFramesAsJson(pLineDebugState);
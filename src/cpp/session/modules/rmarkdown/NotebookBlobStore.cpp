@@ -0,0 +1,295 @@
+/*
+ * NotebookBlobStore.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "NotebookBlobStore.hpp"
+
+#include <vector>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+
+#include <core/FileSerializer.hpp>
+#include <core/Log.hpp>
+#include <core/system/Crypto.hpp>
+#include <core/system/System.hpp>
+
+using namespace rstudio::core;
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace rmarkdown {
+namespace notebook {
+
+namespace {
+
+boost::filesystem::path nativePath(const FilePath& path)
+{
+#ifdef _WIN32
+   return boost::filesystem::path(path.getAbsolutePathW());
+#else
+   return boost::filesystem::path(path.getAbsolutePath());
+#endif
+}
+
+Error fileError(const boost::system::error_code& ec,
+                const FilePath& path,
+                const ErrorLocation& location)
+{
+   Error error(ec, location);
+   error.addProperty("path", path.getAbsolutePath());
+   return error;
+}
+
+std::size_t linkCount(const FilePath& path)
+{
+   boost::system::error_code ec;
+   std::size_t count = static_cast<std::size_t>(
+            boost::filesystem::hard_link_count(nativePath(path), ec));
+   return ec ? 0 : count;
+}
+
+Error createLink(const FilePath& target, const FilePath& link)
+{
+   boost::system::error_code ec;
+   boost::filesystem::create_hard_link(nativePath(target), nativePath(link), ec);
+   if (ec)
+      return fileError(ec, link, ERROR_LOCATION);
+   return Success();
+}
+
+// a temporary path beside a file, from which it can be replaced atomically
+FilePath siblingTempPath(const FilePath& file)
+{
+   return file.getParent().completeChildPath(
+            "." + file.getFilename() + "-" +
+            core::system::generateShortenedUuid());
+}
+
+// replace a file with a link to the given blob
+Error replaceWithLink(const FilePath& blob, const FilePath& file)
+{
+   FilePath temp = siblingTempPath(file);
+   Error error = createLink(blob, temp);
+   if (error)
+      return error;
+
+   error = temp.move(file, FilePath::MoveDirect, true);
+   if (error)
+      temp.removeIfExists();
+   return error;
+}
+
+bool collectFile(const FilePath& path, std::vector<FilePath>* pFiles)
+{
+   if (!path.isDirectory())
+      pFiles->push_back(path);
+   return true;
+}
+
+bool linkItem(const FilePath& from, const FilePath& to, const FilePath& path)
+{
+   FilePath target = to.completePath(path.getRelativePath(from));
+
+   Error error;
+   if (path.isDirectory())
+   {
+      error = target.ensureDirectory();
+   }
+   else
+   {
+      // fall back to copying when the file can't be linked (e.g. the target
+      // is on another device)
+      error = createLink(path, target);
+      if (error)
+         error = path.copy(target);
+   }
+
+   if (error)
+      LOG_ERROR(error);
+   return true;
+}
+
+} // anonymous namespace
+
+ChunkBlobStore::ChunkBlobStore(const FilePath& root)
+   : root_(root)
+{
+}
+
+Error ChunkBlobStore::contentHash(const std::string& contents,
+                                  std::string* pHash)
+{
+   std::string hash;
+   Error error = core::system::crypto::sha256(contents, &hash);
+   if (error)
+      return error;
+
+   pHash->clear();
+   boost::algorithm::hex(hash.begin(), hash.end(), std::back_inserter(*pHash));
+   boost::algorithm::to_lower(*pHash);
+   return Success();
+}
+
+Error ChunkBlobStore::linkDirectory(const FilePath& from, const FilePath& to)
+{
+   Error error = to.ensureDirectory();
+   if (error)
+      return error;
+
+   return from.getChildrenRecursive(
+            boost::bind(linkItem, from, to, _2));
+}
+
+Error ChunkBlobStore::detach(const FilePath& file)
+{
+   if (linkCount(file) < 2)
+      return Success();
+
+   FilePath temp = siblingTempPath(file);
+   Error error = file.copy(temp);
+   if (error)
+      return error;
+
+   error = temp.move(file, FilePath::MoveDirect, true);
+   if (error)
+      temp.removeIfExists();
+   return error;
+}
+
+FilePath ChunkBlobStore::blobPath(const std::string& hash) const
+{
+   // fan blobs out by the first byte of their hash, so no one directory
+   // grows too large
+   return root_.completeChildPath(hash.substr(0, 2))
+               .completeChildPath(hash);
+}
+
+std::size_t ChunkBlobStore::references(const std::string& hash) const
+{
+   std::size_t count = linkCount(blobPath(hash));
+   return count > 0 ? count - 1 : 0;
+}
+
+Error ChunkBlobStore::intern(const FilePath& file)
+{
+   // files that are already linked have already been interned (or copied
+   // from a file that was); empty files aren't worth sharing
+   if (linkCount(file) != 1 || file.getSize() == 0)
+      return Success();
+
+   std::string contents;
+   Error error = readStringFromFile(file, &contents);
+   if (error)
+      return error;
+
+   std::string hash;
+   error = contentHash(contents, &hash);
+   if (error)
+      return error;
+
+   FilePath blob = blobPath(hash);
+   error = blob.getParent().ensureDirectory();
+   if (error)
+      return error;
+
+   // new content: the file becomes the blob
+   if (!blob.exists())
+   {
+      error = createLink(file, blob);
+      if (!error)
+         return Success();
+
+      // another process may have added the same blob in the meantime; if not,
+      // there's nothing more we can do
+      if (!blob.exists())
+         return error;
+   }
+
+   // the content is already stored; share it (being paranoid about hash
+   // collisions and damaged blobs)
+   if (blob.getSize() != file.getSize())
+      return Success();
+
+   error = replaceWithLink(blob, file);
+   if (error && !blob.exists())
+   {
+      // the blob was collected before we could link to it (it was no longer
+      // referred to); store our copy instead
+      error = createLink(file, blob);
+   }
+
+   return error;
+}
+
+Error ChunkBlobStore::internDirectory(const FilePath& dir)
+{
+   if (!dir.exists())
+      return Success();
+
+   // collect the files first, since interning them adds (temporary) files to
+   // the directory
+   std::vector<FilePath> files;
+   Error error = dir.getChildrenRecursive(
+            boost::bind(collectFile, _2, &files));
+   if (error)
+      return error;
+
+   for (const FilePath& file : files)
+   {
+      error = intern(file);
+      if (error)
+         LOG_ERROR(error);
+   }
+
+   return Success();
+}
+
+Error ChunkBlobStore::collectGarbage(std::size_t* pRemoved)
+{
+   if (pRemoved)
+      *pRemoved = 0;
+
+   if (!root_.exists())
+      return Success();
+
+   std::vector<FilePath> blobs;
+   Error error = root_.getChildrenRecursive(
+            boost::bind(collectFile, _2, &blobs));
+   if (error)
+      return error;
+
+   for (const FilePath& blob : blobs)
+   {
+      if (linkCount(blob) != 1)
+         continue;
+
+      error = blob.remove();
+      if (error)
+         LOG_ERROR(error);
+      else if (pRemoved)
+         (*pRemoved)++;
+   }
+
+   return Success();
+}
+
+} // namespace notebook
+} // namespace rmarkdown
+} // namespace modules
+} // namespace session
+} // namespace rstudio
@@ -0,0 +1,88 @@
+/*
+ * NotebookBlobStore.hpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#ifndef SESSION_NOTEBOOK_BLOB_STORE_HPP
+#define SESSION_NOTEBOOK_BLOB_STORE_HPP
+
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#include <shared_core/Error.hpp>
+#include <shared_core/FilePath.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace rmarkdown {
+namespace notebook {
+
+// A content-addressed store for chunk outputs. Each distinct output is kept
+// once, as a blob named by the hash of its contents, and the files in the
+// notebook caches are hard links to their blobs; identical plots, widgets and
+// libraries shared by many notebooks therefore take up space only once, and
+// the chunk outputs can still be read in place.
+//
+// A blob's reference count is the number of links to it (other than its own);
+// blobs nothing refers to any more are removed by collectGarbage(). Because
+// a blob's contents are shared, files which may be linked to a blob must never
+// be written in place -- use detach() first.
+class ChunkBlobStore : boost::noncopyable
+{
+public:
+   explicit ChunkBlobStore(const core::FilePath& root);
+
+   // hex encoded SHA-256 hash of some content
+   static core::Error contentHash(const std::string& contents,
+                                  std::string* pHash);
+
+   // copy a directory, linking to the files within it rather than copying
+   // their contents (files which can't be linked are copied)
+   static core::Error linkDirectory(const core::FilePath& from,
+                                    const core::FilePath& to);
+
+   // give a file its own copy of its contents, if it shares them with others,
+   // so that it can be written in place
+   static core::Error detach(const core::FilePath& file);
+
+   const core::FilePath& root() const { return root_; }
+
+   // the path to the blob holding the content with the given hash
+   core::FilePath blobPath(const std::string& hash) const;
+
+   // the number of files referring to the blob with the given hash
+   std::size_t references(const std::string& hash) const;
+
+   // replace a file with a link to the blob holding its contents, adding the
+   // blob if it's new; files which are already linked are left alone
+   core::Error intern(const core::FilePath& file);
+
+   // intern every file beneath a directory
+   core::Error internDirectory(const core::FilePath& dir);
+
+   // remove blobs which are no longer referred to
+   core::Error collectGarbage(std::size_t* pRemoved = nullptr);
+
+private:
+   core::FilePath root_;
+};
+
+} // namespace notebook
+} // namespace rmarkdown
+} // namespace modules
+} // namespace session
+} // namespace rstudio
+
+#endif // SESSION_NOTEBOOK_BLOB_STORE_HPP
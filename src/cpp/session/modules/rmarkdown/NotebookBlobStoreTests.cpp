@@ -0,0 +1,168 @@
+/*
+ * NotebookBlobStoreTests.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include "NotebookBlobStore.hpp"
+
+#include <core/FileSerializer.hpp>
+
+#define RSTUDIO_NO_TESTTHAT_ALIASES
+#include <tests/TestThat.hpp>
+
+namespace rstudio {
+namespace session {
+namespace modules {
+namespace rmarkdown {
+namespace notebook {
+namespace tests {
+
+using namespace rstudio::core;
+
+namespace {
+
+std::string hashOf(const std::string& contents)
+{
+   std::string hash;
+   REQUIRE_FALSE(ChunkBlobStore::contentHash(contents, &hash));
+   return hash;
+}
+
+void writeFile(const FilePath& path, const std::string& contents)
+{
+   REQUIRE_FALSE(path.getParent().ensureDirectory());
+   REQUIRE_FALSE(writeStringToFile(path, contents));
+}
+
+std::string readFile(const FilePath& path)
+{
+   std::string contents;
+   REQUIRE_FALSE(readStringFromFile(path, &contents));
+   return contents;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Notebook chunk output blob store")
+{
+   FilePath root;
+   FilePath::tempFilePath(root);
+   REQUIRE_FALSE(root.ensureDirectory());
+
+   ChunkBlobStore store(root.completeChildPath("blobs"));
+
+   // two notebook caches with a plot and widget library in common
+   FilePath first = root.completeChildPath("first/s");
+   FilePath second = root.completeChildPath("second/s");
+   const std::string plot(4096, 'p');
+   const std::string widget = "HTMLWidgets.widget({});";
+   writeFile(first.completeChildPath("c1/000001.png"), plot);
+   writeFile(first.completeChildPath("lib/widget.js"), widget);
+   writeFile(second.completeChildPath("c2/000001.png"), plot);
+   writeFile(second.completeChildPath("c2/000002.csv"), "1,out");
+   writeFile(second.completeChildPath("lib/widget.js"), widget);
+
+   SECTION("Content hashes are hex encoded SHA-256")
+   {
+      CHECK(hashOf("") ==
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+      CHECK(hashOf("abc") ==
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+   }
+
+   SECTION("Identical outputs are stored once")
+   {
+      REQUIRE_FALSE(store.internDirectory(first));
+      REQUIRE_FALSE(store.internDirectory(second));
+
+      CHECK(store.references(hashOf(plot)) == 2);
+      CHECK(store.references(hashOf(widget)) == 2);
+      CHECK(store.references(hashOf("1,out")) == 1);
+      CHECK(readFile(store.blobPath(hashOf(plot))) == plot);
+
+      // the outputs are still readable where they were
+      CHECK(readFile(first.completeChildPath("c1/000001.png")) == plot);
+      CHECK(readFile(second.completeChildPath("c2/000001.png")) == plot);
+
+      // interning again changes nothing
+      REQUIRE_FALSE(store.internDirectory(first));
+      CHECK(store.references(hashOf(plot)) == 2);
+
+      // no temporary files are left behind
+      std::vector<FilePath> children;
+      REQUIRE_FALSE(second.completeChildPath("c2").getChildren(children));
+      CHECK(children.size() == 2);
+   }
+
+   SECTION("Copies of a cache share its outputs")
+   {
+      REQUIRE_FALSE(store.internDirectory(first));
+
+      FilePath copy = root.completeChildPath("copy/s");
+      REQUIRE_FALSE(ChunkBlobStore::linkDirectory(first, copy));
+      CHECK(readFile(copy.completeChildPath("c1/000001.png")) == plot);
+      CHECK(readFile(copy.completeChildPath("lib/widget.js")) == widget);
+      CHECK(store.references(hashOf(plot)) == 2);
+   }
+
+   SECTION("Detached files can be written without affecting others")
+   {
+      REQUIRE_FALSE(store.internDirectory(first));
+      REQUIRE_FALSE(store.internDirectory(second));
+
+      FilePath script = first.completeChildPath("lib/widget.js");
+      REQUIRE_FALSE(ChunkBlobStore::detach(script));
+      REQUIRE_FALSE(writeStringToFile(script, "changed",
+                                      string_utils::LineEndingPassthrough,
+                                      false));
+
+      CHECK(readFile(script) == widget + "changed");
+      CHECK(readFile(second.completeChildPath("lib/widget.js")) == widget);
+      CHECK(store.references(hashOf(widget)) == 1);
+   }
+
+   SECTION("Blobs no longer referred to are collected")
+   {
+      REQUIRE_FALSE(store.internDirectory(first));
+      REQUIRE_FALSE(store.internDirectory(second));
+
+      std::size_t removed = 0;
+      REQUIRE_FALSE(store.collectGarbage(&removed));
+      CHECK(removed == 0);
+
+      REQUIRE_FALSE(second.getParent().remove());
+      REQUIRE_FALSE(store.collectGarbage(&removed));
+      CHECK(removed == 1);
+      CHECK_FALSE(store.blobPath(hashOf("1,out")).exists());
+      CHECK(store.references(hashOf(plot)) == 1);
+
+      REQUIRE_FALSE(first.getParent().remove());
+      REQUIRE_FALSE(store.collectGarbage(&removed));
+      CHECK(removed == 2);
+      CHECK_FALSE(store.blobPath(hashOf(plot)).exists());
+
+      // content that turns up again is stored anew
+      writeFile(first.completeChildPath("c1/000001.png"), plot);
+      REQUIRE_FALSE(store.internDirectory(first));
+      CHECK(store.references(hashOf(plot)) == 1);
+   }
+
+   root.remove();
+}
+
+} // namespace tests
+} // namespace notebook
+} // namespace rmarkdown
+} // namespace modules
+} // namespace session
+} // namespace rstudio
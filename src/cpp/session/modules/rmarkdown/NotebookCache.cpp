@@ -15,6 +15,7 @@
 
 #include "SessionRmdNotebook.hpp"
 #include "NotebookCache.hpp"
+#include "NotebookBlobStore.hpp"
 #include "NotebookChunkDefs.hpp"
 #include "NotebookPaths.hpp"
 #include "NotebookOutput.hpp"
@@ -40,6 +41,8 @@
 
 #define kCacheAgeThresholdMs 1000 * 60 * 60 * 24 * 2
 
+#define kNotebookFingerprint "notebook.json"
+
 using namespace rstudio::core;
 
 namespace rstudio {
@@ -143,21 +146,108 @@ void cleanUnusedCaches()
          }
       }
    }
+
+   // sweep up the outputs which no cache refers to any more
+   error = chunkBlobStore().collectGarbage();
+   if (error)
+      LOG_ERROR(error);
+}
+
+// the R Markdown content of a notebook is recorded (as a hash) beside the
+// cache of its .Rmd, along with the size and write time of the notebook; while
+// the notebook is unchanged, the .Rmd can be checked against it without
+// asking R to extract the content again
+FilePath notebookFingerprintPath(const FilePath& rmdPath)
+{
+   return chunkCacheFolder(rmdPath, "", kSavedCtx).getParent()
+                                                  .completeChildPath(kNotebookFingerprint);
+}
+
+bool readNotebookFingerprint(const FilePath& nbPath, const FilePath& rmdPath,
+      std::string* pHash)
+{
+   FilePath fingerprintPath = notebookFingerprintPath(rmdPath);
+   if (!fingerprintPath.exists())
+      return false;
+
+   std::string contents;
+   Error error = core::readStringFromFile(fingerprintPath, &contents);
+   if (error)
+   {
+      LOG_ERROR(error);
+      return false;
+   }
+
+   json::Value fingerprint;
+   if (fingerprint.parse(contents) || !fingerprint.isObject())
+      return false;
+
+   int64_t writeTime = 0;
+   int64_t size = 0;
+   std::string hash;
+   error = json::readObject(fingerprint.getObject(),
+                            "write_time", writeTime,
+                            "size", size,
+                            "hash", hash);
+   if (error)
+      return false;
+
+   if (writeTime != static_cast<int64_t>(nbPath.getLastWriteTime()) ||
+       size != static_cast<int64_t>(nbPath.getSize()))
+      return false;
+
+   *pHash = hash;
+   return true;
+}
+
+void writeNotebookFingerprint(const FilePath& nbPath, const FilePath& rmdPath,
+      const std::string& hash)
+{
+   json::Object fingerprint;
+   fingerprint["write_time"] = static_cast<int64_t>(nbPath.getLastWriteTime());
+   fingerprint["size"]       = static_cast<int64_t>(nbPath.getSize());
+   fingerprint["hash"]       = hash;
+
+   FilePath fingerprintPath = notebookFingerprintPath(rmdPath);
+   Error error = fingerprintPath.getParent().ensureDirectory();
+   if (!error)
+      error = core::writeStringToFile(fingerprintPath, fingerprint.write());
+   if (error)
+      LOG_ERROR(error);
 }
 
 Error notebookContentMatches(const FilePath& nbPath, const FilePath& rmdPath, 
       bool *pMatches, std::string* pContents)
 {
-   // extract content from notebook
-   std::string nbRmdContents;
-   r::exec::RFunction extractRmdFromNotebook(
-            ".rs.extractRmdFromNotebook",
-            string_utils::utf8ToSystem(nbPath.getAbsolutePath()));
-   Error error = extractRmdFromNotebook.call(&nbRmdContents);
-   if (error) 
-      return error;
-   if (pContents)
-      *pContents = nbRmdContents;
+   Error error;
+
+   // if we only need to know whether the content matches, use the recorded
+   // hash of the notebook's content when it's still current
+   std::string nbRmdHash;
+   bool haveHash = pContents == nullptr && rmdPath.exists() &&
+                   readNotebookFingerprint(nbPath, rmdPath, &nbRmdHash);
+   if (!haveHash)
+   {
+      // extract content from notebook
+      std::string nbRmdContents;
+      r::exec::RFunction extractRmdFromNotebook(
+               ".rs.extractRmdFromNotebook",
+               string_utils::utf8ToSystem(nbPath.getAbsolutePath()));
+      error = extractRmdFromNotebook.call(&nbRmdContents);
+      if (error) 
+         return error;
+      if (pContents)
+         *pContents = nbRmdContents;
+
+      // remove whitespace noise from end of file
+      boost::algorithm::trim_right(nbRmdContents);
+      error = ChunkBlobStore::contentHash(nbRmdContents, &nbRmdHash);
+      if (error)
+         return error;
+
+      if (rmdPath.exists())
+         writeNotebookFingerprint(nbPath, rmdPath, nbRmdHash);
+   }
 
    // extract contents from Rmd, if present
    std::string rmdContents;
@@ -171,11 +261,14 @@ Error notebookContentMatches(const FilePath& nbPath, const FilePath& rmdPath,
    // calculate match if requested
    if (pMatches) 
    {
-      // remove whitespace noise from end of file
       boost::algorithm::trim_right(rmdContents);
-      boost::algorithm::trim_right(nbRmdContents);
 
-      *pMatches = rmdContents == nbRmdContents;
+      std::string rmdHash;
+      error = ChunkBlobStore::contentHash(rmdContents, &rmdHash);
+      if (error)
+         return error;
+
+      *pMatches = rmdHash == nbRmdHash;
    }
       
    return Success();
@@ -290,7 +383,9 @@ void onDocRenamed(const std::string& oldPath,
          return;
    }
 
-   error = oldCacheDir.copyDirectoryRecursive(newCacheDir);
+   // the saved outputs don't change once written, so the copy can share them
+   // with the original
+   error = ChunkBlobStore::linkDirectory(oldCacheDir, newCacheDir);
    if (error)
    {
       LOG_ERROR(error);
@@ -431,6 +526,7 @@ void onDocSaved(FilePath path)
       LOG_ERROR(error);
       return;
    }
+   std::vector<FilePath> savedOutputs;
    for (const FilePath& source : children)
    {
       // compute the target path 
@@ -475,6 +571,17 @@ void onDocSaved(FilePath path)
          continue;
       }
 
+      if (error)
+         LOG_ERROR(error);
+      else if (target.isDirectory())
+         savedOutputs.push_back(target);
+   }
+
+   // now that the outputs are committed, share them with any other caches
+   // holding the same content
+   for (const FilePath& output : savedOutputs)
+   {
+      error = chunkBlobStore().internDirectory(output);
       if (error)
          LOG_ERROR(error);
    }
@@ -627,6 +734,13 @@ FilePath notebookCacheRoot()
    return module_context::sharedScratchPath().completeChildPath("notebooks");
 }
 
+ChunkBlobStore& chunkBlobStore()
+{
+   static ChunkBlobStore instance(
+            notebookCacheRoot().completeChildPath("blobs"));
+   return instance;
+}
+
 FilePath chunkCacheFolder(const FilePath& path, const std::string& docId,
       const std::string& nbCtxId)
 {
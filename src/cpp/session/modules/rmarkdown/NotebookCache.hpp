@@ -44,6 +44,8 @@
 //   in the source .Rmd
 // - the special folder "lib" is used for shared libraries (e.g. scripts upon
 //   which several htmlwidget chunks depend)
+// - once committed, the outputs are hard links into the shared blob store
+//   (see NotebookBlobStore.hpp), so identical outputs are stored only once
 
 
 #ifndef SESSION_NOTEBOOK_CACHE_HPP
@@ -66,8 +68,13 @@ namespace modules {
 namespace rmarkdown {
 namespace notebook {
 
+class ChunkBlobStore;
+
 core::FilePath notebookCacheRoot();
 
+// the store holding the committed outputs of every notebook
+ChunkBlobStore& chunkBlobStore();
+
 core::FilePath chunkCacheFolder(const std::string& docPath, 
       const std::string& docId, const std::string& nbCtxId);
 
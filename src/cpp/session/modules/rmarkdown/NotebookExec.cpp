@@ -19,6 +19,7 @@
 #include "NotebookPlots.hpp"
 #include "NotebookHtmlWidgets.hpp"
 #include "NotebookCache.hpp"
+#include "NotebookBlobStore.hpp"
 #include "NotebookData.hpp"
 #include "NotebookErrors.hpp"
 #include "NotebookWorkingDir.hpp"
@@ -409,6 +410,8 @@ void ChunkExecContext::onConsoleText(int type, const std::string& output,
    FilePath outputCsv = chunkOutputFile(docId_, chunkId_, nbCtxId_, 
          ChunkOutputText);
    Error error = outputCsv.ensureFile();
+   if (!error)
+      error = ChunkBlobStore::detach(outputCsv);
    if (error)
    {
       LOG_ERROR(error);
@@ -14,6 +14,7 @@
  */
 
 #include "SessionRmdNotebook.hpp"
+#include "NotebookBlobStore.hpp"
 #include "NotebookCache.hpp"
 #include "NotebookOutput.hpp"
 #include "NotebookPlots.hpp"
@@ -580,6 +581,11 @@ core::Error writeConsoleOutput(int chunkConsoleType,
    error = targetPath.getParent().ensureDirectory();
    if (error)
       return error;
+
+   // committed output may be shared with other notebooks
+   error = ChunkBlobStore::detach(targetPath);
+   if (error)
+      return error;
    
    std::vector<std::string> data;
    data.push_back(safe_convert::numberToString(chunkConsoleType));
@@ -513,14 +513,16 @@ void ProjectContext::onDeferredInit(bool newSession)
    cb.onUnregistered = bind(&ProjectContext::fileMonitorTermination,
                             this, Success());
 
-   FileMonitorFilterContext context;
-   context.ignoreObjectFiles = prefs::userPrefs().hideObjectFiles();
-   context.ignoredComponents = fileMonitorIgnoredComponents();
+   fileMonitorFilterContext_.ignoreObjectFiles = prefs::userPrefs().hideObjectFiles();
+   fileMonitorFilterContext_.ignoredComponents = fileMonitorIgnoredComponents();
    
    core::system::file_monitor::registerMonitor(
          directory(),
          true,
-         boost::bind(&ProjectContext::fileMonitorFilter, this, _1, context),
+         boost::bind(&ProjectContext::fileMonitorFilter,
+                     this,
+                     _1,
+                     fileMonitorFilterContext_),
          cb);
 }
 
@@ -616,6 +618,11 @@ bool ProjectContext::isMonitoringDirectory(const FilePath& dir) const
    return hasProject() && hasFileMonitor() && dir.isWithin(directory());
 }
 
+bool ProjectContext::isMonitoredFile(const FileInfo& fileInfo) const
+{
+   return fileMonitorFilter(fileInfo, fileMonitorFilterContext_);
+}
+
 void ProjectContext::subscribeToFileMonitor(const std::string& featureName,
                                             const FileMonitorCallbacks& cb)
 {
@@ -53,6 +53,21 @@ class Object;
 typedef std::vector<std::pair<std::string, std::string> > StringPairList;
 typedef std::map<std::string, std::vector<std::string> > StringListMap;
 
+/**
+ * @brief Enum which represents where the contents of a json value are allocated.
+ */
+enum class Allocation
+{
+   // Each part of the value is allocated on the heap, and freed as soon as it is no longer needed.
+   Heap,
+
+   // The value and everything added to it are allocated from an arena owned by the value, which is freed all at once
+   // when the value and every view of it have been destroyed. Suited to large documents which are built or parsed
+   // once and then read. Parts of the value which are removed or replaced are not freed until then, and moving a
+   // value out of the arena copies it.
+   Arena
+};
+
 /**
  * @brief Enum which represents the type of a json value.
  */
@@ -86,6 +101,7 @@ protected:
    typedef std::shared_ptr<Impl> ValueImplPtr;
 
    friend class Array;
+   friend class Writer;
 
 public:
    /**
@@ -93,6 +109,13 @@ public:
     */
    Value();
 
+   /**
+    * @brief Constructor. Creates a null JSON value whose contents are allocated as specified.
+    *
+    * @param in_allocation  Where the contents of this value should be allocated.
+    */
+   explicit Value(Allocation in_allocation);
+
    /**
     * @brief Constructor. Creates a JSON value from a Value::Impl object.
     *
@@ -108,7 +131,8 @@ public:
    Value(const Value& in_other);
 
    /**
-    * @brief Move constructor.
+    * @brief Move constructor. Values obtained from an object or array (e.g. via operator[] or getObject()) are views
+    *        of their parent; moving from a view copies it, so the parent is left unchanged.
     *
     * @param in_other   The value to move from.
     */
@@ -636,7 +660,8 @@ public:
    Error setValueAtPointerPath(const std::string& in_pointerPath, const Object& in_value);
 
    /**
-    * @brief Validates this JSON value against a schema.
+    * @brief Validates this JSON value against a schema. Compiled schemas are cached, so repeated validation against
+    *        the same schema does not re-parse it.
     *
     * @param in_schema      The schema to validate this value against.
     *
@@ -837,6 +862,13 @@ public:
     */
    Object();
 
+   /**
+    * @brief Constructs an empty JSON object whose contents are allocated as specified.
+    *
+    * @param in_allocation  Where the contents of this object should be allocated.
+    */
+   explicit Object(Allocation in_allocation);
+
    /**
     * @brief Constructs a JSON object from a list of string pairs.
     *
@@ -1324,6 +1356,13 @@ public:
     */
    Array();
 
+   /**
+    * @brief Constructs an empty JSON array whose contents are allocated as specified.
+    *
+    * @param in_allocation  Where the contents of this array should be allocated.
+    */
+   explicit Array(Allocation in_allocation);
+
    /**
     * @brief Constructs a JSON array from a list of string pairs as an array of strings in the format "key=value".
     *
@@ -1651,6 +1690,156 @@ private:
    friend class Value;
 };
 
+/**
+ * @brief Class which writes JSON incrementally, without first building a Value tree.
+ *
+ * Producers of large documents (e.g. data viewer pages or long lists) can use this to serialize directly into their
+ * output as each element is produced. Output is buffered and appended to the target in blocks; call flush() (or
+ * destroy the writer) before using the output.
+ *
+ * Calls must describe well formed JSON: every startObject() or startArray() must be matched by endObject() or
+ * endArray(), and each value within an object must be preceded by key().
+ */
+class Writer
+{
+public:
+   /**
+    * @brief Constructor. Appends output to the specified string.
+    *
+    * @param out_pOutput    The string to which JSON should be appended. Must outlive this writer.
+    */
+   explicit Writer(std::string* out_pOutput);
+
+   /**
+    * @brief Constructor. Writes output to the specified output stream.
+    *
+    * @param io_ostream     The output stream to which JSON should be written. Must outlive this writer.
+    */
+   explicit Writer(std::ostream& io_ostream);
+
+   /**
+    * @brief Destructor. Flushes any buffered output.
+    */
+   ~Writer();
+
+   // COPYING: not copyable
+   Writer(const Writer&) = delete;
+   Writer& operator=(const Writer&) = delete;
+
+   /**
+    * @brief Starts a JSON object.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& startObject();
+
+   /**
+    * @brief Ends the current JSON object.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& endObject();
+
+   /**
+    * @brief Starts a JSON array.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& startArray();
+
+   /**
+    * @brief Ends the current JSON array.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& endArray();
+
+   /**
+    * @brief Writes the name of the next member of the current object.
+    *
+    * @param in_name    The name of the member.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& key(const char* in_name);
+
+   /**
+    * @brief Writes the name of the next member of the current object.
+    *
+    * @param in_name    The name of the member.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& key(const std::string& in_name);
+
+   /**
+    * @brief Writes a null value.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& null();
+
+   /**
+    * @brief Writes a literal value.
+    *
+    * @param in_value   The value to write.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& value(bool in_value);
+   Writer& value(double in_value);
+   Writer& value(int in_value);
+   Writer& value(int64_t in_value);
+   Writer& value(unsigned int in_value);
+   Writer& value(uint64_t in_value);
+   Writer& value(const char* in_value);
+   Writer& value(const std::string& in_value);
+
+   /**
+    * @brief Writes a string value.
+    *
+    * @param in_value       The string to write (need not be null terminated).
+    * @param in_length      The length of the string.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& value(const char* in_value, size_t in_length);
+
+   /**
+    * @brief Writes an existing JSON value (and all of its children).
+    *
+    * @param in_value   The value to write.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& value(const Value& in_value);
+
+   /**
+    * @brief Writes a value which has already been serialized to JSON, verbatim.
+    *
+    * @param in_json    The serialized JSON value.
+    *
+    * @return A reference to this writer.
+    */
+   Writer& rawValue(const std::string& in_json);
+
+   /**
+    * @brief Writes any buffered output to the target.
+    */
+   void flush();
+
+   /**
+    * @brief Checks whether a complete JSON value has been written.
+    *
+    * @return True if a complete JSON value has been written; false otherwise.
+    */
+   bool isComplete() const;
+
+private:
+   // The private implementation of Writer.
+   PRIVATE_IMPL(m_impl);
+};
+
 /**
  * @brief Checks whether the specified JSON value is of the type specified in the template parameter.
  *
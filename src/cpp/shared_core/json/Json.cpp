@@ -23,6 +23,12 @@
 
 #include <shared_core/json/Json.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
 #include <sstream>
 
 #include <boost/algorithm/string.hpp>
@@ -138,15 +144,197 @@ std::string JsonPointerParseErrorCategory::message(int /*ev*/) const
    return "Pointer parse failure - see error code";
 }
 
-typedef rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::CrtAllocator> JsonDocument;
-typedef rapidjson::GenericValue<rapidjson::UTF8<>, rapidjson::CrtAllocator> JsonValue;
-typedef rapidjson::GenericPointer<rapidjson::GenericValue<rapidjson::UTF8<>, rapidjson::CrtAllocator>,
-                                  rapidjson::CrtAllocator> JsonPointer;
+typedef rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> ArenaAllocator;
+
+// Allocator for the contents of JSON values. Values are normally allocated on the heap, but values created with
+// Allocation::Arena allocate from an arena owned by their document instead. rapidjson frees through a static function,
+// so each block starts with a header recording where it came from: heap blocks are freed individually, arena blocks
+// only when the arena is destroyed.
+class ValueAllocator
+{
+public:
+   static const bool kNeedFree = true;
+
+   ValueAllocator() :
+      m_arena(nullptr)
+   {
+   }
+
+   explicit ValueAllocator(ArenaAllocator* in_arena) :
+      m_arena(in_arena)
+   {
+   }
+
+   void* Malloc(size_t in_size)
+   {
+      if (in_size == 0)
+         return nullptr;
+
+      void* block = m_arena ? m_arena->Malloc(in_size + kHeaderSize) : std::malloc(in_size + kHeaderSize);
+      if (block == nullptr)
+         return nullptr;
+
+      *static_cast<BlockHeader*>(block) = m_arena ? kArenaBlock : kHeapBlock;
+      return static_cast<char*>(block) + kHeaderSize;
+   }
+
+   void* Realloc(void* in_ptr, size_t in_originalSize, size_t in_newSize)
+   {
+      if (in_ptr == nullptr)
+         return Malloc(in_newSize);
+
+      if (in_newSize == 0)
+      {
+         Free(in_ptr);
+         return nullptr;
+      }
+
+      if (m_arena == nullptr && *header(in_ptr) == kHeapBlock)
+      {
+         void* block = std::realloc(header(in_ptr), in_newSize + kHeaderSize);
+         return block ? static_cast<char*>(block) + kHeaderSize : nullptr;
+      }
+
+      void* newPtr = Malloc(in_newSize);
+      if (newPtr != nullptr)
+      {
+         std::memcpy(newPtr, in_ptr, std::min(in_originalSize, in_newSize));
+         Free(in_ptr);
+      }
+      return newPtr;
+   }
+
+   static void Free(void* in_ptr)
+   {
+      if (in_ptr != nullptr && *header(in_ptr) == kHeapBlock)
+         std::free(header(in_ptr));
+   }
+
+   bool isArena() const
+   {
+      return m_arena != nullptr;
+   }
+
+private:
+   typedef uint64_t BlockHeader;
+   static const BlockHeader kHeapBlock = 0;
+   static const BlockHeader kArenaBlock = 1;
+
+   // Keeps the contents 8-byte aligned, which is all rapidjson requires.
+   static const size_t kHeaderSize = RAPIDJSON_ALIGN(sizeof(BlockHeader));
+
+   static BlockHeader* header(void* in_ptr)
+   {
+      return reinterpret_cast<BlockHeader*>(static_cast<char*>(in_ptr) - kHeaderSize);
+   }
+
+   ArenaAllocator* m_arena;
+};
+
+typedef rapidjson::GenericDocument<rapidjson::UTF8<>, ValueAllocator, rapidjson::CrtAllocator> JsonDocument;
+typedef rapidjson::GenericValue<rapidjson::UTF8<>, ValueAllocator> JsonValue;
+typedef rapidjson::GenericPointer<JsonValue, rapidjson::CrtAllocator> JsonPointer;
+
+// Document used only while parsing. Parsed values are allocated with the target value's allocator (so they can be
+// moved into it without copying), but the parser's working stack lives in an arena which is discarded as soon as
+// parsing completes.
+typedef rapidjson::GenericDocument<rapidjson::UTF8<>, ValueAllocator, ArenaAllocator> JsonParseDocument;
 
 // Globals and Helpers =================================================================================================
 namespace {
 
-rapidjson::CrtAllocator s_allocator;
+ValueAllocator s_allocator;
+
+// Size of the arena buffer used by each parse (on the stack); larger documents spill over into heap-allocated chunks.
+const size_t kParseArenaSize = 4096;
+
+// Size of the chunks in which an arena value's arena grows.
+const size_t kValueArenaChunkSize = 1024;
+
+// Owns the arena of an ArenaDocument. This is a base class of ArenaDocument (rather than a member) so that it is
+// constructed before, and destroyed after, the document's values.
+struct ValueArena
+{
+   ValueArena() :
+      Arena(kValueArenaChunkSize),
+      Allocator(&Arena)
+   {
+   }
+
+   ValueAllocator* arenaAllocator()
+   {
+      return &Allocator;
+   }
+
+   ArenaAllocator Arena;
+   ValueAllocator Allocator;
+};
+
+// The root document of a value created with Allocation::Arena.
+class ArenaDocument : private ValueArena, public JsonDocument
+{
+public:
+   ArenaDocument() :
+      ValueArena(),
+      JsonDocument(arenaAllocator())
+   {
+   }
+
+   using ValueArena::arenaAllocator;
+};
+
+// Compiled schemas, keyed by schema text. Schemas are almost always string constants, so the cache is small; the limit
+// only guards against callers which generate schemas dynamically.
+class SchemaCache
+{
+public:
+   typedef std::shared_ptr<const rapidjson::SchemaDocument> SchemaPtr;
+
+   Error get(const std::string& in_schema, SchemaPtr& out_schemaDoc)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         auto itr = m_schemas.find(in_schema);
+         if (itr != m_schemas.end())
+         {
+            out_schemaDoc = itr->second;
+            return Success();
+         }
+      }
+
+      // Compile outside the lock; a race only means the schema is compiled twice.
+      rapidjson::Document sd;
+      rapidjson::ParseResult result = sd.Parse(in_schema.c_str());
+      if (result.IsError())
+      {
+         Error error(result.Code(), ERROR_LOCATION);
+         error.addProperty("offset", result.Offset());
+         return error;
+      }
+
+      // The schema document keeps no references to sd.
+      out_schemaDoc = std::make_shared<rapidjson::SchemaDocument>(sd);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_schemas.size() < kMaxSchemas)
+         m_schemas[in_schema] = out_schemaDoc;
+
+      return Success();
+   }
+
+private:
+   static const size_t kMaxSchemas = 256;
+
+   std::mutex m_mutex;
+   std::map<std::string, SchemaPtr> m_schemas;
+};
+
+SchemaCache& schemaCache()
+{
+   // Intentionally leaked so that it remains usable during static destruction.
+   static SchemaCache* s_schemaCache = new SchemaCache();
+   return *s_schemaCache;
+}
 
 Object getSchemaDefaults(const Object& schema)
 {
@@ -204,25 +392,55 @@ Object getSchemaDefaults(const Object& schema)
 struct Value::Impl
 {
    Impl() :
-      Document(new JsonDocument(&s_allocator))
+      Document(std::make_shared<JsonDocument>(&s_allocator)),
+      Allocator(&s_allocator),
+      IsView(false)
+   {
+   }
+
+   explicit Impl(Allocation in_allocation) :
+      Impl()
    {
+      if (in_allocation == Allocation::Arena)
+      {
+         std::shared_ptr<ArenaDocument> document = std::make_shared<ArenaDocument>();
+         Allocator = document->arenaAllocator();
+         Document = document;
+      }
    }
 
-   explicit Impl(const std::shared_ptr<JsonDocument>& in_jsonDocument) :
-      Document(in_jsonDocument)
+   // A view of a value owned by another value (e.g. an object member or array element, or the object or array
+   // returned by getObject() or getArray()). in_jsonDocument keeps the owner's document alive.
+   Impl(const std::shared_ptr<JsonDocument>& in_jsonDocument, ValueAllocator* in_allocator) :
+      Document(in_jsonDocument),
+      Allocator(in_allocator),
+      IsView(true)
    {
    }
 
    void copy(const Impl& in_other)
    {
-      Document->CopyFrom(*in_other.Document, s_allocator);
+      Document->CopyFrom(*in_other.Document, *Allocator);
+   }
+
+   // The allocator for anything added to this value; the owning document's allocator for views.
+   ValueAllocator& allocator()
+   {
+      return *Allocator;
    }
 
    std::shared_ptr<JsonDocument> Document;
+   ValueAllocator* Allocator;
+   bool IsView;
 };
 
 Value::Value() :
-   m_impl(new Impl())
+   m_impl(std::make_shared<Impl>())
+{
+}
+
+Value::Value(Allocation in_allocation) :
+   m_impl(std::make_shared<Impl>(in_allocation))
 {
 }
 
@@ -346,13 +564,13 @@ Value& Value::operator=(int64_t in_value)
 
 Value& Value::operator=(const char* in_value)
 {
-   m_impl->Document->SetString(in_value, s_allocator);
+   m_impl->Document->SetString(in_value, m_impl->allocator());
    return *this;
 }
 
 Value& Value::operator=(const std::string& in_value)
 {
-   m_impl->Document->SetString(in_value.c_str(), s_allocator);
+   m_impl->Document->SetString(in_value.c_str(), m_impl->allocator());
    return *this;
 }
 
@@ -397,21 +615,14 @@ Value Value::clone() const
 Error Value::coerce(const std::string& in_schema,
                     std::vector<std::string>& out_propViolations)
 {
-   Error error;
-
-   // Parse the schema first.
-   rapidjson::Document sd;
-   rapidjson::ParseResult result = sd.Parse(in_schema.c_str());
-   if (result.IsError())
-   {
-      error = Error(result.Code(), ERROR_LOCATION);
-      error.addProperty("offset", result.Offset());
+   // Get the compiled schema first.
+   SchemaCache::SchemaPtr schemaDoc;
+   Error error = schemaCache().get(in_schema, schemaDoc);
+   if (error)
       return error;
-   }
 
    // Validate the input according to the schema.
-   rapidjson::SchemaDocument schemaDoc(sd);
-   rapidjson::SchemaValidator validator(schemaDoc);
+   rapidjson::SchemaValidator validator(*schemaDoc);
    rapidjson::Pointer lastInvalid;
    while (!m_impl->Document->Accept(validator))
    {
@@ -440,7 +651,7 @@ Error Value::coerce(const std::string& in_schema,
       out_propViolations.emplace_back(sb.GetString());
 
       // Remove the invalid part of the document
-      JsonPointer pointer(sb.GetString(), &s_allocator);
+      JsonPointer pointer(sb.GetString());
       pointer.Erase(*(m_impl->Document));
 
       // Reset state for re-validation
@@ -454,7 +665,7 @@ Error Value::coerce(const std::string& in_schema,
 Array Value::getArray() const
 {
    assert(getType() == Type::ARRAY);
-   return Array(m_impl);
+   return Array(std::make_shared<Impl>(m_impl->Document, m_impl->Allocator));
 }
 
 bool Value::getBool() const
@@ -490,7 +701,7 @@ int64_t Value::getInt64() const
 Object Value::getObject() const
 {
    assert(isObject());
-   return Object(m_impl);
+   return Object(std::make_shared<Impl>(m_impl->Document, m_impl->Allocator));
 }
 
 std::string Value::getString() const
@@ -661,14 +872,19 @@ bool Value::isUInt64() const
 
 Error Value::parse(const char* in_jsonStr)
 {
-   rapidjson::ParseResult result = m_impl->Document->Parse(in_jsonStr);
+   char arenaBuffer[kParseArenaSize];
+   ArenaAllocator arena(arenaBuffer, sizeof(arenaBuffer));
+   JsonParseDocument parsed(m_impl->Allocator, kParseArenaSize / 2, &arena);
 
+   rapidjson::ParseResult result = parsed.Parse(in_jsonStr);
    if (result.IsError())
    {
       std::string message = "An error occurred while parsing json. Offset: " + std::to_string(result.Offset());
       return Error(result.Code(), message, ERROR_LOCATION);
    }
 
+   // Both documents share an allocator, so this moves the parsed value without copying it.
+   static_cast<JsonValue&>(*m_impl->Document) = static_cast<JsonValue&>(parsed);
    return Success();
 }
 
@@ -698,7 +914,7 @@ Error Value::setValueAtPointerPath(const std::string& in_pointerPath, const json
       return error;
    }
 
-   pointer.Set(*m_impl->Document, *in_value.clone().m_impl->Document);
+   pointer.Set(*m_impl->Document, *in_value.clone().m_impl->Document, m_impl->allocator());
    return Success();
 }
 
@@ -759,21 +975,14 @@ Error Value::setValueAtPointerPath(const std::string& in_pointerPath, const Obje
 
 Error Value::validate(const std::string& in_schema) const
 {
-   Error error;
-
-   // Parse the schema first.
-   rapidjson::Document sd;
-   rapidjson::ParseResult result = sd.Parse(in_schema.c_str());
-   if (result.IsError())
-   {
-      error = Error(result.Code(), ERROR_LOCATION);
-      error.addProperty("offset", result.Offset());
+   // Get the compiled schema first.
+   SchemaCache::SchemaPtr schemaDoc;
+   Error error = schemaCache().get(in_schema, schemaDoc);
+   if (error)
       return error;
-   }
 
    // Validate the input according to the schema.
-   rapidjson::SchemaDocument schemaDoc(sd);
-   rapidjson::SchemaValidator validator(schemaDoc);
+   rapidjson::SchemaValidator validator(*schemaDoc);
    if (!m_impl->Document->Accept(validator))
    {
       rapidjson::StringBuffer sb;
@@ -800,7 +1009,8 @@ std::string Value::write() const
 
 void Value::write(std::ostream& os) const
 {
-   os << write();
+   Writer writer(os);
+   writer.value(*this);
 }
 
 std::string Value::writeFormatted() const
@@ -819,6 +1029,16 @@ void Value::writeFormatted(std::ostream& os) const
 
 void Value::move(Value&& in_other)
 {
+   // A view doesn't own its value, so moving from one must not empty the value in its parent (e.g. when a container
+   // of views is reallocated); copy it instead. Values from an arena can't be moved out of it either, since the arena
+   // is freed along with the document which owns it.
+   if (in_other.m_impl->IsView ||
+       (in_other.m_impl->Allocator != m_impl->Allocator && in_other.m_impl->Allocator->isArena()))
+   {
+      m_impl->copy(*in_other.m_impl);
+      return;
+   }
+
    // rapidjson copy is a move operation
    // only move the underlying value (and none of the document members)
    // because we do not want to move the allocators (as they are the same and rapidjson cannot
@@ -829,13 +1049,17 @@ void Value::move(Value&& in_other)
 // Object Member =======================================================================================================
 struct Object::Member::Impl
 {
-   Impl(const std::string& in_name, const std::shared_ptr<JsonDocument>& in_document) :
+   Impl(const std::string& in_name,
+        const std::shared_ptr<JsonDocument>& in_document,
+        ValueAllocator* in_allocator) :
       Document(in_document),
+      Allocator(in_allocator),
       Name(in_name)
    {
    }
 
    std::shared_ptr<JsonDocument> Document;
+   ValueAllocator* Allocator;
    std::string Name;
 };
 
@@ -851,7 +1075,7 @@ const std::string& Object::Member::getName() const
 
 Value Object::Member::getValue() const
 {
-   return Value(ValueImplPtr(new Value::Impl(m_impl->Document)));
+   return Value(std::make_shared<Value::Impl>(m_impl->Document, m_impl->Allocator));
 }
 
 // Object Iterator =====================================================================================================
@@ -919,7 +1143,8 @@ Object::Iterator::reference Object::Iterator::operator*() const
    return Object::Member(
       std::make_shared<Member::Impl>(
       std::string(itr->name.GetString(), itr->name.GetStringLength()),
-      docPtr));
+      docPtr,
+      m_parent->m_impl->Allocator));
 }
 
 // Object ==============================================================================================================
@@ -929,6 +1154,12 @@ Object::Object() :
    m_impl->Document->SetObject();
 }
 
+Object::Object(Allocation in_allocation) :
+   Value(in_allocation)
+{
+   m_impl->Document->SetObject();
+}
+
 Object::Object(const StringPairList& in_strPairs) :
    Object()
 {
@@ -944,7 +1175,7 @@ Object::Object(const Object& in_other) :
 }
 
 Object::Object(Object&& in_other) noexcept :
-   Value(in_other)
+   Value(std::move(in_other))
 {
 }
 
@@ -1023,12 +1254,12 @@ Value Object::operator[](const char* in_name)
    JsonDocument& doc = *m_impl->Document;
    if (!doc.HasMember(in_name))
    {
-      doc.AddMember(JsonValue(in_name, s_allocator), JsonDocument(), s_allocator);
+      doc.AddMember(JsonValue(in_name, m_impl->allocator()), JsonValue(), m_impl->allocator());
    }
 
    JsonDocument& docRef = static_cast<JsonDocument&>(doc.FindMember(in_name)->value);
    std::shared_ptr<JsonDocument> docPtr(m_impl->Document, &docRef);
-   return Value(ValueImplPtr(new Impl(docPtr)));
+   return Value(std::make_shared<Impl>(docPtr, m_impl->Allocator));
 }
 
 Value Object::operator[](const std::string& in_name)
@@ -1114,47 +1345,47 @@ void Object::insert(const std::string& in_name, const Value& in_value)
 
 void Object::insert(const std::string& in_name, bool in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, double in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, float in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, int in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, int64_t in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, const char* in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, const std::string& in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, unsigned int in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, uint64_t in_value)
 {
-   insert(in_name, json::Value(in_value));
+   (*this)[in_name] = in_value;
 }
 
 void Object::insert(const std::string& in_name, const Array& in_value)
@@ -1296,7 +1527,7 @@ Array::Iterator::reference Array::Iterator::operator*() const
    JsonDocument& docRef = static_cast<JsonDocument&>(*internalItr);
    std::shared_ptr<JsonDocument> docPtr(m_parent->m_impl->Document, &docRef);
 
-   return Value(ValueImplPtr(new Impl(docPtr)));
+   return Value(std::make_shared<Impl>(docPtr, m_parent->m_impl->Allocator));
 }
 
 // Array ===============================================================================================================
@@ -1306,6 +1537,12 @@ Array::Array() :
    m_impl->Document->SetArray();
 }
 
+Array::Array(Allocation in_allocation) :
+   Value(in_allocation)
+{
+   m_impl->Document->SetArray();
+}
+
 Array::Array(const StringPairList& in_strPairs) :
    Array()
 {
@@ -1333,7 +1570,7 @@ Array::Array(const Array& in_other) :
 }
 
 Array::Array(Array&& in_other) noexcept :
-   Value(in_other)
+   Value(std::move(in_other))
 {
 }
 
@@ -1354,7 +1591,7 @@ Value Array::operator[](size_t in_index) const
    JsonDocument& docRef = static_cast<JsonDocument&>((*m_impl->Document)[in_index]);
    std::shared_ptr<JsonDocument> docPtr(m_impl->Document, &docRef);
 
-   return Value(ValueImplPtr(new Impl(docPtr)));
+   return Value(std::make_shared<Impl>(docPtr, m_impl->Allocator));
 }
 
 Array::Iterator Array::begin() const
@@ -1446,54 +1683,53 @@ Error Array::parse(const std::string& in_jsonStr)
 
 void Array::push_back(const Value& in_value)
 {
-   JsonDocument doc;
-   doc.CopyFrom(*in_value.m_impl->Document, s_allocator);
-   m_impl->Document->PushBack(doc, s_allocator);
+   JsonValue copy(*in_value.m_impl->Document, m_impl->allocator());
+   m_impl->Document->PushBack(copy, m_impl->allocator());
 }
 
 void Array::push_back(bool in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value), m_impl->allocator());
 }
 
 void Array::push_back(double in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value), m_impl->allocator());
 }
 
 void Array::push_back(float in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value), m_impl->allocator());
 }
 
 void Array::push_back(int in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value), m_impl->allocator());
 }
 
 void Array::push_back(int64_t in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value), m_impl->allocator());
 }
 
 void Array::push_back(const char* in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value, m_impl->allocator()), m_impl->allocator());
 }
 
 void Array::push_back(const std::string& in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value.c_str(), m_impl->allocator()), m_impl->allocator());
 }
 
 void Array::push_back(unsigned int in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value), m_impl->allocator());
 }
 
 void Array::push_back(uint64_t in_value)
 {
-   push_back(json::Value(in_value));
+   m_impl->Document->PushBack(JsonValue(in_value), m_impl->allocator());
 }
 
 void Array::push_back(const json::Array& in_value)
@@ -1591,6 +1827,218 @@ Array::Array(ValueImplPtr in_value)
    assert(m_impl->Document->IsArray());
 }
 
+// Writer ==============================================================================================================
+namespace {
+
+// rapidjson output stream which buffers output and appends it to a string or ostream in blocks.
+class BufferedOutputStream
+{
+public:
+   typedef char Ch;
+
+   explicit BufferedOutputStream(std::string* out_pOutput) :
+      m_pOutput(out_pOutput),
+      m_pStream(nullptr),
+      m_used(0)
+   {
+   }
+
+   explicit BufferedOutputStream(std::ostream* io_pStream) :
+      m_pOutput(nullptr),
+      m_pStream(io_pStream),
+      m_used(0)
+   {
+   }
+
+   void Put(Ch in_c)
+   {
+      if (m_used == kBufferSize)
+         Flush();
+      m_buffer[m_used++] = in_c;
+   }
+
+   void Flush()
+   {
+      if (m_used == 0)
+         return;
+
+      if (m_pOutput != nullptr)
+         m_pOutput->append(m_buffer, m_used);
+      else
+         m_pStream->write(m_buffer, static_cast<std::streamsize>(m_used));
+      m_used = 0;
+   }
+
+private:
+   static const size_t kBufferSize = 8192;
+
+   std::string* m_pOutput;
+   std::ostream* m_pStream;
+   size_t m_used;
+   char m_buffer[kBufferSize];
+};
+
+} // anonymous namespace
+
+struct Writer::Impl
+{
+   explicit Impl(std::string* out_pOutput) :
+      Stream(out_pOutput),
+      JsonWriter(Stream)
+   {
+   }
+
+   explicit Impl(std::ostream* io_pStream) :
+      Stream(io_pStream),
+      JsonWriter(Stream)
+   {
+   }
+
+   BufferedOutputStream Stream;
+   rapidjson::Writer<BufferedOutputStream> JsonWriter;
+};
+
+PRIVATE_IMPL_DELETER_IMPL(Writer)
+
+Writer::Writer(std::string* out_pOutput) :
+   m_impl(new Impl(out_pOutput))
+{
+}
+
+Writer::Writer(std::ostream& io_ostream) :
+   m_impl(new Impl(&io_ostream))
+{
+}
+
+Writer::~Writer()
+{
+   try
+   {
+      flush();
+   }
+   catch (...)
+   {
+      // never throw from the destructor
+   }
+}
+
+Writer& Writer::startObject()
+{
+   m_impl->JsonWriter.StartObject();
+   return *this;
+}
+
+Writer& Writer::endObject()
+{
+   m_impl->JsonWriter.EndObject();
+   return *this;
+}
+
+Writer& Writer::startArray()
+{
+   m_impl->JsonWriter.StartArray();
+   return *this;
+}
+
+Writer& Writer::endArray()
+{
+   m_impl->JsonWriter.EndArray();
+   return *this;
+}
+
+Writer& Writer::key(const char* in_name)
+{
+   m_impl->JsonWriter.Key(in_name, static_cast<rapidjson::SizeType>(std::strlen(in_name)));
+   return *this;
+}
+
+Writer& Writer::key(const std::string& in_name)
+{
+   m_impl->JsonWriter.Key(in_name.c_str(), static_cast<rapidjson::SizeType>(in_name.length()));
+   return *this;
+}
+
+Writer& Writer::null()
+{
+   m_impl->JsonWriter.Null();
+   return *this;
+}
+
+Writer& Writer::value(bool in_value)
+{
+   m_impl->JsonWriter.Bool(in_value);
+   return *this;
+}
+
+Writer& Writer::value(double in_value)
+{
+   m_impl->JsonWriter.Double(in_value);
+   return *this;
+}
+
+Writer& Writer::value(int in_value)
+{
+   m_impl->JsonWriter.Int(in_value);
+   return *this;
+}
+
+Writer& Writer::value(int64_t in_value)
+{
+   m_impl->JsonWriter.Int64(in_value);
+   return *this;
+}
+
+Writer& Writer::value(unsigned int in_value)
+{
+   m_impl->JsonWriter.Uint(in_value);
+   return *this;
+}
+
+Writer& Writer::value(uint64_t in_value)
+{
+   m_impl->JsonWriter.Uint64(in_value);
+   return *this;
+}
+
+Writer& Writer::value(const char* in_value)
+{
+   return value(in_value, std::strlen(in_value));
+}
+
+Writer& Writer::value(const std::string& in_value)
+{
+   return value(in_value.c_str(), in_value.length());
+}
+
+Writer& Writer::value(const char* in_value, size_t in_length)
+{
+   m_impl->JsonWriter.String(in_value, static_cast<rapidjson::SizeType>(in_length));
+   return *this;
+}
+
+Writer& Writer::value(const Value& in_value)
+{
+   in_value.m_impl->Document->Accept(m_impl->JsonWriter);
+   return *this;
+}
+
+Writer& Writer::rawValue(const std::string& in_json)
+{
+   // the type is only used for bookkeeping of the enclosing container; any non-container type will do
+   m_impl->JsonWriter.RawValue(in_json.c_str(), in_json.length(), rapidjson::kStringType);
+   return *this;
+}
+
+void Writer::flush()
+{
+   m_impl->Stream.Flush();
+}
+
+bool Writer::isComplete() const
+{
+   return m_impl->JsonWriter.IsComplete();
+}
+
 // Free functions ======================================================================================================
 std::string typeAsString(Type in_type)
 {
@@ -0,0 +1,202 @@
+/*
+ * JsonBenchmarks.cpp
+ *
+ * Copyright (C) 2020 by RStudio, PBC
+ *
+ * Unless you have received this program directly from RStudio pursuant
+ * to the terms of a commercial license agreement with RStudio, then
+ * this program is licensed to you under the terms of version 3 of the
+ * GNU Affero General Public License. This program is distributed WITHOUT
+ * ANY EXPRESS OR IMPLIED WARRANTY, INCLUDING THOSE OF NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. Please refer to the
+ * AGPL (http://www.gnu.org/licenses/agpl-3.0.txt) for more details.
+ *
+ */
+
+#include <tests/TestThat.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#ifdef __GLIBC__
+# include <malloc.h>
+#endif
+
+#include <shared_core/Error.hpp>
+#include <shared_core/json/Json.hpp>
+
+namespace rstudio {
+namespace core {
+namespace tests {
+
+namespace {
+
+const char* const kRpcRequest =
+   "{\"method\": \"modify_document_properties\", "
+   "\"params\": [\"7C2A9BE1\", {\"cursorPosition\": \"120,4\", \"scrollLine\": \"100\", "
+   "\"source_window_id\": \"\", \"folds\": \"\"}], "
+   "\"clientId\": \"33e600bb-c1b1-46bf-b562-ab5cba070b0e\", \"clientVersion\": \"\"}";
+
+const char* const kPrefsSchema =
+   "{\"type\": \"object\", \"properties\": {"
+   "\"font_size_points\": {\"type\": \"number\", \"default\": 10}, "
+   "\"highlight_selected_line\": {\"type\": \"boolean\", \"default\": false}, "
+   "\"editor_theme\": {\"type\": \"string\", \"default\": \"Textmate\"}, "
+   "\"panes\": {\"type\": \"object\", \"properties\": {"
+   "\"quadrants\": {\"type\": \"array\", \"items\": {\"type\": \"string\"}}}}}}";
+
+const char* const kPrefsValue =
+   "{\"font_size_points\": 12, \"highlight_selected_line\": true, \"editor_theme\": \"Cobalt\", "
+   "\"panes\": {\"quadrants\": [\"Source\", \"Console\", \"TabSet1\", \"TabSet2\"]}}";
+
+// bytes currently allocated on the heap (0 where this can't be determined)
+std::size_t heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+   struct mallinfo2 info = ::mallinfo2();
+   return info.uordblks + info.hblkhd;
+#else
+   return 0;
+#endif
+}
+
+// one round trip of the RPC layer: parse and read the request, then build and
+// write a get_events style response
+std::size_t rpcRoundTrip(int in_iteration, json::Allocation in_allocation)
+{
+   json::Object request(in_allocation);
+   REQUIRE(!request.parse(kRpcRequest));
+
+   std::string method, clientId;
+   json::Array params;
+   REQUIRE(!json::readObject(request, "method", method, "params", params, "clientId", clientId));
+
+   REQUIRE(params.getSize() == 2);
+   std::string docId = params[0].getString();
+   std::string cursorPosition;
+   REQUIRE(!json::readObject(params[1].getObject(), "cursorPosition", cursorPosition));
+
+   json::Array events(in_allocation);
+   for (int i = 0; i < 20; i++)
+   {
+      json::Object data;
+      data["id"] = docId;
+      data["line"] = i;
+      data["text"] = std::string("[1] ") + method;
+
+      json::Object event;
+      event["id"] = in_iteration * 20 + i;
+      event["type"] = "console_output";
+      event["data"] = data;
+      events.push_back(event);
+   }
+
+   json::Object response(in_allocation);
+   response["result"] = events;
+   return response.write().size();
+}
+
+// a large response, e.g. the contents of a data viewer page
+std::string largeDocument()
+{
+   json::Array rows;
+   for (int i = 0; i < 5000; i++)
+   {
+      json::Object row;
+      row["id"] = i;
+      row["name"] = "row " + std::to_string(i);
+      row["value"] = i * 0.5;
+      json::Array tags;
+      tags.push_back("a");
+      tags.push_back("b");
+      row["tags"] = tags;
+      rows.push_back(row);
+   }
+   return rows.write();
+}
+
+std::size_t parseLarge(const std::string& in_document, json::Allocation in_allocation)
+{
+   json::Array rows(in_allocation);
+   REQUIRE(!rows.parse(in_document));
+
+   std::size_t total = 0;
+   for (const json::Value& row : rows)
+      total += row.getObject()["name"].getString().size();
+   return total;
+}
+
+void validatePrefs()
+{
+   json::Value prefs;
+   REQUIRE(!prefs.parseAndValidate(kPrefsValue, kPrefsSchema));
+}
+
+template <typename F>
+void benchmark(const std::string& in_name, int in_iterations, F in_function)
+{
+   // warm up
+   in_function(0);
+
+   auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < in_iterations; i++)
+      in_function(i);
+   auto elapsed = std::chrono::steady_clock::now() - start;
+
+   std::cout << "json benchmark " << in_name << ": "
+             << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / in_iterations
+             << " ns/iteration" << std::endl;
+}
+
+// heap used by each of a batch of parsed requests which are all kept alive
+void parsedSize(const std::string& in_name, json::Allocation in_allocation)
+{
+   const int kDocuments = 1000;
+
+   std::size_t before = heapInUse();
+   std::vector<json::Object> requests;
+   requests.reserve(kDocuments);
+   for (int i = 0; i < kDocuments; i++)
+   {
+      requests.emplace_back(in_allocation);
+      REQUIRE(!requests.back().parse(kRpcRequest));
+   }
+   std::size_t after = heapInUse();
+
+   std::cout << "json benchmark parsed request size (" << in_name << "): "
+             << (after - before) / kDocuments << " heap bytes/request" << std::endl;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Json Benchmarks")
+{
+   SECTION("RPC round trip")
+   {
+      benchmark("rpc round trip (heap)", 20000, [](int i) { rpcRoundTrip(i, json::Allocation::Heap); });
+      benchmark("rpc round trip (arena)", 20000, [](int i) { rpcRoundTrip(i, json::Allocation::Arena); });
+   }
+
+   SECTION("Parse large document")
+   {
+      const std::string document = largeDocument();
+      benchmark("parse large document (heap)", 200, [&](int) { parseLarge(document, json::Allocation::Heap); });
+      benchmark("parse large document (arena)", 200, [&](int) { parseLarge(document, json::Allocation::Arena); });
+   }
+
+   SECTION("Parsed request size")
+   {
+      parsedSize("heap", json::Allocation::Heap);
+      parsedSize("arena", json::Allocation::Arena);
+   }
+
+   SECTION("Validate against schema")
+   {
+      benchmark("parse and validate", 20000, [](int) { validatePrefs(); });
+   }
+}
+
+} // end namespace tests
+} // end namespace core
+} // end namespace rstudio
@@ -16,6 +16,7 @@
 #include <tests/TestThat.hpp>
 
 #include <iostream>
+#include <memory>
 #include <set>
 
 #include <boost/optional/optional_io.hpp>
@@ -959,6 +960,215 @@ TEST_CASE("Json")
       REQUIRE(error);
    }
 
+   SECTION("Failed parse leaves value unchanged")
+   {
+      json::Object obj;
+      obj["a"] = 1;
+
+      REQUIRE(obj.parse(R"({ "a": )"));
+      CHECK(obj["a"].getInt() == 1);
+   }
+
+   SECTION("Parse large document")
+   {
+      // larger than the parse arena
+      json::Array expected;
+      for (int i = 0; i < 2000; i++)
+         expected.push_back(std::string("element ") + std::to_string(i));
+
+      json::Array actual;
+      REQUIRE_FALSE(actual.parse(expected.write()));
+      CHECK(actual == expected);
+   }
+
+   SECTION("Moving from a view leaves the parent intact")
+   {
+      json::Object obj = createObject();
+
+      std::vector<json::Object> views;
+      for (const json::Value& value : obj["h"].getArray())
+         views.push_back(value.getObject());
+      views.reserve(views.capacity() * 2);
+
+      REQUIRE(views.size() == 2);
+      CHECK(views[0]["a1"].getString() == "a1");
+      CHECK(obj == createObject());
+
+      json::Object moved = std::move(views[1]);
+      CHECK(moved["b1"].getString() == "b1");
+      CHECK(obj == createObject());
+   }
+
+   SECTION("Moving from getObject() or getArray() leaves the owner intact")
+   {
+      json::Value objectValue = createObject();
+      json::Value arrayValue = createObject()["h"];
+
+      std::vector<json::Object> objects;
+      objects.push_back(objectValue.getObject());
+      std::pair<std::string, json::Array> pair = std::make_pair("h", arrayValue.getArray());
+
+      CHECK(objects[0] == createObject());
+      CHECK(pair.second == createObject()["h"].getArray());
+      CHECK(objectValue.getObject() == createObject());
+      CHECK(arrayValue.getArray() == createObject()["h"].getArray());
+
+      json::Object movedObject = objectValue.getObject();
+      json::Array movedArray(arrayValue.getArray());
+      CHECK(movedObject == createObject());
+      CHECK(movedArray.getSize() == 2);
+      CHECK(objectValue.getObject() == createObject());
+      CHECK(arrayValue.getArray().getSize() == 2);
+   }
+
+   SECTION("Moving a value does not copy it")
+   {
+      json::Object obj = createObject();
+      json::Value inner = obj["i"];
+
+      json::Object moved = std::move(obj);
+      CHECK(moved == createObject());
+
+      // the view still refers to the moved value
+      inner.getObject()["added"] = true;
+      CHECK(moved["i"].getObject()["added"].getBool());
+   }
+
+   SECTION("Arena values read and write like heap values")
+   {
+      json::Object heap = createObject();
+      heap["s"] = "a string long enough to need an allocation of its own";
+      heap["arr"] = json::Array();
+      for (int i = 0; i < 100; i++)
+         heap["arr"].getArray().push_back("element " + std::to_string(i));
+
+      json::Object arena(json::Allocation::Arena);
+      REQUIRE(!arena.parse(createObject().write()));
+      arena["s"] = "a string long enough to need an allocation of its own";
+      arena["arr"] = json::Array();
+      for (int i = 0; i < 100; i++)
+         arena["arr"].getArray().push_back("element " + std::to_string(i));
+
+      CHECK(arena == heap);
+      CHECK(arena.write() == heap.write());
+
+      // replacing and removing parts of an arena value
+      arena["s"] = "replaced";
+      CHECK(arena.erase("arr"));
+      heap["s"] = "replaced";
+      CHECK(heap.erase("arr"));
+      CHECK(arena == heap);
+
+      // heap values moved into an arena value are moved, not copied
+      json::Object inner = createObject();
+      arena["moved"] = std::move(inner);
+      CHECK(arena["moved"].getObject() == createObject());
+
+      json::Array arenaArray(json::Allocation::Arena);
+      arenaArray.push_back(heap);
+      arenaArray.push_back(1);
+      CHECK(arenaArray[0].getObject() == heap);
+   }
+
+   SECTION("Values moved out of an arena outlive it")
+   {
+      json::Object moved;
+      json::Array movedArray;
+      {
+         json::Object source(json::Allocation::Arena);
+         REQUIRE(!source.parse(createObject().write()));
+         json::Array sourceArray(json::Allocation::Arena);
+         REQUIRE(!sourceArray.parse("[1, \"two\", {\"three\": [3]}]"));
+
+         moved = std::move(source);
+         movedArray = std::move(sourceArray);
+
+         // moving from an arena value copies it
+         CHECK(source == createObject());
+      }
+
+      CHECK(moved == createObject());
+      CHECK(movedArray.write() == "[1,\"two\",{\"three\":[3]}]");
+   }
+
+   SECTION("Views keep an arena alive")
+   {
+      std::unique_ptr<json::Object> pArena(new json::Object(json::Allocation::Arena));
+      REQUIRE(!pArena->parse(createObject().write()));
+
+      json::Value inner = (*pArena)["i"];
+      json::Object::Iterator itr = pArena->find("h");
+      json::Value member = (*itr).getValue();
+      pArena.reset();
+
+      CHECK(inner.getObject() == createObject()["i"].getObject());
+      CHECK(member.getArray() == createObject()["h"].getArray());
+   }
+
+   SECTION("Schemas are compiled once and reused")
+   {
+      const std::string schema = R"({ "type": "object", "properties": { "a": { "type": "integer" } } })";
+
+      json::Object valid;
+      valid["a"] = 1;
+      json::Object invalid;
+      invalid["a"] = "one";
+
+      for (int i = 0; i < 3; i++)
+      {
+         CHECK_FALSE(valid.validate(schema));
+         CHECK(invalid.validate(schema));
+      }
+
+      CHECK(valid.validate("{ \"type\": "));
+   }
+
+   SECTION("Writer output matches Value::write")
+   {
+      json::Object expected = createObject();
+
+      std::string output;
+      {
+         json::Writer writer(&output);
+         writer.startObject()
+            .key("a").value(true)
+            .key("b").value(false)
+            .key("c").value(1000)
+            .key("d").value((uint64_t)18446744073709550615U)
+            .key("e").value(246.9)
+            .key("f").value(std::string("Hello world"))
+            .key("g").startArray().value(100).value(200).value(300).endArray()
+            .key("h").value(expected["h"])
+            .key("i").rawValue(expected["i"].write())
+            .endObject();
+         CHECK(writer.isComplete());
+      }
+
+      CHECK(output == expected.write());
+   }
+
+   SECTION("Writer flushes large output to a stream")
+   {
+      json::Array expected;
+      std::ostringstream stream;
+      {
+         json::Writer writer(stream);
+         writer.startArray();
+         for (int i = 0; i < 10000; i++)
+         {
+            std::string element = "element " + std::to_string(i);
+            expected.push_back(element);
+            writer.value(element);
+         }
+         writer.endArray();
+         CHECK(writer.isComplete());
+      }
+
+      json::Array actual;
+      REQUIRE_FALSE(actual.parse(stream.str()));
+      CHECK(actual == expected);
+   }
+
    SECTION("readObject tests")
    {
       json::Object obj;
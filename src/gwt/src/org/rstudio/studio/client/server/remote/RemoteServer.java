@@ -170,8 +170,8 @@ import org.rstudio.studio.client.workbench.views.environment.model.DataPreviewRe
 import org.rstudio.studio.client.workbench.views.environment.model.DownloadInfo;
 import org.rstudio.studio.client.workbench.views.environment.model.EnvironmentContextData;
 import org.rstudio.studio.client.workbench.views.environment.model.EnvironmentFrame;
+import org.rstudio.studio.client.workbench.views.environment.model.EnvironmentListPage;
 import org.rstudio.studio.client.workbench.views.environment.model.ObjectContents;
-import org.rstudio.studio.client.workbench.views.environment.model.RObject;
 import org.rstudio.studio.client.workbench.views.files.model.DirectoryListing;
 import org.rstudio.studio.client.workbench.views.files.model.FileUploadToken;
 import org.rstudio.studio.client.workbench.views.help.model.HelpInfo;
@@ -3006,6 +3006,16 @@ public class RemoteServer implements Server
       }
    }
 
+   String getClientId()
+   {
+      return clientId_;
+   }
+
+   SessionInfo getSessionInfo()
+   {
+      return session_.getSessionInfo();
+   }
+
    boolean isDisconnected()
    {
       return disconnected_;
@@ -4547,9 +4557,14 @@ public class RemoteServer implements Server
    }
 
    @Override
-   public void listEnvironment(ServerRequestCallback<JsArray<RObject>> callback)
+   public void listEnvironment(int offset,
+                               int count,
+                               ServerRequestCallback<EnvironmentListPage> callback)
    {
-      sendRequest(RPC_SCOPE, LIST_ENVIRONMENT, callback);
+      JSONArray params = new JSONArray();
+      params.set(0, new JSONNumber(offset));
+      params.set(1, new JSONNumber(count));
+      sendRequest(RPC_SCOPE, LIST_ENVIRONMENT, params, callback);
    }
 
    @Override
@@ -21,13 +21,21 @@ import com.google.gwt.user.client.Window;
 import com.google.gwt.user.client.Window.ClosingEvent;
 import com.google.gwt.user.client.Window.ClosingHandler;
 
+import org.rstudio.core.client.StringUtil;
 import org.rstudio.core.client.jsonrpc.RpcError;
 import org.rstudio.core.client.jsonrpc.RpcRequest;
 import org.rstudio.core.client.jsonrpc.RpcRequestCallback;
 import org.rstudio.core.client.jsonrpc.RpcResponse;
+import org.rstudio.studio.client.application.Desktop;
 import org.rstudio.studio.client.application.events.*;
 import org.rstudio.studio.client.server.ServerError;
 import org.rstudio.studio.client.server.ServerRequestCallback;
+import org.rstudio.studio.client.workbench.model.SessionInfo;
+import org.rstudio.studio.client.workbench.views.terminal.TerminalSocketPacket;
+
+import com.sksamuel.gwt.websockets.CloseEvent;
+import com.sksamuel.gwt.websockets.Websocket;
+import com.sksamuel.gwt.websockets.WebsocketListenerExt;
 
 import java.util.HashMap;
 
@@ -68,6 +76,29 @@ class RemoteServerEventListener
             doListen();
          }
       };
+
+      // the push channel has to deliver its first batch of events (sent in
+      // response to our initial acknowledgement) within the connect timeout,
+      // otherwise we give up on it and long-poll instead
+      pushConnectTimer_ = new Timer() {
+         @Override
+         public void run()
+         {
+            GWT.log("Timeout connecting to client event channel, switching to polling");
+            fallBackToPolling(true);
+         }
+      };
+
+      pushKeepAliveTimer_ = new Timer() {
+         @Override
+         public void run()
+         {
+            if (pushSocket_ != null)
+               pushSocket_.send(TerminalSocketPacket.keepAlivePacket());
+            else
+               pushKeepAliveTimer_.cancel();
+         }
+      };
       
       // we take the liberty of stopping ourselves if the window is on 
       // the verge of being closed. this allows us to prevent the scenario:
@@ -130,12 +161,15 @@ class RemoteServerEventListener
       // eliminate this scenario then
       lastEventId_ = -1;
       
-      // start listening
-      listen();
+      // start listening (preferring to have events pushed to us if the
+      // server supports it)
+      if (!connectPushChannel())
+         listen();
    }
      
    public void stop()
    {
+      closePushChannel();
       listenTimer_.cancel();
       isListening_ = false;
       listenCount_ = 0;
@@ -268,20 +302,9 @@ class RemoteServerEventListener
                // only process events if we are still listening
                if (isListening_ && (events != null))
                {
-                  for (int i=0; i<events.length(); i++)
-                  {
-                     // we can stop listening in the middle of dispatching
-                     // events (e.g. if we dispatch a Suicide event) so we 
-                     // need to check the listening_ flag before each event
-                     // is dispatched
-                     if (!isListening_)
-                        return;
-                     
-                     // dispatch event
-                     ClientEvent event = events.get(i);
-                     dispatchEvent(event);
-                     lastEventId_ = event.getId();
-                  }   
+                  processEvents(events, false);
+                  if (!isListening_)
+                     return;
                }
             }
             // catch all here to make sure that in all cases we call
@@ -372,6 +395,173 @@ class RemoteServerEventListener
    }
    
    
+   private void processEvents(JsArray<ClientEvent> events, boolean skipSeen)
+   {
+      for (int i=0; i<events.length(); i++)
+      {
+         // we can stop listening in the middle of dispatching
+         // events (e.g. if we dispatch a Suicide event) so we
+         // need to check the listening_ flag before each event
+         // is dispatched
+         if (!isListening_)
+            return;
+
+         // events pushed after a reconnect can include some we've
+         // already seen (if our acknowledgement didn't make it)
+         ClientEvent event = events.get(i);
+         if (skipSeen && event.getId() <= lastEventId_)
+            continue;
+
+         // dispatch event
+         dispatchEvent(event);
+         lastEventId_ = event.getId();
+      }
+   }
+
+   // attempt to connect to the server's client event push channel; returns
+   // false if the channel isn't available (in which case the caller should
+   // long-poll for events)
+   private boolean connectPushChannel()
+   {
+      if (pushUnavailable_ || !Websocket.isSupported())
+         return false;
+
+      SessionInfo sessionInfo = server_.getSessionInfo();
+      if (sessionInfo == null)
+         return false;
+
+      String channelId = sessionInfo.getClientEventsChannelId();
+      if (StringUtil.isNullOrEmpty(channelId))
+         return false;
+
+      // for desktop talk directly to the websocket, otherwise go through
+      // the server via the /p proxy
+      String urlSuffix = channelId + "/events/";
+      String url;
+      if (Desktop.isDesktop())
+      {
+         url = "ws://127.0.0.1:" + urlSuffix;
+      }
+      else
+      {
+         url = GWT.getHostPageBaseURL();
+         if (url.startsWith("https:"))
+            url = "wss:" + url.substring(6) + "p/" + urlSuffix;
+         else if (url.startsWith("http:"))
+            url = "ws:" + url.substring(5) + "p/" + urlSuffix;
+         else
+            return false;
+      }
+
+      final int pingInterval = sessionInfo.getWebSocketPingInterval();
+      final Websocket socket = new Websocket(url);
+      socket.addListener(new WebsocketListenerExt()
+      {
+         @Override
+         public void onOpen()
+         {
+            if (socket != pushSocket_)
+               return;
+
+            // identify ourselves; the server responds by sending all of
+            // the events we haven't yet acknowledged
+            acknowledgePushedEvents();
+            if (pingInterval > 0)
+               pushKeepAliveTimer_.scheduleRepeating(pingInterval * 1000);
+         }
+
+         @Override
+         public void onMessage(String msg)
+         {
+            if (socket != pushSocket_ || TerminalSocketPacket.isKeepAlive(msg))
+               return;
+
+            pushConnectTimer_.cancel();
+            pushConnected_ = true;
+
+            // keep watchdog appraised of successful receipt of events
+            watchdog_.cancel();
+
+            try
+            {
+               processEvents(parseEvents(TerminalSocketPacket.getMessage(msg)), true);
+            }
+            catch(Throwable e)
+            {
+               GWT.log("ERROR: Processing client events", e);
+            }
+
+            if (isListening_ && socket == pushSocket_)
+               acknowledgePushedEvents();
+         }
+
+         @Override
+         public void onClose(CloseEvent event)
+         {
+            // if we never received anything the channel isn't usable from
+            // here (e.g. blocked by a proxy) so don't try it again
+            if (socket == pushSocket_)
+               fallBackToPolling(!pushConnected_);
+         }
+
+         @Override
+         public void onError()
+         {
+            if (socket == pushSocket_)
+               fallBackToPolling(!pushConnected_);
+         }
+      });
+
+      pushSocket_ = socket;
+      pushConnected_ = false;
+
+      int connectTimeout = sessionInfo.getWebSocketConnectTimeout();
+      pushConnectTimer_.schedule(Math.max(connectTimeout, 1) * 1000);
+      socket.open();
+      return true;
+   }
+
+   private void acknowledgePushedEvents()
+   {
+      pushSocket_.send(TerminalSocketPacket.textPacket(
+            createAcknowledgement(server_.getClientId(), lastEventId_)));
+   }
+
+   private void closePushChannel()
+   {
+      pushConnectTimer_.cancel();
+      pushKeepAliveTimer_.cancel();
+      if (pushSocket_ != null)
+      {
+         // clear the reference first so the close notification is ignored
+         Websocket socket = pushSocket_;
+         pushSocket_ = null;
+         socket.close();
+      }
+   }
+
+   // the push channel failed or went away; any events it didn't deliver are
+   // still pending on the server (they're only discarded once acknowledged)
+   // so we just pick up where it left off with get_events
+   private void fallBackToPolling(boolean pushUnavailable)
+   {
+      closePushChannel();
+      if (pushUnavailable)
+         pushUnavailable_ = true;
+
+      if (isListening_)
+         listen();
+   }
+
+   private static native JsArray<ClientEvent> parseEvents(String json) /*-{
+      return JSON.parse(json);
+   }-*/;
+
+   private static native String createAcknowledgement(String clientId,
+                                                      int lastEventId) /*-{
+      return JSON.stringify({ client_id: clientId, last_event_id: lastEventId });
+   }-*/;
+
    private void dispatchEvent(ClientEvent event)
    {
       // do some special handling before calling the standard dispatcher
@@ -469,6 +659,12 @@ class RemoteServerEventListener
    private final int kWatchdogIntervalMs = 1000;
    private final int kSecondListenBounceMs = 250;
    private Timer listenTimer_;
+
+   private Websocket pushSocket_;
+   private boolean pushConnected_;
+   private boolean pushUnavailable_;
+   private final Timer pushConnectTimer_;
+   private final Timer pushKeepAliveTimer_;
        
    private boolean isListening_;
    private int lastEventId_;
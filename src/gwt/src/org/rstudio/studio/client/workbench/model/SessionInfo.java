@@ -420,6 +420,10 @@ public class SessionInfo extends JavaScriptObject
       return this.websocket_connect_timeout;
    }-*/;
 
+   public final native String getClientEventsChannelId() /*-{
+      return this.client_events_channel_id || "";
+   }-*/;
+
    public final native boolean getAllowExternalPublish() /*-{
       return this.allow_external_publish;
    }-*/;
@@ -82,6 +82,7 @@ import org.rstudio.studio.client.workbench.views.environment.events.JumpToFuncti
 import org.rstudio.studio.client.workbench.views.environment.model.CallFrame;
 import org.rstudio.studio.client.workbench.views.environment.model.DownloadInfo;
 import org.rstudio.studio.client.workbench.views.environment.model.EnvironmentContextData;
+import org.rstudio.studio.client.workbench.views.environment.model.EnvironmentListPage;
 import org.rstudio.studio.client.workbench.views.environment.model.EnvironmentServerOperations;
 import org.rstudio.studio.client.workbench.views.environment.model.RObject;
 import org.rstudio.studio.client.workbench.views.environment.view.EnvironmentClientState;
@@ -219,7 +220,8 @@ public class EnvironmentPresenter extends BasePresenter
                   event.getCallFrames(),
                   event.useProvidedSource(),
                   event.getFunctionCode());
-            setViewFromEnvironmentList(event.getEnvironmentList());
+            setViewFromEnvironmentList(event.getEnvironmentList(),
+                                       event.getEnvironmentListTotal());
             requeryContextTimer_.cancel();
          }
       });
@@ -633,8 +635,9 @@ public class EnvironmentPresenter extends BasePresenter
          // environment was loaded from .RData and therefore not available 
          // during session init; we also want to fetch a fresh list in this
          // case).
-         JsArray<RObject> environmentList = 
-              session_.getSessionInfo().getEnvironmentState().environmentList();
+         EnvironmentContextData environmentState =
+              session_.getSessionInfo().getEnvironmentState();
+         JsArray<RObject> environmentList = environmentState.environmentList();
          if (environmentList == null ||
              environmentList.length() == 0)
          {
@@ -642,7 +645,8 @@ public class EnvironmentPresenter extends BasePresenter
          }
          else
          {
-            setViewFromEnvironmentList(environmentList);
+            setViewFromEnvironmentList(environmentList,
+                                       environmentState.environmentListTotal());
          }
          initialized_ = true;
       }
@@ -671,7 +675,8 @@ public class EnvironmentPresenter extends BasePresenter
             environmentState.callFrames(),
             environmentState.useProvidedSource(),
             environmentState.functionCode());
-      setViewFromEnvironmentList(environmentState.environmentList());
+      setViewFromEnvironmentList(environmentState.environmentList(),
+                                 environmentState.environmentListTotal());
       initialized_ = true;
    }
    
@@ -879,10 +884,46 @@ public class EnvironmentPresenter extends BasePresenter
       }
    }
 
-   private void setViewFromEnvironmentList(JsArray<RObject> objects)
+   private void setViewFromEnvironmentList(JsArray<RObject> objects, int total)
    {
       view_.clearObjects();
       view_.addObjects(objects);
+
+      // the server sends only the first page of objects in a large
+      // environment; fetch the rest a page at a time (abandoning them if the
+      // environment is replaced meanwhile)
+      environmentListGeneration_++;
+      if (objects != null && objects.length() < total)
+         loadEnvironmentListPage(objects.length(), environmentListGeneration_);
+   }
+
+   private void loadEnvironmentListPage(final int offset, final int generation)
+   {
+      server_.listEnvironment(
+            offset,
+            ENVIRONMENT_LIST_PAGE_SIZE,
+            new ServerRequestCallback<EnvironmentListPage>()
+      {
+         @Override
+         public void onResponseReceived(EnvironmentListPage page)
+         {
+            if (generation != environmentListGeneration_)
+               return;
+
+            JsArray<RObject> objects = page.list();
+            view_.addObjects(objects);
+
+            int next = offset + objects.length();
+            if (objects.length() > 0 && next < page.total())
+               loadEnvironmentListPage(next, generation);
+         }
+
+         @Override
+         public void onError(ServerError error)
+         {
+            Debug.logError(error);
+         }
+      });
    }
    
    /***
@@ -1044,6 +1085,7 @@ public class EnvironmentPresenter extends BasePresenter
 
    private int contextDepth_;
    private boolean refreshingView_;
+   private int environmentListGeneration_;
    private boolean initialized_;
    private DebugFilePosition currentBrowsePosition_;
    private int currentFunctionLineNumber_;
@@ -1056,4 +1098,6 @@ public class EnvironmentPresenter extends BasePresenter
    private SearchPathFunctionDefinition searchFunction_;
    
    final String dataImportDependecyUserAction_ = "Preparing data import";
+
+   private static final int ENVIRONMENT_LIST_PAGE_SIZE = 500;
 }
@@ -50,6 +50,11 @@ public class ContextDepthChangedEvent extends
       return contextData_.environmentList();
    }
 
+   public int getEnvironmentListTotal()
+   {
+      return contextData_.environmentListTotal();
+   }
+
    public JsArray<CallFrame> getCallFrames()
    {
       return contextData_.callFrames();
@@ -49,6 +49,14 @@ public class EnvironmentContextData extends JavaScriptObject
       return this.environment_list;
    }-*/;
 
+   // the number of objects in the environment (environmentList() holds
+   // only the first page of them)
+   public final native int environmentListTotal() /*-{
+      if (typeof this.environment_list_total === "undefined")
+         return this.environment_list ? this.environment_list.length : 0;
+      return this.environment_list_total;
+   }-*/;
+
    public final native String environmentName() /*-{
       return this.environment_name;
    }-*/;
@@ -23,7 +23,9 @@ import org.rstudio.studio.client.server.Void;
 
 public interface EnvironmentServerOperations
 {
-   void listEnvironment(ServerRequestCallback<JsArray<RObject> > callback);
+   void listEnvironment(int offset,
+                        int count,
+                        ServerRequestCallback<EnvironmentListPage> callback);
 
    void removeAllObjects(boolean includeHidden,
                          ServerRequestCallback<Void> requestCallback);